@@ -1,9 +1,11 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <Optick/optick.h>
 
+#include "Utility/Assert.h"
 #include "Utility/DataTypes.h"
 
 #define SAFE_DELETE(X) if((X)) { delete (X); (X) = nullptr; }
@@ -11,14 +13,6 @@
 
 #define FORCE_CRASH *((unsigned int*)0) = 0xDEAD
 
-#ifdef DEBUG
-#define ASSERT(X,msg) if(!(X)) { std::cout << msg << std::endl; __debugbreak(); }
-#define NOT_IMPLEMENTED ASSERT(0, "NOT IMPLEMENTED")
-#else
-#define ASSERT(X, MSG) {}
-#define NOT_IMPLEMENTED {}
-#endif // DEBUG
-
 #define ASSERT_CORE(X, msg) if(!(X)) { std::cout << msg << std::endl; FORCE_CRASH; }
 
 #define STATIC_ARRAY_SIZE(X) (sizeof(X)/(sizeof(X[0])))
@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include "Core/Application.h"
+#include "Loading/AssetArchive.h"
 #include "Render/Commands.h"
 #include "Render/Device.h"
 #include "Render/Texture.h"
@@ -26,6 +27,12 @@ Engine::Engine(Application* app)
 	
 	Device::Init();
 	GFX::InitShaderCompiler();
+
+	// Resources are read from the archive built by Tools/AssetPacker if there is one, loose files changed since the packing are read instead
+	if (AssetArchive::Mount(AssetArchive::DEFAULT_PATH))
+	{
+		std::cout << "Mounted asset archive " << AssetArchive::DEFAULT_PATH << std::endl;
+	}
 	RenderThreadPool::Init(8);
 
 	GraphicsContext& context = ContextManager::Get().GetCreationContext();
@@ -56,6 +63,7 @@ Engine::~Engine()
 	RenderThreadPool::Destroy();
 	GFX::DestroyShaderCompiler();
 	GFX::DestroyRenderingResources(context);
+	AssetArchive::UnmountAll();
 	Device::Destroy();
 	Window::Destroy();
 }
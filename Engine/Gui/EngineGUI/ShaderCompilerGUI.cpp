@@ -3,13 +3,28 @@
 #include "Gui/ImGui_Core.h"
 
 #include "Render/Shader.h"
+#include "Render/Context.h"
+#include "Render/PipelineLibrary.h"
 
 void ShaderCompilerGUI::Update(float dt)
 {
-	GetShownRef() = GFX::GetFailedShaderCount() != 0;
+	const ShaderWarmup::Progress warmupProgress = GFX::GetShaderWarmupProgress();
+	GetShownRef() = GFX::GetFailedShaderCount() != 0 || warmupProgress.NumFinished != warmupProgress.NumRequested;
 }
 
 void ShaderCompilerGUI::Render()
 {
+	const ShaderWarmup::Progress warmupProgress = GFX::GetShaderWarmupProgress();
+	ImGui::Text("Shader warm-up: %u/%u (%.1f ms), %u failed", warmupProgress.NumFinished, warmupProgress.NumRequested, warmupProgress.CompileTimeMS, warmupProgress.NumFailed);
 	ImGui::Text("Number of failed shaders: %u", GFX::GetFailedShaderCount());
+
+	const auto psoStatistics = ContextManager::Get().PSOCache.GetStatistics();
+	ImGui::Text("PSO cache: %llu hits, %llu created (%.1f ms)", psoStatistics.NumHits, psoStatistics.NumMisses, psoStatistics.CreationTimeMS);
+
+	const D3D12SignatureCache::Statistics signatureStatistics = ContextManager::Get().Signatures.GetStatistics();
+	ImGui::Text("Root signatures: %llu, states on the global one: %llu/%llu", signatureStatistics.NumRootSignatures, signatureStatistics.NumGlobal, signatureStatistics.NumGlobal + signatureStatistics.NumFallback);
+	ImGui::Text("Command signatures: %llu, %llu hits", signatureStatistics.NumCommandSignatures, signatureStatistics.NumCommandSignatureHits);
+
+	const PipelineLibraryCache::Statistics libraryStatistics = Device::Get()->GetPipelineLibrary()->GetStatistics();
+	ImGui::Text("Pipeline library: %u loaded, %u stored, %u evicted", libraryStatistics.NumLoaded, libraryStatistics.NumStored, libraryStatistics.NumEvicted);
 }
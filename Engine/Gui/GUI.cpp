@@ -136,6 +136,9 @@ void GUI::Render(GraphicsContext& context)
 
 	ImGui::Render();
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), context.CmdList.Get());
+
+	// ImGui binds its own heap, root signature and pipeline
+	context.BoundState.Tracker.Invalidate();
 }
 
 void GUI::Reset()
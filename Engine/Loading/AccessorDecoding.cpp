@@ -0,0 +1,499 @@
+#include "AccessorDecoding.h"
+
+#pragma warning (disable : 4996)
+#include <cgltf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define ACCESSOR_DECODING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace AccessorDecoding
+{
+	namespace
+	{
+		template<ComponentType TYPE> struct Component;
+		template<> struct Component<ComponentType::Int8> { using Type = int8_t; };
+		template<> struct Component<ComponentType::UInt8> { using Type = uint8_t; };
+		template<> struct Component<ComponentType::Int16> { using Type = int16_t; };
+		template<> struct Component<ComponentType::UInt16> { using Type = uint16_t; };
+		template<> struct Component<ComponentType::UInt32> { using Type = uint32_t; };
+		template<> struct Component<ComponentType::Float> { using Type = float; };
+
+		// Accessors don't have to be aligned to the component size
+		template<typename T>
+		T Load(const uint8_t* data)
+		{
+			T value;
+			memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		// Normalized values are c / max, signed ones clamped to -1 as glTF defines them
+		float ReadFloat(const uint8_t* data, ComponentType type, bool normalized)
+		{
+			switch (type)
+			{
+			case ComponentType::Int8: return normalized ? std::max(Load<int8_t>(data) / 127.0f, -1.0f) : (float) Load<int8_t>(data);
+			case ComponentType::UInt8: return normalized ? Load<uint8_t>(data) / 255.0f : (float) Load<uint8_t>(data);
+			case ComponentType::Int16: return normalized ? std::max(Load<int16_t>(data) / 32767.0f, -1.0f) : (float) Load<int16_t>(data);
+			case ComponentType::UInt16: return normalized ? Load<uint16_t>(data) / 65535.0f : (float) Load<uint16_t>(data);
+			case ComponentType::UInt32: return normalized ? Load<uint32_t>(data) / 4294967295.0f : (float) Load<uint32_t>(data);
+			case ComponentType::Float: return Load<float>(data);
+			default: return 0.0f;
+			}
+		}
+
+		// Signed components are sign extended, floats outside of the range are zero
+		uint32_t ReadUInt(const uint8_t* data, ComponentType type)
+		{
+			switch (type)
+			{
+			case ComponentType::Int8: return (uint32_t) Load<int8_t>(data);
+			case ComponentType::UInt8: return Load<uint8_t>(data);
+			case ComponentType::Int16: return (uint32_t) Load<int16_t>(data);
+			case ComponentType::UInt16: return Load<uint16_t>(data);
+			case ComponentType::UInt32: return Load<uint32_t>(data);
+			case ComponentType::Float:
+			{
+				const float value = Load<float>(data);
+				return value >= 0.0f && value < 4294967296.0f ? (uint32_t) value : 0;
+			}
+			default: return 0;
+			}
+		}
+
+		size_t GetColumnStride(const Layout& layout)
+		{
+			const size_t columnSize = (layout.NumComponents / layout.NumColumns) * GetComponentSize(layout.Type);
+			return layout.NumColumns == 1 ? columnSize : (columnSize + 3) & ~(size_t) 3;
+		}
+
+		template<typename T>
+		T* GetElement(T* dst, size_t dstStride, size_t index)
+		{
+			return (T*) ((uint8_t*) dst + index * dstStride);
+		}
+
+		template<typename T, typename ReadFunc>
+		void DecodeReference(const Layout& layout, T* dst, size_t dstStride, uint32_t dstComponents, ReadFunc read)
+		{
+			const uint32_t componentSize = GetComponentSize(layout.Type);
+			const uint32_t numRows = layout.NumComponents / layout.NumColumns;
+			const size_t columnStride = GetColumnStride(layout);
+
+			for (size_t i = 0; i < layout.Count; i++)
+			{
+				T* element = GetElement(dst, dstStride, i);
+				const uint8_t* src = layout.Data ? layout.Data + i * layout.Stride : nullptr;
+				for (uint32_t c = 0; c < dstComponents; c++)
+				{
+					if (!src || c >= layout.NumComponents) element[c] = 0;
+					else element[c] = read(src + (c / numRows) * columnStride + (c % numRows) * componentSize);
+				}
+			}
+		}
+
+		template<typename T, typename DecodeFunc>
+		void ApplySparseValues(const Layout& layout, const SparseLayout& sparse, T* dst, size_t dstStride, uint32_t dstComponents, DecodeFunc decode)
+		{
+			if (!sparse.Indices || !sparse.Values) return;
+
+			const uint32_t indexSize = GetComponentSize(sparse.IndexType);
+			Layout value = layout;
+			value.Count = 1;
+			value.Stride = GetElementSize(layout);
+
+			for (size_t i = 0; i < sparse.Count; i++)
+			{
+				const uint32_t index = ReadUInt(sparse.Indices + i * indexSize, sparse.IndexType);
+				if (index >= layout.Count) continue;
+
+				value.Data = sparse.Values + i * value.Stride;
+				decode(value, GetElement(dst, dstStride, index), dstStride, dstComponents);
+			}
+		}
+
+#ifdef ACCESSOR_DECODING_SSE2
+		// Reads exactly the bytes of the element, odd sizes are put together in registers
+		// Copying them through a temporary would stall the load on the smaller stores
+		template<size_t SIZE>
+		__m128i LoadElement(const uint8_t* src)
+		{
+			if constexpr (SIZE == 1) return _mm_cvtsi32_si128(Load<uint8_t>(src));
+			else if constexpr (SIZE == 2) return _mm_cvtsi32_si128(Load<uint16_t>(src));
+			else if constexpr (SIZE == 3) return _mm_cvtsi32_si128(Load<uint16_t>(src) | (Load<uint8_t>(src + 2) << 16));
+			else if constexpr (SIZE == 4) return _mm_cvtsi32_si128((int) Load<uint32_t>(src));
+			else if constexpr (SIZE == 6) return _mm_unpacklo_epi32(LoadElement<4>(src), LoadElement<2>(src + 4));
+			else if constexpr (SIZE == 8) return _mm_loadl_epi64((const __m128i*) src);
+			else if constexpr (SIZE == 12) return _mm_unpacklo_epi64(LoadElement<8>(src), LoadElement<4>(src + 8));
+			else return _mm_loadu_si128((const __m128i*) src);
+		}
+
+		// Integer components of the element widened to 32 bits, signed ones are sign extended
+		template<ComponentType TYPE, uint32_t N>
+		__m128i WidenElement(const uint8_t* src)
+		{
+			using T = typename Component<TYPE>::Type;
+			const __m128i zero = _mm_setzero_si128();
+
+			__m128i value = LoadElement<N * sizeof(T)>(src);
+			if constexpr (sizeof(T) == 1)
+			{
+				if constexpr (std::is_signed_v<T>)
+				{
+					value = _mm_unpacklo_epi8(value, value);
+					return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 24);
+				}
+				else return _mm_unpacklo_epi16(_mm_unpacklo_epi8(value, zero), zero);
+			}
+			else if constexpr (sizeof(T) == 2)
+			{
+				if constexpr (std::is_signed_v<T>) return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+				else return _mm_unpacklo_epi16(value, zero);
+			}
+			else return value;
+		}
+
+		// Writes only the N components, the rest of the destination element is left as is
+		template<uint32_t N>
+		void StoreElement(uint8_t* dst, __m128 value)
+		{
+			if constexpr (N == 1) _mm_store_ss((float*) dst, value);
+			else if constexpr (N == 2) _mm_storel_pi((__m64*) dst, value);
+			else if constexpr (N == 3)
+			{
+				_mm_storel_pi((__m64*) dst, value);
+				_mm_store_ss((float*) dst + 2, _mm_movehl_ps(value, value));
+			}
+			else _mm_storeu_ps((float*) dst, value);
+		}
+
+		template<uint32_t N>
+		void StoreElement(uint8_t* dst, __m128i value)
+		{
+			StoreElement<N>(dst, _mm_castsi128_ps(value));
+		}
+
+		// Division instead of a multiply by the reciprocal so the results are the same as the reference
+		template<ComponentType TYPE, uint32_t N, bool NORMALIZED>
+		void DecodeFloatsSSE2(const Layout& layout, float* dst, size_t dstStride)
+		{
+			using T = typename Component<TYPE>::Type;
+
+			const __m128 scale = _mm_set1_ps(TYPE == ComponentType::Int8 ? 127.0f : TYPE == ComponentType::UInt8 ? 255.0f : TYPE == ComponentType::Int16 ? 32767.0f : 65535.0f);
+			const __m128 minValue = _mm_set1_ps(-1.0f);
+
+			const uint8_t* src = layout.Data;
+			uint8_t* out = (uint8_t*) dst;
+			for (size_t i = 0; i < layout.Count; i++, src += layout.Stride, out += dstStride)
+			{
+				__m128 value;
+				if constexpr (TYPE == ComponentType::Float)
+				{
+					value = _mm_castsi128_ps(LoadElement<N * sizeof(float)>(src));
+				}
+				else
+				{
+					value = _mm_cvtepi32_ps(WidenElement<TYPE, N>(src));
+					if constexpr (NORMALIZED)
+					{
+						value = _mm_div_ps(value, scale);
+						if constexpr (std::is_signed_v<T>) value = _mm_max_ps(value, minValue);
+					}
+				}
+				StoreElement<N>(out, value);
+			}
+		}
+
+		template<ComponentType TYPE, uint32_t N>
+		void DecodeUIntsSSE2(const Layout& layout, uint32_t* dst, size_t dstStride)
+		{
+			const uint8_t* src = layout.Data;
+			uint8_t* out = (uint8_t*) dst;
+			for (size_t i = 0; i < layout.Count; i++, src += layout.Stride, out += dstStride)
+			{
+				StoreElement<N>(out, WidenElement<TYPE, N>(src));
+			}
+		}
+
+		// Tightly packed 8 and 16 bit indices, 16 or 8 of them per iteration
+		void WidenIndicesSSE2(const Layout& layout, uint32_t* dst)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			size_t i = 0;
+			if (layout.Type == ComponentType::UInt8)
+			{
+				for (; i + 16 <= layout.Count; i += 16)
+				{
+					const __m128i value = _mm_loadu_si128((const __m128i*) (layout.Data + i));
+					const __m128i low = _mm_unpacklo_epi8(value, zero);
+					const __m128i high = _mm_unpackhi_epi8(value, zero);
+					_mm_storeu_si128((__m128i*) (dst + i), _mm_unpacklo_epi16(low, zero));
+					_mm_storeu_si128((__m128i*) (dst + i + 4), _mm_unpackhi_epi16(low, zero));
+					_mm_storeu_si128((__m128i*) (dst + i + 8), _mm_unpacklo_epi16(high, zero));
+					_mm_storeu_si128((__m128i*) (dst + i + 12), _mm_unpackhi_epi16(high, zero));
+				}
+				for (; i < layout.Count; i++) dst[i] = layout.Data[i];
+			}
+			else
+			{
+				for (; i + 8 <= layout.Count; i += 8)
+				{
+					const __m128i value = _mm_loadu_si128((const __m128i*) (layout.Data + i * 2));
+					_mm_storeu_si128((__m128i*) (dst + i), _mm_unpacklo_epi16(value, zero));
+					_mm_storeu_si128((__m128i*) (dst + i + 4), _mm_unpackhi_epi16(value, zero));
+				}
+				for (; i < layout.Count; i++) dst[i] = Load<uint16_t>(layout.Data + i * 2);
+			}
+		}
+
+		using FloatKernel = void(*)(const Layout&, float*, size_t);
+		using UIntKernel = void(*)(const Layout&, uint32_t*, size_t);
+
+		template<ComponentType TYPE, bool NORMALIZED>
+		FloatKernel SelectFloatKernel(uint32_t numComponents)
+		{
+			switch (numComponents)
+			{
+			case 1: return &DecodeFloatsSSE2<TYPE, 1, NORMALIZED>;
+			case 2: return &DecodeFloatsSSE2<TYPE, 2, NORMALIZED>;
+			case 3: return &DecodeFloatsSSE2<TYPE, 3, NORMALIZED>;
+			case 4: return &DecodeFloatsSSE2<TYPE, 4, NORMALIZED>;
+			default: return nullptr;
+			}
+		}
+
+		template<ComponentType TYPE>
+		UIntKernel SelectUIntKernel(uint32_t numComponents)
+		{
+			switch (numComponents)
+			{
+			case 1: return &DecodeUIntsSSE2<TYPE, 1>;
+			case 2: return &DecodeUIntsSSE2<TYPE, 2>;
+			case 3: return &DecodeUIntsSSE2<TYPE, 3>;
+			case 4: return &DecodeUIntsSSE2<TYPE, 4>;
+			default: return nullptr;
+			}
+		}
+
+		// SSE2 has no exact conversion of 32 bit unsigned integers to floats, they use the reference
+		FloatKernel GetFloatKernel(const Layout& layout)
+		{
+			const uint32_t n = layout.NumComponents;
+			switch (layout.Type)
+			{
+			case ComponentType::Int8: return layout.Normalized ? SelectFloatKernel<ComponentType::Int8, true>(n) : SelectFloatKernel<ComponentType::Int8, false>(n);
+			case ComponentType::UInt8: return layout.Normalized ? SelectFloatKernel<ComponentType::UInt8, true>(n) : SelectFloatKernel<ComponentType::UInt8, false>(n);
+			case ComponentType::Int16: return layout.Normalized ? SelectFloatKernel<ComponentType::Int16, true>(n) : SelectFloatKernel<ComponentType::Int16, false>(n);
+			case ComponentType::UInt16: return layout.Normalized ? SelectFloatKernel<ComponentType::UInt16, true>(n) : SelectFloatKernel<ComponentType::UInt16, false>(n);
+			case ComponentType::Float: return SelectFloatKernel<ComponentType::Float, false>(n);
+			default: return nullptr;
+			}
+		}
+
+		UIntKernel GetUIntKernel(const Layout& layout)
+		{
+			const uint32_t n = layout.NumComponents;
+			switch (layout.Type)
+			{
+			case ComponentType::Int8: return SelectUIntKernel<ComponentType::Int8>(n);
+			case ComponentType::UInt8: return SelectUIntKernel<ComponentType::UInt8>(n);
+			case ComponentType::Int16: return SelectUIntKernel<ComponentType::Int16>(n);
+			case ComponentType::UInt16: return SelectUIntKernel<ComponentType::UInt16>(n);
+			case ComponentType::UInt32: return SelectUIntKernel<ComponentType::UInt32>(n);
+			default: return nullptr;
+			}
+		}
+#endif // ACCESSOR_DECODING_SSE2
+
+		// Elements that are already in the destination layout
+		bool CanCopy(const Layout& layout, ComponentType dstType, size_t dstStride, uint32_t dstComponents)
+		{
+			const size_t elementSize = GetElementSize(layout);
+			return layout.Type == dstType && !layout.Normalized && layout.NumColumns == 1 && layout.NumComponents == dstComponents &&
+				layout.Stride == elementSize && dstStride == elementSize;
+		}
+
+		bool CanUseSIMD(const Layout& layout, uint32_t dstComponents)
+		{
+			return layout.Data && layout.NumColumns == 1 && layout.NumComponents == dstComponents && dstComponents <= 4;
+		}
+
+		// Range of the view, fails if the buffer isn't loaded or if the range is outside of the view
+		bool GetViewData(const cgltf_buffer_view* view, size_t offset, size_t size, const uint8_t*& data)
+		{
+			if (!view || !view->buffer) return false;
+
+			const cgltf_buffer* buffer = view->buffer;
+			if (view->data)
+			{
+				if (offset > view->size || size > view->size - offset) return false;
+				data = (const uint8_t*) view->data + offset;
+				return true;
+			}
+
+			if (!buffer->data || view->offset > buffer->size || view->size > buffer->size - view->offset) return false;
+			if (offset > view->size || size > view->size - offset) return false;
+
+			data = (const uint8_t*) buffer->data + view->offset + offset;
+			return true;
+		}
+
+		uint32_t GetNumColumns(cgltf_type type)
+		{
+			switch (type)
+			{
+			case cgltf_type_mat2: return 2;
+			case cgltf_type_mat3: return 3;
+			case cgltf_type_mat4: return 4;
+			default: return 1;
+			}
+		}
+
+		bool GetLayout(const cgltf_accessor* accessor, Layout& layout)
+		{
+			if (accessor->type == cgltf_type_invalid || accessor->component_type == cgltf_component_type_invalid) return false;
+
+			layout.Count = accessor->count;
+			layout.Type = (ComponentType) accessor->component_type;
+			layout.NumComponents = (uint32_t) cgltf_num_components(accessor->type);
+			layout.NumColumns = GetNumColumns(accessor->type);
+			layout.Normalized = accessor->normalized;
+
+			const size_t elementSize = GetElementSize(layout);
+			layout.Stride = accessor->stride ? accessor->stride : elementSize;
+
+			if (!accessor->buffer_view || layout.Count == 0) return true;
+			return GetViewData(accessor->buffer_view, accessor->offset, (layout.Count - 1) * layout.Stride + elementSize, layout.Data);
+		}
+
+		bool GetSparseLayout(const cgltf_accessor* accessor, const Layout& layout, SparseLayout& sparse)
+		{
+			const cgltf_accessor_sparse& data = accessor->sparse;
+			sparse.Count = data.count;
+			sparse.IndexType = (ComponentType) data.indices_component_type;
+			if (sparse.IndexType != ComponentType::UInt8 && sparse.IndexType != ComponentType::UInt16 && sparse.IndexType != ComponentType::UInt32) return false;
+
+			return GetViewData(data.indices_buffer_view, data.indices_byte_offset, sparse.Count * GetComponentSize(sparse.IndexType), sparse.Indices) &&
+				GetViewData(data.values_buffer_view, data.values_byte_offset, sparse.Count * GetElementSize(layout), sparse.Values);
+		}
+
+		template<typename T, typename DecodeFunc>
+		bool ReadAccessor(const cgltf_accessor* accessor, T* dst, size_t dstStride, uint32_t dstComponents, DecodeFunc decode)
+		{
+			Layout layout;
+			SparseLayout sparse;
+			if (!GetLayout(accessor, layout)) return false;
+			if (accessor->is_sparse && !GetSparseLayout(accessor, layout, sparse)) return false;
+
+			decode(layout, dst, dstStride, dstComponents);
+			if (accessor->is_sparse) ApplySparse(layout, sparse, dst, dstStride, dstComponents);
+			return true;
+		}
+	}
+
+	uint32_t GetComponentSize(ComponentType type)
+	{
+		switch (type)
+		{
+		case ComponentType::Int8:
+		case ComponentType::UInt8: return 1;
+		case ComponentType::Int16:
+		case ComponentType::UInt16: return 2;
+		case ComponentType::UInt32:
+		case ComponentType::Float: return 4;
+		default: return 0;
+		}
+	}
+
+	size_t GetElementSize(const Layout& layout)
+	{
+		return layout.NumColumns * GetColumnStride(layout);
+	}
+
+	void DecodeFloats(const Layout& layout, float* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		if (layout.Data && CanCopy(layout, ComponentType::Float, dstStride, dstComponents))
+		{
+			memcpy(dst, layout.Data, layout.Count * layout.Stride);
+			return;
+		}
+
+#ifdef ACCESSOR_DECODING_SSE2
+		if (CanUseSIMD(layout, dstComponents))
+		{
+			if (const FloatKernel kernel = GetFloatKernel(layout))
+			{
+				kernel(layout, dst, dstStride);
+				return;
+			}
+		}
+#endif
+
+		DecodeFloatsReference(layout, dst, dstStride, dstComponents);
+	}
+
+	void DecodeUInts(const Layout& layout, uint32_t* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		if (layout.Data && CanCopy(layout, ComponentType::UInt32, dstStride, dstComponents))
+		{
+			memcpy(dst, layout.Data, layout.Count * layout.Stride);
+			return;
+		}
+
+#ifdef ACCESSOR_DECODING_SSE2
+		if (CanUseSIMD(layout, dstComponents))
+		{
+			const bool packedIndices = dstComponents == 1 && dstStride == sizeof(uint32_t) && layout.Stride == GetComponentSize(layout.Type);
+			if (packedIndices && (layout.Type == ComponentType::UInt8 || layout.Type == ComponentType::UInt16))
+			{
+				WidenIndicesSSE2(layout, dst);
+				return;
+			}
+
+			if (const UIntKernel kernel = GetUIntKernel(layout))
+			{
+				kernel(layout, dst, dstStride);
+				return;
+			}
+		}
+#endif
+
+		DecodeUIntsReference(layout, dst, dstStride, dstComponents);
+	}
+
+	void DecodeFloatsReference(const Layout& layout, float* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		DecodeReference(layout, dst, dstStride, dstComponents, [&layout](const uint8_t* component) { return ReadFloat(component, layout.Type, layout.Normalized); });
+	}
+
+	void DecodeUIntsReference(const Layout& layout, uint32_t* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		DecodeReference(layout, dst, dstStride, dstComponents, [&layout](const uint8_t* component) { return ReadUInt(component, layout.Type); });
+	}
+
+	void ApplySparse(const Layout& layout, const SparseLayout& sparse, float* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		ApplySparseValues(layout, sparse, dst, dstStride, dstComponents, DecodeFloatsReference);
+	}
+
+	void ApplySparse(const Layout& layout, const SparseLayout& sparse, uint32_t* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		ApplySparseValues(layout, sparse, dst, dstStride, dstComponents, DecodeUIntsReference);
+	}
+
+	bool ReadFloats(const cgltf_accessor* accessor, float* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		return ReadAccessor(accessor, dst, dstStride, dstComponents, DecodeFloats);
+	}
+
+	bool ReadUInts(const cgltf_accessor* accessor, uint32_t* dst, size_t dstStride, uint32_t dstComponents)
+	{
+		return ReadAccessor(accessor, dst, dstStride, dstComponents, DecodeUInts);
+	}
+}
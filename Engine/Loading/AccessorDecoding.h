@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct cgltf_accessor;
+
+// Converts glTF accessors into floats and unsigned integers with the layout of the engine vertex formats
+// Handles every component type, normalization, byte stride, padded matrix columns and sparse accessors
+// Doesn't depend on D3D12, common formats have SSE2 paths that are compared against the scalar reference
+namespace AccessorDecoding
+{
+	// Values match cgltf_component_type
+	enum class ComponentType : uint32_t
+	{
+		Invalid,
+		Int8,
+		UInt8,
+		Int16,
+		UInt16,
+		UInt32,
+		Float,
+	};
+
+	// Elements of an accessor in memory
+	struct Layout
+	{
+		// Elements are zero if there is no data, a sparse accessor may not have a buffer view
+		const uint8_t* Data = nullptr;
+		size_t Count = 0;
+		size_t Stride = 0;
+
+		ComponentType Type = ComponentType::Float;
+		uint32_t NumComponents = 1;
+
+		// Matrix columns start at 4 byte boundaries
+		uint32_t NumColumns = 1;
+		bool Normalized = false;
+	};
+
+	// Elements at the indices are replaced by the values, values are tightly packed elements of the accessor type
+	struct SparseLayout
+	{
+		size_t Count = 0;
+		const uint8_t* Indices = nullptr;
+		ComponentType IndexType = ComponentType::UInt32;
+		const uint8_t* Values = nullptr;
+	};
+
+	uint32_t GetComponentSize(ComponentType type);
+
+	// Size of the element with the column padding
+	size_t GetElementSize(const Layout& layout);
+
+	// Elements are written dstStride bytes apart with dstComponents components each
+	// Components the accessor doesn't have are zero and the ones that don't fit are dropped
+	void DecodeFloats(const Layout& layout, float* dst, size_t dstStride, uint32_t dstComponents);
+	void DecodeUInts(const Layout& layout, uint32_t* dst, size_t dstStride, uint32_t dstComponents);
+
+	// Component by component conversion, the SIMD paths are expected to match it exactly
+	void DecodeFloatsReference(const Layout& layout, float* dst, size_t dstStride, uint32_t dstComponents);
+	void DecodeUIntsReference(const Layout& layout, uint32_t* dst, size_t dstStride, uint32_t dstComponents);
+
+	// Writes the sparse values over the decoded elements, indices outside of the accessor are skipped
+	void ApplySparse(const Layout& layout, const SparseLayout& sparse, float* dst, size_t dstStride, uint32_t dstComponents);
+	void ApplySparse(const Layout& layout, const SparseLayout& sparse, uint32_t* dst, size_t dstStride, uint32_t dstComponents);
+
+	// Decodes the accessor with its sparse values, buffers have to be loaded
+	// Fails if a buffer isn't loaded or if the accessor reads outside of its buffer view
+	bool ReadFloats(const cgltf_accessor* accessor, float* dst, size_t dstStride, uint32_t dstComponents);
+	bool ReadUInts(const cgltf_accessor* accessor, uint32_t* dst, size_t dstStride, uint32_t dstComponents);
+
+	// Tightly packed indices
+	inline bool ReadIndices(const cgltf_accessor* accessor, uint32_t* dst) { return ReadUInts(accessor, dst, sizeof(uint32_t), 1); }
+}
@@ -0,0 +1,539 @@
+#include "AssetArchive.h"
+
+#include <set>
+#include <memory>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <shared_mutex>
+
+#include "Utility/Hash.h"
+#include "Utility/LZ4.h"
+#include "Utility/Multithreading.h"
+
+namespace AssetArchive
+{
+	namespace
+	{
+		constexpr uint32_t ARCHIVE_MAGIC = 0x41545341; // ASTA
+		constexpr uint32_t ARCHIVE_VERSION = 2;
+
+		// Stored files are used in place, their data is aligned for the SIMD loads of the decoders
+		constexpr uint64_t DATA_ALIGNMENT = 64;
+		constexpr uint64_t TABLE_ALIGNMENT = 8;
+
+		// File is compressed only if it saves at least 1/16 of the size, otherwise it's stored and used in place
+		constexpr uint64_t MIN_SAVING_FRACTION = 16;
+
+		// Table of contents is at the end of the file, so the packer writes the chunks as it compresses them
+		struct ArchiveHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t ChunkSize;
+			uint32_t NumEntries;
+			uint32_t NumChunks;
+			uint32_t NamesSize;
+			uint64_t TableOffset;
+
+			// Hash of the entries, chunks and names
+			uint64_t TableHash;
+		};
+
+		uint64_t Align(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		uint64_t HashName(std::string_view name)
+		{
+			return Hash::XXHash64(reinterpret_cast<const uint8_t*>(name.data()), name.size());
+		}
+
+		bool IsOrdered(uint64_t hashA, std::string_view nameA, uint64_t hashB, std::string_view nameB)
+		{
+			return hashA != hashB ? hashA < hashB : nameA < nameB;
+		}
+
+		// System clock instead of the file clock, so the archive packed on one platform compares with the files on the other
+		uint64_t GetWriteTime(const std::string& path)
+		{
+			std::error_code error;
+			const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+			if (error) return 0;
+
+			const auto systemTime = std::chrono::file_clock::to_sys(writeTime);
+			return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(systemTime.time_since_epoch()).count();
+		}
+
+		// Loose file that was edited after the packing wins, the archive doesn't have to be rebuilt after every change
+		// Entry without a loose file is never stale, the archive can be shipped alone
+		bool IsStale(const Entry& entry, const std::string& path)
+		{
+			std::error_code error;
+			const uint64_t size = std::filesystem::file_size(path, error);
+			if (error) return false;
+
+			return size != entry.Size || GetWriteTime(path) != entry.WriteTime;
+		}
+
+		enum class EntryState : uint8_t
+		{
+			Unchecked,
+			Current,
+			Stale,
+		};
+
+		// Loose file of an entry is checked on its first lookup, not on every open, and the result is kept while the archive is mounted
+		struct MountedArchive
+		{
+			std::unique_ptr<Archive> Data;
+			std::unique_ptr<std::atomic<EntryState>[]> EntryStates;
+		};
+
+		std::vector<MountedArchive> MountedArchives;
+		std::shared_mutex MountedArchivesMutex;
+
+		const Entry* FindMountedEntry(const std::string& path, const Archive*& archive)
+		{
+			std::shared_lock<std::shared_mutex> lock(MountedArchivesMutex);
+			if (MountedArchives.empty()) return nullptr;
+
+			for (auto it = MountedArchives.rbegin(); it != MountedArchives.rend(); it++)
+			{
+				const Entry* entry = it->Data->Find(path);
+				if (!entry) continue;
+
+				// Threads that look up the same entry for the first time can both check it, they come to the same result
+				std::atomic<EntryState>& state = it->EntryStates[entry - it->Data->GetEntries().data()];
+				if (state == EntryState::Unchecked)
+				{
+					if (!IsStale(*entry, path)) state = EntryState::Current;
+					else if (state.exchange(EntryState::Stale) != EntryState::Stale)
+					{
+						std::cout << "Warning: Loose file changed after the asset archive was packed, reading it instead: " << path << std::endl;
+					}
+				}
+
+				if (state == EntryState::Current)
+				{
+					archive = it->Data.get();
+					return entry;
+				}
+			}
+			return nullptr;
+		}
+	}
+
+	std::string NormalizeName(const std::string& path)
+	{
+		std::string name = path;
+		std::replace(name.begin(), name.end(), '\\', '/');
+		name = std::filesystem::path(name).lexically_normal().generic_string();
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+		return name;
+	}
+
+	bool Archive::Open(const std::string& path)
+	{
+		Close();
+		if (!m_File.Open(path)) return false;
+
+		ArchiveHeader header{};
+		if (m_File.GetSize() >= sizeof(header)) memcpy(&header, m_File.GetData(), sizeof(header));
+		if (header.Magic != ARCHIVE_MAGIC || header.Version != ARCHIVE_VERSION)
+		{
+			m_File.Close();
+			return false;
+		}
+
+		const uint64_t tableSize = (uint64_t) header.NumEntries * sizeof(Entry) + (uint64_t) header.NumChunks * sizeof(Chunk) + header.NamesSize;
+		bool valid = header.ChunkSize > 0 && header.TableOffset % TABLE_ALIGNMENT == 0 && header.TableOffset >= sizeof(header) && header.TableOffset <= m_File.GetSize() && tableSize == m_File.GetSize() - header.TableOffset;
+		valid = valid && Hash::XXHash64(m_File.GetData() + header.TableOffset, tableSize) == header.TableHash;
+
+		if (valid)
+		{
+			const uint8_t* table = m_File.GetData() + header.TableOffset;
+			m_Entries = { reinterpret_cast<const Entry*>(table), header.NumEntries };
+			m_Chunks = { reinterpret_cast<const Chunk*>(table + m_Entries.size_bytes()), header.NumChunks };
+			m_Names = { reinterpret_cast<const char*>(table + m_Entries.size_bytes() + m_Chunks.size_bytes()), header.NamesSize };
+			m_ChunkSize = header.ChunkSize;
+		}
+
+		// Reads trust the table after this, a chunk can't point out of the data and a file can't point out of the chunks
+		for (size_t i = 0; i < m_Entries.size() && valid; i++)
+		{
+			const Entry& entry = m_Entries[i];
+			valid = entry.NameOffset <= m_Names.size() && entry.NameSize <= m_Names.size() - entry.NameOffset;
+			valid = valid && entry.FirstChunk <= m_Chunks.size() && entry.NumChunks <= m_Chunks.size() - entry.FirstChunk;
+			valid = valid && entry.NumChunks == (entry.Size + m_ChunkSize - 1) / m_ChunkSize;
+			valid = valid && HashName(GetName(entry)) == entry.NameHash;
+			valid = valid && (i == 0 || IsOrdered(m_Entries[i - 1].NameHash, GetName(m_Entries[i - 1]), entry.NameHash, GetName(entry)));
+
+			for (uint32_t c = 0; c < entry.NumChunks && valid; c++)
+			{
+				const Chunk& chunk = m_Chunks[entry.FirstChunk + c];
+				const uint64_t expectedSize = std::min<uint64_t>(m_ChunkSize, entry.Size - (uint64_t) c * m_ChunkSize);
+				valid = chunk.Size == expectedSize && chunk.StoredSize <= chunk.Size && chunk.Offset <= header.TableOffset && chunk.StoredSize <= header.TableOffset - chunk.Offset;
+			}
+		}
+
+		if (!valid)
+		{
+			std::cout << "Warning: Corrupted asset archive: " << path << std::endl;
+			Close();
+			return false;
+		}
+
+		m_Path = path;
+		return true;
+	}
+
+	void Archive::Close()
+	{
+		m_File.Close();
+		m_Path.clear();
+		m_Entries = {};
+		m_Chunks = {};
+		m_Names = {};
+		m_ChunkSize = DEFAULT_CHUNK_SIZE;
+	}
+
+	const Entry* Archive::Find(const std::string& path) const
+	{
+		const std::string name = NormalizeName(path);
+		const uint64_t nameHash = HashName(name);
+
+		const auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), name, [&](const Entry& entry, const std::string& value)
+		{
+			return IsOrdered(entry.NameHash, GetName(entry), nameHash, value);
+		});
+
+		if (it == m_Entries.end() || it->NameHash != nameHash || GetName(*it) != name) return nullptr;
+		return &*it;
+	}
+
+	std::string_view Archive::GetName(const Entry& entry) const
+	{
+		return m_Names.substr(entry.NameOffset, entry.NameSize);
+	}
+
+	uint64_t Archive::GetStoredSize(const Entry& entry) const
+	{
+		uint64_t storedSize = 0;
+		for (const Chunk& chunk : m_Chunks.subspan(entry.FirstChunk, entry.NumChunks)) storedSize += chunk.StoredSize;
+		return storedSize;
+	}
+
+	bool Archive::Read(const Entry& entry, uint8_t* dst, uint32_t numThreads) const
+	{
+		if (numThreads == 0) numThreads = MTR::GetNumWorkerThreads(entry.NumChunks);
+
+		// Chunks have the same size so the contiguous ranges take the same time
+		std::atomic<bool> valid = true;
+		MTR::ParallelFor(entry.NumChunks, numThreads, [&](uint32_t rangeStart, uint32_t rangeEnd, uint32_t)
+		{
+			for (uint32_t i = rangeStart; i < rangeEnd && valid; i++)
+			{
+				const Chunk& chunk = m_Chunks[entry.FirstChunk + i];
+				const uint8_t* stored = m_File.GetData() + chunk.Offset;
+				uint8_t* chunkDst = dst + (uint64_t) i * m_ChunkSize;
+
+				if (Hash::Crc32C(stored, chunk.StoredSize) != chunk.Checksum) valid = false;
+				else if (chunk.StoredSize == chunk.Size) memcpy(chunkDst, stored, chunk.Size);
+				else if (!LZ4::Decompress(stored, chunk.StoredSize, chunkDst, chunk.Size)) valid = false;
+			}
+		});
+
+		if (!valid)
+		{
+			std::cout << "Warning: Corrupted asset archive entry: " << GetName(entry) << " in " << m_Path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool Archive::IsStored(const Entry& entry) const
+	{
+		const std::span<const Chunk> chunks = m_Chunks.subspan(entry.FirstChunk, entry.NumChunks);
+		if (chunks.empty()) return false;
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			if (chunks[i].StoredSize != chunks[i].Size || chunks[i].Offset != chunks[0].Offset + i * m_ChunkSize) return false;
+		}
+		return true;
+	}
+
+	const uint8_t* Archive::GetStoredData(const Entry& entry, uint32_t numThreads) const
+	{
+		if (!VerifyChunks(entry, numThreads))
+		{
+			std::cout << "Warning: Corrupted asset archive entry: " << GetName(entry) << " in " << m_Path << std::endl;
+			return nullptr;
+		}
+		return m_File.GetData() + m_Chunks[entry.FirstChunk].Offset;
+	}
+
+	bool Archive::VerifyChunks(const Entry& entry, uint32_t numThreads) const
+	{
+		if (numThreads == 0) numThreads = MTR::GetNumWorkerThreads(entry.NumChunks);
+
+		std::atomic<bool> valid = true;
+		MTR::ParallelFor(entry.NumChunks, numThreads, [&](uint32_t rangeStart, uint32_t rangeEnd, uint32_t)
+		{
+			for (uint32_t i = rangeStart; i < rangeEnd && valid; i++)
+			{
+				const Chunk& chunk = m_Chunks[entry.FirstChunk + i];
+				if (Hash::Crc32C(m_File.GetData() + chunk.Offset, chunk.StoredSize) != chunk.Checksum) valid = false;
+			}
+		});
+		return valid;
+	}
+
+	bool Archive::Verify(uint32_t numThreads) const
+	{
+		// Largest entries first, every thread decompresses whole entries into its own buffer
+		std::vector<uint32_t> order(m_Entries.size());
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return m_Entries[a].Size > m_Entries[b].Size; });
+
+		if (numThreads == 0) numThreads = MTR::GetNumWorkerThreads((uint32_t) order.size());
+
+		std::atomic<bool> valid = true;
+		std::vector<std::vector<uint8_t>> buffers(numThreads);
+		MTR::ParallelForEach(order, numThreads, [&](uint32_t entryIndex, uint32_t threadIndex)
+		{
+			const Entry& entry = m_Entries[entryIndex];
+			std::vector<uint8_t>& buffer = buffers[threadIndex];
+			buffer.resize(entry.Size);
+
+			// Read prints the warning for the corrupted chunks
+			if (!Read(entry, buffer.data(), 1))
+			{
+				valid = false;
+			}
+			else if (Hash::XXHash64(buffer.data(), buffer.size()) != entry.ContentHash)
+			{
+				std::cout << "Warning: Asset archive entry doesn't match its content hash: " << GetName(entry) << " in " << m_Path << std::endl;
+				valid = false;
+			}
+		});
+		return valid;
+	}
+
+	bool Pack(const std::string& archivePath, const std::vector<SourceFile>& files, uint32_t numThreads, PackStatistics& statistics)
+	{
+		statistics = PackStatistics{};
+
+		std::vector<std::string> names;
+		std::set<std::string> uniqueNames;
+		for (const SourceFile& sourceFile : files)
+		{
+			names.push_back(NormalizeName(sourceFile.Name));
+			if (!uniqueNames.insert(names.back()).second)
+			{
+				std::cout << "Warning: Asset archive would have the file twice: " << names.back() << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		const std::filesystem::path parentPath = std::filesystem::path(archivePath).parent_path();
+		if (!parentPath.empty()) std::filesystem::create_directories(parentPath, error);
+
+		std::ofstream archiveFile(archivePath, std::ios::binary | std::ios::trunc);
+		if (!archiveFile.is_open()) return false;
+
+		// Header is written again once the table is known
+		ArchiveHeader header{};
+		archiveFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		uint64_t offset = sizeof(header);
+
+		const auto writePadding = [&](uint64_t alignment)
+		{
+			const uint64_t alignedOffset = Align(offset, alignment);
+			const std::vector<char> padding(alignedOffset - offset, 0);
+			archiveFile.write(padding.data(), padding.size());
+			offset = alignedOffset;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<Chunk> chunks;
+		std::vector<uint8_t> content;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			if (!FileUtility::ReadBinaryFile(files[i].Path, content))
+			{
+				std::cout << "Warning: Failed to read the file for the asset archive: " << files[i].Path << std::endl;
+				return false;
+			}
+
+			Entry entry{};
+			entry.NameHash = HashName(names[i]);
+			entry.Size = content.size();
+			entry.ContentHash = Hash::XXHash64(content.data(), content.size());
+			entry.WriteTime = GetWriteTime(files[i].Path);
+			entry.FirstChunk = (uint32_t) chunks.size();
+			entry.NumChunks = (uint32_t) ((content.size() + DEFAULT_CHUNK_SIZE - 1) / DEFAULT_CHUNK_SIZE);
+
+			std::vector<std::vector<uint8_t>> compressedChunks(entry.NumChunks);
+			MTR::ParallelFor(entry.NumChunks, numThreads ? numThreads : MTR::GetNumWorkerThreads(entry.NumChunks), [&](uint32_t rangeStart, uint32_t rangeEnd, uint32_t)
+			{
+				for (uint32_t c = rangeStart; c < rangeEnd; c++)
+				{
+					const uint8_t* src = content.data() + (size_t) c * DEFAULT_CHUNK_SIZE;
+					const size_t size = std::min<size_t>(DEFAULT_CHUNK_SIZE, content.size() - (size_t) c * DEFAULT_CHUNK_SIZE);
+
+					std::vector<uint8_t>& compressed = compressedChunks[c];
+					compressed.resize(LZ4::GetMaxCompressedSize(size));
+					compressed.resize(LZ4::Compress(src, size, compressed.data()));
+				}
+			});
+
+			uint64_t compressedSize = 0;
+			for (const std::vector<uint8_t>& compressed : compressedChunks) compressedSize += compressed.size();
+			const bool stored = compressedSize > entry.Size - entry.Size / MIN_SAVING_FRACTION;
+
+			writePadding(DATA_ALIGNMENT);
+			for (uint32_t c = 0; c < entry.NumChunks; c++)
+			{
+				Chunk chunk{};
+				chunk.Offset = offset;
+				chunk.Size = (uint32_t) std::min<size_t>(DEFAULT_CHUNK_SIZE, content.size() - (size_t) c * DEFAULT_CHUNK_SIZE);
+
+				// Chunk that doesn't get smaller is stored even in a compressed file
+				const std::vector<uint8_t>& compressed = compressedChunks[c];
+				const bool useCompressed = !stored && compressed.size() < chunk.Size;
+				const uint8_t* storedData = useCompressed ? compressed.data() : content.data() + (size_t) c * DEFAULT_CHUNK_SIZE;
+				chunk.StoredSize = useCompressed ? (uint32_t) compressed.size() : chunk.Size;
+				chunk.Checksum = Hash::Crc32C(storedData, chunk.StoredSize);
+
+				archiveFile.write(reinterpret_cast<const char*>(storedData), chunk.StoredSize);
+				offset += chunk.StoredSize;
+				chunks.push_back(chunk);
+			}
+
+			entries.push_back(entry);
+			statistics.NumFiles++;
+			statistics.NumStoredFiles += stored ? 1 : 0;
+			statistics.Size += entry.Size;
+			statistics.StoredSize += stored ? entry.Size : std::min(compressedSize, entry.Size);
+		}
+
+		// Names are placed in the order of the table, lookups compare the name right after the hash
+		std::vector<uint32_t> order(entries.size());
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return IsOrdered(entries[a].NameHash, names[a], entries[b].NameHash, names[b]); });
+
+		FileUtility::BinaryWriter table;
+		std::string nameTable;
+		for (uint32_t entryIndex : order)
+		{
+			Entry entry = entries[entryIndex];
+			entry.NameOffset = (uint32_t) nameTable.size();
+			entry.NameSize = (uint32_t) names[entryIndex].size();
+			nameTable += names[entryIndex];
+			table.Write(entry);
+		}
+		table.WriteArray(chunks);
+		table.Write(nameTable.data(), nameTable.size());
+
+		writePadding(TABLE_ALIGNMENT);
+		archiveFile.write(reinterpret_cast<const char*>(table.GetData().data()), table.GetData().size());
+
+		header.Magic = ARCHIVE_MAGIC;
+		header.Version = ARCHIVE_VERSION;
+		header.ChunkSize = DEFAULT_CHUNK_SIZE;
+		header.NumEntries = (uint32_t) entries.size();
+		header.NumChunks = (uint32_t) chunks.size();
+		header.NamesSize = (uint32_t) nameTable.size();
+		header.TableOffset = offset;
+		header.TableHash = Hash::XXHash64(table.GetData().data(), table.GetData().size());
+
+		archiveFile.seekp(0);
+		archiveFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		return (bool) archiveFile;
+	}
+
+	bool Mount(const std::string& path)
+	{
+		std::unique_ptr<Archive> archive = std::make_unique<Archive>();
+		if (!archive->Open(path)) return false;
+
+		MountedArchive mounted{};
+		mounted.EntryStates = std::make_unique<std::atomic<EntryState>[]>(archive->GetEntries().size());
+		mounted.Data = std::move(archive);
+
+		std::unique_lock<std::shared_mutex> lock(MountedArchivesMutex);
+		MountedArchives.push_back(std::move(mounted));
+		return true;
+	}
+
+	void UnmountAll()
+	{
+		std::unique_lock<std::shared_mutex> lock(MountedArchivesMutex);
+		MountedArchives.clear();
+	}
+
+	bool FindMountedFile(const std::string& path, FileInfo& info)
+	{
+		const Archive* archive = nullptr;
+		const Entry* entry = FindMountedEntry(path, archive);
+		if (!entry) return false;
+
+		info.Size = entry->Size;
+		info.ContentHash = entry->ContentHash;
+		return true;
+	}
+
+	bool AssetFile::Open(const std::string& path)
+	{
+		Close();
+
+		const Archive* archive = nullptr;
+		const Entry* entry = FindMountedEntry(path, archive);
+		if (!entry)
+		{
+			if (!m_File.Open(path)) return false;
+
+			m_Data = m_File.GetData();
+			m_Size = m_File.GetSize();
+			return true;
+		}
+
+		if (entry->Size == 0) return false;
+
+		if (archive->IsStored(*entry))
+		{
+			m_Data = archive->GetStoredData(*entry);
+		}
+		else
+		{
+			m_Buffer.resize(entry->Size);
+			if (archive->Read(*entry, m_Buffer.data())) m_Data = m_Buffer.data();
+		}
+
+		// Corrupted entry fails instead of falling back to the loose file, the archive is expected to be rebuilt
+		if (!m_Data)
+		{
+			Close();
+			return false;
+		}
+
+		m_Size = entry->Size;
+		return true;
+	}
+
+	void AssetFile::Close()
+	{
+		m_File.Close();
+		m_Buffer = {};
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}
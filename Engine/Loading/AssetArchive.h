@@ -0,0 +1,164 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include "Utility/FileUtility.h"
+
+// Resource files packed into a single memory mapped file, built by Tools/AssetPacker
+// Files are split into chunks that are LZ4 compressed independently, so a file is decompressed by several threads into the memory of the caller
+// Incompressible files like JPG and PNG are stored as they are and used in place of the mapping
+// Doesn't depend on D3D12, the packer and the reader build on any platform
+namespace AssetArchive
+{
+	constexpr const char* DEFAULT_PATH = "Cache/AssetArchive.bin";
+	constexpr uint32_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+	// Table of contents, sorted by the name hash and then by the name
+	struct Entry
+	{
+		uint64_t NameHash;
+		uint64_t Size;
+
+		// Hash of the uncompressed content, checked by Archive::Verify
+		uint64_t ContentHash;
+
+		// Last write of the packed file in nanoseconds since the Unix epoch, compared with the loose file to find stale entries
+		uint64_t WriteTime;
+
+		uint32_t FirstChunk;
+		uint32_t NumChunks;
+
+		// Normalized name in the name table
+		uint32_t NameOffset;
+		uint32_t NameSize;
+	};
+
+	// Every chunk has DEFAULT_CHUNK_SIZE uncompressed bytes except the last one of the file
+	struct Chunk
+	{
+		uint64_t Offset;
+		uint32_t StoredSize;
+		uint32_t Size;
+
+		// CRC32C of the stored bytes, checked on every read
+		uint32_t Checksum;
+		uint32_t Padding;
+	};
+
+	// Relative path with '/' separators, without "." and "..", and in lower case so the archive built on Linux works on Windows
+	// Names are resolved without touching the file system, absolute paths aren't found in archives
+	std::string NormalizeName(const std::string& path);
+
+	class Archive
+	{
+	public:
+		Archive() = default;
+
+		Archive(const Archive&) = delete;
+		Archive& operator=(const Archive&) = delete;
+
+		// Fails if the file doesn't exist, has a different archive version or the table of contents is corrupted
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_File.IsOpen(); }
+		const std::string& GetPath() const { return m_Path; }
+
+		// Null if the file isn't in the archive
+		const Entry* Find(const std::string& path) const;
+
+		std::span<const Entry> GetEntries() const { return m_Entries; }
+		std::string_view GetName(const Entry& entry) const;
+
+		// Bytes the entry takes in the archive
+		uint64_t GetStoredSize(const Entry& entry) const;
+
+		// Decompresses the chunks into dst that holds entry.Size bytes, numThreads 0 uses a thread per core
+		// Fails with a warning if a chunk is corrupted
+		bool Read(const Entry& entry, uint8_t* dst, uint32_t numThreads = 0) const;
+
+		// Entry is stored without compression in one piece
+		bool IsStored(const Entry& entry) const;
+
+		// Points into the mapping, the entry has to be stored, null with a warning if a chunk is corrupted
+		const uint8_t* GetStoredData(const Entry& entry, uint32_t numThreads = 0) const;
+
+		// Decompresses every entry and compares the content hashes, prints a warning for each corrupted entry
+		bool Verify(uint32_t numThreads = 0) const;
+
+	private:
+		bool VerifyChunks(const Entry& entry, uint32_t numThreads) const;
+
+	private:
+		std::string m_Path;
+		FileUtility::MappedFile m_File;
+		std::span<const Entry> m_Entries;
+		std::span<const Chunk> m_Chunks;
+		std::string_view m_Names;
+		uint32_t m_ChunkSize = DEFAULT_CHUNK_SIZE;
+	};
+
+	struct SourceFile
+	{
+		// Name the file is found by, normalized when packed
+		std::string Name;
+		std::string Path;
+	};
+
+	struct PackStatistics
+	{
+		uint32_t NumFiles = 0;
+		uint32_t NumStoredFiles = 0;
+		uint64_t Size = 0;
+		uint64_t StoredSize = 0;
+	};
+
+	// Chunks of each file are compressed in parallel, files are written in the given order so the related ones are read together
+	// Fails if a file can't be read or two names are the same after the normalization
+	bool Pack(const std::string& archivePath, const std::vector<SourceFile>& files, uint32_t numThreads, PackStatistics& statistics);
+
+	// Mounted archives are searched before the loose files, the last mounted first
+	// Entry whose loose file has another size or write time than when it was packed is stale, the loose file is read instead
+	// Loose file is checked once on the first lookup of the entry, it has to be mounted again to see later edits
+	// Mount before the loading starts, the files opened from an archive have to be closed before it's unmounted
+	bool Mount(const std::string& path);
+	void UnmountAll();
+
+	struct FileInfo
+	{
+		uint64_t Size = 0;
+		uint64_t ContentHash = 0;
+	};
+
+	// Fails if the file isn't in any of the mounted archives or its entries are stale
+	bool FindMountedFile(const std::string& path, FileInfo& info);
+
+	// Whole file either from the mounted archives or mapped from the disk
+	// Stored entries point into the archive mapping, compressed ones are decompressed into memory owned by the file
+	class AssetFile
+	{
+	public:
+		AssetFile() = default;
+
+		AssetFile(const AssetFile&) = delete;
+		AssetFile& operator=(const AssetFile&) = delete;
+
+		// Fails for empty files, same as FileUtility::MappedFile
+		bool Open(const std::string& path);
+		void Close();
+
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+		bool IsOpen() const { return m_Data != nullptr; }
+
+	private:
+		FileUtility::MappedFile m_File;
+		std::vector<uint8_t> m_Buffer;
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+}
@@ -0,0 +1,642 @@
+#include "BCEncoding.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#include "Utility/Multithreading.h"
+
+namespace BCEncoding
+{
+	namespace
+	{
+		using BlockEncoder = void (*)(const uint8_t* block, uint8_t* dst);
+		using BlockDecoder = void (*)(const uint8_t* src, uint8_t* block);
+
+		// Bits are packed from the lowest bit of the first byte, the data has to be zeroed before writing
+		struct BitWriter
+		{
+			uint8_t* Data;
+			uint32_t Position = 0;
+
+			void Write(uint32_t value, uint32_t numBits)
+			{
+				for (uint32_t i = 0; i < numBits; i++, Position++)
+				{
+					if ((value >> i) & 1) Data[Position / 8] |= (uint8_t) (1 << (Position % 8));
+				}
+			}
+		};
+
+		struct BitReader
+		{
+			const uint8_t* Data;
+			uint32_t Position = 0;
+
+			uint32_t Read(uint32_t numBits)
+			{
+				uint32_t value = 0;
+				for (uint32_t i = 0; i < numBits; i++, Position++)
+				{
+					value |= (uint32_t) ((Data[Position / 8] >> (Position % 8)) & 1) << i;
+				}
+				return value;
+			}
+		};
+
+		template<uint32_t N>
+		float GetDistance(const float* a, const int* b)
+		{
+			float distance = 0.0f;
+			for (uint32_t c = 0; c < N; c++) distance += (a[c] - b[c]) * (a[c] - b[c]);
+			return distance;
+		}
+
+		// Line through the mean of the pixels in the direction of the largest variance, found by power iteration
+		// Endpoints are the extreme projections of the pixels on the line
+		template<uint32_t N>
+		void FitLine(const float (&pixels)[BLOCK_PIXELS][4], float (&endpoints)[2][4])
+		{
+			float mean[N] = {};
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				for (uint32_t c = 0; c < N; c++) mean[c] += pixels[i][c] / BLOCK_PIXELS;
+			}
+
+			float covariance[N][N] = {};
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				for (uint32_t a = 0; a < N; a++)
+				{
+					for (uint32_t b = 0; b < N; b++) covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+				}
+			}
+
+			float axis[N];
+			for (uint32_t c = 0; c < N; c++) axis[c] = 1.0f;
+			for (uint32_t iteration = 0; iteration < 8; iteration++)
+			{
+				float next[N] = {};
+				float length = 0.0f;
+				for (uint32_t a = 0; a < N; a++)
+				{
+					for (uint32_t b = 0; b < N; b++) next[a] += covariance[a][b] * axis[b];
+					length = std::max(length, std::abs(next[a]));
+				}
+
+				// Pixels are all the same
+				if (length < 1e-6f) break;
+				for (uint32_t c = 0; c < N; c++) axis[c] = next[c] / length;
+			}
+
+			float axisLength = 0.0f;
+			for (uint32_t c = 0; c < N; c++) axisLength += axis[c] * axis[c];
+			axisLength = std::sqrt(axisLength);
+			for (uint32_t c = 0; c < N; c++) axis[c] /= axisLength;
+
+			float minT = std::numeric_limits<float>::max();
+			float maxT = -std::numeric_limits<float>::max();
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < N; c++) t += (pixels[i][c] - mean[c]) * axis[c];
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (uint32_t c = 0; c < N; c++)
+			{
+				endpoints[0][c] = mean[c] + maxT * axis[c];
+				endpoints[1][c] = mean[c] + minT * axis[c];
+			}
+		}
+
+		// Least squares endpoints for the pixels at their weights of the first endpoint, fails if the weights are all the same
+		template<uint32_t N>
+		bool FitEndpoints(const float (&pixels)[BLOCK_PIXELS][4], const float (&weights)[BLOCK_PIXELS], float (&endpoints)[2][4])
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[N] = {}, bx[N] = {};
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				const float a = weights[i];
+				const float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t c = 0; c < N; c++)
+				{
+					ax[c] += a * pixels[i][c];
+					bx[c] += b * pixels[i][c];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f) return false;
+
+			for (uint32_t c = 0; c < N; c++)
+			{
+				endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+				endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		void LoadBlock(const uint8_t* block, float (&pixels)[BLOCK_PIXELS][4])
+		{
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				for (uint32_t c = 0; c < 4; c++) pixels[i][c] = block[i * 4 + c];
+			}
+		}
+
+		// BC1
+
+		uint16_t To565(const float* color)
+		{
+			const uint32_t r = (uint32_t) std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f);
+			const uint32_t g = (uint32_t) std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f);
+			const uint32_t b = (uint32_t) std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f);
+			return (uint16_t) (r << 11 | g << 5 | b);
+		}
+
+		void GetPaletteBC1(uint16_t color0, uint16_t color1, int (&palette)[4][3])
+		{
+			const uint16_t colors[2] = { color0, color1 };
+			for (uint32_t i = 0; i < 2; i++)
+			{
+				const int r = colors[i] >> 11;
+				const int g = (colors[i] >> 5) & 0x3F;
+				const int b = colors[i] & 0x1F;
+				palette[i][0] = r << 3 | r >> 2;
+				palette[i][1] = g << 2 | g >> 4;
+				palette[i][2] = b << 3 | b >> 2;
+			}
+
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				if (color0 > color1)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+				else
+				{
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+			}
+		}
+
+		// Weight of the first endpoint of the four color indices
+		constexpr float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float SelectIndicesBC1(const float (&pixels)[BLOCK_PIXELS][4], uint16_t color0, uint16_t color1, uint32_t (&indices)[BLOCK_PIXELS])
+		{
+			int palette[4][3];
+			GetPaletteBC1(color0, color1, palette);
+
+			// Last color of the three color mode is transparent black
+			const uint32_t numColors = color0 > color1 ? 4 : 3;
+
+			float error = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				float bestDistance = std::numeric_limits<float>::max();
+				for (uint32_t index = 0; index < numColors; index++)
+				{
+					const float distance = GetDistance<3>(pixels[i], palette[index]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						indices[i] = index;
+					}
+				}
+				error += bestDistance;
+			}
+			return error;
+		}
+
+		// BC4
+
+		void GetPaletteBC4(uint8_t value0, uint8_t value1, int (&palette)[8])
+		{
+			palette[0] = value0;
+			palette[1] = value1;
+			if (value0 > value1)
+			{
+				for (int i = 2; i < 8; i++) palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+			}
+			else
+			{
+				for (int i = 2; i < 6; i++) palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		// BC7
+
+		constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		int InterpolateBC7(int endpoint0, int endpoint1, uint32_t index)
+		{
+			return ((64 - BC7_WEIGHTS[index]) * endpoint0 + BC7_WEIGHTS[index] * endpoint1 + 32) >> 6;
+		}
+
+		// Mode 6: one subset, RGBA endpoints with 7 bits and a P-bit each, 4 bit indices
+		struct BlockBC7
+		{
+			int Endpoints[2][4];
+			uint32_t Indices[BLOCK_PIXELS];
+			float Error = std::numeric_limits<float>::max();
+		};
+
+		// Index is guessed by the projection on the endpoint line, the neighbours are checked because the weights aren't uniform
+		float SelectIndicesBC7(const float (&pixels)[BLOCK_PIXELS][4], const int (&endpoints)[2][4], uint32_t (&indices)[BLOCK_PIXELS])
+		{
+			float direction[4];
+			float lengthSquared = 0.0f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				direction[c] = (float) (endpoints[1][c] - endpoints[0][c]);
+				lengthSquared += direction[c] * direction[c];
+			}
+
+			float error = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < 4; c++) t += (pixels[i][c] - endpoints[0][c]) * direction[c];
+				t = lengthSquared > 0.0f ? t / lengthSquared : 0.0f;
+
+				const int guess = std::clamp((int) std::lround(t * 15.0f), 0, 15);
+				float bestDistance = std::numeric_limits<float>::max();
+				for (int index = std::max(guess - 1, 0); index <= std::min(guess + 1, 15); index++)
+				{
+					int color[4];
+					for (uint32_t c = 0; c < 4; c++) color[c] = InterpolateBC7(endpoints[0][c], endpoints[1][c], index);
+
+					const float distance = GetDistance<4>(pixels[i], color);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						indices[i] = (uint32_t) index;
+					}
+				}
+				error += bestDistance;
+			}
+			return error;
+		}
+
+		// Tries the P-bits of both endpoints, a P-bit is the lowest bit of all channels of the endpoint
+		void QuantizeBC7(const float (&pixels)[BLOCK_PIXELS][4], const float (&endpoints)[2][4], BlockBC7& best)
+		{
+			for (uint32_t pBits = 0; pBits < 4; pBits++)
+			{
+				BlockBC7 block;
+				for (uint32_t e = 0; e < 2; e++)
+				{
+					const int pBit = (pBits >> e) & 1;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						const int quantized = std::clamp((int) std::lround((endpoints[e][c] - pBit) / 2.0f), 0, 127);
+						block.Endpoints[e][c] = quantized << 1 | pBit;
+					}
+				}
+
+				block.Error = SelectIndicesBC7(pixels, block.Endpoints, block.Indices);
+				if (block.Error < best.Error) best = block;
+			}
+		}
+
+		void LoadBlockEdge(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* block)
+		{
+			for (uint32_t y = 0; y < BLOCK_WIDTH; y++)
+			{
+				const uint32_t pixelY = std::min(blockY * BLOCK_WIDTH + y, height - 1);
+				for (uint32_t x = 0; x < BLOCK_WIDTH; x++)
+				{
+					const uint32_t pixelX = std::min(blockX * BLOCK_WIDTH + x, width - 1);
+					memcpy(block + (y * BLOCK_WIDTH + x) * 4, pixels + ((size_t) pixelY * width + pixelX) * 4, 4);
+				}
+			}
+		}
+
+		BlockEncoder GetBlockEncoder(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return EncodeBlockBC1;
+			case Format::BC5: return EncodeBlockBC5;
+			case Format::BC7: return EncodeBlockBC7;
+			default: return nullptr;
+			}
+		}
+
+		BlockDecoder GetBlockDecoder(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return DecodeBlockBC1;
+			case Format::BC5: return DecodeBlockBC5;
+			case Format::BC7: return DecodeBlockBC7;
+			default: return nullptr;
+			}
+		}
+	}
+
+	uint32_t GetBlockSize(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1: return 8;
+		case Format::BC5: return 16;
+		case Format::BC7: return 16;
+		default: return 0;
+		}
+	}
+
+	size_t GetRowPitch(Format format, uint32_t width)
+	{
+		const uint32_t blockSize = GetBlockSize(format);
+		if (blockSize == 0) return (size_t) width * 4;
+		return (size_t) (width + BLOCK_WIDTH - 1) / BLOCK_WIDTH * blockSize;
+	}
+
+	size_t GetImageSize(Format format, uint32_t width, uint32_t height)
+	{
+		const uint32_t numRows = GetBlockSize(format) == 0 ? height : (height + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+		return GetRowPitch(format, width) * numRows;
+	}
+
+	// Endpoints of the color line are refined by least squares on the chosen indices while the error drops
+	void EncodeBlockBC1(const uint8_t* block, uint8_t* dst)
+	{
+		float pixels[BLOCK_PIXELS][4];
+		LoadBlock(block, pixels);
+
+		float endpoints[2][4];
+		FitLine<3>(pixels, endpoints);
+
+		uint16_t color0 = To565(endpoints[0]);
+		uint16_t color1 = To565(endpoints[1]);
+		uint32_t indices[BLOCK_PIXELS];
+		float error = SelectIndicesBC1(pixels, std::max(color0, color1), std::min(color0, color1), indices);
+		if (color0 < color1) std::swap(color0, color1);
+
+		for (uint32_t iteration = 0; iteration < 2 && error > 0.0f && color0 != color1; iteration++)
+		{
+			float weights[BLOCK_PIXELS];
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++) weights[i] = BC1_WEIGHTS[indices[i]];
+			if (!FitEndpoints<3>(pixels, weights, endpoints)) break;
+
+			uint16_t refined0 = To565(endpoints[0]);
+			uint16_t refined1 = To565(endpoints[1]);
+			if (refined0 < refined1) std::swap(refined0, refined1);
+
+			uint32_t refinedIndices[BLOCK_PIXELS];
+			const float refinedError = SelectIndicesBC1(pixels, refined0, refined1, refinedIndices);
+			if (refinedError >= error) break;
+
+			error = refinedError;
+			color0 = refined0;
+			color1 = refined1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+
+		uint32_t packedIndices = 0;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++) packedIndices |= indices[i] << (i * 2);
+		memcpy(dst, &color0, 2);
+		memcpy(dst + 2, &color1, 2);
+		memcpy(dst + 4, &packedIndices, 4);
+	}
+
+	// Endpoints are the range of the block in the eight value mode
+	void EncodeBlockBC4(const uint8_t* values, uint8_t* dst)
+	{
+		const auto [minValue, maxValue] = std::minmax_element(values, values + BLOCK_PIXELS);
+
+		int palette[8];
+		GetPaletteBC4(*maxValue, *minValue, palette);
+
+		uint64_t packedIndices = 0;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			uint32_t bestIndex = 0;
+			for (uint32_t index = 1; index < 8; index++)
+			{
+				if (std::abs(palette[index] - values[i]) < std::abs(palette[bestIndex] - values[i])) bestIndex = index;
+			}
+			packedIndices |= (uint64_t) bestIndex << (i * 3);
+		}
+
+		dst[0] = *maxValue;
+		dst[1] = *minValue;
+		for (uint32_t i = 0; i < 6; i++) dst[2 + i] = (uint8_t) (packedIndices >> (i * 8));
+	}
+
+	void EncodeBlockBC5(const uint8_t* block, uint8_t* dst)
+	{
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			uint8_t values[BLOCK_PIXELS];
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++) values[i] = block[i * 4 + c];
+			EncodeBlockBC4(values, dst + c * 8);
+		}
+	}
+
+	// Mode 6 only, the RGBA line is refined by least squares and every fit tries all P-bits
+	void EncodeBlockBC7(const uint8_t* block, uint8_t* dst)
+	{
+		float pixels[BLOCK_PIXELS][4];
+		LoadBlock(block, pixels);
+
+		float endpoints[2][4];
+		FitLine<4>(pixels, endpoints);
+
+		BlockBC7 best;
+		QuantizeBC7(pixels, endpoints, best);
+
+		for (uint32_t iteration = 0; iteration < 2 && best.Error > 0.0f; iteration++)
+		{
+			float weights[BLOCK_PIXELS];
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++) weights[i] = 1.0f - BC7_WEIGHTS[best.Indices[i]] / 64.0f;
+			if (!FitEndpoints<4>(pixels, weights, endpoints)) break;
+
+			const float error = best.Error;
+			QuantizeBC7(pixels, endpoints, best);
+			if (best.Error >= error) break;
+		}
+
+		// Highest bit of the first index is implicitly 0
+		if (best.Indices[0] >= 8)
+		{
+			std::swap(best.Endpoints[0], best.Endpoints[1]);
+			for (uint32_t& index : best.Indices) index = 15 - index;
+		}
+
+		memset(dst, 0, 16);
+		BitWriter writer{ dst };
+		writer.Write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.Write(best.Endpoints[0][c] >> 1, 7);
+			writer.Write(best.Endpoints[1][c] >> 1, 7);
+		}
+		writer.Write(best.Endpoints[0][0] & 1, 1);
+		writer.Write(best.Endpoints[1][0] & 1, 1);
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++) writer.Write(best.Indices[i], i == 0 ? 3 : 4);
+	}
+
+	void DecodeBlockBC1(const uint8_t* src, uint8_t* block)
+	{
+		uint16_t color0, color1;
+		uint32_t packedIndices;
+		memcpy(&color0, src, 2);
+		memcpy(&color1, src + 2, 2);
+		memcpy(&packedIndices, src + 4, 4);
+
+		int palette[4][3];
+		GetPaletteBC1(color0, color1, palette);
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			const uint32_t index = (packedIndices >> (i * 2)) & 3;
+			for (uint32_t c = 0; c < 3; c++) block[i * 4 + c] = (uint8_t) palette[index][c];
+			block[i * 4 + 3] = 255;
+		}
+	}
+
+	void DecodeBlockBC4(const uint8_t* src, uint8_t* values)
+	{
+		int palette[8];
+		GetPaletteBC4(src[0], src[1], palette);
+
+		uint64_t packedIndices = 0;
+		for (uint32_t i = 0; i < 6; i++) packedIndices |= (uint64_t) src[2 + i] << (i * 8);
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++) values[i] = (uint8_t) palette[(packedIndices >> (i * 3)) & 7];
+	}
+
+	void DecodeBlockBC5(const uint8_t* src, uint8_t* block)
+	{
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			uint8_t values[BLOCK_PIXELS];
+			DecodeBlockBC4(src + c * 8, values);
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++) block[i * 4 + c] = values[i];
+		}
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			block[i * 4 + 2] = 0;
+			block[i * 4 + 3] = 255;
+		}
+	}
+
+	void DecodeBlockBC7(const uint8_t* src, uint8_t* block)
+	{
+		BitReader reader{ src };
+		if (reader.Read(7) != 1 << 6)
+		{
+			memset(block, 0, BLOCK_PIXELS * 4);
+			return;
+		}
+
+		int endpoints[2][4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			endpoints[0][c] = (int) reader.Read(7) << 1;
+			endpoints[1][c] = (int) reader.Read(7) << 1;
+		}
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			const int pBit = (int) reader.Read(1);
+			for (uint32_t c = 0; c < 4; c++) endpoints[e][c] |= pBit;
+		}
+
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			const uint32_t index = reader.Read(i == 0 ? 3 : 4);
+			for (uint32_t c = 0; c < 4; c++) block[i * 4 + c] = (uint8_t) InterpolateBC7(endpoints[0][c], endpoints[1][c], index);
+		}
+	}
+
+	void Encode(Format format, const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t* dst, uint32_t numThreads)
+	{
+		const BlockEncoder encodeBlock = GetBlockEncoder(format);
+		if (!encodeBlock)
+		{
+			memcpy(dst, pixels, GetImageSize(format, width, height));
+			return;
+		}
+
+		const uint32_t blockSize = GetBlockSize(format);
+		const uint32_t numBlocksX = (width + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+		const uint32_t numBlocksY = (height + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+		const auto encodeRows = [=](uint32_t rowStart, uint32_t rowEnd, uint32_t)
+		{
+			uint8_t block[BLOCK_PIXELS * 4];
+			for (uint32_t blockY = rowStart; blockY < rowEnd; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < numBlocksX; blockX++)
+				{
+					LoadBlockEdge(pixels, width, height, blockX, blockY, block);
+					encodeBlock(block, dst + ((size_t) blockY * numBlocksX + blockX) * blockSize);
+				}
+			}
+		};
+
+		if (numThreads == 0) MTR::ParallelFor(numBlocksY, encodeRows);
+		else MTR::ParallelFor(numBlocksY, numThreads, encodeRows);
+	}
+
+	void Decode(Format format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* pixels)
+	{
+		const BlockDecoder decodeBlock = GetBlockDecoder(format);
+		if (!decodeBlock)
+		{
+			memcpy(pixels, src, GetImageSize(format, width, height));
+			return;
+		}
+
+		const uint32_t blockSize = GetBlockSize(format);
+		const uint32_t numBlocksX = (width + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+		const uint32_t numBlocksY = (height + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+		uint8_t block[BLOCK_PIXELS * 4];
+		for (uint32_t blockY = 0; blockY < numBlocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < numBlocksX; blockX++)
+			{
+				decodeBlock(src + ((size_t) blockY * numBlocksX + blockX) * blockSize, block);
+
+				const uint32_t blockWidth = std::min(BLOCK_WIDTH, width - blockX * BLOCK_WIDTH);
+				const uint32_t blockHeight = std::min(BLOCK_WIDTH, height - blockY * BLOCK_WIDTH);
+				for (uint32_t y = 0; y < blockHeight; y++)
+				{
+					uint8_t* row = pixels + (((size_t) blockY * BLOCK_WIDTH + y) * width + blockX * BLOCK_WIDTH) * 4;
+					memcpy(row, block + y * BLOCK_WIDTH * 4, blockWidth * 4);
+				}
+			}
+		}
+	}
+
+	double CalculatePSNR(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height, uint32_t channelMask)
+	{
+		double squaredError = 0.0;
+		size_t numValues = 0;
+		for (size_t i = 0; i < (size_t) width * height; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				if (!((channelMask >> c) & 1)) continue;
+
+				const double difference = (double) a[i * 4 + c] - b[i * 4 + c];
+				squaredError += difference * difference;
+				numValues++;
+			}
+		}
+
+		if (squaredError == 0.0 || numValues == 0) return std::numeric_limits<double>::infinity();
+		return 10.0 * std::log10(255.0 * 255.0 * numValues / squaredError);
+	}
+}
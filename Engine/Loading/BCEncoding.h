@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Block compression of RGBA8 images into the BCn formats, 4x4 pixels are stored in 8 or 16 bytes
+// Doesn't depend on D3D12, the decoders are used for quality checks of the encoder
+namespace BCEncoding
+{
+	enum class Format : uint32_t
+	{
+		// Uncompressed, 4 bytes per pixel
+		RGBA8,
+
+		// RGB with 565 endpoints, alpha is ignored
+		BC1,
+
+		// Red and green, each stored as BC4
+		BC5,
+
+		// RGBA, the encoder only uses mode 6
+		BC7,
+	};
+
+	constexpr uint32_t BLOCK_WIDTH = 4;
+	constexpr uint32_t BLOCK_PIXELS = BLOCK_WIDTH * BLOCK_WIDTH;
+
+	// Bytes of a 4x4 block, 0 for RGBA8
+	uint32_t GetBlockSize(Format format);
+
+	// Rows of pixels or of blocks, blocks of images that aren't a multiple of 4 are partially filled
+	size_t GetRowPitch(Format format, uint32_t width);
+	size_t GetImageSize(Format format, uint32_t width, uint32_t height);
+
+	// Block is 16 RGBA8 pixels in rows
+	void EncodeBlockBC1(const uint8_t* block, uint8_t* dst);
+	void EncodeBlockBC5(const uint8_t* block, uint8_t* dst);
+	void EncodeBlockBC7(const uint8_t* block, uint8_t* dst);
+
+	// Single channel block of 16 values, the color channels of BC5
+	void EncodeBlockBC4(const uint8_t* values, uint8_t* dst);
+
+	// BC1 alpha is 255, BC5 blue is 0 and alpha is 255
+	void DecodeBlockBC1(const uint8_t* src, uint8_t* block);
+	void DecodeBlockBC4(const uint8_t* src, uint8_t* values);
+	void DecodeBlockBC5(const uint8_t* src, uint8_t* block);
+
+	// Blocks in the other modes are decoded as black, only the blocks of the encoder can be checked
+	void DecodeBlockBC7(const uint8_t* src, uint8_t* block);
+
+	// Tightly packed RGBA8 pixels to tightly packed rows of blocks, pixels past the edge repeat the last row and column
+	// Rows of blocks are split between the threads, 0 uses a thread per core
+	void Encode(Format format, const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t* dst, uint32_t numThreads = 0);
+	void Decode(Format format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* pixels);
+
+	// Peak signal to noise ratio of the channels in the mask (bit per channel, RGBA from the lowest), infinite for equal images
+	double CalculatePSNR(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height, uint32_t channelMask = 0xF);
+}
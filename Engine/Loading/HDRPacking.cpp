@@ -0,0 +1,353 @@
+#include "HDRPacking.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define HDR_PACKING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace HDRPacking
+{
+	namespace
+	{
+		// Exponent bias and mantissa bits of RGB9E5
+		constexpr int32_t RGB9E5_BIAS = 15;
+		constexpr int32_t RGB9E5_MANTISSA_BITS = 9;
+		constexpr int32_t RGB9E5_MAX_MANTISSA = (1 << RGB9E5_MANTISSA_BITS) - 1;
+
+		// Clamps to the range and counts the values that didn't fit
+		float ClampValue(float value, float minValue, float maxValue, ConversionReport& report)
+		{
+			report.NumValues++;
+			if (std::isnan(value))
+			{
+				report.NumInvalid++;
+				return 0.0f;
+			}
+
+			report.MaxMagnitude = std::max(report.MaxMagnitude, std::abs(value));
+			if (value < minValue || value > maxValue)
+			{
+				report.NumClamped++;
+				return std::clamp(value, minValue, maxValue);
+			}
+			return value;
+		}
+
+		uint16_t ToHalfValue(float value)
+		{
+			const uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+			const double magnitude = std::abs((double) value);
+
+			// Subnormal halves are multiples of 2^-24, rounding up to 1024 gives the smallest normal half
+			if (magnitude < std::ldexp(1.0, -14)) return sign | (uint16_t) std::nearbyint(std::ldexp(magnitude, 24));
+
+			int exponent;
+			const double significand = std::frexp(magnitude, &exponent) * 2.0;
+			exponent--;
+
+			uint32_t mantissa = (uint32_t) std::nearbyint((significand - 1.0) * 1024.0);
+			if (mantissa == 1024)
+			{
+				mantissa = 0;
+				exponent++;
+			}
+			return sign | (uint16_t) ((exponent + 15) << 10 | mantissa);
+		}
+
+		float FromHalfValue(uint16_t value)
+		{
+			const float sign = value & 0x8000 ? -1.0f : 1.0f;
+			const int32_t exponent = (value >> 10) & 0x1F;
+			const int32_t mantissa = value & 0x3FF;
+
+			if (exponent == 0) return sign * std::ldexp((float) mantissa, -24);
+			if (exponent == 31) return mantissa ? NAN : sign * INFINITY;
+			return sign * std::ldexp((float) (1024 + mantissa), exponent - 25);
+		}
+
+		// Shared exponent of the largest channel, bumped if its mantissa rounds up to 512
+		uint32_t ToRGB9E5Value(const float* rgb)
+		{
+			const float maxValue = std::max({ rgb[0], rgb[1], rgb[2] });
+
+			// Floor of log2, zero takes the smallest shared exponent
+			int32_t floatExponent = -RGB9E5_BIAS - 1;
+			if (maxValue > 0.0f)
+			{
+				std::frexp(maxValue, &floatExponent);
+				floatExponent--;
+			}
+
+			int32_t exponent = std::max(-RGB9E5_BIAS - 1, floatExponent) + 1 + RGB9E5_BIAS;
+			double scale = std::ldexp(1.0, RGB9E5_BIAS + RGB9E5_MANTISSA_BITS - exponent);
+			if (std::nearbyint(maxValue * scale) > RGB9E5_MAX_MANTISSA)
+			{
+				exponent++;
+				scale *= 0.5;
+			}
+
+			uint32_t packed = (uint32_t) exponent << 27;
+			for (uint32_t c = 0; c < 3; c++) packed |= (uint32_t) std::nearbyint(rgb[c] * scale) << (RGB9E5_MANTISSA_BITS * c);
+			return packed;
+		}
+
+#ifdef HDR_PACKING_SSE2
+		__m128i CountMask(__m128 mask)
+		{
+			return _mm_srli_epi32(_mm_castps_si128(mask), 31);
+		}
+
+		size_t SumLanes(__m128i counts)
+		{
+			uint32_t lanes[4];
+			_mm_storeu_si128((__m128i*) lanes, counts);
+			return (size_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+
+		float MaxLane(__m128 values)
+		{
+			float lanes[4];
+			_mm_storeu_ps(lanes, values);
+			return std::max({ lanes[0], lanes[1], lanes[2], lanes[3] });
+		}
+
+		// NaN is zeroed and counted, values outside of the range are clamped and counted
+		// Counters hold one count per lane so they can't overflow before the lanes are summed
+		struct ClampState
+		{
+			__m128i NumClamped = _mm_setzero_si128();
+			__m128i NumInvalid = _mm_setzero_si128();
+			__m128 MaxMagnitude = _mm_setzero_ps();
+		};
+
+		__m128 ClampValues(__m128 values, __m128 minValue, __m128 maxValue, ClampState& state)
+		{
+			state.NumInvalid = _mm_add_epi32(state.NumInvalid, CountMask(_mm_cmpunord_ps(values, values)));
+			values = _mm_and_ps(values, _mm_cmpord_ps(values, values));
+
+			const __m128 magnitude = _mm_and_ps(values, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+			state.MaxMagnitude = _mm_max_ps(state.MaxMagnitude, magnitude);
+
+			const __m128 outside = _mm_or_ps(_mm_cmplt_ps(values, minValue), _mm_cmpgt_ps(values, maxValue));
+			state.NumClamped = _mm_add_epi32(state.NumClamped, CountMask(outside));
+			return _mm_min_ps(_mm_max_ps(values, minValue), maxValue);
+		}
+
+		void AddState(const ClampState& state, size_t numValues, ConversionReport& report)
+		{
+			report.NumValues += numValues;
+			report.NumClamped += SumLanes(state.NumClamped);
+			report.NumInvalid += SumLanes(state.NumInvalid);
+			report.MaxMagnitude = std::max(report.MaxMagnitude, MaxLane(state.MaxMagnitude));
+		}
+
+		// Values are in the half range, the exponent is rebiased and the mantissa rounded to nearest even
+		// Subnormals are aligned by adding a float whose mantissa ends at the last half bit, the float addition does the rounding
+		__m128i ToHalfBits(__m128 values)
+		{
+			const __m128i signMask = _mm_set1_epi32((int32_t) 0x80000000);
+			const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+			const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+
+			const __m128i bits = _mm_castps_si128(values);
+			const __m128i sign = _mm_and_si128(bits, signMask);
+			const __m128i magnitude = _mm_xor_si128(bits, sign);
+
+			const __m128 denormSum = _mm_add_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(denormMagic));
+			const __m128i denorm = _mm_sub_epi32(_mm_castps_si128(denormSum), denormMagic);
+
+			const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+			__m128i normal = _mm_add_epi32(magnitude, _mm_set1_epi32(((15 - 127) << 23) + 0xFFF));
+			normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+			const __m128i isDenorm = _mm_cmplt_epi32(magnitude, minNormal);
+			const __m128i half = _mm_or_si128(_mm_and_si128(isDenorm, denorm), _mm_andnot_si128(isDenorm, normal));
+			return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+		}
+
+		// Sign extended so the saturating pack keeps the bits
+		__m128i PackHalves(__m128i a, __m128i b)
+		{
+			a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+			b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+			return _mm_packs_epi32(a, b);
+		}
+
+		// Subnormal halves become subnormal floats and are scaled by 2^112 with the exponent, infinity and NaN keep all exponent bits
+		__m128 FromHalfBits(__m128i halves)
+		{
+			const __m128i expMantissa = _mm_and_si128(halves, _mm_set1_epi32(0x7FFF));
+			const __m128i sign = _mm_slli_epi32(_mm_xor_si128(halves, expMantissa), 16);
+			const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+			const __m128i wasInfNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF));
+			const __m128 infNaNExponent = _mm_and_ps(_mm_castsi128_ps(wasInfNaN), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+			return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNaNExponent));
+		}
+
+		// Power of two float from the unbiased exponent, exponents stay in the normal float range
+		__m128 ToPowerOfTwo(__m128i exponent)
+		{
+			return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23));
+		}
+
+		__m128i Max(__m128i a, __m128i b)
+		{
+			const __m128i greater = _mm_cmpgt_epi32(a, b);
+			return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+		}
+#endif
+	}
+
+	void ConversionReport::Add(const ConversionReport& other)
+	{
+		NumValues += other.NumValues;
+		NumClamped += other.NumClamped;
+		NumInvalid += other.NumInvalid;
+		MaxMagnitude = std::max(MaxMagnitude, other.MaxMagnitude);
+	}
+
+	ConversionReport ToHalfReference(const float* src, size_t count, uint16_t* dst)
+	{
+		ConversionReport report{};
+		for (size_t i = 0; i < count; i++) dst[i] = ToHalfValue(ClampValue(src[i], -MAX_HALF, MAX_HALF, report));
+		return report;
+	}
+
+	void FromHalfReference(const uint16_t* src, size_t count, float* dst)
+	{
+		for (size_t i = 0; i < count; i++) dst[i] = FromHalfValue(src[i]);
+	}
+
+	ConversionReport ToRGB9E5Reference(const float* src, size_t numPixels, uint32_t* dst)
+	{
+		ConversionReport report{};
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			float rgb[3];
+			for (uint32_t c = 0; c < 3; c++) rgb[c] = ClampValue(src[i * 4 + c], 0.0f, MAX_RGB9E5, report);
+			dst[i] = ToRGB9E5Value(rgb);
+		}
+		return report;
+	}
+
+	void FromRGB9E5Reference(const uint32_t* src, size_t numPixels, float* dst)
+	{
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			const int32_t exponent = (int32_t) (src[i] >> 27);
+			for (uint32_t c = 0; c < 3; c++) dst[i * 4 + c] = std::ldexp((float) ((src[i] >> (RGB9E5_MANTISSA_BITS * c)) & RGB9E5_MAX_MANTISSA), exponent - RGB9E5_BIAS - RGB9E5_MANTISSA_BITS);
+			dst[i * 4 + 3] = 1.0f;
+		}
+	}
+
+#ifdef HDR_PACKING_SSE2
+	ConversionReport ToHalf(const float* src, size_t count, uint16_t* dst)
+	{
+		const __m128 minValue = _mm_set1_ps(-MAX_HALF);
+		const __m128 maxValue = _mm_set1_ps(MAX_HALF);
+
+		ClampState state{};
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128 a = ClampValues(_mm_loadu_ps(src + i), minValue, maxValue, state);
+			const __m128 b = ClampValues(_mm_loadu_ps(src + i + 4), minValue, maxValue, state);
+			_mm_storeu_si128((__m128i*) (dst + i), PackHalves(ToHalfBits(a), ToHalfBits(b)));
+		}
+
+		ConversionReport report{};
+		AddState(state, i, report);
+		report.Add(ToHalfReference(src + i, count - i, dst + i));
+		return report;
+	}
+
+	void FromHalf(const uint16_t* src, size_t count, float* dst)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i halves = _mm_loadu_si128((const __m128i*) (src + i));
+			_mm_storeu_ps(dst + i, FromHalfBits(_mm_unpacklo_epi16(halves, _mm_setzero_si128())));
+			_mm_storeu_ps(dst + i + 4, FromHalfBits(_mm_unpackhi_epi16(halves, _mm_setzero_si128())));
+		}
+		FromHalfReference(src + i, count - i, dst + i);
+	}
+
+	// Four pixels are transposed so each channel is a vector
+	ConversionReport ToRGB9E5(const float* src, size_t numPixels, uint32_t* dst)
+	{
+		const __m128 minValue = _mm_setzero_ps();
+		const __m128 maxValue = _mm_set1_ps(MAX_RGB9E5);
+		const __m128i maxMantissa = _mm_set1_epi32(RGB9E5_MAX_MANTISSA);
+
+		ClampState state{};
+		size_t i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			__m128 r = _mm_loadu_ps(src + i * 4);
+			__m128 g = _mm_loadu_ps(src + i * 4 + 4);
+			__m128 b = _mm_loadu_ps(src + i * 4 + 8);
+			__m128 a = _mm_loadu_ps(src + i * 4 + 12);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			r = ClampValues(r, minValue, maxValue, state);
+			g = ClampValues(g, minValue, maxValue, state);
+			b = ClampValues(b, minValue, maxValue, state);
+
+			// Floor of log2 is the float exponent, subnormals and zero fall under the smallest shared exponent
+			const __m128 maxValues = _mm_max_ps(_mm_max_ps(r, g), b);
+			const __m128i floatExponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxValues), 23), _mm_set1_epi32(127));
+			__m128i exponent = _mm_add_epi32(Max(floatExponent, _mm_set1_epi32(-RGB9E5_BIAS - 1)), _mm_set1_epi32(1 + RGB9E5_BIAS));
+
+			// Scale is a power of two so the products are exact and the conversion rounds to nearest even
+			__m128 scale = ToPowerOfTwo(_mm_sub_epi32(_mm_set1_epi32(RGB9E5_BIAS + RGB9E5_MANTISSA_BITS), exponent));
+			const __m128i overflow = _mm_cmpgt_epi32(_mm_cvtps_epi32(_mm_mul_ps(maxValues, scale)), maxMantissa);
+			exponent = _mm_sub_epi32(exponent, overflow);
+			scale = _mm_mul_ps(scale, _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(overflow), _mm_set1_ps(0.5f)), _mm_andnot_ps(_mm_castsi128_ps(overflow), _mm_set1_ps(1.0f))));
+
+			__m128i packed = _mm_slli_epi32(exponent, 27);
+			packed = _mm_or_si128(packed, _mm_cvtps_epi32(_mm_mul_ps(r, scale)));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(g, scale)), RGB9E5_MANTISSA_BITS));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(b, scale)), 2 * RGB9E5_MANTISSA_BITS));
+			_mm_storeu_si128((__m128i*) (dst + i), packed);
+		}
+
+		ConversionReport report{};
+		AddState(state, i * 3, report);
+		report.Add(ToRGB9E5Reference(src + i * 4, numPixels - i, dst + i));
+		return report;
+	}
+
+	void FromRGB9E5(const uint32_t* src, size_t numPixels, float* dst)
+	{
+		const __m128i mantissaMask = _mm_set1_epi32(RGB9E5_MAX_MANTISSA);
+
+		size_t i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i packed = _mm_loadu_si128((const __m128i*) (src + i));
+			const __m128 scale = ToPowerOfTwo(_mm_sub_epi32(_mm_srli_epi32(packed, 27), _mm_set1_epi32(RGB9E5_BIAS + RGB9E5_MANTISSA_BITS)));
+
+			__m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mantissaMask)), scale);
+			__m128 g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, RGB9E5_MANTISSA_BITS), mantissaMask)), scale);
+			__m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 2 * RGB9E5_MANTISSA_BITS), mantissaMask)), scale);
+			__m128 a = _mm_set1_ps(1.0f);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			_mm_storeu_ps(dst + i * 4, r);
+			_mm_storeu_ps(dst + i * 4 + 4, g);
+			_mm_storeu_ps(dst + i * 4 + 8, b);
+			_mm_storeu_ps(dst + i * 4 + 12, a);
+		}
+		FromRGB9E5Reference(src + i, numPixels - i, dst + i * 4);
+	}
+#else
+	ConversionReport ToHalf(const float* src, size_t count, uint16_t* dst) { return ToHalfReference(src, count, dst); }
+	void FromHalf(const uint16_t* src, size_t count, float* dst) { FromHalfReference(src, count, dst); }
+	ConversionReport ToRGB9E5(const float* src, size_t numPixels, uint32_t* dst) { return ToRGB9E5Reference(src, numPixels, dst); }
+	void FromRGB9E5(const uint32_t* src, size_t numPixels, float* dst) { FromRGB9E5Reference(src, numPixels, dst); }
+#endif
+}
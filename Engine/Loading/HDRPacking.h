@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Packs float HDR pixels into the 16 bit half float and the 32 bit shared exponent RGB9E5 formats, and unpacks them back
+// Values outside of the format are clamped to its range and counted, so the caller can report the loss
+// Doesn't depend on D3D12, the SSE2 paths are expected to match the scalar references exactly
+namespace HDRPacking
+{
+	// Largest finite half, values past it are clamped
+	constexpr float MAX_HALF = 65504.0f;
+
+	// 9 bit mantissa with exponent up to 2^16, no sign
+	constexpr float MAX_RGB9E5 = 65408.0f;
+
+	struct ConversionReport
+	{
+		size_t NumValues = 0;
+
+		// Out of the range of the format, infinity included
+		size_t NumClamped = 0;
+
+		// NaN is written as 0
+		size_t NumInvalid = 0;
+
+		// Largest absolute value of the source without NaN
+		float MaxMagnitude = 0.0f;
+
+		bool HasErrors() const { return NumClamped > 0 || NumInvalid > 0; }
+		void Add(const ConversionReport& other);
+	};
+
+	// Rounds to nearest even, count is the number of floats
+	ConversionReport ToHalf(const float* src, size_t count, uint16_t* dst);
+	ConversionReport ToHalfReference(const float* src, size_t count, uint16_t* dst);
+	void FromHalf(const uint16_t* src, size_t count, float* dst);
+	void FromHalfReference(const uint16_t* src, size_t count, float* dst);
+
+	// RGBA float pixels, alpha is dropped and unpacks as 1, so it's only for opaque images
+	// Channels share the exponent of the largest one, the smaller channels keep less precision
+	ConversionReport ToRGB9E5(const float* src, size_t numPixels, uint32_t* dst);
+	ConversionReport ToRGB9E5Reference(const float* src, size_t numPixels, uint32_t* dst);
+	void FromRGB9E5(const uint32_t* src, size_t numPixels, float* dst);
+	void FromRGB9E5Reference(const uint32_t* src, size_t numPixels, float* dst);
+}
@@ -0,0 +1,72 @@
+#include "ImageDecoding.h"
+
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include "Loading/AssetArchive.h"
+
+namespace TextureLoading
+{
+	static const uint8_t INVALID_TEXTURE_COLOR[] = { 0xff, 0x00, 0x33, 0xff };
+
+	// Takes the ownership of the decoded pixels, invalid color if the image failed to decode
+	static ImageData ToImageData(uint8_t* texData, int width, int height, const std::string& name)
+	{
+		ImageData image{};
+		if (!texData)
+		{
+			std::cout << "Warning: Failed to load texture: " << name << std::endl;
+			image.Width = 1;
+			image.Height = 1;
+			image.Pixels.assign(INVALID_TEXTURE_COLOR, INVALID_TEXTURE_COLOR + 4);
+			return image;
+		}
+
+		image.Width = (uint32_t) width;
+		image.Height = (uint32_t) height;
+		image.Pixels.assign(texData, texData + (size_t) width * height * 4);
+		stbi_image_free(texData);
+		return image;
+	}
+
+	ImageDataHDR LoadImageHDR(const std::string& path)
+	{
+		ImageDataHDR image{};
+
+		int width, height, bpp;
+		AssetArchive::AssetFile file;
+		float* texData = file.Open(path) ? stbi_loadf_from_memory(file.GetData(), (int) file.GetSize(), &width, &height, &bpp, 4) : nullptr;
+		if (!texData)
+		{
+			std::cout << "Warning: Failed to load texture: " << path << std::endl;
+			image.Width = 1;
+			image.Height = 1;
+			image.Pixels = { INVALID_TEXTURE_COLOR[0] / 255.0f, INVALID_TEXTURE_COLOR[1] / 255.0f, INVALID_TEXTURE_COLOR[2] / 255.0f, INVALID_TEXTURE_COLOR[3] / 255.0f };
+			return image;
+		}
+
+		image.Width = (uint32_t) width;
+		image.Height = (uint32_t) height;
+		image.Pixels.assign(texData, texData + (size_t) width * height * 4);
+		stbi_image_free(texData);
+		return image;
+	}
+
+	// Read through the mounted asset archives, falls back to the loose file
+	ImageData LoadImageLDR(const std::string& path)
+	{
+		int width, height, bpp;
+		AssetArchive::AssetFile file;
+		uint8_t* texData = file.Open(path) ? stbi_load_from_memory(file.GetData(), (int) file.GetSize(), &width, &height, &bpp, 4) : nullptr;
+		return ToImageData(texData, width, height, path);
+	}
+
+	ImageData LoadImageLDR(const uint8_t* data, size_t size)
+	{
+		int width, height, bpp;
+		uint8_t* texData = stbi_load_from_memory(data, (int) size, &width, &height, &bpp, 4);
+		return ToImageData(texData, width, height, "embedded image");
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// CPU half of the texture loading, decodes the images without creating the textures
+// Doesn't depend on D3D12 so the scene conversion can decode them on any platform
+namespace TextureLoading
+{
+	// CPU copy of HDR image, 4 floats per pixel (RGBA)
+	struct ImageDataHDR
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<float> Pixels;
+	};
+
+	// CPU copy of LDR image, 4 bytes per pixel (RGBA)
+	struct ImageData
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<uint8_t> Pixels;
+	};
+
+	// Images that fail to decode are 1x1 of the invalid texture color with a warning
+	ImageDataHDR LoadImageHDR(const std::string& path);
+	ImageData LoadImageLDR(const std::string& path);
+
+	// Encoded image in memory, PNG or JPG
+	ImageData LoadImageLDR(const uint8_t* data, size_t size);
+}
@@ -0,0 +1,90 @@
+#include "MappedGLTF.h"
+
+#pragma warning(disable : 4996)
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+namespace
+{
+	using MappedFiles = std::unordered_map<const void*, std::unique_ptr<AssetArchive::AssetFile>>;
+
+	// Files in the mounted asset archives are read from them
+	cgltf_result ReadMappedFile(const cgltf_memory_options*, const cgltf_file_options* fileOptions, const char* path, cgltf_size* size, void** data)
+	{
+		std::unique_ptr<AssetArchive::AssetFile> file = std::make_unique<AssetArchive::AssetFile>();
+		if (!file->Open(path)) return cgltf_result_file_not_found;
+
+		// Expected size is the byte length of the buffer, 0 when the glTF itself is read
+		if (size && *size > file->GetSize()) return cgltf_result_data_too_short;
+		if (size) *size = file->GetSize();
+
+		*data = const_cast<uint8_t*>(file->GetData());
+
+		MappedFiles& files = *static_cast<MappedFiles*>(fileOptions->user_data);
+		files[*data] = std::move(file);
+		return cgltf_result_success;
+	}
+
+	void ReleaseMappedFile(const cgltf_memory_options*, const cgltf_file_options* fileOptions, void* data)
+	{
+		MappedFiles& files = *static_cast<MappedFiles*>(fileOptions->user_data);
+		files.erase(data);
+	}
+
+	cgltf_options GetOptions(MappedFiles& files)
+	{
+		cgltf_options options = {};
+		options.file.read = &ReadMappedFile;
+		options.file.release = &ReleaseMappedFile;
+		options.file.user_data = &files;
+		return options;
+	}
+}
+
+bool MappedGLTF::Parse(const std::string& path)
+{
+	Free();
+
+	const cgltf_options options = GetOptions(m_Files);
+	if (cgltf_parse_file(&options, path.c_str(), &m_Data) != cgltf_result_success)
+	{
+		m_Data = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool MappedGLTF::Load(const std::string& path)
+{
+	if (!Parse(path)) return false;
+
+	// Binary chunk of the GLB is used in place, other buffers are mapped through ReadMappedFile
+	const cgltf_options options = GetOptions(m_Files);
+	if (cgltf_load_buffers(&options, m_Data, path.c_str()) != cgltf_result_success)
+	{
+		Free();
+		return false;
+	}
+	return true;
+}
+
+void MappedGLTF::Free()
+{
+	// Releases the mappings through ReleaseMappedFile
+	if (m_Data) cgltf_free(m_Data);
+	m_Data = nullptr;
+	m_Files.clear();
+}
+
+const uint8_t* MappedGLTF::GetImageData(const cgltf_image* image, size_t& size)
+{
+	const cgltf_buffer_view* bufferView = image->buffer_view;
+	if (!bufferView || !bufferView->buffer->data)
+	{
+		size = 0;
+		return nullptr;
+	}
+
+	size = bufferView->size;
+	return static_cast<const uint8_t*>(bufferView->buffer->data) + bufferView->offset;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "Loading/AssetArchive.h"
+
+struct cgltf_data;
+struct cgltf_image;
+
+// glTF or GLB whose file and external buffers are memory mapped instead of read into heap memory
+// Binary chunk of the GLB and the buffer files are used in place, accessors and embedded images point into the mappings
+// Files in the mounted asset archives are used in place of the archive or decompressed if they're compressed
+class MappedGLTF
+{
+public:
+	MappedGLTF() = default;
+	~MappedGLTF() { Free(); }
+
+	MappedGLTF(const MappedGLTF&) = delete;
+	MappedGLTF& operator=(const MappedGLTF&) = delete;
+
+	// Only parses the JSON, buffers aren't loaded
+	bool Parse(const std::string& path);
+
+	// Parses the file and maps the buffers
+	bool Load(const std::string& path);
+
+	void Free();
+
+	cgltf_data* GetData() const { return m_Data; }
+
+	// Encoded image stored in a buffer view, null if the image is referenced by URI
+	static const uint8_t* GetImageData(const cgltf_image* image, size_t& size);
+
+private:
+	cgltf_data* m_Data = nullptr;
+
+	// Mapped files by their data pointer, cgltf releases them by it
+	std::unordered_map<const void*, std::unique_ptr<AssetArchive::AssetFile>> m_Files;
+};
@@ -0,0 +1,415 @@
+#include "MipGeneration.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define MIP_GENERATION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MipGeneration
+{
+	namespace
+	{
+		constexpr double PI = 3.14159265358979323846;
+
+		// Same window as the Kaiser filter of the NVIDIA texture tools, radius is in pixels of the mip
+		constexpr double KAISER_RADIUS = 3.0;
+		constexpr double KAISER_ALPHA = 4.0;
+
+		// Color weighted by less alpha is too imprecise, the mip pixel takes the color that isn't weighted
+		constexpr float MIN_WEIGHTED_ALPHA = 1.0f / 1024.0f;
+
+		double ToLinear(double value)
+		{
+			return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+		}
+
+		double ToSRGB(double value)
+		{
+			return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+		}
+
+		constexpr uint32_t SRGB_BUCKETS = 4096;
+
+		// Linear values of the bytes and the linear values halfway between the neighboring bytes
+		// Rounded byte of a linear value is the number of thresholds under it, buckets of the linear range start the search close to it
+		struct SRGBTable
+		{
+			float Linear[256];
+			float Thresholds[256];
+			uint8_t Buckets[SRGB_BUCKETS + 1];
+		};
+
+		const SRGBTable& GetSRGBTable()
+		{
+			static const SRGBTable table = []()
+			{
+				SRGBTable t;
+				for (uint32_t i = 0; i < 256; i++) t.Linear[i] = (float) ToLinear(i / 255.0);
+				for (uint32_t i = 0; i < 255; i++) t.Thresholds[i] = (float) ToLinear((i + 0.5) / 255.0);
+				t.Thresholds[255] = 2.0f;
+
+				uint32_t byte = 0;
+				for (uint32_t i = 0; i <= SRGB_BUCKETS; i++)
+				{
+					while (t.Thresholds[byte] <= (float) i / SRGB_BUCKETS) byte++;
+					t.Buckets[i] = (uint8_t) byte;
+				}
+				return t;
+			}();
+			return table;
+		}
+
+		uint8_t ToByte(float value)
+		{
+			return (uint8_t) (std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+
+		uint8_t ToSRGBByte(const SRGBTable& table, float value)
+		{
+			value = std::clamp(value, 0.0f, 1.0f);
+			uint32_t byte = table.Buckets[(uint32_t) (value * SRGB_BUCKETS)];
+			while (table.Thresholds[byte] <= value) byte++;
+			return (uint8_t) byte;
+		}
+
+		double BesselI0(double x)
+		{
+			double sum = 1.0;
+			double term = 1.0;
+			for (uint32_t k = 1; k < 32; k++)
+			{
+				const double half = x / (2.0 * k);
+				term *= half * half;
+				sum += term;
+			}
+			return sum;
+		}
+
+		double Kaiser(double x)
+		{
+			if (std::abs(x) >= KAISER_RADIUS) return 0.0;
+
+			const double t = x / KAISER_RADIUS;
+			const double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+			return sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / BesselI0(KAISER_ALPHA);
+		}
+
+		// Source pixels under the mip pixel along one axis, the first and last can be outside of the image
+		// Scale is the source size over the mip size, it isn't 2 for sizes that aren't a power of two
+		void GetFootprint(FilterKernel kernel, uint32_t dst, double scale, int32_t& first, int32_t& last)
+		{
+			const double radius = kernel == FilterKernel::Box ? 0.5 * scale : KAISER_RADIUS * scale;
+			const double center = (dst + 0.5) * scale;
+			first = (int32_t) std::floor(center - radius);
+			last = (int32_t) std::ceil(center + radius) - 1;
+		}
+
+		// Box weight is the part of the source pixel that the mip pixel covers, weights aren't normalized
+		double GetWeight(FilterKernel kernel, uint32_t dst, int32_t src, double scale)
+		{
+			if (kernel == FilterKernel::Box)
+			{
+				const double overlap = std::min((dst + 1) * scale, src + 1.0) - std::max(dst * scale, (double) src);
+				return std::max(overlap, 0.0);
+			}
+			return Kaiser((src + 0.5) / scale - (dst + 0.5));
+		}
+
+		uint32_t ClampIndex(int32_t index, uint32_t size)
+		{
+			return (uint32_t) std::clamp(index, 0, (int32_t) size - 1);
+		}
+
+		// Normalized weights of one axis with the same number of taps for every mip pixel, unused taps have zero weight
+		// Pixels past the edge repeat the edge pixel
+		struct AxisFilter
+		{
+			uint32_t NumTaps = 0;
+			std::vector<uint32_t> Indices;
+			std::vector<float> Weights;
+		};
+
+		AxisFilter GetAxisFilter(FilterKernel kernel, uint32_t srcSize, uint32_t dstSize)
+		{
+			const double scale = (double) srcSize / dstSize;
+
+			AxisFilter filter;
+			for (uint32_t dst = 0; dst < dstSize; dst++)
+			{
+				int32_t first, last;
+				GetFootprint(kernel, dst, scale, first, last);
+				filter.NumTaps = std::max(filter.NumTaps, (uint32_t) (last - first + 1));
+			}
+
+			filter.Indices.assign((size_t) dstSize * filter.NumTaps, 0);
+			filter.Weights.assign((size_t) dstSize * filter.NumTaps, 0.0f);
+			for (uint32_t dst = 0; dst < dstSize; dst++)
+			{
+				int32_t first, last;
+				GetFootprint(kernel, dst, scale, first, last);
+
+				double sum = 0.0;
+				for (int32_t src = first; src <= last; src++) sum += GetWeight(kernel, dst, src, scale);
+
+				for (int32_t src = first; src <= last; src++)
+				{
+					const size_t tap = (size_t) dst * filter.NumTaps + (src - first);
+					filter.Indices[tap] = ClampIndex(src, srcSize);
+					filter.Weights[tap] = (float) (GetWeight(kernel, dst, src, scale) / sum);
+				}
+			}
+			return filter;
+		}
+
+#ifdef MIP_GENERATION_SSE2
+		// RGBA of a pixel
+		struct Vec4 { __m128 V; };
+
+		inline Vec4 Set(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+		inline Vec4 Splat(float value) { return { _mm_set1_ps(value) }; }
+		inline Vec4 SplatW(Vec4 v) { return { _mm_shuffle_ps(v.V, v.V, _MM_SHUFFLE(3, 3, 3, 3)) }; }
+		inline Vec4 MulAdd(Vec4 sum, Vec4 v, float weight) { return { _mm_add_ps(sum.V, _mm_mul_ps(v.V, _mm_set1_ps(weight))) }; }
+		inline Vec4 Min(Vec4 a, Vec4 b) { return { _mm_min_ps(a.V, b.V) }; }
+		inline Vec4 Max(Vec4 a, Vec4 b) { return { _mm_max_ps(a.V, b.V) }; }
+		inline void Store(Vec4 v, float* dst) { _mm_storeu_ps(dst, v.V); }
+#else
+		struct Vec4 { float X, Y, Z, W; };
+
+		inline Vec4 Set(float x, float y, float z, float w) { return { x, y, z, w }; }
+		inline Vec4 Splat(float value) { return { value, value, value, value }; }
+		inline Vec4 SplatW(Vec4 v) { return Splat(v.W); }
+		inline Vec4 MulAdd(Vec4 sum, Vec4 v, float weight) { return { sum.X + v.X * weight, sum.Y + v.Y * weight, sum.Z + v.Z * weight, sum.W + v.W * weight }; }
+		inline Vec4 Min(Vec4 a, Vec4 b) { return { std::min(a.X, b.X), std::min(a.Y, b.Y), std::min(a.Z, b.Z), std::min(a.W, b.W) }; }
+		inline Vec4 Max(Vec4 a, Vec4 b) { return { std::max(a.X, b.X), std::max(a.Y, b.Y), std::max(a.Z, b.Z), std::max(a.W, b.W) }; }
+		inline void Store(Vec4 v, float* dst) { dst[0] = v.X; dst[1] = v.Y; dst[2] = v.Z; dst[3] = v.W; }
+#endif
+
+		// Mip in linear floats, each pixel has the filtered color and, for alpha weighted images with transparency, the color that isn't weighted
+		struct Level
+		{
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			uint32_t NumVectors = 1;
+			std::vector<Vec4> Pixels;
+		};
+
+		Level ToLevel(const Settings& settings, const uint8_t* pixels, uint32_t width, uint32_t height)
+		{
+			const SRGBTable& table = GetSRGBTable();
+			const size_t numPixels = (size_t) width * height;
+
+			Level level;
+			level.Width = width;
+			level.Height = height;
+			if (settings.AlphaWeighted)
+			{
+				for (size_t i = 0; i < numPixels && level.NumVectors == 1; i++)
+					if (pixels[i * 4 + 3] != 255) level.NumVectors = 2;
+			}
+
+			level.Pixels.resize(numPixels * level.NumVectors);
+			for (size_t i = 0; i < numPixels; i++)
+			{
+				const uint8_t* pixel = pixels + i * 4;
+				const float r = settings.SRGB ? table.Linear[pixel[0]] : pixel[0] / 255.0f;
+				const float g = settings.SRGB ? table.Linear[pixel[1]] : pixel[1] / 255.0f;
+				const float b = settings.SRGB ? table.Linear[pixel[2]] : pixel[2] / 255.0f;
+				const float a = pixel[3] / 255.0f;
+
+				Vec4* dst = level.Pixels.data() + i * level.NumVectors;
+				dst[0] = settings.AlphaWeighted ? Set(r * a, g * a, b * a, a) : Set(r, g, b, a);
+				if (level.NumVectors == 2) dst[1] = Set(r, g, b, a);
+			}
+			return level;
+		}
+
+		void ToPixels(const Settings& settings, const Level& level, uint8_t* pixels)
+		{
+			const SRGBTable& table = GetSRGBTable();
+			const size_t numPixels = (size_t) level.Width * level.Height;
+			for (size_t i = 0; i < numPixels; i++)
+			{
+				const Vec4* src = level.Pixels.data() + i * level.NumVectors;
+				float color[4];
+				Store(src[0], color);
+
+				if (settings.AlphaWeighted && color[3] >= MIN_WEIGHTED_ALPHA)
+				{
+					for (uint32_t c = 0; c < 3; c++) color[c] /= color[3];
+				}
+				else if (level.NumVectors == 2)
+				{
+					const float alpha = color[3];
+					Store(src[1], color);
+					color[3] = alpha;
+				}
+
+				uint8_t* pixel = pixels + i * 4;
+				for (uint32_t c = 0; c < 3; c++) pixel[c] = settings.SRGB ? ToSRGBByte(table, color[c]) : ToByte(color[c]);
+				pixel[3] = ToByte(color[3]);
+			}
+		}
+
+		// Rows are filtered first into the mip width, then the columns of those rows into the mip height
+		// Negative lobes of the Kaiser filter can leave the range, weighted color is clamped to its alpha
+		Level Downsample(const Settings& settings, const Level& src, uint32_t width, uint32_t height)
+		{
+			const AxisFilter filterX = GetAxisFilter(settings.Kernel, src.Width, width);
+			const AxisFilter filterY = GetAxisFilter(settings.Kernel, src.Height, height);
+			const uint32_t numVectors = src.NumVectors;
+			const size_t rowSize = (size_t) width * numVectors;
+
+			std::vector<Vec4> rows((size_t) src.Height * rowSize);
+			for (uint32_t y = 0; y < src.Height; y++)
+			{
+				const Vec4* srcRow = src.Pixels.data() + (size_t) y * src.Width * numVectors;
+				Vec4* dstRow = rows.data() + y * rowSize;
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const uint32_t* indices = filterX.Indices.data() + (size_t) x * filterX.NumTaps;
+					const float* weights = filterX.Weights.data() + (size_t) x * filterX.NumTaps;
+					for (uint32_t v = 0; v < numVectors; v++)
+					{
+						Vec4 sum = Splat(0.0f);
+						for (uint32_t tap = 0; tap < filterX.NumTaps; tap++) sum = MulAdd(sum, srcRow[indices[tap] * numVectors + v], weights[tap]);
+						dstRow[x * numVectors + v] = sum;
+					}
+				}
+			}
+
+			Level dst;
+			dst.Width = width;
+			dst.Height = height;
+			dst.NumVectors = numVectors;
+			dst.Pixels.assign((size_t) height * rowSize, Splat(0.0f));
+			for (uint32_t y = 0; y < height; y++)
+			{
+				Vec4* dstRow = dst.Pixels.data() + y * rowSize;
+				for (uint32_t tap = 0; tap < filterY.NumTaps; tap++)
+				{
+					const size_t index = (size_t) y * filterY.NumTaps + tap;
+					const Vec4* srcRow = rows.data() + filterY.Indices[index] * rowSize;
+					const float weight = filterY.Weights[index];
+					for (size_t i = 0; i < rowSize; i++) dstRow[i] = MulAdd(dstRow[i], srcRow[i], weight);
+				}
+			}
+
+			const Vec4 zero = Splat(0.0f);
+			const Vec4 one = Splat(1.0f);
+			for (size_t i = 0; i < dst.Pixels.size(); i++)
+			{
+				Vec4 value = Min(Max(dst.Pixels[i], zero), one);
+				if (settings.AlphaWeighted && i % numVectors == 0) value = Min(value, SplatW(value));
+				dst.Pixels[i] = value;
+			}
+			return dst;
+		}
+	}
+
+	uint32_t GetMipSize(uint32_t size, uint32_t mip)
+	{
+		return std::max(size >> mip, 1u);
+	}
+
+	size_t GetMipOffset(uint32_t width, uint32_t height, uint32_t mip)
+	{
+		size_t offset = 0;
+		for (uint32_t i = 0; i < mip; i++) offset += (size_t) GetMipSize(width, i) * GetMipSize(height, i) * 4;
+		return offset;
+	}
+
+	void Generate(const Settings& settings, uint32_t width, uint32_t height, uint32_t numMips, std::vector<uint8_t>& pixels)
+	{
+		pixels.resize(GetMipOffset(width, height, numMips));
+		if (numMips <= 1) return;
+
+		Level level = ToLevel(settings, pixels.data(), width, height);
+		for (uint32_t mip = 1; mip < numMips; mip++)
+		{
+			level = Downsample(settings, level, GetMipSize(width, mip), GetMipSize(height, mip));
+			ToPixels(settings, level, pixels.data() + GetMipOffset(width, height, mip));
+		}
+	}
+
+	void GenerateReference(const Settings& settings, uint32_t width, uint32_t height, uint32_t numMips, std::vector<uint8_t>& pixels)
+	{
+		pixels.resize(GetMipOffset(width, height, numMips));
+
+		// Weighted and unweighted RGBA of every pixel
+		std::vector<double> src((size_t) width * height * 8);
+		for (size_t i = 0; i < (size_t) width * height; i++)
+		{
+			double* dst = src.data() + i * 8;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				const double value = pixels[i * 4 + c] / 255.0;
+				dst[4 + c] = settings.SRGB && c < 3 ? ToLinear(value) : value;
+			}
+			for (uint32_t c = 0; c < 4; c++) dst[c] = settings.AlphaWeighted && c < 3 ? dst[4 + c] * dst[7] : dst[4 + c];
+		}
+
+		uint32_t srcWidth = width;
+		uint32_t srcHeight = height;
+		for (uint32_t mip = 1; mip < numMips; mip++)
+		{
+			const uint32_t dstWidth = GetMipSize(width, mip);
+			const uint32_t dstHeight = GetMipSize(height, mip);
+			const double scaleX = (double) srcWidth / dstWidth;
+			const double scaleY = (double) srcHeight / dstHeight;
+
+			std::vector<double> dst((size_t) dstWidth * dstHeight * 8, 0.0);
+			uint8_t* dstPixels = pixels.data() + GetMipOffset(width, height, mip);
+			for (uint32_t y = 0; y < dstHeight; y++)
+			{
+				int32_t firstY, lastY;
+				GetFootprint(settings.Kernel, y, scaleY, firstY, lastY);
+				double sumY = 0.0;
+				for (int32_t sy = firstY; sy <= lastY; sy++) sumY += GetWeight(settings.Kernel, y, sy, scaleY);
+
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					int32_t firstX, lastX;
+					GetFootprint(settings.Kernel, x, scaleX, firstX, lastX);
+					double sumX = 0.0;
+					for (int32_t sx = firstX; sx <= lastX; sx++) sumX += GetWeight(settings.Kernel, x, sx, scaleX);
+
+					double* value = dst.data() + ((size_t) y * dstWidth + x) * 8;
+					for (int32_t sy = firstY; sy <= lastY; sy++)
+					{
+						const double weightY = GetWeight(settings.Kernel, y, sy, scaleY) / sumY;
+						for (int32_t sx = firstX; sx <= lastX; sx++)
+						{
+							const double weight = weightY * GetWeight(settings.Kernel, x, sx, scaleX) / sumX;
+							const double* srcValue = src.data() + ((size_t) ClampIndex(sy, srcHeight) * srcWidth + ClampIndex(sx, srcWidth)) * 8;
+							for (uint32_t c = 0; c < 8; c++) value[c] += weight * srcValue[c];
+						}
+					}
+
+					for (uint32_t c = 0; c < 8; c++) value[c] = std::clamp(value[c], 0.0, 1.0);
+					if (settings.AlphaWeighted) for (uint32_t c = 0; c < 3; c++) value[c] = std::min(value[c], value[3]);
+
+					double color[4] = { value[0], value[1], value[2], value[3] };
+					if (settings.AlphaWeighted)
+					{
+						const bool weighted = value[3] >= MIN_WEIGHTED_ALPHA;
+						for (uint32_t c = 0; c < 3; c++) color[c] = weighted ? value[c] / value[3] : value[4 + c];
+					}
+
+					uint8_t* pixel = dstPixels + ((size_t) y * dstWidth + x) * 4;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						const double encoded = settings.SRGB && c < 3 ? ToSRGB(color[c]) : color[c];
+						pixel[c] = (uint8_t) std::lround(std::clamp(encoded, 0.0, 1.0) * 255.0);
+					}
+				}
+			}
+
+			src = std::move(dst);
+			srcWidth = dstWidth;
+			srcHeight = dstHeight;
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Generates the mips of RGBA8 images on the CPU, so the textures don't need a GPU pass or UAV formats
+// Each mip is filtered from the previous one kept in linear floats, sizes that aren't a power of two are resampled by their exact ratio
+// Doesn't depend on D3D12, the SSE2 path is compared against the scalar reference
+namespace MipGeneration
+{
+	enum class FilterKernel : uint32_t
+	{
+		// Average of the pixels under the area of the mip pixel
+		Box,
+
+		// Sinc windowed by Kaiser, sharper mips at the cost of a wider footprint
+		Kaiser,
+	};
+
+	struct Settings
+	{
+		FilterKernel Kernel = FilterKernel::Kaiser;
+
+		// Color is averaged in linear space and stored back as sRGB, alpha is always linear
+		bool SRGB = true;
+
+		// Color is weighted by alpha so the transparent pixels don't bleed into the visible ones
+		bool AlphaWeighted = true;
+	};
+
+	// Width or height of the mip, at least 1
+	uint32_t GetMipSize(uint32_t size, uint32_t mip);
+
+	// Mips are tightly packed from the largest
+	size_t GetMipOffset(uint32_t width, uint32_t height, uint32_t mip);
+
+	// Pixels hold the largest mip and are resized to the whole chain
+	void Generate(const Settings& settings, uint32_t width, uint32_t height, uint32_t numMips, std::vector<uint8_t>& pixels);
+
+	// Filters every pixel of a mip directly in doubles, the SIMD path is expected to be within one step of it
+	void GenerateReference(const Settings& settings, uint32_t width, uint32_t height, uint32_t numMips, std::vector<uint8_t>& pixels);
+}
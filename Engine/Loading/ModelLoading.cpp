@@ -1,10 +1,7 @@
 #include "ModelLoading.h"
 
 #pragma warning(disable : 4996)
-#ifndef CGLTF_IMPLEMENTATION
-#define CGLTF_IMPLEMENTATION
 #include <cgltf.h>
-#endif
 
 #include "Common.h"
 #include "Render/Device.h"
@@ -13,12 +10,12 @@
 #include "Render/Context.h"
 #include "Render/Commands.h"
 #include "Render/RenderThread.h"
+#include "Loading/AccessorDecoding.h"
+#include "Loading/MappedGLTF.h"
 #include "Loading/TextureLoading.h"
 #include "Utility/PathUtility.h"
 #include "System/ApplicationConfiguration.h"
 
-#define CGTF_CALL(X) { cgltf_result result = X; ASSERT(result == cgltf_result_success, "CGTF_CALL_FAIL") }
-
 #undef min
 #undef max
 #undef OPAQUE
@@ -35,22 +32,23 @@ namespace ModelLoading
 		return Float4{ color[0], color[1], color[2], color[3] };
 	}
 
+	// Decodes the accessor into tightly packed elements of T, T is made only of floats
+	// Components of any type, normalization and stride are converted, missing ones are zero
 	template<typename T>
-	static T* GetBufferData(cgltf_accessor* accessor)
+	static std::vector<T> ReadAccessor(cgltf_accessor* accessor)
 	{
-		unsigned char* buffer = (unsigned char*)accessor->buffer_view->buffer->data + accessor->buffer_view->offset;
-		void* data = buffer + accessor->offset;
-		return static_cast<T*>(data);
+		std::vector<T> data(accessor->count);
+		if (!data.empty() && !AccessorDecoding::ReadFloats(accessor, (float*) data.data(), sizeof(T), sizeof(T) / sizeof(float)))
+		{
+			ASSERT(0, "[SceneLoading] Failed to read accessor " << (accessor->name ? accessor->name : ""));
+		}
+		return data;
 	}
 
 	template<typename T>
-	static void FetchIndexData(cgltf_accessor* indexAccessor, std::vector<uint32_t>& buffer)
+	static const T* GetDataOrNull(const std::vector<T>& data)
 	{
-		T* indexData = GetBufferData<T>(indexAccessor);
-		for (size_t i = 0; i < indexAccessor->count; i++)
-		{
-			buffer[i] = indexData[i];
-		}
+		return data.empty() ? nullptr : data.data();
 	}
 
 	static void LoadIB(cgltf_accessor* indexAccessor, std::vector<uint32_t>& buffer)
@@ -59,12 +57,9 @@ namespace ModelLoading
 		ASSERT(indexAccessor->type == cgltf_type_scalar, "[SceneLoading] Indices of a mesh arent scalar.");
 
 		buffer.resize(indexAccessor->count);
-
-		switch (indexAccessor->component_type)
+		if (!buffer.empty() && !AccessorDecoding::ReadIndices(indexAccessor, buffer.data()))
 		{
-		case cgltf_component_type_r_16u: FetchIndexData<uint16_t>(indexAccessor, buffer); break;
-		case cgltf_component_type_r_32u: FetchIndexData<uint32_t>(indexAccessor, buffer); break;
-		default: NOT_IMPLEMENTED;
+			ASSERT(0, "[SceneLoading] Failed to read indices");
 		}
 	}
 
@@ -76,8 +71,7 @@ namespace ModelLoading
 		ASSERT(sampler->input->type == cgltf_type_scalar, "sampler->input->type != cgltf_type_scalar");
 		ASSERT(sampler->input->component_type == cgltf_component_type_r_32f, "sampler->input->component_type == cgltf_component_type_r_32f");
 
-		// Value data
-		ASSERT(sampler->output->component_type == cgltf_component_type_r_32f, "sampler->output->component_type == cgltf_component_type_r_32f");
+		// Value data, normalized integer rotations and weights are decoded to floats
 		switch (targetType)
 		{
 		case AnimTarget::Translation:
@@ -96,41 +90,35 @@ namespace ModelLoading
 		}
 	}
 
-	template<cgltf_type TYPE, cgltf_component_type COMPONENT_TYPE>
+	// Any component type is decoded, only the number of components has to match
+	template<cgltf_type TYPE>
 	static void ValidateVertexAttribute(cgltf_attribute* attribute)
 	{
 		ASSERT(attribute->data->type == TYPE, "[SceneLoading] ASSERT FAILED: attributeAccessor->type == TYPE");
-		ASSERT(attribute->data->component_type == COMPONENT_TYPE, "[SceneLoading] ASSERT FAILED: attributeAccessor->component_type == COMPONENT_TYPE");
 	}
 
 	struct VertexAttributesData
 	{
 		uint32_t NumVertices = 0;
-		Float3* Positions = nullptr;
-		Float2* Texcoords = nullptr;
-		Float3* Normals = nullptr;
-		Float4* Tangents = nullptr;
-		Float4* Colors = nullptr;
-		Float4* Weights = nullptr;
-
-		// This is actually uint4
-		uint16_t* Joints16 = nullptr; 
-		uint8_t* Joints8 = nullptr;
+		std::vector<Float3> Positions;
+		std::vector<Float2> Texcoords;
+		std::vector<Float3> Normals;
+		std::vector<Float4> Tangents;
+		std::vector<Float4> Colors;
+		std::vector<Float4> Weights;
+
+		// uint4 per vertex
+		std::vector<uint32_t> Joints;
 	};
 
 	void GetJointsData(VertexAttributesData& vertexData, cgltf_attribute* jointsData)
 	{
-		switch (jointsData->data->component_type)
+		ValidateVertexAttribute<cgltf_type_vec4>(jointsData);
+
+		vertexData.Joints.resize(jointsData->data->count * 4);
+		if (!vertexData.Joints.empty() && !AccessorDecoding::ReadUInts(jointsData->data, vertexData.Joints.data(), sizeof(uint32_t) * 4, 4))
 		{
-		case cgltf_component_type_r_8u:
-			ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_8u>(jointsData);
-			vertexData.Joints8 = GetBufferData<uint8_t>(jointsData->data);
-			break;
-		case cgltf_component_type_r_16u:
-			ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_16u>(jointsData);
-			vertexData.Joints16 = GetBufferData<uint16_t>(jointsData->data);
-			break;
-		default: NOT_IMPLEMENTED;
+			ASSERT(0, "[SceneLoading] Failed to read joints");
 		}
 	}
 
@@ -146,32 +134,31 @@ namespace ModelLoading
 			switch (vertexAttribute->type)
 			{
 			case cgltf_attribute_type_position:
-				ValidateVertexAttribute<cgltf_type_vec3, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Positions = GetBufferData<Float3>(vertexAttribute->data);
+				ValidateVertexAttribute<cgltf_type_vec3>(vertexAttribute);
+				attributesData.Positions = ReadAccessor<Float3>(vertexAttribute->data);
 				break;
 			case cgltf_attribute_type_texcoord:
-				ValidateVertexAttribute<cgltf_type_vec2, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Texcoords = GetBufferData<Float2>(vertexAttribute->data);
+				ValidateVertexAttribute<cgltf_type_vec2>(vertexAttribute);
+				attributesData.Texcoords = ReadAccessor<Float2>(vertexAttribute->data);
 				break;
 			case cgltf_attribute_type_normal:
-				ValidateVertexAttribute<cgltf_type_vec3, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Normals = GetBufferData<Float3>(vertexAttribute->data);
+				ValidateVertexAttribute<cgltf_type_vec3>(vertexAttribute);
+				attributesData.Normals = ReadAccessor<Float3>(vertexAttribute->data);
 				break;
 			case cgltf_attribute_type_tangent:
-				if (vertexAttribute->type != cgltf_type_vec4) continue; // Tmp hack: Find a way to fix this
-				ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Tangents = GetBufferData<Float4>(vertexAttribute->data);
+				// Morph targets have vec3 tangent displacements, w stays zero
+				attributesData.Tangents = ReadAccessor<Float4>(vertexAttribute->data);
 				break;
 			case cgltf_attribute_type_color:
-				ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Colors = GetBufferData<Float4>(vertexAttribute->data);
+				// RGB colors are decoded with zero alpha
+				attributesData.Colors = ReadAccessor<Float4>(vertexAttribute->data);
 				break;
 			case cgltf_attribute_type_joints:
 				GetJointsData(attributesData, vertexAttribute);
 				break;
 			case cgltf_attribute_type_weights:
-				ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_32f>(vertexAttribute);
-				attributesData.Weights = GetBufferData<Float4>(vertexAttribute->data);
+				ValidateVertexAttribute<cgltf_type_vec4>(vertexAttribute);
+				attributesData.Weights = ReadAccessor<Float4>(vertexAttribute->data);
 				break;
 			default:
 				NOT_IMPLEMENTED;
@@ -207,10 +194,9 @@ namespace ModelLoading
 		return AnimInterpolation::Invalid;
 	}
 
-	static BoundingSphere CalculateBoundingSphere(cgltf_primitive* meshData)
+	static BoundingSphere CalculateBoundingSphere(const VertexAttributesData& vertexData)
 	{
-		VertexAttributesData vertexData = LoadAttributes(meshData->attributes, meshData->attributes_count);
-		if (vertexData.Positions == nullptr || vertexData.NumVertices == 0) return BoundingSphere{};
+		if (vertexData.Positions.empty() || vertexData.NumVertices == 0) return BoundingSphere{};
 
 		static constexpr float MAX_FLOAT = std::numeric_limits<float>::max();
 		static constexpr float MIN_FLOAT = -MAX_FLOAT;
@@ -267,25 +253,27 @@ namespace ModelLoading
 	std::vector<SceneObject> Loader::Load(const std::string& path)
 	{
 		const std::string& ext = PathUtility::GetFileExtension(path);
-		if (ext != "gltf")
+		if (ext != "gltf" && ext != "glb")
 		{
 			ASSERT(0, "[SceneLoading] For now we only support glTF 3D format.");
 			return {};
 		}
 		m_DirectoryPath = PathUtility::GetPathWitoutFile(path);
 
-		cgltf_options options = {};
-		cgltf_data* data = NULL;
-		CGTF_CALL(cgltf_parse_file(&options, path.c_str(), &data));
-		CGTF_CALL(cgltf_load_buffers(&options, data, path.c_str()));
+		// Accessors and embedded images are read from the mapped file
+		MappedGLTF gltf;
+		if (!gltf.Load(path))
+		{
+			ASSERT(0, "[ModelLoading] Failed to load " << path);
+			return {};
+		}
+		cgltf_data* data = gltf.GetData();
 
 		m_Scene = std::vector<SceneObject>();
 
 		FillNodeAnimationMap(data);
 		for (size_t i = 0; i < data->nodes_count; i++) LoadNode(data->nodes + i);
 
-		cgltf_free(data);
-
 		return m_Scene;
 	}
 
@@ -347,12 +335,9 @@ namespace ModelLoading
 			const AnimInterpolation animationInterpolation = ToInterpolationType(animationSampler->interpolation, animationTarget);
 			ValidateAnimationSampler(animationSampler, animationTarget);
 
-			// Load data
-			float* timeData = GetBufferData<float>(animationSampler->input);
-			uint8_t* valueData = GetBufferData<uint8_t>(animationSampler->output);
-			Float4* valueDataF4 = (Float4*)valueData;
-			Float3* valueDataF3 = (Float3*)valueData;
-			float* valueDataF = (float*)valueData;
+			// Load data, values are decoded to Float4 whatever their type is
+			const std::vector<float> timeData = ReadAccessor<float>(animationSampler->input);
+			const std::vector<Float4> valueData = ReadAccessor<Float4>(animationSampler->output);
 
 			// Insert entries
 			const cgltf_size entriesCount = animationSampler->output->count / animationSampler->input->count;
@@ -365,29 +350,29 @@ namespace ModelLoading
 				AnimationEntry entry{};
 				entry.Target = animationTarget;
 				entry.Interpolation = animationInterpolation;
-				entry.Duration = *(timeData + keyFrameCount - 1);
+				entry.Duration = timeData[keyFrameCount - 1];
 				entry.KeyFrames.resize(keyFrameCount);
 				entry.WeightTargetIndex = (uint32_t) i;
 
 				// Insert keyframes
 				for (cgltf_size keyFrameIndex = 0; keyFrameIndex < keyFrameCount; keyFrameIndex++)
 				{
-					entry.KeyFrames[keyFrameIndex].Time = *(timeData + keyFrameIndex);
+					entry.KeyFrames[keyFrameIndex].Time = timeData[keyFrameIndex];
 
-					const cgltf_size valueIndex = i + keyFrameIndex * entriesCount;
+					const Float4& value = valueData[i + keyFrameIndex * entriesCount];
 					switch (entry.Target)
 					{
 					case AnimTarget::Translation:
-						entry.KeyFrames[keyFrameIndex].Translation = *(valueDataF3 + valueIndex);
+						entry.KeyFrames[keyFrameIndex].Translation = Float3{ value.x, value.y, value.z };
 						break;
 					case AnimTarget::Rotation:
-						entry.KeyFrames[keyFrameIndex].Rotation = *(valueDataF4 + valueIndex);
+						entry.KeyFrames[keyFrameIndex].Rotation = value;
 						break;
 					case AnimTarget::Scale:
-						entry.KeyFrames[keyFrameIndex].Scale = *(valueDataF3 + valueIndex);
+						entry.KeyFrames[keyFrameIndex].Scale = Float3{ value.x, value.y, value.z };
 						break;
 					case AnimTarget::Weights:
-						entry.KeyFrames[keyFrameIndex].Weight = *(valueDataF + valueIndex);
+						entry.KeyFrames[keyFrameIndex].Weight = value.x;
 						break;
 					case AnimTarget::Invalid:
 					default:
@@ -413,16 +398,16 @@ namespace ModelLoading
 			cgltf_morph_target* morphTarget = meshData->targets + targetIndex;
 
 			VertexAttributesData vertices = LoadAttributes(morphTarget->attributes, morphTarget->attributes_count);
-			ASSERT(!vertices.Joints8 && !vertices.Joints16 && !vertices.Weights && !vertices.Colors, "[Loader::LoadMorph] Using not supported morph vertex attributes");
+			ASSERT(vertices.Joints.empty() && vertices.Weights.empty() && vertices.Colors.empty(), "[Loader::LoadMorph] Using not supported morph vertex attributes");
 
 			std::vector<MorphVertex> morphTargetData{};
 			morphTargetData.resize(vertices.NumVertices);
 			for (uint32_t i = 0; i < vertices.NumVertices; i++)
 			{
-				if (vertices.Positions) morphTargetData[i].Position = *(vertices.Positions + i);
-				if (vertices.Texcoords) morphTargetData[i].Texcoord = *(vertices.Texcoords + i);
-				if (vertices.Normals) morphTargetData[i].Normal = *(vertices.Normals + i);
-				if (vertices.Tangents) morphTargetData[i].Tangent = *(vertices.Tangents + i);
+				if (!vertices.Positions.empty()) morphTargetData[i].Position = vertices.Positions[i];
+				if (!vertices.Texcoords.empty()) morphTargetData[i].Texcoord = vertices.Texcoords[i];
+				if (!vertices.Normals.empty()) morphTargetData[i].Normal = vertices.Normals[i];
+				if (!vertices.Tangents.empty()) morphTargetData[i].Tangent = vertices.Tangents[i];
 			}
 			
 			ResourceInitData initData{};
@@ -441,13 +426,13 @@ namespace ModelLoading
 	{
 		if (!skinData) return;
 
-		DirectX::XMFLOAT4X4* jointMatrices = GetBufferData<DirectX::XMFLOAT4X4>(skinData->inverse_bind_matrices);
+		const std::vector<DirectX::XMFLOAT4X4> jointMatrices = ReadAccessor<DirectX::XMFLOAT4X4>(skinData->inverse_bind_matrices);
 		for (cgltf_size i = 0; i < skinData->joints_count; i++)
 		{
 			cgltf_node* jointNode = *(skinData->joints + i);
 
 			SkeletonJoint joint;
-			joint.ModelToJoint = *(jointMatrices + i);
+			joint.ModelToJoint = jointMatrices[i];
 			joint.Transform = CalcBaseTransform(jointNode, m_PositionOrigin, m_BaseScale);
 			joint.Animations = LoadAnimations(jointNode);
 			m_Object.Skeleton.push_back(joint);
@@ -457,7 +442,6 @@ namespace ModelLoading
 	void Loader::LoadObject(cgltf_primitive* objectData)
 	{
 		m_Object = SceneObject{};
-		m_Object.BoundingVolume = CalculateBoundingSphere(objectData);
 		LoadMesh(objectData);
 		LoadMaterial(objectData->material);
 	}
@@ -469,21 +453,7 @@ namespace ModelLoading
 		const uint32_t vertCount = (uint32_t) meshData->attributes[0].data->count;
 
 		const VertexAttributesData vertices = LoadAttributes(meshData->attributes, meshData->attributes_count);
-		std::vector<uint32_t> joints;
-
-		if (vertices.Joints8)
-		{
-			joints.resize(vertices.NumVertices * 4);
-			for (uint16_t i = 0; i < vertices.NumVertices * 4; i++) 
-				joints[i] = vertices.Joints8[i];
-		}
-
-		if (vertices.Joints16)
-		{
-			joints.resize(vertices.NumVertices * 4);
-			for (uint16_t i = 0; i < vertices.NumVertices * 4; i++)
-				joints[i] = vertices.Joints16[i];
-		}
+		m_Object.BoundingVolume = CalculateBoundingSphere(vertices);
 
 		std::vector<uint32_t> indices;
 		if(meshData->indices)
@@ -502,13 +472,13 @@ namespace ModelLoading
 			return GFX::CreateBuffer(numElements * stride, stride, RCF::None, &initData);
 		};
 
-		m_Object.Positions = createBuffer(vertices.Positions, sizeof(DirectX::XMFLOAT3), vertCount);
-		m_Object.Texcoords = createBuffer(vertices.Texcoords, sizeof(DirectX::XMFLOAT2), vertCount);
-		m_Object.Normals = createBuffer(vertices.Normals, sizeof(DirectX::XMFLOAT3), vertCount);
-		m_Object.Tangents = createBuffer(vertices.Tangents, sizeof(DirectX::XMFLOAT4), vertCount);
-		m_Object.Weights = createBuffer(vertices.Weights, sizeof(Float4), vertCount);
-		m_Object.Joints = createBuffer(joints.empty() ? nullptr : joints.data(), sizeof(uint32_t) * 4, vertCount);
-		m_Object.Indices = createBuffer(indices.empty() ? nullptr : indices.data(), sizeof(uint32_t), (uint32_t) indices.size());
+		m_Object.Positions = createBuffer(GetDataOrNull(vertices.Positions), sizeof(DirectX::XMFLOAT3), vertCount);
+		m_Object.Texcoords = createBuffer(GetDataOrNull(vertices.Texcoords), sizeof(DirectX::XMFLOAT2), vertCount);
+		m_Object.Normals = createBuffer(GetDataOrNull(vertices.Normals), sizeof(DirectX::XMFLOAT3), vertCount);
+		m_Object.Tangents = createBuffer(GetDataOrNull(vertices.Tangents), sizeof(DirectX::XMFLOAT4), vertCount);
+		m_Object.Weights = createBuffer(GetDataOrNull(vertices.Weights), sizeof(Float4), vertCount);
+		m_Object.Joints = createBuffer(GetDataOrNull(vertices.Joints), sizeof(uint32_t) * 4, vertCount);
+		m_Object.Indices = createBuffer(GetDataOrNull(indices), sizeof(uint32_t), (uint32_t) indices.size());
 	}
 
 	void Loader::LoadMaterial(cgltf_material* materialData)
@@ -546,7 +516,13 @@ namespace ModelLoading
 
 	Texture* Loader::LoadTexture(cgltf_texture* textureData, ColorUNORM defaultColor)
 	{
-		if (textureData)
+		size_t imageSize = 0;
+		const uint8_t* imageData = textureData ? MappedGLTF::GetImageData(textureData->image, imageSize) : nullptr;
+		if (imageData)
+		{
+			return TextureLoading::LoadTexture(m_Context, imageData, imageSize, RCF::None, m_TextureNumMips);
+		}
+		else if (textureData)
 		{
 			const std::string textureURI = textureData->image->uri;
 			const std::string texturePath = m_DirectoryPath + "/" + textureURI;
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <vector>
+
 #include "Common.h"
+#include "Loading/ImageDecoding.h"
 
 struct Texture;
 struct GraphicsContext;
@@ -9,7 +12,10 @@ enum class RCF : uint64_t;
 
 namespace TextureLoading
 {
+	Texture* CreateTextureHDR(GraphicsContext& context, const ImageDataHDR& image, RCF creationFlags);
+
 	Texture* LoadTextureHDR(GraphicsContext& context, const std::string& path, RCF creationFlags);
 	Texture* LoadTexture(GraphicsContext& context, const std::string& path, RCF creationFlags, uint32_t numMips = 1);
+	Texture* LoadTexture(GraphicsContext& context, const uint8_t* data, size_t size, RCF creationFlags, uint32_t numMips = 1);
 	Texture* LoadCubemap(GraphicsContext& context, const std::string& path, RCF creationFlags);
 }
\ No newline at end of file
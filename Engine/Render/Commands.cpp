@@ -153,7 +153,9 @@ namespace GFX::Cmd
 		{
 			context.CmdAlloc->Reset();
 			context.CmdList->Reset(context.CmdAlloc.Get(), nullptr);
-			context.BoundState.Valid = false;
+			context.BoundState.Tracker.Invalidate();
+			context.BoundState.ShaderPending = false;
+			context.DescriptorTableCache.clear();
 		}
 
 		context.Closed = false;
@@ -182,6 +184,9 @@ namespace GFX::Cmd
 
 		ASSERT(!values.empty(), "[UpdatePushConstants] Push constants are empty");
 
+		// Root signature of the skipped state isn't bound
+		if (context.BoundState.ShaderPending) return;
+
 		const bool useCompute = shaderStages & CS;
 		if (useCompute) context.CmdList->SetComputeRoot32BitConstants(0, (UINT)values.size(), values.data(), 0);
 		else  context.CmdList->SetGraphicsRoot32BitConstants(0, (UINT)values.size(), values.data(), 0);
@@ -198,11 +203,16 @@ namespace GFX::Cmd
 	}
 
 	void ClearDepthStencil(GraphicsContext& context, Texture* depthStencil)
+	{
+		D3D12_RECT rect = { 0, 0, (long) depthStencil->Width, (long) depthStencil->Height };
+		ClearDepthStencil(context, depthStencil, rect);
+	}
+
+	void ClearDepthStencil(GraphicsContext& context, Texture* depthStencil, const D3D12_RECT& rect)
 	{
 		PROFILE_CMD();
 
 		TransitionResource(context, depthStencil, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-		D3D12_RECT rect = { 0, 0, (long) depthStencil->Width, (long) depthStencil->Height };
 		context.CmdList->ClearDepthStencilView(depthStencil->DSV.GetCPUHandle(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 1, &rect);
 	}
 
@@ -253,11 +263,7 @@ namespace GFX::Cmd
 
 		// Get memory footprints
 		uint32_t subresourceIndex = 0;
-		D3D12_SUBRESOURCE_DATA subresourceData{};
-		subresourceData.pData = data;
 		subresourceIndex = GFX::GetSubresourceIndex(texture, mipIndex, arrayIndex);
-		subresourceData.RowPitch = texture->RowPitch;
-		subresourceData.SlicePitch = texture->SlicePitch;
 
 		uint64_t resourceSize;
 		D3D12_PLACED_SUBRESOURCE_FOOTPRINT subresLayout;
@@ -271,6 +277,12 @@ namespace GFX::Cmd
 		resourceDevice->GetCopyableFootprints(&resourceDesc, subresourceIndex, 1, 0, &subresLayout, &subresRowNumber, &subresRowByteSizes, &resourceSize);
 		resourceDevice->Release();
 
+		// Data has tightly packed rows of the mip, rows of 4x4 blocks for the block compressed formats
+		D3D12_SUBRESOURCE_DATA subresourceData{};
+		subresourceData.pData = data;
+		subresourceData.RowPitch = (LONG_PTR) subresRowByteSizes;
+		subresourceData.SlicePitch = (LONG_PTR) (subresRowByteSizes * subresRowNumber);
+
 		// Create staging resource
 		Buffer* stagingResource = GFX::CreateBuffer((uint32_t)resourceSize, 1, RCF::CPU_Access | RCF::NoSRV);
 		GFX::SetDebugName(stagingResource, "UpdateSubresource::StagingBuffer");
@@ -341,36 +353,42 @@ namespace GFX::Cmd
 	void Draw(GraphicsContext& context, uint32_t vertexCount, uint32_t vertexOffset)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->DrawInstanced(vertexCount, 1, vertexOffset, 0);
 	}
 	
 	void DrawIndexed(GraphicsContext& context, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexOffset)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->DrawIndexedInstanced(indexCount, 1, indexOffset, vertexOffset, 0);
 	}
 
 	void DrawInstanced(GraphicsContext& context, uint32_t vertexCount, uint32_t instanceCount, uint32_t vertexOffset, uint32_t firstInstance)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->DrawInstanced(vertexCount, instanceCount, vertexOffset, firstInstance);
 	}
 	
 	void DrawIndexedInstanced(GraphicsContext& context, uint32_t indexCount, uint32_t instanceCount, uint32_t indexOffset, uint32_t vertexOffset, uint32_t firstInstance)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->DrawIndexedInstanced(indexCount, instanceCount, indexOffset, vertexOffset, firstInstance);
 	}
 	
 	void Dispatch(GraphicsContext& context, uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->Dispatch(numGroupsX, numGroupsY, numGroupsZ);
 	}
 
 	void ExecuteIndirect(GraphicsContext& context, ID3D12CommandSignature* commandSignature, uint32_t maxCommands, Buffer* argumentBuffer, uint32_t argumentOffset, Buffer* countBuffer, uint32_t countBufferOffset)
 	{
 		PROFILE_CMD();
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->ExecuteIndirect(commandSignature, maxCommands, argumentBuffer->Handle.Get(), argumentOffset, countBuffer ? countBuffer->Handle.Get() : nullptr, countBufferOffset);
 	}
 
@@ -380,6 +398,7 @@ namespace GFX::Cmd
 
 		state.VertexBuffers[0] = GFX::RenderResources.QuadBuffer.get();
 		context.ApplyState(state);
+		if (context.BoundState.ShaderPending) return;
 		context.CmdList->DrawInstanced(6, 1, 0, 0);
 	}
 
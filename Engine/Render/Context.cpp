@@ -6,6 +6,7 @@
 #include "Render/Texture.h"
 #include "Render/Buffer.h"
 #include "Render/Shader.h"
+#include "Render/PipelineLibrary.h"
 #include "Utility/Hash.h"
 
 ContextManager* ContextManager::s_Instance = nullptr;
@@ -71,58 +72,6 @@ GraphicsState::GraphicsState()
 	CommandSignature.pArgumentDescs = nullptr;
 }
 
-static std::vector<D3D12_DESCRIPTOR_RANGE> CreateDescriptorRanges(const BindVector<Resource*>& bindings, D3D12_DESCRIPTOR_RANGE_TYPE rangeType)
-{
-	std::vector<D3D12_DESCRIPTOR_RANGE> ranges;
-
-	uint32_t descriptorsToBind = 0;
-	for (uint32_t i = 0; i < bindings.size(); i++)
-	{
-		if (bindings[i]) descriptorsToBind++;
-
-		if (!bindings[i] || i == bindings.size() - 1)
-		{
-			if (descriptorsToBind != 0)
-			{
-				uint32_t baseRegister = i - descriptorsToBind + 1;
-				if (!bindings[i]) baseRegister--;
-
-				D3D12_DESCRIPTOR_RANGE range;
-				range.RangeType = rangeType;
-				range.BaseShaderRegister = baseRegister;
-				range.NumDescriptors = descriptorsToBind;
-				range.RegisterSpace = 0;
-				range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-				ranges.push_back(range);
-
-				descriptorsToBind = 0;
-			}
-		}
-	}
-	return ranges;
-}
-
-static std::vector<D3D12_DESCRIPTOR_RANGE> CreateDescriptorRanges(const BindVector<BindlessTable>& bindlessTables, D3D12_DESCRIPTOR_RANGE_TYPE rangeType)
-{
-	ASSERT(rangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SRV, "Bindless tables only supported for SRVs!");
-
-	std::vector<D3D12_DESCRIPTOR_RANGE> ranges;
-
-	for (const BindlessTable& table : bindlessTables)
-	{
-		ASSERT(table.RegisterSpace != 0 && table.DescriptorCount != 0, "table.RegisterSpace != 0 && table.DescriptorCount != 0");
-
-		D3D12_DESCRIPTOR_RANGE range;
-		range.RangeType = rangeType;
-		range.BaseShaderRegister = 0;
-		range.NumDescriptors = table.DescriptorCount;
-		range.RegisterSpace = table.RegisterSpace;
-		range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-		ranges.push_back(range);
-	}
-	return ranges;
-}
-
 namespace
 {
 	enum class BindingType
@@ -174,115 +123,263 @@ static D3D12_PRIMITIVE_TOPOLOGY ToPrimitiveTopology(const RenderPrimitiveType pr
 	return D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
 }
 
-static uint32_t CalcRootSignatureHash(const GraphicsState& state)
+static std::vector<D3D12_DESCRIPTOR_RANGE> CreateDescriptorRanges(const std::bitset<BindingLayout::MAX_SLOTS>& slots, D3D12_DESCRIPTOR_RANGE_TYPE rangeType)
 {
-	uint32_t sigHash = Hash::Crc32(state.PushConstantCount);
-	sigHash = Hash::Crc32(sigHash, "CBV");
-	for (uint32_t i = 0; i < state.Table.CBVs.size(); i++) if(state.Table.CBVs[i]) sigHash = Hash::Crc32(sigHash, i);
-	sigHash = Hash::Crc32(sigHash, "SRV");
-	for (uint32_t i = 0; i < state.Table.SRVs.size(); i++) if (state.Table.SRVs[i]) sigHash = Hash::Crc32(sigHash, i);
-	sigHash = Hash::Crc32(sigHash, "UAV");
-	for (uint32_t i = 0; i < state.Table.UAVs.size(); i++) if (state.Table.UAVs[i]) sigHash = Hash::Crc32(sigHash, i);
-	sigHash = Hash::Crc32(sigHash, "SMP");
-	for (uint32_t i = 0; i < state.Table.SMPs.size(); i++) sigHash = Hash::Crc32(sigHash, i);
-	sigHash = Hash::Crc32(sigHash, "BTS");
-	for (const BindlessTable& table : state.BindlessTables)
+	// Bound registers are packed in the table, every run of registers is one range
+	std::vector<D3D12_DESCRIPTOR_RANGE> ranges;
+	for (uint32_t i = 0; i < slots.size(); i++)
 	{
-		sigHash = Hash::Crc32(sigHash, "1");
-		sigHash = Hash::Crc32(sigHash, table.RegisterSpace);
-		sigHash = Hash::Crc32(sigHash, "2");
-		sigHash = Hash::Crc32(sigHash, table.DescriptorCount);
-		sigHash = Hash::Crc32(sigHash, "3");
-		sigHash = Hash::Crc32(sigHash, table.DescriptorTable);
+		if (!slots[i]) continue;
+
+		if (ranges.empty() || ranges.back().BaseShaderRegister + ranges.back().NumDescriptors != i)
+		{
+			D3D12_DESCRIPTOR_RANGE range;
+			range.RangeType = rangeType;
+			range.BaseShaderRegister = i;
+			range.NumDescriptors = 0;
+			range.RegisterSpace = 0;
+			range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+			ranges.push_back(range);
+		}
+		ranges.back().NumDescriptors++;
 	}
-	return sigHash;
+	return ranges;
 }
 
-static ID3D12RootSignature* GetOrCreateRootSignature(GraphicsContext& context, const GraphicsState& state)
+static D3D12_DESCRIPTOR_RANGE CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE rangeType, uint32_t numDescriptors, uint32_t registerSpace = 0)
 {
-	uint32_t rootSignatureHash = CalcRootSignatureHash(state);
-	if (context.RootSignatureCache.contains(rootSignatureHash)) 
-		return context.RootSignatureCache[rootSignatureHash].Get();
+	D3D12_DESCRIPTOR_RANGE range;
+	range.RangeType = rangeType;
+	range.BaseShaderRegister = 0;
+	range.NumDescriptors = numDescriptors;
+	range.RegisterSpace = registerSpace;
+	range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+	return range;
+}
 
-	ID3D12RootSignature* rootSignature = nullptr;
+static D3D12_STATIC_SAMPLER_DESC CreateStaticSampler(StaticSampler sampler)
+{
+	D3D12_STATIC_SAMPLER_DESC samplerDesc{};
+	switch (sampler)
+	{
+	case StaticSampler::PointClamp:		samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP; break;
+	case StaticSampler::PointWrap:		samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP; break;
+	case StaticSampler::LinearClamp:	samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP; break;
+	case StaticSampler::LinearWrap:		samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP; break;
+	case StaticSampler::LinearBorder:	samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER; break;
+	case StaticSampler::AnisoWrap:		samplerDesc.Filter = D3D12_FILTER_ANISOTROPIC; samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP; break;
+	default: NOT_IMPLEMENTED;
+	}
+	samplerDesc.AddressV = samplerDesc.AddressU;
+	samplerDesc.AddressW = samplerDesc.AddressU;
+	samplerDesc.BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+	samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+	samplerDesc.MaxAnisotropy = 16;
+	samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MipLODBias = 0;
+	samplerDesc.ShaderRegister = STATIC_SAMPLER_REGISTER + EnumToInt(sampler);
+	samplerDesc.RegisterSpace = 0;
+	samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	return samplerDesc;
+}
 
-	const BindTable& table = state.Table;
-	std::vector<D3D12_ROOT_PARAMETER> rootParameters;
-	std::vector<std::vector<D3D12_DESCRIPTOR_RANGE>> descriptorRanges;
+static BindingLayout GetBindingLayout(const GraphicsState& state)
+{
+	const auto getSlots = [](const BindVector<Resource*>& bindings)
+	{
+		ASSERT(bindings.size() <= BindingLayout::MAX_SLOTS, "Binding slot is out of range");
 
-	if (!table.CBVs.empty()) descriptorRanges.push_back(CreateDescriptorRanges(table.CBVs, D3D12_DESCRIPTOR_RANGE_TYPE_CBV));
-	if (!table.SRVs.empty()) descriptorRanges.push_back(CreateDescriptorRanges(table.SRVs, D3D12_DESCRIPTOR_RANGE_TYPE_SRV));
-	if (!table.UAVs.empty()) descriptorRanges.push_back(CreateDescriptorRanges(table.UAVs, D3D12_DESCRIPTOR_RANGE_TYPE_UAV));
+		std::bitset<BindingLayout::MAX_SLOTS> slots;
+		for (uint32_t i = 0; i < bindings.size(); i++) if (bindings[i]) slots.set(i);
+		return slots;
+	};
 
-	if (!state.Table.SMPs.empty())
+	BindingLayout layout;
+	layout.CBVs = getSlots(state.Table.CBVs);
+	layout.SRVs = getSlots(state.Table.SRVs);
+	layout.UAVs = getSlots(state.Table.UAVs);
+	layout.NumSamplers = (uint32_t) state.Table.SMPs.size();
+	layout.PushConstantBinding = state.PushConstantBinding;
+	layout.PushConstantCount = state.PushConstantCount;
+	for (const BindlessTable& table : state.BindlessTables)
 	{
-		D3D12_DESCRIPTOR_RANGE samplerRange;
-		samplerRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
-		samplerRange.BaseShaderRegister = 0;
-		samplerRange.NumDescriptors = (UINT)state.Table.SMPs.size();
-		samplerRange.RegisterSpace = 0;
-		samplerRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-		descriptorRanges.push_back({ samplerRange });
+		ASSERT(table.RegisterSpace != 0 && table.DescriptorCount != 0, "table.RegisterSpace != 0 && table.DescriptorCount != 0");
+		layout.BindlessTables.push_back({ table.RegisterSpace, table.DescriptorCount });
 	}
-	if(!state.BindlessTables.empty()) descriptorRanges.push_back(CreateDescriptorRanges(state.BindlessTables, D3D12_DESCRIPTOR_RANGE_TYPE_SRV));
+	return layout;
+}
+
+static IndirectLayout GetIndirectLayout(const D3D12_COMMAND_SIGNATURE_DESC& commandSignature)
+{
+	static_assert(EnumToInt(IndirectLayout::ArgumentType::UnorderedAccessView) == D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW);
 
-	if (state.PushConstantCount != 0)
+	// Only the used part of the union is copied, the rest is left uninitialized by the callers and would change the hash
+	IndirectLayout layout;
+	layout.ByteStride = commandSignature.ByteStride;
+	for (uint32_t i = 0; i < commandSignature.NumArgumentDescs; i++)
 	{
-		D3D12_ROOT_PARAMETER rootParamater;
-		rootParamater.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
-		rootParamater.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParamater.Constants.Num32BitValues = (uint32_t) state.PushConstantCount;
-		rootParamater.Constants.RegisterSpace = 0;
-		rootParamater.Constants.ShaderRegister = state.PushConstantBinding;
-		rootParameters.push_back(rootParamater);
+		const D3D12_INDIRECT_ARGUMENT_DESC& argumentDesc = commandSignature.pArgumentDescs[i];
+
+		IndirectLayout::Argument argument;
+		argument.Type = IntToEnum<IndirectLayout::ArgumentType>(argumentDesc.Type);
+		switch (argumentDesc.Type)
+		{
+		case D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW:
+			argument.Data[0] = argumentDesc.VertexBuffer.Slot;
+			break;
+		case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
+			argument.Data[0] = argumentDesc.Constant.RootParameterIndex;
+			argument.Data[1] = argumentDesc.Constant.DestOffsetIn32BitValues;
+			argument.Data[2] = argumentDesc.Constant.Num32BitValuesToSet;
+			break;
+		case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
+		case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
+		case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
+			argument.Data[0] = argumentDesc.ConstantBufferView.RootParameterIndex;
+			break;
+		default:
+			break;
+		}
+		layout.Arguments.push_back(argument);
 	}
+	return layout;
+}
 
-	for (const auto& descriptors : descriptorRanges)
+namespace
+{
+	class D3D12SignatureFactory : public D3D12SignatureCache::Factory
 	{
-		D3D12_ROOT_PARAMETER rootParamater;
-		rootParamater.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-		rootParamater.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParamater.DescriptorTable.NumDescriptorRanges = (uint32_t)descriptors.size();
-		rootParamater.DescriptorTable.pDescriptorRanges = descriptors.data();
-		rootParameters.push_back(rootParamater);
-	}
+	public:
+		ComPtr<ID3D12RootSignature> CreateRootSignature(const BindingLayout& layout, bool global) override
+		{
+			std::vector<D3D12_ROOT_PARAMETER> rootParameters;
+			std::vector<std::vector<D3D12_DESCRIPTOR_RANGE>> descriptorRanges;
+
+			const auto addPushConstants = [&rootParameters](uint32_t count, uint32_t binding)
+			{
+				D3D12_ROOT_PARAMETER rootParamater;
+				rootParamater.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+				rootParamater.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+				rootParamater.Constants.Num32BitValues = count;
+				rootParamater.Constants.RegisterSpace = 0;
+				rootParamater.Constants.ShaderRegister = binding;
+				rootParameters.push_back(rootParamater);
+			};
+
+			// Order of the parameters has to match RootParameters
+			if (global)
+			{
+				addPushConstants(GlobalRootSignature::PUSH_CONSTANT_COUNT, GlobalRootSignature::PUSH_CONSTANT_BINDING);
+				descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, GlobalRootSignature::CBV_COUNT) });
+				descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, GlobalRootSignature::SRV_COUNT) });
+				descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, GlobalRootSignature::UAV_COUNT) });
+				descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, GlobalRootSignature::SAMPLER_COUNT) });
+				descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, GlobalRootSignature::BINDLESS_REGISTER_SPACE) });
+			}
+			else
+			{
+				if (layout.PushConstantCount != 0) addPushConstants(layout.PushConstantCount, layout.PushConstantBinding);
+				if (layout.CBVs.any()) descriptorRanges.push_back(CreateDescriptorRanges(layout.CBVs, D3D12_DESCRIPTOR_RANGE_TYPE_CBV));
+				if (layout.SRVs.any()) descriptorRanges.push_back(CreateDescriptorRanges(layout.SRVs, D3D12_DESCRIPTOR_RANGE_TYPE_SRV));
+				if (layout.UAVs.any()) descriptorRanges.push_back(CreateDescriptorRanges(layout.UAVs, D3D12_DESCRIPTOR_RANGE_TYPE_UAV));
+				if (layout.NumSamplers != 0) descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, layout.NumSamplers) });
+				for (const BindingLayout::BindlessTable& table : layout.BindlessTables)
+				{
+					descriptorRanges.push_back({ CreateDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, table.DescriptorCount, table.RegisterSpace) });
+				}
+			}
 
-	D3D12_ROOT_SIGNATURE_DESC rootSigDesc;
-	rootSigDesc.NumParameters = (uint32_t)rootParameters.size();
-	rootSigDesc.pParameters = rootSigDesc.NumParameters == 0 ? nullptr : rootParameters.data();
-	rootSigDesc.NumStaticSamplers = 0;
-	rootSigDesc.pStaticSamplers = nullptr;
-	rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+			for (const auto& descriptors : descriptorRanges)
+			{
+				D3D12_ROOT_PARAMETER rootParamater;
+				rootParamater.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+				rootParamater.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+				rootParamater.DescriptorTable.NumDescriptorRanges = (uint32_t)descriptors.size();
+				rootParamater.DescriptorTable.pDescriptorRanges = descriptors.data();
+				rootParameters.push_back(rootParamater);
+			}
 
-	ComPtr<ID3DBlob> serializedRootSig = nullptr;
-	ComPtr<ID3DBlob> errorBlob = nullptr;
-	HRESULT hr = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-		serializedRootSig.GetAddressOf(), errorBlob.GetAddressOf());
+			std::vector<D3D12_STATIC_SAMPLER_DESC> staticSamplers;
+			for (uint32_t i = 0; i < EnumToInt(StaticSampler::Count); i++) staticSamplers.push_back(CreateStaticSampler(IntToEnum<StaticSampler>(i)));
 
-	if (FAILED(hr))
-	{
-		const char* errorString = NULL;
-		if (errorBlob) {
-			errorString = (const char*)errorBlob->GetBufferPointer();
+			D3D12_ROOT_SIGNATURE_DESC rootSigDesc;
+			rootSigDesc.NumParameters = (uint32_t)rootParameters.size();
+			rootSigDesc.pParameters = rootSigDesc.NumParameters == 0 ? nullptr : rootParameters.data();
+			rootSigDesc.NumStaticSamplers = (uint32_t)staticSamplers.size();
+			rootSigDesc.pStaticSamplers = staticSamplers.data();
+			rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+			ComPtr<ID3DBlob> serializedRootSig = nullptr;
+			ComPtr<ID3DBlob> errorBlob = nullptr;
+			HRESULT hr = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1,
+				serializedRootSig.GetAddressOf(), errorBlob.GetAddressOf());
+
+			if (FAILED(hr))
+			{
+				const char* errorString = NULL;
+				if (errorBlob) {
+					errorString = (const char*)errorBlob->GetBufferPointer();
+				}
+				MessageBoxA(0, errorString, "Root signature serialization Error", MB_ICONERROR | MB_OK);
+				ASSERT(0, "[GraphicsContext::SubmitState] Failed to create root signature");
+			}
+
+			ComPtr<ID3D12RootSignature> rootSignature;
+			API_CALL(Device::Get()->GetHandle()->CreateRootSignature(0, serializedRootSig->GetBufferPointer(), serializedRootSig->GetBufferSize(), IID_PPV_ARGS(rootSignature.GetAddressOf())));
+			return rootSignature;
 		}
-		MessageBoxA(0, errorString, "Root signature serialization Error", MB_ICONERROR | MB_OK);
-		ASSERT(0, "[GraphicsContext::SubmitState] Failed to create root signature");
-	}
 
-	Device* device = Device::Get();
+		ComPtr<ID3D12CommandSignature> CreateCommandSignature(const IndirectLayout& layout, const ComPtr<ID3D12RootSignature>* rootSignature) override
+		{
+			static_assert(sizeof(IndirectLayout::Argument) == sizeof(D3D12_INDIRECT_ARGUMENT_DESC));
+
+			std::vector<D3D12_INDIRECT_ARGUMENT_DESC> arguments(layout.Arguments.size());
+			memcpy(arguments.data(), layout.Arguments.data(), arguments.size() * sizeof(D3D12_INDIRECT_ARGUMENT_DESC));
+
+			D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc{};
+			commandSignatureDesc.ByteStride = layout.ByteStride;
+			commandSignatureDesc.NumArgumentDescs = (uint32_t)arguments.size();
+			commandSignatureDesc.pArgumentDescs = arguments.data();
+			commandSignatureDesc.NodeMask = 0;
 
-	API_CALL(device->GetHandle()->CreateRootSignature(0, serializedRootSig->GetBufferPointer(), serializedRootSig->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
+			ComPtr<ID3D12CommandSignature> commandSignature;
+			API_CALL(Device::Get()->GetHandle()->CreateCommandSignature(&commandSignatureDesc, rootSignature ? rootSignature->Get() : nullptr, IID_PPV_ARGS(commandSignature.GetAddressOf())));
+			return commandSignature;
+		}
+	};
+
+	D3D12SignatureFactory SignatureFactory;
+}
 
-	context.RootSignatureCache[rootSignatureHash] = rootSignature;
+// Pointers in the description are replaced by the hashes of what they point to, the hash stays the same between launches for the pipeline library
+template<typename PipelineDesc>
+static uint64_t CalcPSOHash(PipelineDesc pipeline, const CompiledShader& compiledShader, uint64_t rootSignatureHash, bool multiInput)
+{
+	pipeline.pRootSignature = nullptr;
+	if constexpr (std::is_same_v<PipelineDesc, D3D12_GRAPHICS_PIPELINE_STATE_DESC>)
+	{
+		pipeline.VS = pipeline.HS = pipeline.DS = pipeline.GS = pipeline.PS = {};
+		pipeline.InputLayout.pInputElementDescs = nullptr;
+	}
+	else
+	{
+		pipeline.CS = {};
+	}
 
-	return rootSignature;
+	uint64_t psoHash = Hash::XXHash64(pipeline);
+	psoHash = Hash::XXHash64(psoHash, compiledShader.Hash);
+	psoHash = Hash::XXHash64(psoHash, rootSignatureHash);
+	psoHash = Hash::XXHash64(psoHash, multiInput);
+	return psoHash;
 }
 
-static ID3D12PipelineState* GetOrCreatePSO(GraphicsContext& context, const GraphicsState& state, ID3D12RootSignature* rootSignature, uint32_t& psoHash)
+static ID3D12PipelineState* GetOrCreatePSO(const GraphicsState& state, ID3D12RootSignature* rootSignature, uint64_t rootSignatureHash, uint64_t& psoHash)
 {
 	ID3D12PipelineState* pipelineState = nullptr;
-	const CompiledShader& compShader = GFX::GetCompiledShader(state.Shader, state.ShaderConfig, state.ShaderStages);
+	// Holds the implementation until the PSO is created, the hot reload can replace it on another thread meanwhile
+	const std::shared_ptr<const CompiledShader> compiledShader = GFX::GetCompiledShader(state.Shader, state.ShaderConfig, state.ShaderStages);
+	const CompiledShader& compShader = *compiledShader;
 
 	if (state.ShaderStages & CS)
 	{
@@ -293,16 +390,8 @@ static ID3D12PipelineState* GetOrCreatePSO(GraphicsContext& context, const Graph
 		pipeline.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 		pipeline.NodeMask = 0;
 
-		psoHash = Hash::Crc32(pipeline);
-		if (context.PSOCache.contains(psoHash))
-		{
-			pipelineState = context.PSOCache[psoHash].Get();
-		}
-		else
-		{
-			API_CALL(Device::Get()->GetHandle()->CreateComputePipelineState(&pipeline, IID_PPV_ARGS(&pipelineState)));
-			context.PSOCache[psoHash] = pipelineState;
-		}
+		psoHash = CalcPSOHash(pipeline, compShader, rootSignatureHash, false);
+		pipelineState = ContextManager::Get().PSOCache.GetOrCreate(psoHash, [&pipeline, psoHash] { return Device::Get()->GetPipelineLibrary()->CreatePipelineState(psoHash, pipeline); }).Get();
 	}
 	else
 	{
@@ -330,16 +419,8 @@ static ID3D12PipelineState* GetOrCreatePSO(GraphicsContext& context, const Graph
 		pipeline.SampleDesc.Count = state.RenderTargets.empty() ? (state.DepthStencil ? GetSampleCount(state.DepthStencil->CreationFlags) : 1) : GetSampleCount(state.RenderTargets[0]->CreationFlags);
 		pipeline.SampleDesc.Quality = 0;
 
-		psoHash = Hash::Crc32(pipeline);
-		if (context.PSOCache.contains(psoHash))
-		{
-			pipelineState = context.PSOCache[psoHash].Get();
-		}
-		else
-		{
-			API_CALL(Device::Get()->GetHandle()->CreateGraphicsPipelineState(&pipeline, IID_PPV_ARGS(&pipelineState)));
-			context.PSOCache[psoHash] = pipelineState;
-		}
+		psoHash = CalcPSOHash(pipeline, compShader, rootSignatureHash, state.VertexBuffers.size() > 1);
+		pipelineState = ContextManager::Get().PSOCache.GetOrCreate(psoHash, [&pipeline, psoHash] { return Device::Get()->GetPipelineLibrary()->CreatePipelineState(psoHash, pipeline); }).Get();
 	}
 	return pipelineState;
 }
@@ -361,7 +442,7 @@ static D3D12_CPU_DESCRIPTOR_HANDLE GetSamplerDescriptor(GraphicsContext& context
 	samplerDesc.MinLOD = 0;
 	samplerDesc.MipLODBias = 0;
 	
-	const uint32_t samplerHash = Hash::Crc32(samplerDesc);
+	const uint64_t samplerHash = Hash::XXHash64(samplerDesc);
 	if (!context.SamplerCache.contains(samplerHash))
 	{
 		context.SamplerCache[samplerHash] = Device::Get()->GetMemory().SMPHeap->Allocate();
@@ -371,20 +452,38 @@ static D3D12_CPU_DESCRIPTOR_HANDLE GetSamplerDescriptor(GraphicsContext& context
 	return context.SamplerCache[samplerHash].GetCPUHandle();
 }
 
-static DescriptorAllocation CreateDescriptorTable(GraphicsContext& context, const BindVector<Resource*>& bindings, BindingType bindingType)
+static DescriptorAllocation GetDescriptor(Resource* resource, BindingType type)
+{
+	switch (type)
+	{
+	case BindingType::CBV: return resource->CBV;
+	case BindingType::SRV: return resource->SRV;
+	case BindingType::UAV: return resource->UAV;
+	default: NOT_IMPLEMENTED;
+	}
+
+	return DescriptorAllocation{};
+}
+
+static DescriptorAllocation CreateDescriptorTable(const BindVector<Resource*>& bindings, BindingType bindingType, bool global)
 {
-	const auto getDescriptor = [](Resource* resource, BindingType type)
+	// Tables of the global root signature have every register, the unbound ones are null
+	if (global)
 	{
-		switch (type)
+		const DeviceMemory& deviceMemory = Device::Get()->GetMemory();
+		const DescriptorAllocation& nullDescriptors = bindingType == BindingType::CBV ? deviceMemory.NullCBVs : (bindingType == BindingType::SRV ? deviceMemory.NullSRVs : deviceMemory.NullUAVs);
+		DescriptorAllocation alloc = deviceMemory.SRVHeapGPU->AllocateTransient(nullDescriptors.GetDescriptorCount());
+		Device::Get()->GetHandle()->CopyDescriptorsSimple((UINT) nullDescriptors.GetDescriptorCount(), alloc.GetCPUHandle(), nullDescriptors.GetCPUHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+		for (uint32_t i = 0; i < bindings.size(); i++)
 		{
-		case BindingType::CBV: return resource->CBV;
-		case BindingType::SRV: return resource->SRV;
-		case BindingType::UAV: return resource->UAV;
-		default: NOT_IMPLEMENTED;
-		}
+			if (!bindings[i]) continue;
 
-		return DescriptorAllocation{};
-	};
+			const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = GetDescriptor(bindings[i], bindingType).GetCPUHandle();
+			Device::Get()->GetHandle()->CopyDescriptorsSimple(1, alloc.GetCPUHandle(i), srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		}
+		return alloc;
+	}
 
 	std::vector<Resource*> bindingsToUpload{};
 	for (Resource* binding : bindings)
@@ -395,185 +494,370 @@ static DescriptorAllocation CreateDescriptorTable(GraphicsContext& context, cons
 
 	for (size_t i = 0; i < bindingsToUpload.size(); i++)
 	{
-		const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = getDescriptor(bindingsToUpload[i], bindingType).GetCPUHandle();
+		const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = GetDescriptor(bindingsToUpload[i], bindingType).GetCPUHandle();
 		const D3D12_CPU_DESCRIPTOR_HANDLE dstDescriptor = alloc.GetCPUHandle(i);
 		Device::Get()->GetHandle()->CopyDescriptorsSimple(1, dstDescriptor, srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	}
 	return alloc;
 }
 
-ID3D12CommandSignature* GraphicsContext::ApplyState(const GraphicsState& state)
+static DescriptorAllocation CreateSamplerTable(GraphicsContext& context, const BindVector<Sampler>& samplers, bool global)
 {
-	PROFILE_SECTION(*this, "ApplyState");
-
 	Device* device = Device::Get();
-	DeviceMemory& deviceMemory = Device::Get()->GetMemory();
-	ID3D12GraphicsCommandList* cmdList = CmdList.Get();
+	DeviceMemory& deviceMemory = device->GetMemory();
 
-	std::vector<D3D12_RESOURCE_BARRIER> barriers;
-	
-	const bool useCompute = state.ShaderStages & CS;
+	const size_t numSamplers = global ? GlobalRootSignature::SAMPLER_COUNT : samplers.size();
+	DescriptorAllocation samplerTable = deviceMemory.SMPHeapGPU->AllocateTransient(numSamplers);
+	if (global) device->GetHandle()->CopyDescriptorsSimple((UINT) numSamplers, samplerTable.GetCPUHandle(), deviceMemory.NullSamplers.GetCPUHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
 
-	// Root Signature
-	ID3D12RootSignature* rootSignature = GetOrCreateRootSignature(*this, state);
-	
-	// Pipeline state
-	uint32_t psoHash = 0;
-	ID3D12PipelineState* pipelineState = GetOrCreatePSO(*this, state, rootSignature, psoHash);
+	for (size_t i = 0; i < samplers.size(); i++)
+	{
+		const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = GetSamplerDescriptor(context, samplers[i]);
+		const D3D12_CPU_DESCRIPTOR_HANDLE dstDescriptor = samplerTable.GetCPUHandle(i);
+		device->GetHandle()->CopyDescriptorsSimple(1, dstDescriptor, srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+	}
+	return samplerTable;
+}
 
-	const bool pipelineDirty = !BoundState.Valid || BoundState.PSOHash != psoHash;
-	BoundState.Valid = true;
-	BoundState.PSOHash = psoHash;
+// Keys of the StateTracker components, made only from what is cheap to read from the state
 
-	if (pipelineDirty)
+static uint64_t GetDescriptorTableKey(const BindVector<Resource*>& bindings, BindingType bindingType, bool global)
+{
+	if (bindings.empty()) return 0;
+
+	uint64_t hash = Hash::XXHash64(bindingType);
+	hash = Hash::XXHash64(hash, global);
+	for (uint32_t i = 0; i < bindings.size(); i++)
 	{
-		std::vector<ID3D12DescriptorHeap*> descriptorHeaps{};
-		descriptorHeaps.push_back(deviceMemory.SRVHeapGPU->GetHeap());
-		descriptorHeaps.push_back(deviceMemory.SMPHeapGPU->GetHeap());
-		cmdList->SetDescriptorHeaps((UINT) descriptorHeaps.size(), descriptorHeaps.data());
+		if (!bindings[i]) continue;
 
-		if (useCompute) cmdList->SetComputeRootSignature(rootSignature);
-		else cmdList->SetGraphicsRootSignature(rootSignature);
-		cmdList->SetPipelineState(pipelineState);
+		hash = Hash::XXHash64(hash, i);
+		hash = Hash::XXHash64(hash, GetDescriptor(bindings[i], bindingType).GetCPUHandle().ptr);
 	}
+	return hash;
+}
 
-	if (!useCompute)
+static uint64_t GetSamplerTableKey(const BindVector<Sampler>& samplers, bool global)
+{
+	if (samplers.empty()) return 0;
+
+	uint64_t hash = Hash::XXHash64(BindingType::SMP);
+	hash = Hash::XXHash64(hash, global);
+	for (const Sampler& sampler : samplers) hash = Hash::XXHash64(hash, sampler);
+	return hash;
+}
+
+// Everything the pipeline description is made of, the shader isn't resolved for it
+static uint64_t CalcPipelineKey(const GraphicsState& state, uint64_t rootSignatureHash)
+{
+	uint64_t hash = Hash::XXHash64(state.Shader);
+	hash = Hash::XXHash64(hash, state.ShaderConfig);
+	hash = Hash::XXHash64(hash, state.ShaderStages);
+	hash = Hash::XXHash64(hash, rootSignatureHash);
+	if (state.ShaderStages & CS) return hash;
+
+	hash = Hash::XXHash64(hash, state.BlendState);
+	hash = Hash::XXHash64(hash, state.RasterizerState);
+	hash = Hash::XXHash64(hash, state.DepthStencilState);
+	hash = Hash::XXHash64(hash, ToPrimitiveTopologyType(state.PrimitiveType));
+	hash = Hash::XXHash64(hash, state.VertexBuffers.size() > 1);
+	hash = Hash::XXHash64(hash, state.RenderTargets.size());
+	for (const Texture* renderTarget : state.RenderTargets)
 	{
-		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> rtDescs{};
-		rtDescs.reserve(state.RenderTargets.size());
-		const D3D12_CPU_DESCRIPTOR_HANDLE* dsDescPtr = nullptr;
-		D3D12_CPU_DESCRIPTOR_HANDLE dsDesc;
-		
-		for (Texture* rt : state.RenderTargets)
+		hash = Hash::XXHash64(hash, renderTarget->Format);
+		hash = Hash::XXHash64(hash, GetSampleCount(renderTarget->CreationFlags));
+	}
+	if (state.DepthStencil)
+	{
+		hash = Hash::XXHash64(hash, state.DepthStencil->Format);
+		hash = Hash::XXHash64(hash, GetSampleCount(state.DepthStencil->CreationFlags));
+	}
+	return hash;
+}
+
+static void GetViewportAndScissor(const GraphicsState& state, D3D12_VIEWPORT& viewport, D3D12_RECT& scissor)
+{
+	viewport = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	scissor = { 0, 0, 0, 0 };
+	if (state.DepthStencil)
+	{
+		viewport.Width = (float)state.DepthStencil->Width;
+		viewport.Height = (float)state.DepthStencil->Height;
+		scissor.right = (long)state.DepthStencil->Width;
+		scissor.bottom = (long)state.DepthStencil->Height;
+	}
+	if (!state.RenderTargets.empty())
+	{
+		viewport.Width = (float)state.RenderTargets[0]->Width;
+		viewport.Height = (float)state.RenderTargets[0]->Height;
+		scissor.right = (long)state.RenderTargets[0]->Width;
+		scissor.bottom = (long)state.RenderTargets[0]->Height;
+	}
+	if (state.UseCustomViewport)
+		viewport = state.CustomViewport;
+
+	if (state.UseCustomScissor)
+		scissor = state.CustomScissor;
+}
+
+static D3D12_INDEX_BUFFER_VIEW GetIndexBufferView(const Buffer* indexBuffer)
+{
+	DXGI_FORMAT dxgiFormat = DXGI_FORMAT_UNKNOWN;
+	switch (indexBuffer->Stride)
+	{
+	case 1:  dxgiFormat = DXGI_FORMAT_R8_UINT; break;
+	case 2: dxgiFormat = DXGI_FORMAT_R16_UINT; break;
+	case 4: dxgiFormat = DXGI_FORMAT_R32_UINT; break;
+	default: NOT_IMPLEMENTED;
+	}
+	return { indexBuffer->GPUAddress, (uint32_t)indexBuffer->ByteSize, dxgiFormat };
+}
+
+namespace
+{
+	enum DescriptorTableSlot : uint32_t
+	{
+		CBVTable,
+		SRVTable,
+		UAVTable,
+		SamplerTable,
+	};
+	static_assert(SamplerTable + 1 == StateTracker::FIRST_BINDLESS_TABLE);
+
+	// Records the commands of the components that the StateTracker found changed
+	class ApplyStateSink : public StateTracker::CommandSink
+	{
+	public:
+		ApplyStateSink(GraphicsContext& context, const GraphicsState& state, const BindingLayout& bindingLayout, const StateTracker::State& trackedState) :
+			m_Context(context),
+			m_State(state),
+			m_BindingLayout(bindingLayout),
+			m_TrackedState(trackedState),
+			m_CmdList(context.CmdList.Get())
+		{}
+
+		void SetDescriptorHeaps() override
 		{
-			ASSERT(TestFlag(rt->CreationFlags, RCF::RTV), "Texture must have RCF_Bind_RTV in order to be used as a render target!");
-			GFX::Cmd::AddResourceTransition(barriers, rt, D3D12_RESOURCE_STATE_RENDER_TARGET);
-			rtDescs.push_back(rt->RTV.GetCPUHandle());
+			const DeviceMemory& deviceMemory = Device::Get()->GetMemory();
+			ID3D12DescriptorHeap* descriptorHeaps[] = { deviceMemory.SRVHeapGPU->GetHeap(), deviceMemory.SMPHeapGPU->GetHeap() };
+			m_CmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 		}
 
-		if (state.DepthStencil)
+		void SetRootSignature() override
 		{
-			ASSERT(TestFlag(state.DepthStencil->CreationFlags, RCF::DSV), "Texture must have RCF_Bind_DSV in order to be used as a depth stencil!");
-			GFX::Cmd::AddResourceTransition(barriers, state.DepthStencil, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-			dsDesc = state.DepthStencil->DSV.GetCPUHandle();
-			dsDescPtr = &dsDesc;
+			m_Context.BoundState.RootSignature = ContextManager::Get().Signatures.GetRootSignature(SignatureFactory, m_BindingLayout);
+
+			ID3D12RootSignature* rootSignature = m_Context.BoundState.RootSignature.Signature->Get();
+			if (m_TrackedState.Compute) m_CmdList->SetComputeRootSignature(rootSignature);
+			else m_CmdList->SetGraphicsRootSignature(rootSignature);
 		}
 
-		cmdList->OMSetRenderTargets((UINT) rtDescs.size(), rtDescs.empty() ? nullptr : rtDescs.data(), false, dsDescPtr);
-		cmdList->OMSetStencilRef(state.StencilRef);
-		D3D12_VIEWPORT viewport = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
-		D3D12_RECT scissor = { 0, 0, 0, 0 };
-		if (state.DepthStencil)
+		void SetPipelineState() override
 		{
-			viewport.Width = (float)state.DepthStencil->Width;
-			viewport.Height = (float)state.DepthStencil->Height;
-			scissor.right = (long)state.DepthStencil->Width;
-			scissor.bottom = (long)state.DepthStencil->Height;
+			const D3D12SignatureCache::Selection& rootSignature = m_Context.BoundState.RootSignature;
+
+			uint64_t psoHash = 0;
+			m_CmdList->SetPipelineState(GetOrCreatePSO(m_State, rootSignature.Signature->Get(), rootSignature.Hash, psoHash));
 		}
-		if (!state.RenderTargets.empty())
+
+		void SetDescriptorTable(uint32_t table) override
 		{
-			viewport.Width = (float)state.RenderTargets[0]->Width;
-			viewport.Height = (float)state.RenderTargets[0]->Height;
-			scissor.right = (long)state.RenderTargets[0]->Width;
-			scissor.bottom = (long)state.RenderTargets[0]->Height;
-		}
-		if (state.UseCustomViewport)
-			viewport = state.CustomViewport;
+			const D3D12SignatureCache::Selection& rootSignature = m_Context.BoundState.RootSignature;
+			const RootParameters& rootParameters = rootSignature.Parameters;
 
-		if (state.UseCustomScissor)
-			scissor = state.CustomScissor;
+			if (table >= StateTracker::FIRST_BINDLESS_TABLE)
+			{
+				const uint32_t bindlessTable = table - StateTracker::FIRST_BINDLESS_TABLE;
+				BindTable(rootParameters.FirstBindlessTable + bindlessTable, m_State.BindlessTables[bindlessTable].DescriptorTable);
+				return;
+			}
 
-		cmdList->RSSetViewports(1, &viewport);
-		cmdList->RSSetScissorRects(1, &scissor);
-		cmdList->IASetPrimitiveTopology(ToPrimitiveTopology(state.PrimitiveType, state.NumControlPoints));
+			// Same bindings are copied to the descriptor heap once per recording
+			const uint64_t key = m_TrackedState.DescriptorTables[table];
+			auto it = m_Context.DescriptorTableCache.find(key);
+			if (it == m_Context.DescriptorTableCache.end())
+			{
+				DescriptorAllocation descriptorTable;
+				switch (table)
+				{
+				case CBVTable: descriptorTable = CreateDescriptorTable(m_State.Table.CBVs, BindingType::CBV, rootSignature.IsGlobal); break;
+				case SRVTable: descriptorTable = CreateDescriptorTable(m_State.Table.SRVs, BindingType::SRV, rootSignature.IsGlobal); break;
+				case UAVTable: descriptorTable = CreateDescriptorTable(m_State.Table.UAVs, BindingType::UAV, rootSignature.IsGlobal); break;
+				case SamplerTable: descriptorTable = CreateSamplerTable(m_Context, m_State.Table.SMPs, rootSignature.IsGlobal); break;
+				default: NOT_IMPLEMENTED;
+				}
+				it = m_Context.DescriptorTableCache.emplace(key, descriptorTable).first;
+			}
 
-		if (state.VertexBuffers.size())
-		{
-			std::vector<D3D12_VERTEX_BUFFER_VIEW> views;
-			views.reserve(state.VertexBuffers.size());
-			for (Buffer* buffer : state.VertexBuffers)
+			switch (table)
 			{
-				GFX::Cmd::AddResourceTransition(barriers, buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-				views.push_back({ buffer->GPUAddress, (uint32_t)buffer->ByteSize, (uint32_t)buffer->Stride });
+			case CBVTable: BindTable(rootParameters.CBVs, it->second); break;
+			case SRVTable: BindTable(rootParameters.SRVs, it->second); break;
+			case UAVTable: BindTable(rootParameters.UAVs, it->second); break;
+			case SamplerTable: BindTable(rootParameters.Samplers, it->second); break;
+			default: NOT_IMPLEMENTED;
 			}
-			cmdList->IASetVertexBuffers(0, (UINT) views.size(), views.data());
 		}
 
-		if (state.IndexBuffer)
+		void SetRenderTargets() override
 		{
-			DXGI_FORMAT dxgiFormat = DXGI_FORMAT_UNKNOWN;
-			switch (state.IndexBuffer->Stride)
+			std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> rtDescs{};
+			rtDescs.reserve(m_State.RenderTargets.size());
+			for (Texture* rt : m_State.RenderTargets) rtDescs.push_back(rt->RTV.GetCPUHandle());
+
+			D3D12_CPU_DESCRIPTOR_HANDLE dsDesc;
+			const D3D12_CPU_DESCRIPTOR_HANDLE* dsDescPtr = nullptr;
+			if (m_State.DepthStencil)
 			{
-			case 1:  dxgiFormat = DXGI_FORMAT_R8_UINT; break;
-			case 2: dxgiFormat = DXGI_FORMAT_R16_UINT; break;
-			case 4: dxgiFormat = DXGI_FORMAT_R32_UINT; break;
-			default: NOT_IMPLEMENTED;
+				dsDesc = m_State.DepthStencil->DSV.GetCPUHandle();
+				dsDescPtr = &dsDesc;
 			}
 
-			GFX::Cmd::AddResourceTransition(barriers, state.IndexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
-			D3D12_INDEX_BUFFER_VIEW ibv = { state.IndexBuffer->GPUAddress, (uint32_t)state.IndexBuffer->ByteSize, dxgiFormat };
-			cmdList->IASetIndexBuffer(&ibv);
+			m_CmdList->OMSetRenderTargets((UINT) rtDescs.size(), rtDescs.empty() ? nullptr : rtDescs.data(), false, dsDescPtr);
+		}
+
+		void SetViewport() override
+		{
+			D3D12_VIEWPORT viewport;
+			D3D12_RECT scissor;
+			GetViewportAndScissor(m_State, viewport, scissor);
+			m_CmdList->RSSetViewports(1, &viewport);
+			m_CmdList->RSSetScissorRects(1, &scissor);
+		}
+
+		void SetStencilRef() override
+		{
+			m_CmdList->OMSetStencilRef(m_State.StencilRef);
+		}
+
+		void SetPrimitiveTopology() override
+		{
+			m_CmdList->IASetPrimitiveTopology(ToPrimitiveTopology(m_State.PrimitiveType, m_State.NumControlPoints));
 		}
+
+		void SetVertexBuffers() override
+		{
+			std::vector<D3D12_VERTEX_BUFFER_VIEW> views;
+			views.reserve(m_State.VertexBuffers.size());
+			for (Buffer* buffer : m_State.VertexBuffers) views.push_back({ buffer->GPUAddress, (uint32_t)buffer->ByteSize, (uint32_t)buffer->Stride });
+			m_CmdList->IASetVertexBuffers(0, (UINT) views.size(), views.data());
+		}
+
+		void SetIndexBuffer() override
+		{
+			const D3D12_INDEX_BUFFER_VIEW ibv = GetIndexBufferView(m_State.IndexBuffer);
+			m_CmdList->IASetIndexBuffer(&ibv);
+		}
+
+	private:
+		void BindTable(uint32_t rootParameter, const DescriptorAllocation& descriptorTable)
+		{
+			if (m_TrackedState.Compute) m_CmdList->SetComputeRootDescriptorTable(rootParameter, descriptorTable.GetGPUHandle());
+			else m_CmdList->SetGraphicsRootDescriptorTable(rootParameter, descriptorTable.GetGPUHandle());
+		}
+
+		GraphicsContext& m_Context;
+		const GraphicsState& m_State;
+		const BindingLayout& m_BindingLayout;
+		const StateTracker::State& m_TrackedState;
+		ID3D12GraphicsCommandList* m_CmdList;
+	};
+}
+
+ID3D12CommandSignature* GraphicsContext::ApplyState(const GraphicsState& state)
+{
+	PROFILE_SECTION(*this, "ApplyState");
+
+	const bool useCompute = state.ShaderStages & CS;
+	const BindingLayout bindingLayout = GetBindingLayout(state);
+	const bool global = GlobalRootSignature::Fits(bindingLayout);
+
+	StateTracker::State trackedState;
+	trackedState.Compute = useCompute;
+	trackedState.RootSignature = GetRootSignatureHash(bindingLayout);
+	trackedState.PipelineState = CalcPipelineKey(state, trackedState.RootSignature);
+
+	// Shader of the bound pipeline was already resolved
+	BoundState.ShaderPending = SkipPendingShaders && !BoundState.Tracker.IsPipelineStateBound(trackedState.PipelineState) && GFX::IsShaderCompilePending(state.Shader, state.ShaderConfig, state.ShaderStages);
+	if (BoundState.ShaderPending) return nullptr;
+
+	ASSERT(state.BindlessTables.size() <= StateTracker::MAX_DESCRIPTOR_TABLES - StateTracker::FIRST_BINDLESS_TABLE, "Too many bindless tables");
+	trackedState.DescriptorTables[CBVTable] = GetDescriptorTableKey(state.Table.CBVs, BindingType::CBV, global);
+	trackedState.DescriptorTables[SRVTable] = GetDescriptorTableKey(state.Table.SRVs, BindingType::SRV, global);
+	trackedState.DescriptorTables[UAVTable] = GetDescriptorTableKey(state.Table.UAVs, BindingType::UAV, global);
+	trackedState.DescriptorTables[SamplerTable] = GetSamplerTableKey(state.Table.SMPs, global);
+	for (uint32_t i = 0; i < state.BindlessTables.size(); i++)
+	{
+		trackedState.DescriptorTables[StateTracker::FIRST_BINDLESS_TABLE + i] = Hash::XXHash64(state.BindlessTables[i].DescriptorTable.GetGPUHandle().ptr);
 	}
 
-	// Setup descriptor tables
+	std::vector<D3D12_RESOURCE_BARRIER>& barriers = PendingBarriers;
+	barriers.clear();
+
+	if (!useCompute)
 	{
-		std::vector<DescriptorAllocation> descriptorTables;
-		
-		if (!state.Table.CBVs.empty()) descriptorTables.push_back(CreateDescriptorTable(*this, state.Table.CBVs, BindingType::CBV));
-		if (!state.Table.SRVs.empty()) descriptorTables.push_back(CreateDescriptorTable(*this, state.Table.SRVs, BindingType::SRV));
-		if (!state.Table.UAVs.empty()) descriptorTables.push_back(CreateDescriptorTable(*this, state.Table.UAVs, BindingType::UAV));
+		uint64_t renderTargetsKey = Hash::XXHash64(state.RenderTargets.size());
+		for (Texture* rt : state.RenderTargets)
+		{
+			ASSERT(TestFlag(rt->CreationFlags, RCF::RTV), "Texture must have RCF_Bind_RTV in order to be used as a render target!");
+			GFX::Cmd::AddResourceTransition(barriers, rt, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			renderTargetsKey = Hash::XXHash64(renderTargetsKey, rt->RTV.GetCPUHandle().ptr);
+		}
 
-		if (!state.Table.SMPs.empty())
+		if (state.DepthStencil)
 		{
-			const uint32_t samplerTableIndex = (uint32_t) descriptorTables.size();
-			descriptorTables.push_back(deviceMemory.SMPHeapGPU->AllocateTransient(state.Table.SMPs.size()));
+			ASSERT(TestFlag(state.DepthStencil->CreationFlags, RCF::DSV), "Texture must have RCF_Bind_DSV in order to be used as a depth stencil!");
+			GFX::Cmd::AddResourceTransition(barriers, state.DepthStencil, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+			renderTargetsKey = Hash::XXHash64(renderTargetsKey, state.DepthStencil->DSV.GetCPUHandle().ptr);
+		}
+		trackedState.RenderTargets = renderTargetsKey;
+
+		D3D12_VIEWPORT viewport;
+		D3D12_RECT scissor;
+		GetViewportAndScissor(state, viewport, scissor);
+		trackedState.Viewport = Hash::XXHash64(Hash::XXHash64(viewport), scissor);
+		trackedState.StencilRef = Hash::XXHash64(state.StencilRef);
+		trackedState.PrimitiveTopology = Hash::XXHash64(ToPrimitiveTopology(state.PrimitiveType, state.NumControlPoints));
 
-			for (size_t i = 0; i < state.Table.SMPs.size(); i++)
+		if (!state.VertexBuffers.empty())
+		{
+			uint64_t vertexBuffersKey = Hash::XXHash64(state.VertexBuffers.size());
+			for (Buffer* buffer : state.VertexBuffers)
 			{
-				const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = GetSamplerDescriptor(*this, state.Table.SMPs[i]);
-				const D3D12_CPU_DESCRIPTOR_HANDLE dstDescriptor = descriptorTables[samplerTableIndex].GetCPUHandle(i);
-				Device::Get()->GetHandle()->CopyDescriptorsSimple(1, dstDescriptor, srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+				GFX::Cmd::AddResourceTransition(barriers, buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+				vertexBuffersKey = Hash::XXHash64(vertexBuffersKey, D3D12_VERTEX_BUFFER_VIEW{ buffer->GPUAddress, (uint32_t)buffer->ByteSize, (uint32_t)buffer->Stride });
 			}
+			trackedState.VertexBuffers = vertexBuffersKey;
 		}
 
-		for (const BindlessTable& table : state.BindlessTables)
+		if (state.IndexBuffer)
 		{
-			descriptorTables.push_back(table.DescriptorTable);
+			GFX::Cmd::AddResourceTransition(barriers, state.IndexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+			trackedState.IndexBuffer = Hash::XXHash64(GetIndexBufferView(state.IndexBuffer));
 		}
+	}
 
-		// Add resource transitions
-		for (Resource* bind : state.Table.CBVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_GENERIC_READ);
-		for (Resource* bind : state.Table.SRVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		for (Resource* bind : state.Table.UAVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	// Resource states change outside of ApplyState, the transitions are checked even if the bindings didn't change
+	for (Resource* bind : state.Table.CBVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_GENERIC_READ);
+	for (Resource* bind : state.Table.SRVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	for (Resource* bind : state.Table.UAVs) GFX::Cmd::AddResourceTransition(barriers, bind, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
-		// Bind to root table
-		uint32_t nextSlot = state.PushConstantCount > 0 ? 1 : 0;
-		for (const DescriptorAllocation& descriptorTable : descriptorTables)
-		{
-			const D3D12_GPU_DESCRIPTOR_HANDLE descriptorHandle = descriptorTable.GetGPUHandle();
-			if (useCompute) cmdList->SetComputeRootDescriptorTable(nextSlot++, descriptorHandle);
-			else cmdList->SetGraphicsRootDescriptorTable(nextSlot++, descriptorHandle);
-		}
-	}
+	ApplyStateSink sink{ *this, state, bindingLayout, trackedState };
+	BoundState.Tracker.Apply(trackedState, sink);
 
 	// Execute pending barriers
 	{
 		if (!barriers.empty())
 		{
-			cmdList->ResourceBarrier((UINT) barriers.size(), barriers.data());
+			CmdList->ResourceBarrier((UINT) barriers.size(), barriers.data());
 		}
 	}
 
-	// Create command signature
+	// Command signature
 	ID3D12CommandSignature* commandSignature = nullptr;
 	if (state.CommandSignature.ByteStride != 0)
 	{
-		// TODO: Cache signatures
-		ID3D12RootSignature* rootSig = nullptr;
-		if (state.CommandSignature.NumArgumentDescs > 1) rootSig = rootSignature;
-		API_CALL(Device::Get()->GetHandle()->CreateCommandSignature(&state.CommandSignature, rootSig, IID_PPV_ARGS(&commandSignature)));
-		GFX::Cmd::Delete(*this, commandSignature);
+		commandSignature = ContextManager::Get().Signatures.GetCommandSignature(SignatureFactory, GetIndirectLayout(state.CommandSignature), BoundState.RootSignature).Get();
 	}
 	return commandSignature;
 }
@@ -596,19 +880,19 @@ GraphicsContext::~GraphicsContext()
 	GFX::Cmd::WaitToFinish(*this);
 }
 
-static uint32_t GetHash(const StagingResourcesContext::StagingTextureRequest& request)
+static uint64_t GetHash(const StagingResourcesContext::StagingTextureRequest& request)
 {
-	uint32_t h = Hash::Crc32(request.Width);
-	h = Hash::Crc32(h, request.Height);
-	h = Hash::Crc32(h, request.NumMips);
-	h = Hash::Crc32(h, request.CreationFlags);
-	h = Hash::Crc32(h, request.Format);
+	uint64_t h = Hash::XXHash64(request.Width);
+	h = Hash::XXHash64(h, request.Height);
+	h = Hash::XXHash64(h, request.NumMips);
+	h = Hash::XXHash64(h, request.CreationFlags);
+	h = Hash::XXHash64(h, request.Format);
 	return h;
 }
 
 StagingResourcesContext::StagingTexture* StagingResourcesContext::GetTransientTexture(const StagingTextureRequest& request)
 {
-	const uint32_t hash = GetHash(request);
+	const uint64_t hash = GetHash(request);
 
 	if (!m_TransientStagingTextures.contains(hash))
 	{
@@ -650,6 +934,7 @@ ContextManager::ContextManager()
 	for (uint32_t i = 0; i < Device::IN_FLIGHT_FRAME_COUNT; i++)
 	{
 		m_FrameContexts[i] = ScopedRef<GraphicsContext>(CreateGraphicsContext());
+		m_FrameContexts[i]->SkipPendingShaders = true;
 	}
 	m_CreationContext = ScopedRef<GraphicsContext>(CreateGraphicsContext());
 }
@@ -6,8 +6,11 @@
 #include "Render/RenderAPI.h"
 #include "Render/DescriptorHeap.h"
 #include "Render/Shader.h"
+#include "Render/SignatureCache.h"
+#include "Render/StateTracker.h"
 #include "Utility/MathUtility.h"
 #include "Utility/Multithreading.h"
+#include "Utility/ConcurrentCache.h"
 #include "System/ApplicationConfiguration.h"
 
 enum class RCF : uint64_t;
@@ -127,7 +130,7 @@ struct GraphicsState
 	// Shader
 	Shader* Shader = nullptr;
 	uint32_t ShaderStages = VS | PS;
-	std::vector<std::string> ShaderConfig = {};
+	ShaderPermutationKey ShaderConfig = 0; // Built with Shader::Permutations
 
 	// State
 	D3D12_BLEND_DESC BlendState;
@@ -171,13 +174,20 @@ public:
 	void ClearTransientTextures(GraphicsContext& context);
 
 private:
-	std::unordered_map<uint32_t, StagingTexture*> m_TransientStagingTextures;
+	std::unordered_map<uint64_t, StagingTexture*> m_TransientStagingTextures;
 };
 
+using D3D12SignatureCache = SignatureCache<ComPtr<ID3D12RootSignature>, ComPtr<ID3D12CommandSignature>>;
+
 struct BoundGraphicsState
 {
-	bool Valid = false;
-	uint32_t PSOHash = 0;
+	StateTracker Tracker;
+
+	// Root signature of the last applied state, stays bound while the tracker skips it
+	D3D12SignatureCache::Selection RootSignature;
+
+	// Last applied state was skipped, draws and dispatches are dropped until the next ApplyState
+	bool ShaderPending = false;
 };
 
 struct GraphicsContext
@@ -186,6 +196,10 @@ struct GraphicsContext
 	ID3D12CommandSignature* ApplyState(const GraphicsState& state);
 
 	bool Closed = false;
+
+	// Frame contexts skip the work that needs the shader still compiled by the warm-up, other contexts wait for it
+	bool SkipPendingShaders = false;
+
 	ComPtr<ID3D12CommandAllocator> CmdAlloc;
 	ComPtr<ID3D12GraphicsCommandList> CmdList;
 	MemoryContext MemContext;
@@ -194,9 +208,13 @@ struct GraphicsContext
 	std::vector<ReadbackBuffer*> PendingReadbacks;
 
 	// Cache
-	std::unordered_map<uint32_t, ComPtr<ID3D12RootSignature>> RootSignatureCache;
-	std::unordered_map<uint32_t, ComPtr<ID3D12PipelineState>> PSOCache;
-	std::unordered_map<uint32_t, DescriptorAllocation> SamplerCache;
+	std::unordered_map<uint64_t, DescriptorAllocation> SamplerCache;
+
+	// Descriptor tables copied to the heap in this recording, looked up by the hash of their bindings
+	std::unordered_map<uint64_t, DescriptorAllocation> DescriptorTableCache;
+
+	// Reused by ApplyState to avoid the allocation on every call
+	std::vector<D3D12_RESOURCE_BARRIER> PendingBarriers;
 
 	StagingResourcesContext StagingResources;
 
@@ -226,6 +244,10 @@ public:
 
 	GraphicsContext& CreateWorkerContext();
 	GraphicsContext& GetCreationContext() const { return *m_CreationContext; }
+
+	// Shared by all contexts, signatures and PSOs don't depend on the command list that created them
+	D3D12SignatureCache Signatures;
+	MTR::ConcurrentCache<ComPtr<ID3D12PipelineState>> PSOCache;
 private:
 	MTR::Mutex m_CreationMutex;
 
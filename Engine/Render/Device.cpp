@@ -5,6 +5,7 @@
 #include "Render/Buffer.h"
 #include "Render/Shader.h"
 #include "Render/DescriptorHeap.h"
+#include "Render/PipelineLibrary.h"
 #include "Render/Resource.h"
 #include "Render/Texture.h"
 #include "Render/RenderThread.h"
@@ -62,6 +63,15 @@ void Device::InitDevice()
 	allocatorDesc.pAdapter = dxgiAdapter.Get();
 	API_CALL(D3D12MA::CreateAllocator(&allocatorDesc, &m_Allocator));
 
+	// Pipeline library
+	DXGI_ADAPTER_DESC1 adapterDesc{};
+	dxgiAdapter->GetDesc1(&adapterDesc);
+	LARGE_INTEGER driverVersion{};
+	dxgiAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+	const PipelineLibraryCache::AdapterID adapterID{ adapterDesc.VendorId, adapterDesc.DeviceId, adapterDesc.SubSysId, adapterDesc.Revision, (uint64_t) driverVersion.QuadPart };
+	m_PipelineLibrary = ScopedRef<PipelineLibrary>(new PipelineLibrary{ m_Handle.Get(), adapterID });
+	m_PipelineLibrary->Load();
+
 	// Command queue
 	D3D12_COMMAND_QUEUE_DESC queueDesc{};
 	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
@@ -85,6 +95,7 @@ void Device::InitDevice()
 	m_Memory.SMPHeap = ScopedRef<DescriptorHeap>(new DescriptorHeap{false,  D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 256u });
 	m_Memory.SRVHeapGPU = ScopedRef<DescriptorHeap>(new DescriptorHeap{ true, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64u * 1024, 256u * 1024u });
 	m_Memory.SMPHeapGPU = ScopedRef<DescriptorHeap>(new DescriptorHeap{ true, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 256u,  1024u });
+	CreateNullDescriptors();
 
 	// Create swapchain
 	DXGI_SWAP_CHAIN_DESC desc;
@@ -113,6 +124,8 @@ void Device::InitDevice()
 
 void Device::DeinitDevice()
 {
+	m_PipelineLibrary->Save();
+
 	ContextManager::Get().Destroy();
 
 	for (uint32_t i = 0; i < SWAPCHAIN_BUFFER_COUNT; i++)
@@ -122,9 +135,44 @@ void Device::DeinitDevice()
 
 	m_DXGIFactory = nullptr;
 	m_Allocator = nullptr;
+	m_PipelineLibrary = nullptr;
 	m_Handle = nullptr;
 }
 
+void Device::CreateNullDescriptors()
+{
+	m_Memory.NullCBVs = m_Memory.SRVHeap->Allocate(GlobalRootSignature::CBV_COUNT);
+	m_Memory.NullSRVs = m_Memory.SRVHeap->Allocate(GlobalRootSignature::SRV_COUNT);
+	m_Memory.NullUAVs = m_Memory.SRVHeap->Allocate(GlobalRootSignature::UAV_COUNT);
+	m_Memory.NullSamplers = m_Memory.SMPHeap->Allocate(GlobalRootSignature::SAMPLER_COUNT);
+
+	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc{};
+	cbvDesc.BufferLocation = 0;
+	cbvDesc.SizeInBytes = 0;
+	for (uint32_t i = 0; i < GlobalRootSignature::CBV_COUNT; i++) m_Handle->CreateConstantBufferView(&cbvDesc, m_Memory.NullCBVs.GetCPUHandle(i));
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MipLevels = 1;
+	for (uint32_t i = 0; i < GlobalRootSignature::SRV_COUNT; i++) m_Handle->CreateShaderResourceView(nullptr, &srvDesc, m_Memory.NullSRVs.GetCPUHandle(i));
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	for (uint32_t i = 0; i < GlobalRootSignature::UAV_COUNT; i++) m_Handle->CreateUnorderedAccessView(nullptr, nullptr, &uavDesc, m_Memory.NullUAVs.GetCPUHandle(i));
+
+	D3D12_SAMPLER_DESC samplerDesc{};
+	samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+	samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+	samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
+	for (uint32_t i = 0; i < GlobalRootSignature::SAMPLER_COUNT; i++) m_Handle->CreateSampler(&samplerDesc, m_Memory.NullSamplers.GetCPUHandle(i));
+}
+
 void Device::RecreateSwapchain(GraphicsContext& context)
 {
 	PROFILE_SECTION_CPU("RecreateSwapchain");
@@ -173,6 +221,9 @@ void Device::BindSwapchainToRenderTarget(GraphicsContext& context)
 	context.CmdList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
 	context.CmdList->RSSetViewports(1, &viewport);
 	context.CmdList->RSSetScissorRects(1, &scissor);
+
+	// Render target and viewport are set outside of ApplyState
+	context.BoundState.Tracker.Invalidate();
 }
 
 void Device::CopyToSwapchain(GraphicsContext& context, Texture* texture)
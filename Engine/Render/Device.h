@@ -4,9 +4,10 @@
 
 #include "Common.h"
 #include "Render/RenderAPI.h"
+#include "Render/DescriptorHeap.h"
 
 class RenderTask;
-class DescriptorHeap;
+class PipelineLibrary;
 struct GraphicsContext;
 struct Texture;
 struct Shader;
@@ -27,6 +28,12 @@ struct DeviceMemory
 
 	ScopedRef<DescriptorHeap> SRVHeapGPU;
 	ScopedRef<DescriptorHeap> SMPHeapGPU;
+
+	// Fill the unbound registers of the global root signature tables
+	DescriptorAllocation NullCBVs;
+	DescriptorAllocation NullSRVs;
+	DescriptorAllocation NullUAVs;
+	DescriptorAllocation NullSamplers;
 };
 
 class DeferredTaskExecutor
@@ -64,6 +71,7 @@ private:
 	~Device();
 	void InitDevice();
 	void DeinitDevice();
+	void CreateNullDescriptors();
 
 public:
 	void RecreateSwapchain(GraphicsContext& context);
@@ -77,6 +85,7 @@ public:
 	DeviceMemory& GetMemory() { return m_Memory; }
 	DeferredTaskExecutor& GetTaskExecutor() { return m_TaskExecutor; }
 	ID3D12CommandQueue* GetCommandQueue() const { return m_CommandQueue.Get(); }
+	PipelineLibrary* GetPipelineLibrary() const { return m_PipelineLibrary.get(); }
 
 private:
 	DeviceSpecification m_Specification;
@@ -84,6 +93,7 @@ private:
 	ComPtr<IDXGIFactory4> m_DXGIFactory;
 	ComPtr<ID3D12Device> m_Handle;
 	ComPtr<D3D12MA::Allocator> m_Allocator;
+	ScopedRef<PipelineLibrary> m_PipelineLibrary;
 
 	ComPtr<ID3D12CommandQueue> m_CommandQueue;
 	ComPtr<IDXGISwapChain> m_SwapchainHandle;
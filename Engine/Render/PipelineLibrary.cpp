@@ -0,0 +1,117 @@
+#include "PipelineLibrary.h"
+
+#include <cwchar>
+
+static std::wstring GetPipelineName(uint64_t stateHash)
+{
+	wchar_t name[17];
+	swprintf(name, 17, L"%016llx", (unsigned long long) stateHash);
+	return name;
+}
+
+PipelineLibrary::PipelineLibrary(ID3D12Device* device, const PipelineLibraryCache::AdapterID& adapter) :
+	m_Handle(device),
+	m_Cache(*this, adapter)
+{
+	if (FAILED(device->QueryInterface(IID_PPV_ARGS(m_Device.GetAddressOf()))) || !Create({}))
+	{
+		std::cout << "Pipeline libraries are not supported, pipelines are created on every launch" << std::endl;
+		m_Device = nullptr;
+		m_Library = nullptr;
+	}
+}
+
+void PipelineLibrary::Load()
+{
+	if (!m_Device) return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Cache.Load(PipelineLibraryCache::DEFAULT_PATH))
+	{
+		std::cout << "Loaded pipeline library with " << m_Cache.GetNumEntries() << " pipelines" << std::endl;
+	}
+}
+
+void PipelineLibrary::Save()
+{
+	if (!m_Device) return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Cache.Save(PipelineLibraryCache::DEFAULT_PATH);
+}
+
+ComPtr<ID3D12PipelineState> PipelineLibrary::CreatePipelineState(uint64_t stateHash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	return LoadOrCreate(stateHash,
+		[this, &desc](const std::wstring& name, ComPtr<ID3D12PipelineState>& pipelineState) { return m_Library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(pipelineState.GetAddressOf())); },
+		[&desc](ID3D12Device* device, ComPtr<ID3D12PipelineState>& pipelineState) { return device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pipelineState.GetAddressOf())); });
+}
+
+ComPtr<ID3D12PipelineState> PipelineLibrary::CreatePipelineState(uint64_t stateHash, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+	return LoadOrCreate(stateHash,
+		[this, &desc](const std::wstring& name, ComPtr<ID3D12PipelineState>& pipelineState) { return m_Library->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(pipelineState.GetAddressOf())); },
+		[&desc](ID3D12Device* device, ComPtr<ID3D12PipelineState>& pipelineState) { return device->CreateComputePipelineState(&desc, IID_PPV_ARGS(pipelineState.GetAddressOf())); });
+}
+
+template<typename LoadFunc, typename CreateFunc>
+ComPtr<ID3D12PipelineState> PipelineLibrary::LoadOrCreate(uint64_t stateHash, LoadFunc load, CreateFunc create)
+{
+	ComPtr<ID3D12PipelineState> pipelineState;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Library && m_Cache.Contains(stateHash) && SUCCEEDED(load(GetPipelineName(stateHash), pipelineState)))
+		{
+			m_Cache.MarkUsed(stateHash);
+			m_SessionPipelines[stateHash] = pipelineState;
+			return pipelineState;
+		}
+	}
+
+	// Compiling the pipeline is the slow part, other threads can use the library meanwhile
+	API_CALL(create(m_Handle.Get(), pipelineState));
+
+	if (m_Device && pipelineState)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_SessionPipelines[stateHash] = pipelineState;
+		m_Cache.Add(stateHash);
+	}
+	return pipelineState;
+}
+
+PipelineLibraryCache::Statistics PipelineLibrary::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Cache.GetStatistics();
+}
+
+bool PipelineLibrary::Create(const std::vector<uint8_t>& blob)
+{
+	m_Library = nullptr;
+	m_Blob = blob;
+
+	const HRESULT hr = m_Device->CreatePipelineLibrary(m_Blob.empty() ? nullptr : m_Blob.data(), m_Blob.size(), IID_PPV_ARGS(m_Library.GetAddressOf()));
+	if (FAILED(hr))
+	{
+		m_Library = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool PipelineLibrary::Store(uint64_t stateHash)
+{
+	const auto it = m_SessionPipelines.find(stateHash);
+	if (!m_Library || it == m_SessionPipelines.end()) return false;
+
+	return SUCCEEDED(m_Library->StorePipeline(GetPipelineName(stateHash).c_str(), it->second.Get()));
+}
+
+bool PipelineLibrary::Serialize(std::vector<uint8_t>& blob)
+{
+	if (!m_Library) return false;
+
+	blob.resize(m_Library->GetSerializedSize());
+	return SUCCEEDED(m_Library->Serialize(blob.data(), blob.size()));
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+#include "Render/RenderAPI.h"
+#include "Render/PipelineLibraryCache.h"
+
+// ID3D12PipelineLibrary that is kept on the disk, the pipelines created in the earlier launches are loaded instead of compiled
+// Bookkeeping of the file is in PipelineLibraryCache, this only talks to the driver
+class PipelineLibrary : public PipelineLibraryCache::Library
+{
+public:
+	PipelineLibrary(ID3D12Device* device, const PipelineLibraryCache::AdapterID& adapter);
+
+	void Load();
+	void Save();
+
+	// State hash has to be based on the content of the description, not on the pointers in it
+	// Thread safe, the pipelines are created outside of the lock
+	ComPtr<ID3D12PipelineState> CreatePipelineState(uint64_t stateHash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+	ComPtr<ID3D12PipelineState> CreatePipelineState(uint64_t stateHash, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+	PipelineLibraryCache::Statistics GetStatistics();
+
+	// PipelineLibraryCache::Library
+	bool Create(const std::vector<uint8_t>& blob) override;
+	bool Store(uint64_t stateHash) override;
+	bool Serialize(std::vector<uint8_t>& blob) override;
+
+private:
+	template<typename LoadFunc, typename CreateFunc>
+	ComPtr<ID3D12PipelineState> LoadOrCreate(uint64_t stateHash, LoadFunc load, CreateFunc create);
+
+	ComPtr<ID3D12Device> m_Handle;
+
+	// Null if the runtime doesn't support the pipeline libraries
+	ComPtr<ID3D12Device1> m_Device;
+	ComPtr<ID3D12PipelineLibrary> m_Library;
+
+	// Library reads from the blob it was created with for its whole lifetime
+	std::vector<uint8_t> m_Blob;
+
+	// Pipelines created in this launch, needed to store them again when the library is rebuilt
+	std::unordered_map<uint64_t, ComPtr<ID3D12PipelineState>> m_SessionPipelines;
+
+	std::mutex m_Mutex;
+	PipelineLibraryCache m_Cache;
+};
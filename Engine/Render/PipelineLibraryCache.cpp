@@ -0,0 +1,165 @@
+#include "PipelineLibraryCache.h"
+
+#include <iostream>
+
+#include "Utility/FileUtility.h"
+
+namespace
+{
+	constexpr uint32_t LIBRARY_MAGIC = 0x4C4F5350; // PSOL
+	constexpr uint32_t LIBRARY_VERSION = 1;
+}
+
+PipelineLibraryCache::PipelineLibraryCache(Library& library, const AdapterID& adapter, uint32_t maxUnusedLaunches) :
+	m_Library(library),
+	m_Adapter(adapter),
+	m_MaxUnusedLaunches(maxUnusedLaunches)
+{
+}
+
+bool PipelineLibraryCache::Load(const std::string& path)
+{
+	m_Entries.clear();
+	m_Launch = 0;
+	m_Dirty = false;
+
+	std::vector<uint8_t> fileContent;
+	const bool fileExists = FileUtility::ReadBinaryFile(path, fileContent);
+
+	FileUtility::BinaryReader reader{ fileContent };
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	AdapterID adapter{};
+	uint32_t launch = 0;
+	uint32_t numEntries = 0;
+	reader.Read(magic);
+	reader.Read(version);
+	reader.Read(adapter);
+	reader.Read(launch);
+	reader.Read(numEntries);
+
+	bool valid = fileExists && reader.IsValid() && magic == LIBRARY_MAGIC && version == LIBRARY_VERSION;
+	const bool sameAdapter = valid && adapter == m_Adapter;
+
+	std::unordered_map<uint64_t, Entry> entries;
+	for (uint32_t i = 0; i < numEntries && valid && reader.IsValid(); i++)
+	{
+		uint64_t stateHash = 0;
+		Entry entry{};
+		reader.Read(stateHash);
+		reader.Read(entry.LastUsedLaunch);
+		entries[stateHash] = entry;
+	}
+
+	uint64_t blobSize = 0;
+	std::vector<uint8_t> blob;
+	reader.Read(blobSize);
+	reader.ReadArray(blob, blobSize);
+	valid = valid && reader.IsValid() && reader.IsAtEnd();
+
+	if (fileExists && !valid)
+	{
+		std::cout << "Warning: Corrupted pipeline library: " << path << std::endl;
+	}
+	else if (valid && !sameAdapter)
+	{
+		std::cout << "Pipeline library was made for a different adapter or driver, it is discarded" << std::endl;
+		valid = false;
+	}
+	else if (valid && !m_Library.Create(blob))
+	{
+		std::cout << "Warning: Driver rejected the pipeline library: " << path << std::endl;
+		valid = false;
+	}
+
+	if (valid)
+	{
+		m_Entries = std::move(entries);
+		m_Launch = launch;
+	}
+	else
+	{
+		m_Library.Create({});
+
+		// Discarded file is overwritten on the next save even if nothing is added
+		m_Dirty = fileExists;
+	}
+
+	m_Launch++;
+	return valid;
+}
+
+bool PipelineLibraryCache::Save(const std::string& path)
+{
+	bool needsEviction = false;
+	for (const auto& [stateHash, entry] : m_Entries)
+	{
+		needsEviction = needsEviction || m_Launch - entry.LastUsedLaunch > m_MaxUnusedLaunches;
+	}
+
+	// Pipelines can't be removed from the library, the new one is made from the ones used in this launch
+	// Others that weren't used are dropped with the stale ones
+	if (needsEviction)
+	{
+		m_Library.Create({});
+
+		const uint32_t numEntries = (uint32_t) m_Entries.size();
+		std::erase_if(m_Entries, [this](const auto& entry) { return entry.second.LastUsedLaunch != m_Launch || !m_Library.Store(entry.first); });
+		m_Statistics.NumEvicted += numEntries - (uint32_t) m_Entries.size();
+		m_Dirty = true;
+	}
+
+	if (!m_Dirty) return true;
+
+	std::vector<uint8_t> blob;
+	if (!m_Library.Serialize(blob))
+	{
+		std::cout << "Warning: Failed to serialize the pipeline library" << std::endl;
+		return false;
+	}
+
+	FileUtility::BinaryWriter writer;
+	writer.Write(LIBRARY_MAGIC);
+	writer.Write(LIBRARY_VERSION);
+	writer.Write(m_Adapter);
+	writer.Write(m_Launch);
+	writer.Write((uint32_t) m_Entries.size());
+	for (const auto& [stateHash, entry] : m_Entries)
+	{
+		writer.Write(stateHash);
+		writer.Write(entry.LastUsedLaunch);
+	}
+	writer.Write((uint64_t) blob.size());
+	writer.WriteArray(blob);
+
+	if (!FileUtility::WriteBinaryFile(path, writer.GetData().data(), writer.GetData().size()))
+	{
+		std::cout << "Warning: Failed to write pipeline library: " << path << std::endl;
+		return false;
+	}
+
+	m_Dirty = false;
+	return true;
+}
+
+void PipelineLibraryCache::MarkUsed(uint64_t stateHash)
+{
+	const auto it = m_Entries.find(stateHash);
+	if (it == m_Entries.end()) return;
+
+	m_Statistics.NumLoaded++;
+	if (it->second.LastUsedLaunch == m_Launch) return;
+
+	it->second.LastUsedLaunch = m_Launch;
+	m_Dirty = true;
+}
+
+void PipelineLibraryCache::Add(uint64_t stateHash)
+{
+	if (m_Entries.contains(stateHash) || !m_Library.Store(stateHash)) return;
+
+	m_Entries[stateHash].LastUsedLaunch = m_Launch;
+	m_Statistics.NumStored++;
+	m_Dirty = true;
+}
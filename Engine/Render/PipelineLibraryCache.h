@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Bookkeeping of the serialized pipeline library that is kept on the disk between launches
+// Doesn't depend on D3D12, the library itself is behind PipelineLibraryCache::Library so the format and the eviction can be used with a mock
+class PipelineLibraryCache
+{
+public:
+	static constexpr const char* DEFAULT_PATH = "Cache/PipelineLibrary.bin";
+
+	// Serialized pipelines are only valid for the same adapter and driver
+	struct AdapterID
+	{
+		uint32_t VendorID = 0;
+		uint32_t DeviceID = 0;
+		uint32_t SubSysID = 0;
+		uint32_t Revision = 0;
+		uint64_t DriverVersion = 0;
+
+		bool operator==(const AdapterID& other) const = default;
+	};
+
+	// Pipelines are named by the PSO state hash, same as the one used by the in memory PSO cache
+	class Library
+	{
+	public:
+		virtual ~Library() = default;
+
+		// Replaces the library, empty blob creates the empty one
+		// Returns false if the driver rejects the blob
+		virtual bool Create(const std::vector<uint8_t>& blob) = 0;
+
+		// Pipeline has to be created during this launch
+		virtual bool Store(uint64_t stateHash) = 0;
+
+		virtual bool Serialize(std::vector<uint8_t>& blob) = 0;
+	};
+
+	struct Statistics
+	{
+		uint32_t NumLoaded = 0;
+		uint32_t NumStored = 0;
+		uint32_t NumEvicted = 0;
+	};
+
+	// Pipeline that isn't used for this many launches is dropped on the next save
+	PipelineLibraryCache(Library& library, const AdapterID& adapter, uint32_t maxUnusedLaunches = 8);
+
+	// Starts with the empty library if the file doesn't exist, is corrupted, is made for the other adapter or driver, or the driver rejects it
+	// Returns true if the file was used
+	bool Load(const std::string& path);
+
+	// Evicts the pipelines unused for too long, writes only if something changed
+	bool Save(const std::string& path);
+
+	bool Contains(uint64_t stateHash) const { return m_Entries.contains(stateHash); }
+
+	// Pipeline was loaded from the library
+	void MarkUsed(uint64_t stateHash);
+
+	// Pipeline was created and has to be stored in the library
+	void Add(uint64_t stateHash);
+
+	const Statistics& GetStatistics() const { return m_Statistics; }
+	uint32_t GetNumEntries() const { return (uint32_t) m_Entries.size(); }
+
+private:
+	struct Entry
+	{
+		uint32_t LastUsedLaunch = 0;
+	};
+
+	Library& m_Library;
+	AdapterID m_Adapter;
+	uint32_t m_MaxUnusedLaunches;
+
+	uint32_t m_Launch = 0;
+	bool m_Dirty = false;
+	std::unordered_map<uint64_t, Entry> m_Entries;
+	Statistics m_Statistics;
+};
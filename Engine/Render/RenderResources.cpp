@@ -11,7 +11,7 @@ namespace GFX
 
 	void InitRenderingResources(GraphicsContext& context)
 	{
-		RenderResources.CopyShader = ScopedRef<Shader>(new Shader{ "Engine/Render/copy.hlsl" });
+		RenderResources.CopyShader = ScopedRef<Shader>(new Shader{ *ShaderManifest::Find(ShaderManifest::GetEngineShaders(), "Engine/Render/copy.hlsl") });
 
 		struct FCVert
 		{
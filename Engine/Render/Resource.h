@@ -116,7 +116,7 @@ struct Resource
 	DescriptorAllocation RTV;
 	DescriptorAllocation DSV;
 
-	std::unordered_map<uint32_t, SubResource> Subresources;
+	std::unordered_map<uint64_t, SubResource> Subresources;
 
 #ifdef DEBUG
 	std::string DebugName = "Unknown Resource";
@@ -5,17 +5,27 @@
 #include <dxc/hlsl/DxilContainer.h>
 
 #include <set>
+#include <mutex>
+#include <atomic>
 #include <fstream>
 #include <d3d12shader.h>
 
 #include "Render/Device.h"
+#include "Render/ShaderCache.h"
+#include "Render/ShaderDependencyGraph.h"
+#include "Render/ShaderWarmup.h"
 #include "Utility/StringUtility.h"
 #include "Utility/PathUtility.h"
 #include "Utility/Hash.h"
 
 namespace GFX
 {
-	static uint32_t FailedShaderCount = 0;
+	static std::atomic<uint32_t> FailedShaderCount = 0;
+
+	// Guards Shader::Implementations and the dependency graph, the warm-up threads add to them while the render thread reads
+	static std::mutex ImplementationsMutex;
+	static ScopedRef<ShaderWarmup> Warmup;
+	static ShaderDependencyGraph DependencyGraph;
 
 	namespace ShaderCompiler
 	{
@@ -26,9 +36,26 @@ namespace GFX
 			ComPtr<IDxcIncludeHandler> IncludeHandler;
 		};
 
-		DXCCompiler Compiler;
+		// Compiler instance can't be used from multiple threads at once, every thread that compiles gets its own
+		thread_local DXCCompiler Compiler;
+		std::string CompilerVersion;
+
+		// Built offline by Tools/ShaderPrecompiler, read only after the init so the warm-up threads don't need a lock
+		ShaderCache::Archive PrecompiledArchive;
+		bool HasPrecompiledArchive = false;
+
+		DXCCompiler& GetCompiler()
+		{
+			if (!Compiler.Compiler)
+			{
+				API_CALL(DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(Compiler.Library.GetAddressOf())));
+				API_CALL(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(Compiler.Compiler.GetAddressOf())));
+				API_CALL(Compiler.Library->CreateIncludeHandler(&Compiler.IncludeHandler));
+			}
+			return Compiler;
+		}
 
-		DXGI_FORMAT ToDXGIFormat(D3D12_SIGNATURE_PARAMETER_DESC paramDesc)
+		DXGI_FORMAT ToDXGIFormat(const ShaderCache::InputParameter& paramDesc)
 		{
 			if (paramDesc.Mask == 1)
 			{
@@ -85,18 +112,20 @@ namespace GFX
 
 		IDxcOperationResult* DXC_Compile(const std::wstring& path, const std::wstring& entryPoint, const std::wstring& targetProfile, const std::vector<DxcDefine>& defines, bool& compilationSuccess)
 		{
+			DXCCompiler& compiler = GetCompiler();
+
 			ComPtr<IDxcBlobEncoding> sourceBlob;
 			uint32_t codePage = CP_UTF8;
-			API_CALL(Compiler.Library->CreateBlobFromFile(path.c_str(), &codePage, sourceBlob.GetAddressOf()));
+			API_CALL(compiler.Library->CreateBlobFromFile(path.c_str(), &codePage, sourceBlob.GetAddressOf()));
 
 			IDxcOperationResult* result;
 
-			HRESULT hr = Compiler.Compiler->Compile(
+			HRESULT hr = compiler.Compiler->Compile(
 				sourceBlob.Get(), path.c_str(),
 				entryPoint.c_str(), targetProfile.c_str(),
 				nullptr, 0,
 				defines.empty() ? nullptr : defines.data(), (UINT) defines.size(),
-				Compiler.IncludeHandler.Get(),
+				compiler.IncludeHandler.Get(),
 				&result);
 
 			compilationSuccess = compilationSuccess && SUCCEEDED(hr);
@@ -119,32 +148,62 @@ namespace GFX
 			return result;
 		}
 
-		std::vector<D3D12_INPUT_ELEMENT_DESC> DXC_CreateInputLayout(IDxcBlob* vsBlob, bool multiInput)
+		std::vector<ShaderCache::InputParameter> DXC_ReflectInputParameters(IDxcBlob* vsBlob)
 		{
-			std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout{};
+			std::vector<ShaderCache::InputParameter> inputParameters{};
 
-			ID3D12ShaderReflection* reflection;
+			ComPtr<ID3D12ShaderReflection> reflection;
 			ComPtr<IDxcContainerReflection> dxcReflection;
 			UINT32 shaderIdx;
 			API_CALL(DxcCreateInstance(CLSID_DxcContainerReflection, IID_PPV_ARGS(dxcReflection.GetAddressOf())));
 			API_CALL(dxcReflection->Load(vsBlob));
 			API_CALL(dxcReflection->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
-			API_CALL(dxcReflection->GetPartReflection(shaderIdx, __uuidof(ID3D12ShaderReflection), (void**)&reflection));
+			API_CALL(dxcReflection->GetPartReflection(shaderIdx, IID_PPV_ARGS(reflection.GetAddressOf())));
 
 			D3D12_SHADER_DESC desc{};
 			reflection->GetDesc(&desc);
 
-			bool lastPerInstance = false;
-			uint32_t multiSlotInputSlot = 0;
 			for (UINT i = 0; i < desc.InputParameters; i++)
 			{
 				D3D12_SIGNATURE_PARAMETER_DESC paramDesc;
 				reflection->GetInputParameterDesc(i, &paramDesc);
 
+				ShaderCache::InputParameter inputParameter{};
+				inputParameter.SemanticName = paramDesc.SemanticName;
+				inputParameter.SemanticIndex = paramDesc.SemanticIndex;
+				inputParameter.SystemValueType = (uint32_t) paramDesc.SystemValueType;
+				inputParameter.ComponentType = (uint32_t) paramDesc.ComponentType;
+				inputParameter.Mask = paramDesc.Mask;
+				inputParameters.push_back(inputParameter);
+			}
+
+			return inputParameters;
+		}
+
+		// Input element descs keep the pointer to the semantic name, names are stored here so they outlive both the reflection and the cache entry
+		const char* GetSemanticName(const std::string& name)
+		{
+			static std::mutex SemanticNamesMutex;
+			static std::set<std::string> SemanticNames;
+
+			std::lock_guard<std::mutex> lock(SemanticNamesMutex);
+			return SemanticNames.insert(name).first->c_str();
+		}
+
+		std::vector<D3D12_INPUT_ELEMENT_DESC> DXC_CreateInputLayout(const std::vector<ShaderCache::InputParameter>& inputParameters, bool multiInput)
+		{
+			std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout{};
+
+			bool lastPerInstance = false;
+			uint32_t multiSlotInputSlot = 0;
+			for (UINT i = 0; i < inputParameters.size(); i++)
+			{
+				const ShaderCache::InputParameter& paramDesc = inputParameters[i];
+
 				if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED) continue;
 
-				const bool perInstance = std::string(paramDesc.SemanticName).find("I_") == 0 ||
-					std::string(paramDesc.SemanticName).find("i_") == 0;
+				const bool perInstance = paramDesc.SemanticName.find("I_") == 0 ||
+					paramDesc.SemanticName.find("i_") == 0;
 
 				// If we have mixed inputs don't create single slot input layout
 				if (i > 0 && !multiInput && perInstance != lastPerInstance)
@@ -154,7 +213,7 @@ namespace GFX
 				}
 
 				D3D12_INPUT_ELEMENT_DESC inputElement{};
-				inputElement.SemanticName = paramDesc.SemanticName;
+				inputElement.SemanticName = GetSemanticName(paramDesc.SemanticName);
 				inputElement.SemanticIndex = paramDesc.SemanticIndex;
 				inputElement.Format = ToDXGIFormat(paramDesc);
 				inputElement.InputSlot = multiInput ? multiSlotInputSlot++ : 0;
@@ -166,16 +225,75 @@ namespace GFX
 				lastPerInstance = perInstance;
 			}
 
-			// TODO: FIgure out why engine crashes when we release reflection ?
-			// reflection->Release();
-
 			return inputLayout;
 		}
 
+		// Input parameters belong to the vertex shader, the other stages of the same shader must not overwrite them
+		ComPtr<IDxcBlob> CreateBlob(const std::string& entryPoint, ShaderCache::Entry& entry, std::vector<ShaderCache::InputParameter>& inputParameters)
+		{
+			ComPtr<IDxcBlobEncoding> blob;
+			API_CALL(GetCompiler().Library->CreateBlobWithEncodingOnHeapCopy(entry.Bytecode.data(), (UINT32) entry.Bytecode.size(), CP_ACP, blob.GetAddressOf()));
+			if (entryPoint == "VS") inputParameters = std::move(entry.InputParameters);
+			return blob;
+		}
+
+		// Loads the stage from the precompiled archive or the shader cache, otherwise compiles it and stores the result to the cache
+		// Files that the stage was made from are added to the dependencies, even if the compilation fails
+		ComPtr<IDxcBlob> CompileStage(const std::string& path, const std::string& entryPoint, const std::string& targetProfile, const std::vector<std::string>& defines, const std::vector<DxcDefine>& dxcDefines, std::vector<ShaderCache::InputParameter>& inputParameters, std::vector<ShaderCache::FileHash>& dependencies, bool& compilationSuccess)
+		{
+			// Sources are still hashed, entry for the changed source is skipped and the stage is compiled as usual
+			ShaderCache::Key archiveKey;
+			ShaderCache::Entry archiveEntry;
+			if (HasPrecompiledArchive && ShaderCache::CreateKey(path, defines, entryPoint, targetProfile, PrecompiledArchive.GetCompilerVersion(), archiveKey) && PrecompiledArchive.Find(archiveKey, archiveEntry))
+			{
+				dependencies.insert(dependencies.end(), archiveKey.Files.begin(), archiveKey.Files.end());
+				return CreateBlob(entryPoint, archiveEntry, inputParameters);
+			}
+
+			ShaderCache::Key cacheKey;
+			const bool useCache = ShaderCache::CreateKey(path, defines, entryPoint, targetProfile, CompilerVersion, cacheKey);
+			const std::string cachePath = useCache ? ShaderCache::GetCachePath(cacheKey) : "";
+
+			// Missing source is tracked too, it gets recompiled once it exists
+			if (useCache) dependencies.insert(dependencies.end(), cacheKey.Files.begin(), cacheKey.Files.end());
+			else dependencies.push_back(ShaderCache::FileHash{ path, 0 });
+
+			ShaderCache::Entry cacheEntry;
+			if (useCache && ShaderCache::Load(cachePath, cacheKey, cacheEntry))
+			{
+				return CreateBlob(entryPoint, cacheEntry, inputParameters);
+			}
+
+			bool stageSuccess = true;
+			ComPtr<IDxcOperationResult> result;
+			result.Attach(DXC_Compile(StringUtility::ToWideString(path), StringUtility::ToWideString(entryPoint), StringUtility::ToWideString(targetProfile), dxcDefines, stageSuccess));
+			compilationSuccess = compilationSuccess && stageSuccess;
+
+			ComPtr<IDxcBlob> shaderBlob;
+			if (!stageSuccess || FAILED(result->GetResult(shaderBlob.GetAddressOf())) || !shaderBlob) return nullptr;
+
+			if (entryPoint == "VS") inputParameters = DXC_ReflectInputParameters(shaderBlob.Get());
+
+			if (useCache)
+			{
+				const uint8_t* bytecode = (const uint8_t*) shaderBlob->GetBufferPointer();
+				cacheEntry.Bytecode.assign(bytecode, bytecode + shaderBlob->GetBufferSize());
+				if (entryPoint == "VS") cacheEntry.InputParameters = inputParameters;
+				ShaderCache::Store(cachePath, cacheKey, cacheEntry);
+			}
+
+			return shaderBlob;
+		}
+
+		D3D12_SHADER_BYTECODE ToBytecode(IDxcBlob* blob)
+		{
+			return blob ? D3D12_SHADER_BYTECODE{ blob->GetBufferPointer(), blob->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
+		}
+
 		// Returns true if compile success
-		bool CompileShader(const std::string path, const uint32_t creationFlags, const std::vector<std::string>& defines, CompiledShader& compiledShader)
+		bool CompileShader(const std::string path, const uint32_t creationFlags, const std::vector<std::string>& defines, CompiledShader& compiledShader, std::vector<ShaderCache::FileHash>& dependencies)
 		{
-			static const std::wstring SHADER_VERSION = L"6_0";
+			static const std::string SHADER_VERSION = "6_0";
 
 			std::vector<std::wstring> dxcDefinesW;
 			std::vector<DxcDefine> dxcDefines;
@@ -189,96 +307,203 @@ namespace GFX
 				dxcDefines[i].Value = 0;
 			}
 
-			const std::wstring wPath = StringUtility::ToWideString(path);
-
 			bool compilationSuccess = true;
+			std::vector<ShaderCache::InputParameter> inputParameters;
 			compiledShader.Data.resize(6);
-			compiledShader.Data[0] = creationFlags & VS ? DXC_Compile(wPath, L"VS", L"vs_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-			compiledShader.Data[1] = creationFlags & GS ? DXC_Compile(wPath, L"GS", L"gs_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-			compiledShader.Data[2] = creationFlags & HS ? DXC_Compile(wPath, L"HS", L"hs_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-			compiledShader.Data[3] = creationFlags & DS ? DXC_Compile(wPath, L"DS", L"ds_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-			compiledShader.Data[4] = creationFlags & PS ? DXC_Compile(wPath, L"PS", L"ps_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-			compiledShader.Data[5] = creationFlags & CS ? DXC_Compile(wPath, L"CS", L"cs_" + SHADER_VERSION, dxcDefines, compilationSuccess) : nullptr;
-
-			ComPtr<IDxcBlob> shaderBlobs[6];
-			for (uint32_t i = 0; i < 6; i++)
+			compiledShader.Data[0] = creationFlags & VS ? CompileStage(path, "VS", "vs_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+			compiledShader.Data[1] = creationFlags & GS ? CompileStage(path, "GS", "gs_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+			compiledShader.Data[2] = creationFlags & HS ? CompileStage(path, "HS", "hs_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+			compiledShader.Data[3] = creationFlags & DS ? CompileStage(path, "DS", "ds_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+			compiledShader.Data[4] = creationFlags & PS ? CompileStage(path, "PS", "ps_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+			compiledShader.Data[5] = creationFlags & CS ? CompileStage(path, "CS", "cs_" + SHADER_VERSION, defines, dxcDefines, inputParameters, dependencies, compilationSuccess) : nullptr;
+
+			compiledShader.Vertex = ToBytecode(compiledShader.Data[0].Get());
+			compiledShader.Geometry = ToBytecode(compiledShader.Data[1].Get());
+			compiledShader.Hull = ToBytecode(compiledShader.Data[2].Get());
+			compiledShader.Domain = ToBytecode(compiledShader.Data[3].Get());
+			compiledShader.Pixel = ToBytecode(compiledShader.Data[4].Get());
+			compiledShader.Compute = ToBytecode(compiledShader.Data[5].Get());
+
+			compiledShader.Hash = Hash::XXHash64(creationFlags);
+			for (const ComPtr<IDxcBlob>& stage : compiledShader.Data)
 			{
-				if (compiledShader.Data[i]) API_CALL(compiledShader.Data[i]->GetResult(shaderBlobs[i].GetAddressOf()));
+				if (stage) compiledShader.Hash = Hash::XXHash64((const uint8_t*) stage->GetBufferPointer(), stage->GetBufferSize(), compiledShader.Hash);
 			}
 
-			compiledShader.Vertex = shaderBlobs[0].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[0]->GetBufferPointer(), shaderBlobs[0]->GetBufferSize()} : D3D12_SHADER_BYTECODE{nullptr, 0};
-			compiledShader.Geometry = shaderBlobs[1].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[1]->GetBufferPointer(), shaderBlobs[1]->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
-			compiledShader.Hull = shaderBlobs[2].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[2]->GetBufferPointer(), shaderBlobs[2]->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
-			compiledShader.Domain = shaderBlobs[3].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[3]->GetBufferPointer(), shaderBlobs[3]->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
-			compiledShader.Pixel = shaderBlobs[4].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[4]->GetBufferPointer(), shaderBlobs[4]->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
-			compiledShader.Compute = shaderBlobs[5].Get() ? D3D12_SHADER_BYTECODE{ shaderBlobs[5]->GetBufferPointer(), shaderBlobs[5]->GetBufferSize() } : D3D12_SHADER_BYTECODE{ nullptr, 0 };
-
 			if (compiledShader.Vertex.BytecodeLength)
 			{
-				compiledShader.InputLayout = DXC_CreateInputLayout(shaderBlobs[0].Get(), false);
-				compiledShader.InputLayoutMultiInput = DXC_CreateInputLayout(shaderBlobs[0].Get(), true);
+				compiledShader.InputLayout = DXC_CreateInputLayout(inputParameters, false);
+				compiledShader.InputLayoutMultiInput = DXC_CreateInputLayout(inputParameters, true);
 			}
 
 			return compilationSuccess;
 		}
 	}
 
+	static uint64_t GetImplementationKey(ShaderPermutationKey permutation, uint32_t shaderStages)
+	{
+		return permutation | ((uint64_t) shaderStages << ShaderPermutationLayout::MAX_KEY_BITS);
+	}
+
+	// Called from the warm-up threads
+	static bool CompileImplementation(Shader* shader, uint64_t implementationKey)
+	{
+		const ShaderPermutationKey permutation = implementationKey & ((1ull << ShaderPermutationLayout::MAX_KEY_BITS) - 1);
+		const uint32_t shaderStages = (uint32_t) (implementationKey >> ShaderPermutationLayout::MAX_KEY_BITS);
+
+		CompiledShader compiledShader;
+		std::vector<ShaderCache::FileHash> dependencies;
+		const bool success = ShaderCompiler::CompileShader(shader->Path, shaderStages, shader->Permutations.GetDefines(permutation), compiledShader, dependencies);
+
+		std::lock_guard<std::mutex> lock(ImplementationsMutex);
+		DependencyGraph.SetDependencies({ shader, implementationKey }, dependencies);
+
+		// Failed hot reload keeps the old implementation
+		if (!success)
+		{
+			FailedShaderCount++;
+			return false;
+		}
+
+		std::shared_ptr<const CompiledShader> implementation = std::make_shared<const CompiledShader>(std::move(compiledShader));
+		if (shader->Implementations.contains(implementationKey)) shader->RecompiledImplementations[implementationKey] = std::move(implementation);
+		else shader->Implementations.try_emplace(implementationKey, std::move(implementation));
+		return true;
+	}
+
 	void InitShaderCompiler()
 	{
 		using namespace ShaderCompiler;
 
-		API_CALL(DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(Compiler.Library.GetAddressOf())));
-		API_CALL(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(Compiler.Compiler.GetAddressOf())));
-		API_CALL(Compiler.Library->CreateIncludeHandler(&Compiler.IncludeHandler));
+		// Part of the shader cache key, new compiler invalidates the whole cache
+		CompilerVersion = "unknown";
+		ComPtr<IDxcVersionInfo> versionInfo;
+		if (SUCCEEDED(GetCompiler().Compiler.As(&versionInfo)))
+		{
+			UINT32 major = 0;
+			UINT32 minor = 0;
+			versionInfo->GetVersion(&major, &minor);
+			CompilerVersion = std::to_string(major) + "." + std::to_string(minor);
+
+			ComPtr<IDxcVersionInfo2> versionInfo2;
+			UINT32 commitCount = 0;
+			char* commitHash = nullptr;
+			if (SUCCEEDED(versionInfo.As(&versionInfo2)) && SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)))
+			{
+				CompilerVersion += "." + std::to_string(commitCount) + " " + commitHash;
+				CoTaskMemFree(commitHash);
+			}
+		}
+
+		HasPrecompiledArchive = PrecompiledArchive.Load(ShaderCache::Archive::DEFAULT_PATH);
+		if (HasPrecompiledArchive)
+		{
+			std::cout << "Loaded shader archive with " << PrecompiledArchive.GetNumEntries() << " stages, built with " << PrecompiledArchive.GetCompilerVersion() << std::endl;
+		}
+
+		// One core is left for the thread that loads the scene meanwhile
+		const uint32_t numWarmupThreads = MAX(std::thread::hardware_concurrency(), 2u) - 1;
+		Warmup = ScopedRef<ShaderWarmup>(new ShaderWarmup(CompileImplementation, numWarmupThreads));
 	}
 
 	void DestroyShaderCompiler()
 	{
 		using namespace ShaderCompiler;
 
+		// Warm-up threads release their compilers when they exit
+		Warmup = nullptr;
+
+		PrecompiledArchive = ShaderCache::Archive{};
+		HasPrecompiledArchive = false;
+
 		Compiler.Library = nullptr;
 		Compiler.Compiler = nullptr;
 		Compiler.IncludeHandler = nullptr;
 	}
 
-	static ShaderHash GetImlementationHash(const std::vector<std::string>& defines, uint32_t shaderStages)
+	void WarmUpShader(Shader* shader, ShaderPermutationKey permutation, uint32_t shaderStages)
 	{
-		// TODO: Sort defines so we don't make duplicates
-		std::string defAll = " ";
-		for (const std::string& def : defines) defAll += def;
-		if (shaderStages & VS) defAll += "VS";
-		if (shaderStages & HS) defAll += "HS";
-		if (shaderStages & DS) defAll += "DS";
-		if (shaderStages & GS) defAll += "GS";
-		if (shaderStages & PS) defAll += "PS";
-		if (shaderStages & CS) defAll += "CS";
-		return Hash::Crc32(defAll);
+		ASSERT(shader->Permutations.IsValid(permutation), "Invalid shader permutation!");
+
+		const uint64_t implHash = GetImplementationKey(permutation, shaderStages);
+		{
+			std::lock_guard<std::mutex> lock(ImplementationsMutex);
+			if (shader->Implementations.contains(implHash)) return;
+		}
+
+		if (Warmup) Warmup->Request(shader, implHash);
 	}
 
-	const CompiledShader& GetCompiledShader(Shader* shader, const std::vector<std::string>& defines, uint32_t shaderStages)
+	void WarmUpShader(Shader* shader)
 	{
-		const uint32_t implHash = GetImlementationHash(defines, shaderStages);
-		if (!shader->Implementations.contains(implHash))
+		for (const ShaderImplementationDesc& implementation : shader->DeclaredImplementations)
 		{
-			bool success = ShaderCompiler::CompileShader(shader->Path, shaderStages, defines, shader->Implementations[implHash]);
-			ASSERT(success, "Shader compilation failed!");
+			WarmUpShader(shader, implementation.Permutation, implementation.Stages);
 		}
+	}
+
+	void CancelShaderWarmup(Shader* shader)
+	{
+		if (Warmup) Warmup->Cancel(shader);
+	}
+
+	bool IsShaderCompilePending(Shader* shader, ShaderPermutationKey permutation, uint32_t shaderStages)
+	{
+		const uint64_t implHash = GetImplementationKey(permutation, shaderStages);
+		if (!Warmup || !Warmup->IsPending(shader, implHash)) return false;
+
+		// Hot reloaded implementation keeps using the old one meanwhile
+		std::lock_guard<std::mutex> lock(ImplementationsMutex);
+		return !shader->Implementations.contains(implHash);
+	}
 
-		CompiledShader& compiledShader = shader->Implementations.at(implHash);
-		if (compiledShader.NeedsRecompilation)
+	ShaderWarmup::Progress GetShaderWarmupProgress()
+	{
+		return Warmup ? Warmup->GetProgress() : ShaderWarmup::Progress{};
+	}
+
+	std::shared_ptr<const CompiledShader> GetCompiledShader(Shader* shader, ShaderPermutationKey permutation, uint32_t shaderStages)
+	{
+		ASSERT(shader->Permutations.IsValid(permutation), "Invalid shader permutation!");
+
+		const uint64_t implHash = GetImplementationKey(permutation, shaderStages);
+
+		// Copy of the pointer, the previous implementation lives until the last context using it releases it
+		const auto findImplementation = [&]() -> std::shared_ptr<const CompiledShader>
 		{
-			compiledShader.NeedsRecompilation = false;
+			std::lock_guard<std::mutex> lock(ImplementationsMutex);
 
-			CompiledShader recompiledShader;
-			bool success = ShaderCompiler::CompileShader(shader->Path, shaderStages, defines, recompiledShader);
-			if (success)
-			{
-				compiledShader = recompiledShader;
-			}
-			else
+			const auto recompiled = shader->RecompiledImplementations.find(implHash);
+			if (recompiled != shader->RecompiledImplementations.end())
 			{
-				FailedShaderCount++;
+				shader->Implementations[implHash] = std::move(recompiled->second);
+				shader->RecompiledImplementations.erase(recompiled);
 			}
+
+			const auto it = shader->Implementations.find(implHash);
+			return it != shader->Implementations.end() ? it->second : nullptr;
+		};
+
+		std::shared_ptr<const CompiledShader> compiledShader = findImplementation();
+
+		// Queued warm-up job is compiled right here instead of waiting for its turn
+		if (!compiledShader && Warmup)
+		{
+			Warmup->Wait(shader, implHash);
+			compiledShader = findImplementation();
+		}
+
+		// Implementation that wasn't declared for the warm-up
+		if (!compiledShader)
+		{
+			CompiledShader newShader;
+			std::vector<ShaderCache::FileHash> dependencies;
+			bool success = ShaderCompiler::CompileShader(shader->Path, shaderStages, shader->Permutations.GetDefines(permutation), newShader, dependencies);
+			ASSERT(success, "Shader compilation failed!");
+
+			std::lock_guard<std::mutex> lock(ImplementationsMutex);
+			DependencyGraph.SetDependencies({ shader, implHash }, dependencies);
+			compiledShader = shader->Implementations.try_emplace(implHash, std::make_shared<const CompiledShader>(std::move(newShader))).first->second;
 		}
 
 		return compiledShader;
@@ -287,16 +512,34 @@ namespace GFX
 	void ReloadAllShaders()
 	{
 		FailedShaderCount = 0;
+		if (!Warmup) return;
 
+		std::lock_guard<std::mutex> lock(ImplementationsMutex);
 		for (Shader* shader : Shader::AllShaders)
 		{
 			for (auto& it : shader->Implementations)
 			{
-				it.second.NeedsRecompilation = true;
+				Warmup->Recompile(shader, it.first);
 			}
 		}
 	}
 
+	uint32_t ReloadChangedShaders()
+	{
+		FailedShaderCount = 0;
+		if (!Warmup) return 0;
+
+		std::lock_guard<std::mutex> lock(ImplementationsMutex);
+		const std::vector<ShaderDependencyGraph::Implementation> changedImplementations = DependencyGraph.ScanForChanges();
+		for (const ShaderDependencyGraph::Implementation& implementation : changedImplementations)
+		{
+			Warmup->Recompile(implementation.first, implementation.second);
+		}
+
+		std::cout << "Shader reload: " << changedImplementations.size() << " implementations depend on the changed files" << std::endl;
+		return (uint32_t) changedImplementations.size();
+	}
+
 	uint32_t GetFailedShaderCount()
 	{
 		return FailedShaderCount;
@@ -304,3 +547,13 @@ namespace GFX
 }
 
 std::set<Shader*> Shader::AllShaders;
+
+Shader::~Shader()
+{
+	// Warm-up thread can still be compiling it
+	GFX::CancelShaderWarmup(this);
+	AllShaders.erase(this);
+
+	std::lock_guard<std::mutex> lock(GFX::ImplementationsMutex);
+	GFX::DependencyGraph.Remove(this);
+}
\ No newline at end of file
@@ -1,32 +1,21 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <set>
 
 // TODO: Move this to .cpp
 #include "REnder/RenderAPI.h"
+#include "Render/ShaderPermutation.h"
+#include "Render/ShaderManifest.h"
+#include "Render/ShaderWarmup.h"
 #include <dxcapi.h>
 
 struct D3D12_INPUT_ELEMENT_DESC;
 
-enum ShaderStage : uint8_t
-{
-	VS = 1 << 0,
-	GS = 1 << 1,
-	HS = 1 << 2,
-	DS = 1 << 3,
-	PS = 1 << 4,
-	CS = 1 << 5,
-	SHADER_STAGE_COUNT = 6
-};
-
-using ShaderHash = uint32_t;
-
 struct CompiledShader
 {
-	bool NeedsRecompilation = false;
-
 	D3D12_SHADER_BYTECODE Vertex;
 	D3D12_SHADER_BYTECODE Geometry;
 	D3D12_SHADER_BYTECODE Hull;
@@ -36,25 +25,41 @@ struct CompiledShader
 	std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayoutMultiInput;
 
-	std::vector<ComPtr<IDxcOperationResult>> Data;
+	// Owns the bytecode of the stages, either compiled or loaded from the shader cache
+	std::vector<ComPtr<IDxcBlob>> Data;
+
+	// Hash of the bytecode of all stages, stays the same between launches unlike the bytecode pointers
+	uint64_t Hash = 0;
 };
 
 struct Shader
 {
 	static std::set<Shader*> AllShaders;
 
-	Shader(std::string path) : Path(path) 
+	Shader(std::string path, ShaderPermutationLayout permutations = {}) : Path(path), Permutations(std::move(permutations))
 	{
 		AllShaders.insert(this);
 	}
 
-	~Shader()
+	Shader(const ShaderDeclaration& declaration) : Shader(declaration.Path, declaration.Permutations)
 	{
-		AllShaders.erase(this);
+		DeclaredImplementations = declaration.DeclaredImplementations;
 	}
 
+	~Shader();
+
 	std::string Path;
-	std::unordered_map<ShaderHash, CompiledShader> Implementations;
+	ShaderPermutationLayout Permutations;
+
+	// Compiled ahead of the first use by GFX::WarmUpShader
+	std::vector<ShaderImplementationDesc> DeclaredImplementations;
+
+	// Key is the permutation key with the shader stages in the top bits
+	// Shared so a context that got the implementation keeps it alive while the hot reload replaces it
+	std::unordered_map<uint64_t, std::shared_ptr<const CompiledShader>> Implementations;
+
+	// Recompiled in the background by the hot reload, GetCompiledShader swaps them in on the next request
+	std::unordered_map<uint64_t, std::shared_ptr<const CompiledShader>> RecompiledImplementations;
 };
 
 namespace GFX
@@ -62,8 +67,23 @@ namespace GFX
 	void InitShaderCompiler();
 	void DestroyShaderCompiler();
 
-	const CompiledShader& GetCompiledShader(Shader* shaderID, const std::vector<std::string>& defines, uint32_t shaderStages);
+	// Queues the implementation to be compiled on the warm-up threads, GetCompiledShader waits for it instead of compiling it again
+	void WarmUpShader(Shader* shader, ShaderPermutationKey permutation, uint32_t shaderStages);
+	void WarmUpShader(Shader* shader); // All declared implementations
+	void CancelShaderWarmup(Shader* shader);
+
+	// True while the warm-up didn't finish the implementation, GetCompiledShader would block on it
+	bool IsShaderCompilePending(Shader* shader, ShaderPermutationKey permutation, uint32_t shaderStages);
+	ShaderWarmup::Progress GetShaderWarmupProgress();
+
+	// Returned pointer stays valid after the implementation is replaced by the hot reload
+	std::shared_ptr<const CompiledShader> GetCompiledShader(Shader* shaderID, ShaderPermutationKey permutation, uint32_t shaderStages);
+
+	// Implementations are recompiled on the warm-up threads, the old ones are used until the new ones are ready
 	void ReloadAllShaders();
 
+	// Recompiles only the implementations that include a changed file, returns the number of them
+	uint32_t ReloadChangedShaders();
+
 	uint32_t GetFailedShaderCount();
 }
\ No newline at end of file
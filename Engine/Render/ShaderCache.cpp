@@ -0,0 +1,339 @@
+#include "ShaderCache.h"
+
+#include <set>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "Utility/FileUtility.h"
+#include "Utility/Hash.h"
+
+namespace GFX::ShaderCache
+{
+	namespace
+	{
+		constexpr uint32_t CACHE_MAGIC = 0x43444853; // SHDC
+		constexpr uint32_t CACHE_VERSION = 2;
+		constexpr uint32_t ARCHIVE_MAGIC = 0x41444853; // SHDA
+		constexpr uint32_t ARCHIVE_VERSION = 2;
+
+		// Shaders compiled on different threads can share the stage, reading the half written entry would look corrupted
+		std::mutex CacheFileMutex;
+
+		std::string NormalizePath(const std::filesystem::path& path)
+		{
+			return path.lexically_normal().generic_string();
+		}
+
+		// Returns the name from #include "name" or #include <name>, empty if the line isn't an include
+		std::string ParseInclude(const std::string& line)
+		{
+			size_t i = line.find_first_not_of(" \t");
+			if (i == std::string::npos || line[i] != '#') return "";
+
+			i = line.find_first_not_of(" \t", i + 1);
+			if (i == std::string::npos || line.compare(i, 7, "include") != 0) return "";
+
+			i = line.find_first_not_of(" \t", i + 7);
+			if (i == std::string::npos || (line[i] != '"' && line[i] != '<')) return "";
+
+			const char closing = line[i] == '"' ? '"' : '>';
+			const size_t end = line.find(closing, i + 1);
+			if (end == std::string::npos) return "";
+
+			return line.substr(i + 1, end - i - 1);
+		}
+
+		// Windows checkout has CRLF line endings, the archive built on Linux has to match it
+		bool ReadSourceFile(const std::string& path, std::vector<uint8_t>& content)
+		{
+			if (!FileUtility::ReadBinaryFile(path, content)) return false;
+			content.erase(std::remove(content.begin(), content.end(), (uint8_t) '\r'), content.end());
+			return true;
+		}
+
+		// Includes inside of the inactive preprocessor branches are hashed too, that only invalidates more than needed
+		void AppendFile(const std::string& path, std::set<std::string>& visitedFiles, std::string& description, std::vector<FileHash>& files)
+		{
+			if (visitedFiles.contains(path)) return;
+			visitedFiles.insert(path);
+
+			std::vector<uint8_t> content;
+			ReadSourceFile(path, content);
+
+			const uint64_t contentHash = Hash::XXHash64(content.data(), content.size());
+			files.push_back(FileHash{ path, contentHash });
+
+			std::stringstream ss;
+			ss << "file: " << path << " " << content.size() << " " << std::hex << contentHash << "\n";
+			description += ss.str();
+
+			const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+			std::istringstream lines(std::string(content.begin(), content.end()));
+			std::string line;
+			while (std::getline(lines, line))
+			{
+				const std::string includeName = ParseInclude(line);
+				if (includeName.empty()) continue;
+
+				const std::string relativeToFile = NormalizePath(directory / includeName);
+				const std::string relativeToWorkingDirectory = NormalizePath(includeName);
+				if (FileUtility::FileExists(relativeToFile))
+				{
+					AppendFile(relativeToFile, visitedFiles, description, files);
+				}
+				else if (FileUtility::FileExists(relativeToWorkingDirectory))
+				{
+					AppendFile(relativeToWorkingDirectory, visitedFiles, description, files);
+				}
+				else
+				{
+					// Include that starts to exist later changes the key
+					description += "missing: " + includeName + "\n";
+				}
+			}
+		}
+
+		void WriteString(FileUtility::BinaryWriter& writer, const std::string& value)
+		{
+			writer.Write((uint32_t) value.size());
+			writer.Write(value.data(), value.size());
+		}
+
+		bool ReadString(FileUtility::BinaryReader& reader, std::string& value)
+		{
+			uint32_t size = 0;
+			std::vector<char> characters;
+			if (!reader.Read(size) || !reader.ReadArray(characters, size)) return false;
+
+			value.assign(characters.begin(), characters.end());
+			return true;
+		}
+
+		void WriteInputParameters(FileUtility::BinaryWriter& writer, const std::vector<InputParameter>& inputParameters)
+		{
+			writer.Write((uint32_t) inputParameters.size());
+			for (const InputParameter& parameter : inputParameters)
+			{
+				WriteString(writer, parameter.SemanticName);
+				writer.Write(parameter.SemanticIndex);
+				writer.Write(parameter.SystemValueType);
+				writer.Write(parameter.ComponentType);
+				writer.Write(parameter.Mask);
+			}
+		}
+
+		void ReadInputParameters(FileUtility::BinaryReader& reader, std::vector<InputParameter>& inputParameters)
+		{
+			uint32_t numInputParameters = 0;
+			reader.Read(numInputParameters);
+			for (uint32_t i = 0; i < numInputParameters && reader.IsValid(); i++)
+			{
+				InputParameter parameter{};
+				ReadString(reader, parameter.SemanticName);
+				reader.Read(parameter.SemanticIndex);
+				reader.Read(parameter.SystemValueType);
+				reader.Read(parameter.ComponentType);
+				reader.Read(parameter.Mask);
+				inputParameters.push_back(parameter);
+			}
+		}
+	}
+
+	bool CreateKey(const std::string& path, const std::vector<std::string>& defines, const std::string& entryPoint, const std::string& targetProfile, const std::string& compilerVersion, Key& key)
+	{
+		const std::string sourcePath = NormalizePath(path);
+		if (!FileUtility::FileExists(sourcePath)) return false;
+
+		std::string description;
+		description += "compiler: " + compilerVersion + "\n";
+		description += "profile: " + targetProfile + "\n";
+		description += "entry: " + entryPoint + "\n";
+		for (const std::string& define : GetCanonicalDefines(defines)) description += "define: " + define + "\n";
+
+		std::set<std::string> visitedFiles;
+		std::vector<FileHash> files;
+		AppendFile(sourcePath, visitedFiles, description, files);
+
+		key.Hash = Hash::XXHash64(description);
+		key.Description = std::move(description);
+		key.Files = std::move(files);
+		return true;
+	}
+
+	uint64_t HashFile(const std::string& path)
+	{
+		std::vector<uint8_t> content;
+		if (!ReadSourceFile(NormalizePath(path), content)) return 0;
+		return Hash::XXHash64(content.data(), content.size());
+	}
+
+	std::vector<std::string> GetCanonicalDefines(const std::vector<std::string>& defines)
+	{
+		std::vector<std::string> canonicalDefines = defines;
+		std::sort(canonicalDefines.begin(), canonicalDefines.end());
+		canonicalDefines.erase(std::unique(canonicalDefines.begin(), canonicalDefines.end()), canonicalDefines.end());
+		return canonicalDefines;
+	}
+
+	std::string GetCachePath(const Key& key)
+	{
+		std::stringstream ss;
+		ss << "Cache/Shaders/" << std::hex << std::setw(16) << std::setfill('0') << key.Hash << ".bin";
+		return ss.str();
+	}
+
+	bool Load(const std::string& cachePath, const Key& key, Entry& entry)
+	{
+		std::vector<uint8_t> fileContent;
+		{
+			std::lock_guard<std::mutex> lock(CacheFileMutex);
+			if (!FileUtility::ReadBinaryFile(cachePath, fileContent)) return false;
+		}
+
+		FileUtility::BinaryReader reader{ fileContent };
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		std::string description;
+		if (!reader.Read(magic) || !reader.Read(version) || magic != CACHE_MAGIC || version != CACHE_VERSION) return false;
+		if (!ReadString(reader, description) || description != key.Description) return false;
+
+		Entry cached{};
+		uint32_t bytecodeSize = 0;
+		reader.Read(bytecodeSize);
+		reader.ReadArray(cached.Bytecode, bytecodeSize);
+		ReadInputParameters(reader, cached.InputParameters);
+
+		if (!reader.IsValid() || !reader.IsAtEnd() || cached.Bytecode.empty())
+		{
+			std::cout << "Warning: Corrupted shader cache: " << cachePath << std::endl;
+			return false;
+		}
+
+		entry = std::move(cached);
+		return true;
+	}
+
+	void Store(const std::string& cachePath, const Key& key, const Entry& entry)
+	{
+		FileUtility::BinaryWriter writer;
+		writer.Write(CACHE_MAGIC);
+		writer.Write(CACHE_VERSION);
+		WriteString(writer, key.Description);
+
+		writer.Write((uint32_t) entry.Bytecode.size());
+		writer.WriteArray(entry.Bytecode);
+		WriteInputParameters(writer, entry.InputParameters);
+
+		std::lock_guard<std::mutex> lock(CacheFileMutex);
+		if (!FileUtility::WriteBinaryFile(cachePath, writer.GetData().data(), writer.GetData().size()))
+		{
+			std::cout << "Warning: Failed to write shader cache: " << cachePath << std::endl;
+		}
+	}
+
+	bool Archive::Load(const std::string& path)
+	{
+		std::vector<uint8_t> fileContent;
+		if (!FileUtility::ReadBinaryFile(path, fileContent)) return false;
+
+		FileUtility::BinaryReader reader{ fileContent };
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		if (!reader.Read(magic) || !reader.Read(version) || magic != ARCHIVE_MAGIC || version != ARCHIVE_VERSION) return false;
+
+		// Table of contents first, the bytecode of all entries is one blob at the end
+		std::string compilerVersion;
+		uint32_t numEntries = 0;
+		ReadString(reader, compilerVersion);
+		reader.Read(numEntries);
+
+		std::map<uint64_t, TableEntry> tableOfContents;
+		for (uint32_t i = 0; i < numEntries && reader.IsValid(); i++)
+		{
+			uint64_t hash = 0;
+			TableEntry tableEntry{};
+			reader.Read(hash);
+			ReadString(reader, tableEntry.Description);
+			reader.Read(tableEntry.BytecodeOffset);
+			reader.Read(tableEntry.BytecodeSize);
+			ReadInputParameters(reader, tableEntry.InputParameters);
+			tableOfContents[hash] = std::move(tableEntry);
+		}
+
+		uint64_t bytecodeSize = 0;
+		std::vector<uint8_t> bytecode;
+		reader.Read(bytecodeSize);
+		reader.ReadArray(bytecode, bytecodeSize);
+
+		bool valid = reader.IsValid() && reader.IsAtEnd();
+		for (const auto& [hash, tableEntry] : tableOfContents)
+		{
+			valid = valid && tableEntry.BytecodeSize > 0 && tableEntry.BytecodeOffset + tableEntry.BytecodeSize <= bytecode.size();
+		}
+
+		if (!valid)
+		{
+			std::cout << "Warning: Corrupted shader archive: " << path << std::endl;
+			return false;
+		}
+
+		m_CompilerVersion = std::move(compilerVersion);
+		m_TableOfContents = std::move(tableOfContents);
+		m_Bytecode = std::move(bytecode);
+		return true;
+	}
+
+	bool Archive::Save(const std::string& path) const
+	{
+		FileUtility::BinaryWriter writer;
+		writer.Write(ARCHIVE_MAGIC);
+		writer.Write(ARCHIVE_VERSION);
+		WriteString(writer, m_CompilerVersion);
+
+		writer.Write((uint32_t) m_TableOfContents.size());
+		for (const auto& [hash, tableEntry] : m_TableOfContents)
+		{
+			writer.Write(hash);
+			WriteString(writer, tableEntry.Description);
+			writer.Write(tableEntry.BytecodeOffset);
+			writer.Write(tableEntry.BytecodeSize);
+			WriteInputParameters(writer, tableEntry.InputParameters);
+		}
+
+		writer.Write((uint64_t) m_Bytecode.size());
+		writer.WriteArray(m_Bytecode);
+
+		return FileUtility::WriteBinaryFile(path, writer.GetData().data(), writer.GetData().size());
+	}
+
+	bool Archive::Find(const Key& key, Entry& entry) const
+	{
+		const auto it = m_TableOfContents.find(key.Hash);
+		if (it == m_TableOfContents.end() || it->second.Description != key.Description) return false;
+
+		const TableEntry& tableEntry = it->second;
+		const auto bytecodeBegin = m_Bytecode.begin() + tableEntry.BytecodeOffset;
+		entry.Bytecode.assign(bytecodeBegin, bytecodeBegin + tableEntry.BytecodeSize);
+		entry.InputParameters = tableEntry.InputParameters;
+		return true;
+	}
+
+	void Archive::Add(const Key& key, const Entry& entry)
+	{
+		// Replaced entry leaves its bytecode in the blob, the tool adds every key only once
+		TableEntry tableEntry{};
+		tableEntry.Description = key.Description;
+		tableEntry.BytecodeOffset = m_Bytecode.size();
+		tableEntry.BytecodeSize = (uint32_t) entry.Bytecode.size();
+		tableEntry.InputParameters = entry.InputParameters;
+		m_TableOfContents[key.Hash] = std::move(tableEntry);
+
+		m_Bytecode.insert(m_Bytecode.end(), entry.Bytecode.begin(), entry.Bytecode.end());
+	}
+}
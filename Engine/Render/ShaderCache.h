@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <map>
+
+// Content addressed disk cache of the compiled shader stages
+// Doesn't depend on the compiler so the keying and the storage can be used without D3D12
+namespace GFX::ShaderCache
+{
+	// Part of the vertex shader reflection needed to create the input layout
+	struct InputParameter
+	{
+		std::string SemanticName;
+		uint32_t SemanticIndex = 0;
+		uint32_t SystemValueType = 0; // D3D_NAME
+		uint32_t ComponentType = 0; // D3D_REGISTER_COMPONENT_TYPE
+		uint8_t Mask = 0;
+
+		bool operator==(const InputParameter& other) const = default;
+	};
+
+	struct Entry
+	{
+		std::vector<uint8_t> Bytecode;
+		std::vector<InputParameter> InputParameters;
+	};
+
+	struct FileHash
+	{
+		std::string Path;
+		uint64_t Hash = 0;
+	};
+
+	struct Key
+	{
+		uint64_t Hash = 0;
+
+		// Everything the hash was made from, stored in the entry so the hash collision can't return wrong bytecode
+		std::string Description;
+
+		// Source and every include that was found, with the content hashes the key was made from
+		std::vector<FileHash> Files;
+	};
+
+	// Key is made from the content of the source and all of its includes, sorted defines, entry point, target profile and the compiler version
+	// Includes are resolved relative to the including file and then to the working directory, same as the default DXC include handler
+	// Fails if the source can't be read
+	bool CreateKey(const std::string& path, const std::vector<std::string>& defines, const std::string& entryPoint, const std::string& targetProfile, const std::string& compilerVersion, Key& key);
+
+	// Same content hash as the key uses, line endings don't change it
+	// Returns 0 if the file can't be read
+	uint64_t HashFile(const std::string& path);
+
+	// Sorted and without duplicates, order of the defines without values doesn't change the result
+	std::vector<std::string> GetCanonicalDefines(const std::vector<std::string>& defines);
+
+	std::string GetCachePath(const Key& key);
+
+	// Fails if the entry doesn't exist, is corrupted or was made for a different key
+	bool Load(const std::string& cachePath, const Key& key, Entry& entry);
+	void Store(const std::string& cachePath, const Key& key, const Entry& entry);
+
+	// Every declared shader stage compiled ahead of time into a single file, built by Tools/ShaderPrecompiler
+	// Entries are keyed with the version of the compiler that built the archive, the runtime compiler version doesn't matter
+	class Archive
+	{
+	public:
+		static constexpr const char* DEFAULT_PATH = "Cache/ShaderArchive.bin";
+
+		// Fails if the file doesn't exist, is corrupted or has a different archive version
+		bool Load(const std::string& path);
+		bool Save(const std::string& path) const;
+
+		// Fails if the entry doesn't exist or the sources changed since the archive was built
+		bool Find(const Key& key, Entry& entry) const;
+
+		// Entry with the same key is replaced
+		void Add(const Key& key, const Entry& entry);
+
+		void SetCompilerVersion(const std::string& compilerVersion) { m_CompilerVersion = compilerVersion; }
+		const std::string& GetCompilerVersion() const { return m_CompilerVersion; }
+		uint32_t GetNumEntries() const { return (uint32_t) m_TableOfContents.size(); }
+
+	private:
+		struct TableEntry
+		{
+			std::string Description;
+			uint64_t BytecodeOffset = 0;
+			uint32_t BytecodeSize = 0;
+			std::vector<InputParameter> InputParameters;
+		};
+
+		std::string m_CompilerVersion;
+		std::map<uint64_t, TableEntry> m_TableOfContents; // Sorted so the same shaders always give the same file
+		std::vector<uint8_t> m_Bytecode;
+	};
+}
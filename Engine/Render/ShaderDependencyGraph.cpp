@@ -0,0 +1,64 @@
+#include "ShaderDependencyGraph.h"
+
+void ShaderDependencyGraph::SetDependencies(const Implementation& implementation, const std::vector<GFX::ShaderCache::FileHash>& files)
+{
+	RemoveDependencies(implementation);
+
+	std::vector<std::string>& paths = m_Implementations[implementation];
+	for (const GFX::ShaderCache::FileHash& file : files)
+	{
+		// Implementation compiled from the older content than the last scan saw only makes the next scan invalidate more
+		File& node = m_Files[file.Path];
+		node.ContentHash = file.Hash;
+
+		// Stages of the implementation share most of the files
+		if (node.Dependents.insert(implementation).second) paths.push_back(file.Path);
+	}
+}
+
+void ShaderDependencyGraph::Remove(Shader* shader)
+{
+	std::vector<Implementation> implementations;
+	for (auto it = m_Implementations.lower_bound(Implementation{ shader, 0 }); it != m_Implementations.end() && it->first.first == shader; it++)
+	{
+		implementations.push_back(it->first);
+	}
+
+	for (const Implementation& implementation : implementations) RemoveDependencies(implementation);
+}
+
+std::vector<ShaderDependencyGraph::Implementation> ShaderDependencyGraph::GetDependents(const std::string& path) const
+{
+	const auto it = m_Files.find(path);
+	if (it == m_Files.end()) return {};
+	return { it->second.Dependents.begin(), it->second.Dependents.end() };
+}
+
+std::vector<ShaderDependencyGraph::Implementation> ShaderDependencyGraph::ScanForChanges()
+{
+	std::set<Implementation> changedImplementations;
+	for (auto& [path, file] : m_Files)
+	{
+		const uint64_t contentHash = GFX::ShaderCache::HashFile(path);
+		if (contentHash == file.ContentHash) continue;
+
+		file.ContentHash = contentHash;
+		changedImplementations.insert(file.Dependents.begin(), file.Dependents.end());
+	}
+	return { changedImplementations.begin(), changedImplementations.end() };
+}
+
+void ShaderDependencyGraph::RemoveDependencies(const Implementation& implementation)
+{
+	const auto it = m_Implementations.find(implementation);
+	if (it == m_Implementations.end()) return;
+
+	for (const std::string& path : it->second)
+	{
+		// File that nothing depends on anymore isn't scanned
+		const auto fileIt = m_Files.find(path);
+		fileIt->second.Dependents.erase(implementation);
+		if (fileIt->second.Dependents.empty()) m_Files.erase(fileIt);
+	}
+	m_Implementations.erase(it);
+}
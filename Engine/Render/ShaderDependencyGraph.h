@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Render/ShaderCache.h"
+
+struct Shader;
+
+// Maps every shader source and include to the implementations that were compiled from it
+// Doesn't depend on D3D12 so the invalidation can be used on plain files
+class ShaderDependencyGraph
+{
+public:
+	// Shader with the implementation key, same as the one used by Shader::Implementations
+	using Implementation = std::pair<Shader*, uint64_t>;
+
+	// Replaces the previous dependencies of the implementation
+	// Files are the ones from the shader cache key, their hashes are the content the implementation was compiled from
+	void SetDependencies(const Implementation& implementation, const std::vector<GFX::ShaderCache::FileHash>& files);
+	void Remove(Shader* shader);
+
+	// Implementations that include the file, directly or through other includes
+	std::vector<Implementation> GetDependents(const std::string& path) const;
+
+	// Hashes every tracked file again and returns the implementations that depend on the changed ones
+	// Changed hashes are remembered, the next scan doesn't return the same implementations again
+	std::vector<Implementation> ScanForChanges();
+
+	uint32_t GetNumFiles() const { return (uint32_t) m_Files.size(); }
+
+private:
+	struct File
+	{
+		uint64_t ContentHash = 0;
+		std::set<Implementation> Dependents;
+	};
+
+	void RemoveDependencies(const Implementation& implementation);
+
+	std::map<std::string, File> m_Files;
+	std::map<Implementation, std::vector<std::string>> m_Implementations;
+};
@@ -0,0 +1,42 @@
+#include "ShaderManifest.h"
+
+#include <algorithm>
+
+ShaderDeclaration& ShaderDeclaration::Implementations(uint32_t stages, std::initializer_list<const char*> defines, std::initializer_list<const char*> optionalDefines)
+{
+	const ShaderPermutationKey requiredKey = Permutations.GetKey(defines);
+
+	const std::vector<const char*> optional{ optionalDefines.begin(), optionalDefines.end() };
+	for (uint32_t mask = 0; mask < (1u << optional.size()); mask++)
+	{
+		ShaderPermutationKey key = requiredKey;
+		for (uint32_t i = 0; i < optional.size(); i++)
+		{
+			if (mask & (1u << i)) key = Permutations.SetDefine(key, optional[i]);
+		}
+
+		const bool alreadyDeclared = std::any_of(DeclaredImplementations.begin(), DeclaredImplementations.end(), [&](const ShaderImplementationDesc& desc) { return desc.Permutation == key && desc.Stages == stages; });
+		if (!alreadyDeclared) DeclaredImplementations.push_back(ShaderImplementationDesc{ key, stages });
+	}
+	return *this;
+}
+
+namespace ShaderManifest
+{
+	const std::vector<ShaderDeclaration>& GetEngineShaders()
+	{
+		static const std::vector<ShaderDeclaration> EngineShaders = {
+			ShaderDeclaration{ "Engine/Render/copy.hlsl" }.Implementations(VS | PS),
+		};
+		return EngineShaders;
+	}
+
+	const ShaderDeclaration* Find(const std::vector<ShaderDeclaration>& declarations, const std::string& path)
+	{
+		for (const ShaderDeclaration& declaration : declarations)
+		{
+			if (declaration.Path == path) return &declaration;
+		}
+		return nullptr;
+	}
+}
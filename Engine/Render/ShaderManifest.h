@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+#include "Render/ShaderPermutation.h"
+
+// Permutation and the shader stages that are compiled together
+struct ShaderImplementationDesc
+{
+	ShaderPermutationKey Permutation = 0;
+	uint32_t Stages = 0;
+};
+
+// Shader file with everything that the renderers compile from it
+// Same declaration is used for the runtime warm-up and for the offline precompiler
+struct ShaderDeclaration
+{
+	ShaderDeclaration(std::string path, ShaderPermutationLayout permutations = {}) : Path(std::move(path)), Permutations(std::move(permutations)) {}
+
+	// Declares every combination of the optional defines on top of the required ones
+	ShaderDeclaration& Implementations(uint32_t stages, std::initializer_list<const char*> defines = {}, std::initializer_list<const char*> optionalDefines = {});
+
+	std::string Path;
+	ShaderPermutationLayout Permutations;
+	std::vector<ShaderImplementationDesc> DeclaredImplementations;
+};
+
+namespace ShaderManifest
+{
+	// Shaders that the engine itself uses
+	const std::vector<ShaderDeclaration>& GetEngineShaders();
+
+	// Returns nullptr if the path isn't declared
+	const ShaderDeclaration* Find(const std::vector<ShaderDeclaration>& declarations, const std::string& path);
+}
@@ -0,0 +1,107 @@
+#include "ShaderPermutation.h"
+
+#include <cstring>
+
+#include "Utility/Assert.h"
+
+ShaderPermutationLayout::ShaderPermutationLayout(std::initializer_list<ShaderPermutationAxis> axes)
+{
+	for (const ShaderPermutationAxis& axisDesc : axes)
+	{
+		Axis axis{};
+		axis.Defines = axisDesc.Defines;
+		axis.IsOption = axisDesc.IsOption;
+		axis.Shift = m_NumBits;
+
+		uint32_t numBits = 0;
+		while ((1ull << numBits) < axis.GetNumValues()) numBits++;
+
+		axis.Mask = ((1ull << numBits) - 1) << axis.Shift;
+		m_NumBits += numBits;
+		m_Axes.push_back(axis);
+	}
+
+	// Bits above MAX_KEY_BITS are the shader stages of the implementation key
+	ASSERT(m_NumBits <= MAX_KEY_BITS, "[ShaderPermutationLayout] Layout needs " << m_NumBits << " bits, only " << MAX_KEY_BITS << " are supported");
+}
+
+ShaderPermutationKey ShaderPermutationLayout::GetKey(std::initializer_list<const char*> defines) const
+{
+	ShaderPermutationKey key = 0;
+	for (const char* define : defines) key = SetDefine(key, define);
+	return key;
+}
+
+ShaderPermutationKey ShaderPermutationLayout::SetDefine(ShaderPermutationKey key, const char* define) const
+{
+	if (!define) return key;
+
+	for (const Axis& axis : m_Axes)
+	{
+		for (uint32_t i = 0; i < axis.Defines.size(); i++)
+		{
+			if (strcmp(axis.Defines[i].c_str(), define) != 0) continue;
+
+			const ShaderPermutationKey value = axis.IsOption ? i : 1;
+			return (key & ~axis.Mask) | (value << axis.Shift);
+		}
+	}
+
+	ASSERT(0, "[ShaderPermutationLayout] Define " << define << " isn't declared in the shader permutation layout");
+	return key;
+}
+
+bool ShaderPermutationLayout::IsValid(ShaderPermutationKey key) const
+{
+	ShaderPermutationKey usedBits = 0;
+	for (const Axis& axis : m_Axes)
+	{
+		if (((key & axis.Mask) >> axis.Shift) >= axis.GetNumValues()) return false;
+		usedBits |= axis.Mask;
+	}
+	return (key & ~usedBits) == 0;
+}
+
+std::vector<std::string> ShaderPermutationLayout::GetDefines(ShaderPermutationKey key) const
+{
+	std::vector<std::string> defines;
+	for (const Axis& axis : m_Axes)
+	{
+		const ShaderPermutationKey value = (key & axis.Mask) >> axis.Shift;
+		if (axis.IsOption && value < axis.Defines.size()) defines.push_back(axis.Defines[value]);
+		else if (!axis.IsOption && value) defines.push_back(axis.Defines[0]);
+	}
+	return defines;
+}
+
+uint64_t ShaderPermutationLayout::GetNumPermutations() const
+{
+	uint64_t numPermutations = 1;
+	for (const Axis& axis : m_Axes) numPermutations *= axis.GetNumValues();
+	return numPermutations;
+}
+
+std::vector<ShaderPermutationKey> ShaderPermutationLayout::EnumeratePermutations() const
+{
+	std::vector<ShaderPermutationKey> permutations;
+	permutations.reserve(GetNumPermutations());
+
+	// Counts through the values of all axes, first axis changes the fastest
+	std::vector<uint32_t> values(m_Axes.size(), 0);
+	while (true)
+	{
+		ShaderPermutationKey key = 0;
+		for (uint32_t i = 0; i < m_Axes.size(); i++) key |= (ShaderPermutationKey) values[i] << m_Axes[i].Shift;
+		permutations.push_back(key);
+
+		uint32_t axisIndex = 0;
+		while (axisIndex < m_Axes.size() && ++values[axisIndex] == m_Axes[axisIndex].GetNumValues())
+		{
+			values[axisIndex] = 0;
+			axisIndex++;
+		}
+		if (axisIndex == m_Axes.size()) break;
+	}
+
+	return permutations;
+}
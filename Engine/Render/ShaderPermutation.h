@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <initializer_list>
+
+// Doesn't depend on D3D12 so the offline shader precompiler uses the same permutations as the runtime
+
+enum ShaderStage : uint8_t
+{
+	VS = 1 << 0,
+	GS = 1 << 1,
+	HS = 1 << 2,
+	DS = 1 << 3,
+	PS = 1 << 4,
+	CS = 1 << 5,
+	SHADER_STAGE_COUNT = 6
+};
+
+// Bitmask of the shader defines, same set of defines gives the same key regardless of the order
+using ShaderPermutationKey = uint64_t;
+
+struct ShaderPermutationAxis
+{
+	// Define that is either set or not
+	static ShaderPermutationAxis Flag(const char* define) { return ShaderPermutationAxis{ { define }, false }; }
+
+	// Mutually exclusive defines where one is always set, first one is the default
+	// Used for the sections of the shader file
+	static ShaderPermutationAxis Option(std::initializer_list<const char*> defines) { return ShaderPermutationAxis{ { defines.begin(), defines.end() }, true }; }
+
+	std::vector<std::string> Defines;
+	bool IsOption = false;
+};
+
+// Permutation axes that shader declares up front, every axis takes its own bits of the key
+class ShaderPermutationLayout
+{
+public:
+	// Rest of the 64 bits is used for the shader stages of the implementation
+	static constexpr uint32_t MAX_KEY_BITS = 56;
+
+	ShaderPermutationLayout() = default;
+	ShaderPermutationLayout(std::initializer_list<ShaderPermutationAxis> axes);
+
+	// Doesn't allocate so it can be called every frame
+	// nullptr defines are skipped so the conditional define can be written inline, define set later in the same option axis wins
+	// Every other define has to be declared in the layout
+	ShaderPermutationKey GetKey(std::initializer_list<const char*> defines) const;
+	ShaderPermutationKey SetDefine(ShaderPermutationKey key, const char* define) const;
+
+	// False if the key has bits outside of the axes or out of range option
+	bool IsValid(ShaderPermutationKey key) const;
+
+	// Defines of the key in the order of the axes
+	std::vector<std::string> GetDefines(ShaderPermutationKey key) const;
+
+	uint64_t GetNumPermutations() const;
+	std::vector<ShaderPermutationKey> EnumeratePermutations() const;
+
+private:
+	struct Axis
+	{
+		std::vector<std::string> Defines;
+		bool IsOption = false;
+		uint32_t Shift = 0;
+		ShaderPermutationKey Mask = 0;
+
+		uint32_t GetNumValues() const { return IsOption ? (uint32_t) Defines.size() : 2; }
+	};
+
+	std::vector<Axis> m_Axes;
+	uint32_t m_NumBits = 0;
+};
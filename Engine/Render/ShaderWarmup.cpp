@@ -0,0 +1,197 @@
+#include "ShaderWarmup.h"
+
+ShaderWarmup::ShaderWarmup(CompileFunc compileFunc, uint32_t numThreads) :
+	m_CompileFunc(std::move(compileFunc))
+{
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		m_Threads.push_back(std::thread([this] { WorkerLoop(); }));
+	}
+}
+
+ShaderWarmup::~ShaderWarmup()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+		m_Queue.clear();
+	}
+	m_JobQueued.notify_all();
+
+	for (std::thread& thread : m_Threads) thread.join();
+}
+
+bool ShaderWarmup::Request(Shader* shader, uint64_t implementationKey)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		const JobKey job{ shader, implementationKey };
+		if (m_Jobs.contains(job)) return false;
+
+		QueueJob(job);
+	}
+	m_JobQueued.notify_one();
+	return true;
+}
+
+void ShaderWarmup::Recompile(Shader* shader, uint64_t implementationKey)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		const JobKey job{ shader, implementationKey };
+		const auto it = m_Jobs.find(job);
+		if (it != m_Jobs.end() && it->second == JobStatus::Queued) return;
+
+		// Compilation in progress could have read the files before they changed
+		if (it != m_Jobs.end() && it->second == JobStatus::Compiling)
+		{
+			m_RecompileAfterFinish.insert(job);
+			return;
+		}
+
+		QueueJob(job);
+	}
+	m_JobQueued.notify_one();
+}
+
+ShaderWarmup::JobStatus ShaderWarmup::GetStatus(Shader* shader, uint64_t implementationKey) const
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	const auto it = m_Jobs.find(JobKey{ shader, implementationKey });
+	return it == m_Jobs.end() ? JobStatus::NotRequested : it->second;
+}
+
+bool ShaderWarmup::IsPending(Shader* shader, uint64_t implementationKey) const
+{
+	const JobStatus status = GetStatus(shader, implementationKey);
+	return status == JobStatus::Queued || status == JobStatus::Compiling;
+}
+
+ShaderWarmup::JobStatus ShaderWarmup::Wait(Shader* shader, uint64_t implementationKey)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	const JobKey job{ shader, implementationKey };
+	auto it = m_Jobs.find(job);
+	if (it == m_Jobs.end()) return JobStatus::NotRequested;
+
+	// Taking the job is faster than waiting for the workers to get to it, the worker skips it later
+	if (it->second == JobStatus::Queued)
+	{
+		it->second = JobStatus::Compiling;
+		RunJob(lock, job);
+	}
+
+	m_JobFinished.wait(lock, [&] { it = m_Jobs.find(job); return it == m_Jobs.end() || it->second != JobStatus::Compiling; });
+	return it == m_Jobs.end() ? JobStatus::NotRequested : it->second;
+}
+
+void ShaderWarmup::WaitAll()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_JobFinished.wait(lock, [this] { return m_NumFinished == m_NumRequested; });
+}
+
+void ShaderWarmup::Cancel(Shader* shader)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	const bool hadPendingJobs = m_NumFinished != m_NumRequested;
+	for (auto it = m_Jobs.lower_bound(JobKey{ shader, 0 }); it != m_Jobs.end() && it->first.first == shader; it++)
+	{
+		if (it->second != JobStatus::Queued) continue;
+
+		// Stays in the queue, the worker skips the job it can't find
+		it->second = JobStatus::NotRequested;
+		m_NumRequested--;
+	}
+	m_RecompileAfterFinish.erase(m_RecompileAfterFinish.lower_bound(JobKey{ shader, 0 }), m_RecompileAfterFinish.upper_bound(JobKey{ shader, UINT64_MAX }));
+
+	m_JobFinished.wait(lock, [&]
+	{
+		for (auto it = m_Jobs.lower_bound(JobKey{ shader, 0 }); it != m_Jobs.end() && it->first.first == shader; it++)
+		{
+			if (it->second == JobStatus::Compiling) return false;
+		}
+		return true;
+	});
+
+	// New shader can get the same address
+	m_Jobs.erase(m_Jobs.lower_bound(JobKey{ shader, 0 }), m_Jobs.upper_bound(JobKey{ shader, UINT64_MAX }));
+
+	if (hadPendingJobs && m_NumFinished == m_NumRequested)
+	{
+		m_FinishedBatchesTime += Clock::now() - m_BatchStartTime;
+		m_JobFinished.notify_all();
+	}
+}
+
+ShaderWarmup::Progress ShaderWarmup::GetProgress() const
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	Clock::duration compileTime = m_FinishedBatchesTime;
+	if (m_NumFinished != m_NumRequested) compileTime += Clock::now() - m_BatchStartTime;
+
+	Progress progress{};
+	progress.NumRequested = m_NumRequested;
+	progress.NumFinished = m_NumFinished;
+	progress.NumFailed = m_NumFailed;
+	progress.CompileTimeMS = std::chrono::duration<float, std::milli>(compileTime).count();
+	return progress;
+}
+
+void ShaderWarmup::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_JobQueued.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+		if (m_Stopping) return;
+
+		const JobKey job = m_Queue.front();
+		m_Queue.pop_front();
+
+		// Already taken by Wait or cancelled
+		const auto it = m_Jobs.find(job);
+		if (it == m_Jobs.end() || it->second != JobStatus::Queued) continue;
+
+		it->second = JobStatus::Compiling;
+		RunJob(lock, job);
+	}
+}
+
+void ShaderWarmup::QueueJob(const JobKey& job)
+{
+	if (m_NumFinished == m_NumRequested) m_BatchStartTime = Clock::now();
+
+	m_Jobs[job] = JobStatus::Queued;
+	m_Queue.push_back(job);
+	m_NumRequested++;
+}
+
+void ShaderWarmup::RunJob(std::unique_lock<std::mutex>& lock, const JobKey& job)
+{
+	lock.unlock();
+	const bool success = m_CompileFunc(job.first, job.second);
+	lock.lock();
+
+	m_Jobs[job] = success ? JobStatus::Ready : JobStatus::Failed;
+
+	// Queued before the job counts as finished so the batch continues
+	if (m_RecompileAfterFinish.erase(job))
+	{
+		QueueJob(job);
+		m_JobQueued.notify_one();
+	}
+
+	m_NumFinished++;
+	if (!success) m_NumFailed++;
+
+	if (m_NumFinished == m_NumRequested) m_FinishedBatchesTime += Clock::now() - m_BatchStartTime;
+
+	m_JobFinished.notify_all();
+}
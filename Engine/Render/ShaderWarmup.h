@@ -0,0 +1,93 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+struct Shader;
+
+// Compiles the shader implementations declared up front on the background threads
+// Doesn't depend on the compiler so the scheduling can be used without D3D12
+class ShaderWarmup
+{
+public:
+	enum class JobStatus
+	{
+		NotRequested,
+		Queued,
+		Compiling,
+		Ready,
+		Failed,
+	};
+
+	struct Progress
+	{
+		uint32_t NumRequested = 0;
+		uint32_t NumFinished = 0;
+		uint32_t NumFailed = 0;
+
+		// Wall time while there were pending jobs, grows until the last job is finished
+		float CompileTimeMS = 0.0f;
+	};
+
+	// Returns true on success, called from the warm-up threads and from the threads that wait for the queued job
+	using CompileFunc = std::function<bool(Shader* shader, uint64_t implementationKey)>;
+
+	ShaderWarmup(CompileFunc compileFunc, uint32_t numThreads);
+
+	// Queued jobs are dropped, jobs in progress are finished
+	~ShaderWarmup();
+
+	// Returns false if the implementation was already requested
+	bool Request(Shader* shader, uint64_t implementationKey);
+
+	// Queues the implementation even if it was already compiled, the one in progress is compiled once more after it finishes
+	void Recompile(Shader* shader, uint64_t implementationKey);
+
+	JobStatus GetStatus(Shader* shader, uint64_t implementationKey) const;
+	bool IsPending(Shader* shader, uint64_t implementationKey) const;
+
+	// Job that is still queued is compiled on the calling thread, otherwise waits for the thread that compiles it
+	JobStatus Wait(Shader* shader, uint64_t implementationKey);
+	void WaitAll();
+
+	// Drops the queued jobs of the shader and waits for the ones in progress, the shader can be deleted after
+	void Cancel(Shader* shader);
+
+	Progress GetProgress() const;
+
+private:
+	using JobKey = std::pair<Shader*, uint64_t>;
+	using Clock = std::chrono::steady_clock;
+
+	void WorkerLoop();
+	void QueueJob(const JobKey& job); // Expects the mutex to be locked
+
+	// Expects the job in the compiling state, lock is released during the compilation
+	void RunJob(std::unique_lock<std::mutex>& lock, const JobKey& job);
+
+	CompileFunc m_CompileFunc;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_JobQueued;
+	std::condition_variable m_JobFinished;
+
+	std::map<JobKey, JobStatus> m_Jobs;
+	std::deque<JobKey> m_Queue;
+	std::set<JobKey> m_RecompileAfterFinish;
+	std::vector<std::thread> m_Threads;
+	bool m_Stopping = false;
+
+	uint32_t m_NumRequested = 0;
+	uint32_t m_NumFinished = 0;
+	uint32_t m_NumFailed = 0;
+	Clock::time_point m_BatchStartTime;
+	Clock::duration m_FinishedBatchesTime{};
+};
@@ -0,0 +1,81 @@
+#include "SignatureCache.h"
+
+uint64_t BindingLayout::GetHash() const
+{
+	uint64_t hash = Hash::XXHash64(CBVs);
+	hash = Hash::XXHash64(hash, SRVs);
+	hash = Hash::XXHash64(hash, UAVs);
+	hash = Hash::XXHash64(hash, NumSamplers);
+	hash = Hash::XXHash64(hash, PushConstantBinding);
+	hash = Hash::XXHash64(hash, PushConstantCount);
+	for (const BindlessTable& table : BindlessTables)
+	{
+		hash = Hash::XXHash64(hash, table.RegisterSpace);
+		hash = Hash::XXHash64(hash, table.DescriptorCount);
+	}
+	return hash;
+}
+
+bool IndirectLayout::ChangesRootArguments() const
+{
+	for (const Argument& argument : Arguments)
+	{
+		if (argument.Type >= ArgumentType::Constant) return true;
+	}
+	return false;
+}
+
+uint64_t IndirectLayout::GetHash() const
+{
+	uint64_t hash = Hash::XXHash64(ByteStride);
+	for (const Argument& argument : Arguments)
+	{
+		hash = Hash::XXHash64(hash, argument);
+	}
+	return hash;
+}
+
+uint64_t GetRootSignatureHash(const BindingLayout& layout)
+{
+	return GlobalRootSignature::Fits(layout) ? GlobalRootSignature::HASH : layout.GetHash();
+}
+
+RootParameters GetRootParameters(const BindingLayout& layout)
+{
+	RootParameters parameters;
+	uint32_t nextParameter = 0;
+	if (layout.PushConstantCount != 0) parameters.PushConstants = nextParameter++;
+	if (layout.CBVs.any()) parameters.CBVs = nextParameter++;
+	if (layout.SRVs.any()) parameters.SRVs = nextParameter++;
+	if (layout.UAVs.any()) parameters.UAVs = nextParameter++;
+	if (layout.NumSamplers != 0) parameters.Samplers = nextParameter++;
+	if (!layout.BindlessTables.empty()) parameters.FirstBindlessTable = nextParameter;
+	return parameters;
+}
+
+namespace GlobalRootSignature
+{
+	bool Fits(const BindingLayout& layout)
+	{
+		const bool pushConstantsFit = layout.PushConstantCount == 0 || (layout.PushConstantBinding == PUSH_CONSTANT_BINDING && layout.PushConstantCount <= PUSH_CONSTANT_COUNT);
+		const bool bindlessTablesFit = layout.BindlessTables.empty() || (layout.BindlessTables.size() == 1 && layout.BindlessTables[0].RegisterSpace == BINDLESS_REGISTER_SPACE);
+
+		return pushConstantsFit && bindlessTablesFit &&
+			(layout.CBVs >> CBV_COUNT).none() &&
+			(layout.SRVs >> SRV_COUNT).none() &&
+			(layout.UAVs >> UAV_COUNT).none() &&
+			layout.NumSamplers <= SAMPLER_COUNT;
+	}
+
+	RootParameters GetParameters()
+	{
+		RootParameters parameters;
+		parameters.PushConstants = 0;
+		parameters.CBVs = 1;
+		parameters.SRVs = 2;
+		parameters.UAVs = 3;
+		parameters.Samplers = 4;
+		parameters.FirstBindlessTable = 5;
+		return parameters;
+	}
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <bitset>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "Utility/ConcurrentCache.h"
+#include "Utility/Hash.h"
+
+// Doesn't depend on D3D12, signatures are created through SignatureCache::Factory so the selection and the caching can be used with a mock
+
+// Shape of the bindings of the state, the root signature is chosen by it
+struct BindingLayout
+{
+	static constexpr uint32_t MAX_SLOTS = 128;
+
+	struct BindlessTable
+	{
+		uint32_t RegisterSpace = 1;
+		uint32_t DescriptorCount = 0;
+	};
+
+	// Bit per bound register
+	std::bitset<MAX_SLOTS> CBVs;
+	std::bitset<MAX_SLOTS> SRVs;
+	std::bitset<MAX_SLOTS> UAVs;
+	uint32_t NumSamplers = 0;
+
+	uint32_t PushConstantBinding = 128;
+	uint32_t PushConstantCount = 0;
+
+	std::vector<BindlessTable> BindlessTables;
+
+	uint64_t GetHash() const;
+};
+
+// Arguments of the indirect command, values of the types match D3D12_INDIRECT_ARGUMENT_TYPE
+struct IndirectLayout
+{
+	enum class ArgumentType : uint32_t
+	{
+		Draw,
+		DrawIndexed,
+		Dispatch,
+		VertexBufferView,
+		IndexBufferView,
+		Constant,
+		ConstantBufferView,
+		ShaderResourceView,
+		UnorderedAccessView,
+	};
+
+	struct Argument
+	{
+		ArgumentType Type = ArgumentType::Draw;
+
+		// Same layout as the union of D3D12_INDIRECT_ARGUMENT_DESC
+		uint32_t Data[3] = {};
+	};
+
+	uint32_t ByteStride = 0;
+	std::vector<Argument> Arguments;
+
+	// Command signature that sets the root arguments is made for the root signature
+	bool ChangesRootArguments() const;
+
+	uint64_t GetHash() const;
+};
+
+// Indices of the root parameters, INVALID if the root signature doesn't have it
+struct RootParameters
+{
+	static constexpr uint32_t INVALID = ~0u;
+
+	uint32_t PushConstants = INVALID;
+	uint32_t CBVs = INVALID;
+	uint32_t SRVs = INVALID;
+	uint32_t UAVs = INVALID;
+	uint32_t Samplers = INVALID;
+	uint32_t FirstBindlessTable = INVALID;
+
+	bool operator==(const RootParameters& other) const = default;
+};
+
+// Hash of the root signature the layout is bound with, doesn't create it
+uint64_t GetRootSignatureHash(const BindingLayout& layout);
+
+// Root parameters of the signature made for the layout, in the order push constants, CBVs, SRVs, UAVs, samplers, bindless tables
+RootParameters GetRootParameters(const BindingLayout& layout);
+
+// Root signature that is shared by all states that fit into it, its root parameters are always the same
+// Descriptor tables have a descriptor for every register, the unbound ones are null
+namespace GlobalRootSignature
+{
+	constexpr uint32_t PUSH_CONSTANT_BINDING = 128;
+	constexpr uint32_t PUSH_CONSTANT_COUNT = 8;
+	constexpr uint32_t CBV_COUNT = 8;
+	constexpr uint32_t SRV_COUNT = BindingLayout::MAX_SLOTS;
+	constexpr uint32_t UAV_COUNT = 8;
+	constexpr uint32_t SAMPLER_COUNT = 4;
+
+	// Unbounded table of SRVs that starts at t0
+	constexpr uint32_t BINDLESS_REGISTER_SPACE = 1;
+
+	// Layout hashes are never 0 in practice
+	constexpr uint64_t HASH = 0;
+
+	bool Fits(const BindingLayout& layout);
+	RootParameters GetParameters();
+}
+
+// Samplers that are part of every root signature, shaders declare them at STATIC_SAMPLER_REGISTER + index
+enum class StaticSampler : uint32_t
+{
+	PointClamp,
+	PointWrap,
+	LinearClamp,
+	LinearWrap,
+	LinearBorder,
+	AnisoWrap,
+	Count
+};
+constexpr uint32_t STATIC_SAMPLER_REGISTER = 100;
+
+// Root signatures shared by all contexts and command signatures cached by their arguments
+template<typename RootSignature, typename CommandSignature>
+class SignatureCache
+{
+public:
+	class Factory
+	{
+	public:
+		virtual ~Factory() = default;
+
+		// Global root signature has all of the GlobalRootSignature parameters regardless of the layout
+		virtual RootSignature CreateRootSignature(const BindingLayout& layout, bool global) = 0;
+
+		// Root signature is null if the arguments don't change the root arguments
+		virtual CommandSignature CreateCommandSignature(const IndirectLayout& layout, const RootSignature* rootSignature) = 0;
+	};
+
+	struct Selection
+	{
+		const RootSignature* Signature = nullptr;
+		uint64_t Hash = 0;
+		bool IsGlobal = false;
+		RootParameters Parameters;
+	};
+
+	struct Statistics
+	{
+		uint64_t NumGlobal = 0;
+		uint64_t NumFallback = 0;
+		uint64_t NumRootSignatures = 0;
+		uint64_t NumCommandSignatures = 0;
+		uint64_t NumCommandSignatureHits = 0;
+	};
+
+	// States that don't fit into the global root signature get their own, cached by the layout
+	Selection GetRootSignature(Factory& factory, const BindingLayout& layout)
+	{
+		Selection selection;
+		selection.IsGlobal = GlobalRootSignature::Fits(layout);
+		selection.Hash = GetRootSignatureHash(layout);
+		selection.Parameters = selection.IsGlobal ? GlobalRootSignature::GetParameters() : GetRootParameters(layout);
+		selection.Signature = &m_RootSignatures.GetOrCreate(selection.Hash, [&factory, &layout, &selection] { return factory.CreateRootSignature(layout, selection.IsGlobal); });
+
+		if (selection.IsGlobal) m_NumGlobal++;
+		else m_NumFallback++;
+
+		return selection;
+	}
+
+	// Command signature that doesn't change the root arguments is shared by all root signatures
+	const CommandSignature& GetCommandSignature(Factory& factory, const IndirectLayout& layout, const Selection& rootSignature)
+	{
+		const bool changesRootArguments = layout.ChangesRootArguments();
+
+		uint64_t hash = layout.GetHash();
+		if (changesRootArguments) hash = Hash::XXHash64(hash, rootSignature.Hash);
+
+		return m_CommandSignatures.GetOrCreate(hash, [&factory, &layout, &rootSignature, changesRootArguments]
+		{
+			return factory.CreateCommandSignature(layout, changesRootArguments ? rootSignature.Signature : nullptr);
+		});
+	}
+
+	Statistics GetStatistics() const
+	{
+		Statistics statistics{};
+		statistics.NumGlobal = m_NumGlobal;
+		statistics.NumFallback = m_NumFallback;
+		statistics.NumRootSignatures = m_RootSignatures.GetSize();
+		statistics.NumCommandSignatures = m_CommandSignatures.GetSize();
+		statistics.NumCommandSignatureHits = m_CommandSignatures.GetStatistics().NumHits;
+		return statistics;
+	}
+
+	// Expects that no other thread uses the cache
+	void Clear()
+	{
+		m_CommandSignatures.Clear();
+		m_RootSignatures.Clear();
+	}
+
+private:
+	MTR::ConcurrentCache<RootSignature> m_RootSignatures;
+	MTR::ConcurrentCache<CommandSignature> m_CommandSignatures;
+
+	std::atomic<uint64_t> m_NumGlobal = 0;
+	std::atomic<uint64_t> m_NumFallback = 0;
+};
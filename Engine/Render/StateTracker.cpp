@@ -0,0 +1,69 @@
+#include "StateTracker.h"
+
+template<typename EmitFunc>
+void StateTracker::Update(uint64_t& bound, uint64_t key, EmitFunc emit)
+{
+	if (m_Valid && bound == key)
+	{
+		m_Statistics.NumSkipped++;
+		return;
+	}
+
+	emit();
+	bound = key;
+	m_Statistics.NumEmitted++;
+}
+
+void StateTracker::Apply(const State& state, CommandSink& sink)
+{
+	m_Statistics.NumApplied++;
+
+	if (!m_Valid)
+	{
+		sink.SetDescriptorHeaps();
+		m_Statistics.NumEmitted++;
+	}
+
+	// Graphics and compute have separate root arguments, only the ones of the last type are tracked
+	if (!m_Valid || m_Bound.Compute != state.Compute || m_Bound.RootSignature != state.RootSignature)
+	{
+		sink.SetRootSignature();
+		m_Bound.Compute = state.Compute;
+		m_Bound.RootSignature = state.RootSignature;
+		m_Statistics.NumEmitted++;
+
+		// Tables of the previous root signature are unbound by it
+		m_Bound.DescriptorTables.fill(0);
+	}
+	else
+	{
+		m_Statistics.NumSkipped++;
+	}
+
+	Update(m_Bound.PipelineState, state.PipelineState, [&sink] { sink.SetPipelineState(); });
+
+	if (!state.Compute)
+	{
+		Update(m_Bound.RenderTargets, state.RenderTargets, [&sink] { sink.SetRenderTargets(); });
+		Update(m_Bound.Viewport, state.Viewport, [&sink] { sink.SetViewport(); });
+		Update(m_Bound.StencilRef, state.StencilRef, [&sink] { sink.SetStencilRef(); });
+		Update(m_Bound.PrimitiveTopology, state.PrimitiveTopology, [&sink] { sink.SetPrimitiveTopology(); });
+
+		// Buffers of the previous state stay bound if the state doesn't have them, the draw doesn't read them
+		if (state.VertexBuffers != 0) Update(m_Bound.VertexBuffers, state.VertexBuffers, [&sink] { sink.SetVertexBuffers(); });
+		if (state.IndexBuffer != 0) Update(m_Bound.IndexBuffer, state.IndexBuffer, [&sink] { sink.SetIndexBuffer(); });
+	}
+
+	for (uint32_t i = 0; i < MAX_DESCRIPTOR_TABLES; i++)
+	{
+		if (state.DescriptorTables[i] != 0) Update(m_Bound.DescriptorTables[i], state.DescriptorTables[i], [&sink, i] { sink.SetDescriptorTable(i); });
+	}
+
+	m_Valid = true;
+}
+
+void StateTracker::Invalidate()
+{
+	m_Valid = false;
+	m_Bound = State{};
+}
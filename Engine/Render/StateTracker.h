@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Last state applied to the command list, split into the components that are set by separate commands
+// Only the components whose key changed since the last Apply are emitted again
+// Doesn't depend on D3D12, the commands go through StateTracker::CommandSink so the deltas can be counted with a mock
+class StateTracker
+{
+public:
+	// CBVs, SRVs, UAVs, samplers and the bindless tables after them
+	static constexpr uint32_t MAX_DESCRIPTOR_TABLES = 16;
+	static constexpr uint32_t FIRST_BINDLESS_TABLE = 4;
+
+	// Keys are hashes of what the command sets, 0 if the state doesn't set the component
+	struct State
+	{
+		bool Compute = false;
+
+		uint64_t RootSignature = 0;
+		uint64_t PipelineState = 0;
+		std::array<uint64_t, MAX_DESCRIPTOR_TABLES> DescriptorTables{};
+
+		// Graphics only, compute states leave them as they are
+		uint64_t RenderTargets = 0;
+		uint64_t Viewport = 0;
+		uint64_t StencilRef = 0;
+		uint64_t PrimitiveTopology = 0;
+		uint64_t VertexBuffers = 0;
+		uint64_t IndexBuffer = 0;
+	};
+
+	class CommandSink
+	{
+	public:
+		virtual ~CommandSink() = default;
+
+		virtual void SetDescriptorHeaps() = 0;
+		virtual void SetRootSignature() = 0;
+		virtual void SetPipelineState() = 0;
+		virtual void SetDescriptorTable(uint32_t table) = 0;
+		virtual void SetRenderTargets() = 0;
+		virtual void SetViewport() = 0;
+		virtual void SetStencilRef() = 0;
+		virtual void SetPrimitiveTopology() = 0;
+		virtual void SetVertexBuffers() = 0;
+		virtual void SetIndexBuffer() = 0;
+	};
+
+	struct Statistics
+	{
+		uint64_t NumApplied = 0;
+		uint64_t NumEmitted = 0;
+		uint64_t NumSkipped = 0;
+	};
+
+	void Apply(const State& state, CommandSink& sink);
+
+	// Called when the command list was reset or other code recorded commands that change its state
+	void Invalidate();
+
+	bool IsPipelineStateBound(uint64_t pipelineState) const { return m_Valid && m_Bound.PipelineState == pipelineState; }
+
+	const Statistics& GetStatistics() const { return m_Statistics; }
+
+private:
+	template<typename EmitFunc>
+	void Update(uint64_t& bound, uint64_t key, EmitFunc emit);
+
+	bool m_Valid = false;
+	State m_Bound;
+
+	Statistics m_Statistics;
+};
@@ -15,7 +15,9 @@ namespace GFX
 		case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
 		case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
 		case DXGI_FORMAT_R11G11B10_FLOAT: return 4;
+		case DXGI_FORMAT_R9G9B9E5_SHAREDEXP: return 4;
 		case DXGI_FORMAT_R16G16_UNORM: return 4;
+		case DXGI_FORMAT_R16G16_FLOAT: return 4;
 		case DXGI_FORMAT_R8G8B8A8_UNORM: return 4;
 		case DXGI_FORMAT_R24G8_TYPELESS:  return 4;
 		case DXGI_FORMAT_R32_FLOAT:  return 4;
@@ -27,6 +29,30 @@ namespace GFX
 		return 0;
 	}
 
+	// Bytes of a 4x4 block, 0 if the format isn't block compressed
+	static unsigned int ToBlockSize(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: return 8;
+		case DXGI_FORMAT_BC5_UNORM: return 16;
+		case DXGI_FORMAT_BC7_UNORM: return 16;
+		default: return 0;
+		}
+	}
+
+	// Block compressed formats have rows of blocks
+	static unsigned int ToRowPitch(DXGI_FORMAT format, uint32_t width)
+	{
+		const unsigned int blockSize = ToBlockSize(format);
+		return blockSize ? (width + 3) / 4 * blockSize : width * ToBPP(format);
+	}
+
+	static unsigned int ToNumRows(DXGI_FORMAT format, uint32_t height)
+	{
+		return ToBlockSize(format) ? (height + 3) / 4 : height;
+	}
+
 	// Depth format hack
 	constexpr DXGI_FORMAT DepthFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 	constexpr DXGI_FORMAT DepthViewFormat = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
@@ -217,8 +243,8 @@ namespace GFX
 		tex->Height = height;
 		tex->NumMips = numMips;
 		tex->DepthOrArraySize = 1;
-		tex->RowPitch = tex->Width * ToBPP(format);
-		tex->SlicePitch = tex->RowPitch * height;
+		tex->RowPitch = ToRowPitch(format, tex->Width);
+		tex->SlicePitch = tex->RowPitch * ToNumRows(format, height);
 		tex->CurrState = D3D12_RESOURCE_STATE_COMMON;
 		CreateTextureResources(tex, initData);
 		return tex;
@@ -234,8 +260,8 @@ namespace GFX
 		tex->Height = height;
 		tex->NumMips = numMips;
 		tex->DepthOrArraySize = numElements;
-		tex->RowPitch = width * ToBPP(format);
-		tex->SlicePitch = tex->RowPitch * height;
+		tex->RowPitch = ToRowPitch(format, width);
+		tex->SlicePitch = tex->RowPitch * ToNumRows(format, height);
 		tex->CurrState = D3D12_RESOURCE_STATE_COMMON;
 		CreateTextureResources(tex, nullptr);
 
@@ -252,12 +278,12 @@ namespace GFX
 		return MipSlice + ArraySlice * MipLevels + PlaneSlice * MipLevels * ArraySize;
 	}
 
-	static uint32_t GetSubresourceHash(uint32_t firstMip, uint32_t lastMip, uint32_t firstElement, uint32_t lastElement)
+	static uint64_t GetSubresourceHash(uint32_t firstMip, uint32_t lastMip, uint32_t firstElement, uint32_t lastElement)
 	{
-		uint32_t h = Hash::Crc32(firstMip);
-		h = Hash::Crc32(h, lastMip);
-		h = Hash::Crc32(h, firstElement);
-		h = Hash::Crc32(h, lastElement);
+		uint64_t h = Hash::XXHash64(firstMip);
+		h = Hash::XXHash64(h, lastMip);
+		h = Hash::XXHash64(h, firstElement);
+		h = Hash::XXHash64(h, lastElement);
 		return h;
 	}
 
@@ -285,7 +311,7 @@ namespace GFX
 		subres->FirstElement = firstElement;
 		subres->LastElement = lastElement;
 
-		const uint32_t subresHash = GetSubresourceHash(firstMip, lastMip, firstElement, lastElement);
+		const uint64_t subresHash = GetSubresourceHash(firstMip, lastMip, firstElement, lastElement);
 		if (!resource->Subresources.contains(subresHash))
 		{
 			const uint32_t mipCount = lastMip - firstMip + 1;
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <iostream>
+
+// Asserts without the rest of Common.h, so the code shared with the tools builds without D3D12
+#ifdef DEBUG
+#ifdef _MSC_VER
+#define DEBUG_BREAK() __debugbreak()
+#else
+#define DEBUG_BREAK() __builtin_trap()
+#endif // _MSC_VER
+#define ASSERT(X,msg) if(!(X)) { std::cout << msg << std::endl; DEBUG_BREAK(); }
+#define NOT_IMPLEMENTED ASSERT(0, "NOT IMPLEMENTED")
+#else
+#define ASSERT(X, MSG) {}
+#define NOT_IMPLEMENTED {}
+#endif // DEBUG
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace MTR
+{
+	// Objects that are expensive to create, shared by all threads and looked up by the 64 bit hash of their description
+	// Lookups only take the shared lock of one shard, the threads that ask for the same missing object wait for the one that creates it
+	// Doesn't depend on D3D12 so the locking can be used with any value
+	template<typename Value, uint32_t ShardCount = 16>
+	class ConcurrentCache
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t NumHits = 0;
+			uint64_t NumMisses = 0;
+
+			// Hits that found the object still being created by the other thread
+			uint64_t NumSharedCreations = 0;
+
+			// Sum of the time spent in the creation functions
+			float CreationTimeMS = 0.0f;
+		};
+
+		// create() is called outside of the lock, at most once per key
+		// Reference stays valid until Clear
+		template<typename CreateFunc>
+		const Value& GetOrCreate(uint64_t key, CreateFunc create)
+		{
+			Shard& shard = m_Shards[key % ShardCount];
+
+			// Entry is copied out of the lock, waiting for the creation doesn't block the other keys of the shard
+			std::shared_future<Value> entry;
+			{
+				std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+				const auto it = shard.Entries.find(key);
+				if (it != shard.Entries.end()) entry = it->second;
+			}
+			if (entry.valid()) return GetExisting(entry);
+
+			std::promise<Value> promise;
+			{
+				std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+				// Other thread could have added it between the locks
+				const auto it = shard.Entries.find(key);
+				if (it != shard.Entries.end()) entry = it->second;
+				else shard.Entries[key] = promise.get_future().share();
+			}
+			if (entry.valid()) return GetExisting(entry);
+
+			m_NumMisses++;
+			const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+			promise.set_value(create());
+			m_CreationTimeNS += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+			std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+			return shard.Entries.find(key)->second.get();
+		}
+
+		Statistics GetStatistics() const
+		{
+			Statistics statistics{};
+			statistics.NumHits = m_NumHits;
+			statistics.NumMisses = m_NumMisses;
+			statistics.NumSharedCreations = m_NumSharedCreations;
+			statistics.CreationTimeMS = m_CreationTimeNS / 1000000.0f;
+			return statistics;
+		}
+
+		size_t GetSize() const
+		{
+			size_t size = 0;
+			for (const Shard& shard : m_Shards)
+			{
+				std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+				size += shard.Entries.size();
+			}
+			return size;
+		}
+
+		// Expects that no other thread uses the cache
+		void Clear()
+		{
+			for (Shard& shard : m_Shards)
+			{
+				std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+				shard.Entries.clear();
+			}
+		}
+
+	private:
+		// Value lives in the shared state of the future that the map keeps alive, the reference stays valid on rehash
+		const Value& GetExisting(const std::shared_future<Value>& entry)
+		{
+			if (entry.wait_for(std::chrono::seconds(0)) != std::future_status::ready) m_NumSharedCreations++;
+			m_NumHits++;
+			return entry.get();
+		}
+
+		struct Shard
+		{
+			mutable std::shared_mutex Mutex;
+			std::unordered_map<uint64_t, std::shared_future<Value>> Entries;
+		};
+
+		std::array<Shard, ShardCount> m_Shards;
+
+		std::atomic<uint64_t> m_NumHits = 0;
+		std::atomic<uint64_t> m_NumMisses = 0;
+		std::atomic<uint64_t> m_NumSharedCreations = 0;
+		std::atomic<uint64_t> m_CreationTimeNS = 0;
+	};
+}
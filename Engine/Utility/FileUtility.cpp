@@ -0,0 +1,72 @@
+#include "FileUtility.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace FileUtility
+{
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER fileSize{};
+		HANDLE mapping = nullptr;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+
+		// View keeps the file mapped after the handles are closed
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		if (!view) return false;
+
+		m_Data = static_cast<const uint8_t*>(view);
+		m_Size = (size_t) fileSize.QuadPart;
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) return false;
+
+		struct stat fileStat{};
+		void* view = MAP_FAILED;
+		if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			view = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		}
+		close(file);
+		if (view == MAP_FAILED) return false;
+
+		madvise(view, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+
+		m_Data = static_cast<const uint8_t*>(view);
+		m_Size = (size_t) fileStat.st_size;
+#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (!m_Data) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_Data);
+#else
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}
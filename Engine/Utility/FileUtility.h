@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+namespace FileUtility
+{
+	inline bool FileExists(const std::string& path)
+	{
+		std::error_code error;
+		return std::filesystem::is_regular_file(path, error);
+	}
+
+	inline bool ReadBinaryFile(const std::string& path, std::vector<uint8_t>& data)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		const std::streamsize size = file.tellg();
+		if (size < 0) return false;
+
+		data.resize((size_t) size);
+		file.seekg(0, std::ios::beg);
+		return size == 0 || (bool) file.read(reinterpret_cast<char*>(data.data()), size);
+	}
+
+	// Creates missing directories on the path
+	inline bool WriteBinaryFile(const std::string& path, const void* data, size_t size)
+	{
+		std::error_code error;
+		const std::filesystem::path parentPath = std::filesystem::path(path).parent_path();
+		if (!parentPath.empty()) std::filesystem::create_directories(parentPath, error);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		file.write(reinterpret_cast<const char*>(data), size);
+		return (bool) file;
+	}
+
+	// Sequential reader over the file content, every read fails after the first out of bounds access
+	class BinaryReader
+	{
+	public:
+		BinaryReader(const std::vector<uint8_t>& data) : m_Data(data) {}
+
+		bool Read(void* dst, size_t size)
+		{
+			if (!m_Valid || m_Offset + size > m_Data.size())
+			{
+				m_Valid = false;
+				return false;
+			}
+
+			if (size > 0) memcpy(dst, m_Data.data() + m_Offset, size);
+			m_Offset += size;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& value) { return Read(&value, sizeof(T)); }
+
+		template<typename T>
+		bool ReadArray(std::vector<T>& values, size_t count)
+		{
+			if (!m_Valid || count > (m_Data.size() - m_Offset) / sizeof(T))
+			{
+				m_Valid = false;
+				return false;
+			}
+
+			values.resize(count);
+			return Read(values.data(), count * sizeof(T));
+		}
+
+		bool IsValid() const { return m_Valid; }
+		bool IsAtEnd() const { return m_Offset == m_Data.size(); }
+
+	private:
+		const std::vector<uint8_t>& m_Data;
+		size_t m_Offset = 0;
+		bool m_Valid = true;
+	};
+
+	// Read only mapping of the whole file, the OS reads the pages when they are first accessed
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Fails for empty files
+		bool Open(const std::string& path);
+		void Close();
+
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+		bool IsOpen() const { return m_Data != nullptr; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+
+	class BinaryWriter
+	{
+	public:
+		void Write(const void* src, size_t size)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+			m_Data.insert(m_Data.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		void Write(const T& value) { Write(&value, sizeof(T)); }
+
+		template<typename T>
+		void WriteArray(const std::vector<T>& values) { Write(values.data(), values.size() * sizeof(T)); }
+
+		const std::vector<uint8_t>& GetData() const { return m_Data; }
+
+	private:
+		std::vector<uint8_t> m_Data;
+	};
+}
\ No newline at end of file
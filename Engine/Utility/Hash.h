@@ -1,6 +1,23 @@
 #pragma once
 
 #include <inttypes.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define HASH_HARDWARE_CRC32C
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HASH_TARGET_SSE42
+#else
+#include <nmmintrin.h>
+#include <cpuid.h>
+#define HASH_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
 
 namespace Hash
 {
@@ -69,6 +86,281 @@ namespace Hash
 		return Crc32(0xFFFFFFFF, bytes, byteSize);
 	}
 
+	// 64 bit FNV-1a, for content addressed keys where 32 bit collisions are too likely
+	inline uint64_t Fnv1a64(const uint8_t* bytes, size_t byteSize, uint64_t hash = 0xcbf29ce484222325ull)
+	{
+		for (size_t i = 0; i < byteSize; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	uint64_t Fnv1a64(const uint64_t hash, const T& data)
+	{
+		return Fnv1a64(reinterpret_cast<const uint8_t*>(&data), sizeof(T), hash);
+	}
+
+	template<typename T>
+	uint64_t Fnv1a64(const T& data)
+	{
+		return Fnv1a64(reinterpret_cast<const uint8_t*>(&data), sizeof(T));
+	}
+
+	// 64 bit xxHash (XXH64), several times faster than FNV-1a on anything longer than a few bytes
+	// Use it for the keys that are hashed every frame, previous hash is the seed when the keys are chained
+	namespace Private
+	{
+		constexpr uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ull;
+		constexpr uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4Full;
+		constexpr uint64_t XXH_PRIME3 = 0x165667B19E3779F9ull;
+		constexpr uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ull;
+		constexpr uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ull;
+
+		inline uint64_t Read64(const uint8_t* bytes) { uint64_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+		inline uint32_t Read32(const uint8_t* bytes) { uint32_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+
+		inline uint64_t XXHRound(uint64_t acc, uint64_t input)
+		{
+			acc += input * XXH_PRIME2;
+			acc = std::rotl(acc, 31);
+			return acc * XXH_PRIME1;
+		}
+
+		inline uint64_t XXHMergeRound(uint64_t acc, uint64_t value)
+		{
+			acc ^= XXHRound(0, value);
+			return acc * XXH_PRIME1 + XXH_PRIME4;
+		}
+
+		// Consumes the stripes of 32 bytes, returns the number of consumed bytes
+		inline size_t XXHStripes(uint64_t (&acc)[4], const uint8_t* bytes, size_t byteSize)
+		{
+			size_t offset = 0;
+			for (; offset + 32 <= byteSize; offset += 32)
+			{
+				acc[0] = XXHRound(acc[0], Read64(bytes + offset));
+				acc[1] = XXHRound(acc[1], Read64(bytes + offset + 8));
+				acc[2] = XXHRound(acc[2], Read64(bytes + offset + 16));
+				acc[3] = XXHRound(acc[3], Read64(bytes + offset + 24));
+			}
+			return offset;
+		}
+
+		inline uint64_t XXHFinalize(uint64_t hash, const uint8_t* bytes, size_t byteSize)
+		{
+			for (; byteSize >= 8; bytes += 8, byteSize -= 8)
+			{
+				hash ^= XXHRound(0, Read64(bytes));
+				hash = std::rotl(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+			}
+			if (byteSize >= 4)
+			{
+				hash ^= (uint64_t) Read32(bytes) * XXH_PRIME1;
+				hash = std::rotl(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+				bytes += 4;
+				byteSize -= 4;
+			}
+			for (; byteSize > 0; bytes++, byteSize--)
+			{
+				hash ^= *bytes * XXH_PRIME5;
+				hash = std::rotl(hash, 11) * XXH_PRIME1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= XXH_PRIME2;
+			hash ^= hash >> 29;
+			hash *= XXH_PRIME3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		inline uint64_t XXHMergeAccumulators(const uint64_t (&acc)[4])
+		{
+			uint64_t hash = std::rotl(acc[0], 1) + std::rotl(acc[1], 7) + std::rotl(acc[2], 12) + std::rotl(acc[3], 18);
+			for (uint64_t value : acc) hash = XXHMergeRound(hash, value);
+			return hash;
+		}
+	}
+
+	inline uint64_t XXHash64(const uint8_t* bytes, size_t byteSize, uint64_t seed = 0)
+	{
+		uint64_t hash;
+		size_t offset = 0;
+		if (byteSize >= 32)
+		{
+			uint64_t acc[4] = { seed + Private::XXH_PRIME1 + Private::XXH_PRIME2, seed + Private::XXH_PRIME2, seed, seed - Private::XXH_PRIME1 };
+			offset = Private::XXHStripes(acc, bytes, byteSize);
+			hash = Private::XXHMergeAccumulators(acc);
+		}
+		else
+		{
+			hash = seed + Private::XXH_PRIME5;
+		}
+
+		hash += byteSize;
+		return Private::XXHFinalize(hash, bytes + offset, byteSize - offset);
+	}
+
+	template<typename T>
+	uint64_t XXHash64(const uint64_t hash, const T& data)
+	{
+		return XXHash64(reinterpret_cast<const uint8_t*>(&data), sizeof(T), hash);
+	}
+
+	template<typename T>
+	uint64_t XXHash64(const T& data)
+	{
+		return XXHash64(reinterpret_cast<const uint8_t*>(&data), sizeof(T));
+	}
+
+	template<>
+	inline uint64_t XXHash64<std::string>(const std::string& data)
+	{
+		return XXHash64(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+	}
+
+	template<>
+	inline uint64_t XXHash64<std::string>(const uint64_t hash, const std::string& data)
+	{
+		return XXHash64(reinterpret_cast<const uint8_t*>(data.data()), data.size(), hash);
+	}
+
+	// Same result as XXHash64 over all of the added bytes, for data that isn't in one piece
+	class XXHash64Stream
+	{
+	public:
+		explicit XXHash64Stream(uint64_t seed = 0) :
+			m_Seed(seed),
+			m_Acc{ seed + Private::XXH_PRIME1 + Private::XXH_PRIME2, seed + Private::XXH_PRIME2, seed, seed - Private::XXH_PRIME1 }
+		{}
+
+		void Add(const uint8_t* bytes, size_t byteSize)
+		{
+			m_TotalSize += byteSize;
+
+			// Stripe started by the previous call
+			if (m_BufferSize != 0)
+			{
+				const size_t toCopy = std::min(byteSize, sizeof(m_Buffer) - m_BufferSize);
+				memcpy(m_Buffer + m_BufferSize, bytes, toCopy);
+				m_BufferSize += toCopy;
+				bytes += toCopy;
+				byteSize -= toCopy;
+
+				if (m_BufferSize < sizeof(m_Buffer)) return;
+				Private::XXHStripes(m_Acc, m_Buffer, sizeof(m_Buffer));
+				m_BufferSize = 0;
+			}
+
+			const size_t consumed = Private::XXHStripes(m_Acc, bytes, byteSize);
+			m_BufferSize = byteSize - consumed;
+			if (m_BufferSize != 0) memcpy(m_Buffer, bytes + consumed, m_BufferSize);
+		}
+
+		template<typename T>
+		void Add(const T& data)
+		{
+			Add(reinterpret_cast<const uint8_t*>(&data), sizeof(T));
+		}
+
+		uint64_t GetHash() const
+		{
+			uint64_t hash = m_TotalSize >= 32 ? Private::XXHMergeAccumulators(m_Acc) : m_Seed + Private::XXH_PRIME5;
+			hash += m_TotalSize;
+			return Private::XXHFinalize(hash, m_Buffer, m_BufferSize);
+		}
+
+	private:
+		uint64_t m_Seed;
+		uint64_t m_Acc[4];
+		uint8_t m_Buffer[32];
+		size_t m_BufferSize = 0;
+		uint64_t m_TotalSize = 0;
+	};
+
+	// CRC32C (Castagnoli), uses the SSE 4.2 instruction when the CPU has it, the result is the same either way
+	// Previous result is passed to continue the checksum over the next bytes
+	namespace Private
+	{
+		constexpr std::array<uint32_t, 256> MakeCrc32CTable()
+		{
+			std::array<uint32_t, 256> table{};
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (uint32_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+				table[i] = crc;
+			}
+			return table;
+		}
+		inline constexpr std::array<uint32_t, 256> CRC32C = MakeCrc32CTable();
+
+		inline uint32_t Crc32CSoftware(uint32_t crc, const uint8_t* bytes, size_t byteSize)
+		{
+			for (size_t i = 0; i < byteSize; i++)
+			{
+				crc = (crc >> 8) ^ CRC32C[(crc ^ bytes[i]) & 0xff];
+			}
+			return crc;
+		}
+
+#ifdef HASH_HARDWARE_CRC32C
+		inline bool HasHardwareCrc32C()
+		{
+			static const bool supported = []
+			{
+#if defined(_MSC_VER)
+				int info[4];
+				__cpuid(info, 1);
+				return (info[2] & (1 << 20)) != 0;
+#else
+				unsigned int eax, ebx, ecx, edx;
+				return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+#endif
+			}();
+			return supported;
+		}
+
+		HASH_TARGET_SSE42 inline uint32_t Crc32CHardware(uint32_t crc, const uint8_t* bytes, size_t byteSize)
+		{
+			uint64_t crc64 = crc;
+			for (; byteSize >= 8; bytes += 8, byteSize -= 8)
+			{
+				crc64 = _mm_crc32_u64(crc64, Read64(bytes));
+			}
+			crc = (uint32_t) crc64;
+			for (; byteSize > 0; bytes++, byteSize--)
+			{
+				crc = _mm_crc32_u8(crc, *bytes);
+			}
+			return crc;
+		}
+#endif
+	}
+
+	inline uint32_t Crc32C(const uint8_t* bytes, size_t byteSize, uint32_t crc = 0)
+	{
+#ifdef HASH_HARDWARE_CRC32C
+		if (Private::HasHardwareCrc32C()) return ~Private::Crc32CHardware(~crc, bytes, byteSize);
+#endif
+		return ~Private::Crc32CSoftware(~crc, bytes, byteSize);
+	}
+
+	template<typename T>
+	uint32_t Crc32C(const uint32_t crc, const T& data)
+	{
+		return Crc32C(reinterpret_cast<const uint8_t*>(&data), sizeof(T), crc);
+	}
+
+	template<typename T>
+	uint32_t Crc32C(const T& data)
+	{
+		return Crc32C(reinterpret_cast<const uint8_t*>(&data), sizeof(T));
+	}
+
 	template<typename T>
 	uint32_t Crc32(const uint32_t crc32, const T& data)
 	{
@@ -82,14 +374,14 @@ namespace Hash
 	}
 
 	template<>
-	uint32_t Crc32<std::string>(const std::string& data)
+	inline uint32_t Crc32<std::string>(const std::string& data)
 	{
 		static_assert(sizeof(uint8_t) == sizeof(char));
 		return Crc32(reinterpret_cast<const uint8_t*>(data.c_str()), data.size());
 	}
 
 	template<>
-	uint32_t Crc32<std::string>(uint32_t crc32, const std::string& data)
+	inline uint32_t Crc32<std::string>(uint32_t crc32, const std::string& data)
 	{
 		static_assert(sizeof(uint8_t) == sizeof(char));
 		return Crc32(crc32, reinterpret_cast<const uint8_t*>(data.c_str()), data.size());
@@ -0,0 +1,242 @@
+#include "LZ4.h"
+
+#include <bit>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+
+namespace LZ4
+{
+	namespace
+	{
+		constexpr size_t MIN_MATCH = 4;
+		constexpr size_t MAX_OFFSET = 65535;
+
+		// Required by the format so the reference decompressor can copy past the end of the matches
+		constexpr size_t LAST_LITERALS = 5;
+		constexpr size_t MATCH_FIND_LIMIT = 12;
+
+		constexpr uint32_t HASH_BITS = 16;
+		constexpr uint32_t RUN_MASK = 15;
+
+		inline uint32_t Read32(const uint8_t* bytes) { uint32_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+		inline uint64_t Read64(const uint8_t* bytes) { uint64_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+
+		inline uint32_t HashSequence(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		// Length past the nibble of the token, 255 continues to the next byte
+		uint8_t* WriteLength(uint8_t* dst, size_t length)
+		{
+			for (; length >= 255; length -= 255) *dst++ = 255;
+			*dst++ = (uint8_t) length;
+			return dst;
+		}
+
+		uint8_t* WriteLiterals(uint8_t* dst, uint8_t& token, const uint8_t* literals, size_t numLiterals)
+		{
+			if (numLiterals >= RUN_MASK)
+			{
+				token = RUN_MASK << 4;
+				dst = WriteLength(dst, numLiterals - RUN_MASK);
+			}
+			else
+			{
+				token = (uint8_t) (numLiterals << 4);
+			}
+
+			if (numLiterals > 0) memcpy(dst, literals, numLiterals);
+			return dst + numLiterals;
+		}
+
+		uint8_t* WriteSequence(uint8_t* dst, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+		{
+			uint8_t& token = *dst++;
+			dst = WriteLiterals(dst, token, literals, numLiterals);
+
+			*dst++ = (uint8_t) (offset & 0xff);
+			*dst++ = (uint8_t) (offset >> 8);
+
+			const size_t length = matchLength - MIN_MATCH;
+			if (length >= RUN_MASK)
+			{
+				token |= RUN_MASK;
+				dst = WriteLength(dst, length - RUN_MASK);
+			}
+			else
+			{
+				token |= (uint8_t) length;
+			}
+			return dst;
+		}
+
+		// Compares 8 bytes at a time, the first different byte is the lowest set bit of the difference
+		size_t CountMatch(const uint8_t* a, const uint8_t* b, const uint8_t* aLimit)
+		{
+			const uint8_t* start = a;
+			while (a + sizeof(uint64_t) <= aLimit)
+			{
+				const uint64_t difference = Read64(a) ^ Read64(b);
+				if (difference) return (a - start) + std::countr_zero(difference) / 8;
+
+				a += sizeof(uint64_t);
+				b += sizeof(uint64_t);
+			}
+
+			while (a < aLimit && *a == *b)
+			{
+				a++;
+				b++;
+			}
+			return a - start;
+		}
+
+		// Reads the continuation bytes of the length, fails if the block ends first
+		bool ReadLength(const uint8_t* src, size_t srcSize, size_t& offset, size_t& length)
+		{
+			uint8_t value = 0;
+			do
+			{
+				if (offset >= srcSize) return false;
+				value = src[offset++];
+				length += value;
+			} while (value == 255);
+			return true;
+		}
+
+		// Source and destination overlap when the offset is shorter than the match
+		void CopyMatch(uint8_t* dst, size_t dstSize, size_t position, size_t offset, size_t length)
+		{
+			constexpr size_t COPY_SIZE = 16;
+
+			uint8_t* op = dst + position;
+			const uint8_t* match = op - offset;
+			uint8_t* const end = op + length;
+
+			if (position + length + COPY_SIZE > dstSize)
+			{
+				while (op < end) *op++ = *match++;
+				return;
+			}
+
+			// Match repeats every offset bytes, so once the first repeats are written any multiple of the offset gives the same bytes
+			if (offset < sizeof(uint64_t))
+			{
+				const size_t distance = offset * ((sizeof(uint64_t) + offset - 1) / offset);
+				uint8_t* const patternEnd = op + std::min(length, distance);
+				while (op < patternEnd) *op++ = *match++;
+				match = op - distance;
+			}
+
+			// Copies up to 15 bytes past the match, they're overwritten by the next sequence
+			if ((size_t) (op - match) >= COPY_SIZE)
+			{
+				for (; op < end; op += COPY_SIZE, match += COPY_SIZE) memcpy(op, match, COPY_SIZE);
+			}
+			else
+			{
+				for (; op < end; op += sizeof(uint64_t), match += sizeof(uint64_t)) memcpy(op, match, sizeof(uint64_t));
+			}
+		}
+	}
+
+	size_t GetMaxCompressedSize(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	size_t Compress(const uint8_t* src, size_t size, uint8_t* dst)
+	{
+		uint8_t* op = dst;
+		size_t anchor = 0;
+
+		// Positions are stored one higher so 0 is an empty slot, blocks are limited to 4 GB
+		std::vector<uint32_t> hashTable;
+
+		if (size > MATCH_FIND_LIMIT)
+		{
+			hashTable.resize((size_t) 1 << HASH_BITS, 0);
+
+			const size_t lastMatchStart = size - MATCH_FIND_LIMIT;
+			const uint8_t* matchLimit = src + size - LAST_LITERALS;
+
+			size_t position = 0;
+			while (position <= lastMatchStart)
+			{
+				const uint32_t sequence = Read32(src + position);
+				uint32_t& slot = hashTable[HashSequence(sequence)];
+				const size_t candidate = slot;
+				slot = (uint32_t) position + 1;
+
+				if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != sequence)
+				{
+					// Steps get longer the longer nothing matches, incompressible data goes through quickly
+					position += 1 + ((position - anchor) >> 6);
+					continue;
+				}
+
+				size_t match = candidate - 1;
+				size_t matchStart = position;
+				while (matchStart > anchor && match > 0 && src[matchStart - 1] == src[match - 1])
+				{
+					matchStart--;
+					match--;
+				}
+
+				const size_t matchLength = (position - matchStart) + MIN_MATCH + CountMatch(src + position + MIN_MATCH, src + candidate - 1 + MIN_MATCH, matchLimit);
+				op = WriteSequence(op, src + anchor, matchStart - anchor, matchStart - match, matchLength);
+
+				position = matchStart + matchLength;
+				anchor = position;
+
+				// Position inside of the match helps the next one to find a longer reference
+				if (position - 2 <= lastMatchStart) hashTable[HashSequence(Read32(src + position - 2))] = (uint32_t) (position - 2) + 1;
+			}
+		}
+
+		uint8_t& token = *op++;
+		op = WriteLiterals(op, token, src + anchor, size - anchor);
+		return op - dst;
+	}
+
+	bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		size_t ip = 0;
+		size_t op = 0;
+		while (ip < srcSize)
+		{
+			const uint8_t token = src[ip++];
+
+			size_t numLiterals = token >> 4;
+			if (numLiterals == RUN_MASK && !ReadLength(src, srcSize, ip, numLiterals)) return false;
+			if (numLiterals > srcSize - ip || numLiterals > dstSize - op) return false;
+
+			// Short literals are copied with a fixed size, the bytes past them are overwritten later
+			if (numLiterals < RUN_MASK && srcSize - ip >= 16 && dstSize - op >= 16) memcpy(dst + op, src + ip, 16);
+			else if (numLiterals > 0) memcpy(dst + op, src + ip, numLiterals);
+			ip += numLiterals;
+			op += numLiterals;
+
+			// Last sequence has only the literals
+			if (ip == srcSize) return op == dstSize;
+
+			if (srcSize - ip < 2) return false;
+			const size_t offset = src[ip] | ((size_t) src[ip + 1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > op) return false;
+
+			size_t matchLength = token & RUN_MASK;
+			if (matchLength == RUN_MASK && !ReadLength(src, srcSize, ip, matchLength)) return false;
+			matchLength += MIN_MATCH;
+			if (matchLength > dstSize - op) return false;
+
+			CopyMatch(dst, dstSize, op, offset, matchLength);
+			op += matchLength;
+		}
+
+		// Empty input isn't a valid block, even the empty block has a token
+		return false;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compressor and decompressor of the LZ4 block format, blocks are compatible with the reference LZ4 library
+// Fast enough to decompress faster than the disk reads, the compression is the greedy single probe of LZ4 level 1
+// Expects a little endian CPU
+namespace LZ4
+{
+	// Largest compressed size of the incompressible data
+	size_t GetMaxCompressedSize(size_t size);
+
+	// Dst has to hold GetMaxCompressedSize(size) bytes, returns the compressed size
+	size_t Compress(const uint8_t* src, size_t size, uint8_t* dst);
+
+	// Fails if the block is malformed or doesn't decompress to exactly dstSize bytes, never reads or writes out of the buffers
+	bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+}
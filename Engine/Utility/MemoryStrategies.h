@@ -2,8 +2,13 @@
 
 #include <stack>
 #include <list>
+#include <algorithm>
+#include <set>
+#include <vector>
 #include <mutex>
 
+#include "Utility/Assert.h"
+
 static constexpr size_t INVALID_ALLOCATION = static_cast<size_t>(-1);
 
 struct PageAllocation
@@ -18,6 +23,15 @@ struct RangeAllocation
 	size_t NumElements = INVALID_ALLOCATION;
 };
 
+struct AtlasAllocation
+{
+	uint32_t X = 0;
+	uint32_t Y = 0;
+	uint32_t Size = 0; // Size 0 means that allocation is not valid
+
+	bool IsValid() const { return Size != 0; }
+};
+
 class ElementStrategy
 {
 public:
@@ -204,4 +218,185 @@ public:
 private:
 	size_t m_NumElements = 0;
 	size_t m_NextAllocation = 0;
+};
+
+// Linear allocation of ranges in a buffer that grows when they don't fit, the owner resizes the buffer to the capacity
+// Reserve grows it to exactly what is needed, allocations that don't fit grow it by half so repeated additions are amortized
+class GrowingRangeStrategy
+{
+public:
+	GrowingRangeStrategy(size_t capacity = 0) :
+		m_Capacity(capacity) {}
+
+	// Makes room for numElements more elements, the next allocations that fit into it don't grow the buffer
+	void Reserve(size_t numElements)
+	{
+		if (m_Size + numElements > m_Capacity) Grow(m_Size + numElements);
+	}
+
+	RangeAllocation Allocate(size_t numElements)
+	{
+		const size_t requiredCapacity = m_Size + numElements;
+		if (requiredCapacity > m_Capacity) Grow(std::max(requiredCapacity, m_Capacity + m_Capacity / 2));
+
+		RangeAllocation alloc{};
+		alloc.Start = m_Size;
+		alloc.NumElements = numElements;
+		m_Size += numElements;
+		return alloc;
+	}
+
+	// Capacity is kept
+	void Clear()
+	{
+		m_Size = 0;
+	}
+
+	size_t GetSize() const { return m_Size; }
+	size_t GetCapacity() const { return m_Capacity; }
+	uint32_t GetNumGrowths() const { return m_NumGrowths; }
+
+private:
+	void Grow(size_t capacity)
+	{
+		m_Capacity = capacity;
+		m_NumGrowths++;
+	}
+
+private:
+	size_t m_Size = 0;
+	size_t m_Capacity = 0;
+	uint32_t m_NumGrowths = 0;
+};
+
+// Allocates square power of 2 tiles inside of a square power of 2 atlas
+// Every node is split in 4 children and free siblings are merged back on release
+class QuadTreeStrategy
+{
+public:
+	QuadTreeStrategy(uint32_t atlasSize, uint32_t minTileSize) :
+		m_AtlasSize(atlasSize),
+		m_MinTileSize(minTileSize)
+	{
+		ASSERT(atlasSize >= minTileSize, "[QuadTreeStrategy] Min tile size is bigger than the atlas!");
+
+		uint32_t numLevels = 1;
+		for (uint32_t size = atlasSize; size > minTileSize; size /= 2) numLevels++;
+		m_FreeNodes.resize(numLevels);
+
+		Clear();
+	}
+
+	AtlasAllocation Allocate(uint32_t tileSize)
+	{
+		const uint32_t level = GetLevel(tileSize);
+		if (level == INVALID_LEVEL) return {};
+
+		// Find the smallest free node that can fit the tile
+		int32_t freeLevel = (int32_t) level;
+		while (freeLevel >= 0 && m_FreeNodes[freeLevel].empty()) freeLevel--;
+		if (freeLevel < 0) return {};
+
+		// Nodes are sorted by (y,x) so we are always filling the atlas from the top left
+		std::set<uint64_t>& freeNodes = m_FreeNodes[freeLevel];
+		const uint64_t node = *freeNodes.begin();
+		freeNodes.erase(freeNodes.begin());
+
+		const uint32_t x = GetNodeX(node);
+		const uint32_t y = GetNodeY(node);
+
+		// Split the node until we get to the requested size
+		for (uint32_t l = freeLevel + 1; l <= level; l++)
+		{
+			const uint32_t childSize = m_AtlasSize >> l;
+			m_FreeNodes[l].insert(GetNodeKey(x + childSize, y));
+			m_FreeNodes[l].insert(GetNodeKey(x, y + childSize));
+			m_FreeNodes[l].insert(GetNodeKey(x + childSize, y + childSize));
+		}
+
+		m_UsedArea += (uint64_t) tileSize * tileSize;
+
+		AtlasAllocation alloc{};
+		alloc.X = x;
+		alloc.Y = y;
+		alloc.Size = tileSize;
+		return alloc;
+	}
+
+	void Release(AtlasAllocation& alloc)
+	{
+		if (!alloc.IsValid()) return;
+
+		uint32_t level = GetLevel(alloc.Size);
+		uint32_t x = alloc.X;
+		uint32_t y = alloc.Y;
+
+		m_UsedArea -= (uint64_t) alloc.Size * alloc.Size;
+
+		// Merge with siblings while all of them are free
+		while (level > 0)
+		{
+			const uint32_t size = m_AtlasSize >> level;
+			const uint32_t parentX = x - x % (2 * size);
+			const uint32_t parentY = y - y % (2 * size);
+
+			const uint64_t nodeKey = GetNodeKey(x, y);
+			const uint64_t siblings[4] = { GetNodeKey(parentX, parentY), GetNodeKey(parentX + size, parentY), GetNodeKey(parentX, parentY + size), GetNodeKey(parentX + size, parentY + size) };
+
+			std::set<uint64_t>& freeNodes = m_FreeNodes[level];
+			bool allSiblingsFree = true;
+			for (uint64_t sibling : siblings)
+			{
+				if (sibling != nodeKey && !freeNodes.contains(sibling)) allSiblingsFree = false;
+			}
+
+			if (!allSiblingsFree) break;
+
+			for (uint64_t sibling : siblings) freeNodes.erase(sibling);
+
+			x = parentX;
+			y = parentY;
+			level--;
+		}
+
+		m_FreeNodes[level].insert(GetNodeKey(x, y));
+
+		alloc = {};
+	}
+
+	void Clear()
+	{
+		for (std::set<uint64_t>& freeNodes : m_FreeNodes) freeNodes.clear();
+		m_FreeNodes[0].insert(GetNodeKey(0, 0));
+		m_UsedArea = 0;
+	}
+
+	uint32_t GetAtlasSize() const { return m_AtlasSize; }
+	uint32_t GetMinTileSize() const { return m_MinTileSize; }
+	uint64_t GetUsedArea() const { return m_UsedArea; }
+	float GetOccupancy() const { return (float) m_UsedArea / ((uint64_t) m_AtlasSize * m_AtlasSize); }
+
+private:
+	static constexpr uint32_t INVALID_LEVEL = static_cast<uint32_t>(-1);
+
+	uint32_t GetLevel(uint32_t tileSize) const
+	{
+		uint32_t level = 0;
+		for (uint32_t size = m_AtlasSize; size > tileSize; size /= 2) level++;
+
+		const bool validSize = level < m_FreeNodes.size() && (m_AtlasSize >> level) == tileSize;
+		return validSize ? level : INVALID_LEVEL;
+	}
+
+	static uint64_t GetNodeKey(uint32_t x, uint32_t y) { return ((uint64_t) y << 32) | x; }
+	static uint32_t GetNodeX(uint64_t key) { return (uint32_t) (key & 0xffffffff); }
+	static uint32_t GetNodeY(uint64_t key) { return (uint32_t) (key >> 32); }
+
+private:
+	uint32_t m_AtlasSize = 0;
+	uint32_t m_MinTileSize = 0;
+	uint64_t m_UsedArea = 0;
+
+	// Free nodes per level, level 0 is the whole atlas
+	std::vector<std::set<uint64_t>> m_FreeNodes;
 };
\ No newline at end of file
@@ -2,10 +2,13 @@
 
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
 #include <queue>
+#include <condition_variable>
 #include <sstream>
 #include <chrono>
+#include <algorithm>
 
 namespace MTR
 {
@@ -25,6 +28,57 @@ namespace MTR
 		std::this_thread::sleep_for(std::chrono::milliseconds(duration));
 	}
 
+	inline uint32_t GetNumWorkerThreads(uint32_t numItems)
+	{
+		return std::min(std::max(std::thread::hardware_concurrency(), 1u), std::max(numItems, 1u));
+	}
+
+	// Splits [0, numItems) into one contiguous range per thread and waits for all of them
+	// func(rangeStart, rangeEnd, threadIndex) - ranges depend only on numItems and numThreads so per thread results can be combined deterministically
+	// Single thread runs the whole range on the calling thread
+	template<typename RangeFunc>
+	void ParallelFor(uint32_t numItems, uint32_t numThreads, RangeFunc func)
+	{
+		numThreads = std::min(std::max(numThreads, 1u), std::max(numItems, 1u));
+		if (numThreads == 1)
+		{
+			func(0u, numItems, 0u);
+			return;
+		}
+
+		const uint32_t itemsPerThread = (numItems + numThreads - 1) / numThreads;
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+		for (uint32_t i = 0; i < numThreads; i++)
+		{
+			const uint32_t rangeStart = std::min(i * itemsPerThread, numItems);
+			const uint32_t rangeEnd = std::min(rangeStart + itemsPerThread, numItems);
+			threads.push_back(std::thread(func, rangeStart, rangeEnd, i));
+		}
+
+		for (std::thread& thread : threads) thread.join();
+	}
+
+	template<typename RangeFunc>
+	void ParallelFor(uint32_t numItems, RangeFunc func)
+	{
+		ParallelFor(numItems, GetNumWorkerThreads(numItems), func);
+	}
+
+	// Threads take the items one at a time in the given order and wait for all of them
+	// Expensive items should come first so that none of them is left for the end while the other threads are idle
+	// func(item, threadIndex) - items finish in any order, results have to be written to the place of the item
+	template<typename ItemFunc>
+	void ParallelForEach(const std::vector<uint32_t>& order, uint32_t numThreads, ItemFunc func)
+	{
+		std::atomic<uint32_t> nextItem = 0;
+		ParallelFor(numThreads, numThreads, [&order, &nextItem, &func](uint32_t, uint32_t, uint32_t threadIndex)
+		{
+			for (uint32_t i = nextItem++; i < order.size(); i = nextItem++) func(order[i], threadIndex);
+		});
+	}
+
 	class Mutex
 	{
 	public:
@@ -136,7 +190,7 @@ namespace MTR
 		T Pop()
 		{
 			std::unique_lock<std::mutex> lock(m_Mutex);
-			m_Condition.wait(lock, [=] { return !m_Queue.empty(); });
+			m_Condition.wait(lock, [this] { return !m_Queue.empty(); });
 			T rc(std::move(m_Queue.back()));
 			m_Queue.pop_back();
 			return rc;
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
 
 namespace PathUtility
 {
@@ -18,4 +21,19 @@ namespace PathUtility
         }
         return "";
     }
+
+    // Absolute path with '/' separators and without "." and "..", so different spellings of the same file are equal
+    // Lower case on Windows where paths aren't case sensitive
+    inline std::string NormalizePath(const std::string& path)
+    {
+        std::error_code error;
+        std::filesystem::path absolutePath = std::filesystem::absolute(path, error);
+        if (error) absolutePath = path;
+
+        std::string normalized = absolutePath.lexically_normal().generic_string();
+#ifdef _WIN32
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+#endif
+        return normalized;
+    }
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Renderers/Util/VertexPipeline.h"
 #include "Renderers/Util/TextureDebugger.h"
 #include "Scene/SceneManager.h"
@@ -40,7 +41,7 @@ namespace ForwardPlusPrivate
 
 		if (Input::IsKeyJustPressed('R'))
 		{
-			GFX::ReloadAllShaders();
+			GFX::ReloadChangedShaders();
 			app->OnShaderReload(context);
 		}
 
@@ -145,24 +146,16 @@ void ForwardPlus::OnInit(GraphicsContext& context)
 		GUI::Get()->AddElement(new TextureDebuggerGUI());
 	}
 
-	// Load scene
-	{
-#ifdef DEBUG
-		const SceneSelection scene = SceneSelection::SimpleBoxes;
-#else
-		const SceneSelection scene = SceneSelection::Sponza;
-#endif
-		SceneManager::Get().LoadScene(context, scene);
-	}
-
 	// Initialize GFX resources
+	// Renderers declare their shaders for the warm-up here, so they get compiled while the scene is loading
 	{
 		PROFILE_SECTION(context, "Initialize GFX Resources");
 
 		VertPipeline = new VertexPipeline{};
 		VertPipeline->Init(context);
 
-		m_DepthResolveShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/resolve_depth.hlsl"));
+		m_DepthResolveShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/resolve_depth.hlsl")));
+		GFX::WarmUpShader(m_DepthResolveShader.get());
 
 		m_Culling.Init(context);
 		m_SkyboxRenderer.Init(context);
@@ -172,10 +165,20 @@ void ForwardPlus::OnInit(GraphicsContext& context)
 		m_GeometryRenderer.Init(context);
 		m_SSAORenderer.Init(context);
 		m_TextureDebuggerRenderer.Init(context);
+	}
 
-		OnWindowResize(context);
+	// Load scene
+	{
+#ifdef DEBUG
+		const SceneSelection scene = SceneSelection::SimpleBoxes;
+#else
+		const SceneSelection scene = SceneSelection::Sponza;
+#endif
+		SceneManager::Get().LoadScene(context, scene);
 	}
 
+	OnWindowResize(context);
+
 	if (profileLoading)
 	{
 		OPTICK_STOP_CAPTURE();
@@ -257,17 +260,20 @@ Texture* ForwardPlus::OnDraw(GraphicsContext& context)
 	// Shadow mask
 	Texture* shadowMask = m_ShadowRenderer.CalculateShadowMask(context, m_MainRT_Depth.get());
 
+	// Local light shadows
+	m_ShadowRenderer.DrawLocalShadows(context);
+
 	// Light culling
 	m_Culling.CullLights(context, m_MainRT_Depth.get());
 
-	// Irradiance map
-	Texture* irradianceMap = m_SkyboxRenderer.GetIrradianceMap();
+	// Irradiance
+	const SphericalHarmonics::SH9ColorRenderData& irradianceSH = m_SkyboxRenderer.GetIrradianceSH();
 
 	// Geometry
 	GraphicsState geometryState;
 	geometryState.RenderTargets[0] = m_MainRT_HDR.get();
 	geometryState.DepthStencil = m_MainRT_DepthMS.get();
-	m_GeometryRenderer.Draw(context, geometryState, shadowMask, m_Culling.GetVisibleLightsBuffer(), irradianceMap, ssaoTexture);
+	m_GeometryRenderer.Draw(context, geometryState, shadowMask, m_Culling.GetVisibleLightsBuffer(), irradianceSH, m_SkyboxRenderer.GetSpecularIBL(), m_SkyboxRenderer.GetBRDFLut(), ssaoTexture, m_ShadowRenderer.GetShadowAtlas(), m_ShadowRenderer.GetLocalShadowsBuffer());
 	
 	// Skybox
 	GraphicsState skyboxState{};
@@ -286,6 +292,21 @@ Texture* ForwardPlus::OnDraw(GraphicsContext& context)
 	RenderStats.MainStats = SceneManager::Get().GetSceneGraph().MainCamera.CullingData.CullingStats;
 	RenderStats.ShadowStats = SceneManager::Get().GetSceneGraph().ShadowCamera.CullingData.CullingStats;
 
+	RenderStats.MeshStorageStats = MeshStorageStatistics{};
+	for (const RenderGroup& rg : SceneManager::Get().GetSceneGraph().RenderGroups)
+	{
+		RenderStats.MeshStorageStats.NumVertices += rg.MeshData.GetVertexCount();
+		RenderStats.MeshStorageStats.NumIndices += rg.MeshData.GetIndexCount();
+		RenderStats.MeshStorageStats.Reallocations += rg.MeshData.GetNumReallocations();
+	}
+
+	const TextureStorage& textures = SceneManager::Get().GetSceneGraph().Textures;
+	const TextureRegistry::Statistics textureStats = textures.GetStatistics();
+	RenderStats.TextureStorageStats.NumTextures = textures.GetNumTextures();
+	RenderStats.TextureStorageStats.NumMisses = textureStats.NumMisses;
+	RenderStats.TextureStorageStats.NumPathHits = textureStats.NumPathHits;
+	RenderStats.TextureStorageStats.NumContentHits = textureStats.NumContentHits;
+
 	return ppResult;
 }
 
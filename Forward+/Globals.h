@@ -54,6 +54,12 @@ struct ShadingSettings
 	bool UseIBL = true;
 };
 
+struct ShadowSettings
+{
+	bool LocalShadowsEnabled = true;
+	uint32_t LocalShadowBudget = 16; // Max number of shadowed local lights per frame
+};
+
 struct RendererSettings
 {
 	AntiAliasingMode AntialiasingMode = AntiAliasingMode::MSAA;
@@ -62,6 +68,7 @@ struct RendererSettings
 	SSAOSettings SSAO;
 	CullingSettings Culling;
 	ShadingSettings Shading;
+	ShadowSettings Shadows;
 };
 
 struct CullingStatistics
@@ -73,10 +80,37 @@ struct CullingStatistics
 	uint32_t VisibleTriangles;
 };
 
+struct LocalShadowStatistics
+{
+	uint32_t ShadowedLights;
+	uint32_t RedrawnLights;
+	uint32_t Evictions;
+	uint32_t Repacks;
+	float AtlasOccupancy;
+};
+
+struct MeshStorageStatistics
+{
+	uint32_t NumVertices;
+	uint32_t NumIndices;
+	uint32_t Reallocations;
+};
+
+struct TextureStorageStatistics
+{
+	uint32_t NumTextures;
+	uint32_t NumMisses;
+	uint32_t NumPathHits;
+	uint32_t NumContentHits;
+};
+
 struct RenderStatistics
 {
 	CullingStatistics MainStats;
 	CullingStatistics ShadowStats;
+	LocalShadowStatistics LocalShadowStats;
+	MeshStorageStatistics MeshStorageStats;
+	TextureStorageStatistics TextureStorageStats;
 };
 
 extern RenderStatistics RenderStats;
@@ -145,6 +145,17 @@ void RenderSettingsGUI::Render(GraphicsContext& context)
 		}
 		
 	}
+
+	if (ImGui::CollapsingHeader("Shadows"))
+	{
+		ImGui::Checkbox("Local light shadows", &RenderSettings.Shadows.LocalShadowsEnabled);
+		if (RenderSettings.Shadows.LocalShadowsEnabled)
+		{
+			const uint32_t minBudget = 0;
+			const uint32_t maxBudget = 64;
+			ImGui::SliderScalar("Light budget", ImGuiDataType_U32, &RenderSettings.Shadows.LocalShadowBudget, &minBudget, &maxBudget);
+		}
+	}
 }
 
 // --------------------------------------------------
@@ -183,6 +194,15 @@ void RenderStatsGUI::Render(GraphicsContext& context)
 	ImGui::Separator();
 	ImGui::Text("Drawables(Shadow):   %u / %u", RenderStats.ShadowStats.VisibleDrawables, RenderStats.ShadowStats.TotalDrawables);
 	ImGui::Text("Triangles(Shadow):   %s / %s", StringUtility::RepresentNumberWithSeparator(RenderStats.ShadowStats.VisibleTriangles, ' ').c_str(), StringUtility::RepresentNumberWithSeparator(RenderStats.ShadowStats.TotalTriangles, ' ').c_str());
+	ImGui::Separator();
+	ImGui::Text("Shadowed lights  :   %u (%u redrawn)", RenderStats.LocalShadowStats.ShadowedLights, RenderStats.LocalShadowStats.RedrawnLights);
+	ImGui::Text("Shadow atlas     :   %.1f%% (%u evictions, %u repacks)", 100.0f * RenderStats.LocalShadowStats.AtlasOccupancy, RenderStats.LocalShadowStats.Evictions, RenderStats.LocalShadowStats.Repacks);
+	ImGui::Separator();
+	ImGui::Text("Mesh vertices    :   %s", StringUtility::RepresentNumberWithSeparator(RenderStats.MeshStorageStats.NumVertices, ' ').c_str());
+	ImGui::Text("Mesh indices     :   %s", StringUtility::RepresentNumberWithSeparator(RenderStats.MeshStorageStats.NumIndices, ' ').c_str());
+	ImGui::Text("Mesh reallocs    :   %u", RenderStats.MeshStorageStats.Reallocations);
+	ImGui::Text("Textures         :   %u", RenderStats.TextureStorageStats.NumTextures);
+	ImGui::Text("Texture loads    :   %u created, %u shared by path, %u shared by content", RenderStats.TextureStorageStats.NumMisses, RenderStats.TextureStorageStats.NumPathHits, RenderStats.TextureStorageStats.NumContentHits);
 }
 
 // --------------------------------------------------
@@ -10,6 +10,7 @@
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Scene/SceneManager.h"
 #include "Scene/SceneGraph.h"
 #include "Shaders/shared_definitions.h"
@@ -33,8 +34,10 @@ Culling::~Culling()
 
 void Culling::Init(GraphicsContext& context)
 {
-	m_LightCullingShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/light_culling.hlsl" });
-	m_GeometryCullingShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/geometry_culling.hlsl" });
+	m_LightCullingShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/light_culling.hlsl") });
+	m_GeometryCullingShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/geometry_culling.hlsl") });
+	GFX::WarmUpShader(m_LightCullingShader.get());
+	GFX::WarmUpShader(m_GeometryCullingShader.get());
 	UpdateResources(context);
 }
 
@@ -131,20 +134,10 @@ void Culling::CullRenderGroupGPU(GraphicsContext& context, RenderGroupType rgTyp
 
 	if (rg.Drawables.GetSize() == 0u) return;
 
-	std::vector<std::string> config{};
-	config.push_back("GEO_CULLING");
-	if (RenderSettings.Culling.GeoCullingMode == GeometryCullingMode::None) config.push_back("FORCE_VISIBLE");
-	
-	if (input.HZB && RenderSettings.Culling.GeoCullingMode == GeometryCullingMode::GPU_OcclusionCulling)
-	{
-		config.push_back("OCCLUSION_CULLING");
-	}
-
 	const DeviceSpecification& deviceSpec = Device::Get()->GetSpec();
-	if (deviceSpec.SupportWaveIntrinscs && deviceSpec.WavefrontSize >= 32)
-	{
-		config.push_back("WAVEFRONT_SIZE_GE_32");
-	}
+	const bool forceVisible = RenderSettings.Culling.GeoCullingMode == GeometryCullingMode::None;
+	const bool occlusionCulling = input.HZB && RenderSettings.Culling.GeoCullingMode == GeometryCullingMode::GPU_OcclusionCulling;
+	const bool wavefrontSizeGE32 = deviceSpec.SupportWaveIntrinscs && deviceSpec.WavefrontSize >= 32;
 
 	if(!cullData.VisibilityMaskBuffer) cullData.VisibilityMaskBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(1, 1, RCF::UAV | RCF::RAW));
 
@@ -166,7 +159,11 @@ void Culling::CullRenderGroupGPU(GraphicsContext& context, RenderGroupType rgTyp
 	cullingState.Table.CBVs[0] = cb.GetBuffer(context);
 	cullingState.Shader = m_GeometryCullingShader.get();
 	cullingState.ShaderStages = CS;
-	cullingState.ShaderConfig = config;
+	cullingState.ShaderConfig = m_GeometryCullingShader->Permutations.GetKey({
+		"GEO_CULLING",
+		forceVisible ? "FORCE_VISIBLE" : nullptr,
+		occlusionCulling ? "OCCLUSION_CULLING" : nullptr,
+		wavefrontSizeGE32 ? "WAVEFRONT_SIZE_GE_32" : nullptr });
 	cullingState.PushConstantCount = 3;
 	context.ApplyState(cullingState);
 
@@ -11,6 +11,7 @@
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Renderers/Util/TextureDebugger.h"
 #include "Scene/SceneGraph.h"
 
@@ -104,8 +105,10 @@ void DebugRenderer::Init(GraphicsContext& context)
 	m_CubeVB = ScopedRef<Buffer>(GenerateCubeVB(context));
 	m_SphereVB = ScopedRef<Buffer>(GenerateSphereVB(context));
 
-	m_DebugGeometryShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/debug_geometry.hlsl"));
-	m_LightHeatmapShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/light_heatmap.hlsl"));
+	m_DebugGeometryShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/debug_geometry.hlsl")));
+	m_LightHeatmapShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/light_heatmap.hlsl")));
+	GFX::WarmUpShader(m_DebugGeometryShader.get());
+	GFX::WarmUpShader(m_LightHeatmapShader.get());
 
 	m_DebugGeometriesBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(sizeof(DebugGeometrySB), sizeof(DebugGeometrySB), RCF::None));
 }
@@ -227,7 +230,8 @@ void DebugRenderer::DrawGeometries(GraphicsContext& context, GraphicsState& stat
 
 void TextureDebuggerRenderer::Init(GraphicsContext& context)
 {
-	m_Shader = ScopedRef<Shader>(new Shader("Forward+/Shaders/texture_debugger.hlsl"));
+	m_Shader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/texture_debugger.hlsl")));
+	GFX::WarmUpShader(m_Shader.get());
 	m_PreviewTextureDescriptor = Device::Get()->GetMemory().SRVHeap->Allocate(1);
 	m_RangeBuffer = ScopedRef<ReadbackBuffer>(new ReadbackBuffer{ 2 * sizeof(float) });
 }
@@ -276,7 +280,7 @@ void TextureDebuggerRenderer::Draw(GraphicsContext& context)
 
 		GraphicsState state{};
 		state.Shader = m_Shader.get();
-		state.ShaderConfig = { "READ_RANGE" };
+		state.ShaderConfig = m_Shader->Permutations.GetKey({ "READ_RANGE" });
 		state.ShaderStages = CS;
 		state.Table.SRVs[0] = selectedTex;
 		state.Table.UAVs[0] = m_RangeBuffer->GetWriteBuffer();
@@ -298,13 +302,6 @@ void TextureDebuggerRenderer::Draw(GraphicsContext& context)
 
 	// Texture preview
 	{
-		std::vector<std::string> config{};
-		config.push_back("TEXTURE_PREVIEW");
-		if (selectedTexture.ShowAlpha)
-		{
-			config.push_back("SHOW_ALPHA");
-		}
-
 		ConstantBuffer cb{};
 		cb.Add(selectedTexture.RangeMin);
 		cb.Add(selectedTexture.RangeMax);
@@ -312,10 +309,9 @@ void TextureDebuggerRenderer::Draw(GraphicsContext& context)
 
 		GraphicsState state{};
 		state.Shader = m_Shader.get();
-		state.ShaderConfig = config;
+		state.ShaderConfig = m_Shader->Permutations.GetKey({ "TEXTURE_PREVIEW", selectedTexture.ShowAlpha ? "SHOW_ALPHA" : nullptr });
 		state.Table.SRVs[0] = selectedTex;
 		state.Table.CBVs[0] = cb.GetBuffer(context);
-		state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_POINT , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 		state.RenderTargets[0] = m_PreviewTexture.get();
 		GFX::Cmd::DrawFC(context, state);
 	}
@@ -8,6 +8,7 @@
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Renderers/Util/VertexPipeline.h"
 #include "Scene/SceneManager.h"
 #include "Scene/SceneGraph.h"
@@ -24,8 +25,10 @@ GeometryRenderer::~GeometryRenderer()
 
 void GeometryRenderer::Init(GraphicsContext& context)
 {
-	m_DepthPrepassShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/depth.hlsl" });
-	m_GeometryShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/geometry.hlsl" });
+	m_DepthPrepassShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/depth.hlsl") });
+	m_GeometryShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/geometry.hlsl") });
+	GFX::WarmUpShader(m_DepthPrepassShader.get());
+	GFX::WarmUpShader(m_GeometryShader.get());
 	m_HzbGenerator.Init(context);
 }
 
@@ -40,7 +43,6 @@ void GeometryRenderer::DepthPrepass(GraphicsContext& context, GraphicsState& sta
 	cb.Add(SceneManager::Get().GetSceneGraph().MainCamera.LastCameraData);
 	cb.Add(SceneManager::Get().GetSceneGraph().SceneInfoData);
 
-	state.Table.SMPs[0] = { D3D12_FILTER_ANISOTROPIC , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 	state.Table.CBVs[0] = cb.GetBuffer(context);
 	state.DepthStencilState.DepthEnable = true;
 	state.Shader = m_DepthPrepassShader.get();
@@ -51,19 +53,14 @@ void GeometryRenderer::DepthPrepass(GraphicsContext& context, GraphicsState& sta
 		RenderGroupType rgType = IntToEnum<RenderGroupType>(i);
 		RenderGroup& renderGroup = SceneManager::Get().GetSceneGraph().RenderGroups[i];
 
-		std::vector<std::string> config{};
-		if (drawMotionVectors) config.push_back("MOTION_VECTORS");
-
-		if (rgType == RenderGroupType::AlphaDiscard)
-		{
-			config.push_back("ALPHA_DISCARD");
-		}
-		state.ShaderConfig = config;
+		state.ShaderConfig = m_DepthPrepassShader->Permutations.GetKey({
+			drawMotionVectors ? "MOTION_VECTORS" : nullptr,
+			rgType == RenderGroupType::AlphaDiscard ? "ALPHA_DISCARD" : nullptr });
 		VertPipeline->Draw(context, state, renderGroup, SceneManager::Get().GetSceneGraph().MainCamera.CullingData[rgType]);
 	}
 }
 
-void GeometryRenderer::Draw(GraphicsContext& context, GraphicsState& state, Texture* shadowMask, Buffer* visibleLights, Texture* irradianceMap, Texture* ambientOcclusion)
+void GeometryRenderer::Draw(GraphicsContext& context, GraphicsState& state, Texture* shadowMask, Buffer* visibleLights, const SphericalHarmonics::SH9ColorRenderData& irradianceSH, Texture* specularIBL, Texture* brdfLut, Texture* ambientOcclusion, Texture* shadowAtlas, Buffer* localShadows)
 {
 	PROFILE_SECTION(context, "Geometry");
 
@@ -80,9 +77,8 @@ void GeometryRenderer::Draw(GraphicsContext& context, GraphicsState& state, Text
 	ConstantBuffer cb{};
 	cb.Add(SceneManager::Get().GetSceneGraph().MainCamera.CameraData);
 	cb.Add(SceneManager::Get().GetSceneGraph().SceneInfoData);
+	cb.Add(irradianceSH);
 	state.Table.CBVs[0] = cb.GetBuffer(context);
-	state.Table.SMPs[0] = { D3D12_FILTER_ANISOTROPIC , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
-	state.Table.SMPs[1] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 
 	state.StencilRef = 0xff;
 	state.DepthStencilState.DepthEnable = true;
@@ -97,8 +93,11 @@ void GeometryRenderer::Draw(GraphicsContext& context, GraphicsState& state, Text
 	state.Table.SRVs[0] = SceneManager::Get().GetSceneGraph().Lights.GetBuffer();
 	state.Table.SRVs[1] = visibleLights;
 	state.Table.SRVs[2] = shadowMask;
-	state.Table.SRVs[3] = irradianceMap;
+	state.Table.SRVs[3] = specularIBL;
 	state.Table.SRVs[4] = ambientOcclusion;
+	state.Table.SRVs[5] = shadowAtlas;
+	state.Table.SRVs[6] = localShadows;
+	state.Table.SRVs[7] = brdfLut;
 
 	for (uint32_t i = 0; i < EnumToInt(RenderGroupType::Count); i++)
 	{
@@ -106,15 +105,13 @@ void GeometryRenderer::Draw(GraphicsContext& context, GraphicsState& state, Text
 		RenderGroup& renderGroup = SceneManager::Get().GetSceneGraph().RenderGroups[i];
 		if (renderGroup.Drawables.GetSize() == 0u) continue;
 
-		std::vector<std::string> configuration;
-		if (rgType == RenderGroupType::AlphaDiscard) configuration.push_back("ALPHA_DISCARD");
-		if (rgType == RenderGroupType::Transparent) configuration.push_back("ALPHA_BLEND");
-		if (!RenderSettings.Culling.LightCullingEnabled) configuration.push_back("DISABLE_LIGHT_CULLING");
-		if (RenderSettings.Shading.UsePBR) configuration.push_back("USE_PBR");
-		if (RenderSettings.Shading.UsePBR && RenderSettings.Shading.UseIBL) configuration.push_back("USE_IBL");
-		
 		state.Shader = m_GeometryShader.get();
-		state.ShaderConfig = configuration;
+		state.ShaderConfig = m_GeometryShader->Permutations.GetKey({
+			rgType == RenderGroupType::AlphaDiscard ? "ALPHA_DISCARD" : nullptr,
+			rgType == RenderGroupType::Transparent ? "ALPHA_BLEND" : nullptr,
+			!RenderSettings.Culling.LightCullingEnabled ? "DISABLE_LIGHT_CULLING" : nullptr,
+			RenderSettings.Shading.UsePBR ? "USE_PBR" : nullptr,
+			RenderSettings.Shading.UsePBR && RenderSettings.Shading.UseIBL ? "USE_IBL" : nullptr });
 		state.BlendState = rgType == RenderGroupType::Transparent ? blendStateOn : blendStateOff;
 		VertPipeline->Draw(context, state, renderGroup, SceneManager::Get().GetSceneGraph().MainCamera.CullingData[rgType]);
 	}
@@ -3,6 +3,7 @@
 #include <Engine/Common.h>
 
 #include "Renderers/Util/HzbGenerator.h"
+#include "Renderers/Util/SphericalHarmonics.h"
 
 struct GraphicsContext;
 struct GraphicsState;
@@ -18,7 +19,7 @@ public:
 
 	void Init(GraphicsContext& context);
 	void DepthPrepass(GraphicsContext& context, GraphicsState& state);
-	void Draw(GraphicsContext& context, GraphicsState& state, Texture* shadowMask, Buffer* visibleLights, Texture* irradianceMap, Texture* ambientOcclusion);
+	void Draw(GraphicsContext& context, GraphicsState& state, Texture* shadowMask, Buffer* visibleLights, const SphericalHarmonics::SH9ColorRenderData& irradianceSH, Texture* specularIBL, Texture* brdfLut, Texture* ambientOcclusion, Texture* shadowAtlas, Buffer* localShadows);
 
 	Texture* GetHZB(GraphicsContext& context, Texture* depth);
 
@@ -2,15 +2,19 @@
 
 #include <Engine/Render/Commands.h>
 #include <Engine/Render/Buffer.h>
+#include <Engine/Render/Context.h>
 #include <Engine/Render/Shader.h>
 #include <Engine/Render/Device.h>
 #include <Engine/Render/Texture.h>
 #include <Engine/System/ApplicationConfiguration.h>
+#include <Engine/Utility/MathUtility.h>
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Renderers/Util/TextureDebugger.h"
 #include "Scene/SceneGraph.h"
+#include "Shaders/shared_definitions.h"
 
 static const Float2 HaltonSequence[16] = { 
 						{0.500000f,0.333333f},
@@ -30,25 +34,6 @@ static const Float2 HaltonSequence[16] = {
 						{0.937500f,0.259259f},
 						{0.031250f,0.592593f} };
 
-struct BloomInputRenderData
-{
-	DirectX::XMFLOAT4 SampleScale;
-	DirectX::XMFLOAT2A TexelSize;
-	float Treshold;
-	float Knee;
-};
-
-static BloomInputRenderData GetBloomInput(Texture* texture)
-{
-	BloomInputRenderData input{};
-	input.SampleScale = RenderSettings.Bloom.SamplingScale.ToXMF();
-	input.Treshold = RenderSettings.Bloom.FTheshold;
-	input.Knee = RenderSettings.Bloom.FKnee;
-	input.TexelSize.x = 1.0f / texture->Width;
-	input.TexelSize.y = 1.0f / texture->Height;
-	return input;
-}
-
 PostprocessingRenderer::PostprocessingRenderer()
 {
 
@@ -61,8 +46,10 @@ PostprocessingRenderer::~PostprocessingRenderer()
 
 void PostprocessingRenderer::Init(GraphicsContext& context)
 {
-	m_PostprocessShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/postprocessing.hlsl"));
-	m_BloomShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/bloom.hlsl"));
+	m_PostprocessShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/postprocessing.hlsl")));
+	m_BloomShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/bloom.hlsl")));
+	GFX::WarmUpShader(m_PostprocessShader.get());
+	GFX::WarmUpShader(m_BloomShader.get());
 }
 
 Texture* PostprocessingRenderer::Process(GraphicsContext& context, Texture* colorInput, Texture* motionVectorInput)
@@ -87,70 +74,30 @@ Texture* PostprocessingRenderer::Process(GraphicsContext& context, Texture* colo
 	{
 		PROFILE_SECTION(context, "Bloom");
 
-		// Prefilter
-		{
-			PROFILE_SECTION(context, "Prefilter");
-
-			ConstantBuffer cb{};
-			cb.Add(GetBloomInput(hdrRT));
-			cb.Add(RenderSettings.Exposure);
-
-			state.Table.CBVs[0] = cb.GetBuffer(context);
-			state.Table.SRVs[0] = hdrRT;
-			state.RenderTargets[0] = m_BloomTexturesDownsample[0].get();
-			state.Shader = m_BloomShader.get();
-			state.ShaderConfig = { "PREFILTER" };
-
-			GFX::Cmd::DrawFC(context, state);
-		}
-
-		// Downsample
-		{
-			PROFILE_SECTION(context, "Downsample");
-			state.Shader = m_BloomShader.get();
-			state.ShaderConfig = { "DOWNSAMPLE" };
-			for (uint32_t i = 1; i < BLOOM_NUM_SAMPLES; i++)
-			{
-				ConstantBuffer cb{};
-				cb.Add(GetBloomInput(m_BloomTexturesDownsample[i - 1].get()));
-				cb.Add(RenderSettings.Exposure);
-
-				state.Table.CBVs[0] = cb.GetBuffer(context);
-				state.Table.SRVs[0] = m_BloomTexturesDownsample[i - 1].get();
-				state.RenderTargets[0] = m_BloomTexturesDownsample[i].get();
-				GFX::Cmd::DrawFC(context, state);
-			}
-		}
-
-		// Upsample
-		{
-			PROFILE_SECTION(context, "Upsample");
-			
-			ConstantBuffer cb{};
-			cb.Add(GetBloomInput(m_BloomTexturesDownsample[BLOOM_NUM_SAMPLES - 1].get()));
-			cb.Add(RenderSettings.Exposure);
-
-			state.Table.CBVs[0] = cb.GetBuffer(context);
-			state.Table.SRVs[0] = m_BloomTexturesDownsample[BLOOM_NUM_SAMPLES - 1].get();
-			state.Table.SRVs[1] = m_BloomTexturesDownsample[BLOOM_NUM_SAMPLES - 2].get();
-			state.Shader = m_BloomShader.get();
-			state.ShaderConfig = { "UPSAMPLE" };
-			state.RenderTargets[0] = m_BloomTexturesUpsample[BLOOM_NUM_SAMPLES - 2].get();
-
-			GFX::Cmd::DrawFC(context, state);
-
-			for (int32_t i = BLOOM_NUM_SAMPLES - 3; i >= 0; i--)
-			{
-				ConstantBuffer cb1{};
-				cb1.Add(GetBloomInput(m_BloomTexturesDownsample[i].get()));
-				cb1.Add(RenderSettings.Exposure);
-				state.Table.CBVs[0] = cb1.GetBuffer(context);
-				state.Table.SRVs[0] = m_BloomTexturesDownsample[i + 1].get();
-				state.Table.SRVs[1] = m_BloomTexturesDownsample[i].get();
-				state.RenderTargets[0] = m_BloomTexturesUpsample[i].get();
-				GFX::Cmd::DrawFC(context, state);
-			}
-		}
+		// Views are tracking the state on their own and are always left in the state of the parent
+		for (ScopedRef<TextureSubresourceView>& levelView : m_BloomChainViews) levelView->CurrState = m_BloomChain->CurrState;
+
+		GraphicsState bloomState;
+		bloomState.Table.SRVs[0] = hdrRT;
+		for (uint32_t i = 0; i < BLOOM_NUM_LEVELS; i++) bloomState.Table.UAVs[i] = m_BloomChainViews[i].get();
+		bloomState.Shader = m_BloomShader.get();
+		bloomState.ShaderStages = CS;
+		bloomState.PushConstantCount = 7;
+		context.ApplyState(bloomState);
+
+		PushConstantTable pushConstants;
+		pushConstants[0].Uint = m_BloomChain->Width;
+		pushConstants[1].Uint = m_BloomChain->Height;
+		pushConstants[2].Float = 1.0f / hdrRT->Width;
+		pushConstants[3].Float = 1.0f / hdrRT->Height;
+		pushConstants[4].Float = RenderSettings.Bloom.FTheshold;
+		pushConstants[5].Float = RenderSettings.Bloom.FKnee;
+		pushConstants[6].Float = RenderSettings.Exposure;
+		GFX::Cmd::SetPushConstants(CS, context, pushConstants);
+
+		GFX::Cmd::Dispatch(context, MathUtility::CeilDiv(m_BloomChain->Width, BLOOM_TILE_SIZE), MathUtility::CeilDiv(m_BloomChain->Height, BLOOM_TILE_SIZE), 1);
+
+		for (ScopedRef<TextureSubresourceView>& levelView : m_BloomChainViews) GFX::Cmd::TransitionResource(context, levelView.get(), m_BloomChain->CurrState);
 	}
 
 	// Tonemapping
@@ -158,18 +105,15 @@ Texture* PostprocessingRenderer::Process(GraphicsContext& context, Texture* colo
 		PROFILE_SECTION(context, "Tonemapping");
 
 		ConstantBuffer cb{};
+		cb.Add(RenderSettings.Bloom.SamplingScale.ToXMF());
 		cb.Add(RenderSettings.Exposure);
 
 		state.Table.CBVs[0] = cb.GetBuffer(context);
 		state.Table.SRVs[0] = hdrRT;
-		state.Table.SRVs[1] = m_BloomTexturesUpsample[0].get();
+		state.Table.SRVs[1] = m_BloomChain.get();
 		state.RenderTargets[0] = GetOutputTexture();
 		state.Shader = m_PostprocessShader.get();
-
-		std::vector<std::string> config{};
-		config.push_back("TONEMAPPING");
-		if (RenderSettings.Bloom.Enabled) config.push_back("APPLY_BLOOM");
-		state.ShaderConfig = config;
+		state.ShaderConfig = m_PostprocessShader->Permutations.GetKey({ "TONEMAPPING", RenderSettings.Bloom.Enabled ? "APPLY_BLOOM" : nullptr });
 
 		GFX::Cmd::DrawFC(context, state);
 
@@ -190,7 +134,7 @@ Texture* PostprocessingRenderer::Process(GraphicsContext& context, Texture* colo
 		state.Table.SRVs[2] = motionVectorInput;
 		state.RenderTargets[0] = GetOutputTexture();
 		state.Shader = m_PostprocessShader.get();
-		state.ShaderConfig = { "TAA" };
+		state.ShaderConfig = m_PostprocessShader->Permutations.GetKey({ "TAA" });
 
 		GFX::Cmd::DrawFC(context, state);
 
@@ -219,18 +163,13 @@ void PostprocessingRenderer::ReloadTextureResources(GraphicsContext& context)
 
 	// Bloom
 	const float aspect = (float)size[0] / size[1];
-	uint32_t bloomTexSize[2] = { (uint32_t)(512 * aspect), 512 };
-	for (uint32_t i = 0; i < BLOOM_NUM_SAMPLES; i++)
-	{
-		m_BloomTexturesDownsample[i] = ScopedRef<Texture>(GFX::CreateTexture(bloomTexSize[0], bloomTexSize[1], RCF::RTV, 1, DXGI_FORMAT_R16G16B16A16_FLOAT));
-		m_BloomTexturesUpsample[i] = ScopedRef<Texture>(GFX::CreateTexture(bloomTexSize[0], bloomTexSize[1], RCF::RTV, 1, DXGI_FORMAT_R16G16B16A16_FLOAT));
+	const uint32_t bloomSize[2] = { (uint32_t)(512 * aspect), 512 };
+	m_BloomChain = ScopedRef<Texture>(GFX::CreateTexture(bloomSize[0], bloomSize[1], RCF::UAV, BLOOM_NUM_LEVELS, DXGI_FORMAT_R16G16B16A16_FLOAT));
+	GFX::SetDebugName(m_BloomChain.get(), "PostprocessingRenderer::BloomChain");
 
-		GFX::SetDebugName(m_BloomTexturesDownsample[i].get(), "PostprocessingRenderer::BloomTexturesDownsample" + std::to_string(i));
-		GFX::SetDebugName(m_BloomTexturesUpsample[i].get(), "PostprocessingRenderer::BloomTexturesUpsample" + std::to_string(i));
-
-		bloomTexSize[0] /= 2;
-		bloomTexSize[1] /= 2;
-	}
+	m_BloomChainViews.clear();
+	m_BloomChainViews.resize(BLOOM_NUM_LEVELS);
+	for (uint32_t i = 0; i < BLOOM_NUM_LEVELS; i++) m_BloomChainViews[i] = ScopedRef<TextureSubresourceView>(GFX::GetTextureSubresource(m_BloomChain.get(), i, i, 0, 0));
 
 	// Camera
 	SceneManager::Get().GetSceneGraph().MainCamera.UseJitter = RenderSettings.AntialiasingMode == AntiAliasingMode::TAA;
@@ -239,4 +178,3 @@ void PostprocessingRenderer::ReloadTextureResources(GraphicsContext& context)
 		SceneManager::Get().GetSceneGraph().MainCamera.Jitter[i] = 2.0f * ((HaltonSequence[i] - Float2{ 0.5f, 0.5f }) / Float2((float) AppConfig.WindowWidth, (float) AppConfig.WindowHeight));
 	}
 }
-
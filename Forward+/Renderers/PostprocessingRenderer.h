@@ -1,10 +1,13 @@
 #pragma once
 
+#include <vector>
+
 #include <Engine/Common.h>
 
 struct GraphicsContext;
 struct GraphicsState;
 struct Texture;
+struct TextureSubresourceView;
 struct Buffer;
 struct Shader;
 
@@ -31,9 +34,8 @@ private:
 	ScopedRef<Texture> m_TAAHistory[2]; // 0 - current frame, 1 - last frame
 
 	// Bloom
-	static constexpr uint32_t BLOOM_NUM_SAMPLES = 5;
-	ScopedRef<Texture> m_BloomTexturesDownsample[BLOOM_NUM_SAMPLES];
-	ScopedRef<Texture> m_BloomTexturesUpsample[BLOOM_NUM_SAMPLES];
+	ScopedRef<Texture> m_BloomChain;
+	std::vector<ScopedRef<TextureSubresourceView>> m_BloomChainViews;
 
 	uint32_t m_PostprocessRTIndex = 0;
 	ScopedRef<Texture> m_PostprocessRT[2];
@@ -11,6 +11,7 @@
 #include "Globals.h"
 #include "Scene/SceneGraph.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Shaders/shared_definitions.h"
 
 SSAORenderer::SSAORenderer()
@@ -50,7 +51,8 @@ void SSAORenderer::Init(GraphicsContext& context)
 	ResourceInitData defaultData{ &context, &defaultColor };
 	m_NoSSAOTexture = ScopedRef<Texture>(GFX::CreateTexture(1, 1, RCF::None, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &defaultData));
 
-	m_Shader = ScopedRef<Shader>(new Shader("Forward+/Shaders/ssao.hlsl"));
+	m_Shader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/ssao.hlsl")));
+	GFX::WarmUpShader(m_Shader.get());
 
 	UpdateResources(context);
 
@@ -98,10 +100,9 @@ Texture* SSAORenderer::Draw(GraphicsContext& context, Texture* depth)
 		state.Table.CBVs[0] = cb.GetBuffer(context);
 		state.Table.SRVs[0] = m_NoiseTexture.get();
 		state.Table.SRVs[1] = depth;
-		state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_POINT , D3D12_TEXTURE_ADDRESS_MODE_CLAMP };
 		state.RenderTargets[0] = m_SSAOSampleTexture.get();
 		state.Shader = m_Shader.get();
-		state.ShaderConfig = { "SSAO_SAMPLE" };
+		state.ShaderConfig = m_Shader->Permutations.GetKey({ "SSAO_SAMPLE" });
 		GFX::Cmd::DrawFC(context, state);
 	}
 
@@ -113,12 +114,11 @@ Texture* SSAORenderer::Draw(GraphicsContext& context, Texture* depth)
 		cb.Add(AppConfig.WindowWidth);
 		cb.Add(AppConfig.WindowHeight);
 
-		state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_BORDER, {0.0f, 0.0f, 0.0f, 0.0f} };
 		state.Table.CBVs[0] = cb.GetBuffer(context);
 		state.Table.SRVs[0] = m_SSAOSampleTexture.get();
 		state.RenderTargets[0] = m_SSAOTexture.get();
 		state.Shader = m_Shader.get();
-		state.ShaderConfig = { "SSAO_BLUR" };
+		state.ShaderConfig = m_Shader->Permutations.GetKey({ "SSAO_BLUR" });
 		GFX::Cmd::DrawFC(context, state);
 	}
 
@@ -6,14 +6,61 @@
 #include <Engine/Render/Commands.h>
 #include <Engine/Render/Context.h>
 #include <Engine/System/ApplicationConfiguration.h>
+#include <Engine/Utility/MathUtility.h>
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Renderers/Util/VertexPipeline.h"
 #include "Scene/SceneManager.h"
 #include "Scene/SceneGraph.h"
 
-ShadowRenderer::ShadowRenderer()
+namespace ShadowRendererPrivate
+{
+	struct LocalShadowSB
+	{
+		DirectX::XMFLOAT4X4 WorldToClip[ShadowAtlasEntry::MAX_FACES];
+		DirectX::XMFLOAT4 AtlasRect[ShadowAtlasEntry::MAX_FACES];
+		uint32_t NumFaces;
+		DirectX::XMFLOAT3 Padding;
+	};
+
+	// Must match the face selection in geometry.hlsl: +X, -X, +Y, -Y, +Z, -Z
+	// Spot lights light every direction until they get a spot mask, so they get all 6 faces same as point lights
+	Camera::CameraRenderData GetLocalShadowFaceCamera(const Light& light, uint32_t faceIndex, DirectX::XMFLOAT4X4& worldToClipOut)
+	{
+		using namespace DirectX;
+
+		static const Float3 forwards[6] = { Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f) };
+		static const Float3 ups[6] = { Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, 0.0f, -1.0f), Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f) };
+
+		const Float3 forward = forwards[faceIndex];
+		const Float3 up = ups[faceIndex];
+
+		const float zNear = 0.1f;
+		const float zFar = MAX(light.Falloff.y, zNear + 0.1f);
+
+		const XMMATRIX worldToView = XMMatrixLookAtLH(light.Position.ToXM(), (light.Position + forward).ToXM(), up.ToXM());
+		const XMMATRIX viewToClip = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, zNear, zFar);
+		const XMMATRIX worldToClip = XMMatrixMultiply(worldToView, viewToClip);
+
+		Camera::CameraRenderData cameraData{};
+		cameraData.WorldToView = XMUtility::ToHLSLFloat4x4(worldToView);
+		cameraData.ViewToClip = XMUtility::ToHLSLFloat4x4(viewToClip);
+		cameraData.ClipToWorld = XMUtility::ToHLSLFloat4x4(XMMatrixInverse(nullptr, worldToClip));
+		cameraData.Position = light.Position.ToXMFA();
+		cameraData.Jitter = Float2(0.0f, 0.0f).ToXMF();
+		cameraData.ZNear = zNear;
+		cameraData.ZFar = zFar;
+
+		worldToClipOut = XMUtility::ToHLSLFloat4x4(worldToClip);
+
+		return cameraData;
+	}
+}
+
+ShadowRenderer::ShadowRenderer():
+	m_ShadowAtlas(SHADOW_ATLAS_SIZE, MIN_LOCAL_SHADOW_SIZE, MAX_LOCAL_SHADOW_SIZE)
 {
 
 }
@@ -26,12 +73,20 @@ ShadowRenderer::~ShadowRenderer()
 void ShadowRenderer::Init(GraphicsContext& context)
 {
 	m_Shadowmap = ScopedRef<Texture>(GFX::CreateTexture(1024, 1024, RCF::DSV));
-	m_ShadowmapShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/depth.hlsl"));
-	m_ShadowmaskShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/shadowmask.hlsl"));
+	m_ShadowmapShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/depth.hlsl")));
+	m_ShadowmaskShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/shadowmask.hlsl")));
+	GFX::WarmUpShader(m_ShadowmapShader.get());
+	GFX::WarmUpShader(m_ShadowmaskShader.get());
 	m_HzbGenerator.Init(context);
 	ReloadTextureResources(context);
 
+	m_ShadowAtlasTexture = ScopedRef<Texture>(GFX::CreateTexture(SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, RCF::DSV));
+	m_LocalShadowsBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(MAX_SHADOWED_LIGHTS * sizeof(ShadowRendererPrivate::LocalShadowSB), sizeof(ShadowRendererPrivate::LocalShadowSB), RCF::None));
+	m_LocalShadowCullingData.resize(MAX_SHADOWED_LIGHTS);
+
 	GFX::SetDebugName(m_Shadowmap.get(), "ShadowRenderer::Shadowmap");
+	GFX::SetDebugName(m_ShadowAtlasTexture.get(), "ShadowRenderer::ShadowAtlas");
+	GFX::SetDebugName(m_LocalShadowsBuffer.get(), "ShadowRenderer::LocalShadows");
 }
 
 Texture* ShadowRenderer::CalculateShadowMask(GraphicsContext& context, Texture* depth)
@@ -48,7 +103,6 @@ Texture* ShadowRenderer::CalculateShadowMask(GraphicsContext& context, Texture*
 		ConstantBuffer cb{};
 		cb.Add(SceneManager::Get().GetSceneGraph().ShadowCamera.CameraData);
 
-		state.Table.SMPs[0] = { D3D12_FILTER_ANISOTROPIC , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 		state.Table.CBVs[0] = cb.GetBuffer(context);
 		state.DepthStencilState.DepthEnable = true;
 		state.Shader = m_ShadowmapShader.get();
@@ -59,15 +113,8 @@ Texture* ShadowRenderer::CalculateShadowMask(GraphicsContext& context, Texture*
 			RenderGroupType rgType = IntToEnum<RenderGroupType>(i);
 			RenderGroup& renderGroup = SceneManager::Get().GetSceneGraph().RenderGroups[i];
 
-			std::vector<std::string> config{};
-			config.push_back("SHADOWMAP");
 			state.DepthStencil = m_Shadowmap.get();
-			
-			if (rgType == RenderGroupType::AlphaDiscard)
-			{
-				config.push_back("ALPHA_DISCARD");
-			}
-			state.ShaderConfig = config;
+			state.ShaderConfig = m_ShadowmapShader->Permutations.GetKey({ "SHADOWMAP", rgType == RenderGroupType::AlphaDiscard ? "ALPHA_DISCARD" : nullptr });
 			VertPipeline->Draw(context, state, renderGroup, SceneManager::Get().GetSceneGraph().ShadowCamera.CullingData[rgType]);
 		}
 	}
@@ -83,7 +130,6 @@ Texture* ShadowRenderer::CalculateShadowMask(GraphicsContext& context, Texture*
 		cb.Add(SceneManager::Get().GetSceneGraph().ShadowCamera.CameraData);
 		cb.Add(SceneManager::Get().GetSceneGraph().SceneInfoData);
 
-		state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 		state.Table.CBVs[0] = cb.GetBuffer(context);
 		state.Table.SRVs[0] = depth;
 		state.Table.SRVs[1] = m_Shadowmap.get();
@@ -96,6 +142,190 @@ Texture* ShadowRenderer::CalculateShadowMask(GraphicsContext& context, Texture*
 	return m_Shadowmask.get();
 }
 
+void ShadowRenderer::DrawLocalShadows(GraphicsContext& context)
+{
+	using namespace ShadowRendererPrivate;
+
+	PROFILE_SECTION(context, "Local shadows");
+
+	UpdateShadowAtlas(context);
+
+	RenderStats.LocalShadowStats.RedrawnLights = 0;
+
+	const std::vector<ShadowAtlasEntry>& entries = m_ShadowAtlas.GetEntries();
+	if (entries.empty()) return;
+
+	SceneGraph& scene = SceneManager::Get().GetSceneGraph();
+
+	// Lights don't move, so a tile kept from the last frame only has to be drawn again if the geometry changed
+	uint32_t numDrawables = 0;
+	for (uint32_t i = 0; i < EnumToInt(RenderGroupType::Count); i++) numDrawables += scene.RenderGroups[i].Drawables.GetSize();
+
+	const uint32_t sceneVersion = SceneManager::Get().GetSceneVersion();
+	const bool redrawAll = sceneVersion != m_DrawnSceneVersion || numDrawables != m_DrawnDrawables;
+	m_DrawnSceneVersion = sceneVersion;
+	m_DrawnDrawables = numDrawables;
+
+	if (redrawAll) GFX::Cmd::ClearDepthStencil(context, m_ShadowAtlasTexture.get());
+
+	std::vector<LocalShadowSB> localShadows{};
+	localShadows.resize(entries.size());
+
+	GraphicsState state;
+	state.DepthStencilState.DepthEnable = true;
+	state.DepthStencil = m_ShadowAtlasTexture.get();
+	state.Shader = m_ShadowmapShader.get();
+	state.UseCustomViewport = true;
+	state.UseCustomScissor = true;
+
+	for (uint32_t i = 0; i < entries.size(); i++)
+	{
+		const ShadowAtlasEntry& entry = entries[i];
+		const Light& light = scene.Lights[entry.LightIndex];
+
+		LocalShadowSB& localShadow = localShadows[i];
+		localShadow.NumFaces = entry.NumFaces;
+
+		const bool redraw = redrawAll || entry.IsNew;
+		if (redraw)
+		{
+			CullLocalShadow(context, light, m_LocalShadowCullingData[i]);
+			RenderStats.LocalShadowStats.RedrawnLights++;
+		}
+
+		for (uint32_t face = 0; face < entry.NumFaces; face++)
+		{
+			const AtlasAllocation& tile = entry.Tiles[face];
+			const Camera::CameraRenderData faceCamera = GetLocalShadowFaceCamera(light, face, localShadow.WorldToClip[face]);
+			localShadow.AtlasRect[face] = Float4((float) tile.X, (float) tile.Y, (float) tile.Size, (float) tile.Size).ToXMF();
+			localShadow.AtlasRect[face].x /= SHADOW_ATLAS_SIZE;
+			localShadow.AtlasRect[face].y /= SHADOW_ATLAS_SIZE;
+			localShadow.AtlasRect[face].z /= SHADOW_ATLAS_SIZE;
+			localShadow.AtlasRect[face].w /= SHADOW_ATLAS_SIZE;
+
+			if (!redraw) continue;
+
+			state.CustomViewport = { (float) tile.X, (float) tile.Y, (float) tile.Size, (float) tile.Size, 0.0f, 1.0f };
+			state.CustomScissor = { (long) tile.X, (long) tile.Y, (long) (tile.X + tile.Size), (long) (tile.Y + tile.Size) };
+			if (!redrawAll) GFX::Cmd::ClearDepthStencil(context, m_ShadowAtlasTexture.get(), state.CustomScissor);
+
+			ConstantBuffer cb{};
+			cb.Add(faceCamera);
+
+			state.Table.CBVs[0] = cb.GetBuffer(context);
+
+			RenderGroupType shadowTypes[] = { RenderGroupType::Opaque, RenderGroupType::AlphaDiscard };
+			for (uint32_t rg = 0; rg < STATIC_ARRAY_SIZE(shadowTypes); rg++)
+			{
+				const RenderGroupType rgType = shadowTypes[rg];
+
+				state.ShaderConfig = m_ShadowmapShader->Permutations.GetKey({ "SHADOWMAP", rgType == RenderGroupType::AlphaDiscard ? "ALPHA_DISCARD" : nullptr });
+
+				VertPipeline->Draw(context, state, scene.RenderGroups[EnumToInt(rgType)], m_LocalShadowCullingData[i][rgType]);
+			}
+		}
+	}
+
+	GFX::Cmd::UploadToBuffer(context, m_LocalShadowsBuffer.get(), 0, localShadows.data(), 0, (uint32_t) (localShadows.size() * sizeof(LocalShadowSB)));
+}
+
+void ShadowRenderer::UpdateShadowAtlas(GraphicsContext& context)
+{
+	PROFILE_SECTION(context, "Update shadow atlas");
+
+	SceneGraph& scene = SceneManager::Get().GetSceneGraph();
+	const uint32_t numLights = scene.Lights.GetSize();
+
+	std::vector<ShadowAtlasRequest> requests{};
+	if (RenderSettings.Shadows.LocalShadowsEnabled)
+	{
+		for (uint32_t i = 0; i < numLights; i++)
+		{
+			const Light& light = scene.Lights[i];
+
+			ShadowAtlasRequest request{};
+			request.LightIndex = i;
+			request.NumFaces = 6;
+			request.Importance = ShadowAtlas::CalculateImportance(light, scene.MainCamera);
+			if (request.Importance > 0.0f) requests.push_back(request);
+		}
+	}
+
+	const uint32_t lightBudget = MIN(RenderSettings.Shadows.LocalShadowBudget, MAX_SHADOWED_LIGHTS);
+	m_ShadowAtlas.Update(requests, lightBudget);
+
+	// Point lights to their shadows, only touch the lights whose shadow index changed
+	std::unordered_map<uint32_t, uint32_t> lastShadowIndices{};
+	for (uint32_t lightIndex : m_ShadowedLights)
+	{
+		if (lightIndex >= numLights) continue;
+		lastShadowIndices[lightIndex] = scene.Lights[lightIndex].ShadowIndex;
+		scene.Lights[lightIndex].ShadowIndex = Light::InvalidShadowIndex;
+	}
+
+	m_ShadowedLights.clear();
+	const std::vector<ShadowAtlasEntry>& entries = m_ShadowAtlas.GetEntries();
+	for (uint32_t i = 0; i < entries.size(); i++)
+	{
+		const uint32_t lightIndex = entries[i].LightIndex;
+		lastShadowIndices.try_emplace(lightIndex, Light::InvalidShadowIndex);
+		scene.Lights[lightIndex].ShadowIndex = i;
+		m_ShadowedLights.push_back(lightIndex);
+	}
+
+	for (const auto& [lightIndex, lastShadowIndex] : lastShadowIndices)
+	{
+		if (scene.Lights[lightIndex].ShadowIndex != lastShadowIndex) scene.Lights.MarkDirty(lightIndex);
+	}
+	scene.Lights.SyncGPUBuffer(context);
+
+	const ShadowAtlasStats& atlasStats = m_ShadowAtlas.GetStats();
+	RenderStats.LocalShadowStats.ShadowedLights = atlasStats.ShadowedLights;
+	RenderStats.LocalShadowStats.Evictions = atlasStats.Evictions;
+	RenderStats.LocalShadowStats.Repacks = atlasStats.Repacks;
+	RenderStats.LocalShadowStats.AtlasOccupancy = atlasStats.Occupancy;
+}
+
+void ShadowRenderer::CullLocalShadow(GraphicsContext& context, const Light& light, CameraCullingData& cullingData)
+{
+	BoundingSphere lightVolume{};
+	lightVolume.Center = light.Position;
+	lightVolume.Radius = light.Falloff.y;
+
+	for (uint32_t i = 0; i < EnumToInt(RenderGroupType::Count); i++)
+	{
+		const RenderGroupType rgType = IntToEnum<RenderGroupType>(i);
+		RenderGroup& rg = SceneManager::Get().GetSceneGraph().RenderGroups[i];
+		RenderGroupCullingData& rgCullingData = cullingData[rgType];
+
+		const uint32_t numDrawables = rg.Drawables.GetSize();
+		if (numDrawables == 0) continue;
+
+		rgCullingData.VisibilityMask = BitField{ numDrawables };
+		for (uint32_t d = 0; d < numDrawables; d++)
+		{
+			const Drawable& drawable = rg.Drawables[d];
+			if (drawable.DrawableIndex == Drawable::InvalidIndex) continue;
+
+			const BoundingSphere bv = drawable.GetBoundingVolume();
+			const float maxDistance = bv.Radius + lightVolume.Radius;
+			if ((bv.Center - lightVolume.Center).LengthSq() <= maxDistance * maxDistance)
+			{
+				rgCullingData.VisibilityMask.Set(d, true);
+			}
+		}
+
+		// GPU path reads the same mask from the buffer
+		if (RenderSettings.Culling.GeoCullingMode != GeometryCullingMode::CPU_FrustumCulling)
+		{
+			const uint32_t maskByteSize = MathUtility::CeilDiv(numDrawables, 32u) * sizeof(uint32_t);
+			if (!rgCullingData.VisibilityMaskBuffer) rgCullingData.VisibilityMaskBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(maskByteSize, 1, RCF::UAV | RCF::RAW));
+			GFX::ExpandBuffer(context, rgCullingData.VisibilityMaskBuffer.get(), maskByteSize);
+			GFX::Cmd::UploadToBuffer(context, rgCullingData.VisibilityMaskBuffer.get(), 0, rgCullingData.VisibilityMask.GetRaw(), 0, maskByteSize);
+		}
+	}
+}
+
 void ShadowRenderer::ReloadTextureResources(GraphicsContext& context)
 {
 	m_Shadowmask = ScopedRef<Texture>(GFX::CreateTexture(AppConfig.WindowWidth, AppConfig.WindowHeight, RCF::RTV, 1, DXGI_FORMAT_R32_FLOAT));
@@ -3,6 +3,8 @@
 #include <Engine/Common.h>
 
 #include "Renderers/Util/HzbGenerator.h"
+#include "Renderers/Util/ShadowAtlas.h"
+#include "Scene/SceneGraph.h"
 
 struct GraphicsContext;
 struct GraphicsState;
@@ -13,15 +15,28 @@ struct Shader;
 class ShadowRenderer
 {
 public:
+	static constexpr uint32_t SHADOW_ATLAS_SIZE = ShadowAtlas::ATLAS_SIZE;
+	static constexpr uint32_t MIN_LOCAL_SHADOW_SIZE = ShadowAtlas::MIN_TILE_SIZE;
+	static constexpr uint32_t MAX_LOCAL_SHADOW_SIZE = ShadowAtlas::MAX_TILE_SIZE;
+	static constexpr uint32_t MAX_SHADOWED_LIGHTS = 64;
+
 	ShadowRenderer();
 	~ShadowRenderer();
 
 	void Init(GraphicsContext& context);
 	Texture* CalculateShadowMask(GraphicsContext& context, Texture* depth);
+	void DrawLocalShadows(GraphicsContext& context);
 	void ReloadTextureResources(GraphicsContext& context);
 
 	Texture* GetHZB(GraphicsContext& context);
 
+	Texture* GetShadowAtlas() const { return m_ShadowAtlasTexture.get(); }
+	Buffer* GetLocalShadowsBuffer() const { return m_LocalShadowsBuffer.get(); }
+
+private:
+	void UpdateShadowAtlas(GraphicsContext& context);
+	void CullLocalShadow(GraphicsContext& context, const Light& light, CameraCullingData& cullingData);
+
 private:
 	ScopedRef<Shader> m_ShadowmapShader;
 	ScopedRef<Shader> m_ShadowmaskShader;
@@ -30,4 +45,15 @@ private:
 	ScopedRef<Texture> m_Shadowmask;
 
 	HZBGenerator m_HzbGenerator;
+
+	// Local lights
+	ShadowAtlas m_ShadowAtlas;
+	ScopedRef<Texture> m_ShadowAtlasTexture;
+	ScopedRef<Buffer> m_LocalShadowsBuffer;
+	std::vector<uint32_t> m_ShadowedLights;
+	std::vector<CameraCullingData> m_LocalShadowCullingData;
+
+	// Scene the atlas tiles were drawn with
+	uint32_t m_DrawnSceneVersion = 0;
+	uint32_t m_DrawnDrawables = 0;
 };
\ No newline at end of file
@@ -4,119 +4,68 @@
 #include <Engine/Render/Commands.h>
 #include <Engine/Render/Buffer.h>
 #include <Engine/Render/Shader.h>
-#include <Engine/Render/Device.h>
 #include <Engine/Render/Texture.h>
 #include <Engine/Loading/TextureLoading.h>
+#include <Engine/System/ApplicationConfiguration.h>
 
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
+#include "Renderers/Util/IBLBaker.h"
 #include "Scene/SceneGraph.h"
 
 Buffer* GenerateCubeVB(GraphicsContext& context);
 
-static void ProcessAllCubemapFaces(GraphicsContext& context, GraphicsState& faceState, Texture* cubemap)
+static Texture* UploadSpecularCubemap(GraphicsContext& context, const IBLBaker::BakedIBL& ibl)
 {
-	Buffer* CubeVB = GenerateCubeVB(context);
-	
-	const auto getCameraForFace = [](uint32_t faceIndex)
+	const IBLBaker::BakeSettings& settings = ibl.Settings;
+	const DXGI_FORMAT format = settings.SpecularFormat == IBLBaker::CubemapFormat::RGB9E5 ? DXGI_FORMAT_R9G9B9E5_SHAREDEXP : DXGI_FORMAT_R16G16B16A16_FLOAT;
+	Texture* cubemap = GFX::CreateTextureArray(settings.CubemapSize, settings.CubemapSize, 6, RCF::Cubemap, settings.NumMips, format);
+	for (uint32_t face = 0; face < 6; face++)
 	{
-		using namespace DirectX;
-		static Float3 forwards[6] = { Float3(-1.0f,  0.0f,  0.0f), Float3(1.0f,  0.0f,  0.0f), Float3(0.0f,  -1.0f,  0.0f), Float3(0.0f, 1.0f,  0.0f), Float3(0.0f,  0.0f,  1.0f), Float3(0.0f,  0.0f, -1.0f) };
-		static Float3 ups[6] = { Float3(0.0f, -1.0f,  0.0f), Float3(0.0f, -1.0f,  0.0f), Float3(0.0f,  0.0f,  -1.0f), Float3(0.0f,  0.0f, 1.0f), Float3(0.0f, -1.0f,  0.0f), Float3(0.0f, -1.0f,  0.0f) };
-
-		XMMATRIX viewMat = XMMatrixLookAtLH(Float3(0.0f, 0.0f, 0.0f).ToXM(), forwards[faceIndex].ToXM(), ups[faceIndex].ToXM());
-		XMMATRIX projMat = XMMatrixOrthographicLH(2.0f, 2.0f, 0.1f, 10.0f);
-		XMMATRIX viewProj = XMMatrixMultiply(viewMat, projMat);
-		return XMUtility::ToHLSLFloat4x4(viewProj);
-	};
-
-	faceState.VertexBuffers[0] = CubeVB;
-	
-	DescriptorAllocation oldRTV = cubemap->RTV;
-
-	for (uint32_t i = 0; i < 6; i++)
-	{
-		DescriptorHeap* heap = Device::Get()->GetMemory().RTVHeap.get();
-		DescriptorAllocation rtvDescriptor = heap->Allocate();
-		
-		D3D12_RENDER_TARGET_VIEW_DESC rtvDesc{};
-		rtvDesc.Format = cubemap->Format;
-		rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-		rtvDesc.Texture2DArray.ArraySize = 1;
-		rtvDesc.Texture2DArray.FirstArraySlice = i;
-		rtvDesc.Texture2DArray.MipSlice = 0;
-		Device::Get()->GetHandle()->CreateRenderTargetView(cubemap->Handle.Get(), &rtvDesc, rtvDescriptor.GetCPUHandle());
-
-		DirectX::XMFLOAT4X4 worldToClip = getCameraForFace(i);
-		ConstantBuffer cb{};
-		cb.Add(worldToClip);
-		faceState.Table.CBVs[0] = cb.GetBuffer(context);
-		cubemap->RTV = rtvDescriptor;
-		faceState.RenderTargets[0] = cubemap;
-		context.ApplyState(faceState);
-		GFX::Cmd::Draw(context, CubeVB->ByteSize / CubeVB->Stride, 0);
-
-		GFX::Cmd::Delete(context, rtvDescriptor);
+		for (uint32_t mip = 0; mip < settings.NumMips; mip++)
+		{
+			GFX::Cmd::UploadToTexture(context, ibl.SpecularCubemap.data() + ibl.GetMipOffset(face, mip), cubemap, mip, face);
+		}
 	}
-
-	cubemap->RTV = oldRTV;
-
-	GFX::Cmd::Delete(context, CubeVB);
+	return cubemap;
 }
 
-static Texture* PanoramaToCubemap(GraphicsContext& context, Texture* panoramaTexture, uint32_t cubemapSize)
+static Texture* UploadBRDFLut(GraphicsContext& context, const IBLBaker::BakedIBL& ibl)
 {
-	PROFILE_SECTION(context, "Panorama to cubemap");
-
-	Texture* cubemapTex = GFX::CreateTextureArray(cubemapSize, cubemapSize, 6, RCF::RTV | RCF::Cubemap);
-
-	Shader* shader = new Shader("Forward+/Shaders/quadrilateral2cubemap.hlsl");
-	
-	GraphicsState state;
-	state.Shader = shader;
-	state.Table.SRVs[0] = panoramaTexture;
-	state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
-
-	ProcessAllCubemapFaces(context, state, cubemapTex);
-	GFX::Cmd::Delete(context, shader);
-
-	return cubemapTex;
+	ResourceInitData initData = { &context, ibl.BRDFLut.data() };
+	return GFX::CreateTexture(ibl.Settings.BRDFLutSize, ibl.Settings.BRDFLutSize, RCF::None, 1, DXGI_FORMAT_R16G16_FLOAT, &initData);
 }
 
-static Texture* CubemapToIrradianceMap(GraphicsContext& context, Texture* cubemapTexture, uint32_t cubemapSize)
+static IBLBaker::BakedIBL LoadOrBakeIBL(const std::string& texturePath)
 {
-	PROFILE_SECTION(context, "Calculate irradiance");
-
-	Texture* cubemapTex = GFX::CreateTextureArray(cubemapSize, cubemapSize, 6, RCF::RTV | RCF::Cubemap, 1, DXGI_FORMAT_R11G11B10_FLOAT);
-	Shader* shader = new Shader("Forward+/Shaders/calculate_irradiance.hlsl");
-	
-	GraphicsState state;
-	state.Shader = shader;
-
-	state.Table.SRVs[0] = cubemapTexture;
-	state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
-	ProcessAllCubemapFaces(context, state, cubemapTex);
-	GFX::Cmd::Delete(context, shader);
-	
-	return cubemapTex;
-}
+	const IBLBaker::BakeSettings settings{};
 
-static Texture* GenerateSkybox(GraphicsContext& context, const std::string& texturePath)
-{
-	Texture* skyboxPanorama = TextureLoading::LoadTextureHDR(context, texturePath, RCF::None);
-	Texture* cubemap = PanoramaToCubemap(context, skyboxPanorama, SkyboxRenderer::CUBEMAP_SIZE);
-	GFX::Cmd::Delete(context, skyboxPanorama);
-	return cubemap;
+	uint64_t sourceHash = 0;
+	const bool hasSource = IBLBaker::HashSourceFile(texturePath, sourceHash);
+	const std::string cachePath = IBLBaker::GetCachePath(sourceHash);
+
+	IBLBaker::BakedIBL ibl{};
+	if (hasSource && IBLBaker::LoadCache(cachePath, sourceHash, settings, ibl)) return ibl;
+
+	const TextureLoading::ImageDataHDR panorama = TextureLoading::LoadImageHDR(texturePath);
+	ibl = IBLBaker::Bake(panorama, settings);
+	if (hasSource) IBLBaker::SaveCache(cachePath, sourceHash, ibl);
+	return ibl;
 }
 
 void SkyboxRenderer::Init(GraphicsContext& context)
 {
-	m_SkyboxCubemap = ScopedRef<Texture>(GenerateSkybox(context, m_SkyboxTexturePath));
-	m_IrradianceCubemap = ScopedRef<Texture>(CubemapToIrradianceMap(context, m_SkyboxCubemap.get(), CUBEMAP_SIZE));
-	m_SkyboxShader = ScopedRef<Shader>(new Shader("Forward+/Shaders/skybox.hlsl"));
+	const IBLBaker::BakedIBL ibl = LoadOrBakeIBL(m_SkyboxTexturePath);
+
+	m_SkyboxCubemap = ScopedRef<Texture>(UploadSpecularCubemap(context, ibl));
+	m_BRDFLut = ScopedRef<Texture>(UploadBRDFLut(context, ibl));
+	m_IrradianceSH = SphericalHarmonics::ToRenderData(ibl.IrradianceSH);
+	m_SkyboxShader = ScopedRef<Shader>(new Shader(ShaderDeclarations::Get("Forward+/Shaders/skybox.hlsl")));
+	GFX::WarmUpShader(m_SkyboxShader.get());
 	m_CubeVB = ScopedRef<Buffer>(GenerateCubeVB(context));
 
 	GFX::SetDebugName(m_SkyboxCubemap.get(), "SkyboxRenderer::SkyboxCubemap");
-	GFX::SetDebugName(m_IrradianceCubemap.get(), "SkyboxRenderer::IrradianceCubemap");
+	GFX::SetDebugName(m_BRDFLut.get(), "SkyboxRenderer::BRDFLut");
 	GFX::SetDebugName(m_CubeVB.get(), "SkyboxRenderer::CubeVB");
 }
 
@@ -138,7 +87,6 @@ void SkyboxRenderer::Draw(GraphicsContext& context, GraphicsState& state)
 
 	state.Table.CBVs[0] = cb.GetBuffer(context);
 	state.Table.SRVs[0] = m_SkyboxCubemap.get();
-	state.Table.SMPs[0] = { D3D12_FILTER_MIN_MAG_MIP_LINEAR , D3D12_TEXTURE_ADDRESS_MODE_WRAP };
 	state.VertexBuffers[0] = m_CubeVB.get();
 	state.Shader = m_SkyboxShader.get();
 
@@ -148,10 +96,5 @@ void SkyboxRenderer::Draw(GraphicsContext& context, GraphicsState& state)
 
 void SkyboxRenderer::OnShaderReload(GraphicsContext& context)
 {
-	// GfxRef<Texture> tmpRef = GfxRef<Texture>(m_SkyboxCubemap.get());
-	// m_SkyboxCubemap = ScopedRef<Texture>(GenerateSkybox(context, m_SkyboxTexturePath));
-	// GFX::SetDebugName(m_SkyboxCubemap.get(), "SkyboxRenderer::SkyboxCubemap");
-
-	// Too long, enable if needed
-	// m_IrradianceCubemap = ScopedRef<Texture>(CubemapToIrradianceMap(context, m_SkyboxCubemap.get(), CUBEMAP_SIZE));
-}
+	// IBL is baked on the CPU, nothing to regenerate
+}
\ No newline at end of file
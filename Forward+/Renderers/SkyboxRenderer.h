@@ -2,6 +2,8 @@
 
 #include <Engine/Common.h>
 
+#include "Renderers/Util/SphericalHarmonics.h"
+
 struct GraphicsContext;
 struct GraphicsState;
 struct Texture;
@@ -11,8 +13,6 @@ struct Shader;
 class SkyboxRenderer
 {
 public:
-	static constexpr uint32_t CUBEMAP_SIZE = 512;
-
 	SkyboxRenderer(const std::string& texturePath): m_SkyboxTexturePath(texturePath) {}
 
 	void Init(GraphicsContext& context);
@@ -20,7 +20,11 @@ public:
 
 	void OnShaderReload(GraphicsContext& context);
 
-	Texture* GetIrradianceMap() const { return m_IrradianceCubemap.get(); }
+	const SphericalHarmonics::SH9ColorRenderData& GetIrradianceSH() const { return m_IrradianceSH; }
+
+	// Mip 0 is the skybox, rest of the mips are prefiltered for increasing roughness
+	Texture* GetSpecularIBL() const { return m_SkyboxCubemap.get(); }
+	Texture* GetBRDFLut() const { return m_BRDFLut.get(); }
 
 private:
 	std::string m_SkyboxTexturePath;
@@ -28,5 +32,6 @@ private:
 	ScopedRef<Buffer> m_CubeVB;
 	ScopedRef<Shader> m_SkyboxShader;
 	ScopedRef<Texture> m_SkyboxCubemap;
-	ScopedRef<Texture> m_IrradianceCubemap;
+	ScopedRef<Texture> m_BRDFLut;
+	SphericalHarmonics::SH9ColorRenderData m_IrradianceSH;
 };
\ No newline at end of file
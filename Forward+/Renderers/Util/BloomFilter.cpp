@@ -0,0 +1,153 @@
+#include "BloomFilter.h"
+
+#include <algorithm>
+
+#include <Engine/Utility/Multithreading.h>
+
+#include "Shaders/shared_definitions.h"
+
+namespace BloomFilter
+{
+	Float4 SampleLinearBorder(const std::vector<Float4>& image, uint32_t width, uint32_t height, Float2 uv)
+	{
+		const float x = uv.x * width - 0.5f;
+		const float y = uv.y * height - 0.5f;
+		const float x0 = floorf(x);
+		const float y0 = floorf(y);
+		const float fx = x - x0;
+		const float fy = y - y0;
+
+		const auto fetch = [&](float tx, float ty)
+		{
+			if (tx < 0.0f || ty < 0.0f || tx >= (float) width || ty >= (float) height) return Float4{};
+			return image[(size_t) ty * width + (size_t) tx];
+		};
+
+		const Float4 top = (1.0f - fx) * fetch(x0, y0) + fx * fetch(x0 + 1.0f, y0);
+		const Float4 bottom = (1.0f - fx) * fetch(x0, y0 + 1.0f) + fx * fetch(x0 + 1.0f, y0 + 1.0f);
+		return (1.0f - fy) * top + fy * bottom;
+	}
+
+	std::vector<std::vector<Float4>> GenerateReference(const float* input, uint32_t inputWidth, uint32_t inputHeight, uint32_t bloomWidth, uint32_t bloomHeight, float treshold, float knee, float exposure)
+	{
+		static constexpr float EPSILON = 0.0001f;
+		static constexpr float EMISSIVE_CLAMP = 20.0f;
+
+		std::vector<Float4> inputImage;
+		inputImage.resize((size_t) inputWidth * inputHeight);
+		for (size_t i = 0; i < inputImage.size(); i++) inputImage[i] = Float4{ input[4 * i], input[4 * i + 1], input[4 * i + 2], input[4 * i + 3] };
+
+		const Float2 texelSize{ 1.0f / inputWidth, 1.0f / inputHeight };
+		const auto sampleInput = [&](Float2 uv, float offsetX, float offsetY)
+		{
+			return SampleLinearBorder(inputImage, inputWidth, inputHeight, Float2{ uv.x + offsetX * texelSize.x, uv.y + offsetY * texelSize.y });
+		};
+
+		const auto prefilter = [&](uint32_t x, uint32_t y)
+		{
+			const Float2 uv{ (x + 0.5f) / bloomWidth, (y + 0.5f) / bloomHeight };
+
+			// DownsampleBox
+			const Float4 A = sampleInput(uv, -1.0f, -1.0f);
+			const Float4 B = sampleInput(uv, 0.0f, -1.0f);
+			const Float4 C = sampleInput(uv, 1.0f, -1.0f);
+			const Float4 D = sampleInput(uv, -0.5f, -0.5f);
+			const Float4 E = sampleInput(uv, 0.5f, -0.5f);
+			const Float4 F = sampleInput(uv, -1.0f, 0.0f);
+			const Float4 G = sampleInput(uv, 0.0f, 0.0f);
+			const Float4 H = sampleInput(uv, 1.0f, 0.0f);
+			const Float4 I = sampleInput(uv, -0.5f, 0.5f);
+			const Float4 J = sampleInput(uv, 0.5f, 0.5f);
+			const Float4 K = sampleInput(uv, -1.0f, 1.0f);
+			const Float4 L = sampleInput(uv, 0.0f, 1.0f);
+			const Float4 M = sampleInput(uv, 1.0f, 1.0f);
+
+			Float4 color = (0.5f / 4.0f) * (D + E + I + J);
+			color += (0.125f / 4.0f) * (A + B + G + F);
+			color += (0.125f / 4.0f) * (B + C + H + G);
+			color += (0.125f / 4.0f) * (F + G + L + K);
+			color += (0.125f / 4.0f) * (G + H + M + L);
+
+			color *= exposure;
+			color = Float4{ MIN(color.x, EMISSIVE_CLAMP), MIN(color.y, EMISSIVE_CLAMP), MIN(color.z, EMISSIVE_CLAMP), MIN(color.w, EMISSIVE_CLAMP) };
+
+			// QuadraticThreshold
+			const float brightness = MAX(MAX(color.x, color.y), color.z);
+			float rq = std::clamp(brightness - (treshold - knee), 0.0f, 2.0f * knee);
+			rq = (0.25f / knee) * rq * rq;
+			color *= MAX(rq, brightness - treshold) / MAX(brightness, EPSILON);
+
+			return color;
+		};
+
+		std::vector<std::vector<Float4>> chain;
+		chain.resize(BLOOM_NUM_LEVELS);
+
+		chain[0].resize((size_t) bloomWidth * bloomHeight);
+		MTR::ParallelFor(bloomHeight, [&](uint32_t rowStart, uint32_t rowEnd, uint32_t)
+		{
+			for (uint32_t y = rowStart; y < rowEnd; y++)
+			{
+				for (uint32_t x = 0; x < bloomWidth; x++)
+				{
+					chain[0][(size_t) y * bloomWidth + x] = prefilter(x, y);
+				}
+			}
+		});
+
+		for (uint32_t level = 1; level < BLOOM_NUM_LEVELS; level++)
+		{
+			const uint32_t prevWidth = bloomWidth >> (level - 1);
+			const uint32_t levelWidth = bloomWidth >> level;
+			const uint32_t levelHeight = bloomHeight >> level;
+
+			const std::vector<Float4>& prevLevel = chain[level - 1];
+			std::vector<Float4>& currentLevel = chain[level];
+			currentLevel.resize((size_t) levelWidth * levelHeight);
+
+			for (uint32_t y = 0; y < levelHeight; y++)
+			{
+				for (uint32_t x = 0; x < levelWidth; x++)
+				{
+					const size_t child = (size_t) 2 * y * prevWidth + 2 * x;
+					Float4 value = prevLevel[child] + prevLevel[child + 1];
+					value += prevLevel[child + prevWidth] + prevLevel[child + prevWidth + 1];
+					currentLevel[(size_t) y * levelWidth + x] = 0.25f * value;
+				}
+			}
+		}
+
+		return chain;
+	}
+
+	Float4 ComposeReference(const std::vector<std::vector<Float4>>& chain, uint32_t bloomWidth, uint32_t bloomHeight, Float2 uv, Float4 sampleScale)
+	{
+		Float4 bloom{};
+		for (uint32_t level = 0; level < chain.size(); level++)
+		{
+			const uint32_t levelWidth = bloomWidth >> level;
+			const uint32_t levelHeight = bloomHeight >> level;
+			const auto sampleLevel = [&](float offsetX, float offsetY)
+			{
+				return SampleLinearBorder(chain[level], levelWidth, levelHeight, Float2{ uv.x + offsetX / levelWidth, uv.y + offsetY / levelHeight });
+			};
+
+			// UpsampleTent, shader scales the left and right offsets of the middle column with the z component
+			const float dx = sampleScale.x;
+			const float dy = sampleScale.y;
+			const float dz = sampleScale.z;
+			Float4 tent = sampleLevel(-dx, -dy);
+			tent += 2.0f * sampleLevel(0.0f, -dy);
+			tent += sampleLevel(dz, -dy);
+			tent += 2.0f * sampleLevel(-dz, 0.0f);
+			tent += 4.0f * sampleLevel(0.0f, 0.0f);
+			tent += 2.0f * sampleLevel(dx, 0.0f);
+			tent += sampleLevel(-dz, dy);
+			tent += 2.0f * sampleLevel(0.0f, dy);
+			tent += sampleLevel(dx, dy);
+
+			bloom += (1.0f / 16.0f) * tent;
+		}
+		return bloom;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include <Engine/Common.h>
+
+// CPU side of the bloom filters, doesn't depend on D3D12 so it can be tested on its own
+namespace BloomFilter
+{
+	// D3D12 linear filtering with the border color of zero
+	Float4 SampleLinearBorder(const std::vector<Float4>& image, uint32_t width, uint32_t height, Float2 uv);
+
+	// CPU version of the bloom.hlsl downsampler, input is RGBA float image
+	// GPU result must match it up to the precision of the RGBA16F chain
+	std::vector<std::vector<Float4>> GenerateReference(const float* input, uint32_t inputWidth, uint32_t inputHeight, uint32_t bloomWidth, uint32_t bloomHeight, float treshold, float knee, float exposure);
+
+	// CPU version of the bloom composite from postprocessing.hlsl, samples the chain the same way the D3D12 linear border sampler does
+	Float4 ComposeReference(const std::vector<std::vector<Float4>>& chain, uint32_t bloomWidth, uint32_t bloomHeight, Float2 uv, Float4 sampleScale);
+}
@@ -8,12 +8,15 @@
 #include <Engine/Utility/MathUtility.h>
 
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/HzbReduction.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Scene/SceneGraph.h"
 #include "Shaders/shared_definitions.h"
 
 void HZBGenerator::Init(GraphicsContext& context)
 {
-	m_GenerateHZBShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/generate_hzb.hlsl" });
+	m_GenerateHZBShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/generate_hzb.hlsl") });
+	GFX::WarmUpShader(m_GenerateHZBShader.get());
 }
 
 Texture* HZBGenerator::GetHZB(GraphicsContext& context, Texture* depth, const Camera& camera)
@@ -30,7 +33,7 @@ Texture* HZBGenerator::GetHZB(GraphicsContext& context, Texture* depth, const Ca
 		GraphicsState state{};
 		state.Table.UAVs[0] = m_ReprojectedDepth.get();
 		state.Shader = m_GenerateHZBShader.get();
-		state.ShaderConfig = { "CLEAR_DEPTH" };
+		state.ShaderConfig = m_GenerateHZBShader->Permutations.GetKey({ "CLEAR_DEPTH" });
 		state.ShaderStages = CS;
 		state.PushConstantCount = 2;
 		context.ApplyState(state);
@@ -58,7 +61,7 @@ Texture* HZBGenerator::GetHZB(GraphicsContext& context, Texture* depth, const Ca
 		state.Table.SRVs[0] = depth;
 		state.Table.UAVs[0] = m_ReprojectedDepth.get();
 		state.Shader = m_GenerateHZBShader.get();
-		state.ShaderConfig = { "REPROJECT_DEPTH" };
+		state.ShaderConfig = m_GenerateHZBShader->Permutations.GetKey({ "REPROJECT_DEPTH" });
 		state.ShaderStages = CS;
 		context.ApplyState(state);
 
@@ -67,47 +70,35 @@ Texture* HZBGenerator::GetHZB(GraphicsContext& context, Texture* depth, const Ca
 
 	// Generate HZB
 	{
-		// Get subresources
-		std::vector<Texture*> hzbMips{};
-		hzbMips.resize(m_HZBMips);
-		for(uint32_t i=0;i<m_HZBMips;i++)
-			hzbMips[i] = GFX::GetTextureSubresource(m_HZB.get(), i, i, 0, 0);
+		// Views are tracking the state on their own and are always left in the state of the parent
+		for (ScopedRef<TextureSubresourceView>& mipView : m_HZBMipViews) mipView->CurrState = m_HZB->CurrState;
 
-		// Common state
 		GraphicsState state{};
-		state.Table.SMPs[0] = { D3D12_FILTER_MAXIMUM_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP };
+		state.Table.SRVs[0] = m_ReprojectedDepth.get();
+		state.Table.UAVs[0] = m_GroupCounter.get();
+
+		// Shader declares all HZB_MAX_MIPS, slots after the last mip are never written
+		for (uint32_t i = 0; i < HZB_MAX_MIPS; i++) state.Table.UAVs[1 + i] = m_HZBMipViews[MIN(i, m_HZBMips - 1)].get();
+
 		state.Shader = m_GenerateHZBShader.get();
-		state.ShaderConfig = { "GENERATE_HZB" };
+		state.ShaderConfig = m_GenerateHZBShader->Permutations.GetKey({ "GENERATE_HZB" });
 		state.ShaderStages = CS;
 		state.PushConstantCount = 4;
-		
+		context.ApplyState(state);
+
+		const uint32_t numGroupsX = MathUtility::CeilDiv(depth->Width, HZB_TILE_SIZE);
+		const uint32_t numGroupsY = MathUtility::CeilDiv(depth->Height, HZB_TILE_SIZE);
+
 		PushConstantTable pushConstants;
-		pushConstants[2].Uint = depth->Width;
-		pushConstants[3].Uint = depth->Height;
-
-		for (uint32_t writeMip = 0; writeMip < m_HZBMips; writeMip++)
-		{
-			state.Table.SRVs[0] = writeMip == 0 ? m_ReprojectedDepth.get() : hzbMips[writeMip - 1];
-			state.Table.UAVs[0] = hzbMips[writeMip];
-			context.ApplyState(state);
-
-			pushConstants[0].Uint = writeMip == 0 ? 0 : writeMip - 1;
-			pushConstants[1].Uint = writeMip;
-			GFX::Cmd::SetPushConstants(CS, context, pushConstants);
-
-			const uint32_t mipWidth = depth->Width >> writeMip;
-			const uint32_t mipHeight = depth->Height >> writeMip;
-			GFX::Cmd::Dispatch(context, (UINT)MathUtility::CeilDiv(mipWidth, OPT_TILE_SIZE), (UINT)MathUtility::CeilDiv(mipHeight, OPT_TILE_SIZE), 1);
-		}
-	
-		// Bring back state of a parent resource
-		// And release subresources
-		for (uint32_t i = 0; i < m_HZBMips; i++)
-		{
-			GFX::Cmd::TransitionResource(context, hzbMips[i], m_HZB->CurrState);
-			delete hzbMips[i];
-		}
-			
+		pushConstants[0].Uint = depth->Width;
+		pushConstants[1].Uint = depth->Height;
+		pushConstants[2].Uint = m_HZBMips;
+		pushConstants[3].Uint = numGroupsX * numGroupsY;
+		GFX::Cmd::SetPushConstants(CS, context, pushConstants);
+
+		GFX::Cmd::Dispatch(context, numGroupsX, numGroupsY, 1);
+
+		for (ScopedRef<TextureSubresourceView>& mipView : m_HZBMipViews) GFX::Cmd::TransitionResource(context, mipView.get(), m_HZB->CurrState);
 	}
 
 	return m_HZB.get();
@@ -117,6 +108,18 @@ void HZBGenerator::RecreateTextures(GraphicsContext& context, uint32_t width, ui
 {
 	m_ReprojectedDepth = ScopedRef<Texture>(GFX::CreateTexture(width, height, RCF::UAV, 1, DXGI_FORMAT_R32_FLOAT));
 
-	m_HZBMips = (uint32_t) log2(MAX(width, height));
+	m_HZBMipViews.clear();
+	m_HZBMips = HZBReduction::GetNumMips(width, height);
 	m_HZB = ScopedRef<Texture>(GFX::CreateTexture(width, height, RCF::UAV, m_HZBMips, DXGI_FORMAT_R32_FLOAT));
+
+	m_HZBMipViews.resize(m_HZBMips);
+	for (uint32_t i = 0; i < m_HZBMips; i++) m_HZBMipViews[i] = ScopedRef<TextureSubresourceView>(GFX::GetTextureSubresource(m_HZB.get(), i, i, 0, 0));
+
+	// Last group resets the counter so it only needs to be cleared on creation
+	if (!m_GroupCounter)
+	{
+		const uint32_t zero = 0;
+		m_GroupCounter = ScopedRef<Buffer>(GFX::CreateBuffer(sizeof(uint32_t), sizeof(uint32_t), RCF::UAV | RCF::RAW));
+		GFX::Cmd::UploadToBuffer(context, m_GroupCounter.get(), 0, &zero, 0, sizeof(uint32_t));
+	}
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <vector>
+
 #include <Engine/Common.h>
 
 struct Texture;
+struct TextureSubresourceView;
+struct Buffer;
 struct Shader;
 struct GraphicsContext;
 struct Camera;
@@ -23,4 +27,6 @@ private:
 
 	ScopedRef<Texture> m_ReprojectedDepth;
 	ScopedRef<Texture> m_HZB;
+	std::vector<ScopedRef<TextureSubresourceView>> m_HZBMipViews;
+	ScopedRef<Buffer> m_GroupCounter;
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "HzbReduction.h"
+
+#include <cmath>
+
+#include "Shaders/shared_definitions.h"
+
+namespace HZBReduction
+{
+	uint32_t GetNumMips(uint32_t width, uint32_t height)
+	{
+		const uint32_t numMips = (uint32_t) log2(MAX(MAX(width, height), 2u));
+		return MIN(numMips, HZB_MAX_MIPS);
+	}
+
+	float ReduceTexel(const float* prevMip, uint32_t prevWidth, uint32_t prevHeight, uint32_t mipWidth, uint32_t mipHeight, uint32_t x, uint32_t y)
+	{
+		const uint32_t lastX = x == mipWidth - 1 ? prevWidth - 1 : MIN(2 * x + 1, prevWidth - 1);
+		const uint32_t lastY = y == mipHeight - 1 ? prevHeight - 1 : MIN(2 * y + 1, prevHeight - 1);
+
+		float maxDepth = 0.0f;
+		for (uint32_t childY = 2 * y; childY <= lastY; childY++)
+		{
+			for (uint32_t childX = 2 * x; childX <= lastX; childX++)
+			{
+				maxDepth = MAX(maxDepth, prevMip[(size_t) childY * prevWidth + childX]);
+			}
+		}
+		return maxDepth;
+	}
+
+	std::vector<std::vector<float>> GenerateReference(const float* depth, uint32_t width, uint32_t height)
+	{
+		const uint32_t numMips = GetNumMips(width, height);
+
+		std::vector<std::vector<float>> hzb;
+		hzb.resize(numMips);
+		hzb[0].assign(depth, depth + (size_t) width * height);
+
+		for (uint32_t mip = 1; mip < numMips; mip++)
+		{
+			const uint32_t prevWidth = MAX(width >> (mip - 1), 1u);
+			const uint32_t prevHeight = MAX(height >> (mip - 1), 1u);
+			const uint32_t mipWidth = MAX(width >> mip, 1u);
+			const uint32_t mipHeight = MAX(height >> mip, 1u);
+
+			std::vector<float>& currentMip = hzb[mip];
+			currentMip.resize((size_t) mipWidth * mipHeight);
+
+			for (uint32_t y = 0; y < mipHeight; y++)
+			{
+				for (uint32_t x = 0; x < mipWidth; x++)
+				{
+					currentMip[(size_t) y * mipWidth + x] = ReduceTexel(hzb[mip - 1].data(), prevWidth, prevHeight, mipWidth, mipHeight, x, y);
+				}
+			}
+		}
+
+		return hzb;
+	}
+}
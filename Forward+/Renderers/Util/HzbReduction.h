@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include <Engine/Common.h>
+
+// CPU side of the generate_hzb.hlsl reduction, doesn't depend on D3D12 so it can be tested on its own
+namespace HZBReduction
+{
+	uint32_t GetNumMips(uint32_t width, uint32_t height);
+
+	// Max of the 2x2 children of the texel in the previous mip
+	// Last texel in the row and column also takes the odd child, so nothing of the previous mip is lost
+	float ReduceTexel(const float* prevMip, uint32_t prevWidth, uint32_t prevHeight, uint32_t mipWidth, uint32_t mipHeight, uint32_t x, uint32_t y);
+
+	// Whole chain mip by mip, GPU result must match it exactly
+	std::vector<std::vector<float>> GenerateReference(const float* depth, uint32_t width, uint32_t height);
+}
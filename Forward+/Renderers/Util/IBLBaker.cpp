@@ -0,0 +1,575 @@
+#include "IBLBaker.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include <Engine/Loading/AssetArchive.h>
+#include <Engine/Loading/HDRPacking.h>
+#include <Engine/Loading/TextureLoading.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Engine/Utility/Hash.h>
+#include <Engine/Utility/Multithreading.h>
+
+namespace IBLBaker
+{
+	namespace
+	{
+		constexpr float PI = 3.14159265f;
+
+		constexpr uint32_t CACHE_MAGIC = 0x4C424949; // IIBL
+		constexpr uint32_t CACHE_VERSION = 3;
+
+		struct CacheHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t SourceHash;
+			BakeSettings Settings;
+		};
+
+		struct PanoramaLevel
+		{
+			uint32_t Width;
+			uint32_t Height;
+			std::vector<float> Pixels;
+		};
+
+		// Box filtered mips of the panorama, used for the filtered importance sampling
+		using PanoramaPyramid = std::vector<PanoramaLevel>;
+
+		// Importance sample precomputed in the tangent space of the normal
+		struct PrefilterSample
+		{
+			Float3 Direction;
+			float NdotL;
+			float Lod;
+		};
+
+		PanoramaPyramid BuildPanoramaPyramid(const TextureLoading::ImageDataHDR& panorama)
+		{
+			PanoramaPyramid pyramid;
+			pyramid.push_back(PanoramaLevel{ panorama.Width, panorama.Height, panorama.Pixels });
+
+			while (pyramid.back().Width > 1 && pyramid.back().Height > 1)
+			{
+				const PanoramaLevel& src = pyramid.back();
+
+				PanoramaLevel dst{};
+				dst.Width = src.Width / 2;
+				dst.Height = src.Height / 2;
+				dst.Pixels.resize((size_t) dst.Width * dst.Height * 4);
+
+				for (uint32_t y = 0; y < dst.Height; y++)
+				{
+					const uint32_t y0 = 2 * y;
+					const uint32_t y1 = MIN(2 * y + 1, src.Height - 1);
+					for (uint32_t x = 0; x < dst.Width; x++)
+					{
+						const uint32_t x0 = 2 * x;
+						const uint32_t x1 = MIN(2 * x + 1, src.Width - 1);
+						for (uint32_t c = 0; c < 4; c++)
+						{
+							const float sum = src.Pixels[4 * ((size_t) y0 * src.Width + x0) + c] + src.Pixels[4 * ((size_t) y0 * src.Width + x1) + c] +
+								src.Pixels[4 * ((size_t) y1 * src.Width + x0) + c] + src.Pixels[4 * ((size_t) y1 * src.Width + x1) + c];
+							dst.Pixels[4 * ((size_t) y * dst.Width + x) + c] = 0.25f * sum;
+						}
+					}
+				}
+
+				pyramid.push_back(std::move(dst));
+			}
+
+			return pyramid;
+		}
+
+		// Wraps horizontally and clamps vertically
+		DirectX::XMVECTOR SampleBilinear(const PanoramaLevel& level, float u, float v)
+		{
+			using namespace DirectX;
+
+			const float x = u * level.Width - 0.5f;
+			const float y = v * level.Height - 0.5f;
+			const float x0 = floorf(x);
+			const float y0 = floorf(y);
+
+			const auto load = [&level](int32_t px, int32_t py)
+			{
+				px = ((px % (int32_t) level.Width) + (int32_t) level.Width) % (int32_t) level.Width;
+				py = MIN(MAX(py, 0), (int32_t) level.Height - 1);
+				return XMLoadFloat4((const XMFLOAT4*) &level.Pixels[4 * ((size_t) py * level.Width + px)]);
+			};
+
+			const int32_t ix = (int32_t) x0;
+			const int32_t iy = (int32_t) y0;
+			const XMVECTOR top = XMVectorLerp(load(ix, iy), load(ix + 1, iy), x - x0);
+			const XMVECTOR bottom = XMVectorLerp(load(ix, iy + 1), load(ix + 1, iy + 1), x - x0);
+			return XMVectorLerp(top, bottom, y - y0);
+		}
+
+		// Inverse of the SphericalHarmonics::PanoramaTexelToDirection
+		DirectX::XMVECTOR SamplePanorama(const PanoramaPyramid& pyramid, const Float3& direction, float lod)
+		{
+			using namespace DirectX;
+
+			const float u = atan2f(direction.z, direction.x) / (2.0f * PI) + 0.5f;
+			const float v = asinf(MIN(MAX(direction.y, -1.0f), 1.0f)) / PI + 0.5f;
+
+			lod = MIN(MAX(lod, 0.0f), (float) (pyramid.size() - 1));
+			const uint32_t level0 = (uint32_t) lod;
+			const uint32_t level1 = MIN(level0 + 1, (uint32_t) pyramid.size() - 1);
+
+			const XMVECTOR sample0 = SampleBilinear(pyramid[level0], u, v);
+			if (level0 == level1) return sample0;
+			return XMVectorLerp(sample0, SampleBilinear(pyramid[level1], u, v), lod - level0);
+		}
+
+		// D3D cubemap face layout: +X, -X, +Y, -Y, +Z, -Z
+		Float3 CubemapTexelToDirection(uint32_t face, uint32_t x, uint32_t y, uint32_t size)
+		{
+			const float u = 2.0f * (x + 0.5f) / size - 1.0f;
+			const float v = 2.0f * (y + 0.5f) / size - 1.0f;
+
+			Float3 direction;
+			switch (face)
+			{
+			case 0: direction = Float3(1.0f, -v, -u); break;
+			case 1: direction = Float3(-1.0f, -v, u); break;
+			case 2: direction = Float3(u, 1.0f, v); break;
+			case 3: direction = Float3(u, -1.0f, -v); break;
+			case 4: direction = Float3(u, -v, 1.0f); break;
+			case 5: direction = Float3(-u, -v, -1.0f); break;
+			default: NOT_IMPLEMENTED;
+			}
+			return direction.Normalize();
+		}
+
+		void Hammersley(uint32_t index, uint32_t numSamples, float& xi0, float& xi1)
+		{
+			uint32_t bits = index;
+			bits = (bits << 16u) | (bits >> 16u);
+			bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+			bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+			bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+			bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+			xi0 = (float) index / numSamples;
+			xi1 = (float) bits * 2.3283064365386963e-10f;
+		}
+
+		// Half vector in the tangent space (normal is +Z), alpha = roughness^2 like in the lighting.h
+		Float3 ImportanceSampleGGX(float xi0, float xi1, float roughness)
+		{
+			const float alpha = roughness * roughness;
+			const float phi = 2.0f * PI * xi0;
+			const float cosTheta = sqrtf((1.0f - xi1) / (1.0f + (alpha * alpha - 1.0f) * xi1));
+			const float sinTheta = sqrtf(MAX(1.0f - cosTheta * cosTheta, 0.0f));
+			return Float3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+		}
+
+		float NdfGGX(float cosLh, float roughness)
+		{
+			const float alpha = roughness * roughness;
+			const float alphaSq = alpha * alpha;
+			const float denom = (cosLh * cosLh) * (alphaSq - 1.0f) + 1.0f;
+			return alphaSq / (PI * denom * denom);
+		}
+
+		// Schlick-GGX with k = alpha / 2 for the IBL
+		float GeometrySmithIBL(float cosLi, float cosLo, float roughness)
+		{
+			const float k = roughness * roughness / 2.0f;
+			const float g1Li = cosLi / (cosLi * (1.0f - k) + k);
+			const float g1Lo = cosLo / (cosLo * (1.0f - k) + k);
+			return g1Li * g1Lo;
+		}
+
+		void GetTangentBasis(const Float3& normal, Float3& tangent, Float3& bitangent)
+		{
+			const Float3 up = fabsf(normal.z) < 0.999f ? Float3(0.0f, 0.0f, 1.0f) : Float3(1.0f, 0.0f, 0.0f);
+			tangent = up.Cross(normal).Normalize();
+			bitangent = normal.Cross(tangent);
+		}
+
+		// Samples are the same for every texel of the mip, with N = V = R the light direction depends only on the half vector
+		std::vector<PrefilterSample> GeneratePrefilterSamples(float roughness, uint32_t numSamples, const PanoramaLevel& panorama)
+		{
+			const float texelSolidAngle = 4.0f * PI / ((float) panorama.Width * panorama.Height);
+
+			std::vector<PrefilterSample> samples;
+			samples.reserve(numSamples);
+			for (uint32_t i = 0; i < numSamples; i++)
+			{
+				float xi0, xi1;
+				Hammersley(i, numSamples, xi0, xi1);
+				const Float3 h = ImportanceSampleGGX(xi0, xi1, roughness);
+				const Float3 l = Float3(2.0f * h.z * h.x, 2.0f * h.z * h.y, 2.0f * h.z * h.z - 1.0f);
+				if (l.z <= 0.0f) continue;
+
+				// Filtered importance sampling, pdf of the light direction is D(h) / 4 when N = V
+				const float pdf = NdfGGX(h.z, roughness) / 4.0f;
+				const float sampleSolidAngle = 1.0f / (numSamples * pdf + 0.0001f);
+				const float lod = roughness == 0.0f ? 0.0f : MAX(0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+
+				samples.push_back(PrefilterSample{ l, l.z, lod });
+			}
+			return samples;
+		}
+
+		DirectX::XMVECTOR Prefilter(const PanoramaPyramid& pyramid, const std::vector<PrefilterSample>& samples, const Float3& normal)
+		{
+			using namespace DirectX;
+
+			Float3 tangent, bitangent;
+			GetTangentBasis(normal, tangent, bitangent);
+
+			XMVECTOR radiance = XMVectorZero();
+			float totalWeight = 0.0f;
+			for (const PrefilterSample& sample : samples)
+			{
+				const Float3 direction = sample.Direction.x * tangent + sample.Direction.y * bitangent + sample.Direction.z * normal;
+				radiance = XMVectorMultiplyAdd(SamplePanorama(pyramid, direction, sample.Lod), XMVectorReplicate(sample.NdotL), radiance);
+				totalWeight += sample.NdotL;
+			}
+			return XMVectorScale(radiance, 1.0f / MAX(totalWeight, 0.0001f));
+		}
+
+		Float2 IntegrateBRDF(float NdotV, float roughness, uint32_t numSamples)
+		{
+			const Float3 v = Float3(sqrtf(1.0f - NdotV * NdotV), 0.0f, NdotV);
+
+			float a = 0.0f;
+			float b = 0.0f;
+			for (uint32_t i = 0; i < numSamples; i++)
+			{
+				float xi0, xi1;
+				Hammersley(i, numSamples, xi0, xi1);
+				const Float3 h = ImportanceSampleGGX(xi0, xi1, roughness);
+				const float VdotH = v.Dot(h);
+				const Float3 l = 2.0f * VdotH * h - v;
+
+				const float NdotL = l.z;
+				const float NdotH = h.z;
+				if (NdotL <= 0.0f || VdotH <= 0.0f) continue;
+
+				const float visibility = GeometrySmithIBL(NdotL, NdotV, roughness) * VdotH / (NdotH * NdotV);
+				const float fresnel = powf(1.0f - VdotH, 5.0f);
+				a += (1.0f - fresnel) * visibility;
+				b += fresnel * visibility;
+			}
+			return Float2(a / numSamples, b / numSamples);
+		}
+
+		// Midpoint quadrature over the hemisphere of the light directions
+		Float2 IntegrateBRDFReference(float NdotV, float roughness)
+		{
+			constexpr uint32_t THETA_STEPS = 512;
+			constexpr uint32_t PHI_STEPS = 1024;
+			const float dTheta = (PI / 2.0f) / THETA_STEPS;
+			const float dPhi = (2.0f * PI) / PHI_STEPS;
+
+			const Float3 v = Float3(sqrtf(1.0f - NdotV * NdotV), 0.0f, NdotV);
+
+			double a = 0.0;
+			double b = 0.0;
+			for (uint32_t t = 0; t < THETA_STEPS; t++)
+			{
+				const float theta = (t + 0.5f) * dTheta;
+				for (uint32_t p = 0; p < PHI_STEPS; p++)
+				{
+					const float phi = (p + 0.5f) * dPhi;
+					const Float3 l = Float3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+					const Float3 h = (l + v).Normalize();
+					const float VdotH = MAX(v.Dot(h), 0.0f);
+
+					// BRDF without fresnel times NdotL
+					const float brdf = NdfGGX(h.z, roughness) * GeometrySmithIBL(l.z, NdotV, roughness) / (4.0f * NdotV);
+					const float weight = brdf * sinf(theta) * dTheta * dPhi;
+					const float fresnel = powf(1.0f - VdotH, 5.0f);
+					a += (1.0f - fresnel) * weight;
+					b += fresnel * weight;
+				}
+			}
+			return Float2((float) a, (float) b);
+		}
+
+		// Brute force over all texels of the panorama level
+		DirectX::XMVECTOR PrefilterReference(const PanoramaLevel& level, float roughness, const Float3& normal)
+		{
+			using namespace DirectX;
+
+			const float texelAngleArea = (2.0f * PI / level.Width) * (PI / level.Height);
+
+			XMVECTOR radiance = XMVectorZero();
+			float totalWeight = 0.0f;
+			for (uint32_t y = 0; y < level.Height; y++)
+			{
+				const float latitude = ((y + 0.5f) / level.Height - 0.5f) * PI;
+				const float solidAngle = cosf(latitude) * texelAngleArea;
+				for (uint32_t x = 0; x < level.Width; x++)
+				{
+					const Float3 l = SphericalHarmonics::PanoramaTexelToDirection(x, y, level.Width, level.Height);
+					const float NdotL = normal.Dot(l);
+					if (NdotL <= 0.0f) continue;
+
+					const float NdotH = normal.Dot((normal + l).Normalize());
+					const float weight = NdfGGX(NdotH, roughness) * NdotL * solidAngle;
+					radiance = XMVectorMultiplyAdd(XMLoadFloat4((const XMFLOAT4*) &level.Pixels[4 * ((size_t) y * level.Width + x)]), XMVectorReplicate(weight), radiance);
+					totalWeight += weight;
+				}
+			}
+			return XMVectorScale(radiance, 1.0f / MAX(totalWeight, 0.0001f));
+		}
+
+		void BakeSpecular(const PanoramaPyramid& pyramid, const BakeSettings& settings, BakedIBL& ibl)
+		{
+			using namespace DirectX;
+
+			ibl.SpecularCubemap.resize(ibl.GetMipOffset(6, 0));
+
+			HDRPacking::ConversionReport report{};
+			for (uint32_t mip = 0; mip < settings.NumMips; mip++)
+			{
+				const uint32_t mipSize = MAX(settings.CubemapSize >> mip, 1u);
+				const float roughness = settings.NumMips > 1 ? (float) mip / (settings.NumMips - 1) : 0.0f;
+				const std::vector<PrefilterSample> samples = GeneratePrefilterSamples(roughness, settings.NumSamples, pyramid[0]);
+				std::vector<HDRPacking::ConversionReport> rowReports(6 * mipSize);
+
+				// Every texel is written by exactly one thread so the result doesn't depend on the scheduling
+				// Row is prefiltered in floats and packed at once
+				MTR::ParallelFor(6 * mipSize, [&](uint32_t rowStart, uint32_t rowEnd, uint32_t)
+				{
+					std::vector<XMFLOAT4> radianceRow(mipSize);
+					for (uint32_t row = rowStart; row < rowEnd; row++)
+					{
+						const uint32_t face = row / mipSize;
+						const uint32_t y = row % mipSize;
+						uint8_t* dst = ibl.SpecularCubemap.data() + ibl.GetMipOffset(face, mip) + (size_t) y * mipSize * ibl.GetTexelSize();
+
+						for (uint32_t x = 0; x < mipSize; x++)
+						{
+							const Float3 direction = CubemapTexelToDirection(face, x, y, mipSize);
+							const XMVECTOR radiance = mip == 0 ? SamplePanorama(pyramid, direction, 0.0f) : Prefilter(pyramid, samples, direction);
+							XMStoreFloat4(&radianceRow[x], XMVectorSetW(radiance, 1.0f));
+						}
+
+						const float* values = &radianceRow[0].x;
+						if (settings.SpecularFormat == CubemapFormat::RGB9E5) rowReports[row] = HDRPacking::ToRGB9E5(values, mipSize, reinterpret_cast<uint32_t*>(dst));
+						else rowReports[row] = HDRPacking::ToHalf(values, (size_t) mipSize * 4, reinterpret_cast<uint16_t*>(dst));
+					}
+				});
+
+				for (const HDRPacking::ConversionReport& rowReport : rowReports) report.Add(rowReport);
+			}
+
+			if (report.HasErrors())
+			{
+				std::cout << "Warning: [IBLBaker] Specular cubemap has " << report.NumClamped << " values out of the range of the format and " << report.NumInvalid << " NaN values of "
+					<< report.NumValues << ", largest value is " << report.MaxMagnitude << std::endl;
+			}
+		}
+
+		void BakeBRDFLut(const BakeSettings& settings, BakedIBL& ibl)
+		{
+			const uint32_t size = settings.BRDFLutSize;
+			ibl.BRDFLut.resize((size_t) size * size * 2);
+
+			MTR::ParallelFor(size, [&](uint32_t rowStart, uint32_t rowEnd, uint32_t)
+			{
+				std::vector<float> valueRow((size_t) size * 2);
+				for (uint32_t y = rowStart; y < rowEnd; y++)
+				{
+					const float roughness = (y + 0.5f) / size;
+					for (uint32_t x = 0; x < size; x++)
+					{
+						const float NdotV = (x + 0.5f) / size;
+						const Float2 value = IntegrateBRDF(NdotV, roughness, settings.BRDFLutSamples);
+						valueRow[2 * x + 0] = value.x;
+						valueRow[2 * x + 1] = value.y;
+					}
+					HDRPacking::ToHalf(valueRow.data(), valueRow.size(), ibl.BRDFLut.data() + (size_t) y * size * 2);
+				}
+			});
+		}
+	}
+
+	size_t BakedIBL::GetMipOffset(uint32_t face, uint32_t mip) const
+	{
+		size_t faceSize = 0;
+		size_t mipOffset = 0;
+		for (uint32_t i = 0; i < Settings.NumMips; i++)
+		{
+			const size_t mipSize = MAX(Settings.CubemapSize >> i, 1u);
+			if (i == mip) mipOffset = faceSize;
+			faceSize += mipSize * mipSize * GetTexelSize();
+		}
+		return face * faceSize + mipOffset;
+	}
+
+	uint32_t BakedIBL::GetTexelSize() const
+	{
+		return Settings.SpecularFormat == CubemapFormat::RGB9E5 ? 4 : 8;
+	}
+
+	BakedIBL Bake(const TextureLoading::ImageDataHDR& panorama, const BakeSettings& settings)
+	{
+		BakedIBL ibl{};
+		ibl.Settings = settings;
+
+		const PanoramaPyramid pyramid = BuildPanoramaPyramid(panorama);
+		BakeSpecular(pyramid, settings, ibl);
+		BakeBRDFLut(settings, ibl);
+
+		const SphericalHarmonics::SH9Color radianceSH = SphericalHarmonics::ProjectPanorama(panorama.Pixels.data(), panorama.Width, panorama.Height);
+		ibl.IrradianceSH = SphericalHarmonics::ConvolveIrradiance(radianceSH);
+
+		return ibl;
+	}
+
+	bool HashSourceFile(const std::string& path, uint64_t& sourceHash)
+	{
+		// Same file as LoadImageHDR reads, from the mounted asset archive if it's packed
+		AssetArchive::AssetFile file;
+		if (!file.Open(path)) return false;
+
+		sourceHash = Hash::XXHash64(file.GetData(), file.GetSize());
+		return true;
+	}
+
+	std::string GetCachePath(uint64_t sourceHash)
+	{
+		std::stringstream ss;
+		ss << "Cache/IBL/" << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".ibl";
+		return ss.str();
+	}
+
+	bool LoadCache(const std::string& cachePath, uint64_t sourceHash, const BakeSettings& settings, BakedIBL& ibl)
+	{
+		std::vector<uint8_t> fileContent;
+		if (!FileUtility::ReadBinaryFile(cachePath, fileContent)) return false;
+
+		FileUtility::BinaryReader reader{ fileContent };
+
+		CacheHeader header{};
+		if (!reader.Read(header)) return false;
+		if (header.Magic != CACHE_MAGIC || header.Version != CACHE_VERSION || header.SourceHash != sourceHash || !(header.Settings == settings)) return false;
+
+		BakedIBL cached{};
+		cached.Settings = settings;
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			Float3& coefficient = cached.IrradianceSH.Coefficients[i];
+			reader.Read(coefficient.x);
+			reader.Read(coefficient.y);
+			reader.Read(coefficient.z);
+		}
+		reader.ReadArray(cached.SpecularCubemap, cached.GetMipOffset(6, 0));
+		reader.ReadArray(cached.BRDFLut, (size_t) settings.BRDFLutSize * settings.BRDFLutSize * 2);
+
+		if (!reader.IsValid() || !reader.IsAtEnd())
+		{
+			std::cout << "Warning: Corrupted IBL cache: " << cachePath << std::endl;
+			return false;
+		}
+
+		ibl = std::move(cached);
+		return true;
+	}
+
+	void SaveCache(const std::string& cachePath, uint64_t sourceHash, const BakedIBL& ibl)
+	{
+		CacheHeader header{};
+		header.Magic = CACHE_MAGIC;
+		header.Version = CACHE_VERSION;
+		header.SourceHash = sourceHash;
+		header.Settings = ibl.Settings;
+
+		FileUtility::BinaryWriter writer;
+		writer.Write(header);
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			const Float3& coefficient = ibl.IrradianceSH.Coefficients[i];
+			writer.Write(coefficient.x);
+			writer.Write(coefficient.y);
+			writer.Write(coefficient.z);
+		}
+		writer.WriteArray(ibl.SpecularCubemap);
+		writer.WriteArray(ibl.BRDFLut);
+
+		if (!FileUtility::WriteBinaryFile(cachePath, writer.GetData().data(), writer.GetData().size()))
+		{
+			std::cout << "Warning: Failed to write IBL cache: " << cachePath << std::endl;
+		}
+	}
+
+	float ValidateSpecular(const TextureLoading::ImageDataHDR& panorama, uint32_t numSamples)
+	{
+		using namespace DirectX;
+
+		static const Float3 directions[] =
+		{
+			Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f),
+			Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f),
+			Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f),
+			Float3(1.0f, 1.0f, 1.0f), Float3(-1.0f, -1.0f, -1.0f),
+		};
+		static const float roughnessValues[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+
+		const PanoramaPyramid pyramid = BuildPanoramaPyramid(panorama);
+
+		// Reference on the smaller level to keep the brute force in reasonable time
+		uint32_t referenceLevel = 0;
+		while (referenceLevel + 1 < pyramid.size() && pyramid[referenceLevel].Width > 256) referenceLevel++;
+
+		const uint32_t numDirections = STATIC_ARRAY_SIZE(directions);
+		const uint32_t numTests = numDirections * STATIC_ARRAY_SIZE(roughnessValues);
+		std::vector<float> errors;
+		errors.resize(numTests);
+
+		MTR::ParallelFor(numTests, [&](uint32_t testStart, uint32_t testEnd, uint32_t)
+		{
+			for (uint32_t i = testStart; i < testEnd; i++)
+			{
+				const Float3 normal = directions[i % numDirections].Normalize();
+				const float roughness = roughnessValues[i / numDirections];
+
+				const std::vector<PrefilterSample> samples = GeneratePrefilterSamples(roughness, numSamples, pyramid[0]);
+				const Float3 approximation = Float3(Prefilter(pyramid, samples, normal));
+				const Float3 reference = Float3(PrefilterReference(pyramid[referenceLevel], roughness, normal));
+
+				errors[i] = (approximation - reference).Length() / MAX(reference.Length(), 0.0001f);
+			}
+		});
+
+		float maxError = 0.0f;
+		for (float error : errors) maxError = MAX(maxError, error);
+		return maxError;
+	}
+
+	float ValidateBRDFLut(uint32_t numSamples)
+	{
+		static const float NdotVValues[] = { 0.1f, 0.4f, 0.7f, 1.0f };
+		static const float roughnessValues[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+
+		const uint32_t numNdotV = STATIC_ARRAY_SIZE(NdotVValues);
+		const uint32_t numTests = numNdotV * STATIC_ARRAY_SIZE(roughnessValues);
+		std::vector<float> errors;
+		errors.resize(numTests);
+
+		MTR::ParallelFor(numTests, [&](uint32_t testStart, uint32_t testEnd, uint32_t)
+		{
+			for (uint32_t i = testStart; i < testEnd; i++)
+			{
+				const float NdotV = NdotVValues[i % numNdotV];
+				const float roughness = roughnessValues[i / numNdotV];
+
+				const Float2 approximation = IntegrateBRDF(NdotV, roughness, numSamples);
+				const Float2 reference = IntegrateBRDFReference(NdotV, roughness);
+				errors[i] = MAX(fabsf(approximation.x - reference.x), fabsf(approximation.y - reference.y));
+			}
+		});
+
+		float maxError = 0.0f;
+		for (float error : errors) maxError = MAX(maxError, error);
+		return maxError;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+#include <Engine/Common.h>
+
+#include "Renderers/Util/SphericalHarmonics.h"
+
+namespace TextureLoading
+{
+	struct ImageDataHDR;
+}
+
+// CPU bake of the image based lighting from the HDR panorama
+// Specular is prefiltered with GGX importance sampling (split sum), results are cached on disk so the renderer only uploads them
+namespace IBLBaker
+{
+	// Specular has no alpha, the shared exponent format keeps enough precision for the radiance in half of the size
+	enum class CubemapFormat : uint32_t
+	{
+		RGBA16F,
+		RGB9E5,
+	};
+
+	struct BakeSettings
+	{
+		uint32_t CubemapSize = 512;
+		uint32_t NumMips = 6; // Roughness of the mip is mip / (NumMips - 1)
+		uint32_t NumSamples = 256;
+		uint32_t BRDFLutSize = 128;
+		uint32_t BRDFLutSamples = 512;
+		CubemapFormat SpecularFormat = CubemapFormat::RGB9E5;
+
+		bool operator==(const BakeSettings& other) const = default;
+	};
+
+	struct BakedIBL
+	{
+		BakeSettings Settings;
+
+		// Texels in the SpecularFormat, all mips of the face are stored before the next face
+		std::vector<uint8_t> SpecularCubemap;
+
+		// RG16F, x is NdotV and y is roughness
+		std::vector<uint16_t> BRDFLut;
+
+		SphericalHarmonics::SH9Color IrradianceSH;
+
+		// Offset in the SpecularCubemap, in bytes
+		size_t GetMipOffset(uint32_t face, uint32_t mip) const;
+		uint32_t GetTexelSize() const;
+	};
+
+	// Deterministic, same input always gives the same bits regardless of the number of threads
+	BakedIBL Bake(const TextureLoading::ImageDataHDR& panorama, const BakeSettings& settings);
+
+	bool HashSourceFile(const std::string& path, uint64_t& sourceHash);
+	std::string GetCachePath(uint64_t sourceHash);
+
+	// Fails if the cache doesn't exist or if it was made with different version, source or settings
+	bool LoadCache(const std::string& cachePath, uint64_t sourceHash, const BakeSettings& settings, BakedIBL& ibl);
+	void SaveCache(const std::string& cachePath, uint64_t sourceHash, const BakedIBL& ibl);
+
+	// Compares importance sampled prefilter with numSamples against brute force integration over the panorama, returns max relative error
+	float ValidateSpecular(const TextureLoading::ImageDataHDR& panorama, uint32_t numSamples);
+
+	// Compares importance sampled BRDF integration with numSamples against numerical quadrature, returns max absolute error
+	float ValidateBRDFLut(uint32_t numSamples);
+}
\ No newline at end of file
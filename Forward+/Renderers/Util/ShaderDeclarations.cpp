@@ -0,0 +1,91 @@
+#include "ShaderDeclarations.h"
+
+#include <iostream>
+#include <cstdlib>
+
+namespace ShaderDeclarations
+{
+	const std::vector<ShaderDeclaration>& GetAll()
+	{
+		static const std::vector<ShaderDeclaration> Declarations = {
+			ShaderDeclaration{ "Forward+/Shaders/bloom.hlsl" }
+				.Implementations(CS),
+
+			ShaderDeclaration{ "Forward+/Shaders/debug_geometry.hlsl" }
+				.Implementations(VS | PS),
+
+			ShaderDeclaration{ "Forward+/Shaders/depth.hlsl", {
+				ShaderPermutationAxis::Flag("MOTION_VECTORS"),
+				ShaderPermutationAxis::Flag("SHADOWMAP"),
+				ShaderPermutationAxis::Flag("ALPHA_DISCARD") } }
+				.Implementations(VS | PS, {}, { "MOTION_VECTORS", "ALPHA_DISCARD" })
+				.Implementations(VS | PS, { "SHADOWMAP" }, { "ALPHA_DISCARD" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/generate_hzb.hlsl", {
+				ShaderPermutationAxis::Option({ "CLEAR_DEPTH", "REPROJECT_DEPTH", "GENERATE_HZB" }) } }
+				.Implementations(CS, { "CLEAR_DEPTH" })
+				.Implementations(CS, { "REPROJECT_DEPTH" })
+				.Implementations(CS, { "GENERATE_HZB" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/geometry.hlsl", {
+				ShaderPermutationAxis::Flag("ALPHA_DISCARD"),
+				ShaderPermutationAxis::Flag("ALPHA_BLEND"),
+				ShaderPermutationAxis::Flag("DISABLE_LIGHT_CULLING"),
+				ShaderPermutationAxis::Flag("USE_PBR"),
+				ShaderPermutationAxis::Flag("USE_IBL") } }
+				.Implementations(VS | PS, {}, { "ALPHA_DISCARD", "ALPHA_BLEND", "DISABLE_LIGHT_CULLING", "USE_PBR", "USE_IBL" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/geometry_culling.hlsl", {
+				ShaderPermutationAxis::Option({ "GEO_CULLING", "PREPARE_ARGUMENTS" }),
+				ShaderPermutationAxis::Flag("FORCE_VISIBLE"),
+				ShaderPermutationAxis::Flag("OCCLUSION_CULLING"),
+				ShaderPermutationAxis::Flag("WAVEFRONT_SIZE_GE_32") } }
+				.Implementations(CS, { "GEO_CULLING" }, { "FORCE_VISIBLE", "OCCLUSION_CULLING", "WAVEFRONT_SIZE_GE_32" })
+				.Implementations(CS, { "PREPARE_ARGUMENTS" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/light_culling.hlsl" }
+				.Implementations(CS),
+
+			ShaderDeclaration{ "Forward+/Shaders/light_heatmap.hlsl" }
+				.Implementations(VS | PS),
+
+			ShaderDeclaration{ "Forward+/Shaders/postprocessing.hlsl", {
+				ShaderPermutationAxis::Option({ "TONEMAPPING", "TAA" }),
+				ShaderPermutationAxis::Flag("APPLY_BLOOM") } }
+				.Implementations(VS | PS, { "TONEMAPPING" }, { "APPLY_BLOOM" })
+				.Implementations(VS | PS, { "TAA" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/resolve_depth.hlsl" }
+				.Implementations(VS | PS),
+
+			ShaderDeclaration{ "Forward+/Shaders/shadowmask.hlsl" }
+				.Implementations(VS | PS),
+
+			ShaderDeclaration{ "Forward+/Shaders/skybox.hlsl" }
+				.Implementations(VS | PS),
+
+			ShaderDeclaration{ "Forward+/Shaders/ssao.hlsl", {
+				ShaderPermutationAxis::Option({ "SSAO_SAMPLE", "SSAO_BLUR" }) } }
+				.Implementations(VS | PS, { "SSAO_SAMPLE" })
+				.Implementations(VS | PS, { "SSAO_BLUR" }),
+
+			ShaderDeclaration{ "Forward+/Shaders/texture_debugger.hlsl", {
+				ShaderPermutationAxis::Option({ "TEXTURE_PREVIEW", "READ_RANGE" }),
+				ShaderPermutationAxis::Flag("SHOW_ALPHA") } }
+				.Implementations(VS | PS, { "TEXTURE_PREVIEW" }, { "SHOW_ALPHA" })
+				.Implementations(CS, { "READ_RANGE" }),
+		};
+		return Declarations;
+	}
+
+	const ShaderDeclaration& Get(const std::string& path)
+	{
+		const ShaderDeclaration* declaration = ShaderManifest::Find(GetAll(), path);
+		if (!declaration)
+		{
+			std::cout << "Error: Shader " << path << " isn't declared in ShaderDeclarations" << std::endl;
+			std::abort();
+		}
+		return *declaration;
+	}
+}
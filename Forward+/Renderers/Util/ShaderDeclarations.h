@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Engine/Render/ShaderManifest.h>
+
+// Every shader of the Forward+ renderers with the implementations they use
+// Doesn't depend on D3D12, the offline shader precompiler builds the archive from the same list
+namespace ShaderDeclarations
+{
+	const std::vector<ShaderDeclaration>& GetAll();
+
+	// Aborts if the shader isn't declared
+	const ShaderDeclaration& Get(const std::string& path);
+}
@@ -0,0 +1,222 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Scene/SceneGraph.h"
+
+ShadowAtlas::ShadowAtlas(uint32_t atlasSize, uint32_t minTileSize, uint32_t maxTileSize) :
+	m_MinTileSize(minTileSize),
+	m_MaxTileSize(maxTileSize),
+	m_Allocator(atlasSize, minTileSize)
+{
+	ASSERT(minTileSize <= maxTileSize && maxTileSize <= atlasSize, "[ShadowAtlas] Invalid tile sizes!");
+}
+
+float ShadowAtlas::CalculateImportance(const Light& light, const Camera& camera)
+{
+	BoundingSphere lightVolume{};
+	lightVolume.Center = light.Position;
+	lightVolume.Radius = light.Falloff.y;
+
+	if (lightVolume.Radius <= 0.0f || !camera.CameraFrustum.IsInFrustum(lightVolume)) return 0.0f;
+
+	const float distance = (light.Position - camera.CurrentTranform.Position).Length();
+
+	// Camera is inside of the light volume
+	if (distance <= lightVolume.Radius) return 1.0f;
+
+	float projectedRadius = 0.0f;
+	if (camera.Type == Camera::CameraType::Perspective)
+	{
+		const float DEG_2_RAD = 3.1415f / 180.0f;
+		projectedRadius = lightVolume.Radius / (distance * tanf(camera.FOV * DEG_2_RAD / 2.0f));
+	}
+	else
+	{
+		projectedRadius = 2.0f * lightVolume.Radius / camera.RectHeight;
+	}
+
+	return MIN(projectedRadius, 1.0f);
+}
+
+uint32_t ShadowAtlas::SelectTileSize(float importance) const
+{
+	const float desiredSize = importance * m_MaxTileSize;
+
+	uint32_t tileSize = m_MinTileSize;
+	while (tileSize < m_MaxTileSize && (float) tileSize < desiredSize) tileSize *= 2;
+	return tileSize;
+}
+
+void ShadowAtlas::Update(std::vector<ShadowAtlasRequest>& requests, uint32_t lightBudget)
+{
+	m_Stats = {};
+	m_Stats.RequestedLights = (uint32_t) requests.size();
+
+	// Most important first, light index makes the order deterministic
+	const auto isMoreImportant = [](const ShadowAtlasRequest& a, const ShadowAtlasRequest& b)
+	{
+		if (a.Importance != b.Importance) return a.Importance > b.Importance;
+		return a.LightIndex < b.LightIndex;
+	};
+	std::sort(requests.begin(), requests.end(), isMoreImportant);
+
+	uint32_t numRequests = 0;
+	while (numRequests < requests.size() && numRequests < lightBudget && requests[numRequests].Importance > 0.0f) numRequests++;
+
+	// Select tile sizes
+	const uint64_t atlasArea = (uint64_t) m_Allocator.GetAtlasSize() * m_Allocator.GetAtlasSize();
+	uint64_t requiredArea = 0;
+
+	std::vector<uint32_t> tileSizes;
+	tileSizes.resize(numRequests);
+	for (uint32_t i = 0; i < numRequests; i++)
+	{
+		ASSERT(requests[i].NumFaces > 0 && requests[i].NumFaces <= ShadowAtlasEntry::MAX_FACES, "[ShadowAtlas] Invalid number of faces!");
+		tileSizes[i] = SelectTileSize(requests[i].Importance);
+		requiredArea += (uint64_t) requests[i].NumFaces * tileSizes[i] * tileSizes[i];
+	}
+
+	// Shrink tiles starting from the least important light until everything fits
+	bool shrinked = true;
+	while (requiredArea > atlasArea && shrinked)
+	{
+		shrinked = false;
+		for (int32_t i = (int32_t) numRequests - 1; i >= 0 && requiredArea > atlasArea; i--)
+		{
+			if (tileSizes[i] <= m_MinTileSize) continue;
+
+			const uint64_t tileSize = tileSizes[i];
+			requiredArea -= requests[i].NumFaces * (tileSize * tileSize - (tileSize / 2) * (tileSize / 2));
+			tileSizes[i] /= 2;
+			shrinked = true;
+		}
+	}
+
+	// Still doesn't fit, drop the least important lights
+	while (requiredArea > atlasArea && numRequests > 0)
+	{
+		numRequests--;
+		requiredArea -= (uint64_t) requests[numRequests].NumFaces * tileSizes[numRequests] * tileSizes[numRequests];
+	}
+
+	// Reuse allocations from the last frame
+	std::unordered_map<uint32_t, ShadowAtlasEntry> lastEntries;
+	for (const ShadowAtlasEntry& entry : m_Entries) lastEntries[entry.LightIndex] = entry;
+
+	std::vector<ShadowAtlasEntry> entries;
+	entries.reserve(numRequests);
+	for (uint32_t i = 0; i < numRequests; i++)
+	{
+		const ShadowAtlasRequest& request = requests[i];
+
+		ShadowAtlasEntry entry{};
+		const auto lastEntry = lastEntries.find(request.LightIndex);
+		if (lastEntry != lastEntries.end() && lastEntry->second.TileSize == tileSizes[i] && lastEntry->second.NumFaces == request.NumFaces)
+		{
+			entry = lastEntry->second;
+			entry.IsNew = false;
+			lastEntries.erase(lastEntry);
+		}
+		else
+		{
+			entry.LightIndex = request.LightIndex;
+			entry.NumFaces = request.NumFaces;
+			entry.TileSize = tileSizes[i];
+			entry.IsNew = true;
+		}
+		entry.Importance = request.Importance;
+		entries.push_back(entry);
+	}
+
+	// Evict lights that lost the shadow or changed the tile size
+	for (auto& [lightIndex, entry] : lastEntries)
+	{
+		ReleaseEntry(entry);
+		m_Stats.Evictions++;
+	}
+
+	// Allocate new entries, if atlas got too fragmented pack everything again
+	bool needsRepack = false;
+	for (ShadowAtlasEntry& entry : entries)
+	{
+		if (entry.Tiles[0].IsValid()) continue;
+
+		if (!AllocateEntry(entry))
+		{
+			needsRepack = true;
+			break;
+		}
+		m_Stats.Allocations++;
+	}
+
+	m_Entries = entries;
+
+	if (needsRepack) Repack();
+
+	m_Stats.ShadowedLights = (uint32_t) m_Entries.size();
+	m_Stats.Occupancy = m_Allocator.GetOccupancy();
+}
+
+void ShadowAtlas::Clear()
+{
+	m_Allocator.Clear();
+	m_Entries.clear();
+	m_Stats = {};
+}
+
+bool ShadowAtlas::AllocateEntry(ShadowAtlasEntry& entry)
+{
+	for (uint32_t i = 0; i < entry.NumFaces; i++)
+	{
+		entry.Tiles[i] = m_Allocator.Allocate(entry.TileSize);
+		if (!entry.Tiles[i].IsValid())
+		{
+			ReleaseEntry(entry);
+			return false;
+		}
+	}
+	return true;
+}
+
+void ShadowAtlas::ReleaseEntry(ShadowAtlasEntry& entry)
+{
+	for (uint32_t i = 0; i < entry.NumFaces; i++)
+	{
+		m_Allocator.Release(entry.Tiles[i]);
+	}
+}
+
+void ShadowAtlas::Repack()
+{
+	m_Stats.Repacks++;
+	m_Allocator.Clear();
+
+	// Allocating from the biggest to the smallest tile never fails in the quad tree while total area fits
+	std::vector<uint32_t> packOrder;
+	packOrder.resize(m_Entries.size());
+	for (uint32_t i = 0; i < packOrder.size(); i++)
+	{
+		packOrder[i] = i;
+		m_Entries[i].IsNew = true;
+		for (AtlasAllocation& tile : m_Entries[i].Tiles) tile = {};
+	}
+	std::stable_sort(packOrder.begin(), packOrder.end(), [this](uint32_t a, uint32_t b) { return m_Entries[a].TileSize > m_Entries[b].TileSize; });
+
+	std::vector<bool> packed;
+	packed.resize(m_Entries.size());
+	for (uint32_t entryIndex : packOrder)
+	{
+		packed[entryIndex] = AllocateEntry(m_Entries[entryIndex]);
+		if (packed[entryIndex]) m_Stats.Allocations++;
+	}
+
+	std::vector<ShadowAtlasEntry> packedEntries;
+	packedEntries.reserve(m_Entries.size());
+	for (uint32_t i = 0; i < m_Entries.size(); i++)
+	{
+		if (packed[i]) packedEntries.push_back(m_Entries[i]);
+	}
+	m_Entries = packedEntries;
+}
\ No newline at end of file
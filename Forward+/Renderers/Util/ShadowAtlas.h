@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include <Engine/Common.h>
+#include <Engine/Utility/MemoryStrategies.h>
+
+struct Light;
+struct Camera;
+
+// Shadow that one light wants to have in the atlas this frame
+struct ShadowAtlasRequest
+{
+	uint32_t LightIndex = 0;
+	uint32_t NumFaces = 6;
+	float Importance = 0.0f;
+};
+
+struct ShadowAtlasEntry
+{
+	static constexpr uint32_t MAX_FACES = 6;
+
+	uint32_t LightIndex = 0;
+	uint32_t NumFaces = 0;
+	uint32_t TileSize = 0;
+	float Importance = 0.0f;
+	AtlasAllocation Tiles[MAX_FACES];
+
+	// Tiles were allocated this frame, their content from the last frame belongs to another light
+	bool IsNew = false;
+};
+
+struct ShadowAtlasStats
+{
+	uint32_t RequestedLights = 0;
+	uint32_t ShadowedLights = 0;
+	uint32_t Allocations = 0;
+	uint32_t Evictions = 0;
+	uint32_t Repacks = 0;
+	float Occupancy = 0.0f;
+};
+
+// CPU side of the local light shadow atlas
+// Decides which lights get shadows and where they are in the atlas, doesn't touch the GPU
+class ShadowAtlas
+{
+public:
+	// Atlas of the ShadowRenderer, tiles are power of 2 sizes between the min and the max
+	static constexpr uint32_t ATLAS_SIZE = 4096;
+	static constexpr uint32_t MIN_TILE_SIZE = 64;
+	static constexpr uint32_t MAX_TILE_SIZE = 1024;
+
+	ShadowAtlas(uint32_t atlasSize, uint32_t minTileSize, uint32_t maxTileSize);
+
+	// Fraction of the screen height that light volume covers [0,1], 0 if light is not visible
+	static float CalculateImportance(const Light& light, const Camera& camera);
+
+	uint32_t SelectTileSize(float importance) const;
+
+	// Keeps up to lightBudget most important requests in the atlas
+	// Allocations are kept between frames if the tile size didn't change, only the new entries have to be drawn again
+	void Update(std::vector<ShadowAtlasRequest>& requests, uint32_t lightBudget);
+
+	void Clear();
+
+	// Sorted by importance, most important first
+	const std::vector<ShadowAtlasEntry>& GetEntries() const { return m_Entries; }
+	const ShadowAtlasStats& GetStats() const { return m_Stats; }
+
+	uint32_t GetAtlasSize() const { return m_Allocator.GetAtlasSize(); }
+
+private:
+	bool AllocateEntry(ShadowAtlasEntry& entry);
+	void ReleaseEntry(ShadowAtlasEntry& entry);
+	void Repack();
+
+private:
+	uint32_t m_MinTileSize;
+	uint32_t m_MaxTileSize;
+
+	QuadTreeStrategy m_Allocator;
+	std::vector<ShadowAtlasEntry> m_Entries;
+	ShadowAtlasStats m_Stats;
+};
\ No newline at end of file
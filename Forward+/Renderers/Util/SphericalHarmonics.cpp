@@ -0,0 +1,180 @@
+#include "SphericalHarmonics.h"
+
+#include <vector>
+
+#include <Engine/Utility/Multithreading.h>
+
+namespace SphericalHarmonics
+{
+	namespace
+	{
+		constexpr float PI = 3.14159265f;
+
+		// Cosine lobe convolution factors per band
+		constexpr float COSINE_LOBE[NUM_COEFFICIENTS] = { PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f };
+
+		void EvaluateBasis(const Float3& d, float basis[NUM_COEFFICIENTS])
+		{
+			basis[0] = 0.282095f;
+			basis[1] = 0.488603f * d.y;
+			basis[2] = 0.488603f * d.z;
+			basis[3] = 0.488603f * d.x;
+			basis[4] = 1.092548f * d.x * d.y;
+			basis[5] = 1.092548f * d.y * d.z;
+			basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+			basis[7] = 1.092548f * d.x * d.z;
+			basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+		}
+	}
+
+	Float3 PanoramaTexelToDirection(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		// Inverse of the SprericalToUV
+		const float u = (x + 0.5f) / width;
+		const float v = (y + 0.5f) / height;
+		const float phi = (u - 0.5f) * 2.0f * PI;
+		const float latitude = (v - 0.5f) * PI;
+		return Float3{ cosf(latitude) * cosf(phi), sinf(latitude), cosf(latitude) * sinf(phi) };
+	}
+
+	SH9Color ProjectPanorama(const float* pixels, uint32_t width, uint32_t height)
+	{
+		using namespace DirectX;
+
+		const uint32_t numThreads = MTR::GetNumWorkerThreads(height);
+		std::vector<XMVECTOR> threadResults;
+		threadResults.resize(numThreads * NUM_COEFFICIENTS, XMVectorZero());
+
+		const float texelAngleArea = (2.0f * PI / width) * (PI / height);
+
+		MTR::ParallelFor(height, [&](uint32_t rowStart, uint32_t rowEnd, uint32_t threadIndex)
+		{
+			XMVECTOR accumulated[NUM_COEFFICIENTS];
+			for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++) accumulated[i] = XMVectorZero();
+
+			float basis[NUM_COEFFICIENTS];
+			for (uint32_t y = rowStart; y < rowEnd; y++)
+			{
+				const float latitude = ((y + 0.5f) / height - 0.5f) * PI;
+				const float solidAngle = cosf(latitude) * texelAngleArea;
+
+				for (uint32_t x = 0; x < width; x++)
+				{
+					EvaluateBasis(PanoramaTexelToDirection(x, y, width, height), basis);
+
+					const XMVECTOR radiance = XMVectorScale(XMLoadFloat4((const XMFLOAT4*) &pixels[4 * ((size_t) y * width + x)]), solidAngle);
+					for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++)
+					{
+						accumulated[i] = XMVectorMultiplyAdd(radiance, XMVectorReplicate(basis[i]), accumulated[i]);
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++) threadResults[threadIndex * NUM_COEFFICIENTS + i] = accumulated[i];
+		});
+
+		SH9Color sh{};
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++)
+			{
+				sh.Coefficients[i] += Float3{ threadResults[t * NUM_COEFFICIENTS + i] };
+			}
+		}
+		return sh;
+	}
+
+	SH9Color ConvolveIrradiance(const SH9Color& radiance)
+	{
+		SH9Color irradiance{};
+		for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++)
+		{
+			irradiance.Coefficients[i] = (COSINE_LOBE[i] / PI) * radiance.Coefficients[i];
+		}
+		return irradiance;
+	}
+
+	Float3 Evaluate(const SH9Color& sh, const Float3& direction)
+	{
+		float basis[NUM_COEFFICIENTS];
+		EvaluateBasis(direction, basis);
+
+		Float3 result{ 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++)
+		{
+			result += basis[i] * sh.Coefficients[i];
+		}
+		return result;
+	}
+
+	Float3 IntegrateIrradiance(const float* pixels, uint32_t width, uint32_t height, const Float3& normal)
+	{
+		const uint32_t numThreads = MTR::GetNumWorkerThreads(height);
+		std::vector<Float3> threadResults;
+		threadResults.resize(numThreads);
+
+		const float texelAngleArea = (2.0f * PI / width) * (PI / height);
+
+		MTR::ParallelFor(height, [&](uint32_t rowStart, uint32_t rowEnd, uint32_t threadIndex)
+		{
+			Float3 irradiance{ 0.0f, 0.0f, 0.0f };
+			for (uint32_t y = rowStart; y < rowEnd; y++)
+			{
+				const float latitude = ((y + 0.5f) / height - 0.5f) * PI;
+				const float solidAngle = cosf(latitude) * texelAngleArea;
+
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const Float3 direction = PanoramaTexelToDirection(x, y, width, height);
+					const float cosTheta = normal.x * direction.x + normal.y * direction.y + normal.z * direction.z;
+					if (cosTheta <= 0.0f) continue;
+
+					const float* pixel = &pixels[4 * ((size_t) y * width + x)];
+					irradiance += (cosTheta * solidAngle) * Float3{ pixel[0], pixel[1], pixel[2] };
+				}
+			}
+			threadResults[threadIndex] = irradiance;
+		});
+
+		Float3 irradiance{ 0.0f, 0.0f, 0.0f };
+		for (const Float3& threadResult : threadResults) irradiance += threadResult;
+		return irradiance / PI;
+	}
+
+	float ValidateIrradiance(const SH9Color& irradiance, const float* pixels, uint32_t width, uint32_t height)
+	{
+		static const Float3 directions[] =
+		{
+			Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f),
+			Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f),
+			Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f),
+			Float3(1.0f, 1.0f, 1.0f), Float3(-1.0f, 1.0f, 1.0f),
+			Float3(1.0f, -1.0f, 1.0f), Float3(1.0f, 1.0f, -1.0f),
+			Float3(-1.0f, -1.0f, 1.0f), Float3(-1.0f, 1.0f, -1.0f),
+			Float3(1.0f, -1.0f, -1.0f), Float3(-1.0f, -1.0f, -1.0f),
+		};
+
+		float maxError = 0.0f;
+		for (uint32_t i = 0; i < STATIC_ARRAY_SIZE(directions); i++)
+		{
+			const Float3 direction = directions[i].Normalize();
+			const Float3 reference = IntegrateIrradiance(pixels, width, height, direction);
+			const Float3 approximation = Evaluate(irradiance, direction);
+
+			const float error = (approximation - reference).Length() / MAX(reference.Length(), 0.0001f);
+			maxError = MAX(maxError, error);
+		}
+		return maxError;
+	}
+
+	SH9ColorRenderData ToRenderData(const SH9Color& sh)
+	{
+		SH9ColorRenderData renderData{};
+		for (uint32_t i = 0; i < NUM_COEFFICIENTS; i++)
+		{
+			const Float3& c = sh.Coefficients[i];
+			renderData.Coefficients[i] = DirectX::XMFLOAT4{ c.x, c.y, c.z, 0.0f };
+		}
+		return renderData;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Engine/Common.h>
+
+// 3rd order (9 coefficients) spherical harmonics for the diffuse IBL
+namespace SphericalHarmonics
+{
+	static constexpr uint32_t NUM_COEFFICIENTS = 9;
+
+	struct SH9Color
+	{
+		Float3 Coefficients[NUM_COEFFICIENTS];
+	};
+
+	// Layout of the SH in the constant buffer, must match lighting.h
+	struct SH9ColorRenderData
+	{
+		DirectX::XMFLOAT4 Coefficients[NUM_COEFFICIENTS];
+	};
+
+	// Projects equirectangular panorama (RGBA float) to SH
+	SH9Color ProjectPanorama(const float* pixels, uint32_t width, uint32_t height);
+
+	// Convolves radiance SH with the cosine lobe
+	// Result is irradiance divided by PI so it can be multiplied directly with the albedo
+	SH9Color ConvolveIrradiance(const SH9Color& radiance);
+
+	Float3 Evaluate(const SH9Color& sh, const Float3& direction);
+
+	// Brute force cosine weighted integration over all pixels of the panorama, used for the validation
+	Float3 IntegrateIrradiance(const float* pixels, uint32_t width, uint32_t height, const Float3& normal);
+
+	// Compares SH irradiance against brute force integration and returns max relative error
+	float ValidateIrradiance(const SH9Color& irradiance, const float* pixels, uint32_t width, uint32_t height);
+
+	SH9ColorRenderData ToRenderData(const SH9Color& sh);
+
+	// Direction convention of the panorama, IBLBaker samples it with the inverse mapping
+	Float3 PanoramaTexelToDirection(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+}
\ No newline at end of file
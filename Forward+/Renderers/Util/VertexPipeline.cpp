@@ -7,6 +7,7 @@
 
 #include "Globals.h"
 #include "Renderers/Util/ConstantBuffer.h"
+#include "Renderers/Util/ShaderDeclarations.h"
 #include "Scene/SceneGraph.h"
 #include "Shaders/shared_definitions.h"
 
@@ -28,7 +29,8 @@ void VertexPipeline::Init(GraphicsContext& context)
 {
 	m_IndirectArgumentsBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(INDIRECT_ARGUMENTS_STRIDE, INDIRECT_ARGUMENTS_STRIDE, RCF::UAV));
 	m_IndirectArgumentsCountBuffer = ScopedRef<Buffer>(GFX::CreateBuffer(sizeof(uint32_t), sizeof(uint32_t), RCF::UAV));
-	m_PrepareArgsShader = ScopedRef<Shader>(new Shader{ "Forward+/Shaders/geometry_culling.hlsl" });
+	m_PrepareArgsShader = ScopedRef<Shader>(new Shader{ ShaderDeclarations::Get("Forward+/Shaders/geometry_culling.hlsl") });
+	GFX::WarmUpShader(m_PrepareArgsShader.get());
 }
 
 void VertexPipeline::Draw(GraphicsContext& context, GraphicsState& state, RenderGroup& rg, RenderGroupCullingData& cullingData)
@@ -91,12 +93,9 @@ void VertexPipeline::Draw_GPU(GraphicsContext& context, GraphicsState& state, Re
 		prepareState.Table.UAVs[1] = m_IndirectArgumentsCountBuffer.get();
 		prepareState.Table.CBVs[0] = cb.GetBuffer(context);
 
-		std::vector<std::string> config{};
-		config.push_back("PREPARE_ARGUMENTS");
-		
 		prepareState.Shader = m_PrepareArgsShader.get();
 		prepareState.ShaderStages = CS;
-		prepareState.ShaderConfig = config;
+		prepareState.ShaderConfig = m_PrepareArgsShader->Permutations.GetKey({ "PREPARE_ARGUMENTS" });
 		context.ApplyState(prepareState);
 		GFX::Cmd::Dispatch(context, MathUtility::CeilDiv(rg.Drawables.GetSize(), (uint32_t)OPT_COMP_TG_SIZE), 1, 1);
 	}
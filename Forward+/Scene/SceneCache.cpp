@@ -0,0 +1,891 @@
+#include "SceneCache.h"
+
+#pragma warning (disable : 4996)
+#include <cgltf.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <limits>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+#include <Engine/Loading/AccessorDecoding.h>
+#include <Engine/Loading/AssetArchive.h>
+#include <Engine/Loading/BCEncoding.h>
+#include <Engine/Loading/ImageDecoding.h>
+#include <Engine/Loading/MipGeneration.h>
+#include <Engine/Loading/MappedGLTF.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Engine/Utility/Hash.h>
+#include <Engine/Utility/Multithreading.h>
+#include <Engine/Utility/PathUtility.h>
+
+namespace SceneCache
+{
+	namespace
+	{
+		constexpr uint32_t CACHE_MAGIC = 0x434E4353; // SCNC
+		constexpr uint32_t CACHE_VERSION = 5;
+
+		// Sections start on a page so the mapped data is aligned for every type
+		constexpr uint64_t SECTION_ALIGNMENT = 4096;
+
+		enum class Section : uint32_t
+		{
+			RenderGroups,
+			Meshes,
+			Materials,
+			Textures,
+			Objects,
+			Vertices,
+			Indices,
+			TexturePixels,
+			Count
+		};
+
+		struct SectionRange
+		{
+			uint64_t Offset;
+			uint64_t Size;
+		};
+
+		struct CacheHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t SourceHash;
+			SectionRange Sections[(uint32_t) Section::Count];
+		};
+
+		// Image file, image embedded in a buffer view or the color of 1x1 texture if the material doesn't have the texture
+		struct TextureSource
+		{
+			std::string Path;
+			const uint8_t* Data = nullptr;
+			size_t DataSize = 0;
+			uint8_t DefaultColor[4] = {};
+			uint64_t PathHash = 0;
+			BCEncoding::Format Format = BCEncoding::Format::RGBA8;
+			MipGeneration::Settings Mips = {};
+		};
+
+		// Format and mip filtering depend on what the material uses the texture for
+		struct TextureUsage
+		{
+			BCEncoding::Format Format;
+			MipGeneration::Settings Mips;
+		};
+
+		// Albedo is sRGB and keeps the alpha of the blended and alpha tested materials
+		// Metallic, roughness and normal are linear, shading reads metallic and roughness from red and green and reconstructs Z of the normal from X and Y
+		// Two channel textures are BC5, the channels don't share the endpoints like in BC1 and keep 8 bits each
+		constexpr TextureUsage ALBEDO_USAGE = { BCEncoding::Format::BC7, { MipGeneration::FilterKernel::Kaiser, true, true } };
+		constexpr TextureUsage METALLIC_ROUGHNESS_USAGE = { BCEncoding::Format::BC5, { MipGeneration::FilterKernel::Kaiser, false, false } };
+		constexpr TextureUsage NORMAL_USAGE = { BCEncoding::Format::BC5, { MipGeneration::FilterKernel::Kaiser, false, false } };
+
+		struct BuildContext
+		{
+			BuildContext(const std::string& relativePath, SceneData& scene, uint32_t numThreads) :
+				RelativePath(relativePath),
+				Scene(scene),
+				NumThreads(numThreads)
+			{}
+
+			std::string RelativePath;
+			SceneData& Scene;
+
+			// 0 uses a thread per core
+			uint32_t NumThreads;
+
+			std::unordered_map<const cgltf_primitive*, uint32_t> Meshes;
+			std::unordered_map<const cgltf_material*, uint32_t> Materials;
+			std::map<std::pair<const cgltf_image*, const TextureUsage*>, uint32_t> ImageTextures;
+			std::unordered_map<uint32_t, uint32_t> ColorTextures;
+			std::vector<TextureSource> TextureSources;
+
+			// Primitives are only counted while the nodes are added, they are read once the meshes have their offsets
+			std::vector<const cgltf_primitive*> MeshSources;
+		};
+
+		uint32_t GetRenderGroup(const cgltf_material* materialData)
+		{
+			// Transparent, AlphaDiscard, Opaque
+			if (materialData->alpha_mode == cgltf_alpha_mode_blend) return 2;
+			if (materialData->alpha_mode == cgltf_alpha_mode_mask) return 1;
+			return 0;
+		}
+
+		TextureSource GetImageSource(const BuildContext& context, const cgltf_image* image)
+		{
+			TextureSource source{};
+			source.Data = MappedGLTF::GetImageData(image, source.DataSize);
+			if (!source.Data)
+			{
+				std::string uri = image->uri ? image->uri : "";
+				uri.resize(cgltf_decode_uri(uri.data()));
+				source.Path = context.RelativePath + uri;
+				source.PathHash = Hash::XXHash64(PathUtility::NormalizePath(source.Path));
+			}
+			return source;
+		}
+
+		// Image used for different purposes is a texture for each usage, default colors are 1x1 and stay RGBA8
+		uint32_t AddTexture(BuildContext& context, const cgltf_texture* texture, const TextureUsage& usage, const uint8_t (&defaultColor)[4])
+		{
+			if (texture && texture->image)
+			{
+				const auto key = std::make_pair(texture->image, &usage);
+				const auto it = context.ImageTextures.find(key);
+				if (it != context.ImageTextures.end()) return it->second;
+
+				const uint32_t textureIndex = (uint32_t) context.TextureSources.size();
+				context.TextureSources.push_back(GetImageSource(context, texture->image));
+				context.TextureSources.back().Format = usage.Format;
+				context.TextureSources.back().Mips = usage.Mips;
+				context.ImageTextures[key] = textureIndex;
+				return textureIndex;
+			}
+
+			uint32_t colorKey;
+			memcpy(&colorKey, defaultColor, sizeof(colorKey));
+			const auto it = context.ColorTextures.find(colorKey);
+			if (it != context.ColorTextures.end()) return it->second;
+
+			const uint32_t textureIndex = (uint32_t) context.TextureSources.size();
+			TextureSource source{};
+			memcpy(source.DefaultColor, defaultColor, sizeof(source.DefaultColor));
+			context.TextureSources.push_back(source);
+			context.ColorTextures[colorKey] = textureIndex;
+			return textureIndex;
+		}
+
+		bool AddMaterial(BuildContext& context, const cgltf_material* materialData, uint32_t& materialIndex)
+		{
+			const auto it = context.Materials.find(materialData);
+			if (it != context.Materials.end())
+			{
+				materialIndex = it->second;
+				return true;
+			}
+
+			if (!materialData || !materialData->has_pbr_metallic_roughness)
+			{
+				std::cout << "Warning: [SceneCache] Every primitive must have a metallic roughness material" << std::endl;
+				return false;
+			}
+
+			// Same as ColorUNORM(1, 1, 1, 1) and ColorUNORM(0.5, 0.5, 1, 1)
+			static constexpr uint8_t WHITE[4] = { 255, 255, 255, 255 };
+			static constexpr uint8_t FLAT_NORMAL[4] = { 127, 127, 255, 255 };
+
+			const cgltf_pbr_metallic_roughness& mat = materialData->pbr_metallic_roughness;
+
+			MaterialData material{};
+			material.RenderGroup = GetRenderGroup(materialData);
+			material.UseBlend = materialData->alpha_mode == cgltf_alpha_mode_blend;
+			material.UseAlphaDiscard = materialData->alpha_mode == cgltf_alpha_mode_mask;
+			memcpy(material.AlbedoFactor, mat.base_color_factor, sizeof(material.AlbedoFactor));
+			material.MetallicFactor = mat.metallic_factor;
+			material.RoughnessFactor = mat.roughness_factor;
+			material.Albedo = AddTexture(context, mat.base_color_texture.texture, ALBEDO_USAGE, WHITE);
+			material.MetallicRoughness = AddTexture(context, mat.metallic_roughness_texture.texture, METALLIC_ROUGHNESS_USAGE, WHITE);
+			material.Normal = AddTexture(context, materialData->normal_texture.texture, NORMAL_USAGE, FLAT_NORMAL);
+
+			materialIndex = (uint32_t) context.Scene.Materials.size();
+			context.Scene.Materials.push_back(material);
+			context.Materials[materialData] = materialIndex;
+			return true;
+		}
+
+		// Attributes the renderer uses, only the format is checked before the data is read
+		const cgltf_accessor* GetAttribute(const cgltf_primitive* meshData, cgltf_attribute_type type)
+		{
+			for (size_t i = 0; i < meshData->attributes_count; i++)
+			{
+				const cgltf_attribute& attribute = meshData->attributes[i];
+				if (attribute.type == type && attribute.index == 0) return attribute.data;
+			}
+			return nullptr;
+		}
+
+		bool IsValidAttribute(const cgltf_accessor* accessor, cgltf_type type, size_t vertexCount)
+		{
+			return !accessor || (accessor->type == type && accessor->count == vertexCount);
+		}
+
+		// Decodes from the mapped buffer straight into the vertices, components of any type and stride are converted to floats
+		template<size_t N>
+		bool ReadAttribute(const cgltf_accessor* accessor, std::span<Vertex> vertices, float (Vertex::*member)[N])
+		{
+			return !accessor || vertices.empty() || AccessorDecoding::ReadFloats(accessor, vertices[0].*member, sizeof(Vertex), N);
+		}
+
+		// Counting pass, the mesh gets its vertex and index counts and the data is read later
+		bool AddMesh(BuildContext& context, const cgltf_primitive* meshData, uint32_t renderGroup, uint32_t& meshIndex)
+		{
+			const auto it = context.Meshes.find(meshData);
+			if (it != context.Meshes.end())
+			{
+				meshIndex = it->second;
+				return true;
+			}
+
+			if (meshData->type != cgltf_primitive_type_triangles || meshData->attributes_count == 0)
+			{
+				std::cout << "Warning: [SceneCache] Scene contains non triangle meshes, we are supporting just triangle meshes" << std::endl;
+				return false;
+			}
+
+			// TODO: calculate missing attributes
+			const cgltf_accessor* positions = GetAttribute(meshData, cgltf_attribute_type_position);
+			if (!positions || !GetAttribute(meshData, cgltf_attribute_type_texcoord) || !GetAttribute(meshData, cgltf_attribute_type_normal))
+			{
+				std::cout << "Warning: [SceneCache] Missing vertex data" << std::endl;
+				return false;
+			}
+
+			const size_t vertexCount = positions->count;
+			if (!IsValidAttribute(positions, cgltf_type_vec3, vertexCount) ||
+				!IsValidAttribute(GetAttribute(meshData, cgltf_attribute_type_normal), cgltf_type_vec3, vertexCount) ||
+				!IsValidAttribute(GetAttribute(meshData, cgltf_attribute_type_tangent), cgltf_type_vec4, vertexCount) ||
+				!IsValidAttribute(GetAttribute(meshData, cgltf_attribute_type_texcoord), cgltf_type_vec2, vertexCount))
+			{
+				std::cout << "Warning: [SceneCache] Unexpected format of vertex attributes" << std::endl;
+				return false;
+			}
+
+			MeshData mesh{};
+			mesh.RenderGroup = renderGroup;
+			mesh.VertexCount = (uint32_t) vertexCount;
+			mesh.IndexCount = (uint32_t) (meshData->indices ? meshData->indices->count : vertexCount);
+
+			meshIndex = (uint32_t) context.Scene.Meshes.size();
+			context.Scene.Meshes.push_back(mesh);
+			context.MeshSources.push_back(meshData);
+			context.Meshes[meshData] = meshIndex;
+			return true;
+		}
+
+		// Tangents are zero if the mesh doesn't have them
+		bool ReadMesh(const cgltf_primitive* meshData, std::span<Vertex> vertices, std::span<uint32_t> indices)
+		{
+			if (!ReadAttribute(GetAttribute(meshData, cgltf_attribute_type_position), vertices, &Vertex::Position) ||
+				!ReadAttribute(GetAttribute(meshData, cgltf_attribute_type_normal), vertices, &Vertex::Normal) ||
+				!ReadAttribute(GetAttribute(meshData, cgltf_attribute_type_tangent), vertices, &Vertex::Tangent) ||
+				!ReadAttribute(GetAttribute(meshData, cgltf_attribute_type_texcoord), vertices, &Vertex::Texcoord))
+			{
+				std::cout << "Warning: [SceneCache] Failed to read vertex attributes" << std::endl;
+				return false;
+			}
+
+			if (!meshData->indices)
+			{
+				for (size_t i = 0; i < indices.size(); i++) indices[i] = (uint32_t) i;
+			}
+			else if (!indices.empty() && !AccessorDecoding::ReadIndices(meshData->indices, indices.data()))
+			{
+				std::cout << "Warning: [SceneCache] Failed to read indices" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		// Sphere around the AABB
+		std::array<float, 4> CalculateBounds(std::span<const Vertex> vertices)
+		{
+			float minAABB[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			float maxAABB[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+			for (const Vertex& vertex : vertices)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					minAABB[c] = std::min(minAABB[c], vertex.Position[c]);
+					maxAABB[c] = std::max(maxAABB[c], vertex.Position[c]);
+				}
+			}
+
+			std::array<float, 4> bounds{};
+			float extentSq = 0.0f;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				bounds[c] = 0.5f * (maxAABB[c] + minAABB[c]);
+				extentSq += (maxAABB[c] - minAABB[c]) * (maxAABB[c] - minAABB[c]);
+			}
+			bounds[3] = std::sqrt(extentSq) * 0.5f;
+			return bounds;
+		}
+
+		void Multiply(const float (&a)[16], const float (&b)[16], float (&result)[16])
+		{
+			for (uint32_t row = 0; row < 4; row++)
+			{
+				for (uint32_t col = 0; col < 4; col++)
+				{
+					float value = 0.0f;
+					for (uint32_t k = 0; k < 4; k++) value += a[row * 4 + k] * b[k * 4 + col];
+					result[row * 4 + col] = value;
+				}
+			}
+		}
+
+		// Same as XMMatrixAffineTransformation with zero rotation origin, row vectors
+		void GetNodeTransform(const cgltf_node* node, float (&transform)[16])
+		{
+			// Column major matrix of glTF has the same memory layout as row major matrix for row vectors
+			if (node->has_matrix)
+			{
+				memcpy(transform, node->matrix, sizeof(transform));
+				return;
+			}
+
+			const float translation[3] = { node->has_translation ? node->translation[0] : 0.0f, node->has_translation ? node->translation[1] : 0.0f, node->has_translation ? node->translation[2] : 0.0f };
+			const float scale[3] = { node->has_scale ? node->scale[0] : 1.0f, node->has_scale ? node->scale[1] : 1.0f, node->has_scale ? node->scale[2] : 1.0f };
+			const float x = node->has_rotation ? node->rotation[0] : 0.0f;
+			const float y = node->has_rotation ? node->rotation[1] : 0.0f;
+			const float z = node->has_rotation ? node->rotation[2] : 0.0f;
+			const float w = node->has_rotation ? node->rotation[3] : 1.0f;
+
+			const float rotation[12] =
+			{
+				1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w),
+				2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w),
+				2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y),
+			};
+
+			for (uint32_t row = 0; row < 3; row++)
+			{
+				for (uint32_t col = 0; col < 3; col++) transform[row * 4 + col] = scale[row] * rotation[row * 3 + col];
+				transform[row * 4 + 3] = 0.0f;
+			}
+			transform[12] = translation[0];
+			transform[13] = translation[1];
+			transform[14] = translation[2];
+			transform[15] = 1.0f;
+		}
+
+		void CalcBaseTransform(const cgltf_node* nodeData, float (&transform)[16])
+		{
+			std::vector<const cgltf_node*> hierarchy;
+			for (const cgltf_node* node = nodeData; node; node = node->parent) hierarchy.push_back(node);
+
+			static constexpr float IDENTITY[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			memcpy(transform, IDENTITY, sizeof(transform));
+			for (int32_t i = (int32_t) hierarchy.size() - 1; i >= 0; i--)
+			{
+				float nodeTransform[16];
+				GetNodeTransform(hierarchy[i], nodeTransform);
+
+				// Row vectors, transform of the node is applied before the one of its parent
+				float parentTransform[16];
+				memcpy(parentTransform, transform, sizeof(transform));
+				Multiply(nodeTransform, parentTransform, transform);
+			}
+		}
+
+		bool AddNode(BuildContext& context, const cgltf_node* nodeData)
+		{
+			if (!nodeData->mesh) return true;
+
+			ObjectData object{};
+			CalcBaseTransform(nodeData, object.Transform);
+
+			for (size_t i = 0; i < nodeData->mesh->primitives_count; i++)
+			{
+				const cgltf_primitive* primitive = nodeData->mesh->primitives + i;
+				if (!AddMaterial(context, primitive->material, object.Material)) return false;
+				if (!AddMesh(context, primitive, context.Scene.Materials[object.Material].RenderGroup, object.Mesh)) return false;
+
+				// Bounds are set once the mesh is read
+				context.Scene.Objects.push_back(object);
+			}
+			return true;
+		}
+
+		uint32_t GetNumThreads(const BuildContext& context, uint32_t numItems)
+		{
+			return context.NumThreads == 0 ? MTR::GetNumWorkerThreads(numItems) : std::min(context.NumThreads, std::max(numItems, 1u));
+		}
+
+		// Items ordered from the largest cost, equal costs keep their order
+		std::vector<uint32_t> GetLargestFirstOrder(const std::vector<uint64_t>& costs)
+		{
+			std::vector<uint32_t> order(costs.size());
+			for (uint32_t i = 0; i < (uint32_t) order.size(); i++) order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&costs](uint32_t a, uint32_t b) { return costs[a] > costs[b]; });
+			return order;
+		}
+
+		// Vertices and indices are allocated once for all meshes, every mesh is read into its place by a worker
+		// Sizes of the meshes vary a lot so the workers take the largest meshes first instead of splitting them into equal ranges
+		bool ReadMeshes(BuildContext& context)
+		{
+			SceneData& scene = context.Scene;
+			if (!AssignMeshOffsets(scene.Meshes, scene.RenderGroups))
+			{
+				std::cout << "Warning: [SceneCache] Scene has too many vertices or indices" << std::endl;
+				return false;
+			}
+
+			const RenderGroupData& lastGroup = scene.RenderGroups[RENDER_GROUP_COUNT - 1];
+			scene.Vertices.resize((size_t) lastGroup.FirstVertex + lastGroup.NumVertices);
+			scene.Indices.resize((size_t) lastGroup.FirstIndex + lastGroup.NumIndices);
+
+			const uint32_t numMeshes = (uint32_t) scene.Meshes.size();
+			std::vector<uint64_t> costs(numMeshes);
+			for (uint32_t i = 0; i < numMeshes; i++) costs[i] = (uint64_t) scene.Meshes[i].VertexCount + scene.Meshes[i].IndexCount;
+
+			std::vector<std::array<float, 4>> bounds(numMeshes);
+			std::atomic<bool> valid = true;
+			MTR::ParallelForEach(GetLargestFirstOrder(costs), GetNumThreads(context, numMeshes), [&context, &scene, &bounds, &valid](uint32_t i, uint32_t)
+			{
+				const MeshData& mesh = scene.Meshes[i];
+				const std::span<Vertex> vertices{ scene.Vertices.data() + mesh.VertexOffset, mesh.VertexCount };
+				const std::span<uint32_t> indices{ scene.Indices.data() + mesh.IndexOffset, mesh.IndexCount };
+
+				if (!ReadMesh(context.MeshSources[i], vertices, indices)) valid = false;
+				bounds[i] = CalculateBounds(vertices);
+			});
+
+			for (ObjectData& object : scene.Objects)
+			{
+				memcpy(object.BoundsCenter, bounds[object.Mesh].data(), sizeof(object.BoundsCenter));
+				object.BoundsRadius = bounds[object.Mesh][3];
+			}
+			return valid;
+		}
+
+		// Mips are encoded one after another and the encoder splits each of them between the threads
+		// Block compressed textures have to be a multiple of 4, the other ones stay RGBA8
+		void CompressTextures(BuildContext& context, std::vector<std::vector<uint8_t>>& texturePixels)
+		{
+			SceneData& scene = context.Scene;
+			for (uint32_t i = 0; i < (uint32_t) scene.Textures.size(); i++)
+			{
+				const BCEncoding::Format format = context.TextureSources[i].Format;
+				TextureData& texture = scene.Textures[i];
+				if (format == BCEncoding::Format::RGBA8 || texture.Width % BCEncoding::BLOCK_WIDTH != 0 || texture.Height % BCEncoding::BLOCK_WIDTH != 0) continue;
+
+				TextureData compressed = texture;
+				compressed.Format = (uint32_t) format;
+
+				std::vector<uint8_t> blocks(GetMipOffset(compressed, compressed.NumMips));
+				for (uint32_t mip = 0; mip < texture.NumMips; mip++)
+				{
+					const uint32_t width = GetMipWidth(texture, mip);
+					const uint32_t height = GetMipHeight(texture, mip);
+					const uint32_t numBlockRows = (height + BCEncoding::BLOCK_WIDTH - 1) / BCEncoding::BLOCK_WIDTH;
+					BCEncoding::Encode(format, texturePixels[i].data() + GetMipOffset(texture, mip), width, height, blocks.data() + GetMipOffset(compressed, mip), GetNumThreads(context, numBlockRows));
+				}
+
+				texture = compressed;
+				texturePixels[i] = std::move(blocks);
+			}
+		}
+
+		// Decoding is the slow part of the build, images are decoded in parallel and appended in order
+		// Encoded size is the cost estimate, the largest images are decoded first
+		void DecodeTextures(BuildContext& context)
+		{
+			SceneData& scene = context.Scene;
+			const uint32_t numTextures = (uint32_t) context.TextureSources.size();
+
+			std::vector<uint64_t> costs(numTextures);
+			for (uint32_t i = 0; i < numTextures; i++)
+			{
+				const TextureSource& source = context.TextureSources[i];
+				std::error_code error;
+				costs[i] = source.Data ? source.DataSize : source.Path.empty() ? 0 : std::filesystem::file_size(source.Path, error);
+				if (error) costs[i] = 0;
+			}
+
+			scene.Textures.assign(numTextures, TextureData{});
+			std::vector<std::vector<uint8_t>> texturePixels(numTextures);
+			MTR::ParallelForEach(GetLargestFirstOrder(costs), GetNumThreads(context, numTextures), [&context, &scene, &texturePixels](uint32_t i, uint32_t)
+			{
+				const TextureSource& source = context.TextureSources[i];
+				TextureData& texture = scene.Textures[i];
+				std::vector<uint8_t>& pixels = texturePixels[i];
+
+				if (source.Path.empty() && !source.Data)
+				{
+					texture.Width = 1;
+					texture.Height = 1;
+					pixels.assign(source.DefaultColor, source.DefaultColor + 4);
+				}
+				else
+				{
+					TextureLoading::ImageData image = source.Data ? TextureLoading::LoadImageLDR(source.Data, source.DataSize) : TextureLoading::LoadImageLDR(source.Path);
+					texture.Width = image.Width;
+					texture.Height = image.Height;
+					pixels = std::move(image.Pixels);
+				}
+
+				// Same mip count as TextureLoading::LoadTexture
+				const uint32_t maxWH = std::max(texture.Width, texture.Height);
+				texture.NumMips = NUM_TEXTURE_MIPS;
+				while (maxWH >> (texture.NumMips - 1) == 0) texture.NumMips--;
+
+				MipGeneration::Generate(source.Mips, texture.Width, texture.Height, texture.NumMips, pixels);
+			});
+
+			CompressTextures(context, texturePixels);
+
+			for (uint32_t i = 0; i < numTextures; i++)
+			{
+				TextureData& texture = scene.Textures[i];
+				const std::vector<uint8_t>& pixels = texturePixels[i];
+				const uint32_t description[3] = { texture.Width, texture.Height, texture.Format };
+				const uint64_t pathHash = context.TextureSources[i].PathHash;
+
+				texture.PixelOffset = scene.TexturePixels.size();
+				texture.PixelSize = pixels.size();
+				texture.PathHash = pathHash ? Hash::XXHash64(pathHash, texture.Format) : 0;
+				texture.ContentHash = Hash::XXHash64(pixels.data(), pixels.size(), Hash::XXHash64(reinterpret_cast<const uint8_t*>(description), sizeof(description)));
+
+				scene.TexturePixels.insert(scene.TexturePixels.end(), pixels.begin(), pixels.end());
+				std::vector<uint8_t>().swap(texturePixels[i]);
+			}
+		}
+
+		// Files in the mounted asset archives are identified by their content hash instead, the loose file may not exist
+		void AddFileStamp(Hash::XXHash64Stream& hash, const std::string& path)
+		{
+			AssetArchive::FileInfo archivedFile;
+			if (AssetArchive::FindMountedFile(path, archivedFile))
+			{
+				hash.Add(reinterpret_cast<const uint8_t*>(&archivedFile.Size), sizeof(archivedFile.Size));
+				hash.Add(reinterpret_cast<const uint8_t*>(&archivedFile.ContentHash), sizeof(archivedFile.ContentHash));
+				return;
+			}
+
+			std::error_code error;
+			const uint64_t fileSize = std::filesystem::file_size(path, error);
+			const uint64_t writeTime = error ? 0 : (uint64_t) std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+			hash.Add(reinterpret_cast<const uint8_t*>(&fileSize), sizeof(fileSize));
+			hash.Add(reinterpret_cast<const uint8_t*>(&writeTime), sizeof(writeTime));
+		}
+
+		void AddFileStamp(Hash::XXHash64Stream& hash, const std::string& relativePath, const char* uri)
+		{
+			// Embedded data is part of the glTF file
+			if (!uri || strncmp(uri, "data:", 5) == 0) return;
+
+			std::string decodedURI = uri;
+			decodedURI.resize(cgltf_decode_uri(decodedURI.data()));
+			AddFileStamp(hash, relativePath + decodedURI);
+		}
+
+		uint64_t AlignSection(uint64_t offset)
+		{
+			return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+		}
+
+		template<typename T>
+		std::span<const uint8_t> AsBytes(std::span<const T> values)
+		{
+			return { reinterpret_cast<const uint8_t*>(values.data()), values.size_bytes() };
+		}
+
+		template<typename T>
+		bool GetSection(const FileUtility::MappedFile& file, const CacheHeader& header, Section section, std::span<const T>& values)
+		{
+			const SectionRange& range = header.Sections[(uint32_t) section];
+			if (range.Offset % SECTION_ALIGNMENT != 0 || range.Offset > file.GetSize() || range.Size > file.GetSize() - range.Offset || range.Size % sizeof(T) != 0) return false;
+
+			values = { reinterpret_cast<const T*>(file.GetData() + range.Offset), (size_t) (range.Size / sizeof(T)) };
+			return true;
+		}
+
+		// References between the sections, the renderer trusts them after the load
+		bool Validate(const SceneView& scene)
+		{
+			if (scene.RenderGroups.size() != RENDER_GROUP_COUNT) return false;
+
+			for (const RenderGroupData& rg : scene.RenderGroups)
+			{
+				if (rg.FirstVertex > scene.Vertices.size() || rg.NumVertices > scene.Vertices.size() - rg.FirstVertex) return false;
+				if (rg.FirstIndex > scene.Indices.size() || rg.NumIndices > scene.Indices.size() - rg.FirstIndex) return false;
+			}
+
+			for (const MeshData& mesh : scene.Meshes)
+			{
+				if (mesh.RenderGroup >= RENDER_GROUP_COUNT) return false;
+
+				const RenderGroupData& rg = scene.RenderGroups[mesh.RenderGroup];
+				if (mesh.VertexOffset < rg.FirstVertex || mesh.VertexOffset - rg.FirstVertex > rg.NumVertices || mesh.VertexCount > rg.NumVertices - (mesh.VertexOffset - rg.FirstVertex)) return false;
+				if (mesh.IndexOffset < rg.FirstIndex || mesh.IndexOffset - rg.FirstIndex > rg.NumIndices || mesh.IndexCount > rg.NumIndices - (mesh.IndexOffset - rg.FirstIndex)) return false;
+			}
+
+			for (const TextureData& texture : scene.Textures)
+			{
+				if (texture.Width == 0 || texture.Height == 0 || texture.NumMips == 0 || texture.NumMips > NUM_TEXTURE_MIPS) return false;
+				if (texture.Format > (uint32_t) BCEncoding::Format::BC7) return false;
+				if (BCEncoding::GetBlockSize((BCEncoding::Format) texture.Format) && (texture.Width % BCEncoding::BLOCK_WIDTH || texture.Height % BCEncoding::BLOCK_WIDTH)) return false;
+				if (texture.PixelSize != GetMipOffset(texture, texture.NumMips)) return false;
+				if (texture.PixelOffset > scene.TexturePixels.size() || texture.PixelSize > scene.TexturePixels.size() - texture.PixelOffset) return false;
+			}
+
+			const size_t numTextures = scene.Textures.size();
+			for (const MaterialData& material : scene.Materials)
+			{
+				if (material.RenderGroup >= RENDER_GROUP_COUNT) return false;
+				if (material.Albedo >= numTextures || material.MetallicRoughness >= numTextures || material.Normal >= numTextures) return false;
+			}
+
+			for (const ObjectData& object : scene.Objects)
+			{
+				if (object.Mesh >= scene.Meshes.size() || object.Material >= scene.Materials.size()) return false;
+				if (scene.Meshes[object.Mesh].RenderGroup != scene.Materials[object.Material].RenderGroup) return false;
+			}
+
+			return true;
+		}
+	}
+
+	SceneView SceneData::GetView() const
+	{
+		SceneView view;
+		view.RenderGroups = RenderGroups;
+		view.Meshes = Meshes;
+		view.Materials = Materials;
+		view.Textures = Textures;
+		view.Objects = Objects;
+		view.Vertices = Vertices;
+		view.Indices = Indices;
+		view.TexturePixels = TexturePixels;
+		return view;
+	}
+
+	uint32_t GetMipWidth(const TextureData& texture, uint32_t mip)
+	{
+		return std::max(texture.Width >> mip, 1u);
+	}
+
+	uint32_t GetMipHeight(const TextureData& texture, uint32_t mip)
+	{
+		return std::max(texture.Height >> mip, 1u);
+	}
+
+	uint64_t GetMipOffset(const TextureData& texture, uint32_t mip)
+	{
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < mip; i++) offset += BCEncoding::GetImageSize((BCEncoding::Format) texture.Format, GetMipWidth(texture, i), GetMipHeight(texture, i));
+		return offset;
+	}
+
+	bool AssignMeshOffsets(std::span<MeshData> meshes, std::vector<RenderGroupData>& renderGroups)
+	{
+		uint64_t numVertices[RENDER_GROUP_COUNT] = {};
+		uint64_t numIndices[RENDER_GROUP_COUNT] = {};
+		for (const MeshData& mesh : meshes)
+		{
+			if (mesh.RenderGroup >= RENDER_GROUP_COUNT) return false;
+			numVertices[mesh.RenderGroup] += mesh.VertexCount;
+			numIndices[mesh.RenderGroup] += mesh.IndexCount;
+		}
+
+		// Offsets are 32 bit in the mesh storage
+		renderGroups.assign(RENDER_GROUP_COUNT, RenderGroupData{});
+		uint64_t firstVertex = 0;
+		uint64_t firstIndex = 0;
+		for (uint32_t rg = 0; rg < RENDER_GROUP_COUNT; rg++)
+		{
+			if (firstVertex + numVertices[rg] > UINT32_MAX || firstIndex + numIndices[rg] > UINT32_MAX) return false;
+
+			renderGroups[rg].FirstVertex = (uint32_t) firstVertex;
+			renderGroups[rg].NumVertices = (uint32_t) numVertices[rg];
+			renderGroups[rg].FirstIndex = (uint32_t) firstIndex;
+			renderGroups[rg].NumIndices = (uint32_t) numIndices[rg];
+			firstVertex += numVertices[rg];
+			firstIndex += numIndices[rg];
+		}
+
+		uint32_t nextVertex[RENDER_GROUP_COUNT];
+		uint32_t nextIndex[RENDER_GROUP_COUNT];
+		for (uint32_t rg = 0; rg < RENDER_GROUP_COUNT; rg++)
+		{
+			nextVertex[rg] = renderGroups[rg].FirstVertex;
+			nextIndex[rg] = renderGroups[rg].FirstIndex;
+		}
+
+		for (MeshData& mesh : meshes)
+		{
+			mesh.VertexOffset = nextVertex[mesh.RenderGroup];
+			mesh.IndexOffset = nextIndex[mesh.RenderGroup];
+			nextVertex[mesh.RenderGroup] += mesh.VertexCount;
+			nextIndex[mesh.RenderGroup] += mesh.IndexCount;
+		}
+		return true;
+	}
+
+	bool Build(const std::string& path, SceneData& scene, uint32_t numThreads)
+	{
+		scene = SceneData{};
+
+		// Embedded images point into the mapping, it's kept until they are decoded
+		MappedGLTF gltf;
+		if (!gltf.Load(path))
+		{
+			std::cout << "Warning: [SceneCache] Failed to load scene: " << path << std::endl;
+			return false;
+		}
+
+		BuildContext context(PathUtility::GetPathWitoutFile(path), scene, numThreads);
+
+		const cgltf_data* data = gltf.GetData();
+		bool valid = true;
+		for (size_t i = 0; i < data->nodes_count && valid; i++)
+		{
+			valid = AddNode(context, data->nodes + i);
+		}
+
+		if (!valid)
+		{
+			scene = SceneData{};
+			return false;
+		}
+
+		if (!ReadMeshes(context))
+		{
+			scene = SceneData{};
+			return false;
+		}
+
+		DecodeTextures(context);
+		return true;
+	}
+
+	bool HashSourceFile(const std::string& path, uint64_t& sourceHash)
+	{
+		// Only the JSON is parsed, buffers and images are identified by their size and write time or by their hash in the asset archive
+		MappedGLTF gltf;
+		if (!gltf.Parse(path)) return false;
+
+		const cgltf_data* data = gltf.GetData();
+		Hash::XXHash64Stream hash;
+		hash.Add(reinterpret_cast<const uint8_t*>(data->json), data->json_size);
+
+		// Binary chunk of the GLB
+		if (data->bin) AddFileStamp(hash, path);
+
+		const std::string relativePath = PathUtility::GetPathWitoutFile(path);
+		for (size_t i = 0; i < data->buffers_count; i++) AddFileStamp(hash, relativePath, data->buffers[i].uri);
+		for (size_t i = 0; i < data->images_count; i++) AddFileStamp(hash, relativePath, data->images[i].uri);
+
+		sourceHash = hash.GetHash();
+		return true;
+	}
+
+	std::string GetCachePath(uint64_t sourceHash)
+	{
+		std::stringstream ss;
+		ss << "Cache/Scenes/" << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".scene";
+		return ss.str();
+	}
+
+	bool LoadCache(const std::string& cachePath, uint64_t sourceHash, FileUtility::MappedFile& file, SceneView& scene)
+	{
+		if (!file.Open(cachePath)) return false;
+
+		CacheHeader header{};
+		if (file.GetSize() >= sizeof(header)) memcpy(&header, file.GetData(), sizeof(header));
+		if (header.Magic != CACHE_MAGIC || header.Version != CACHE_VERSION || header.SourceHash != sourceHash)
+		{
+			file.Close();
+			return false;
+		}
+
+		SceneView cached;
+		const bool valid =
+			GetSection(file, header, Section::RenderGroups, cached.RenderGroups) &&
+			GetSection(file, header, Section::Meshes, cached.Meshes) &&
+			GetSection(file, header, Section::Materials, cached.Materials) &&
+			GetSection(file, header, Section::Textures, cached.Textures) &&
+			GetSection(file, header, Section::Objects, cached.Objects) &&
+			GetSection(file, header, Section::Vertices, cached.Vertices) &&
+			GetSection(file, header, Section::Indices, cached.Indices) &&
+			GetSection(file, header, Section::TexturePixels, cached.TexturePixels) &&
+			Validate(cached);
+
+		if (!valid)
+		{
+			std::cout << "Warning: Corrupted scene cache: " << cachePath << std::endl;
+			file.Close();
+			return false;
+		}
+
+		scene = cached;
+		return true;
+	}
+
+	void SaveCache(const std::string& cachePath, uint64_t sourceHash, const SceneView& scene)
+	{
+		const std::span<const uint8_t> sections[] =
+		{
+			AsBytes(scene.RenderGroups),
+			AsBytes(scene.Meshes),
+			AsBytes(scene.Materials),
+			AsBytes(scene.Textures),
+			AsBytes(scene.Objects),
+			AsBytes(scene.Vertices),
+			AsBytes(scene.Indices),
+			AsBytes(scene.TexturePixels),
+		};
+		static_assert(std::size(sections) == (size_t) Section::Count);
+
+		CacheHeader header{};
+		header.Magic = CACHE_MAGIC;
+		header.Version = CACHE_VERSION;
+		header.SourceHash = sourceHash;
+
+		uint64_t offset = sizeof(header);
+		for (uint32_t i = 0; i < (uint32_t) Section::Count; i++)
+		{
+			offset = AlignSection(offset);
+			header.Sections[i] = SectionRange{ offset, sections[i].size() };
+			offset += sections[i].size();
+		}
+
+		// Texture pixels can take hundreds of megabytes, the sections are written directly instead of going through BinaryWriter
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		static const std::vector<char> padding(SECTION_ALIGNMENT, 0);
+		uint64_t written = sizeof(header);
+		for (uint32_t i = 0; i < (uint32_t) Section::Count && file; i++)
+		{
+			file.write(padding.data(), header.Sections[i].Offset - written);
+			file.write(reinterpret_cast<const char*>(sections[i].data()), sections[i].size());
+			written = header.Sections[i].Offset + sections[i].size();
+		}
+
+		if (!file)
+		{
+			std::cout << "Warning: Failed to write scene cache: " << cachePath << std::endl;
+		}
+	}
+
+	bool IsEqual(const SceneView& a, const SceneView& b)
+	{
+		return std::ranges::equal(a.RenderGroups, b.RenderGroups) &&
+			std::ranges::equal(a.Meshes, b.Meshes) &&
+			std::ranges::equal(a.Materials, b.Materials) &&
+			std::ranges::equal(a.Textures, b.Textures) &&
+			std::ranges::equal(a.Objects, b.Objects) &&
+			std::ranges::equal(a.Vertices, b.Vertices) &&
+			std::ranges::equal(a.Indices, b.Indices) &&
+			std::ranges::equal(a.TexturePixels, b.TexturePixels);
+	}
+}
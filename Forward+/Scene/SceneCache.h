@@ -0,0 +1,162 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace FileUtility
+{
+	class MappedFile;
+}
+
+// glTF scene converted into the data the renderer uploads: packed vertices and indices, materials, objects and decoded texture mips
+// Cached on disk after the first load, the cache is memory mapped so the next load only copies its sections into upload memory
+// Doesn't depend on D3D12, the conversion and the cache can be compared on any platform
+namespace SceneCache
+{
+	// Index of RenderGroupType
+	constexpr uint32_t RENDER_GROUP_COUNT = 3;
+	constexpr uint32_t NUM_TEXTURE_MIPS = 6;
+
+	// Same layout as MeshStorage::Vertex
+	struct Vertex
+	{
+		float Position[3];
+		float Texcoord[2];
+		float Normal[3];
+		float Tangent[4];
+
+		bool operator==(const Vertex& other) const = default;
+	};
+
+	// Meshes of the render group are next to each other in the vertex and index data
+	struct RenderGroupData
+	{
+		uint32_t FirstVertex;
+		uint32_t NumVertices;
+		uint32_t FirstIndex;
+		uint32_t NumIndices;
+
+		bool operator==(const RenderGroupData& other) const = default;
+	};
+
+	// Indices are relative to the first vertex of the mesh
+	struct MeshData
+	{
+		uint32_t RenderGroup;
+		uint32_t VertexOffset;
+		uint32_t VertexCount;
+		uint32_t IndexOffset;
+		uint32_t IndexCount;
+
+		bool operator==(const MeshData& other) const = default;
+	};
+
+	struct MaterialData
+	{
+		uint32_t RenderGroup;
+		uint32_t UseBlend;
+		uint32_t UseAlphaDiscard;
+		float AlbedoFactor[3];
+		float MetallicFactor;
+		float RoughnessFactor;
+
+		// Indices of the textures
+		uint32_t Albedo;
+		uint32_t MetallicRoughness;
+		uint32_t Normal;
+
+		bool operator==(const MaterialData& other) const = default;
+	};
+
+	// Mips are stored from the largest with tightly packed rows of pixels, or rows of 4x4 blocks if the texture is block compressed
+	struct TextureData
+	{
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t NumMips;
+
+		// BCEncoding::Format, chosen by what the materials use the texture for
+		uint32_t Format;
+
+		uint64_t PixelOffset;
+		uint64_t PixelSize;
+
+		// Hash of the normalized image path and the format, 0 if the image isn't a file, and hash of the size, format and data of all mips
+		// Textures with the same hash are shared across scenes
+		uint64_t PathHash;
+		uint64_t ContentHash;
+
+		bool operator==(const TextureData& other) const = default;
+	};
+
+	struct ObjectData
+	{
+		uint32_t Mesh;
+		uint32_t Material;
+
+		// Row major, same as XMFLOAT4X4
+		float Transform[16];
+
+		float BoundsCenter[3];
+		float BoundsRadius;
+
+		bool operator==(const ObjectData& other) const = default;
+	};
+
+	// Points either to SceneData or to the mapped cache
+	struct SceneView
+	{
+		std::span<const RenderGroupData> RenderGroups;
+		std::span<const MeshData> Meshes;
+		std::span<const MaterialData> Materials;
+		std::span<const TextureData> Textures;
+		std::span<const ObjectData> Objects;
+		std::span<const Vertex> Vertices;
+		std::span<const uint32_t> Indices;
+		std::span<const uint8_t> TexturePixels;
+	};
+
+	struct SceneData
+	{
+		std::vector<RenderGroupData> RenderGroups;
+		std::vector<MeshData> Meshes;
+		std::vector<MaterialData> Materials;
+		std::vector<TextureData> Textures;
+		std::vector<ObjectData> Objects;
+		std::vector<Vertex> Vertices;
+		std::vector<uint32_t> Indices;
+		std::vector<uint8_t> TexturePixels;
+
+		SceneView GetView() const;
+	};
+
+	uint32_t GetMipWidth(const TextureData& texture, uint32_t mip);
+	uint32_t GetMipHeight(const TextureData& texture, uint32_t mip);
+
+	// Offset from the TextureData::PixelOffset
+	uint64_t GetMipOffset(const TextureData& texture, uint32_t mip);
+
+	// Places the meshes of each render group next to each other in the order of the meshes and fills the ranges of the render groups
+	// Vertex and index counts of the meshes have to be set, fails if a render group is invalid or the offsets don't fit into 32 bits
+	bool AssignMeshOffsets(std::span<MeshData> meshes, std::vector<RenderGroupData>& renderGroups);
+
+	// Parses the glTF or GLB, converts the meshes and decodes the textures, fails with a warning if the scene isn't supported
+	// Meshes are counted first so the vertices and indices are allocated once and every mesh is read in parallel into its place
+	// numThreads 0 uses a thread per core and 1 reads everything on the calling thread, the result is the same for any count
+	bool Build(const std::string& path, SceneData& scene, uint32_t numThreads = 0);
+
+	// Hash of the glTF JSON and the size and write time of the GLB and of the buffers and images it references
+	// Files in the mounted asset archives use their size and content hash instead
+	bool HashSourceFile(const std::string& path, uint64_t& sourceHash);
+	std::string GetCachePath(uint64_t sourceHash);
+
+	// Fails if the cache doesn't exist, if it was made with different version or source or if it's corrupted
+	// Scene points into the file, it's valid while the file is open
+	bool LoadCache(const std::string& cachePath, uint64_t sourceHash, FileUtility::MappedFile& file, SceneView& scene);
+	void SaveCache(const std::string& cachePath, uint64_t sourceHash, const SceneView& scene);
+
+	// Compares every element of the scenes
+	bool IsEqual(const SceneView& a, const SceneView& b);
+}
@@ -185,13 +185,13 @@ RenderGroup::RenderGroup():
 
 }
 
-void RenderGroup::Initialize(GraphicsContext& context)
+void RenderGroup::Initialize(GraphicsContext& context, const TextureStorage& textures)
 {
 	Materials.Initialize("ElementBuffer::Materials");
 	Meshes.Initialize("ElementBuffer::Meshes");
 	Drawables.Initialize("ElementBuffer::Drawables");
 	MeshData.Initialize();
-	TextureData.Initialize(context);
+	Textures = &textures;
 }
 
 uint32_t RenderGroup::AddMaterial(GraphicsContext& context, Material& material)
@@ -225,10 +225,11 @@ void RenderGroup::SetupPipelineInputs(GraphicsState& state)
 {
 	state.Table.SRVs[125] = Materials.GetBuffer();
 	state.Table.SRVs[126] = Drawables.GetBuffer();
-	state.BindlessTables[0] = TextureData.GetBindlessTable();
+	state.BindlessTables[0] = Textures->GetBindlessTable();
 }
 
-SceneGraph::SceneGraph():
+SceneGraph::SceneGraph(TextureStorage& textures):
+	Textures(textures),
 	Lights(MAX_LIGHTS)
 {
 
@@ -244,7 +245,7 @@ void SceneGraph::InitRenderData(GraphicsContext& context)
 	
 	for (uint32_t i = 0; i < EnumToInt(RenderGroupType::Count); i++)
 	{
-		RenderGroups[i].Initialize(context);
+		RenderGroups[i].Initialize(context, Textures);
 	}
 	Lights.Initialize("ElementBuffer::Lights");
 }
@@ -257,11 +258,11 @@ void SceneGraph::FrameUpdate(GraphicsContext& context)
 
 	Lights.SyncGPUBuffer(context);
 
+	Textures.Update(context);
+
 	// Render group date
 	for (uint32_t i = 0; i < EnumToInt(RenderGroupType::Count); i++)
 	{
-		RenderGroups[i].TextureData.Update(context);
-
 		RenderGroups[i].Materials.SyncGPUBuffer(context);
 		RenderGroups[i].Drawables.SyncGPUBuffer(context);
 		RenderGroups[i].Meshes.SyncGPUBuffer(context);
@@ -339,19 +340,37 @@ void MeshStorage::Initialize()
 	GFX::SetDebugName(m_IndexBuffer.get(), "MeshStorage::IndexBuffer");
 }
 
+void MeshStorage::Reserve(GraphicsContext& context, uint32_t vertexCount, uint32_t indexCount)
+{
+	std::lock_guard<std::mutex> lock(m_AllocationLock);
+
+	m_Vertices.Reserve(vertexCount);
+	m_Indices.Reserve(indexCount);
+	ResizeBuffers(context);
+}
+
 MeshStorage::Allocation MeshStorage::Allocate(GraphicsContext& context, uint32_t vertexCount, uint32_t indexCount)
 {
+	std::lock_guard<std::mutex> lock(m_AllocationLock);
+
 	MeshStorage::Allocation alloc{};
-	alloc.VertexOffset = m_VertexCount.fetch_add(vertexCount);
-	alloc.IndexOffset = m_IndexCount.fetch_add(indexCount);
+	alloc.VertexOffset = (uint32_t) m_Vertices.Allocate(vertexCount).Start;
+	alloc.IndexOffset = (uint32_t) m_Indices.Allocate(indexCount).Start;
+	ResizeBuffers(context);
 
-	const uint32_t wantedVBSize = vertexCount + alloc.VertexOffset;
-	const uint32_t wantedIBSize = indexCount + alloc.IndexOffset;
+	return alloc;
+}
 
-	GFX::ExpandBuffer(context, m_VertexBuffer.get(), wantedVBSize * GetVertexBufferStride());
-	GFX::ExpandBuffer(context, m_IndexBuffer.get(), wantedIBSize * GetIndexBufferStride());
+void MeshStorage::ResizeBuffers(GraphicsContext& context)
+{
+	GFX::ExpandBuffer(context, m_VertexBuffer.get(), (uint32_t) m_Vertices.GetCapacity() * GetVertexBufferStride());
+	GFX::ExpandBuffer(context, m_IndexBuffer.get(), (uint32_t) m_Indices.GetCapacity() * GetIndexBufferStride());
+}
+
+TextureStorage::TextureStorage() :
+	m_Registry(MAX_TEXTURE_COUNT)
+{
 
-	return alloc;
 }
 
 TextureStorage::~TextureStorage()
@@ -382,24 +401,13 @@ void TextureStorage::Update(GraphicsContext& context)
 	}
 }
 
-uint32_t TextureStorage::AllocTexture()
+void TextureStorage::ReleaseTexture(GraphicsContext& context, uint32_t textureIndex)
 {
-	const uint32_t textureIndex = m_NextAllocation++;
-	ASSERT(m_NextAllocation < MAX_TEXTURE_COUNT, "[TextureStorage] Too many textures!");
-	m_Textures[textureIndex] = m_EmptyTexture.get();
-	m_TableDirty = true;
-	return textureIndex;
-}
+	std::lock_guard<std::mutex> lock(m_RegistryLock);
 
-void TextureStorage::UpdateTexture(uint32_t textureIndex, Texture* texture)
-{
-	m_Textures[textureIndex] = texture;
-	m_TableDirty = true;
-}
+	if (!m_Registry.Release(textureIndex)) return;
 
-uint32_t TextureStorage::AddTexture(Texture* texture)
-{
-	const uint32_t texIndex = AllocTexture();
-	UpdateTexture(texIndex, texture);
-	return texIndex;
+	GFX::Delete(context, m_Textures[textureIndex]);
+	m_Textures[textureIndex] = m_EmptyTexture.get();
+	m_TableDirty = true;
 }
@@ -5,8 +5,10 @@
 #include <Engine/Common.h>
 #include <Engine/Render/Context.h>
 #include <Engine/Utility/Multithreading.h>
+#include <Engine/Utility/MemoryStrategies.h>
 
 #include "Globals.h"
+#include "Scene/TextureRegistry.h"
 
 struct GraphicsState;
 struct GraphicsContext;
@@ -196,6 +198,10 @@ struct Light
 	Float3 Direction = { 0.0f, 0.0f, 0.0f };
 	float SpotPower = 0.0f;
 
+	// Index in the local shadows buffer, updated by the ShadowRenderer every frame
+	static constexpr uint32_t InvalidShadowIndex = static_cast<uint32_t>(-1);
+	uint32_t ShadowIndex = InvalidShadowIndex;
+
 	struct LightSB
 	{
 		bool IsSpot;
@@ -204,6 +210,7 @@ struct Light
 		DirectX::XMFLOAT2 Falloff;
 		DirectX::XMFLOAT3 Direction;
 		float SpotPower;
+		uint32_t ShadowIndex;
 	};
 	using SBType = LightSB;
 
@@ -216,6 +223,7 @@ struct Light
 		lightSB.Falloff = Falloff.ToXMF();
 		lightSB.Direction = Direction.ToXMF();
 		lightSB.SpotPower = SpotPower;
+		lightSB.ShadowIndex = ShadowIndex;
 		return lightSB;
 	}
 };
@@ -404,49 +412,83 @@ public:
 
 	void Initialize();
 
+	// Resizes the buffers at most once so the next allocations of this many vertices and indices fit
+	// Loading reserves everything it adds up front, allocations that don't fit grow the buffers geometrically
+	void Reserve(GraphicsContext& context, uint32_t vertexCount, uint32_t indexCount);
 	Allocation Allocate(GraphicsContext& context, uint32_t vertexCount, uint32_t indexCount);
 
 	Buffer* GetVertexBuffer() const { return m_VertexBuffer.get(); }
 	Buffer* GetIndexBuffer() const { return m_IndexBuffer.get(); }
 
-	uint32_t GetVertexCount() const { return m_VertexCount; }
-	uint32_t GetIndexCount() const { return m_IndexCount; }
+	uint32_t GetVertexCount() const { return (uint32_t) m_Vertices.GetSize(); }
+	uint32_t GetIndexCount() const { return (uint32_t) m_Indices.GetSize(); }
+
+	// Every resize copies the whole buffer on the GPU
+	uint32_t GetNumReallocations() const { return m_Vertices.GetNumGrowths() + m_Indices.GetNumGrowths(); }
 
 	static constexpr uint8_t GetVertexBufferStride()	{ return sizeof(Vertex); }
 	static constexpr uint8_t GetIndexBufferStride()		{ return sizeof(uint32_t); }
 
 private:
-	std::atomic<uint32_t> m_VertexCount = 0;
-	std::atomic<uint32_t> m_IndexCount = 0;
+	void ResizeBuffers(GraphicsContext& context);
+
+private:
+	std::mutex m_AllocationLock;
+
+	// Buffers start with one element
+	GrowingRangeStrategy m_Vertices{ 1 };
+	GrowingRangeStrategy m_Indices{ 1 };
 
 	ScopedRef<Buffer> m_VertexBuffer;
 	ScopedRef<Buffer> m_IndexBuffer;
 };
 
+// Bindless textures of all render groups, textures with the same source or the same pixels are created once and shared
 class TextureStorage
 {
 public:
 	static constexpr uint32_t REGISTER_SPACE = 1;
 	static constexpr uint32_t MAX_TEXTURE_COUNT = 512;
 
+	TextureStorage();
 	~TextureStorage();
 
 	void Initialize(GraphicsContext& context);
 	void Update(GraphicsContext& context);
 
-	uint32_t AllocTexture();
-	void UpdateTexture(uint32_t textureIndex, Texture* texture);
-	uint32_t AddTexture(Texture* texture);
+	// Returns the bindless index, create is only called if the registry doesn't have the texture yet
+	// Index is INVALID_SLOT if the storage is full, every valid index has to be released
+	template<typename CreateFunc>
+	TextureRegistry::Acquisition AcquireTexture(uint64_t pathHash, uint64_t contentHash, CreateFunc create)
+	{
+		std::lock_guard<std::mutex> lock(m_RegistryLock);
+
+		const TextureRegistry::Acquisition acquisition = m_Registry.Acquire(pathHash, contentHash);
+		if (acquisition.Status == TextureRegistry::Result::Miss)
+		{
+			m_Textures[acquisition.Slot] = create();
+			m_TableDirty = true;
+		}
+		return acquisition;
+	}
+
+	// Texture is deleted at the end of the frame once its last reference is released, its index is then reused
+	void ReleaseTexture(GraphicsContext& context, uint32_t textureIndex);
 
 	const BindlessTable& GetBindlessTable() const { return m_Table; }
 
+	uint32_t GetNumTextures() const { return m_Registry.GetNumTextures(); }
+	TextureRegistry::Statistics GetStatistics() const { return m_Registry.GetStatistics(); }
+
 private:
 	bool m_TableDirty = true;
 	BindlessTable m_Table;
 
 	ScopedRef<Texture> m_EmptyTexture;
 	std::vector<Texture*> m_Textures;
-	std::atomic<uint32_t> m_NextAllocation = 0;
+
+	std::mutex m_RegistryLock;
+	TextureRegistry m_Registry;
 };
 
 // Group of data that can be rendered at once
@@ -455,7 +497,7 @@ struct RenderGroup
 	static constexpr uint32_t MAX_DRAWABLES = 200000;
 
 	RenderGroup();
-	void Initialize(GraphicsContext& context);
+	void Initialize(GraphicsContext& context, const TextureStorage& textures);
 	uint32_t AddMaterial(GraphicsContext& context, Material& material);
 	uint32_t AddMesh(GraphicsContext& context, Mesh& mesh);
 	uint32_t AddDrawable(GraphicsContext& context, Drawable& drawable);
@@ -466,7 +508,8 @@ struct RenderGroup
 	ElementBuffer<Mesh> Meshes;
 	ElementBuffer<Drawable> Drawables;
 
-	TextureStorage TextureData;
+	// Shared by all render groups of the scene graph
+	const TextureStorage* Textures = nullptr;
 	MeshStorage MeshData;
 };
 
@@ -493,7 +536,7 @@ struct SceneGraph
 		float AspectRatio;
 	};
 
-	SceneGraph();
+	SceneGraph(TextureStorage& textures);
 	void InitRenderData(GraphicsContext& context);
 	void FrameUpdate(GraphicsContext& context);
 
@@ -503,6 +546,8 @@ struct SceneGraph
 	Camera MainCamera;
 	Camera ShadowCamera;
 
+	// Owned by the scene manager, outlives the scene graph
+	TextureStorage& Textures;
 	RenderGroup RenderGroups[EnumToInt(RenderGroupType::Count)];
 
 	ElementBuffer<Light> Lights;
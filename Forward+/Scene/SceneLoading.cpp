@@ -1,412 +1,217 @@
 #include "SceneLoading.h"
 
-#pragma warning (disable : 4996)
-#include <cgltf.h>
-
-#include <Engine/Render/Device.h>
 #include <Engine/Render/Buffer.h>
 #include <Engine/Render/Texture.h>
 #include <Engine/Render/Context.h>
 #include <Engine/Render/Commands.h>
-#include <Engine/Render/RenderThread.h>
+#include <Engine/Loading/BCEncoding.h>
+#include <Engine/Utility/FileUtility.h>
 #include <Engine/Utility/PathUtility.h>
-#include <Engine/System/ApplicationConfiguration.h>
 
+#include "Scene/SceneCache.h"
 #include "Scene/SceneManager.h"
-#include "Scene/TextureLoading.h"
-#include "Shaders/shared_definitions.h"
-
-#define CGTF_CALL(X) { cgltf_result result = X; ASSERT(result == cgltf_result_success, "CGTF_CALL_FAIL") }
-
-// TMP_HACK
-#undef min
-#undef max
 
 namespace SceneLoading
 {
 	namespace
 	{
-		struct LoadingContext
-		{
-			std::string RelativePath;
-			GraphicsContext* GfxContext;
-			SceneGraph* LoadingScene;
-			RenderGroup* LoadingRG;
-			RenderGroupType RGType;
-		};
-
-		static Float3 ToFloat3(cgltf_float color[3])
-		{
-			return Float3{ color[0], color[1], color[2] };
-		}
-
-		static Float4 ToFloat4(cgltf_float color[4])
-		{
-			return Float4{ color[0], color[1], color[2], color[3] };
-		}
-
-		template<typename T>
-		T* GetBufferData(cgltf_accessor* accessor)
-		{
-			unsigned char* buffer = (unsigned char*)accessor->buffer_view->buffer->data + accessor->buffer_view->offset;
-			void* data = buffer + accessor->offset;
-			return static_cast<T*>(data);
-		}
-
-		void PrepareIB(const LoadingContext& context, Float3* positons, uint32_t numPositions, std::vector<uint32_t>& inBuffer, std::vector<uint32_t>& outBuffer, std::vector<DirectX::CullData>& outCullData)
-		{
-			PROFILE_SECTION(*context.GfxContext, "PrepareIB");
-
-			std::vector<DirectX::Meshlet> meshlets;
-			std::vector<uint8_t> uniqueVertexIB;
-			std::vector<DirectX::MeshletTriangle> triangles;
-			
-			API_CALL(DirectX::ComputeMeshlets(inBuffer.data(), inBuffer.size() / 3, (DirectX::XMFLOAT3*) positons, numPositions, nullptr, meshlets, uniqueVertexIB, triangles, 128, MESHLET_TRIANGLE_COUNT));
-			
-			outCullData.resize(meshlets.size());
-			uint32_t* vertexIBRaw = (uint32_t*) uniqueVertexIB.data();
-
-			API_CALL(DirectX::ComputeCullData((DirectX::XMFLOAT3*)positons, numPositions, meshlets.data(), meshlets.size(), vertexIBRaw, uniqueVertexIB.size() / 4, triangles.data(), triangles.size(), outCullData.data()));
-
-			outBuffer.reserve(meshlets.size() * MESHLET_INDEX_COUNT);
-
-			for (const DirectX::Meshlet& meshlet : meshlets)
-			{
-				for (uint32_t i = 0; i < meshlet.PrimCount; i++)
-				{
-					DirectX::MeshletTriangle t = triangles[meshlet.PrimOffset + i];
-					outBuffer.push_back(vertexIBRaw[meshlet.VertOffset + t.i0]);
-					outBuffer.push_back(vertexIBRaw[meshlet.VertOffset + t.i1]);
-					outBuffer.push_back(vertexIBRaw[meshlet.VertOffset + t.i2]);
-				}
-				for (uint32_t i = meshlet.PrimCount; i < MESHLET_TRIANGLE_COUNT; i++)
-				{
-					outBuffer.push_back(0);
-					outBuffer.push_back(0);
-					outBuffer.push_back(0);
-				}
-			}
-		}
+		static_assert(sizeof(SceneCache::Vertex) == sizeof(MeshStorage::Vertex));
+		static_assert(SceneCache::RENDER_GROUP_COUNT == EnumToInt(RenderGroupType::Count));
 
-		template<typename T>
-		void FetchIndexData(cgltf_accessor* indexAccessor, std::vector<uint32_t>& buffer)
+		DXGI_FORMAT ToDXGIFormat(BCEncoding::Format format)
 		{
-			T* indexData = GetBufferData<T>(indexAccessor);
-			for (size_t i = 0; i < indexAccessor->count; i++)
+			switch (format)
 			{
-				buffer[i] = indexData[i];
+			case BCEncoding::Format::BC1: return DXGI_FORMAT_BC1_UNORM;
+			case BCEncoding::Format::BC5: return DXGI_FORMAT_BC5_UNORM;
+			case BCEncoding::Format::BC7: return DXGI_FORMAT_BC7_UNORM;
+			default: return DXGI_FORMAT_R8G8B8A8_UNORM;
 			}
 		}
 
-		void LoadIB(const LoadingContext& context, cgltf_accessor* indexAccessor, std::vector<uint32_t>& buffer)
+		Texture* CreateTexture(GraphicsContext& context, const SceneCache::SceneView& scene, uint32_t textureIndex)
 		{
-			ASSERT(indexAccessor, "[SceneLoading] Trying to read indices from empty accessor");
-			ASSERT(indexAccessor->type == cgltf_type_scalar, "[SceneLoading] Indices of a mesh arent scalar.");
-			
-			buffer.resize(indexAccessor->count);
-			
-			switch (indexAccessor->component_type)
+			const SceneCache::TextureData& textureData = scene.Textures[textureIndex];
+			const DXGI_FORMAT format = ToDXGIFormat((BCEncoding::Format) textureData.Format);
+			Texture* texture = GFX::CreateTexture(textureData.Width, textureData.Height, RCF::None, textureData.NumMips, format);
+			for (uint32_t mip = 0; mip < textureData.NumMips; mip++)
 			{
-			case cgltf_component_type_r_16u: FetchIndexData<uint16_t>(indexAccessor, buffer); break;
-			case cgltf_component_type_r_32u: FetchIndexData<uint32_t>(indexAccessor, buffer); break;
-			default: NOT_IMPLEMENTED;
+				const uint8_t* mipData = scene.TexturePixels.data() + textureData.PixelOffset + SceneCache::GetMipOffset(textureData, mip);
+				GFX::Cmd::UploadToTexture(context, mipData, texture, mip);
 			}
+			return texture;
 		}
 
-		template<cgltf_type TYPE, cgltf_component_type COMPONENT_TYPE>
-		void ValidateVertexAttribute(cgltf_attribute* attribute)
+		// Meshes of the render group are uploaded with one copy for vertices and one for indices
+		// Storage is resized to the exact size of the group before the allocation so it's resized at most once per load
+		std::vector<uint32_t> AddMeshes(GraphicsContext& context, SceneGraph& sceneGraph, const SceneCache::SceneView& scene)
 		{
-			ASSERT(attribute->data->type == TYPE, "[SceneLoading] ASSERT FAILED: attributeAccessor->type == TYPE");
-			ASSERT(attribute->data->component_type == COMPONENT_TYPE, "[SceneLoading] ASSERT FAILED: attributeAccessor->component_type == COMPONENT_TYPE");
-		}
-
-		uint32_t LoadMesh(const LoadingContext& context, cgltf_primitive* meshData)
-		{
-			PROFILE_SECTION(*context.GfxContext, "LoadMesh");
+			PROFILE_SECTION(context, "AddMeshes");
 
-			ASSERT(meshData->type == cgltf_primitive_type_triangles, "[SceneLoading] Scene contains quad meshes. We are supporting just triangle meshes.");
+			std::vector<uint32_t> meshIndices(scene.Meshes.size());
+			for (uint32_t rgIndex = 0; rgIndex < SceneCache::RENDER_GROUP_COUNT; rgIndex++)
+			{
+				const SceneCache::RenderGroupData& rgData = scene.RenderGroups[rgIndex];
+				if (rgData.NumVertices == 0) continue;
 
-			const uint32_t vertCount = (uint32_t) meshData->attributes[0].data->count;
+				RenderGroup& rg = sceneGraph.RenderGroups[rgIndex];
+				MeshStorage& meshStorage = rg.MeshData;
+				meshStorage.Reserve(context, rgData.NumVertices, rgData.NumIndices);
+				const MeshStorage::Allocation alloc = meshStorage.Allocate(context, rgData.NumVertices, rgData.NumIndices);
 
-			Float3* positionData = nullptr;
-			Float2* uvData = nullptr;
-			Float3* normalData = nullptr;
-			Float4* tangentData = nullptr;
+				GFX::Cmd::UploadToBuffer(context, meshStorage.GetVertexBuffer(), alloc.VertexOffset * MeshStorage::GetVertexBufferStride(), scene.Vertices.data() + rgData.FirstVertex, 0, rgData.NumVertices * MeshStorage::GetVertexBufferStride());
+				GFX::Cmd::UploadToBuffer(context, meshStorage.GetIndexBuffer(), alloc.IndexOffset * MeshStorage::GetIndexBufferStride(), scene.Indices.data() + rgData.FirstIndex, 0, rgData.NumIndices * MeshStorage::GetIndexBufferStride());
 
-			for (size_t i = 0; i < meshData->attributes_count; i++)
-			{
-				cgltf_attribute* vertexAttribute = (meshData->attributes + i);
-				switch (vertexAttribute->type)
+				for (uint32_t i = 0; i < (uint32_t) scene.Meshes.size(); i++)
 				{
-				case cgltf_attribute_type_position:
-					ValidateVertexAttribute<cgltf_type_vec3, cgltf_component_type_r_32f>(vertexAttribute);
-					positionData = GetBufferData<Float3>(vertexAttribute->data);
-					break;
-				case cgltf_attribute_type_texcoord:
-					ValidateVertexAttribute<cgltf_type_vec2, cgltf_component_type_r_32f>(vertexAttribute);
-					uvData = GetBufferData<Float2>(vertexAttribute->data);
-					break;
-				case cgltf_attribute_type_normal:
-					ValidateVertexAttribute<cgltf_type_vec3, cgltf_component_type_r_32f>(vertexAttribute);
-					normalData = GetBufferData<Float3>(vertexAttribute->data);
-					break;
-				case cgltf_attribute_type_tangent:
-					ValidateVertexAttribute<cgltf_type_vec4, cgltf_component_type_r_32f>(vertexAttribute);
-					tangentData = GetBufferData<Float4>(vertexAttribute->data);
-					break;
+					const SceneCache::MeshData& meshData = scene.Meshes[i];
+					if (meshData.RenderGroup != rgIndex) continue;
+
+					Mesh mesh;
+					mesh.VertCount = meshData.VertexCount;
+					mesh.IndexCount = meshData.IndexCount;
+					mesh.VertOffset = alloc.VertexOffset + meshData.VertexOffset - rgData.FirstVertex;
+					mesh.IndexOffset = alloc.IndexOffset + meshData.IndexOffset - rgData.FirstIndex;
+					meshIndices[i] = rg.AddMesh(context, mesh);
 				}
 			}
-
-			// TODO: calculate missing attributes
-			ASSERT(positionData && uvData && normalData, "[SceneLoading::LoadMesh] Missing vertex data");
-			
-			// Indices
-			std::vector<uint32_t> loadedIndices;
-			LoadIB(context, meshData->indices, loadedIndices);
-
-			std::vector<DirectX::CullData> cullData;
-			std::vector<uint32_t> indices = loadedIndices; // TODO: Enable meshlets
-			// PrepareIB(context, positionData, vertCount, loadedIndices, indices, cullData);
-
-			// Vertices
-			std::vector<MeshStorage::Vertex> vertices;
-			vertices.resize(vertCount);
-			for (uint32_t i = 0; i < vertCount; i++)
-			{
-				vertices[i].Position = positionData[i];
-				vertices[i].Texcoord = uvData[i];
-				vertices[i].Normal = normalData[i];
-				vertices[i].Tangent = tangentData ? tangentData[i] : Float4(0,0,0,0);
-			}
-
-			MeshStorage& meshStorage = context.LoadingRG->MeshData;
-			MeshStorage::Allocation alloc = meshStorage.Allocate(*context.GfxContext, vertCount, (uint32_t) indices.size());
-
-			Mesh mesh;
-			mesh.VertCount = vertCount;
-			mesh.IndexCount = (uint32_t) indices.size();
-			mesh.VertOffset = alloc.VertexOffset;
-			mesh.IndexOffset = alloc.IndexOffset;
-			mesh.MeshletCullData = cullData;
-
-			// Upload
-			GFX::Cmd::UploadToBuffer(*context.GfxContext, meshStorage.GetVertexBuffer(), mesh.VertOffset * MeshStorage::GetVertexBufferStride(), vertices.data(), 0, mesh.VertCount * MeshStorage::GetVertexBufferStride());
-			GFX::Cmd::UploadToBuffer(*context.GfxContext, meshStorage.GetIndexBuffer(), mesh.IndexOffset * MeshStorage::GetIndexBufferStride(), indices.data(), 0, mesh.IndexCount * MeshStorage::GetIndexBufferStride());
-
-			return context.LoadingRG->AddMesh(*context.GfxContext, mesh);
+			return meshIndices;
 		}
 
-		BoundingSphere CalculateBoundingSphere(cgltf_primitive* meshData)
+		// Textures are shared by all render groups, a texture that this or another scene already loaded isn't created again
+		// Scene takes one reference for each texture its materials use
+		std::vector<uint32_t> AddMaterials(GraphicsContext& context, SceneGraph& sceneGraph, const SceneCache::SceneView& scene, LoadedScene& loadedScene)
 		{
-			Float3* vertexData = nullptr;
-			uint32_t vertexCount = (uint32_t) meshData->attributes[0].data->count;
+			PROFILE_SECTION(context, "AddMaterials");
+
+			static constexpr uint32_t INVALID_INDEX = TextureRegistry::INVALID_SLOT;
+			std::vector<uint32_t> storageIndices(scene.Textures.size(), INVALID_INDEX);
 
-			for (size_t i = 0; i < meshData->attributes_count && vertexData == nullptr; i++)
+			const auto getTexture = [&](uint32_t textureIndex)
 			{
-				cgltf_attribute* vertexAttribute = (meshData->attributes + i);
-				if (vertexAttribute->type == cgltf_attribute_type_position)
+				uint32_t& storageIndex = storageIndices[textureIndex];
+				if (storageIndex == INVALID_INDEX)
 				{
-					ValidateVertexAttribute<cgltf_type_vec3, cgltf_component_type_r_32f>(vertexAttribute);
-					vertexData = GetBufferData<Float3>(vertexAttribute->data);
+					const SceneCache::TextureData& textureData = scene.Textures[textureIndex];
+					const TextureRegistry::Acquisition acquisition = sceneGraph.Textures.AcquireTexture(textureData.PathHash, textureData.ContentHash, [&]
+					{
+						return CreateTexture(context, scene, textureIndex);
+					});
+					ASSERT(acquisition.Slot != INVALID_INDEX, "[SceneLoading] Too many textures!");
+
+					storageIndex = acquisition.Slot;
+					loadedScene.TextureStats.Add(acquisition.Status);
+					if (storageIndex != INVALID_INDEX) loadedScene.Textures.push_back(storageIndex);
 				}
-			}
-
-			ASSERT(vertexData, "[SceneLoading] ASSERT FAILED: vertexData");
-
-			static constexpr float MAX_FLOAT = std::numeric_limits<float>::max();
-			static constexpr float MIN_FLOAT = std::numeric_limits<float>::min();
+				return storageIndex;
+			};
 
-			Float3 minAABB{ MAX_FLOAT , MAX_FLOAT, MAX_FLOAT };
-			Float3 maxAABB{ MIN_FLOAT, MIN_FLOAT, MIN_FLOAT };
-			for (uint32_t i = 0; i < vertexCount; i++)
+			std::vector<uint32_t> materialIndices(scene.Materials.size());
+			for (uint32_t i = 0; i < (uint32_t) scene.Materials.size(); i++)
 			{
-				const Float3 pos = vertexData[i];
-
-				minAABB.x = MIN(minAABB.x, pos.x);
-				minAABB.y = MIN(minAABB.y, pos.y);
-				minAABB.z = MIN(minAABB.z, pos.z);
-
-				maxAABB.x = MAX(maxAABB.x, pos.x);
-				maxAABB.y = MAX(maxAABB.y, pos.y);
-				maxAABB.z = MAX(maxAABB.z, pos.z);
+				const SceneCache::MaterialData& materialData = scene.Materials[i];
+
+				Material material;
+				material.UseBlend = materialData.UseBlend != 0;
+				material.UseAlphaDiscard = materialData.UseAlphaDiscard != 0;
+				material.AlbedoFactor = Float3{ materialData.AlbedoFactor[0], materialData.AlbedoFactor[1], materialData.AlbedoFactor[2] };
+				material.MetallicFactor = materialData.MetallicFactor;
+				material.RoughnessFactor = materialData.RoughnessFactor;
+				material.Albedo = getTexture(materialData.Albedo);
+				material.MetallicRoughness = getTexture(materialData.MetallicRoughness);
+				material.Normal = getTexture(materialData.Normal);
+
+				materialIndices[i] = sceneGraph.RenderGroups[materialData.RenderGroup].AddMaterial(context, material);
 			}
-
-			BoundingSphere bs;
-			bs.Center = 0.5f * (maxAABB + minAABB);
-			bs.Radius = (minAABB - maxAABB).LengthFast() * 0.5f;
-
-			return bs;
+			return materialIndices;
 		}
 
-		uint32_t LoadTexture(const LoadingContext& context, cgltf_texture* texture, ColorUNORM defaultColor = {1.0f, 1.0f, 1.0f, 1.0f})
+		LoadedScene AddScene(GraphicsContext& context, const SceneCache::SceneView& scene)
 		{
-			PROFILE_SECTION(*context.GfxContext, "LoadTexture");
-
-			uint32_t textureIndex = context.LoadingRG->TextureData.AllocTexture();
+			SceneGraph& sceneGraph = SceneManager::Get().GetSceneGraph();
 
-			std::string texturePath = "";
-			if (texture)
-			{
-				const std::string textureURI = texture->image->uri;
-				texturePath = context.RelativePath + "/" + textureURI;
-			}
+			LoadedScene loadedScene;
+			const std::vector<uint32_t> meshIndices = AddMeshes(context, sceneGraph, scene);
+			const std::vector<uint32_t> materialIndices = AddMaterials(context, sceneGraph, scene, loadedScene);
 
-			if (AppConfig.Settings.contains("MTR_LOADING"))
+			loadedScene.Objects.reserve(scene.Objects.size());
+			for (const SceneCache::ObjectData& objectData : scene.Objects)
 			{
-				RenderThreadPool::Get()->Submit(new TextureLoadingTask(texturePath, textureIndex, context.LoadingRG->TextureData, defaultColor));
+				LoadedObject object{};
+				object.RenderGroup = (RenderGroupType) scene.Materials[objectData.Material].RenderGroup;
+				object.MeshIndex = meshIndices[objectData.Mesh];
+				object.MaterialIndex = materialIndices[objectData.Material];
+				memcpy(&object.Transform, objectData.Transform, sizeof(objectData.Transform));
+				object.BoundingVolume.Center = Float3{ objectData.BoundsCenter[0], objectData.BoundsCenter[1], objectData.BoundsCenter[2] };
+				object.BoundingVolume.Radius = objectData.BoundsRadius;
+				loadedScene.Objects.push_back(object);
 			}
-			else
-			{
-				if (AppConfig.Settings.contains("LOADING_USE_LESS_MEMORY"))
-				{
-					Device::Get()->GetTaskExecutor().Submit(new TextureLoadingTask(texturePath, textureIndex, context.LoadingRG->TextureData, defaultColor));
-				}
-				else
-				{
-					TextureLoadingTask(texturePath, textureIndex, context.LoadingRG->TextureData, defaultColor).Run(*context.GfxContext);
-				}
-			}
-			
-			return textureIndex;
+			return loadedScene;
 		}
+	}
 
-		RenderGroupType GetRenderGroupType(const Material& material)
-		{
-			RenderGroupType rgType = RenderGroupType::Opaque;
-			if (material.UseBlend) rgType = RenderGroupType::Transparent;
-			else if (material.UseAlphaDiscard) rgType = RenderGroupType::AlphaDiscard;
-			return rgType;
-		}
+	LoadedScene Load(GraphicsContext& gfxContext, const std::string& path)
+	{
+		PROFILE_SECTION(gfxContext, "SceneLoading::Load");
 
-		uint32_t LoadMaterial(LoadingContext& context, cgltf_material* materialData)
+		const std::string& ext = PathUtility::GetFileExtension(path);
+		if (ext != "gltf" && ext != "glb")
 		{
-			ASSERT(materialData->has_pbr_metallic_roughness, "[SceneLoading] Every material must have a base color texture!");
-
-			cgltf_pbr_metallic_roughness& mat = materialData->pbr_metallic_roughness;
-
-			Material material;
-			material.UseBlend = materialData->alpha_mode == cgltf_alpha_mode_blend;
-			material.UseAlphaDiscard = materialData->alpha_mode == cgltf_alpha_mode_mask;
-			material.AlbedoFactor = ToFloat3(mat.base_color_factor);
-			material.MetallicFactor = mat.metallic_factor;
-			material.RoughnessFactor = mat.roughness_factor;
-
-			context.RGType = GetRenderGroupType(material);
-			context.LoadingRG = &context.LoadingScene->RenderGroups[EnumToInt(context.RGType)];
+			ASSERT(0, "[SceneLoading] For now we only support glTF 3D format.");
+			return {};
+		}
 
-			material.Albedo = LoadTexture(context, mat.base_color_texture.texture);
-			material.MetallicRoughness = LoadTexture(context, mat.metallic_roughness_texture.texture);
-			material.Normal = LoadTexture(context, materialData->normal_texture.texture, ColorUNORM(0.5f, 0.5f, 1.0f, 1.0f));
+		uint64_t sourceHash = 0;
+		const bool hashed = SceneCache::HashSourceFile(path, sourceHash);
+		ASSERT(hashed, "[SceneLoading] Failed to read the scene: " << path);
+		const std::string cachePath = SceneCache::GetCachePath(sourceHash);
 
-			return context.LoadingRG->AddMaterial(*context.GfxContext, material);
-		}
+		// View points to the mapped cache or to the built data, both live until the scene is uploaded
+		FileUtility::MappedFile cacheFile;
+		SceneCache::SceneData sceneData;
+		SceneCache::SceneView sceneView;
 
-		LoadedObject LoadObject(LoadingContext& context, cgltf_primitive* objectData)
+		bool cached = false;
 		{
-			LoadedObject object{};
-			object.MaterialIndex = LoadMaterial(context, objectData->material);
-			object.RenderGroup = context.RGType;
-			object.MeshIndex = LoadMesh(context, objectData);
-			object.BoundingVolume = CalculateBoundingSphere(objectData);
-			return object;
+			PROFILE_SECTION(gfxContext, "LoadCache");
+			cached = hashed && SceneCache::LoadCache(cachePath, sourceHash, cacheFile, sceneView);
 		}
 
-		DirectX::XMFLOAT4X4 CalcBaseTransform(cgltf_node* nodeData)
+		if (!cached)
 		{
-			using namespace DirectX;
-
-			std::vector<cgltf_node*> hierarchy;
-			cgltf_node* currNode = nodeData;
-			while (currNode)
-			{
-				hierarchy.push_back(currNode);
-				currNode = currNode->parent;
-			}
+			PROFILE_SECTION(gfxContext, "BuildCache");
 
-			XMMATRIX transform = XMMatrixIdentity();
-			for (int32_t i = (int32_t) hierarchy.size()-1; i >= 0; i--)
+			if (!SceneCache::Build(path, sceneData))
 			{
-				cgltf_node* node = hierarchy[i];
-				if (node->has_matrix)
-				{
-					NOT_IMPLEMENTED;
-				}
-				else
-				{
-					const Float3 position = node->has_translation ? ToFloat3(node->translation) : Float3{ 0.0f, 0.0f, 0.0f };
-					const Float4 rotation = node->has_rotation ? ToFloat4(node->rotation) : Float4{ 0.0f, 0.0f, 0.0f, 0.0f };
-					const Float3 scale = node->has_scale ? ToFloat3(node->scale) : Float3{ 1.0f, 1.0f, 1.0f };
-					const XMMATRIX nodeTransform = XMMatrixAffineTransformation(scale, Float3{ 0.0f, 0.0f, 0.0f }, rotation, position);
-					transform = XMMatrixMultiply(transform, nodeTransform);
-				}
+				ASSERT(0, "[SceneLoading] Failed to load the scene: " << path);
+				return {};
 			}
 
-			return XMUtility::ToXMFloat4x4(transform);
+			sceneView = sceneData.GetView();
+			if (hashed) SceneCache::SaveCache(cachePath, sourceHash, sceneView);
 		}
 
-		std::vector<LoadedObject> LoadNode(LoadingContext& context, cgltf_node* nodeData, LoadedScene& sceneRef)
-		{
-			PROFILE_SECTION(*context.GfxContext, "LoadNode");
+		LoadedScene loadedScene = AddScene(gfxContext, sceneView);
 
-			std::vector<LoadedObject> objects;
-			if (nodeData->mesh)
-			{
-				const DirectX::XMFLOAT4X4 transform = CalcBaseTransform(nodeData);
-				for (size_t i = 0; i < nodeData->mesh->primitives_count; i++)
-				{
-					LoadedObject obj = LoadObject(context, nodeData->mesh->primitives + i);
-					obj.Transform = transform;
-					sceneRef.push_back(obj);
-				}
-			}
-			return objects;
-		}
+		const TextureRegistry::Statistics& textureStats = loadedScene.TextureStats;
+		std::cout << "[SceneLoading] " << path << ": " << loadedScene.Textures.size() << " textures, " << textureStats.NumMisses << " created, "
+			<< textureStats.NumPathHits << " shared by path, " << textureStats.NumContentHits << " shared by content" << std::endl;
+
+		return loadedScene;
 	}
 
-	LoadedScene Load(GraphicsContext& gfxContext, const std::string& path)
+	void Unload(GraphicsContext& context, LoadedScene& scene)
 	{
-		PROFILE_SECTION(gfxContext, "SceneLoading::Load");
-
-		LoadedScene scene;
-
-		const std::string& ext = PathUtility::GetFileExtension(path);
-		if (ext != "gltf")
-		{
-			ASSERT(0, "[SceneLoading] For now we only support glTF 3D format.");
-			return scene;
-		}
-
-		LoadingContext context{};
-		context.RelativePath = PathUtility::GetPathWitoutFile(path);
-		context.GfxContext = &gfxContext;
-		context.LoadingScene = &SceneManager::Get().GetSceneGraph();
-
-		cgltf_options options = {};
-		cgltf_data* data = NULL;
-		{
-			PROFILE_SECTION(gfxContext, "ParseFile");
-			CGTF_CALL(cgltf_parse_file(&options, path.c_str(), &data));
-		}
-		{
-			PROFILE_SECTION(gfxContext, "LoadBuffers");
-			CGTF_CALL(cgltf_load_buffers(&options, data, path.c_str()));
-		}
-		
-		for (size_t i = 0; i < data->nodes_count; i++)
-		{
-			std::vector<LoadedObject> objects = LoadNode(context, data->nodes + i, scene);
-		}
-
-		cgltf_free(data);
-
-		return scene;
+		TextureStorage& textures = SceneManager::Get().GetTextureStorage();
+		for (uint32_t textureIndex : scene.Textures) textures.ReleaseTexture(context, textureIndex);
+		scene = LoadedScene{};
 	}
 
-	void AddDraws(GraphicsContext& context, const LoadedScene scene, const Drawable& baseDrawable)
+	void AddDraws(GraphicsContext& context, const LoadedScene& scene, const Drawable& baseDrawable)
 	{
 		PROFILE_SECTION(context, "SceneLoading::AddDraws");
 
-		for (const LoadedObject& obj : scene)
+		for (const LoadedObject& obj : scene.Objects)
 		{
 			Drawable drawable = baseDrawable;
 			drawable.MaterialIndex = obj.MaterialIndex;
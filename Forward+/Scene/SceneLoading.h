@@ -15,10 +15,24 @@ namespace SceneLoading
 		DirectX::XMFLOAT4X4 Transform = XMUtility::ToXMFloat4x4(DirectX::XMMatrixIdentity());
 		BoundingSphere BoundingVolume;
 	};
-	using LoadedScene = std::vector<LoadedObject>;
+
+	struct LoadedScene
+	{
+		std::vector<LoadedObject> Objects;
+
+		// Bindless indices of the textures the scene holds a reference to, each texture once
+		std::vector<uint32_t> Textures;
+
+		// How the textures of this load were found in the texture storage
+		TextureRegistry::Statistics TextureStats;
+	};
 
 	// We are using position, scale and rotation from baseDrawable
-	void AddDraws(GraphicsContext& context, const LoadedScene scene, const Drawable& baseDrawable);
+	void AddDraws(GraphicsContext& context, const LoadedScene& scene, const Drawable& baseDrawable);
 
 	LoadedScene Load(GraphicsContext& context, const std::string& path);
+
+	// Releases the textures of the scene, the ones no other scene uses are deleted
+	// Materials of the scene still point to the released indices so the scene can't be drawn after it's unloaded
+	void Unload(GraphicsContext& context, LoadedScene& scene);
 }
\ No newline at end of file
@@ -13,12 +13,12 @@ SceneManager* SceneManager::s_Instance;
 
 namespace
 {
-	template<SceneSelection Scene> void LoadSceneSelection(GraphicsContext& context) 
+	template<SceneSelection Scene> void LoadSceneSelection(GraphicsContext& context, std::vector<SceneLoading::LoadedScene>& loadedScenes) 
 	{
 		NOT_IMPLEMENTED;
 	}
 
-	template<> void LoadSceneSelection<SceneSelection::SimpleBoxes>(GraphicsContext& context)
+	template<> void LoadSceneSelection<SceneSelection::SimpleBoxes>(GraphicsContext& context, std::vector<SceneLoading::LoadedScene>& loadedScenes)
 	{
 		Drawable plane{};
 		plane.Position = { 0.0f, -10.0f, 0.0f };
@@ -36,13 +36,14 @@ namespace
 			cube.Scale = scale;
 			SceneLoading::AddDraws(context, cubeScene, cube);
 		}
+		loadedScenes.push_back(std::move(cubeScene));
 	}
 
 	// Note: Too big for the github, so using low res scene on repo
 	// const std::string SPONZA_PATH = "Resources/SuperSponza/NewSponza_Main_Blender_glTF.gltf"
 	const std::string SPONZA_PATH = "Resources/sponza/sponza.gltf";
 
-	template<> void LoadSceneSelection<SceneSelection::Sponza>(GraphicsContext& context)
+	template<> void LoadSceneSelection<SceneSelection::Sponza>(GraphicsContext& context, std::vector<SceneLoading::LoadedScene>& loadedScenes)
 	{
 		SceneLoading::LoadedScene scene = SceneLoading::Load(context, SPONZA_PATH);
 
@@ -54,9 +55,10 @@ namespace
 		SceneLoading::AddDraws(context, scene, e);
 
 		SceneManager::Get().GetSceneGraph().MainCamera.NextTransform.Position += startingPosition;
+		loadedScenes.push_back(std::move(scene));
 	}
 
-	template<> void LoadSceneSelection<SceneSelection::SponzaX100>(GraphicsContext& context)
+	template<> void LoadSceneSelection<SceneSelection::SponzaX100>(GraphicsContext& context, std::vector<SceneLoading::LoadedScene>& loadedScenes)
 	{
 		SceneLoading::LoadedScene scene = SceneLoading::Load(context, SPONZA_PATH);
 
@@ -73,6 +75,7 @@ namespace
 			}
 		}
 		SceneManager::Get().GetSceneGraph().MainCamera.NextTransform.Position += Float3(2 * CASTLE_OFFSET[0], 0.0f, 2 * CASTLE_OFFSET[1]);
+		loadedScenes.push_back(std::move(scene));
 	}
 }
 
@@ -81,7 +84,10 @@ SceneManager::~SceneManager()
 	RenderThreadPool::Get()->FlushAndPauseExecution();
 	ContextManager::Get().Flush();
 
+	// Storage deletes the textures that the scenes still reference
 	SAFE_DELETE(m_SceneGraph);
+	m_LoadedScenes.clear();
+	SAFE_DELETE(m_TextureStorage);
 	m_CurrentScene = SceneSelection::None;
 
 	RenderThreadPool::Get()->ResumeExecution();
@@ -101,9 +107,21 @@ void SceneManager::LoadScene(GraphicsContext& context, SceneSelection scene)
 	}
 	
 	m_CurrentScene = scene;
+	m_SceneVersion++;
+
+	if (!m_TextureStorage)
+	{
+		m_TextureStorage = new TextureStorage{};
+		m_TextureStorage->Initialize(context);
+	}
+
+	// Previous scene is released once the new one is loaded so the textures both use stay in the storage
+	SceneGraph* previousSceneGraph = m_SceneGraph;
+	std::vector<SceneLoading::LoadedScene> previousScenes = std::move(m_LoadedScenes);
+	m_LoadedScenes.clear();
 
 	// Init scene graph
-	m_SceneGraph = new SceneGraph{};
+	m_SceneGraph = new SceneGraph{ *m_TextureStorage };
 	m_SceneGraph->InitRenderData(context);
 
 	// Set default lights
@@ -115,22 +133,29 @@ void SceneManager::LoadScene(GraphicsContext& context, SceneSelection scene)
 	switch (scene)
 	{
 	case SceneSelection::None:
-		LoadSceneSelection<SceneSelection::None>(context);
+		LoadSceneSelection<SceneSelection::None>(context, m_LoadedScenes);
 		break;
 	case SceneSelection::SimpleBoxes:
-		LoadSceneSelection<SceneSelection::SimpleBoxes>(context);
+		LoadSceneSelection<SceneSelection::SimpleBoxes>(context, m_LoadedScenes);
 		break;
 	case SceneSelection::Sponza:
-		LoadSceneSelection<SceneSelection::Sponza>(context);
+		LoadSceneSelection<SceneSelection::Sponza>(context, m_LoadedScenes);
 		break;
 	case SceneSelection::SponzaX100:
-		LoadSceneSelection<SceneSelection::SponzaX100>(context);
+		LoadSceneSelection<SceneSelection::SponzaX100>(context, m_LoadedScenes);
 		break;
 	default:
 		NOT_IMPLEMENTED;
 		break;
 	}
 
+	// Materials and drawables of the previous scene are deleted with its graph before its textures are released
+	SAFE_DELETE(previousSceneGraph);
+	for (SceneLoading::LoadedScene& loadedScene : previousScenes)
+	{
+		SceneLoading::Unload(context, loadedScene);
+	}
+
 	if (resumeThreadPool)
 	{
 		RenderThreadPool::Get()->ResumeExecution();
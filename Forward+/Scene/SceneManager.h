@@ -1,7 +1,12 @@
 #pragma once
 
+#include <vector>
+
+#include "Scene/SceneLoading.h"
+
 struct GraphicsContext;
 struct SceneGraph;
+class TextureStorage;
 
 enum class SceneSelection
 {
@@ -42,10 +47,21 @@ public:
 	void LoadScene(GraphicsContext& context, SceneSelection scene);
 	
 	SceneGraph& GetSceneGraph() { return *m_SceneGraph; }
+	TextureStorage& GetTextureStorage() { return *m_TextureStorage; }
 	SceneSelection GetCurrentScene() const { return m_CurrentScene; }
 
+	// Changes every time a scene is loaded, also when the same scene is loaded again
+	uint32_t GetSceneVersion() const { return m_SceneVersion; }
+
 private:
 	SceneSelection m_CurrentScene = SceneSelection::None;
+	uint32_t m_SceneVersion = 0;
 
 	SceneGraph* m_SceneGraph = nullptr;
+
+	// Kept across scene switches so the textures that the next scene uses too aren't created again
+	TextureStorage* m_TextureStorage = nullptr;
+
+	// Scenes that hold the texture references of the current scene graph
+	std::vector<SceneLoading::LoadedScene> m_LoadedScenes;
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "TextureRegistry.h"
+
+#include <algorithm>
+
+void TextureRegistry::Statistics::Add(Result result)
+{
+	if (result == Result::PathHit) NumPathHits++;
+	else if (result == Result::ContentHit) NumContentHits++;
+	else if (result == Result::Miss) NumMisses++;
+}
+
+TextureRegistry::TextureRegistry(uint32_t maxSlots) :
+	m_Slots(maxSlots)
+{
+	m_Entries.resize(maxSlots);
+}
+
+TextureRegistry::Acquisition TextureRegistry::Acquire(uint64_t pathHash, uint64_t contentHash)
+{
+	Acquisition acquisition{};
+
+	const auto pathIt = pathHash ? m_Paths.find(pathHash) : m_Paths.end();
+	if (pathIt != m_Paths.end() && m_Entries[pathIt->second].ContentHash == contentHash)
+	{
+		acquisition.Slot = pathIt->second;
+		acquisition.Status = Result::PathHit;
+	}
+	else if (const auto contentIt = m_Contents.find(contentHash); contentIt != m_Contents.end())
+	{
+		acquisition.Slot = contentIt->second;
+		acquisition.Status = Result::ContentHit;
+	}
+	else
+	{
+		const size_t slot = m_Slots.Allocate();
+		if (slot == INVALID_ALLOCATION) return acquisition;
+
+		acquisition.Slot = (uint32_t) slot;
+		acquisition.Status = Result::Miss;
+
+		Entry& entry = m_Entries[acquisition.Slot];
+		entry = Entry{};
+		entry.ContentHash = contentHash;
+		m_Contents[contentHash] = acquisition.Slot;
+	}
+
+	// Path that pointed to other pixels is stale, the file changed since it was loaded
+	if (pathHash && acquisition.Status != Result::PathHit)
+	{
+		if (pathIt != m_Paths.end()) RemovePath(pathIt->second, pathHash);
+		AddPath(acquisition.Slot, pathHash);
+	}
+
+	m_Entries[acquisition.Slot].References++;
+	m_Statistics.Add(acquisition.Status);
+	return acquisition;
+}
+
+bool TextureRegistry::Release(uint32_t slot)
+{
+	if (slot >= m_Entries.size() || m_Entries[slot].References == 0)
+	{
+		ASSERT(0, "[TextureRegistry] Released a texture that isn't acquired.");
+		return false;
+	}
+
+	Entry& entry = m_Entries[slot];
+	if (--entry.References > 0) return false;
+
+	for (uint64_t pathHash : entry.Paths) m_Paths.erase(pathHash);
+	m_Contents.erase(entry.ContentHash);
+	entry = Entry{};
+
+	m_Slots.Release(slot);
+	return true;
+}
+
+void TextureRegistry::AddPath(uint32_t slot, uint64_t pathHash)
+{
+	m_Paths[pathHash] = slot;
+	m_Entries[slot].Paths.push_back(pathHash);
+}
+
+void TextureRegistry::RemovePath(uint32_t slot, uint64_t pathHash)
+{
+	std::vector<uint64_t>& paths = m_Entries[slot].Paths;
+	paths.erase(std::remove(paths.begin(), paths.end(), pathHash), paths.end());
+	m_Paths.erase(pathHash);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <Engine/Common.h>
+#include <Engine/Utility/MemoryStrategies.h>
+
+// Bindless slots of the scene textures, a texture is shared by every material, render group and scene that uses the same image
+// Textures are found by the hash of the normalized source path and by the hash of the pixels, so a copy of an image under another name is shared too
+// Doesn't depend on D3D12, the registry only hands out the slots and counts the references, the owner creates and deletes the textures
+class TextureRegistry
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = ~0u;
+
+	enum class Result : uint8_t
+	{
+		PathHit,
+		ContentHit,
+		Miss,
+		Full,
+	};
+
+	struct Acquisition
+	{
+		uint32_t Slot = INVALID_SLOT;
+		Result Status = Result::Full;
+	};
+
+	struct Statistics
+	{
+		uint32_t NumPathHits = 0;
+		uint32_t NumContentHits = 0;
+		uint32_t NumMisses = 0;
+
+		void Add(Result result);
+	};
+
+	TextureRegistry(uint32_t maxSlots);
+
+	// Path hash is 0 if the texture doesn't come from a file, it's then only found by its pixels
+	// Path that points to different pixels than before is moved to the new texture
+	// Miss means that the owner has to create the texture in the slot, every acquisition that got a slot has to be released
+	Acquisition Acquire(uint64_t pathHash, uint64_t contentHash);
+
+	// Returns true if it was the last reference, the owner deletes the texture and the slot is reused
+	bool Release(uint32_t slot);
+
+	uint32_t GetNumTextures() const { return (uint32_t) m_Contents.size(); }
+	uint32_t GetNumReferences(uint32_t slot) const { return slot < m_Entries.size() ? m_Entries[slot].References : 0; }
+
+	// All acquisitions since the registry was created
+	const Statistics& GetStatistics() const { return m_Statistics; }
+
+private:
+	struct Entry
+	{
+		uint64_t ContentHash = 0;
+		uint32_t References = 0;
+		std::vector<uint64_t> Paths;
+	};
+
+	void AddPath(uint32_t slot, uint64_t pathHash);
+	void RemovePath(uint32_t slot, uint64_t pathHash);
+
+private:
+	ElementStrategy m_Slots;
+	std::vector<Entry> m_Entries;
+
+	std::unordered_map<uint64_t, uint32_t> m_Paths;
+	std::unordered_map<uint64_t, uint32_t> m_Contents;
+
+	Statistics m_Statistics;
+};
@@ -1,40 +1,42 @@
-#include "full_screen.h"
+#include "shared_definitions.h"
+#include "samplers.h"
 
-struct BloomInput
+// Single pass bloom downsampler
+// Every group prefilters one BLOOM_TILE_SIZE tile of the level 0 and reduces it down to the last level
+// Levels are halved with the box filter so the whole chain of the tile stays inside the group
+// Must match BloomFilter::GenerateReference
+
+cbuffer PushConstants : register(b128)
 {
-    float4 SampleScale;
-    float2 TexelSize;
-    float2 Padding;
+    uint BloomWidth;
+    uint BloomHeight;
+    float2 InputTexelSize;
     float Treshold;
     float Knee;
-    float2 Padding2;
-};
-
-cbuffer Constants : register(b0)
-{
-    BloomInput BloomIN;
     float Exposure;
 }
 
-SamplerState s_LinearBorder : register(s2);
+Texture2D<float4> InputTexture : register(t0);
+RWTexture2D<float4> BloomChain[BLOOM_NUM_LEVELS] : register(u0);
 
-VS_IMPL;
+static const float EPSILON = 0.0001f;
+static const float4 EMISSIVE_CLAMP = 20.0f;
 
 float4 DownsampleBox(Texture2D tex, SamplerState samplerTex, float2 uv, float2 texelSize)
 {
-    float4 A = tex.Sample(samplerTex, uv + texelSize * float2(-1.0, -1.0));
-    float4 B = tex.Sample(samplerTex, uv + texelSize * float2(0.0, -1.0));
-    float4 C = tex.Sample(samplerTex, uv + texelSize * float2(1.0, -1.0));
-    float4 D = tex.Sample(samplerTex, uv + texelSize * float2(-0.5, -0.5));
-    float4 E = tex.Sample(samplerTex, uv + texelSize * float2(0.5, -0.5));
-    float4 F = tex.Sample(samplerTex, uv + texelSize * float2(-1.0, 0.0));
-    float4 G = tex.Sample(samplerTex, uv);
-    float4 H = tex.Sample(samplerTex, uv + texelSize * float2(1.0, 0.0));
-    float4 I = tex.Sample(samplerTex, uv + texelSize * float2(-0.5, 0.5));
-    float4 J = tex.Sample(samplerTex, uv + texelSize * float2(0.5, 0.5));
-    float4 K = tex.Sample(samplerTex, uv + texelSize * float2(-1.0, 1.0));
-    float4 L = tex.Sample(samplerTex, uv + texelSize * float2(0.0, 1.0));
-    float4 M = tex.Sample(samplerTex, uv + texelSize * float2(1.0, 1.0));
+    float4 A = tex.SampleLevel(samplerTex, uv + texelSize * float2(-1.0, -1.0), 0);
+    float4 B = tex.SampleLevel(samplerTex, uv + texelSize * float2(0.0, -1.0), 0);
+    float4 C = tex.SampleLevel(samplerTex, uv + texelSize * float2(1.0, -1.0), 0);
+    float4 D = tex.SampleLevel(samplerTex, uv + texelSize * float2(-0.5, -0.5), 0);
+    float4 E = tex.SampleLevel(samplerTex, uv + texelSize * float2(0.5, -0.5), 0);
+    float4 F = tex.SampleLevel(samplerTex, uv + texelSize * float2(-1.0, 0.0), 0);
+    float4 G = tex.SampleLevel(samplerTex, uv, 0);
+    float4 H = tex.SampleLevel(samplerTex, uv + texelSize * float2(1.0, 0.0), 0);
+    float4 I = tex.SampleLevel(samplerTex, uv + texelSize * float2(-0.5, 0.5), 0);
+    float4 J = tex.SampleLevel(samplerTex, uv + texelSize * float2(0.5, 0.5), 0);
+    float4 K = tex.SampleLevel(samplerTex, uv + texelSize * float2(-1.0, 1.0), 0);
+    float4 L = tex.SampleLevel(samplerTex, uv + texelSize * float2(0.0, 1.0), 0);
+    float4 M = tex.SampleLevel(samplerTex, uv + texelSize * float2(1.0, 1.0), 0);
 
     float2 div = (1.0 / 4.0) * float2(0.5, 0.125);
 
@@ -47,32 +49,6 @@ float4 DownsampleBox(Texture2D tex, SamplerState samplerTex, float2 uv, float2 t
     return o;
 }
 
-float4 UpsampleTent(Texture2D tex, SamplerState samplerTex, float2 uv, float2 texelSize, float4 sampleScale)
-{
-    float4 d = texelSize.xyxy * float4(1.0, 1.0, -1.0, 0.0) * sampleScale;
-
-    float4 s;
-    s =  tex.Sample(samplerTex, uv - d.xy);
-    s += tex.Sample(samplerTex, uv - d.wy) * 2.0;
-    s += tex.Sample(samplerTex, uv - d.zy);
-    s += tex.Sample(samplerTex, uv + d.zw) * 2.0;
-    s += tex.Sample(samplerTex, uv) * 4.0;
-    s += tex.Sample(samplerTex, uv + d.xw) * 2.0;
-    s += tex.Sample(samplerTex, uv + d.zy);
-    s += tex.Sample(samplerTex, uv + d.wy) * 2.0;
-    s += tex.Sample(samplerTex, uv + d.xy);
-
-    return s * (1.0 / 16.0);
-}
-
-static const float EPSILON = 0.0001f;
-
-#ifdef PREFILTER
-
-static const float4 EMISSIVE_CLAMP = 20.0f;
-
-Texture2D<float4> inputTexture : register(t0);
-
 float4 QuadraticThreshold(float4 color, float threshold, float3 curve)
 {
     // Pixel brightness
@@ -88,41 +64,79 @@ float4 QuadraticThreshold(float4 color, float threshold, float3 curve)
     return color;
 }
 
-float4 PS(FCVertex IN) : SV_Target
+float4 Prefilter(uint2 texel)
 {
-    const float knee = BloomIN.Knee;
-    const float3 curve = float3(BloomIN.Treshold - knee, 2.0f * knee, 0.25f / knee);
+    const float3 curve = float3(Treshold - Knee, 2.0f * Knee, 0.25f / Knee);
+    const float2 uv = (float2(texel) + 0.5f) / float2(BloomWidth, BloomHeight);
 
-    float4 color = DownsampleBox(inputTexture, s_LinearBorder, IN.uv, BloomIN.TexelSize);
+    float4 color = DownsampleBox(InputTexture, s_LinearBorder, uv, InputTexelSize);
     color *= Exposure;
     color = min(EMISSIVE_CLAMP, color);
-    color = QuadraticThreshold(color, BloomIN.Treshold, curve);
+    color = QuadraticThreshold(color, Treshold, curve);
     return color;
 }
 
-#endif // PREFILTER
-
-#ifdef DOWNSAMPLE
-
-Texture2D<float4> inputTexture : register(t0);
-
-float4 PS(FCVertex IN) : SV_Target
+void StoreTexel(uint level, uint2 texel, float4 value)
 {
-    return DownsampleBox(inputTexture, s_LinearBorder, IN.uv, BloomIN.TexelSize);
+    if (texel.x < (BloomWidth >> level) && texel.y < (BloomHeight >> level))
+    {
+        BloomChain[level][texel] = value;
+    }
 }
 
-#endif // DOWNSAMPLE
+// Every thread starts with 2x2 texels of the level 0, so the tile of the level 1 is the size of the group
+#define BLOOM_GROUP_SIZE (BLOOM_TILE_SIZE / 2)
 
-#ifdef UPSAMPLE
+groupshared float4 ReductionTile[BLOOM_GROUP_SIZE][BLOOM_GROUP_SIZE];
 
-Texture2D<float4> lowRes : register(t0);
-Texture2D<float4> highRes : register(t1);
-
-float4 PS(FCVertex IN) : SV_Target
+[numthreads(BLOOM_GROUP_SIZE, BLOOM_GROUP_SIZE, 1)]
+void CS(uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID)
 {
-    const float4 bloom = UpsampleTent(lowRes, s_LinearBorder, IN.uv, BloomIN.TexelSize, BloomIN.SampleScale);
-    const float4 color = highRes.Sample(s_LinearBorder, IN.uv);
-    return bloom + color;
+    const uint2 localCoord = groupThreadID.xy;
+
+    // Level 0 and 1
+    float4 value = 0.0f;
+    {
+        const uint2 texel = groupID.xy * BLOOM_GROUP_SIZE + localCoord;
+        for (uint i = 0; i < 4; i++)
+        {
+            const uint2 childTexel = 2 * texel + uint2(i & 1, i >> 1);
+            const float4 childValue = Prefilter(childTexel);
+            StoreTexel(0, childTexel, childValue);
+            value += childValue;
+        }
+        value *= 0.25f;
+
+        StoreTexel(1, texel, value);
+        ReductionTile[localCoord.y][localCoord.x] = value;
+    }
+
+    // Rest of the chain, every level reads the previous one from the groupshared memory
+    [unroll]
+    for (uint level = 2; level < BLOOM_NUM_LEVELS; level++)
+    {
+        const uint levelTileSize = BLOOM_TILE_SIZE >> level;
+        const bool active = localCoord.x < levelTileSize && localCoord.y < levelTileSize;
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (active)
+        {
+            const uint2 child = 2 * localCoord;
+            value = ReductionTile[child.y][child.x];
+            value += ReductionTile[child.y][child.x + 1];
+            value += ReductionTile[child.y + 1][child.x];
+            value += ReductionTile[child.y + 1][child.x + 1];
+            value *= 0.25f;
+        }
+
+        // Reduction is done in place
+        GroupMemoryBarrierWithGroupSync();
+
+        if (active)
+        {
+            ReductionTile[localCoord.y][localCoord.x] = value;
+            StoreTexel(level, groupID.xy * levelTileSize + localCoord, value);
+        }
+    }
 }
-
-#endif // UPSAMPLE
\ No newline at end of file
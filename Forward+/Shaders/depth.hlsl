@@ -1,6 +1,7 @@
 #include "scene.h"
 #include "util.h"
 #include "pipeline.h"
+#include "samplers.h"
 
 struct VertexOut
 {
@@ -26,8 +27,6 @@ cbuffer Constants : register(b0)
 #endif // SHADOWMAP
 }
 
-SamplerState s_AnisoWrap : register(s0);
-
 #ifdef MOTION_VECTORS
 
 float2 CalculateMotionVector(float4 newPosition, float4 oldPosition, float2 screenSize)
@@ -67,38 +67,164 @@ void CS(uint3 threadID : SV_DispatchThreadID)
 
 #ifdef GENERATE_HZB
 
+// Single pass downsampler
+// Every group reduces one HZB_TILE_SIZE tile of the mip 0 down to the HZB_GROUP_MIPS
+// Last group to finish fixes the right and bottom edges and reduces the rest of the chain
+// Must match HZBReduction::GenerateReference
+
 cbuffer PushConstants : register(b128)
 {
-	uint ReadMip;
-	uint WriteMip;
 	uint HzbWidth;
 	uint HzbHeight;
+	uint NumMips;
+	uint NumGroups;
 }
 
-Texture2D<float> HZB_IN : register(t0);
-RWTexture2D<float> HZB_OUT : register(u0);
+Texture2D<float> ReprojectedDepth : register(t0);
 
-SamplerState s_HZBSampler : register(s0);
+globallycoherent RWByteAddressBuffer GroupCounter : register(u0);
+globallycoherent RWTexture2D<float> HZB[HZB_MAX_MIPS] : register(u1);
 
-[numthreads(OPT_TILE_SIZE, OPT_TILE_SIZE, 1)]
-void CS(uint3 threadID : SV_DispatchThreadID)
+groupshared float gs_Depth[HZB_TILE_SIZE / 2][HZB_TILE_SIZE / 2];
+groupshared bool gs_IsLastGroup;
+
+uint2 GetMipSize(uint mip)
 {
-	const uint2 texCoords = threadID.xy;
-	const uint2 writeDims = uint2(HzbWidth >> WriteMip, HzbHeight >> WriteMip);
-	if (texCoords.x >= writeDims.x || texCoords.y >= writeDims.y)
+	return max(uint2(HzbWidth, HzbHeight) >> mip, 1u);
+}
+
+// Last texel in the row or column also covers the odd texel of the previous mip
+float ReduceTexel(uint mip, uint2 coord)
+{
+	const uint2 mipSize = GetMipSize(mip);
+	const uint2 prevMipSize = GetMipSize(mip - 1);
+
+	const uint2 first = 2 * coord;
+	uint2 last;
+	last.x = coord.x == mipSize.x - 1 ? prevMipSize.x - 1 : min(2 * coord.x + 1, prevMipSize.x - 1);
+	last.y = coord.y == mipSize.y - 1 ? prevMipSize.y - 1 : min(2 * coord.y + 1, prevMipSize.y - 1);
+
+	float maxDepth = 0.0f;
+	for (uint y = first.y; y <= last.y; y++)
+	{
+		for (uint x = first.x; x <= last.x; x++)
+		{
+			maxDepth = max(maxDepth, HZB[mip - 1][uint2(x, y)]);
+		}
+	}
+	return maxDepth;
+}
+
+[numthreads(HZB_GROUP_THREADS, 1, 1)]
+void CS(uint3 groupID : SV_GroupID, uint threadIndex : SV_GroupIndex)
+{
+	const uint2 tileOrigin = groupID.xy * HZB_TILE_SIZE;
+	const uint2 mip0Size = GetMipSize(0);
+	const uint2 mip1Size = GetMipSize(1);
+
+	// Mip 0 is a copy of the reprojected depth, mip 1 is reduced in the registers
+	[unroll]
+	for (uint i = 0; i < 4; i++)
+	{
+		const uint quadIndex = threadIndex + i * HZB_GROUP_THREADS;
+		const uint2 localCoord = uint2(quadIndex % (HZB_TILE_SIZE / 2), quadIndex / (HZB_TILE_SIZE / 2));
+
+		float maxDepth = 0.0f;
+		[unroll]
+		for (uint q = 0; q < 4; q++)
+		{
+			const uint2 coord = tileOrigin + 2 * localCoord + uint2(q & 1, q >> 1);
+			if (all(coord < mip0Size))
+			{
+				const float depth = ReprojectedDepth[coord];
+				HZB[0][coord] = depth;
+				maxDepth = max(maxDepth, depth);
+			}
+		}
+
+		gs_Depth[localCoord.y][localCoord.x] = maxDepth;
+
+		const uint2 mip1Coord = tileOrigin / 2 + localCoord;
+		if (NumMips > 1 && all(mip1Coord < mip1Size)) HZB[1][mip1Coord] = maxDepth;
+	}
+
+	[unroll]
+	for (uint mip = 2; mip <= HZB_GROUP_MIPS; mip++)
+	{
+		const uint mipTileSize = HZB_TILE_SIZE >> mip;
+		const uint2 localCoord = uint2(threadIndex % mipTileSize, threadIndex / mipTileSize);
+		const bool isActive = threadIndex < mipTileSize * mipTileSize;
+
+		GroupMemoryBarrierWithGroupSync();
+
+		float maxDepth = 0.0f;
+		if (isActive)
+		{
+			const uint2 readCoord = 2 * localCoord;
+			maxDepth = max(max(gs_Depth[readCoord.y][readCoord.x], gs_Depth[readCoord.y][readCoord.x + 1]), max(gs_Depth[readCoord.y + 1][readCoord.x], gs_Depth[readCoord.y + 1][readCoord.x + 1]));
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+
+		if (isActive)
+		{
+			gs_Depth[localCoord.y][localCoord.x] = maxDepth;
+
+			const uint2 mipCoord = groupID.xy * mipTileSize + localCoord;
+			if (mip < NumMips && all(mipCoord < GetMipSize(mip))) HZB[mip][mipCoord] = maxDepth;
+		}
+	}
+
+	// Make the writes visible before signaling that this group is done
+	DeviceMemoryBarrierWithGroupSync();
+
+	if (threadIndex == 0)
+	{
+		uint finishedGroups;
+		GroupCounter.InterlockedAdd(0, 1, finishedGroups);
+		gs_IsLastGroup = finishedGroups == NumGroups - 1;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (!gs_IsLastGroup)
 		return;
 
-	const float offset = 0.5f / writeDims.x;
-	const float2 readUV = texCoords / float2(writeDims);
-	float maxValue = 0.0f;
-	
-	// Doing this four times since our Depth is not power of two so it can happen to miss some values when reducing size
-	maxValue = max(maxValue, HZB_IN.SampleLevel(s_HZBSampler, readUV + float2(-offset, -offset), ReadMip));
-	maxValue = max(maxValue, HZB_IN.SampleLevel(s_HZBSampler, readUV + float2(offset, -offset), ReadMip));
-	maxValue = max(maxValue, HZB_IN.SampleLevel(s_HZBSampler, readUV + float2(-offset, offset), ReadMip));
-	maxValue = max(maxValue, HZB_IN.SampleLevel(s_HZBSampler, readUV + float2(offset, offset), ReadMip));
-
-	HZB_OUT[texCoords] = maxValue;
+	// Ready for the next frame
+	if (threadIndex == 0) GroupCounter.Store(0, 0);
+
+	// Edge texels can depend on the neighbour tile when the size of the previous mip is odd
+	[unroll]
+	for (uint edgeMip = 1; edgeMip <= HZB_GROUP_MIPS; edgeMip++)
+	{
+		if (edgeMip < NumMips)
+		{
+			const uint2 mipSize = GetMipSize(edgeMip);
+			const uint numEdgeTexels = mipSize.x + mipSize.y - 1;
+			for (uint i = threadIndex; i < numEdgeTexels; i += HZB_GROUP_THREADS)
+			{
+				const uint2 coord = i < mipSize.y ? uint2(mipSize.x - 1, i) : uint2(i - mipSize.y, mipSize.y - 1);
+				HZB[edgeMip][coord] = ReduceTexel(edgeMip, coord);
+			}
+		}
+		DeviceMemoryBarrierWithGroupSync();
+	}
+
+	// Rest of the chain is small enough for one group
+	[unroll]
+	for (uint tailMip = HZB_GROUP_MIPS + 1; tailMip < HZB_MAX_MIPS; tailMip++)
+	{
+		if (tailMip < NumMips)
+		{
+			const uint2 mipSize = GetMipSize(tailMip);
+			for (uint i = threadIndex; i < mipSize.x * mipSize.y; i += HZB_GROUP_THREADS)
+			{
+				const uint2 coord = uint2(i % mipSize.x, i / mipSize.x);
+				HZB[tailMip][coord] = ReduceTexel(tailMip, coord);
+			}
+		}
+		DeviceMemoryBarrierWithGroupSync();
+	}
 }
 
 #endif // GENERATE_HZB
\ No newline at end of file
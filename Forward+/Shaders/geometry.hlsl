@@ -3,6 +3,7 @@
 #include "light_culling.h"
 #include "util.h"
 #include "pipeline.h"
+#include "samplers.h"
 
 struct VertexOut
 {
@@ -19,16 +20,17 @@ cbuffer Constants : register(b0)
 {
 	Camera MainCamera;
 	SceneInfo SceneInfoData;
+	float4 IrradianceSH[9];
 }
 
-SamplerState s_AnisoWrap : register(s0);
-SamplerState s_LinearWrap : register(s1);
-
 StructuredBuffer<Light> Lights : register(t0);
 StructuredBuffer<uint> VisibleLights : register(t1);
 Texture2D<float> Shadowmask : register(t2);
-TextureCube IrradianceMap : register(t3);
+TextureCube SpecularIBL : register(t3);
 Texture2D<float> AmbientOcclusion : register(t4);
+Texture2D<float> ShadowAtlas : register(t5);
+StructuredBuffer<LocalShadow> LocalShadows : register(t6);
+Texture2D<float2> BRDFLut : register(t7);
 
 VertexOut VS(VertexPipelineInput IN)
 {
@@ -46,6 +48,40 @@ VertexOut VS(VertexPipelineInput IN)
 	return OUT;
 }
 
+// Order must match the ShadowRenderer: +X, -X, +Y, -Y, +Z, -Z
+uint GetCubeFaceIndex(float3 direction)
+{
+	const float3 absDirection = abs(direction);
+	if (absDirection.x >= absDirection.y && absDirection.x >= absDirection.z) return direction.x > 0.0f ? 0 : 1;
+	if (absDirection.y >= absDirection.z) return direction.y > 0.0f ? 2 : 3;
+	return direction.z > 0.0f ? 4 : 5;
+}
+
+float CalculateLocalShadowFactor(Light light, float3 worldPosition)
+{
+	if (light.ShadowIndex == INVALID_SHADOW_INDEX) return 1.0f;
+
+	const LocalShadow shadow = LocalShadows[light.ShadowIndex];
+	const uint faceIndex = shadow.NumFaces == 1 ? 0 : GetCubeFaceIndex(worldPosition - light.Position);
+
+	const float4 clipPosition = mul(float4(worldPosition, 1.0f), shadow.WorldToClip[faceIndex]);
+	if (clipPosition.w <= 0.0f) return 1.0f;
+
+	const float2 faceUV = GetUVFromClipPosition(clipPosition);
+	if (any(faceUV < 0.0f) || any(faceUV > 1.0f)) return 1.0f;
+
+	// Load instead of sample so we don't filter with the neighbour tiles
+	uint atlasWidth, atlasHeight;
+	ShadowAtlas.GetDimensions(atlasWidth, atlasHeight);
+	const float4 atlasRect = shadow.AtlasRect[faceIndex];
+	const float2 atlasUV = atlasRect.xy + faceUV * atlasRect.zw;
+	const uint3 atlasCoord = uint3(atlasUV * float2(atlasWidth, atlasHeight), 0);
+
+	const float depthBias = 0.0005f;
+	const float shadowmapDepth = ShadowAtlas.Load(atlasCoord) + depthBias;
+	return GetDepthFromClipPosition(clipPosition) > shadowmapDepth ? 0.0f : 1.0f;
+}
+
 float3 ApplyFog(float3 color, float depth, float3 fogColor)
 {
 	const float FogStart = 0.99f;
@@ -82,7 +118,11 @@ float4 PS(VertexOut IN) : SV_TARGET
 	mat.AO = AmbientOcclusion.Sample(s_LinearWrap, screenUV);
 
 	const float3x3 TBN = float3x3(normalize(IN.Tangent), normalize(IN.Bitangent), normalize(IN.Normal));
-	const float3 normalValue = 2.0f * Textures[matParams.Normal].Sample(s_LinearWrap, IN.UV).rgb - 1.0f;
+
+	// Normal textures are stored as BC5, Z is reconstructed from X and Y
+	float3 normalValue;
+	normalValue.xy = 2.0f * Textures[matParams.Normal].Sample(s_LinearWrap, IN.UV).rg - 1.0f;
+	normalValue.z = sqrt(saturate(1.0f - dot(normalValue.xy, normalValue.xy)));
 
 	const float3 normal = normalize(mul(normalValue, TBN));
 	const float3 view = normalize(MainCamera.Position - IN.WorldPosition);
@@ -93,7 +133,8 @@ float4 PS(VertexOut IN) : SV_TARGET
 	[loop]
 	for (uint i = 0; i < SceneInfoData.NumLights; i++)
 	{
-		litColor.rgb += ComputeLightEffect(Lights[i], mat, IN.WorldPosition, normal, view);
+		const Light light = Lights[i];
+		litColor.rgb += CalculateLocalShadowFactor(light, IN.WorldPosition) * ComputeLightEffect(light, mat, IN.WorldPosition, normal, view);
 	}
 #else
 	const uint2 tileIndex = GetTileIndexFromPosition(IN.Position.xyz);
@@ -102,13 +143,14 @@ float4 PS(VertexOut IN) : SV_TARGET
 	[loop]
 	for (uint i = visibleLightOffset; VisibleLights[i] != VISIBLE_LIGHT_END; i++)
 	{
-		litColor.rgb += ComputeLightEffect(Lights[VisibleLights[i]], mat, IN.WorldPosition, normal, view);
+		const Light light = Lights[VisibleLights[i]];
+		litColor.rgb += CalculateLocalShadowFactor(light, IN.WorldPosition) * ComputeLightEffect(light, mat, IN.WorldPosition, normal, view);
 	}
 #endif // DISABLE_LIGHT_CULLING
 
 #ifdef USE_IBL
-	const float3 fogColor = IrradianceMap.Sample(s_LinearWrap, SceneInfoData.DirLight.Direction).rgb;
-	const float3 ambientIrradiance = IrradianceMap.Sample(s_LinearWrap, normal).rgb;
+	const float3 fogColor = EvaluateIrradianceSH(IrradianceSH, SceneInfoData.DirLight.Direction);
+	const float3 ambientIrradiance = EvaluateIrradianceSH(IrradianceSH, normal);
 #else
 	const float3 fogColor = float3(0.6f, 0.67f, 0.73f);
 	const float3 ambientIrradiance = SceneInfoData.AmbientRadiance;
@@ -122,6 +164,14 @@ float4 PS(VertexOut IN) : SV_TARGET
 	// Ambient
 	litColor.rgb += ComputeAmbientEffect(ambientIrradiance, mat, normal, view);
 
+#ifdef USE_IBL
+	uint specularWidth, specularHeight, specularNumMips;
+	SpecularIBL.GetDimensions(0, specularWidth, specularHeight, specularNumMips);
+	const float3 prefilteredRadiance = SpecularIBL.SampleLevel(s_LinearClamp, reflect(-view, normal), mat.Roughness * (specularNumMips - 1)).rgb;
+	const float2 environmentBRDF = BRDFLut.SampleLevel(s_LinearClamp, float2(max(dot(normal, view), 0.0f), mat.Roughness), 0);
+	litColor.rgb += ComputeAmbientSpecular(prefilteredRadiance, environmentBRDF, mat, normal, view);
+#endif // USE_IBL
+
 	// Distance fog
 	litColor.rgb = ApplyFog(litColor.rgb, IN.Position.z / IN.Position.w, fogColor);
 
@@ -133,6 +133,21 @@ float3 ComputeDirectionalEffect(DirectionalLight light, MaterialInput mat, float
 	return LIGHT_FUNCTION(radiance, toLight, normal, toEye, mat) * mat.AO;
 }
 
+// Irradiance (divided by PI) from 9 SH coefficients, basis must match SphericalHarmonics.cpp
+float3 EvaluateIrradianceSH(float4 sh[9], float3 n)
+{
+	float3 irradiance = sh[0].rgb * 0.282095f;
+	irradiance += sh[1].rgb * 0.488603f * n.y;
+	irradiance += sh[2].rgb * 0.488603f * n.z;
+	irradiance += sh[3].rgb * 0.488603f * n.x;
+	irradiance += sh[4].rgb * 1.092548f * n.x * n.y;
+	irradiance += sh[5].rgb * 1.092548f * n.y * n.z;
+	irradiance += sh[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+	irradiance += sh[7].rgb * 1.092548f * n.x * n.z;
+	irradiance += sh[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(irradiance, 0.0f);
+}
+
 float3 ComputeAmbientEffect(float3 radiance, MaterialInput mat, float3 normal, float3 view)
 {
 #ifdef USE_IBL
@@ -146,4 +161,11 @@ float3 ComputeAmbientEffect(float3 radiance, MaterialInput mat, float3 normal, f
 #endif
 }
 
+// Split sum approximation, prefiltered radiance and BRDF LUT are baked by the IBLBaker
+float3 ComputeAmbientSpecular(float3 prefilteredRadiance, float2 environmentBRDF, MaterialInput mat, float3 normal, float3 view)
+{
+	const float3 specularFactor = FresnelSchlickRoughness(mat.F0, max(dot(normal, view), 0.0), mat.Roughness);
+	return prefilteredRadiance * (specularFactor * environmentBRDF.x + environmentBRDF.y) * mat.AO;
+}
+
 #endif // LIGHTING_H
\ No newline at end of file
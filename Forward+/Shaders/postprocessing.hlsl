@@ -27,18 +27,55 @@ float4 PS(FCVertex IN) : SV_Target
 
 cbuffer Constants : register(b0)
 {
+	float4 BloomSampleScale;
 	float Exposure;
 }
 
 Texture2D HDRTexture : register(t0);
-Texture2D BloomTexture : register(t1);
+Texture2D BloomChain : register(t1);
+
+SamplerState s_LinearBorder : register(s2);
+
+float4 UpsampleTent(Texture2D tex, SamplerState samplerTex, float2 uv, uint level, float2 texelSize, float4 sampleScale)
+{
+	float4 d = texelSize.xyxy * float4(1.0, 1.0, -1.0, 0.0) * sampleScale;
+
+	float4 s;
+	s =  tex.SampleLevel(samplerTex, uv - d.xy, level);
+	s += tex.SampleLevel(samplerTex, uv - d.wy, level) * 2.0;
+	s += tex.SampleLevel(samplerTex, uv - d.zy, level);
+	s += tex.SampleLevel(samplerTex, uv + d.zw, level) * 2.0;
+	s += tex.SampleLevel(samplerTex, uv, level) * 4.0;
+	s += tex.SampleLevel(samplerTex, uv + d.xw, level) * 2.0;
+	s += tex.SampleLevel(samplerTex, uv + d.zy, level);
+	s += tex.SampleLevel(samplerTex, uv + d.wy, level) * 2.0;
+	s += tex.SampleLevel(samplerTex, uv + d.xy, level);
+
+	return s * (1.0 / 16.0);
+}
+
+// Upsample of the whole chain fused in the composite, every level is tent filtered straight to the screen and summed
+// Must match BloomFilter::ComposeReference
+float3 ComposeBloom(float2 uv)
+{
+	uint width, height, numLevels;
+	BloomChain.GetDimensions(0, width, height, numLevels);
+
+	float3 bloom = 0.0f;
+	for (uint level = 0; level < numLevels; level++)
+	{
+		BloomChain.GetDimensions(level, width, height, numLevels);
+		bloom += UpsampleTent(BloomChain, s_LinearBorder, uv, level, 1.0f / float2(width, height), BloomSampleScale).rgb;
+	}
+	return bloom;
+}
 
 float4 PS(FCVertex IN) : SV_Target
 {
 	float3 hdrColor = HDRTexture.Sample(s_LinearWrap, IN.uv).rgb;
 	
 #ifdef APPLY_BLOOM
-	hdrColor += BloomTexture.Sample(s_LinearWrap, IN.uv).rgb;
+	hdrColor += ComposeBloom(IN.uv);
 #endif // APPLY_BLOOM
 
 	float3 color = float3(1.0f, 1.0f, 1.0f) - exp(-hdrColor * Exposure);
@@ -0,0 +1,12 @@
+#ifndef SAMPLERS_H
+#define SAMPLERS_H
+
+// Static samplers of every root signature, registers are STATIC_SAMPLER_REGISTER + StaticSampler in Engine/Render/SignatureCache.h
+SamplerState s_PointClamp : register(s100);
+SamplerState s_PointWrap : register(s101);
+SamplerState s_LinearClamp : register(s102);
+SamplerState s_LinearWrap : register(s103);
+SamplerState s_LinearBorder : register(s104);
+SamplerState s_AnisoWrap : register(s105);
+
+#endif // SAMPLERS_H
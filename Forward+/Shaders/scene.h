@@ -88,6 +88,19 @@ struct Light
 	// Spot only
 	float3 Direction;
 	float SpotPower;
+
+	uint ShadowIndex;	// INVALID_SHADOW_INDEX if light doesn't cast shadows
+};
+
+#define INVALID_SHADOW_INDEX 0xffffffff
+#define LOCAL_SHADOW_MAX_FACES 6
+
+struct LocalShadow
+{
+	float4x4 WorldToClip[LOCAL_SHADOW_MAX_FACES];
+	float4 AtlasRect[LOCAL_SHADOW_MAX_FACES];	// (x, y, size, size) in atlas UV space
+	uint NumFaces;								// 6 cube faces, spot lights are shadowed like point lights
+	float3 Padding;
 };
 
 #endif // SCENE_H
\ No newline at end of file
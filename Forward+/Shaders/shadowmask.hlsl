@@ -1,6 +1,7 @@
 #include "scene.h"
 #include "util.h"
 #include "full_screen.h"
+#include "samplers.h"
 
 VS_IMPL;
 
@@ -11,8 +12,6 @@ cbuffer Constants : register(b0)
 	SceneInfo SceneInfoData;
 }
 
-SamplerState s_LinearWrap : register(s0);
-
 Texture2D<float> DepthTexture : register(t0);
 Texture2D<float> Shadowmap : register(t1);
 
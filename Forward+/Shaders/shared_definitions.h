@@ -12,6 +12,16 @@
 // SSAO
 #define SSAO_KERNEL_SIZE 64
 
+// HZB
+#define HZB_TILE_SIZE 64u // Mip 0 tile reduced by one group
+#define HZB_GROUP_THREADS 256u
+#define HZB_GROUP_MIPS 6u // log2(HZB_TILE_SIZE)
+#define HZB_MAX_MIPS 14u
+
+// Bloom
+#define BLOOM_TILE_SIZE 32u // Level 0 tile downsampled by one group
+#define BLOOM_NUM_LEVELS 5u // Must not exceed log2(BLOOM_TILE_SIZE) + 1
+
 // General
 #define OPT_COMP_TG_SIZE 128 // Must be divisible by 32
 #define OPT_TILE_SIZE 32u
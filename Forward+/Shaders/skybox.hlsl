@@ -1,4 +1,5 @@
 #include "scene.h"
+#include "samplers.h"
 
 struct VertexInput
 {
@@ -16,7 +17,6 @@ cbuffer Constants : register(b0)
 	Camera CamData;
 }
 
-SamplerState s_LinearWrap : register(s0);
 TextureCube SkyboxTexture : register(t0);
 
 VertexOut VS(VertexInput IN)
@@ -31,5 +31,6 @@ VertexOut VS(VertexInput IN)
 
 float4 PS(VertexOut IN) : SV_Target
 {
-	return SkyboxTexture.Sample(s_LinearWrap, IN.SkyRay);
+	// Lower mips are prefiltered for the specular IBL
+	return SkyboxTexture.SampleLevel(s_LinearWrap, IN.SkyRay, 0);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "shared_definitions.h"
 #include "util.h"
 #include "full_screen.h"
+#include "samplers.h"
 
 VS_IMPL;
 
@@ -14,8 +15,6 @@ struct SSAOSettings
     float Padding;
 };
 
-SamplerState s_PointClamp : register(s0);
-
 Texture2D<float4> NoiseTexture : register(t0);
 Texture2D<float> DepthTexture : register(t1);
 
@@ -90,7 +89,6 @@ cbuffer Constants : register(b0)
     uint2 ScreenSize;
 }
 
-SamplerState s_LinearBorder : register(s0);
 Texture2D<float> SampledSSAO : register(t0);
 
 float PS(FCVertex IN) : SV_Target
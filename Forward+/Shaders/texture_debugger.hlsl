@@ -1,6 +1,7 @@
 #ifdef TEXTURE_PREVIEW
 
 #include "full_screen.h"
+#include "samplers.h"
 
 VS_IMPL;
 
@@ -11,7 +12,6 @@ cbuffer Constants : register(b0)
 	uint SelectedMip;
 };
 
-SamplerState s_PointWrap : register(s0);
 Texture2D InputTexture : register(t0);
 
 float4 PS(FCVertex IN) : SV_Target
@@ -0,0 +1,332 @@
+// Packs the resource files into the asset archive that the application mounts at startup, every written archive is verified
+// Also verifies an existing archive or compares reading it against reading the loose files
+// Runs headless on Linux and Windows
+//
+// Usage, from the repository root:
+//   AssetPacker [--input <directory>]... [--output <path>] [--jobs <count>] [--root <directory>]
+//   AssetPacker --verify [--output <path>] [--jobs <count>] [--root <directory>]
+//   AssetPacker --benchmark [--input <directory>]... [--output <path>] [--jobs <count>] [--passes <count>] [--cold] [--root <directory>]
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <Engine/Loading/AssetArchive.h>
+#include <Engine/Utility/FileUtility.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class RunMode
+	{
+		Pack,
+		Verify,
+		Benchmark,
+	};
+
+	struct Options
+	{
+		RunMode Mode = RunMode::Pack;
+		std::vector<std::string> InputDirectories;
+		std::string OutputPath = AssetArchive::DEFAULT_PATH;
+		std::string RootDirectory = ".";
+		uint32_t NumJobs = std::max(std::thread::hardware_concurrency(), 1u);
+		uint32_t NumPasses = 3;
+
+		// Drops the files from the OS cache before every pass, so the benchmark reads from the disk
+		bool Cold = false;
+	};
+
+	// Directories packed when no input is given
+	const char* DefaultInputDirectories[] = {
+		"Resources",
+	};
+
+	struct BenchmarkResult
+	{
+		std::string Name;
+		uint64_t NumBytes = 0;
+		float BestTimeMS = 0.0f;
+	};
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string argument = argv[i];
+			const bool hasValue = i + 1 < argc;
+
+			if (argument == "--verify") options.Mode = RunMode::Verify;
+			else if (argument == "--benchmark") options.Mode = RunMode::Benchmark;
+			else if (argument == "--cold") options.Cold = true;
+			else if (argument == "--input" && hasValue) options.InputDirectories.push_back(argv[++i]);
+			else if (argument == "--output" && hasValue) options.OutputPath = argv[++i];
+			else if (argument == "--root" && hasValue) options.RootDirectory = argv[++i];
+			else if (argument == "--jobs" && hasValue) options.NumJobs = std::max(std::atoi(argv[++i]), 1);
+			else if (argument == "--passes" && hasValue) options.NumPasses = std::max(std::atoi(argv[++i]), 1);
+			else
+			{
+				std::cout << "Usage: AssetPacker [--verify | --benchmark] [--input <directory>]... [--output <path>] [--jobs <count>] [--passes <count>] [--cold] [--root <directory>]" << std::endl;
+				return false;
+			}
+		}
+
+		if (options.InputDirectories.empty()) options.InputDirectories.assign(std::begin(DefaultInputDirectories), std::end(DefaultInputDirectories));
+		return true;
+	}
+
+	// Names are the paths relative to the root, sorted so the files of a scene are next to each other in the archive
+	bool CollectFiles(const Options& options, std::vector<AssetArchive::SourceFile>& files)
+	{
+		const std::string outputName = AssetArchive::NormalizeName(options.OutputPath);
+		for (const std::string& directory : options.InputDirectories)
+		{
+			std::error_code error;
+			if (!std::filesystem::is_directory(directory, error))
+			{
+				std::cout << "Error: Can't open the input directory " << directory << std::endl;
+				return false;
+			}
+
+			for (const auto& file : std::filesystem::recursive_directory_iterator(directory, error))
+			{
+				if (!file.is_regular_file()) continue;
+
+				const std::string path = file.path().lexically_normal().generic_string();
+				if (AssetArchive::NormalizeName(path) != outputName) files.push_back(AssetArchive::SourceFile{ path, path });
+			}
+		}
+
+		std::sort(files.begin(), files.end(), [](const AssetArchive::SourceFile& a, const AssetArchive::SourceFile& b) { return a.Path < b.Path; });
+		return true;
+	}
+
+	float GetMegabytes(uint64_t numBytes)
+	{
+		return numBytes / (1024.0f * 1024.0f);
+	}
+
+	float GetElapsedMS(Clock::time_point startTime)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+	}
+
+	bool DropFileCache(const std::string& path)
+	{
+#ifdef _WIN32
+		return false;
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) return false;
+
+		// Only the clean pages are dropped
+		fdatasync(file);
+		const bool dropped = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(file);
+		return dropped;
+#endif
+	}
+
+	int Pack(const Options& options)
+	{
+		std::vector<AssetArchive::SourceFile> files;
+		if (!CollectFiles(options, files)) return 1;
+
+		std::cout << "Packing " << files.size() << " files on " << options.NumJobs << " threads" << std::endl;
+
+		const Clock::time_point startTime = Clock::now();
+		AssetArchive::PackStatistics statistics;
+		if (!AssetArchive::Pack(options.OutputPath, files, options.NumJobs, statistics))
+		{
+			std::cout << "Error: Failed to write the asset archive " << options.OutputPath << std::endl;
+			return 1;
+		}
+		const float packTimeMS = GetElapsedMS(startTime);
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << statistics.NumFiles << " files, " << GetMegabytes(statistics.Size) << " MB packed into " << GetMegabytes(statistics.StoredSize) << " MB in " << packTimeMS << " ms" << std::endl;
+		std::cout << statistics.NumStoredFiles << " files didn't compress and are stored as they are" << std::endl;
+
+		// Archive is read back the same way as the application reads it
+		AssetArchive::Archive archive;
+		if (!archive.Open(options.OutputPath) || !archive.Verify(options.NumJobs))
+		{
+			std::cout << "Error: Written asset archive " << options.OutputPath << " failed the verification" << std::endl;
+			return 1;
+		}
+
+		std::cout << "Asset archive written to " << options.OutputPath << std::endl;
+		return 0;
+	}
+
+	int Verify(const Options& options)
+	{
+		const Clock::time_point startTime = Clock::now();
+
+		AssetArchive::Archive archive;
+		if (!archive.Open(options.OutputPath))
+		{
+			std::cout << "Error: Can't open the asset archive " << options.OutputPath << std::endl;
+			return 1;
+		}
+
+		if (!archive.Verify(options.NumJobs))
+		{
+			std::cout << "Error: Asset archive " << options.OutputPath << " is corrupted" << std::endl;
+			return 1;
+		}
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << archive.GetEntries().size() << " files verified in " << GetElapsedMS(startTime) << " ms" << std::endl;
+		return 0;
+	}
+
+	int Benchmark(const Options& options)
+	{
+		std::vector<AssetArchive::SourceFile> files;
+		if (!CollectFiles(options, files)) return 1;
+
+		// Both sides read the same files in the same order, the order they were packed in
+		std::vector<AssetArchive::SourceFile> benchmarkFiles;
+		{
+			AssetArchive::Archive archive;
+			if (!archive.Open(options.OutputPath))
+			{
+				std::cout << "Error: Can't open the asset archive " << options.OutputPath << std::endl;
+				return 1;
+			}
+
+			for (const AssetArchive::SourceFile& file : files)
+			{
+				if (archive.Find(file.Name)) benchmarkFiles.push_back(file);
+				else std::cout << "Warning: " << file.Path << " isn't in the archive and isn't benchmarked" << std::endl;
+			}
+		}
+
+		if (options.Cold && !DropFileCache(options.OutputPath))
+		{
+			std::cout << "Warning: Files can't be dropped from the OS cache on this platform, the benchmark reads from the cache" << std::endl;
+		}
+
+		const auto dropCache = [&]
+		{
+			if (!options.Cold) return;
+			DropFileCache(options.OutputPath);
+			for (const AssetArchive::SourceFile& file : benchmarkFiles) DropFileCache(file.Path);
+		};
+
+		BenchmarkResult looseFiles{ "Loose files" };
+		BenchmarkResult archiveSingleThread{ "Archive, 1 thread" };
+		BenchmarkResult archiveThreads{ "Archive, " + std::to_string(options.NumJobs) + " threads" };
+
+		// Loose files are read the way the loaders read them without the archive, opened by the path and read into a new buffer
+		const auto readLooseFiles = [&](BenchmarkResult& result)
+		{
+			std::vector<uint8_t> content;
+			for (const AssetArchive::SourceFile& file : benchmarkFiles)
+			{
+				if (!FileUtility::ReadBinaryFile(file.Path, content)) return false;
+				result.NumBytes += content.size();
+			}
+			return true;
+		};
+
+		// Opening the archive is part of the time, same as mounting it at startup
+		// Files are read the way AssetArchive::AssetFile reads them, stored ones are checked and used in place and the rest is decompressed into a buffer
+		const auto readArchive = [&](BenchmarkResult& result, uint32_t numThreads)
+		{
+			AssetArchive::Archive archive;
+			if (!archive.Open(options.OutputPath)) return false;
+
+			std::vector<uint8_t> content;
+			for (const AssetArchive::SourceFile& file : benchmarkFiles)
+			{
+				const AssetArchive::Entry* entry = archive.Find(file.Name);
+				if (archive.IsStored(*entry))
+				{
+					if (!archive.GetStoredData(*entry, numThreads)) return false;
+				}
+				else
+				{
+					content.resize(entry->Size);
+					if (!archive.Read(*entry, content.data(), numThreads)) return false;
+				}
+				result.NumBytes += entry->Size;
+			}
+			return true;
+		};
+
+		const auto runPass = [&](BenchmarkResult& result, const auto& readFiles)
+		{
+			dropCache();
+			result.NumBytes = 0;
+
+			const Clock::time_point startTime = Clock::now();
+			if (!readFiles(result)) return false;
+
+			const float timeMS = GetElapsedMS(startTime);
+			result.BestTimeMS = result.BestTimeMS > 0.0f ? std::min(result.BestTimeMS, timeMS) : timeMS;
+			return true;
+		};
+
+		std::cout << "Reading " << benchmarkFiles.size() << " files, best of " << options.NumPasses << (options.Cold ? " passes from the disk" : " passes from the OS cache") << std::endl;
+		for (uint32_t pass = 0; pass < options.NumPasses; pass++)
+		{
+			const bool success =
+				runPass(looseFiles, readLooseFiles) &&
+				runPass(archiveSingleThread, [&](BenchmarkResult& result) { return readArchive(result, 1); }) &&
+				(options.NumJobs == 1 || runPass(archiveThreads, [&](BenchmarkResult& result) { return readArchive(result, options.NumJobs); }));
+
+			if (!success)
+			{
+				std::cout << "Error: Failed to read the files" << std::endl;
+				return 1;
+			}
+		}
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << std::left << std::setw(28) << "Source" << std::right << std::setw(12) << "MB" << std::setw(12) << "ms" << std::setw(12) << "MB/s" << std::endl;
+		for (const BenchmarkResult* result : { &looseFiles, &archiveSingleThread, &archiveThreads })
+		{
+			if (result->BestTimeMS == 0.0f) continue;
+
+			const float megabytes = GetMegabytes(result->NumBytes);
+			std::cout << std::left << std::setw(28) << result->Name << std::right << std::setw(12) << megabytes << std::setw(12) << result->BestTimeMS << std::setw(12) << megabytes * 1000.0f / std::max(result->BestTimeMS, 0.001f) << std::endl;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) return 2;
+
+	// Names in the archive are relative to the repository root, same as the working directory of the application
+	std::error_code error;
+	std::filesystem::current_path(options.RootDirectory, error);
+	if (error)
+	{
+		std::cout << "Error: Can't open the root directory " << options.RootDirectory << std::endl;
+		return 1;
+	}
+
+	switch (options.Mode)
+	{
+	case RunMode::Verify: return Verify(options);
+	case RunMode::Benchmark: return Benchmark(options);
+	default: return Pack(options);
+	}
+}
@@ -0,0 +1,382 @@
+// Compiles every declared shader implementation into the archive that the runtime loads instead of compiling
+// Runs headless on Linux and Windows, DXC is used through its command line executable
+//
+// Usage, from the repository root:
+//   ShaderPrecompiler [--dxc <path>] [--output <path>] [--jobs <count>] [--root <directory>]
+
+#include <map>
+#include <set>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+#include <Engine/Render/ShaderCache.h>
+#include <Engine/Render/ShaderManifest.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Forward+/Renderers/Util/ShaderDeclarations.h>
+
+using namespace GFX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Options
+	{
+		std::string DxcPath = "dxc";
+		std::string OutputPath = ShaderCache::Archive::DEFAULT_PATH;
+		std::string RootDirectory = ".";
+		uint32_t NumJobs = std::max(std::thread::hardware_concurrency(), 1u);
+	};
+
+	// One stage of one declared implementation
+	struct CompileJob
+	{
+		std::string Path;
+		std::string EntryPoint;
+		std::string TargetProfile;
+		std::vector<std::string> Defines;
+		ShaderCache::Key Key;
+
+		ShaderCache::Entry Result;
+		bool Success = false;
+		float CompileTimeMS = 0.0f;
+		std::string Log;
+	};
+
+	struct ShaderStatistics
+	{
+		uint32_t NumStages = 0;
+		float CompileTimeMS = 0.0f;
+		float SlowestStageMS = 0.0f;
+	};
+
+	// Same entry points and profiles as GFX::ShaderCompiler::CompileShader
+	struct StageDesc
+	{
+		uint32_t Stage;
+		const char* EntryPoint;
+		const char* TargetProfile;
+	};
+
+	constexpr StageDesc Stages[] = {
+		{ VS, "VS", "vs_6_0" },
+		{ GS, "GS", "gs_6_0" },
+		{ HS, "HS", "hs_6_0" },
+		{ DS, "DS", "ds_6_0" },
+		{ PS, "PS", "ps_6_0" },
+		{ CS, "CS", "cs_6_0" },
+	};
+
+	// Directories with the shader sources, every .hlsl file in them is expected to be declared
+	const char* ShaderDirectories[] = {
+		"Forward+/Shaders",
+		"Engine/Render",
+	};
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string argument = argv[i];
+			const bool hasValue = i + 1 < argc;
+
+			if (argument == "--dxc" && hasValue) options.DxcPath = argv[++i];
+			else if (argument == "--output" && hasValue) options.OutputPath = argv[++i];
+			else if (argument == "--root" && hasValue) options.RootDirectory = argv[++i];
+			else if (argument == "--jobs" && hasValue) options.NumJobs = std::max(std::atoi(argv[++i]), 1);
+			else
+			{
+				std::cout << "Usage: ShaderPrecompiler [--dxc <path>] [--output <path>] [--jobs <count>] [--root <directory>]" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string Quote(const std::string& value)
+	{
+		return "\"" + value + "\"";
+	}
+
+	// Returns the exit code of the command, output of the command is written to the log file
+	int RunCommand(const std::string& command, const std::string& logPath)
+	{
+		std::string fullCommand = command + " > " + Quote(logPath) + " 2>&1";
+#ifdef _WIN32
+		// cmd.exe strips the first and the last quote of the command line
+		fullCommand = "\"" + fullCommand + "\"";
+#endif
+		return std::system(fullCommand.c_str());
+	}
+
+	std::string ReadTextFile(const std::string& path)
+	{
+		std::vector<uint8_t> content;
+		FileUtility::ReadBinaryFile(path, content);
+		return std::string(content.begin(), content.end());
+	}
+
+	// Part of the archive keys, the runtime uses the version stored in the archive instead of its own
+	bool GetCompilerVersion(const Options& options, const std::filesystem::path& tempDirectory, std::string& compilerVersion)
+	{
+		const std::string logPath = (tempDirectory / "version.txt").string();
+		if (RunCommand(Quote(options.DxcPath) + " --version", logPath) != 0) return false;
+
+		compilerVersion = ReadTextFile(logPath);
+		compilerVersion = compilerVersion.substr(0, compilerVersion.find_first_of("\r\n"));
+		return !compilerVersion.empty();
+	}
+
+	// Input signature from the ISG1 part of the DXIL container, same values as ID3D12ShaderReflection returns for the 32 bit types
+	bool ReadInputParameters(const std::vector<uint8_t>& container, std::vector<ShaderCache::InputParameter>& inputParameters)
+	{
+		constexpr uint32_t CONTAINER_FOURCC = 0x43425844; // DXBC
+		constexpr uint32_t INPUT_SIGNATURE_FOURCC = 0x31475349; // ISG1
+		constexpr size_t CONTAINER_HEADER_SIZE = 32;
+		constexpr size_t SIGNATURE_ELEMENT_SIZE = 32;
+
+		const auto readUint = [&](size_t offset, uint32_t& value)
+		{
+			if (offset + sizeof(uint32_t) > container.size()) return false;
+			memcpy(&value, container.data() + offset, sizeof(uint32_t));
+			return true;
+		};
+
+		uint32_t fourCC = 0;
+		uint32_t numParts = 0;
+		if (!readUint(0, fourCC) || fourCC != CONTAINER_FOURCC || !readUint(28, numParts)) return false;
+
+		for (uint32_t i = 0; i < numParts; i++)
+		{
+			uint32_t partOffset = 0;
+			uint32_t partFourCC = 0;
+			uint32_t partSize = 0;
+			if (!readUint(CONTAINER_HEADER_SIZE + i * sizeof(uint32_t), partOffset) || !readUint(partOffset, partFourCC) || !readUint(partOffset + 4, partSize)) return false;
+			if (partFourCC != INPUT_SIGNATURE_FOURCC) continue;
+
+			// Element offsets and the semantic names are relative to the start of the signature
+			const size_t signatureOffset = partOffset + 8;
+			uint32_t numElements = 0;
+			uint32_t elementsOffset = 0;
+			if (!readUint(signatureOffset, numElements) || !readUint(signatureOffset + 4, elementsOffset)) return false;
+
+			for (uint32_t j = 0; j < numElements; j++)
+			{
+				const size_t elementOffset = signatureOffset + elementsOffset + j * SIGNATURE_ELEMENT_SIZE;
+				if (elementOffset + SIGNATURE_ELEMENT_SIZE > container.size()) return false;
+
+				uint32_t nameOffset = 0;
+				ShaderCache::InputParameter parameter{};
+				readUint(elementOffset + 4, nameOffset);
+				readUint(elementOffset + 8, parameter.SemanticIndex);
+				readUint(elementOffset + 12, parameter.SystemValueType);
+				readUint(elementOffset + 16, parameter.ComponentType);
+				parameter.Mask = container[elementOffset + 24];
+
+				for (size_t c = signatureOffset + nameOffset; c < container.size() && container[c]; c++) parameter.SemanticName += (char) container[c];
+				inputParameters.push_back(parameter);
+			}
+			return true;
+		}
+
+		// Vertex shader without the inputs
+		return true;
+	}
+
+	void Compile(const Options& options, const std::filesystem::path& tempDirectory, CompileJob& job)
+	{
+		std::stringstream ss;
+		ss << std::hex << std::setw(16) << std::setfill('0') << job.Key.Hash;
+		const std::string outputPath = (tempDirectory / (ss.str() + ".bin")).string();
+		const std::string logPath = (tempDirectory / (ss.str() + ".log")).string();
+
+		std::string command = Quote(options.DxcPath) + " -nologo -T " + job.TargetProfile + " -E " + job.EntryPoint;
+		for (const std::string& define : job.Defines) command += " -D " + define;
+		command += " -Fo " + Quote(outputPath) + " " + Quote(job.Path);
+
+		const Clock::time_point startTime = Clock::now();
+		const int exitCode = RunCommand(command, logPath);
+		job.CompileTimeMS = std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+
+		job.Log = ReadTextFile(logPath);
+		job.Success = exitCode == 0 && FileUtility::ReadBinaryFile(outputPath, job.Result.Bytecode) && !job.Result.Bytecode.empty();
+
+		// Only the vertex shader entry carries the input parameters, the runtime ignores them on the other stages
+		job.Result.InputParameters.clear();
+		if (job.Success && job.EntryPoint == "VS" && !ReadInputParameters(job.Result.Bytecode, job.Result.InputParameters))
+		{
+			job.Success = false;
+			job.Log += "Failed to read the input signature of the vertex shader\n";
+		}
+	}
+
+	std::string GetDescription(const CompileJob& job)
+	{
+		std::string description = job.Path + " " + job.EntryPoint;
+		for (const std::string& define : job.Defines) description += " " + define;
+		return description;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) return 2;
+
+	// Shader paths and the includes are relative to the repository root, same as the working directory of the application
+	std::error_code error;
+	std::filesystem::current_path(options.RootDirectory, error);
+	if (error)
+	{
+		std::cout << "Error: Can't open the root directory " << options.RootDirectory << std::endl;
+		return 1;
+	}
+
+	const std::filesystem::path tempDirectory = std::filesystem::temp_directory_path() / ("ShaderPrecompiler_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+	std::filesystem::create_directories(tempDirectory, error);
+
+	std::string compilerVersion;
+	if (!GetCompilerVersion(options, tempDirectory, compilerVersion))
+	{
+		std::cout << "Error: Can't run the shader compiler " << options.DxcPath << std::endl;
+		std::filesystem::remove_all(tempDirectory, error);
+		return 1;
+	}
+	std::cout << "Compiler: " << compilerVersion << std::endl;
+
+	std::vector<const ShaderDeclaration*> declarations;
+	for (const ShaderDeclaration& declaration : ShaderManifest::GetEngineShaders()) declarations.push_back(&declaration);
+	for (const ShaderDeclaration& declaration : ShaderDeclarations::GetAll()) declarations.push_back(&declaration);
+
+	// Undeclared shader would still be compiled at runtime, not a failure
+	std::set<std::string> declaredPaths;
+	for (const ShaderDeclaration* declaration : declarations) declaredPaths.insert(declaration->Path);
+	for (const char* directory : ShaderDirectories)
+	{
+		for (const auto& file : std::filesystem::directory_iterator(directory, error))
+		{
+			const std::string path = file.path().lexically_normal().generic_string();
+			if (file.path().extension() == ".hlsl" && !declaredPaths.contains(path))
+			{
+				std::cout << "Warning: Shader " << path << " isn't declared and won't be precompiled" << std::endl;
+			}
+		}
+	}
+
+	bool success = true;
+	std::vector<CompileJob> jobs;
+	std::set<uint64_t> addedKeys;
+	for (const ShaderDeclaration* declaration : declarations)
+	{
+		for (const ShaderImplementationDesc& implementation : declaration->DeclaredImplementations)
+		{
+			if (!declaration->Permutations.IsValid(implementation.Permutation))
+			{
+				std::cout << "Error: Invalid permutation declared for " << declaration->Path << std::endl;
+				success = false;
+				continue;
+			}
+
+			for (const StageDesc& stage : Stages)
+			{
+				if (!(implementation.Stages & stage.Stage)) continue;
+
+				CompileJob job{};
+				job.Path = declaration->Path;
+				job.EntryPoint = stage.EntryPoint;
+				job.TargetProfile = stage.TargetProfile;
+				job.Defines = declaration->Permutations.GetDefines(implementation.Permutation);
+
+				if (!ShaderCache::CreateKey(job.Path, job.Defines, job.EntryPoint, job.TargetProfile, compilerVersion, job.Key))
+				{
+					std::cout << "Error: Can't read the shader " << job.Path << std::endl;
+					success = false;
+					break;
+				}
+
+				// Shaders with the same file can declare the same implementation
+				if (addedKeys.insert(job.Key.Hash).second) jobs.push_back(std::move(job));
+			}
+		}
+	}
+
+	std::cout << "Compiling " << jobs.size() << " shader stages on " << options.NumJobs << " threads" << std::endl;
+
+	const Clock::time_point startTime = Clock::now();
+	{
+		std::mutex outputMutex;
+		std::atomic<uint32_t> nextJob = 0;
+		std::vector<std::thread> threads;
+		for (uint32_t i = 0; i < options.NumJobs; i++)
+		{
+			threads.push_back(std::thread([&]
+			{
+				for (uint32_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++)
+				{
+					CompileJob& job = jobs[jobIndex];
+					Compile(options, tempDirectory, job);
+
+					if (!job.Success)
+					{
+						std::lock_guard<std::mutex> lock(outputMutex);
+						std::cout << "Error: Failed to compile " << GetDescription(job) << "\n" << job.Log << std::endl;
+					}
+				}
+			}));
+		}
+		for (std::thread& thread : threads) thread.join();
+	}
+	const float totalTimeMS = std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+
+	std::filesystem::remove_all(tempDirectory, error);
+
+	std::map<std::string, ShaderStatistics> statistics;
+	uint32_t numFailed = 0;
+	for (const CompileJob& job : jobs)
+	{
+		ShaderStatistics& shaderStatistics = statistics[job.Path];
+		shaderStatistics.NumStages++;
+		shaderStatistics.CompileTimeMS += job.CompileTimeMS;
+		shaderStatistics.SlowestStageMS = std::max(shaderStatistics.SlowestStageMS, job.CompileTimeMS);
+		if (!job.Success) numFailed++;
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << std::left << std::setw(48) << "Shader" << std::right << std::setw(8) << "Stages" << std::setw(14) << "Total ms" << std::setw(14) << "Slowest ms" << std::endl;
+	for (const auto& [path, shaderStatistics] : statistics)
+	{
+		std::cout << std::left << std::setw(48) << path << std::right << std::setw(8) << shaderStatistics.NumStages << std::setw(14) << shaderStatistics.CompileTimeMS << std::setw(14) << shaderStatistics.SlowestStageMS << std::endl;
+	}
+	std::cout << jobs.size() << " stages compiled in " << totalTimeMS << " ms" << std::endl;
+
+	if (numFailed || !success)
+	{
+		// Archive with the missing stages would silently fall back to the runtime compilation
+		std::cout << "Error: " << numFailed << " shader stages failed to compile, archive isn't written" << std::endl;
+		return 1;
+	}
+
+	ShaderCache::Archive archive;
+	archive.SetCompilerVersion(compilerVersion);
+	for (const CompileJob& job : jobs) archive.Add(job.Key, job.Result);
+
+	if (!archive.Save(options.OutputPath))
+	{
+		std::cout << "Error: Failed to write the shader archive " << options.OutputPath << std::endl;
+		return 1;
+	}
+
+	std::cout << "Shader archive written to " << options.OutputPath << " with " << archive.GetNumEntries() << " stages" << std::endl;
+	return 0;
+}
@@ -0,0 +1,142 @@
+// Throughput of the accessor decoding against the scalar reference for the attributes of the scene conversion
+// Vertices are written into the 48 byte vertex of the scene cache, quantized attributes are the ones of KHR_mesh_quantization
+//
+// Usage: AccessorDecodingBenchmark [--elements <count>] [--repeats <count>]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+// AccessorDecoding reads the glTF accessors with cgltf, MappedGLTF has the implementation in the engine
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+#include <Engine/Loading/AccessorDecoding.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using AccessorDecoding::ComponentType;
+	using AccessorDecoding::Layout;
+
+	constexpr size_t VERTEX_STRIDE = 48;
+
+	struct Attribute
+	{
+		const char* Name;
+		ComponentType Type;
+		uint32_t NumComponents;
+		bool Normalized;
+		bool Indices;
+	};
+
+	// Best time of the repeats in nanoseconds
+	template<typename DecodeFunc>
+	double Measure(uint32_t numRepeats, DecodeFunc decode)
+	{
+		double bestNS = 0.0;
+		for (uint32_t i = 0; i < numRepeats; i++)
+		{
+			const Clock::time_point startTime = Clock::now();
+			decode();
+			const double timeNS = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count();
+			bestNS = i == 0 ? timeNS : std::min(bestNS, timeNS);
+		}
+		return bestNS;
+	}
+
+	void BenchmarkAttribute(const Attribute& attribute, size_t numElements, uint32_t numRepeats)
+	{
+		Layout layout;
+		layout.Type = attribute.Type;
+		layout.NumComponents = attribute.NumComponents;
+		layout.Normalized = attribute.Normalized;
+		layout.Count = numElements;
+
+		// Quantized attributes keep the 4 byte alignment of the vertex attributes
+		const size_t elementSize = AccessorDecoding::GetElementSize(layout);
+		layout.Stride = attribute.Indices ? elementSize : (elementSize + 3) & ~(size_t) 3;
+
+		std::mt19937 random{ 1 };
+		std::vector<uint8_t> bytes(layout.Count * layout.Stride);
+		if (attribute.Type == ComponentType::Float)
+		{
+			std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+			for (size_t i = 0; i + 4 <= bytes.size(); i += 4)
+			{
+				const float value = distribution(random);
+				memcpy(bytes.data() + i, &value, sizeof(value));
+			}
+		}
+		else for (uint8_t& byte : bytes) byte = (uint8_t) random();
+		layout.Data = bytes.data();
+
+		const size_t dstStride = attribute.Indices ? sizeof(uint32_t) : VERTEX_STRIDE;
+		std::vector<uint8_t> dst(layout.Count * dstStride);
+
+		double decodeNS;
+		double referenceNS;
+		if (attribute.Indices)
+		{
+			uint32_t* out = reinterpret_cast<uint32_t*>(dst.data());
+			decodeNS = Measure(numRepeats, [&]() { AccessorDecoding::DecodeUInts(layout, out, dstStride, 1); });
+			referenceNS = Measure(numRepeats, [&]() { AccessorDecoding::DecodeUIntsReference(layout, out, dstStride, 1); });
+		}
+		else
+		{
+			float* out = reinterpret_cast<float*>(dst.data());
+			decodeNS = Measure(numRepeats, [&]() { AccessorDecoding::DecodeFloats(layout, out, dstStride, attribute.NumComponents); });
+			referenceNS = Measure(numRepeats, [&]() { AccessorDecoding::DecodeFloatsReference(layout, out, dstStride, attribute.NumComponents); });
+		}
+
+		// Bytes read from the accessor
+		const double sourceBytes = (double) layout.Count * elementSize;
+		std::cout << "  " << std::left << std::setw(28) << attribute.Name << std::right;
+		std::cout << std::setw(10) << sourceBytes / decodeNS << " GB/s";
+		std::cout << std::setw(10) << sourceBytes / referenceNS << " GB/s reference";
+		std::cout << std::setw(8) << referenceNS / decodeNS << "x" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t numElements = 1 << 20;
+	uint32_t numRepeats = 10;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--elements" && i + 1 < argc) numElements = std::max(std::atoi(argv[++i]), 1);
+		else if (argument == "--repeats" && i + 1 < argc) numRepeats = std::max(std::atoi(argv[++i]), 1);
+		else
+		{
+			std::cout << "Usage: AccessorDecodingBenchmark [--elements <count>] [--repeats <count>]" << std::endl;
+			return 2;
+		}
+	}
+
+	const Attribute attributes[] =
+	{
+		{ "Position float3", ComponentType::Float, 3, false, false },
+		{ "Position int16 normalized", ComponentType::Int16, 3, true, false },
+		{ "Normal int8 normalized", ComponentType::Int8, 3, true, false },
+		{ "Tangent int16 normalized", ComponentType::Int16, 4, true, false },
+		{ "Texcoord uint16 normalized", ComponentType::UInt16, 2, true, false },
+		{ "Texcoord uint8 normalized", ComponentType::UInt8, 2, true, false },
+		{ "Indices uint16", ComponentType::UInt16, 1, false, true },
+		{ "Indices uint8", ComponentType::UInt8, 1, false, true },
+	};
+
+	std::cout << numElements << " elements, best of " << numRepeats << " runs" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const Attribute& attribute : attributes)
+	{
+		BenchmarkAttribute(attribute, numElements, numRepeats);
+	}
+	return 0;
+}
@@ -0,0 +1,290 @@
+#include <random>
+#include <vector>
+#include <limits>
+#include <cstring>
+
+#include "Test.h"
+
+// MappedGLTF has the implementation in the engine, the test doesn't link it
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+#include <Engine/Loading/AccessorDecoding.h>
+
+namespace
+{
+	using AccessorDecoding::ComponentType;
+	using AccessorDecoding::Layout;
+
+	constexpr ComponentType COMPONENT_TYPES[] = { ComponentType::Int8, ComponentType::UInt8, ComponentType::Int16, ComponentType::UInt16, ComponentType::UInt32, ComponentType::Float };
+
+	// Destination is filled with the pattern first, the bytes between the components have to stay untouched
+	constexpr uint8_t UNTOUCHED = 0xCD;
+
+	// Random accessor over its own bytes, floats include NaNs, infinities and values past the integer range
+	struct RandomAccessor
+	{
+		std::vector<uint8_t> Bytes;
+		AccessorDecoding::Layout Layout;
+	};
+
+	RandomAccessor CreateRandomAccessor(std::mt19937& random, ComponentType type, uint32_t numComponents, uint32_t numColumns, bool normalized)
+	{
+		RandomAccessor accessor;
+		Layout& layout = accessor.Layout;
+		layout.Type = type;
+		layout.NumComponents = numComponents;
+		layout.NumColumns = numColumns;
+		layout.Normalized = normalized;
+		layout.Count = random() % 3 == 0 ? random() % 4 : random() % 100;
+
+		// Tight, padded and unaligned strides, the data doesn't start on the component size either
+		const size_t elementSize = AccessorDecoding::GetElementSize(layout);
+		const size_t padding[] = { 0, 0, 1, 3, 4, 13 };
+		layout.Stride = elementSize + padding[random() % std::size(padding)];
+		const size_t offset = random() % 4;
+
+		accessor.Bytes.resize(offset + layout.Count * layout.Stride + 16);
+		for (uint8_t& byte : accessor.Bytes) byte = (uint8_t) random();
+		if (type == ComponentType::Float)
+		{
+			const float specials[] = { 0.0f, -0.0f, 1.0f, -1.0f, 4294967296.0f, -1e30f, 1e30f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), 1e-40f };
+			for (size_t i = offset; i + 4 <= accessor.Bytes.size(); i += 4)
+			{
+				const float value = random() % 2 ? specials[random() % std::size(specials)] : std::uniform_real_distribution<float>(-70000.0f, 70000.0f)(random);
+				memcpy(accessor.Bytes.data() + i, &value, sizeof(value));
+			}
+		}
+		layout.Data = accessor.Bytes.data() + offset;
+		return accessor;
+	}
+
+	// Decodes with the dispatching function and the reference into destinations of the same layout and compares every byte
+	template<typename T, typename DecodeFunc, typename ReferenceFunc>
+	bool MatchesReference(const Layout& layout, size_t dstStride, uint32_t dstComponents, DecodeFunc decode, ReferenceFunc reference)
+	{
+		const size_t size = layout.Count * dstStride + sizeof(T) * 4;
+		std::vector<uint8_t> decoded(size, UNTOUCHED);
+		std::vector<uint8_t> expected(size, UNTOUCHED);
+		decode(layout, reinterpret_cast<T*>(decoded.data()), dstStride, dstComponents);
+		reference(layout, reinterpret_cast<T*>(expected.data()), dstStride, dstComponents);
+		return decoded == expected;
+	}
+
+	// Every component type, count, normalization and stride, the destination either matches the SIMD kernels or not
+	void TestFuzzAgainstReference()
+	{
+		std::mt19937 random{ 1 };
+		uint32_t numMismatches = 0;
+		uint32_t numCases = 0;
+		for (uint32_t iteration = 0; iteration < 200; iteration++)
+		{
+			for (ComponentType type : COMPONENT_TYPES)
+			{
+				for (uint32_t numComponents = 1; numComponents <= 4; numComponents++)
+				{
+					const bool normalized = type != ComponentType::Float && random() % 2;
+					const RandomAccessor accessor = CreateRandomAccessor(random, type, numComponents, 1, normalized);
+
+					// Same component count takes the SIMD paths, the others the reference
+					const uint32_t dstComponents = random() % 2 ? numComponents : 1 + random() % 4;
+					const size_t dstStride = dstComponents * sizeof(float) + (random() % 2) * 4 * (random() % 4);
+
+					numMismatches += !MatchesReference<float>(accessor.Layout, dstStride, dstComponents, AccessorDecoding::DecodeFloats, AccessorDecoding::DecodeFloatsReference);
+					numMismatches += !MatchesReference<uint32_t>(accessor.Layout, dstStride, dstComponents, AccessorDecoding::DecodeUInts, AccessorDecoding::DecodeUIntsReference);
+					numCases += 2;
+				}
+			}
+		}
+		CHECK(numCases == 200 * 6 * 4 * 2);
+		CHECK(numMismatches == 0);
+	}
+
+	// Matrix columns start at 4 bytes, the padding isn't read
+	void TestFuzzMatrices()
+	{
+		std::mt19937 random{ 2 };
+		uint32_t numMismatches = 0;
+		for (uint32_t iteration = 0; iteration < 100; iteration++)
+		{
+			for (ComponentType type : COMPONENT_TYPES)
+			{
+				for (uint32_t numColumns = 2; numColumns <= 4; numColumns++)
+				{
+					const RandomAccessor accessor = CreateRandomAccessor(random, type, numColumns * numColumns, numColumns, type != ComponentType::Float && random() % 2);
+					const uint32_t dstComponents = numColumns * numColumns;
+					numMismatches += !MatchesReference<float>(accessor.Layout, dstComponents * sizeof(float), dstComponents, AccessorDecoding::DecodeFloats, AccessorDecoding::DecodeFloatsReference);
+					numMismatches += !MatchesReference<uint32_t>(accessor.Layout, dstComponents * sizeof(uint32_t), dstComponents, AccessorDecoding::DecodeUInts, AccessorDecoding::DecodeUIntsReference);
+				}
+			}
+		}
+		CHECK(numMismatches == 0);
+
+		// Byte mat2 columns are 2 bytes of data and 2 of padding
+		Layout layout;
+		layout.Type = ComponentType::UInt8;
+		layout.NumComponents = 4;
+		layout.NumColumns = 2;
+		layout.Count = 1;
+		CHECK(AccessorDecoding::GetElementSize(layout) == 8);
+		const uint8_t bytes[8] = { 1, 2, 99, 99, 3, 4, 99, 99 };
+		layout.Data = bytes;
+		layout.Stride = 8;
+		uint32_t values[4] = {};
+		AccessorDecoding::DecodeUInts(layout, values, sizeof(values), 4);
+		CHECK(values[0] == 1 && values[1] == 2 && values[2] == 3 && values[3] == 4);
+	}
+
+	// Packed 8 and 16 bit indices around the 16 and 8 wide loops
+	void TestPackedIndices()
+	{
+		std::mt19937 random{ 3 };
+		uint32_t numMismatches = 0;
+		for (ComponentType type : { ComponentType::UInt8, ComponentType::UInt16, ComponentType::UInt32 })
+		{
+			for (size_t count = 0; count <= 70; count++)
+			{
+				const uint32_t size = AccessorDecoding::GetComponentSize(type);
+				std::vector<uint8_t> bytes(count * size + 1);
+				for (uint8_t& byte : bytes) byte = (uint8_t) random();
+
+				Layout layout;
+				layout.Type = type;
+				layout.Count = count;
+				layout.Stride = size;
+				layout.Data = bytes.data() + 1;
+				numMismatches += !MatchesReference<uint32_t>(layout, sizeof(uint32_t), 1, AccessorDecoding::DecodeUInts, AccessorDecoding::DecodeUIntsReference);
+			}
+		}
+		CHECK(numMismatches == 0);
+	}
+
+	// Exact values of the conversions the reference defines
+	void TestConversions()
+	{
+		const auto decodeFloat = [](ComponentType type, bool normalized, const void* data)
+		{
+			Layout layout;
+			layout.Type = type;
+			layout.Normalized = normalized;
+			layout.Count = 1;
+			layout.Stride = AccessorDecoding::GetComponentSize(type);
+			layout.Data = static_cast<const uint8_t*>(data);
+			float value = 0.0f;
+			AccessorDecoding::DecodeFloats(layout, &value, sizeof(value), 1);
+			return value;
+		};
+
+		const int8_t int8Min = -128;
+		const int16_t int16Min = -32768;
+		const uint8_t uint8Max = 255;
+		const int16_t int16Value = -16384;
+		CHECK(decodeFloat(ComponentType::Int8, true, &int8Min) == -1.0f);
+		CHECK(decodeFloat(ComponentType::Int16, true, &int16Min) == -1.0f);
+		CHECK(decodeFloat(ComponentType::UInt8, true, &uint8Max) == 1.0f);
+		CHECK(decodeFloat(ComponentType::Int8, false, &int8Min) == -128.0f);
+		CHECK(decodeFloat(ComponentType::Int16, true, &int16Value) == -16384.0f / 32767.0f);
+
+		// Signed integers are sign extended, floats outside of the range are zero
+		Layout layout;
+		layout.Type = ComponentType::Int16;
+		layout.Count = 1;
+		layout.Stride = 2;
+		layout.Data = reinterpret_cast<const uint8_t*>(&int16Min);
+		uint32_t value = 0;
+		AccessorDecoding::DecodeUInts(layout, &value, sizeof(value), 1);
+		CHECK(value == 0xFFFF8000u);
+
+		const float floats[] = { -1.0f, 4294967296.0f, std::numeric_limits<float>::quiet_NaN(), 7.9f };
+		uint32_t uints[4] = {};
+		layout.Type = ComponentType::Float;
+		layout.Count = 4;
+		layout.Stride = 4;
+		layout.Data = reinterpret_cast<const uint8_t*>(floats);
+		AccessorDecoding::DecodeUInts(layout, uints, sizeof(uint32_t), 1);
+		CHECK(uints[0] == 0 && uints[1] == 0 && uints[2] == 0 && uints[3] == 7);
+
+		// Accessor without data is zero, a sparse accessor may not have a buffer view
+		layout.Data = nullptr;
+		float zeros[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		AccessorDecoding::DecodeFloats(layout, zeros, sizeof(float), 1);
+		CHECK(zeros[0] == 0.0f && zeros[3] == 0.0f);
+	}
+
+	// glTF accessors with the sparse values and the bounds of the buffer views
+	void TestReadAccessor()
+	{
+		std::vector<uint8_t> bufferData(64);
+		const uint16_t positions[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		const uint8_t sparseIndices[] = { 2, 0, 7 };
+		const uint16_t sparseValues[] = { 30, 31, 32, 10, 11, 12, 70, 71, 72 };
+		memcpy(bufferData.data(), positions, sizeof(positions));
+		memcpy(bufferData.data() + 18, sparseIndices, sizeof(sparseIndices));
+		memcpy(bufferData.data() + 22, sparseValues, sizeof(sparseValues));
+
+		cgltf_buffer buffer{};
+		buffer.size = bufferData.size();
+		buffer.data = bufferData.data();
+
+		cgltf_buffer_view views[3] = {};
+		const size_t ranges[3][2] = { { 0, 18 }, { 18, 3 }, { 22, 18 } };
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			views[i].buffer = &buffer;
+			views[i].offset = ranges[i][0];
+			views[i].size = ranges[i][1];
+		}
+
+		cgltf_accessor accessor{};
+		accessor.component_type = cgltf_component_type_r_16u;
+		accessor.type = cgltf_type_vec3;
+		accessor.count = 3;
+		accessor.buffer_view = &views[0];
+		accessor.is_sparse = true;
+		accessor.sparse.count = 3;
+		accessor.sparse.indices_buffer_view = &views[1];
+		accessor.sparse.indices_component_type = cgltf_component_type_r_8u;
+		accessor.sparse.values_buffer_view = &views[2];
+
+		// Index 7 is outside of the accessor and skipped
+		float values[9] = {};
+		CHECK(AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+		const float expected[9] = { 10, 11, 12, 4, 5, 6, 30, 31, 32 };
+		CHECK(memcmp(values, expected, sizeof(values)) == 0);
+
+		// Sparse accessor without a buffer view starts from zeros
+		accessor.buffer_view = nullptr;
+		uint32_t uints[9] = {};
+		CHECK(AccessorDecoding::ReadUInts(&accessor, uints, 3 * sizeof(uint32_t), 3));
+		CHECK(uints[0] == 10 && uints[3] == 0 && uints[8] == 32);
+
+		// Accessor, stride or sparse data past the view fail
+		accessor.buffer_view = &views[0];
+		accessor.count = 4;
+		CHECK(!AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+		accessor.count = 3;
+		accessor.stride = 8;
+		CHECK(!AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+		accessor.stride = 0;
+		accessor.sparse.count = 4;
+		CHECK(!AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+		accessor.sparse.count = 3;
+		accessor.sparse.indices_component_type = cgltf_component_type_r_32f;
+		CHECK(!AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+		accessor.sparse.indices_component_type = cgltf_component_type_r_8u;
+
+		// Buffer that isn't loaded
+		buffer.data = nullptr;
+		CHECK(!AccessorDecoding::ReadFloats(&accessor, values, 3 * sizeof(float), 3));
+	}
+}
+
+int main()
+{
+	Test::Run("Fuzz against reference", TestFuzzAgainstReference);
+	Test::Run("Fuzz matrices", TestFuzzMatrices);
+	Test::Run("Packed indices", TestPackedIndices);
+	Test::Run("Conversions", TestConversions);
+	Test::Run("Read accessor", TestReadAccessor);
+	return Test::Finish();
+}
@@ -0,0 +1,303 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "Test.h"
+
+#include <Engine/Loading/AssetArchive.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Engine/Utility/Hash.h>
+#include <Engine/Utility/LZ4.h>
+
+namespace
+{
+	constexpr uint8_t GUARD = 0xCD;
+	constexpr size_t NUM_GUARD_BYTES = 64;
+
+	const std::string ARCHIVE_PATH = "Cache/Test.bin";
+
+	// Text compresses and spans several chunks, noise is stored and used in place
+	const std::string TEXT_PATH = "Resources/Text.txt";
+	const std::string NOISE_PATH = "Resources/Noise.bin";
+	const std::string SMALL_PATH = "Resources/Small.txt";
+
+	enum class Content
+	{
+		Random,
+		Pattern,
+		Zeros,
+		Mixed,
+	};
+
+	std::vector<uint8_t> CreateData(Content content, size_t size, std::mt19937& random)
+	{
+		std::vector<uint8_t> data(size);
+		for (size_t i = 0; i < size; i++)
+		{
+			switch (content)
+			{
+			case Content::Random: data[i] = (uint8_t) random(); break;
+			case Content::Pattern: data[i] = "abcabcabd"[i % 9] ^ (random() % 50 == 0); break;
+			case Content::Zeros: data[i] = 0; break;
+			case Content::Mixed: data[i] = (i / 3000) % 2 ? (uint8_t) random() : (uint8_t) (i % 251); break;
+			}
+		}
+		return data;
+	}
+
+	// Decompresses into a buffer with guard bytes after dstSize, fails if the decompressor wrote past them
+	bool DecompressGuarded(const std::vector<uint8_t>& compressed, size_t dstSize, std::vector<uint8_t>& dst)
+	{
+		dst.assign(dstSize + NUM_GUARD_BYTES, GUARD);
+		const bool decompressed = LZ4::Decompress(compressed.data(), compressed.size(), dst.data(), dstSize);
+		const bool guarded = std::all_of(dst.begin() + dstSize, dst.end(), [](uint8_t value) { return value == GUARD; });
+		dst.resize(dstSize);
+		return decompressed && guarded;
+	}
+
+	std::vector<uint8_t> Compress(const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> compressed(LZ4::GetMaxCompressedSize(data.size()));
+		compressed.resize(LZ4::Compress(data.data(), data.size(), compressed.data()));
+		return compressed;
+	}
+
+	// Files of the archive in a temporary directory that the test works in
+	void EnterTempDirectory()
+	{
+		const std::string directory = Test::CreateTempDirectory("AssetArchive");
+		std::filesystem::current_path(directory);
+
+		std::mt19937 random{ 5 };
+		std::string text;
+		while (text.size() < 3 * AssetArchive::DEFAULT_CHUNK_SIZE / 2) text += "Line " + std::to_string(text.size() % 1000) + " of the asset archive test\n";
+		const std::vector<uint8_t> noise = CreateData(Content::Random, 100000, random);
+
+		CHECK(FileUtility::WriteBinaryFile(TEXT_PATH, text.data(), text.size()));
+		CHECK(FileUtility::WriteBinaryFile(NOISE_PATH, noise.data(), noise.size()));
+		CHECK(FileUtility::WriteBinaryFile(SMALL_PATH, "hello", 5));
+	}
+
+	bool PackResources()
+	{
+		std::vector<AssetArchive::SourceFile> files;
+		for (const std::string& path : { TEXT_PATH, NOISE_PATH, SMALL_PATH }) files.push_back(AssetArchive::SourceFile{ path, path });
+
+		AssetArchive::PackStatistics statistics;
+		return AssetArchive::Pack(ARCHIVE_PATH, files, 2, statistics) && statistics.NumFiles == 3 && statistics.NumStoredFiles >= 1;
+	}
+
+	bool ReadsAs(const AssetArchive::Archive& archive, const std::string& path)
+	{
+		std::vector<uint8_t> expected;
+		const AssetArchive::Entry* entry = archive.Find(path);
+		if (!entry || !FileUtility::ReadBinaryFile(path, expected) || entry->Size != expected.size()) return false;
+
+		std::vector<uint8_t> content(entry->Size);
+		return archive.Read(*entry, content.data(), 3) && content == expected;
+	}
+
+	std::string ReadAssetFile(const std::string& path)
+	{
+		AssetArchive::AssetFile file;
+		if (!file.Open(path)) return "";
+		return std::string(reinterpret_cast<const char*>(file.GetData()), file.GetSize());
+	}
+
+	// Every kind of data at sizes around the minimal match and the chunk size decompresses back exactly
+	void TestLZ4RoundTrip()
+	{
+		std::mt19937 random{ 1 };
+		for (size_t size : { 0, 1, 5, 12, 13, 14, 20, 64, 100, 1000, 65536, 70000, 262144 })
+		{
+			for (Content content : { Content::Random, Content::Pattern, Content::Zeros, Content::Mixed })
+			{
+				const std::vector<uint8_t> data = CreateData(content, size, random);
+				const std::vector<uint8_t> compressed = Compress(data);
+				CHECK(compressed.size() <= LZ4::GetMaxCompressedSize(size));
+				if (content == Content::Zeros && size >= 65536) CHECK(compressed.size() < size / 100);
+
+				std::vector<uint8_t> decompressed;
+				CHECK(DecompressGuarded(compressed, size, decompressed));
+				CHECK(decompressed == data);
+
+				// Block has to decompress to exactly the expected size
+				if (size > 0) CHECK(!DecompressGuarded(compressed, size - 1, decompressed));
+				CHECK(!DecompressGuarded(compressed, size + 1, decompressed));
+			}
+		}
+	}
+
+	// Malformed blocks fail without writing past the output, random damage never reads or writes out of the buffers
+	void TestLZ4Corruption()
+	{
+		std::vector<uint8_t> dst;
+
+		// Match offset of 0, match before the start of the output and literals past the end of the block
+		CHECK(!DecompressGuarded({ 0x10, 'a', 0x00, 0x00 }, 8, dst));
+		CHECK(!DecompressGuarded({ 0x10, 'a', 0x05, 0x00 }, 8, dst));
+		CHECK(!DecompressGuarded({ 0x50, 'a', 'b' }, 5, dst));
+		CHECK(!DecompressGuarded({ 0xF0 }, 20, dst));
+		CHECK(!DecompressGuarded({}, 1, dst));
+
+		std::mt19937 random{ 2 };
+		std::vector<uint8_t> data(50000);
+		for (size_t i = 0; i < data.size(); i++) data[i] = "hello world, hello lz4 "[i % 23] + (random() % 100 == 0);
+		const std::vector<uint8_t> compressed = Compress(data);
+
+		uint32_t numGuardsHit = 0;
+		for (uint32_t i = 0; i < 20000; i++)
+		{
+			std::vector<uint8_t> damaged = compressed;
+			for (uint32_t k = 0; k < 3; k++) damaged[random() % damaged.size()] = (uint8_t) random();
+			if (random() % 4 == 0) damaged.resize(random() % damaged.size());
+
+			dst.assign(data.size() + NUM_GUARD_BYTES, GUARD);
+			LZ4::Decompress(damaged.data(), damaged.size(), dst.data(), data.size());
+			numGuardsHit += std::any_of(dst.begin() + data.size(), dst.end(), [](uint8_t value) { return value != GUARD; }) ? 1 : 0;
+		}
+		CHECK(numGuardsHit == 0);
+	}
+
+	// Packed files are found by their normalized name and read back, multi chunk files with any thread count
+	void TestArchiveRoundTrip()
+	{
+		CHECK(PackResources());
+
+		AssetArchive::Archive archive;
+		CHECK(archive.Open(ARCHIVE_PATH));
+		CHECK(archive.GetEntries().size() == 3);
+		CHECK(archive.Verify(2));
+
+		CHECK(ReadsAs(archive, TEXT_PATH));
+		CHECK(ReadsAs(archive, NOISE_PATH));
+		CHECK(ReadsAs(archive, SMALL_PATH));
+		CHECK(archive.Find(TEXT_PATH)->NumChunks == 2);
+		CHECK(!archive.IsStored(*archive.Find(TEXT_PATH)));
+		CHECK(archive.IsStored(*archive.Find(NOISE_PATH)));
+
+		CHECK(archive.Find("resources\\TEXT.txt") == archive.Find(TEXT_PATH));
+		CHECK(archive.Find("./Resources/../Resources/Small.txt") == archive.Find(SMALL_PATH));
+		CHECK(archive.Find("Resources/Missing.txt") == nullptr);
+		CHECK(archive.GetName(*archive.Find(SMALL_PATH)) == "resources/small.txt");
+
+		std::vector<uint8_t> noise;
+		CHECK(FileUtility::ReadBinaryFile(NOISE_PATH, noise));
+		const uint8_t* storedData = archive.GetStoredData(*archive.Find(NOISE_PATH));
+		CHECK(storedData && memcmp(storedData, noise.data(), noise.size()) == 0);
+		CHECK(archive.Find(NOISE_PATH)->ContentHash == Hash::XXHash64(noise.data(), noise.size()));
+	}
+
+	// Damaged header or table fails to open, damaged chunks open and then fail to read
+	void TestArchiveCorruption()
+	{
+		CHECK(PackResources());
+
+		std::vector<uint8_t> content;
+		CHECK(FileUtility::ReadBinaryFile(ARCHIVE_PATH, content));
+
+		const auto opens = [&](const std::string& name, const std::vector<uint8_t>& damaged, size_t size)
+		{
+			const std::string path = "Cache/" + name + ".bin";
+			FileUtility::WriteBinaryFile(path, damaged.data(), size);
+			AssetArchive::Archive archive;
+			return archive.Open(path);
+		};
+		const auto damage = [&](const std::string& name, size_t offset, uint8_t value)
+		{
+			std::vector<uint8_t> damaged = content;
+			damaged[offset] = value;
+			return opens(name, damaged, damaged.size());
+		};
+
+		AssetArchive::Archive missing;
+		CHECK(!missing.Open("Cache/Missing.bin"));
+
+		// Header is magic, version, chunk size, counts, table offset and table hash, the chunk size is 0x40000
+		CHECK(opens("copy", content, content.size()));
+		CHECK(!damage("magic", 0, 0));
+		CHECK(!damage("version", 4, 1));
+		CHECK(!damage("chunk size", 10, 0));
+		CHECK(!opens("header", content, 20));
+		CHECK(!opens("table", content, 40));
+		CHECK(!opens("last byte", content, content.size() - 1));
+
+		// Names are at the end of the table that the hash covers
+		CHECK(!damage("names", content.size() - 1, content.back() ^ 1));
+
+		// Text starts on the first aligned offset after the 40 byte header
+		std::vector<uint8_t> damaged = content;
+		damaged[64 + 100] ^= 0xFF;
+		FileUtility::WriteBinaryFile("Cache/chunk.bin", damaged.data(), damaged.size());
+
+		AssetArchive::Archive archive;
+		CHECK(archive.Open("Cache/chunk.bin"));
+		CHECK(!archive.Verify(2));
+		CHECK(!ReadsAs(archive, TEXT_PATH));
+		CHECK(ReadsAs(archive, NOISE_PATH));
+	}
+
+	// Staleness is checked on the first lookup after the mount
+	bool Remount()
+	{
+		AssetArchive::UnmountAll();
+		return AssetArchive::Mount(ARCHIVE_PATH);
+	}
+
+	// Mounted entry is used while its loose file is missing or unchanged, a loose file with another size or write time wins
+	void TestStaleEntries()
+	{
+		CHECK(PackResources());
+		CHECK(AssetArchive::Mount(ARCHIVE_PATH));
+
+		AssetArchive::FileInfo info;
+		CHECK(AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(info.Size == 5 && info.ContentHash == Hash::XXHash64(reinterpret_cast<const uint8_t*>("hello"), 5));
+
+		const std::filesystem::file_time_type packedTime = std::filesystem::last_write_time(SMALL_PATH);
+		std::filesystem::remove(SMALL_PATH);
+		CHECK(AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(ReadAssetFile(SMALL_PATH) == "hello");
+
+		// Same size, edited later, the entry was already checked so the edit is seen after the next mount
+		CHECK(FileUtility::WriteBinaryFile(SMALL_PATH, "world", 5));
+		std::filesystem::last_write_time(SMALL_PATH, packedTime + std::chrono::seconds(1));
+		CHECK(AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(ReadAssetFile(SMALL_PATH) == "hello");
+
+		CHECK(Remount());
+		CHECK(!AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(!AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(ReadAssetFile(SMALL_PATH) == "world");
+
+		// Other size with the packed write time
+		CHECK(FileUtility::WriteBinaryFile(SMALL_PATH, "hello again", 11));
+		std::filesystem::last_write_time(SMALL_PATH, packedTime);
+		CHECK(Remount());
+		CHECK(!AssetArchive::FindMountedFile(SMALL_PATH, info));
+		CHECK(ReadAssetFile(SMALL_PATH) == "hello again");
+
+		// Other files of the archive are still read from it
+		CHECK(AssetArchive::FindMountedFile(TEXT_PATH, info));
+		CHECK(AssetArchive::FindMountedFile(NOISE_PATH, info));
+
+		AssetArchive::UnmountAll();
+		CHECK(!AssetArchive::FindMountedFile(TEXT_PATH, info));
+	}
+}
+
+int main()
+{
+	EnterTempDirectory();
+
+	Test::Run("LZ4 round trip", TestLZ4RoundTrip);
+	Test::Run("LZ4 corruption", TestLZ4Corruption);
+	Test::Run("Archive round trip", TestArchiveRoundTrip);
+	Test::Run("Archive corruption", TestArchiveCorruption);
+	Test::Run("Stale entries", TestStaleEntries);
+	return Test::Finish();
+}
@@ -0,0 +1,124 @@
+// Throughput and quality of the block compression for the textures of the scene conversion
+// Metallic roughness is compressed as BC1 and as BC5 to compare the formats on the red and green channels the shading reads
+//
+// Usage: BCEncodingBenchmark [--size <pixels>] [--threads <count>] [--repeats <count>]
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include <Engine/Loading/BCEncoding.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using BCEncoding::Format;
+
+	struct Case
+	{
+		const char* Name;
+		BCEncoding::Format Format;
+		bool MetallicRoughness;
+		uint32_t ChannelMask;
+	};
+
+	// Same kind of images as BCEncodingTest, smooth values with some grain
+	std::vector<uint8_t> CreateImage(uint32_t size, bool metallicRoughness)
+	{
+		std::mt19937 random{ 1 };
+		std::vector<uint8_t> pixels((size_t) size * size * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+		{
+			const uint32_t c = i % 4;
+			const size_t x = i / 4 % size;
+			const size_t y = i / 4 / size;
+			if (metallicRoughness)
+			{
+				const float metallic = std::clamp(0.5f + 4.0f * std::sin(x * 0.11f) * std::cos(y * 0.07f), 0.0f, 1.0f);
+				const float roughness = 0.2f + 0.6f * (0.5f + 0.5f * std::sin(x * 0.03f + y * 0.05f));
+				if (c == 0) pixels[i] = (uint8_t) (metallic * 255.0f);
+				else if (c == 1) pixels[i] = (uint8_t) std::clamp(roughness * 255.0f + (float) (random() % 9) - 4.0f, 0.0f, 255.0f);
+				else pixels[i] = c == 2 ? (uint8_t) random() : 255;
+			}
+			else
+			{
+				const float wave = 0.5f + 0.5f * std::sin(x * 0.05f * (c + 1) + y * 0.04f * (4 - c));
+				pixels[i] = (uint8_t) std::min(255.0f, wave * 240.0f + random() % 16);
+			}
+		}
+		return pixels;
+	}
+
+	// Best time of the repeats in seconds
+	double MeasureEncode(Format format, const std::vector<uint8_t>& pixels, uint32_t size, uint32_t numThreads, uint32_t numRepeats, std::vector<uint8_t>& encoded)
+	{
+		double bestTime = 0.0;
+		for (uint32_t i = 0; i < numRepeats; i++)
+		{
+			const Clock::time_point startTime = Clock::now();
+			BCEncoding::Encode(format, pixels.data(), size, size, encoded.data(), numThreads);
+			const double time = std::chrono::duration<double>(Clock::now() - startTime).count();
+			bestTime = i == 0 ? time : std::min(bestTime, time);
+		}
+		return bestTime;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t size = 2048;
+	uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t numRepeats = 3;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--size" && i + 1 < argc) size = std::max(std::atoi(argv[++i]) / 4 * 4, 4);
+		else if (argument == "--threads" && i + 1 < argc) numThreads = std::max(std::atoi(argv[++i]), 1);
+		else if (argument == "--repeats" && i + 1 < argc) numRepeats = std::max(std::atoi(argv[++i]), 1);
+		else
+		{
+			std::cout << "Usage: BCEncodingBenchmark [--size <pixels>] [--threads <count>] [--repeats <count>]" << std::endl;
+			return 2;
+		}
+	}
+
+	const Case cases[] =
+	{
+		{ "Albedo BC7", Format::BC7, false, 0xF },
+		{ "Albedo BC1", Format::BC1, false, 0x7 },
+		{ "Normal BC5", Format::BC5, false, 0x3 },
+		{ "Metallic roughness BC1", Format::BC1, true, 0x3 },
+		{ "Metallic roughness BC5", Format::BC5, true, 0x3 },
+	};
+
+	const std::vector<uint8_t> colorImage = CreateImage(size, false);
+	const std::vector<uint8_t> metallicRoughnessImage = CreateImage(size, true);
+
+	std::cout << size << "x" << size << ", " << numThreads << " threads, best of " << numRepeats << " runs" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	const double megaPixels = (double) size * size / 1e6;
+	for (const Case& c : cases)
+	{
+		const std::vector<uint8_t>& pixels = c.MetallicRoughness ? metallicRoughnessImage : colorImage;
+		std::vector<uint8_t> encoded(BCEncoding::GetImageSize(c.Format, size, size));
+		const double serialTime = MeasureEncode(c.Format, pixels, size, 1, numRepeats, encoded);
+		const double parallelTime = MeasureEncode(c.Format, pixels, size, numThreads, numRepeats, encoded);
+
+		std::vector<uint8_t> decoded(pixels.size());
+		BCEncoding::Decode(c.Format, encoded.data(), size, size, decoded.data());
+		const double psnr = BCEncoding::CalculatePSNR(pixels.data(), decoded.data(), size, size, c.ChannelMask);
+
+		std::cout << "  " << std::left << std::setw(24) << c.Name << std::right;
+		std::cout << std::setw(10) << megaPixels / serialTime << " MPix/s";
+		std::cout << std::setw(10) << megaPixels / parallelTime << " MPix/s threaded";
+		std::cout << std::setw(10) << psnr << " dB" << std::endl;
+	}
+	return 0;
+}
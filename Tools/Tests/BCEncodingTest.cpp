@@ -0,0 +1,185 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Engine/Loading/BCEncoding.h>
+
+namespace
+{
+	using BCEncoding::Format;
+
+	constexpr uint32_t RED_GREEN = 0x3;
+
+	// Metallic in red is mostly 0 or 1 with soft edges, roughness in green is a smooth gradient with some grain
+	// Blue and alpha are what an exporter usually writes next to them
+	std::vector<uint8_t> CreateMetallicRoughnessImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::vector<uint8_t> pixels((size_t) width * height * 4);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint8_t* pixel = pixels.data() + ((size_t) y * width + x) * 4;
+				const float metallic = std::clamp(0.5f + 4.0f * std::sin(x * 0.11f) * std::cos(y * 0.07f), 0.0f, 1.0f);
+				const float roughness = 0.2f + 0.6f * (0.5f + 0.5f * std::sin(x * 0.03f + y * 0.05f));
+				pixel[0] = (uint8_t) (metallic * 255.0f);
+				pixel[1] = (uint8_t) std::clamp(roughness * 255.0f + (float) (random() % 9) - 4.0f, 0.0f, 255.0f);
+				pixel[2] = (uint8_t) (random() % 256);
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	// Smooth colors with a bit of noise in every channel
+	std::vector<uint8_t> CreateColorImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::vector<uint8_t> pixels((size_t) width * height * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+		{
+			const uint32_t c = i % 4;
+			const size_t x = i / 4 % width;
+			const size_t y = i / 4 / width;
+			const float wave = 0.5f + 0.5f * std::sin(x * 0.05f * (c + 1) + y * 0.04f * (4 - c));
+			pixels[i] = (uint8_t) std::min(255.0f, wave * 240.0f + random() % 16);
+		}
+		return pixels;
+	}
+
+	std::vector<uint8_t> EncodeAndDecode(Format format, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> encoded(BCEncoding::GetImageSize(format, width, height));
+		std::vector<uint8_t> decoded(pixels.size());
+		BCEncoding::Encode(format, pixels.data(), width, height, encoded.data(), 1);
+		BCEncoding::Decode(format, encoded.data(), width, height, decoded.data());
+		return decoded;
+	}
+
+	double GetPSNR(Format format, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint32_t channelMask)
+	{
+		const std::vector<uint8_t> decoded = EncodeAndDecode(format, pixels, width, height);
+		return BCEncoding::CalculatePSNR(pixels.data(), decoded.data(), width, height, channelMask);
+	}
+
+	// Block of one color is exact in BC5, within 1 in BC7 and within the 565 endpoints in BC1
+	void TestSolidBlocks()
+	{
+		std::mt19937 random{ 1 };
+		for (uint32_t i = 0; i < 200; i++)
+		{
+			const uint8_t color[4] = { (uint8_t) random(), (uint8_t) random(), (uint8_t) random(), (uint8_t) random() };
+			uint8_t block[BCEncoding::BLOCK_PIXELS * 4];
+			for (uint32_t p = 0; p < BCEncoding::BLOCK_PIXELS; p++) memcpy(block + p * 4, color, 4);
+
+			uint8_t encoded[16];
+			uint8_t decoded[BCEncoding::BLOCK_PIXELS * 4];
+			BCEncoding::EncodeBlockBC5(block, encoded);
+			BCEncoding::DecodeBlockBC5(encoded, decoded);
+			for (uint32_t p = 0; p < BCEncoding::BLOCK_PIXELS; p++) CHECK(decoded[p * 4] == color[0] && decoded[p * 4 + 1] == color[1]);
+
+			BCEncoding::EncodeBlockBC7(block, encoded);
+			BCEncoding::DecodeBlockBC7(encoded, decoded);
+			for (uint32_t v = 0; v < BCEncoding::BLOCK_PIXELS * 4; v++) CHECK(std::abs(decoded[v] - block[v]) <= 1);
+
+			BCEncoding::EncodeBlockBC1(block, encoded);
+			BCEncoding::DecodeBlockBC1(encoded, decoded);
+			for (uint32_t v = 0; v < BCEncoding::BLOCK_PIXELS * 4; v++) CHECK(v % 4 == 3 || std::abs(decoded[v] - block[v]) <= 8);
+		}
+	}
+
+	// BC5 keeps metallic and roughness apart and with 8 bit endpoints, BC1 spends its endpoints on the unused blue too
+	void TestMetallicRoughnessPSNR()
+	{
+		constexpr uint32_t SIZE = 256;
+		for (uint32_t seed : { 1u, 2u, 3u })
+		{
+			const std::vector<uint8_t> pixels = CreateMetallicRoughnessImage(SIZE, SIZE, seed);
+			const double bc5 = GetPSNR(Format::BC5, pixels, SIZE, SIZE, RED_GREEN);
+			const double bc1 = GetPSNR(Format::BC1, pixels, SIZE, SIZE, RED_GREEN);
+			CHECK(bc5 > 40.0);
+			CHECK(bc5 > bc1 + 10.0);
+
+			// Roughness alone, the channel that needs the precision for the highlights
+			CHECK(GetPSNR(Format::BC5, pixels, SIZE, SIZE, 0x2) > GetPSNR(Format::BC1, pixels, SIZE, SIZE, 0x2) + 10.0);
+		}
+	}
+
+	// Lower bound of the quality of every format on a smooth image, guards the encoder against regressions
+	void TestColorPSNR()
+	{
+		constexpr uint32_t SIZE = 128;
+		const std::vector<uint8_t> pixels = CreateColorImage(SIZE, SIZE, 1);
+		CHECK(GetPSNR(Format::BC1, pixels, SIZE, SIZE, 0x7) > 28.0);
+		CHECK(GetPSNR(Format::BC5, pixels, SIZE, SIZE, RED_GREEN) > 38.0);
+		CHECK(GetPSNR(Format::BC7, pixels, SIZE, SIZE, 0xF) > 28.0);
+		CHECK(std::isinf(GetPSNR(Format::RGBA8, pixels, SIZE, SIZE, 0xF)));
+	}
+
+	// Pixels past the edge repeat the last row and column, so the visible part matches the padded image
+	void TestPartialBlocks()
+	{
+		for (Format format : { Format::BC1, Format::BC5, Format::BC7 })
+		{
+			for (uint32_t size : { 1u, 2u, 3u, 5u, 7u })
+			{
+				const uint32_t width = size;
+				const uint32_t height = size + 2;
+				const uint32_t paddedWidth = (width + 3) / 4 * 4;
+				const uint32_t paddedHeight = (height + 3) / 4 * 4;
+
+				const std::vector<uint8_t> pixels = CreateColorImage(width, height, size);
+				std::vector<uint8_t> padded((size_t) paddedWidth * paddedHeight * 4);
+				for (uint32_t y = 0; y < paddedHeight; y++)
+				{
+					for (uint32_t x = 0; x < paddedWidth; x++)
+					{
+						const size_t source = ((size_t) std::min(y, height - 1) * width + std::min(x, width - 1)) * 4;
+						memcpy(padded.data() + ((size_t) y * paddedWidth + x) * 4, pixels.data() + source, 4);
+					}
+				}
+
+				std::vector<uint8_t> encoded(BCEncoding::GetImageSize(format, width, height));
+				std::vector<uint8_t> encodedPadded(BCEncoding::GetImageSize(format, paddedWidth, paddedHeight));
+				CHECK(encoded.size() == encodedPadded.size());
+				BCEncoding::Encode(format, pixels.data(), width, height, encoded.data(), 1);
+				BCEncoding::Encode(format, padded.data(), paddedWidth, paddedHeight, encodedPadded.data(), 1);
+				CHECK(encoded == encodedPadded);
+			}
+		}
+	}
+
+	// Rows of blocks split between any number of threads give the same blocks as one thread
+	void TestThreadCounts()
+	{
+		constexpr uint32_t WIDTH = 100;
+		constexpr uint32_t HEIGHT = 60;
+		const std::vector<uint8_t> pixels = CreateColorImage(WIDTH, HEIGHT, 2);
+		for (Format format : { Format::BC1, Format::BC5, Format::BC7 })
+		{
+			std::vector<uint8_t> serial(BCEncoding::GetImageSize(format, WIDTH, HEIGHT));
+			BCEncoding::Encode(format, pixels.data(), WIDTH, HEIGHT, serial.data(), 1);
+			for (uint32_t numThreads : { 2, 3, 7, 64, 0 })
+			{
+				std::vector<uint8_t> parallel(serial.size());
+				BCEncoding::Encode(format, pixels.data(), WIDTH, HEIGHT, parallel.data(), numThreads);
+				CHECK(parallel == serial);
+			}
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("Solid blocks", TestSolidBlocks);
+	Test::Run("Metallic roughness PSNR", TestMetallicRoughnessPSNR);
+	Test::Run("Color PSNR", TestColorPSNR);
+	Test::Run("Partial blocks", TestPartialBlocks);
+	Test::Run("Thread counts", TestThreadCounts);
+	return Test::Finish();
+}
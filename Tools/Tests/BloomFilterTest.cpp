@@ -0,0 +1,251 @@
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "Test.h"
+
+#include "Renderers/Util/BloomFilter.h"
+#include "Shaders/shared_definitions.h"
+
+namespace
+{
+	using Chain = std::vector<std::vector<Float4>>;
+
+	constexpr float TRESHOLD = 1.0f;
+	constexpr float KNEE = 0.5f;
+	constexpr float EXPOSURE = 1.0f;
+
+	std::vector<float> CreateImage(uint32_t width, uint32_t height, const Float4& color)
+	{
+		std::vector<float> pixels(4 * (size_t) width * height);
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			pixels[i + 0] = color.x;
+			pixels[i + 1] = color.y;
+			pixels[i + 2] = color.z;
+			pixels[i + 3] = color.w;
+		}
+		return pixels;
+	}
+
+	std::vector<float> CreateRandomImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> distribution{ 0.0f, 4.0f };
+
+		std::vector<float> pixels(4 * (size_t) width * height);
+		for (float& value : pixels) value = distribution(random);
+		return pixels;
+	}
+
+	// QuadraticThreshold of bloom.hlsl for a gray color
+	float ThresholdGray(float value)
+	{
+		float rq = std::clamp(value - (TRESHOLD - KNEE), 0.0f, 2.0f * KNEE);
+		rq = (0.25f / KNEE) * rq * rq;
+		return value * MAX(rq, value - TRESHOLD) / MAX(value, 0.0001f);
+	}
+
+	float MaxDifference(const Float4& a, const Float4& b)
+	{
+		const Float4 difference = (a - b).Abs();
+		return MAX(MAX(difference.x, difference.y), MAX(difference.z, difference.w));
+	}
+
+	// Same steps and indexing as the CS of bloom.hlsl, starting from the prefiltered level 0
+	// Groups reduce their tile in the group shared memory, texels out of the level are computed but never stored
+	Chain SimulateSinglePass(const std::vector<Float4>& level0, uint32_t bloomWidth, uint32_t bloomHeight)
+	{
+		constexpr uint32_t GROUP_SIZE = BLOOM_TILE_SIZE / 2;
+
+		Chain chain(BLOOM_NUM_LEVELS);
+		for (uint32_t level = 0; level < BLOOM_NUM_LEVELS; level++) chain[level].assign((size_t) (bloomWidth >> level) * (bloomHeight >> level), Float4{ NAN, NAN, NAN, NAN });
+
+		const auto store = [&](uint32_t level, uint32_t x, uint32_t y, const Float4& value)
+		{
+			if (x < (bloomWidth >> level) && y < (bloomHeight >> level)) chain[level][(size_t) y * (bloomWidth >> level) + x] = value;
+		};
+
+		// Prefilter of the texels out of the level 0 isn't zero on the GPU, it doesn't matter because no stored texel reads them
+		const auto prefilter = [&](uint32_t x, uint32_t y)
+		{
+			return x < bloomWidth && y < bloomHeight ? level0[(size_t) y * bloomWidth + x] : Float4{ 1000.0f, 1000.0f, 1000.0f, 1000.0f };
+		};
+
+		const uint32_t numGroupsX = (bloomWidth + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE;
+		const uint32_t numGroupsY = (bloomHeight + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE;
+		for (uint32_t groupY = 0; groupY < numGroupsY; groupY++)
+		{
+			for (uint32_t groupX = 0; groupX < numGroupsX; groupX++)
+			{
+				Float4 reductionTile[GROUP_SIZE][GROUP_SIZE];
+				for (uint32_t localY = 0; localY < GROUP_SIZE; localY++)
+				{
+					for (uint32_t localX = 0; localX < GROUP_SIZE; localX++)
+					{
+						const uint32_t x = groupX * GROUP_SIZE + localX;
+						const uint32_t y = groupY * GROUP_SIZE + localY;
+
+						Float4 value{};
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							const uint32_t childX = 2 * x + (i & 1);
+							const uint32_t childY = 2 * y + (i >> 1);
+							store(0, childX, childY, prefilter(childX, childY));
+							value += prefilter(childX, childY);
+						}
+						value *= 0.25f;
+
+						store(1, x, y, value);
+						reductionTile[localY][localX] = value;
+					}
+				}
+
+				for (uint32_t level = 2; level < BLOOM_NUM_LEVELS; level++)
+				{
+					const uint32_t levelTileSize = BLOOM_TILE_SIZE >> level;
+					for (uint32_t localY = 0; localY < levelTileSize; localY++)
+					{
+						for (uint32_t localX = 0; localX < levelTileSize; localX++)
+						{
+							Float4 value = reductionTile[2 * localY][2 * localX];
+							value += reductionTile[2 * localY][2 * localX + 1];
+							value += reductionTile[2 * localY + 1][2 * localX];
+							value += reductionTile[2 * localY + 1][2 * localX + 1];
+							value *= 0.25f;
+
+							// Texels are read at twice the coordinates, the in place write never overwrites one that is still read
+							reductionTile[localY][localX] = value;
+							store(level, groupX * levelTileSize + localX, groupY * levelTileSize + localY, value);
+						}
+					}
+				}
+			}
+		}
+		return chain;
+	}
+
+	// Group reduction of the shader stores the same chain as the reference, sizes not divisible by the tile included
+	void TestSinglePassMatchesReference()
+	{
+		const uint32_t sizes[][2] = { { 32, 32 }, { 64, 32 }, { 100, 60 }, { 910, 512 }, { 33, 97 } };
+
+		uint32_t seed = 1;
+		for (const uint32_t* size : sizes)
+		{
+			const uint32_t bloomWidth = size[0];
+			const uint32_t bloomHeight = size[1];
+			const std::vector<float> input = CreateRandomImage(2 * bloomWidth, 2 * bloomHeight, seed++);
+			const Chain reference = BloomFilter::GenerateReference(input.data(), 2 * bloomWidth, 2 * bloomHeight, bloomWidth, bloomHeight, TRESHOLD, KNEE, EXPOSURE);
+			const Chain singlePass = SimulateSinglePass(reference[0], bloomWidth, bloomHeight);
+
+			if (!CHECK(reference.size() == BLOOM_NUM_LEVELS)) continue;
+			for (uint32_t level = 0; level < BLOOM_NUM_LEVELS; level++)
+			{
+				if (!CHECK(reference[level].size() == singlePass[level].size())) continue;
+
+				// Sums are in a different order, the rounding differs a bit
+				float maxError = 0.0f;
+				for (size_t i = 0; i < reference[level].size(); i++) maxError = MAX(maxError, MaxDifference(reference[level][i], singlePass[level][i]));
+				if (!CHECK(maxError < 1e-5f)) std::cout << "  Size " << bloomWidth << "x" << bloomHeight << ", level " << level << std::endl;
+			}
+		}
+	}
+
+	// Soft knee of the threshold, dark pixels don't bloom and the curve is continuous around the knee
+	void TestThreshold()
+	{
+		const uint32_t bloomWidth = 64;
+		const uint32_t bloomHeight = 64;
+
+		const float values[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 8.0f, 100.0f };
+		for (float value : values)
+		{
+			const std::vector<float> input = CreateImage(2 * bloomWidth, 2 * bloomHeight, Float4{ value, value, value, 1.0f });
+			const Chain chain = BloomFilter::GenerateReference(input.data(), 2 * bloomWidth, 2 * bloomHeight, bloomWidth, bloomHeight, TRESHOLD, KNEE, EXPOSURE);
+
+			// Emissive clamp limits the brightness before the threshold
+			const float expected = ThresholdGray(MIN(value, 20.0f));
+			const Float4& center = chain[0][(bloomHeight / 2) * bloomWidth + bloomWidth / 2];
+			CHECK_NEAR(center.x, expected, 1e-4f * MAX(expected, 1.0f));
+			CHECK_NEAR(center.y, center.x, 1e-6f);
+			CHECK_NEAR(center.z, center.x, 1e-6f);
+		}
+
+		CHECK(ThresholdGray(TRESHOLD - KNEE) == 0.0f);
+		CHECK_NEAR(ThresholdGray(TRESHOLD + KNEE), KNEE, 1e-6f);
+
+		// Exposure is applied before the threshold
+		const std::vector<float> input = CreateImage(2 * bloomWidth, 2 * bloomHeight, Float4{ 1.0f, 1.0f, 1.0f, 1.0f });
+		const Chain chain = BloomFilter::GenerateReference(input.data(), 2 * bloomWidth, 2 * bloomHeight, bloomWidth, bloomHeight, TRESHOLD, KNEE, 4.0f);
+		CHECK_NEAR(chain[0][(bloomHeight / 2) * bloomWidth + bloomWidth / 2].x, ThresholdGray(4.0f), 1e-4f);
+	}
+
+	// Box reduction keeps the average of the level, the border only darkens the prefilter of the outer texels
+	void TestChainAverage()
+	{
+		const uint32_t bloomWidth = 256;
+		const uint32_t bloomHeight = 128;
+		const std::vector<float> input = CreateRandomImage(512, 256, 7);
+		const Chain chain = BloomFilter::GenerateReference(input.data(), 512, 256, bloomWidth, bloomHeight, TRESHOLD, KNEE, EXPOSURE);
+
+		const auto average = [](const std::vector<Float4>& level)
+		{
+			double sum = 0.0;
+			for (const Float4& value : level) sum += value.x;
+			return sum / level.size();
+		};
+
+		for (uint32_t level = 1; level < BLOOM_NUM_LEVELS; level++)
+		{
+			CHECK((bloomWidth >> level) * (bloomHeight >> level) == chain[level].size());
+			CHECK_NEAR(average(chain[level]), average(chain[0]), 1e-4 * average(chain[0]));
+		}
+	}
+
+	// Tent weights add up to one, every level of a constant chain adds the constant away from the border
+	void TestCompose()
+	{
+		const uint32_t bloomWidth = 256;
+		const uint32_t bloomHeight = 128;
+		const float value = 3.0f;
+		const std::vector<float> input = CreateImage(512, 256, Float4{ value, value, value, value });
+		const Chain chain = BloomFilter::GenerateReference(input.data(), 512, 256, bloomWidth, bloomHeight, TRESHOLD, KNEE, EXPOSURE);
+
+		const float levelValue = ThresholdGray(value);
+		const Float4 sampleScales[] = { Float4{ 1.0f, 1.0f, 1.0f, 0.0f }, Float4{ 0.5f, 0.5f, 0.5f, 0.0f }, Float4{ 1.0f, 2.0f, 0.25f, 0.0f } };
+		for (const Float4& sampleScale : sampleScales)
+		{
+			const Float4 bloom = BloomFilter::ComposeReference(chain, bloomWidth, bloomHeight, Float2{ 0.5f, 0.5f }, sampleScale);
+			CHECK_NEAR(bloom.x, BLOOM_NUM_LEVELS * levelValue, 1e-4f * BLOOM_NUM_LEVELS * levelValue);
+		}
+
+		// Corner is darkened by the zero border, the smallest level the most
+		const Float4 corner = BloomFilter::ComposeReference(chain, bloomWidth, bloomHeight, Float2{ 0.0f, 0.0f }, sampleScales[0]);
+		CHECK(corner.x < 0.5f * BLOOM_NUM_LEVELS * levelValue);
+		CHECK(corner.x > 0.0f);
+	}
+
+	void TestSampleLinearBorder()
+	{
+		const std::vector<Float4> image = { Float4{ 1.0f, 0.0f, 0.0f, 0.0f }, Float4{ 3.0f, 0.0f, 0.0f, 0.0f } };
+
+		// Texel centers, half way between them and the border of zero outside
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 0.25f, 0.5f }).x, 1.0f, 1e-6f);
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 0.75f, 0.5f }).x, 3.0f, 1e-6f);
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 0.5f, 0.5f }).x, 2.0f, 1e-6f);
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 0.0f, 0.5f }).x, 0.5f, 1e-6f);
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 0.75f, 0.0f }).x, 1.5f, 1e-6f);
+		CHECK_NEAR(BloomFilter::SampleLinearBorder(image, 2, 1, Float2{ 2.0f, 0.5f }).x, 0.0f, 1e-6f);
+	}
+}
+
+int main()
+{
+	Test::Run("Sample linear border", TestSampleLinearBorder);
+	Test::Run("Single pass matches reference", TestSinglePassMatchesReference);
+	Test::Run("Threshold", TestThreshold);
+	Test::Run("Chain average", TestChainAverage);
+	Test::Run("Compose", TestCompose);
+	return Test::Finish();
+}
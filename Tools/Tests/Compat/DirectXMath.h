@@ -0,0 +1,132 @@
+#pragma once
+
+// Scalar subset of DirectXMath that the engine math uses, so the tests build where the Windows SDK isn't available
+// Only used on the platforms without the real header, the results match it up to the rounding of the SIMD paths
+
+#include <cmath>
+#include <cstdint>
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+
+	struct XMVECTOR
+	{
+		float v[4];
+	};
+	using FXMVECTOR = const XMVECTOR&;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+
+	struct XMFLOAT2 { float x, y; };
+	struct XMFLOAT3 { float x, y, z; };
+	struct XMFLOAT4 { float x, y, z, w; };
+	struct XMFLOAT2A : XMFLOAT2 {};
+	struct XMFLOAT3A : XMFLOAT3 {};
+	struct XMFLOAT4A : XMFLOAT4 {};
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+	};
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return XMVECTOR{ { x, y, z, w } }; }
+	inline XMVECTOR XMVectorZero() { return XMVECTOR{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline XMVECTOR XMVectorReplicate(float value) { return XMVECTOR{ { value, value, value, value } }; }
+	inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w) { return XMVECTOR{ { v.v[0], v.v[1], v.v[2], w } }; }
+
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return XMVECTOR{ { v.v[0] * scale, v.v[1] * scale, v.v[2] * scale, v.v[3] * scale } }; }
+
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++) result.v[i] = a.v[i] * b.v[i] + c.v[i];
+		return result;
+	}
+
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++) result.v[i] = a.v[i] + t * (b.v[i] - a.v[i]);
+		return result;
+	}
+
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+	inline void XMStoreFloat2(XMFLOAT2* destination, FXMVECTOR v) { *destination = XMFLOAT2{ v.v[0], v.v[1] }; }
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v) { *destination = XMFLOAT3{ v.v[0], v.v[1], v.v[2] }; }
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { *destination = XMFLOAT4{ v.v[0], v.v[1], v.v[2], v.v[3] }; }
+
+	namespace Compat
+	{
+		// Dot product of the first n components replicated to every component
+		inline XMVECTOR Dot(FXMVECTOR a, FXMVECTOR b, int n)
+		{
+			float dot = 0.0f;
+			for (int i = 0; i < n; i++) dot += a.v[i] * b.v[i];
+			return XMVectorReplicate(dot);
+		}
+
+		inline XMVECTOR Normalize(FXMVECTOR v, int n)
+		{
+			const float length = std::sqrt(Dot(v, v, n).v[0]);
+			return length > 0.0f ? XMVectorScale(v, 1.0f / length) : v;
+		}
+	}
+
+	inline XMVECTOR XMVector2Dot(FXMVECTOR a, FXMVECTOR b) { return Compat::Dot(a, b, 2); }
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return Compat::Dot(a, b, 3); }
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return Compat::Dot(a, b, 4); }
+
+	inline XMVECTOR XMVector2LengthSq(FXMVECTOR v) { return Compat::Dot(v, v, 2); }
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return Compat::Dot(v, v, 3); }
+	inline XMVECTOR XMVector4LengthSq(FXMVECTOR v) { return Compat::Dot(v, v, 4); }
+
+	inline XMVECTOR XMVector2Length(FXMVECTOR v) { return XMVectorReplicate(std::sqrt(Compat::Dot(v, v, 2).v[0])); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorReplicate(std::sqrt(Compat::Dot(v, v, 3).v[0])); }
+	inline XMVECTOR XMVector4Length(FXMVECTOR v) { return XMVectorReplicate(std::sqrt(Compat::Dot(v, v, 4).v[0])); }
+	inline XMVECTOR XMVector2LengthEst(FXMVECTOR v) { return XMVector2Length(v); }
+	inline XMVECTOR XMVector3LengthEst(FXMVECTOR v) { return XMVector3Length(v); }
+	inline XMVECTOR XMVector4LengthEst(FXMVECTOR v) { return XMVector4Length(v); }
+
+	inline XMVECTOR XMVector2Normalize(FXMVECTOR v) { return Compat::Normalize(v, 2); }
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v) { return Compat::Normalize(v, 3); }
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v) { return Compat::Normalize(v, 4); }
+	inline XMVECTOR XMVector2NormalizeEst(FXMVECTOR v) { return XMVector2Normalize(v); }
+	inline XMVECTOR XMVector3NormalizeEst(FXMVECTOR v) { return XMVector3Normalize(v); }
+	inline XMVECTOR XMVector4NormalizeEst(FXMVECTOR v) { return XMVector4Normalize(v); }
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0], 0.0f);
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) result.r[i] = XMVectorSet(source->m[i][0], source->m[i][1], source->m[i][2], source->m[i][3]);
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, const XMMATRIX& matrix)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++) destination->m[i][j] = matrix.r[i].v[j];
+		}
+	}
+
+	inline XMMATRIX XMMatrixTranspose(const XMMATRIX& matrix)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++) result.r[i].v[j] = matrix.r[j].v[i];
+		}
+		return result;
+	}
+}
@@ -0,0 +1,222 @@
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Test.h"
+
+#include <Engine/Utility/ConcurrentCache.h>
+
+namespace
+{
+	constexpr uint32_t NUM_THREADS = 8;
+	constexpr uint32_t NUM_KEYS = 256;
+	constexpr uint32_t SHARD_COUNT = 16;
+
+	struct MockObject
+	{
+		uint64_t Key = 0;
+		uint32_t CreationIndex = 0;
+		std::vector<uint64_t> Payload;
+	};
+
+	using Cache = MTR::ConcurrentCache<MockObject, SHARD_COUNT>;
+
+	// Creation function that counts the calls of every key, can be held in the creation until it is opened
+	class MockCreation
+	{
+	public:
+		explicit MockCreation(bool startOpen = true) : m_Open(startOpen), m_NumCreations(NUM_KEYS) {}
+
+		auto GetFunc(uint64_t key)
+		{
+			return [this, key]()
+			{
+				const uint32_t creationIndex = m_NumCreations[key % NUM_KEYS]++;
+
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_NumCreating++;
+				m_StateChanged.notify_all();
+				m_StateChanged.wait(lock, [this] { return m_Open; });
+				m_NumCreating--;
+
+				// Written before the value is published, the threads that read it must see all of it
+				return MockObject{ key, creationIndex, std::vector<uint64_t>(64, key) };
+			};
+		}
+
+		void Open()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Open = true;
+			m_StateChanged.notify_all();
+		}
+
+		bool IsOpen()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Open;
+		}
+
+		void WaitCreating(uint32_t numCreating)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_StateChanged.wait(lock, [&] { return m_NumCreating == numCreating; });
+		}
+
+		uint32_t GetNumCreations(uint64_t key) const { return m_NumCreations[key % NUM_KEYS]; }
+
+	private:
+		std::mutex m_Mutex;
+		std::condition_variable m_StateChanged;
+		bool m_Open;
+		uint32_t m_NumCreating = 0;
+		std::vector<std::atomic<uint32_t>> m_NumCreations;
+	};
+
+	bool IsValid(const MockObject& object, uint64_t key)
+	{
+		return object.Key == key && object.CreationIndex == 0 && object.Payload.size() == 64 && object.Payload.back() == key;
+	}
+
+	// Threads ask for all keys in different orders, every key is created once and every thread gets the same object
+	void TestOneCreationPerKey()
+	{
+		constexpr uint32_t NUM_ROUNDS = 4;
+
+		Cache cache;
+		MockCreation creation;
+
+		std::vector<std::vector<const MockObject*>> results(NUM_THREADS, std::vector<const MockObject*>(NUM_KEYS));
+		std::vector<uint32_t> numInvalid(NUM_THREADS);
+		std::vector<std::thread> threads;
+		for (uint32_t threadIndex = 0; threadIndex < NUM_THREADS; threadIndex++)
+		{
+			threads.emplace_back([&, threadIndex]()
+			{
+				std::vector<uint64_t> keys(NUM_KEYS);
+				for (uint64_t key = 0; key < NUM_KEYS; key++) keys[key] = key;
+
+				std::mt19937 random{ threadIndex };
+				for (uint32_t round = 0; round < NUM_ROUNDS; round++)
+				{
+					std::shuffle(keys.begin(), keys.end(), random);
+					for (uint64_t key : keys)
+					{
+						const MockObject& object = cache.GetOrCreate(key, creation.GetFunc(key));
+						if (!IsValid(object, key)) numInvalid[threadIndex]++;
+
+						if (round == 0) results[threadIndex][key] = &object;
+						else if (results[threadIndex][key] != &object) numInvalid[threadIndex]++;
+					}
+				}
+			});
+		}
+		for (std::thread& thread : threads) thread.join();
+
+		for (uint32_t threadIndex = 0; threadIndex < NUM_THREADS; threadIndex++)
+		{
+			CHECK(numInvalid[threadIndex] == 0);
+			CHECK(results[threadIndex] == results[0]);
+		}
+
+		bool createdOnce = true;
+		for (uint64_t key = 0; key < NUM_KEYS; key++) createdOnce &= creation.GetNumCreations(key) == 1;
+		CHECK(createdOnce);
+
+		const Cache::Statistics statistics = cache.GetStatistics();
+		CHECK(statistics.NumMisses == NUM_KEYS);
+		CHECK(statistics.NumHits == NUM_THREADS * NUM_ROUNDS * NUM_KEYS - NUM_KEYS);
+		CHECK(statistics.NumSharedCreations <= statistics.NumHits);
+		CHECK(cache.GetSize() == NUM_KEYS);
+	}
+
+	// Threads that ask for the object that is being created wait for it instead of creating it again
+	// Other keys of the same shard don't wait for the creation
+	void TestSharedCreation()
+	{
+		constexpr uint64_t KEY = 7;
+		constexpr uint64_t SAME_SHARD_KEY = KEY + SHARD_COUNT;
+
+		Cache cache;
+		MockCreation creation{ false };
+
+		const MockObject* createdObject = nullptr;
+		std::thread creator([&]() { createdObject = &cache.GetOrCreate(KEY, creation.GetFunc(KEY)); });
+		creation.WaitCreating(1);
+
+		std::atomic<uint32_t> numArrived = 0;
+		std::vector<const MockObject*> results(NUM_THREADS);
+		std::vector<uint8_t> returnedOpen(NUM_THREADS);
+		std::vector<std::thread> waiters;
+		for (uint32_t threadIndex = 0; threadIndex < NUM_THREADS; threadIndex++)
+		{
+			waiters.emplace_back([&, threadIndex]()
+			{
+				numArrived++;
+				results[threadIndex] = &cache.GetOrCreate(KEY, creation.GetFunc(KEY));
+				returnedOpen[threadIndex] = creation.IsOpen();
+			});
+		}
+
+		// Lookup of the other key holds the shard lock only for the lookup, it can't wait for the first creation
+		MockCreation otherCreation;
+		std::future<const MockObject*> otherResult = std::async(std::launch::async, [&]() { return &cache.GetOrCreate(SAME_SHARD_KEY, otherCreation.GetFunc(SAME_SHARD_KEY)); });
+		const bool otherCreated = otherResult.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+		CHECK(otherCreated);
+
+		// Gives the waiters the time to get to the entry, the checks below don't depend on it
+		while (numArrived < NUM_THREADS) std::this_thread::yield();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		creation.Open();
+
+		creator.join();
+		for (std::thread& waiter : waiters) waiter.join();
+
+		CHECK(creation.GetNumCreations(KEY) == 1);
+		CHECK(IsValid(*createdObject, KEY));
+		for (uint32_t threadIndex = 0; threadIndex < NUM_THREADS; threadIndex++)
+		{
+			CHECK(results[threadIndex] == createdObject);
+			CHECK(returnedOpen[threadIndex]);
+		}
+
+		if (otherCreated) CHECK(IsValid(*otherResult.get(), SAME_SHARD_KEY));
+
+		const Cache::Statistics statistics = cache.GetStatistics();
+		CHECK(statistics.NumMisses == 2);
+		CHECK(statistics.NumHits == NUM_THREADS);
+		CHECK(statistics.NumSharedCreations >= 1);
+		CHECK(statistics.NumSharedCreations <= NUM_THREADS);
+	}
+
+	// Cleared cache creates the objects again
+	void TestClear()
+	{
+		Cache cache;
+		MockCreation creation;
+
+		for (uint64_t key = 0; key < NUM_KEYS; key++) cache.GetOrCreate(key, creation.GetFunc(key));
+		cache.Clear();
+		CHECK(cache.GetSize() == 0);
+
+		const MockObject& object = cache.GetOrCreate(3, creation.GetFunc(3));
+		CHECK(object.Key == 3);
+		CHECK(object.CreationIndex == 1);
+		CHECK(creation.GetNumCreations(3) == 2);
+		CHECK(cache.GetStatistics().NumMisses == NUM_KEYS + 1);
+	}
+}
+
+int main()
+{
+	Test::Run("One creation per key", TestOneCreationPerKey);
+	Test::Run("Shared creation", TestSharedCreation);
+	Test::Run("Clear", TestClear);
+	return Test::Finish();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Engine/Common.h>
+
+// Subset of Forward+/Scene/SceneGraph.h with the members the D3D12 free renderer code reads, the real header needs D3D12
+// Only the targets that build that code add the Fixtures directory, it's searched before the Forward+ directory
+
+struct BoundingSphere
+{
+	Float3 Center{ 0.0f, 0.0f, 0.0f };
+	float Radius{ 1.0f };
+};
+
+// Same test as the real frustum, the planes are set by the test
+struct ViewFrustum
+{
+	// Top Bottom Left Right Near Far
+	Float4 Planes[6];
+
+	bool IsInFrustum(const BoundingSphere& sphere) const
+	{
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			const float signedDistance = Planes[i].Dot(Float4(sphere.Center.x, sphere.Center.y, sphere.Center.z, 1.0f));
+			if (signedDistance < -sphere.Radius)
+				return false;
+
+			// Intersects plane
+			if (signedDistance < sphere.Radius)
+				return true;
+		}
+		return true;
+	}
+};
+
+struct Light
+{
+	uint32_t LightIndex = 0;
+
+	bool IsSpot = false;
+	Float3 Position = { 0.0f, 0.0f, 0.0f };
+	Float3 Radiance = { 0.0f, 0.0f, 0.0f };
+	Float2 Falloff = { 0.0f, 0.0f };			// (Start, End)
+};
+
+struct Camera
+{
+	enum class CameraType
+	{
+		Ortho,
+		Perspective,
+	};
+
+	struct CameraTransform
+	{
+		Float3 Position{ 0.0f, 2.0f, 0.0f };
+		Float3 Forward{ 1.0f, 0.0f, 0.0f };
+	};
+
+	CameraType Type = CameraType::Perspective;
+	float ZFar = 1000.0f;
+	float ZNear = 0.1f;
+
+	// Perspective data
+	float AspectRatio = 1.0f;
+	float FOV = 90.0f;
+
+	// Ortho data
+	float RectWidth = 0.0f;
+	float RectHeight = 0.0f;
+
+	CameraTransform CurrentTranform;
+	ViewFrustum CameraFrustum;
+};
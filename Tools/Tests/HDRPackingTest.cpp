@@ -0,0 +1,206 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Engine/Loading/HDRPacking.h>
+
+namespace
+{
+	using HDRPacking::ConversionReport;
+
+	constexpr uint32_t NUM_HALVES = 1 << 16;
+
+	bool IsSameReport(const ConversionReport& a, const ConversionReport& b)
+	{
+		return a.NumValues == b.NumValues && a.NumClamped == b.NumClamped && a.NumInvalid == b.NumInvalid && a.MaxMagnitude == b.MaxMagnitude;
+	}
+
+	// Random bit patterns cover NaN, infinity and the denormals, every third value is in the range of the formats
+	std::vector<float> CreateRandomFloats(size_t count, std::mt19937& random)
+	{
+		std::vector<float> values(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t bits = random();
+			memcpy(&values[i], &bits, sizeof(bits));
+			if (i % 3 == 0) values[i] = std::ldexp((float) (random() % 100000) / 1000.0f, (int) (random() % 40) - 30);
+		}
+		return values;
+	}
+
+	// Every half unpacks the same in both paths and every finite half packs back to the same bits, NaN stays NaN
+	void TestHalfRoundTrip()
+	{
+		std::vector<uint16_t> halves(NUM_HALVES);
+		for (uint32_t i = 0; i < NUM_HALVES; i++) halves[i] = (uint16_t) i;
+
+		std::vector<float> values(NUM_HALVES);
+		std::vector<float> reference(NUM_HALVES);
+		HDRPacking::FromHalf(halves.data(), halves.size(), values.data());
+		HDRPacking::FromHalfReference(halves.data(), halves.size(), reference.data());
+
+		std::vector<float> finite;
+		std::vector<uint16_t> finiteHalves;
+		uint32_t numNaNs = 0;
+		for (uint32_t i = 0; i < NUM_HALVES; i++)
+		{
+			if (std::isnan(values[i]))
+			{
+				numNaNs++;
+				CHECK(std::isnan(reference[i]));
+			}
+			else CHECK(memcmp(&values[i], &reference[i], sizeof(float)) == 0);
+
+			if (((i >> 10) & 0x1F) != 0x1F)
+			{
+				finite.push_back(values[i]);
+				finiteHalves.push_back((uint16_t) i);
+			}
+		}
+
+		// Exponent 31 with a mantissa, positive and negative
+		CHECK(numNaNs == 2 * 1023);
+
+		std::vector<uint16_t> packed(finite.size());
+		std::vector<uint16_t> packedReference(finite.size());
+		const ConversionReport report = HDRPacking::ToHalf(finite.data(), finite.size(), packed.data());
+		const ConversionReport reportReference = HDRPacking::ToHalfReference(finite.data(), finite.size(), packedReference.data());
+		CHECK(packed == finiteHalves);
+		CHECK(packedReference == finiteHalves);
+		CHECK(!report.HasErrors() && report.MaxMagnitude == HDRPacking::MAX_HALF);
+		CHECK(IsSameReport(report, reportReference));
+	}
+
+	// SSE2 matches the reference bit for bit, also for the counts that leave a tail, the relative error is under half a step
+	void TestHalfMatchesReference()
+	{
+		std::mt19937 random{ 3 };
+		const std::vector<float> values = CreateRandomFloats((1 << 18) + 5, random);
+
+		for (size_t count : { values.size(), values.size() - 5, (size_t) 7, (size_t) 1 })
+		{
+			std::vector<uint16_t> packed(count);
+			std::vector<uint16_t> reference(count);
+			const ConversionReport report = HDRPacking::ToHalf(values.data(), count, packed.data());
+			const ConversionReport reportReference = HDRPacking::ToHalfReference(values.data(), count, reference.data());
+			CHECK(packed == reference);
+			CHECK(IsSameReport(report, reportReference));
+		}
+
+		std::vector<uint16_t> packed(values.size());
+		HDRPacking::ToHalf(values.data(), values.size(), packed.data());
+		std::vector<float> unpacked(values.size());
+		HDRPacking::FromHalf(packed.data(), packed.size(), unpacked.data());
+
+		const float minNormal = std::ldexp(1.0f, -14);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (std::isnan(values[i]))
+			{
+				CHECK(unpacked[i] == 0.0f);
+				continue;
+			}
+
+			const float clamped = std::clamp(values[i], -HDRPacking::MAX_HALF, HDRPacking::MAX_HALF);
+			const double error = std::abs((double) unpacked[i] - clamped);
+			if (std::abs(clamped) >= minNormal) CHECK(error <= std::ldexp(std::abs((double) clamped), -11));
+			else CHECK(error <= std::ldexp(1.0, -25));
+		}
+	}
+
+	// NaN is written as 0 and counted as invalid, infinity and everything past the largest half is clamped
+	void TestHalfReport()
+	{
+		const float values[] = { 1.0f, -2.0f, std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(), -1e6f, 65504.0f, 65519.0f };
+		uint16_t packed[std::size(values)];
+		const ConversionReport report = HDRPacking::ToHalf(values, std::size(values), packed);
+		CHECK(report.NumValues == std::size(values));
+		CHECK(report.NumInvalid == 1);
+		CHECK(report.NumClamped == 3);
+		CHECK(report.HasErrors());
+		CHECK(packed[0] == 0x3C00 && packed[1] == 0xC000 && packed[2] == 0);
+		CHECK(packed[3] == 0x7BFF && packed[4] == 0xFBFF && packed[5] == 0x7BFF);
+
+		// Would round down to the largest half too, but it's past the range so it's counted
+		CHECK(packed[6] == 0x7BFF);
+	}
+
+	// SSE2 matches the reference, every channel is within a step of the shared exponent of the largest channel
+	void TestRGB9E5()
+	{
+		std::mt19937 random{ 5 };
+		const size_t numPixels = (1 << 16) + 3;
+		std::vector<float> pixels(numPixels * 4);
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++) pixels[i * 4 + c] = random() % 64 ? std::exp((float) (random() % 20000) / 1000.0f - 12.0f) : 0.0f;
+			pixels[i * 4 + 3] = 1.0f;
+		}
+
+		// First pixels hold NaN, a negative, infinity, a value past the range, the exact maximum and values that round up
+		pixels[0] = std::numeric_limits<float>::quiet_NaN();
+		pixels[1 * 4 + 1] = -1.0f;
+		pixels[2 * 4 + 2] = std::numeric_limits<float>::infinity();
+		pixels[3 * 4 + 1] = 1e6f;
+		pixels[5 * 4] = HDRPacking::MAX_RGB9E5;
+		pixels[5 * 4 + 1] = 65407.9f;
+		pixels[6 * 4] = 1.0f;
+		pixels[6 * 4 + 1] = 0.99999994f;
+
+		for (size_t count : { numPixels, numPixels - 3, (size_t) 1 })
+		{
+			std::vector<uint32_t> packed(count);
+			std::vector<uint32_t> reference(count);
+			const ConversionReport report = HDRPacking::ToRGB9E5(pixels.data(), count, packed.data());
+			const ConversionReport reportReference = HDRPacking::ToRGB9E5Reference(pixels.data(), count, reference.data());
+			CHECK(packed == reference);
+			CHECK(IsSameReport(report, reportReference));
+		}
+
+		std::vector<uint32_t> packed(numPixels);
+		const ConversionReport report = HDRPacking::ToRGB9E5(pixels.data(), numPixels, packed.data());
+		CHECK(report.NumValues == numPixels * 3);
+		CHECK(report.NumInvalid == 1);
+		CHECK(report.NumClamped == 3);
+
+		std::vector<float> unpacked(numPixels * 4);
+		std::vector<float> unpackedReference(numPixels * 4);
+		HDRPacking::FromRGB9E5(packed.data(), numPixels, unpacked.data());
+		HDRPacking::FromRGB9E5Reference(packed.data(), numPixels, unpackedReference.data());
+		CHECK(memcmp(unpacked.data(), unpackedReference.data(), unpacked.size() * sizeof(float)) == 0);
+
+		CHECK(unpacked[0] == 0.0f);
+		CHECK(unpacked[1 * 4 + 1] == 0.0f);
+		CHECK(unpacked[2 * 4 + 2] == HDRPacking::MAX_RGB9E5);
+		CHECK(unpacked[3 * 4 + 1] == HDRPacking::MAX_RGB9E5);
+		CHECK(unpacked[5 * 4] == HDRPacking::MAX_RGB9E5);
+		CHECK(unpacked[6 * 4] == 1.0f);
+
+		// 9 bit mantissa of the largest channel, smaller values under the smallest exponent are flushed
+		const float minValue = std::ldexp(1.0f, -15);
+		for (size_t i = 7; i < numPixels; i++)
+		{
+			const float* source = pixels.data() + i * 4;
+			const float* result = unpacked.data() + i * 4;
+			CHECK(result[3] == 1.0f);
+
+			const float maxChannel = std::max({ source[0], source[1], source[2] });
+			if (maxChannel < minValue) continue;
+			for (uint32_t c = 0; c < 3; c++) CHECK(std::abs((double) result[c] - source[c]) <= maxChannel / 512.0);
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("Half round trip", TestHalfRoundTrip);
+	Test::Run("Half matches reference", TestHalfMatchesReference);
+	Test::Run("Half report", TestHalfReport);
+	Test::Run("RGB9E5", TestRGB9E5);
+	return Test::Finish();
+}
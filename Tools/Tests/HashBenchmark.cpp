@@ -0,0 +1,77 @@
+// Throughput of the hashes over keys of the sizes that are hashed every frame
+// 16 bytes is a descriptor handle with the slot, 64 a render target set, 256 and 1024 the pipeline state descriptions
+//
+// Usage: HashBenchmark [--megabytes <count>]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include <Engine/Utility/Hash.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Hashes the keys one after another, the result is consumed so the loop isn't optimized out
+	template<typename HashFunc>
+	void BenchmarkHash(const char* name, const std::vector<uint8_t>& keys, size_t keySize, size_t numBytes, HashFunc hash)
+	{
+		const size_t numKeys = keys.size() / keySize;
+		const size_t numHashes = std::max<size_t>(numBytes / keySize, 1);
+
+		uint64_t result = 0;
+		const Clock::time_point startTime = Clock::now();
+		for (size_t i = 0; i < numHashes; i++)
+		{
+			result += hash(keys.data() + (i % numKeys) * keySize, keySize);
+		}
+		const double timeNS = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count();
+
+		std::cout << "  " << std::left << std::setw(12) << name << std::right;
+		std::cout << std::setw(10) << timeNS / numHashes << " ns per key";
+		std::cout << std::setw(10) << (double) numHashes * keySize / timeNS << " GB/s";
+		std::cout << "  (" << std::hex << (result & 0xFF) << std::dec << ")" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t numMegabytes = 256;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--megabytes" && i + 1 < argc) numMegabytes = std::max(std::atoi(argv[++i]), 1);
+		else
+		{
+			std::cout << "Usage: HashBenchmark [--megabytes <count>]" << std::endl;
+			return 2;
+		}
+	}
+
+	// Keys stay in the cache like the state of the frame does
+	std::mt19937 random{ 1 };
+	std::vector<uint8_t> keys(64 * 1024);
+	for (uint8_t& byte : keys) byte = (uint8_t) random();
+
+#ifdef HASH_HARDWARE_CRC32C
+	std::cout << "CRC32C uses " << (Hash::Private::HasHardwareCrc32C() ? "the SSE 4.2 instruction" : "the table") << std::endl;
+#endif
+
+	std::cout << std::fixed << std::setprecision(2);
+	for (size_t keySize : { 16, 64, 256, 1024 })
+	{
+		const size_t numBytes = numMegabytes * 1024 * 1024;
+		std::cout << keySize << " byte keys, " << numMegabytes << " MB" << std::endl;
+		BenchmarkHash("XXHash64", keys, keySize, numBytes, [](const uint8_t* bytes, size_t size) { return Hash::XXHash64(bytes, size); });
+		BenchmarkHash("CRC32C", keys, keySize, numBytes, [](const uint8_t* bytes, size_t size) { return (uint64_t) Hash::Crc32C(bytes, size); });
+		BenchmarkHash("CRC32", keys, keySize, numBytes / 4, [](const uint8_t* bytes, size_t size) { return (uint64_t) Hash::Crc32(bytes, size); });
+		BenchmarkHash("FNV-1a 64", keys, keySize, numBytes / 4, [](const uint8_t* bytes, size_t size) { return Hash::Fnv1a64(bytes, size); });
+	}
+	return 0;
+}
@@ -0,0 +1,237 @@
+#include <bit>
+#include <random>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "Test.h"
+
+#include <Engine/Utility/Hash.h>
+
+namespace
+{
+	constexpr uint64_t PRIME32 = 2654435761ull;
+	constexpr uint64_t PRIME64 = 11400714785074694797ull;
+
+	// Sanity buffer of the reference xxhsum, the published XXH64 values are made from it
+	std::vector<uint8_t> CreateSanityBuffer()
+	{
+		std::vector<uint8_t> buffer(2367);
+		uint64_t byteGen = PRIME32;
+		for (uint8_t& byte : buffer)
+		{
+			byte = (uint8_t) (byteGen >> 56);
+			byteGen *= PRIME64;
+		}
+		return buffer;
+	}
+
+	std::vector<uint8_t> CreateRandomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& byte : bytes) byte = (uint8_t) random();
+		return bytes;
+	}
+
+	uint64_t XXHash64(const std::string& text, uint64_t seed = 0)
+	{
+		return Hash::XXHash64(reinterpret_cast<const uint8_t*>(text.data()), text.size(), seed);
+	}
+
+	uint32_t Crc32C(const std::vector<uint8_t>& bytes)
+	{
+		return Hash::Crc32C(bytes.data(), bytes.size());
+	}
+
+	// Roughly the size of the pipeline state descriptions that are hashed every frame
+	struct StateKey
+	{
+		uint64_t Words[32] = {};
+	};
+
+	void TestXXHash64Vectors()
+	{
+		const std::vector<uint8_t> sanityBuffer = CreateSanityBuffer();
+		const auto sanity = [&](size_t size, uint64_t seed) { return Hash::XXHash64(sanityBuffer.data(), size, seed); };
+
+		CHECK(sanity(0, 0) == 0xEF46DB3751D8E999ull);
+		CHECK(sanity(0, PRIME32) == 0xAC75FDA2929B17EFull);
+		CHECK(sanity(1, 0) == 0xE934A84ADB052768ull);
+		CHECK(sanity(1, PRIME32) == 0x5014607643A9B4C3ull);
+		CHECK(sanity(4, 0) == 0x9136A0DCA57457EEull);
+		CHECK(sanity(14, 0) == 0x8282DCC4994E35C8ull);
+		CHECK(sanity(14, PRIME32) == 0xC3BD6BF63DEB6DF0ull);
+		CHECK(sanity(222, 0) == 0xB641AE8CB691C174ull);
+		CHECK(sanity(222, PRIME32) == 0x20CB8AB7AE10C14Aull);
+
+		CHECK(XXHash64("") == 0xEF46DB3751D8E999ull);
+		CHECK(XXHash64("a") == 0xD24EC4F1A98C6E5Bull);
+		CHECK(XXHash64("abc") == 0x44BC2CF5AD770999ull);
+		CHECK(XXHash64("xxhash") == 0x32DD38952C4BC720ull);
+		CHECK(XXHash64("xxhash", 20141025) == 0xB559B98D844E0635ull);
+		CHECK(XXHash64("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ull);
+
+		// Typed overloads hash the bytes of the value, the previous hash is the seed
+		const uint32_t value = 0x12345678;
+		CHECK(Hash::XXHash64(value) == Hash::XXHash64(reinterpret_cast<const uint8_t*>(&value), sizeof(value)));
+		CHECK(Hash::XXHash64(7ull, value) == Hash::XXHash64(reinterpret_cast<const uint8_t*>(&value), sizeof(value), 7));
+		CHECK(Hash::XXHash64(std::string("abc")) == 0x44BC2CF5AD770999ull);
+	}
+
+	// Stream gives the same hash however the bytes are split
+	void TestXXHash64Stream()
+	{
+		const std::vector<uint8_t> bytes = CreateRandomBytes(1000, 1);
+		std::mt19937 random{ 2 };
+
+		bool matches = true;
+		for (size_t size : { 0, 1, 31, 32, 33, 63, 64, 65, 100, 1000 })
+		{
+			for (uint64_t seed : { (uint64_t) 0, PRIME32 })
+			{
+				const uint64_t expected = Hash::XXHash64(bytes.data(), size, seed);
+				for (uint32_t split = 0; split < 20; split++)
+				{
+					Hash::XXHash64Stream stream{ seed };
+					size_t offset = 0;
+					while (offset < size)
+					{
+						const size_t chunk = std::min<size_t>(random() % 40 + (split == 0 ? 1 : 0), size - offset);
+						stream.Add(bytes.data() + offset, chunk);
+						offset += chunk;
+					}
+					matches &= stream.GetHash() == expected;
+				}
+			}
+		}
+		CHECK(matches);
+	}
+
+	// Test vectors of RFC 3720, section B.4 and the check value of the CRC catalogue
+	void TestCrc32CVectors()
+	{
+		const std::string check = "123456789";
+		CHECK(Hash::Crc32C(reinterpret_cast<const uint8_t*>(check.data()), check.size()) == 0xE3069283);
+
+		std::vector<uint8_t> ascending(32);
+		std::vector<uint8_t> descending(32);
+		for (uint32_t i = 0; i < 32; i++)
+		{
+			ascending[i] = (uint8_t) i;
+			descending[i] = (uint8_t) (31 - i);
+		}
+		CHECK(Crc32C(std::vector<uint8_t>(32, 0x00)) == 0x8A9136AA);
+		CHECK(Crc32C(std::vector<uint8_t>(32, 0xFF)) == 0x62A8AB43);
+		CHECK(Crc32C(ascending) == 0x46DD794E);
+		CHECK(Crc32C(descending) == 0x113FDB5C);
+		CHECK(Hash::Crc32C(nullptr, 0) == 0);
+
+		// Checksum continues over the next bytes
+		const std::vector<uint8_t> bytes = CreateRandomBytes(300, 3);
+		bool continues = true;
+		for (size_t split = 0; split <= bytes.size(); split += 7)
+		{
+			const uint32_t first = Hash::Crc32C(bytes.data(), split);
+			continues &= Hash::Crc32C(bytes.data() + split, bytes.size() - split, first) == Crc32C(bytes);
+		}
+		CHECK(continues);
+	}
+
+	// SSE 4.2 path and the table give the same checksum for every length and alignment
+	void TestCrc32CHardwareMatchesSoftware()
+	{
+#ifdef HASH_HARDWARE_CRC32C
+		if (!Hash::Private::HasHardwareCrc32C())
+		{
+			std::cout << "  CPU doesn't have SSE 4.2, only the software path is tested" << std::endl;
+			return;
+		}
+
+		const std::vector<uint8_t> bytes = CreateRandomBytes(1024 + 8, 4);
+		bool matches = true;
+		for (size_t offset = 0; offset < 8; offset++)
+		{
+			for (size_t size = 0; size <= 1024; size++)
+			{
+				for (uint32_t crc : { 0u, ~0u, 0x12345678u })
+				{
+					matches &= Hash::Private::Crc32CHardware(crc, bytes.data() + offset, size) == Hash::Private::Crc32CSoftware(crc, bytes.data() + offset, size);
+				}
+			}
+		}
+		CHECK(matches);
+#else
+		std::cout << "  Platform doesn't have the hardware CRC32C" << std::endl;
+#endif
+	}
+
+	// Check values of the CRC catalogue and the FNV reference
+	void TestOtherHashVectors()
+	{
+		const std::string check = "123456789";
+		CHECK(Hash::Crc32(check) == 0xCBF43926);
+		CHECK(Hash::Crc32(reinterpret_cast<const uint8_t*>(check.data()), check.size()) == 0xCBF43926);
+
+		const auto fnv = [](const std::string& text) { return Hash::Fnv1a64(reinterpret_cast<const uint8_t*>(text.data()), text.size()); };
+		CHECK(fnv("") == 0xCBF29CE484222325ull);
+		CHECK(fnv("a") == 0xAF63DC4C8601EC8Cull);
+		CHECK(fnv("foobar") == 0x85944171F73967E8ull);
+	}
+
+	// State keys that differ in one bit or one counter don't collide, one flipped bit changes about half of the hash
+	void TestCollisions()
+	{
+		constexpr uint32_t NUM_BITS = sizeof(StateKey) * 8;
+
+		std::mt19937_64 random{ 5 };
+		StateKey base;
+		for (uint64_t& word : base.Words) word = random();
+
+		std::unordered_set<uint64_t> xxHashes;
+		std::unordered_set<uint32_t> crcHashes;
+		uint64_t changedBits = 0;
+		const uint64_t baseHash = Hash::XXHash64(base);
+		xxHashes.insert(baseHash);
+		crcHashes.insert(Hash::Crc32C(base));
+		for (uint32_t bit = 0; bit < NUM_BITS; bit++)
+		{
+			StateKey key = base;
+			key.Words[bit / 64] ^= 1ull << (bit % 64);
+
+			const uint64_t hash = Hash::XXHash64(key);
+			xxHashes.insert(hash);
+			crcHashes.insert(Hash::Crc32C(key));
+			changedBits += std::popcount(hash ^ baseHash);
+		}
+		CHECK(xxHashes.size() == NUM_BITS + 1);
+		CHECK(crcHashes.size() == NUM_BITS + 1);
+		CHECK_NEAR((double) changedBits / NUM_BITS, 32.0, 1.0);
+
+		// Keys chained from small counters, the way the state keys are built field by field
+		constexpr uint32_t NUM_KEYS = 1 << 20;
+		std::unordered_set<uint64_t> chainedHashes;
+		chainedHashes.reserve(NUM_KEYS);
+		for (uint32_t i = 0; i < NUM_KEYS; i++)
+		{
+			uint64_t hash = Hash::XXHash64(i & 0x3FF);
+			hash = Hash::XXHash64(hash, i >> 10);
+			chainedHashes.insert(hash);
+		}
+		CHECK(chainedHashes.size() == NUM_KEYS);
+
+		// Chaining is order dependent, swapped fields are a different key
+		CHECK(Hash::XXHash64(Hash::XXHash64(1u), 2u) != Hash::XXHash64(Hash::XXHash64(2u), 1u));
+	}
+}
+
+int main()
+{
+	Test::Run("XXHash64 vectors", TestXXHash64Vectors);
+	Test::Run("XXHash64 stream", TestXXHash64Stream);
+	Test::Run("CRC32C vectors", TestCrc32CVectors);
+	Test::Run("CRC32C hardware matches software", TestCrc32CHardwareMatchesSoftware);
+	Test::Run("CRC32 and FNV-1a vectors", TestOtherHashVectors);
+	Test::Run("Collisions", TestCollisions);
+	return Test::Finish();
+}
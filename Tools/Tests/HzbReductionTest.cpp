@@ -0,0 +1,230 @@
+#include <random>
+#include <vector>
+
+#include "Test.h"
+
+#include "Renderers/Util/HzbReduction.h"
+#include "Shaders/shared_definitions.h"
+
+namespace
+{
+	using HZB = std::vector<std::vector<float>>;
+
+	std::vector<float> CreateDepth(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> distribution{ 0.0f, 1.0f };
+
+		std::vector<float> depth((size_t) width * height);
+		for (float& value : depth) value = distribution(random);
+		return depth;
+	}
+
+	// Same steps and indexing as the GENERATE_HZB pass of generate_hzb.hlsl
+	// Groups run one after another, the last one fixes the edges and reduces the tail of the chain
+	HZB SimulateSinglePass(const std::vector<float>& depth, uint32_t width, uint32_t height)
+	{
+		constexpr uint32_t GROUP_TILE = HZB_TILE_SIZE / 2;
+
+		const uint32_t numMips = HZBReduction::GetNumMips(width, height);
+		const auto getMipWidth = [&](uint32_t mip) { return MAX(width >> mip, 1u); };
+		const auto getMipHeight = [&](uint32_t mip) { return MAX(height >> mip, 1u); };
+
+		// Texels that are never written stay NaN so they fail the comparison
+		HZB hzb(numMips);
+		for (uint32_t mip = 0; mip < numMips; mip++) hzb[mip].assign((size_t) getMipWidth(mip) * getMipHeight(mip), NAN);
+
+		const auto write = [&](uint32_t mip, uint32_t x, uint32_t y, float value)
+		{
+			if (mip < numMips && x < getMipWidth(mip) && y < getMipHeight(mip)) hzb[mip][(size_t) y * getMipWidth(mip) + x] = value;
+		};
+
+		const uint32_t numGroupsX = (width + HZB_TILE_SIZE - 1) / HZB_TILE_SIZE;
+		const uint32_t numGroupsY = (height + HZB_TILE_SIZE - 1) / HZB_TILE_SIZE;
+		for (uint32_t groupY = 0; groupY < numGroupsY; groupY++)
+		{
+			for (uint32_t groupX = 0; groupX < numGroupsX; groupX++)
+			{
+				float groupShared[GROUP_TILE][GROUP_TILE];
+
+				// Mip 0 copy and mip 1 in the registers
+				for (uint32_t quadIndex = 0; quadIndex < GROUP_TILE * GROUP_TILE; quadIndex++)
+				{
+					const uint32_t localX = quadIndex % GROUP_TILE;
+					const uint32_t localY = quadIndex / GROUP_TILE;
+
+					float maxDepth = 0.0f;
+					for (uint32_t q = 0; q < 4; q++)
+					{
+						const uint32_t x = groupX * HZB_TILE_SIZE + 2 * localX + (q & 1);
+						const uint32_t y = groupY * HZB_TILE_SIZE + 2 * localY + (q >> 1);
+						if (x < width && y < height)
+						{
+							const float value = depth[(size_t) y * width + x];
+							write(0, x, y, value);
+							maxDepth = MAX(maxDepth, value);
+						}
+					}
+
+					groupShared[localY][localX] = maxDepth;
+					if (numMips > 1) write(1, groupX * GROUP_TILE + localX, groupY * GROUP_TILE + localY, maxDepth);
+				}
+
+				// Group mips reduce the group shared tile in place
+				for (uint32_t mip = 2; mip <= HZB_GROUP_MIPS; mip++)
+				{
+					const uint32_t mipTileSize = HZB_TILE_SIZE >> mip;
+
+					float reduced[GROUP_TILE][GROUP_TILE];
+					for (uint32_t y = 0; y < mipTileSize; y++)
+					{
+						for (uint32_t x = 0; x < mipTileSize; x++)
+						{
+							reduced[y][x] = MAX(MAX(groupShared[2 * y][2 * x], groupShared[2 * y][2 * x + 1]), MAX(groupShared[2 * y + 1][2 * x], groupShared[2 * y + 1][2 * x + 1]));
+						}
+					}
+
+					for (uint32_t y = 0; y < mipTileSize; y++)
+					{
+						for (uint32_t x = 0; x < mipTileSize; x++)
+						{
+							groupShared[y][x] = reduced[y][x];
+							write(mip, groupX * mipTileSize + x, groupY * mipTileSize + y, reduced[y][x]);
+						}
+					}
+				}
+			}
+		}
+
+		const auto reduceTexel = [&](uint32_t mip, uint32_t x, uint32_t y)
+		{
+			return HZBReduction::ReduceTexel(hzb[mip - 1].data(), getMipWidth(mip - 1), getMipHeight(mip - 1), getMipWidth(mip), getMipHeight(mip), x, y);
+		};
+
+		// Last group, right column and bottom row of the group mips
+		for (uint32_t mip = 1; mip <= HZB_GROUP_MIPS && mip < numMips; mip++)
+		{
+			const uint32_t mipWidth = getMipWidth(mip);
+			const uint32_t mipHeight = getMipHeight(mip);
+			for (uint32_t i = 0; i < mipWidth + mipHeight - 1; i++)
+			{
+				const uint32_t x = i < mipHeight ? mipWidth - 1 : i - mipHeight;
+				const uint32_t y = i < mipHeight ? i : mipHeight - 1;
+				write(mip, x, y, reduceTexel(mip, x, y));
+			}
+		}
+
+		// Tail of the chain
+		for (uint32_t mip = HZB_GROUP_MIPS + 1; mip < numMips; mip++)
+		{
+			for (uint32_t i = 0; i < getMipWidth(mip) * getMipHeight(mip); i++)
+			{
+				const uint32_t x = i % getMipWidth(mip);
+				const uint32_t y = i / getMipWidth(mip);
+				write(mip, x, y, reduceTexel(mip, x, y));
+			}
+		}
+
+		return hzb;
+	}
+
+	const uint32_t TEST_SIZES[][2] =
+	{
+		{ 1, 1 }, { 2, 2 }, { 1, 7 }, { 7, 1 }, { 5, 3 }, { 3, 5 },
+		{ 63, 65 }, { 64, 64 }, { 65, 64 }, { 99, 200 }, { 129, 67 },
+		{ 127, 127 }, { 257, 31 }, { 1283, 719 }, { 1920, 1080 },
+	};
+
+	void TestNumMips()
+	{
+		CHECK(HZBReduction::GetNumMips(1, 1) == 1);
+		CHECK(HZBReduction::GetNumMips(2, 2) == 1);
+		CHECK(HZBReduction::GetNumMips(3, 1) == 1);
+		CHECK(HZBReduction::GetNumMips(4, 1) == 2);
+		CHECK(HZBReduction::GetNumMips(1920, 1080) == 10);
+		CHECK(HZBReduction::GetNumMips(2048, 2048) == 11);
+		CHECK(HZBReduction::GetNumMips(1u << 20, 16) == HZB_MAX_MIPS);
+	}
+
+	// Single pass shader reduces the group mips from the tile in the group shared memory and fixes the edges at the end
+	// Its result has to be exactly the mip by mip reference
+	void TestSinglePassMatchesReference()
+	{
+		uint32_t seed = 1;
+		for (const uint32_t* size : TEST_SIZES)
+		{
+			const std::vector<float> depth = CreateDepth(size[0], size[1], seed++);
+			const HZB reference = HZBReduction::GenerateReference(depth.data(), size[0], size[1]);
+			const HZB singlePass = SimulateSinglePass(depth, size[0], size[1]);
+
+			CHECK(reference.size() == HZBReduction::GetNumMips(size[0], size[1]));
+			if (!CHECK(reference.size() == singlePass.size())) continue;
+
+			for (uint32_t mip = 0; mip < reference.size(); mip++)
+			{
+				CHECK(reference[mip].size() == (size_t) MAX(size[0] >> mip, 1u) * MAX(size[1] >> mip, 1u));
+				if (!CHECK(reference[mip] == singlePass[mip])) std::cout << "  Size " << size[0] << "x" << size[1] << ", mip " << mip << std::endl;
+			}
+		}
+	}
+
+	// Every depth texel is covered by the texel it maps to in every mip, the odd row and column included
+	void TestConservative()
+	{
+		uint32_t seed = 100;
+		for (const uint32_t* size : TEST_SIZES)
+		{
+			const uint32_t width = size[0];
+			const uint32_t height = size[1];
+			const std::vector<float> depth = CreateDepth(width, height, seed++);
+			const HZB hzb = HZBReduction::GenerateReference(depth.data(), width, height);
+
+			bool covered = true;
+			float maxDepth = 0.0f;
+			for (uint32_t y = 0; y < height; y++)
+			{
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const float value = depth[(size_t) y * width + x];
+					maxDepth = MAX(maxDepth, value);
+					for (uint32_t mip = 1; mip < hzb.size(); mip++)
+					{
+						const uint32_t mipWidth = MAX(width >> mip, 1u);
+						const uint32_t mipHeight = MAX(height >> mip, 1u);
+						const uint32_t mipX = MIN(x >> mip, mipWidth - 1);
+						const uint32_t mipY = MIN(y >> mip, mipHeight - 1);
+						covered &= hzb[mip][(size_t) mipY * mipWidth + mipX] >= value;
+					}
+				}
+			}
+			CHECK(covered);
+
+			// Nothing is made up, the last mip has the max of the whole depth
+			float lastMipMax = 0.0f;
+			for (float value : hzb.back()) lastMipMax = MAX(lastMipMax, value);
+			CHECK(lastMipMax == maxDepth);
+		}
+	}
+
+	// Odd size takes three children in the last column, the extra one is the only far texel
+	void TestOddEdge()
+	{
+		std::vector<float> depth(5 * 3, 0.1f);
+		depth[2 * 5 + 4] = 0.9f;
+
+		const HZB hzb = HZBReduction::GenerateReference(depth.data(), 5, 3);
+		CHECK(hzb.size() == 2);
+		CHECK(hzb[1].size() == 2);
+		CHECK(hzb[1][0] == 0.1f);
+		CHECK(hzb[1][1] == 0.9f);
+	}
+}
+
+int main()
+{
+	Test::Run("Number of mips", TestNumMips);
+	Test::Run("Single pass matches reference", TestSinglePassMatchesReference);
+	Test::Run("Conservative", TestConservative);
+	Test::Run("Odd edge", TestOddEdge);
+	return Test::Finish();
+}
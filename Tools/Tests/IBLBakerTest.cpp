@@ -0,0 +1,267 @@
+#include <vector>
+#include <functional>
+
+#include "Test.h"
+
+#include <Engine/Loading/HDRPacking.h>
+#include <Engine/Loading/TextureLoading.h>
+#include <Engine/Utility/FileUtility.h>
+
+#include "Renderers/Util/IBLBaker.h"
+
+namespace
+{
+	using RadianceFunc = std::function<Float3(const Float3& direction)>;
+
+	TextureLoading::ImageDataHDR CreatePanorama(uint32_t width, uint32_t height, const RadianceFunc& radiance)
+	{
+		TextureLoading::ImageDataHDR panorama{};
+		panorama.Width = width;
+		panorama.Height = height;
+		panorama.Pixels.resize(4 * (size_t) width * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const Float3 value = radiance(SphericalHarmonics::PanoramaTexelToDirection(x, y, width, height));
+				float* pixel = &panorama.Pixels[4 * ((size_t) y * width + x)];
+				pixel[0] = value.x;
+				pixel[1] = value.y;
+				pixel[2] = value.z;
+				pixel[3] = 1.0f;
+			}
+		}
+		return panorama;
+	}
+
+	// Small bake so the test runs in a moment
+	IBLBaker::BakeSettings GetTestSettings()
+	{
+		IBLBaker::BakeSettings settings{};
+		settings.CubemapSize = 32;
+		settings.NumMips = 4;
+		settings.NumSamples = 128;
+		settings.BRDFLutSize = 32;
+		settings.BRDFLutSamples = 256;
+		return settings;
+	}
+
+	std::vector<float> UnpackMip(const IBLBaker::BakedIBL& ibl, uint32_t face, uint32_t mip)
+	{
+		const uint32_t mipSize = MAX(ibl.Settings.CubemapSize >> mip, 1u);
+		const size_t numTexels = (size_t) mipSize * mipSize;
+		const uint8_t* texels = ibl.SpecularCubemap.data() + ibl.GetMipOffset(face, mip);
+
+		std::vector<float> pixels(4 * numTexels);
+		if (ibl.Settings.SpecularFormat == IBLBaker::CubemapFormat::RGB9E5) HDRPacking::FromRGB9E5(reinterpret_cast<const uint32_t*>(texels), numTexels, pixels.data());
+		else HDRPacking::FromHalf(reinterpret_cast<const uint16_t*>(texels), 4 * numTexels, pixels.data());
+		return pixels;
+	}
+
+	// Prefilter is normalized by the sample weights, a constant environment stays constant in every mip
+	void TestConstantEnvironment()
+	{
+		const Float3 color{ 2.0f, 1.0f, 0.5f };
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(128, 64, [&](const Float3&) { return color; });
+
+		for (IBLBaker::CubemapFormat format : { IBLBaker::CubemapFormat::RGB9E5, IBLBaker::CubemapFormat::RGBA16F })
+		{
+			IBLBaker::BakeSettings settings = GetTestSettings();
+			settings.SpecularFormat = format;
+			const IBLBaker::BakedIBL ibl = IBLBaker::Bake(panorama, settings);
+
+			CHECK(ibl.SpecularCubemap.size() == ibl.GetMipOffset(6, 0));
+
+			float maxError = 0.0f;
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				for (uint32_t mip = 0; mip < settings.NumMips; mip++)
+				{
+					const std::vector<float> pixels = UnpackMip(ibl, face, mip);
+					for (size_t i = 0; i < pixels.size(); i += 4)
+					{
+						maxError = MAX(maxError, std::abs(pixels[i + 0] - color.x) / color.x);
+						maxError = MAX(maxError, std::abs(pixels[i + 1] - color.y) / color.y);
+						maxError = MAX(maxError, std::abs(pixels[i + 2] - color.z) / color.z);
+					}
+				}
+			}
+
+			// RGB9E5 keeps 9 bits of the largest channel, the smallest one is 2 exponents lower
+			CHECK(maxError < (format == IBLBaker::CubemapFormat::RGB9E5 ? 1.5e-2f : 2e-3f));
+
+			const Float3 irradiance = SphericalHarmonics::Evaluate(ibl.IrradianceSH, Float3(0.0f, 1.0f, 0.0f));
+			CHECK((irradiance - color).Length() < 1e-2f);
+		}
+	}
+
+	// Mip 0 samples the panorama in the direction of the texel, face centers look along the axes in the D3D cubemap order
+	void TestCubemapFaces()
+	{
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(256, 128, [](const Float3& d) { return Float3(1.0f + d.x, 1.0f + d.y, 1.0f + d.z); });
+
+		IBLBaker::BakeSettings settings = GetTestSettings();
+		settings.SpecularFormat = IBLBaker::CubemapFormat::RGBA16F;
+		const IBLBaker::BakedIBL ibl = IBLBaker::Bake(panorama, settings);
+
+		const Float3 faceDirections[6] = { Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f) };
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			const std::vector<float> pixels = UnpackMip(ibl, face, 0);
+
+			// Average of the 4 center texels is the face direction
+			const uint32_t size = settings.CubemapSize;
+			Float3 center{ 0.0f, 0.0f, 0.0f };
+			for (uint32_t y = size / 2 - 1; y <= size / 2; y++)
+			{
+				for (uint32_t x = size / 2 - 1; x <= size / 2; x++)
+				{
+					const float* pixel = &pixels[4 * (y * size + x)];
+					center += 0.25f * Float3(pixel[0], pixel[1], pixel[2]);
+				}
+			}
+
+			const Float3 expected = Float3(1.0f, 1.0f, 1.0f) + faceDirections[face];
+			CHECK((center - expected).Length() < 2e-2f);
+		}
+	}
+
+	// Importance sampled prefilter against brute force integration of the GGX lobe over the panorama
+	void TestGGXPrefilter()
+	{
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(256, 128, [](const Float3& d)
+		{
+			const float lobe = powf(MAX(d.y, 0.0f), 4.0f);
+			return Float3(0.1f + lobe, 0.1f + 0.5f * lobe, 0.1f + MAX(d.x, 0.0f));
+		});
+
+		const float error64 = IBLBaker::ValidateSpecular(panorama, 64);
+		const float error512 = IBLBaker::ValidateSpecular(panorama, 512);
+		// Sharp lobe is undersampled with 64 samples at low roughness, the error goes down with the samples
+		CHECK(error64 < 0.5f);
+		CHECK(error512 < 0.06f);
+		CHECK(error512 < 0.25f * error64);
+	}
+
+	// Split sum scale and bias against numerical quadrature over the hemisphere
+	void TestBRDFLut()
+	{
+		CHECK(IBLBaker::ValidateBRDFLut(64) < 0.03f);
+		CHECK(IBLBaker::ValidateBRDFLut(1024) < 0.01f);
+
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(16, 8, [](const Float3&) { return Float3(1.0f, 1.0f, 1.0f); });
+		const IBLBaker::BakeSettings settings = GetTestSettings();
+		const IBLBaker::BakedIBL ibl = IBLBaker::Bake(panorama, settings);
+
+		const uint32_t size = settings.BRDFLutSize;
+		CHECK(ibl.BRDFLut.size() == 2 * (size_t) size * size);
+
+		std::vector<float> lut(ibl.BRDFLut.size());
+		HDRPacking::FromHalf(ibl.BRDFLut.data(), lut.size(), lut.data());
+
+		// Scale and bias are positive and energy is never gained, F0 = 1 gives scale + bias
+		bool valid = true;
+		for (size_t i = 0; i < lut.size(); i += 2)
+		{
+			valid &= lut[i] >= 0.0f && lut[i + 1] >= 0.0f && lut[i] + lut[i + 1] <= 1.001f;
+		}
+		CHECK(valid);
+
+		// Smooth surface looking straight at the normal reflects everything, x is NdotV and y is roughness
+		const float* smoothFacing = &lut[2 * (size_t) (size - 1)];
+		CHECK(smoothFacing[0] + smoothFacing[1] > 0.97f);
+
+		// Rough surface at grazing angles loses most of the energy to the masking
+		const float* roughGrazing = &lut[2 * (size_t) (size - 1) * size];
+		CHECK(roughGrazing[0] + roughGrazing[1] < 0.7f);
+	}
+
+	// Bake doesn't depend on the scheduling of the threads, so the same input has the same bits
+	void TestDeterministic()
+	{
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(64, 32, [](const Float3& d) { return Float3(1.0f + d.x, 2.0f + d.y * d.z, 0.5f); });
+		const IBLBaker::BakedIBL first = IBLBaker::Bake(panorama, GetTestSettings());
+		const IBLBaker::BakedIBL second = IBLBaker::Bake(panorama, GetTestSettings());
+		CHECK(first.SpecularCubemap == second.SpecularCubemap);
+		CHECK(first.BRDFLut == second.BRDFLut);
+	}
+
+	void TestCacheRoundTrip()
+	{
+		const std::string directory = Test::CreateTempDirectory("IBLBakerTest");
+		const std::string cachePath = directory + "/test.ibl";
+		constexpr uint64_t SOURCE_HASH = 0x1234abcd5678ef90ull;
+
+		const TextureLoading::ImageDataHDR panorama = CreatePanorama(64, 32, [](const Float3& d) { return Float3(1.0f + d.x, 1.0f, 1.0f - d.z); });
+		const IBLBaker::BakeSettings settings = GetTestSettings();
+		const IBLBaker::BakedIBL ibl = IBLBaker::Bake(panorama, settings);
+
+		IBLBaker::BakedIBL loaded{};
+		CHECK(!IBLBaker::LoadCache(cachePath, SOURCE_HASH, settings, loaded));
+		IBLBaker::SaveCache(cachePath, SOURCE_HASH, ibl);
+
+		CHECK(IBLBaker::LoadCache(cachePath, SOURCE_HASH, settings, loaded));
+		CHECK(loaded.Settings == settings);
+		CHECK(loaded.SpecularCubemap == ibl.SpecularCubemap);
+		CHECK(loaded.BRDFLut == ibl.BRDFLut);
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			CHECK((loaded.IrradianceSH.Coefficients[i] - ibl.IrradianceSH.Coefficients[i]).Length() == 0.0f);
+		}
+
+		// Different source or settings
+		IBLBaker::BakedIBL rejected{};
+		CHECK(!IBLBaker::LoadCache(cachePath, SOURCE_HASH + 1, settings, rejected));
+		CHECK(!IBLBaker::LoadCache(cachePath, SOURCE_HASH ^ (1ull << 40), settings, rejected));
+
+		IBLBaker::BakeSettings otherSettings = settings;
+		otherSettings.NumSamples *= 2;
+		CHECK(!IBLBaker::LoadCache(cachePath, SOURCE_HASH, otherSettings, rejected));
+
+		otherSettings = settings;
+		otherSettings.SpecularFormat = IBLBaker::CubemapFormat::RGBA16F;
+		CHECK(!IBLBaker::LoadCache(cachePath, SOURCE_HASH, otherSettings, rejected));
+
+		std::vector<uint8_t> content;
+		CHECK(FileUtility::ReadBinaryFile(cachePath, content));
+
+		const auto loadModified = [&](const std::vector<uint8_t>& modified)
+		{
+			const std::string modifiedPath = directory + "/modified.ibl";
+			CHECK(FileUtility::WriteBinaryFile(modifiedPath, modified.data(), modified.size()));
+
+			IBLBaker::BakedIBL result{};
+			return IBLBaker::LoadCache(modifiedPath, SOURCE_HASH, settings, result);
+		};
+
+		// Version is the second field of the header, after the magic
+		std::vector<uint8_t> otherVersion = content;
+		otherVersion[4]++;
+		CHECK(!loadModified(otherVersion));
+
+		std::vector<uint8_t> otherMagic = content;
+		otherMagic[0]++;
+		CHECK(!loadModified(otherMagic));
+
+		// Truncated and extended files
+		CHECK(!loadModified(std::vector<uint8_t>(content.begin(), content.end() - 1)));
+		CHECK(!loadModified(std::vector<uint8_t>(content.begin(), content.begin() + 8)));
+		std::vector<uint8_t> extended = content;
+		extended.push_back(0);
+		CHECK(!loadModified(extended));
+
+		// Unmodified copy still loads
+		CHECK(loadModified(content));
+	}
+}
+
+int main()
+{
+	Test::Run("Constant environment", TestConstantEnvironment);
+	Test::Run("Cubemap faces", TestCubemapFaces);
+	Test::Run("GGX prefilter", TestGGXPrefilter);
+	Test::Run("BRDF LUT", TestBRDFLut);
+	Test::Run("Deterministic", TestDeterministic);
+	Test::Run("Cache round trip", TestCacheRoundTrip);
+	return Test::Finish();
+}
@@ -0,0 +1,347 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Engine/Utility/MemoryStrategies.h>
+
+namespace
+{
+	// Tracks which texels of the atlas are taken to find overlapping tiles
+	class AtlasCoverage
+	{
+	public:
+		AtlasCoverage(uint32_t atlasSize, uint32_t minTileSize) :
+			m_CellSize(minTileSize),
+			m_NumCells(atlasSize / minTileSize),
+			m_Cells(m_NumCells * m_NumCells, false) {}
+
+		// Fails if the tile is out of the atlas, isn't aligned to its size or overlaps another tile
+		bool Add(const AtlasAllocation& tile)
+		{
+			if (tile.X % tile.Size != 0 || tile.Y % tile.Size != 0) return false;
+			if ((tile.X + tile.Size) / m_CellSize > m_NumCells || (tile.Y + tile.Size) / m_CellSize > m_NumCells) return false;
+
+			bool overlaps = false;
+			ForEachCell(tile, [&](std::vector<bool>::reference cell) { overlaps |= cell; cell = true; });
+			return !overlaps;
+		}
+
+		void Remove(const AtlasAllocation& tile)
+		{
+			ForEachCell(tile, [&](std::vector<bool>::reference cell) { cell = false; });
+		}
+
+	private:
+		template<typename CellFunc>
+		void ForEachCell(const AtlasAllocation& tile, CellFunc func)
+		{
+			for (uint32_t y = tile.Y / m_CellSize; y < (tile.Y + tile.Size) / m_CellSize; y++)
+			{
+				for (uint32_t x = tile.X / m_CellSize; x < (tile.X + tile.Size) / m_CellSize; x++)
+				{
+					func(m_Cells[y * m_NumCells + x]);
+				}
+			}
+		}
+
+	private:
+		uint32_t m_CellSize;
+		uint32_t m_NumCells;
+		std::vector<bool> m_Cells;
+	};
+
+	// Ranges follow each other from 0, the capacity always covers them
+	bool IsContiguous(const std::vector<RangeAllocation>& ranges, const GrowingRangeStrategy& allocator)
+	{
+		size_t next = 0;
+		for (const RangeAllocation& range : ranges)
+		{
+			if (range.Start != next) return false;
+			next += range.NumElements;
+		}
+		return next == allocator.GetSize() && allocator.GetCapacity() >= allocator.GetSize();
+	}
+
+	// Reserve grows to exactly what is needed, allocations that fit don't grow and the others grow by half
+	void TestGrowingRangeReserve()
+	{
+		GrowingRangeStrategy allocator{ 1 };
+		allocator.Reserve(1000);
+		CHECK(allocator.GetCapacity() == 1000);
+		CHECK(allocator.GetNumGrowths() == 1);
+
+		CHECK(allocator.Allocate(600).Start == 0);
+		CHECK(allocator.Allocate(400).Start == 600);
+		CHECK(allocator.GetNumGrowths() == 1);
+
+		CHECK(allocator.Allocate(1).Start == 1000);
+		CHECK(allocator.GetCapacity() == 1500);
+		CHECK(allocator.GetNumGrowths() == 2);
+
+		// Allocation bigger than the half grows to exactly its end
+		CHECK(allocator.Allocate(5000).Start == 1001);
+		CHECK(allocator.GetCapacity() == 6001);
+
+		// Reserve that already fits and an empty allocation don't grow
+		allocator.Reserve(0);
+		allocator.Allocate(0);
+		CHECK(allocator.GetNumGrowths() == 3);
+
+		// Clear keeps the capacity, the same allocations again don't grow
+		allocator.Clear();
+		CHECK(allocator.GetSize() == 0 && allocator.GetCapacity() == 6001);
+		CHECK(allocator.Allocate(6001).Start == 0);
+		CHECK(allocator.GetNumGrowths() == 3);
+	}
+
+	// Random additions stay contiguous and the number of growths is logarithmic in the size
+	void TestGrowingRangeRandomAdditions()
+	{
+		std::mt19937 random{ 7 };
+		for (uint32_t pass = 0; pass < 50; pass++)
+		{
+			GrowingRangeStrategy allocator{ 1 };
+			std::vector<RangeAllocation> ranges;
+			size_t numExactGrowths = 0;
+			size_t capacity = 1;
+			for (uint32_t i = 0; i < 2000; i++)
+			{
+				// Mostly small meshes with a big one now and then, the reserved scenes are added at once
+				const size_t numElements = random() % 20 == 0 ? random() % 100000 : random() % 500;
+				if (random() % 100 == 0)
+				{
+					allocator.Reserve(numElements);
+					continue;
+				}
+				ranges.push_back(allocator.Allocate(numElements));
+
+				// Growing to the exact size needs a growth on every allocation that doesn't fit
+				if (allocator.GetSize() > capacity)
+				{
+					capacity = allocator.GetSize();
+					numExactGrowths++;
+				}
+			}
+			CHECK(IsContiguous(ranges, allocator));
+
+			// Every growth but the reserves is at least a half, 1.5^n has to reach the size
+			const double maxGrowths = std::log((double) allocator.GetSize()) / std::log(1.5) + 1.0 + 2000 / 100 * 2;
+			CHECK(allocator.GetNumGrowths() <= maxGrowths);
+			CHECK(allocator.GetNumGrowths() * 10 < numExactGrowths);
+		}
+	}
+
+	// Scene that reserves its meshes first grows once however many meshes it has
+	void TestGrowingRangeReservedScene()
+	{
+		std::mt19937 random{ 8 };
+		std::vector<size_t> meshSizes(10000);
+		size_t total = 0;
+		for (size_t& size : meshSizes)
+		{
+			size = random() % 3000;
+			total += size;
+		}
+
+		GrowingRangeStrategy allocator{ 1 };
+		allocator.Reserve(total);
+		std::vector<RangeAllocation> ranges;
+		for (size_t size : meshSizes) ranges.push_back(allocator.Allocate(size));
+		CHECK(allocator.GetNumGrowths() == 1);
+		CHECK(allocator.GetCapacity() == total);
+		CHECK(IsContiguous(ranges, allocator));
+
+		// Second scene on top of it reserves only the difference
+		allocator.Reserve(total);
+		CHECK(allocator.GetCapacity() == 2 * total);
+		CHECK(allocator.GetNumGrowths() == 2);
+	}
+
+	void TestQuadTreeWholeAtlas()
+	{
+		QuadTreeStrategy allocator{ 1024, 64 };
+
+		AtlasAllocation tile = allocator.Allocate(1024);
+		CHECK(tile.IsValid() && tile.X == 0 && tile.Y == 0 && tile.Size == 1024);
+		CHECK(allocator.GetOccupancy() == 1.0f);
+		CHECK(!allocator.Allocate(64).IsValid());
+
+		allocator.Release(tile);
+		CHECK(!tile.IsValid());
+		CHECK(allocator.GetUsedArea() == 0);
+		CHECK(allocator.Allocate(1024).IsValid());
+	}
+
+	void TestQuadTreeInvalidSizes()
+	{
+		QuadTreeStrategy allocator{ 1024, 64 };
+
+		CHECK(!allocator.Allocate(0).IsValid());
+		CHECK(!allocator.Allocate(100).IsValid());
+		CHECK(!allocator.Allocate(32).IsValid());
+		CHECK(!allocator.Allocate(2048).IsValid());
+		CHECK(allocator.GetUsedArea() == 0);
+
+		// Releasing an invalid allocation does nothing
+		AtlasAllocation invalid{};
+		allocator.Release(invalid);
+		CHECK(allocator.Allocate(1024).IsValid());
+	}
+
+	void TestQuadTreeTopLeftFirst()
+	{
+		QuadTreeStrategy allocator{ 256, 64 };
+
+		const AtlasAllocation first = allocator.Allocate(64);
+		const AtlasAllocation second = allocator.Allocate(64);
+		const AtlasAllocation third = allocator.Allocate(64);
+		const AtlasAllocation fourth = allocator.Allocate(64);
+		CHECK(first.X == 0 && first.Y == 0);
+		CHECK(second.X == 64 && second.Y == 0);
+		CHECK(third.X == 0 && third.Y == 64);
+		CHECK(fourth.X == 64 && fourth.Y == 64);
+
+		// First quadrant is full, the next tile goes to the top right one
+		const AtlasAllocation fifth = allocator.Allocate(64);
+		CHECK(fifth.X == 128 && fifth.Y == 0);
+	}
+
+	void TestQuadTreeFillWithMinTiles()
+	{
+		constexpr uint32_t ATLAS_SIZE = 512;
+		constexpr uint32_t MIN_TILE_SIZE = 32;
+		constexpr uint32_t NUM_TILES = (ATLAS_SIZE / MIN_TILE_SIZE) * (ATLAS_SIZE / MIN_TILE_SIZE);
+
+		QuadTreeStrategy allocator{ ATLAS_SIZE, MIN_TILE_SIZE };
+		AtlasCoverage coverage{ ATLAS_SIZE, MIN_TILE_SIZE };
+
+		std::vector<AtlasAllocation> tiles;
+		for (uint32_t i = 0; i < NUM_TILES; i++)
+		{
+			tiles.push_back(allocator.Allocate(MIN_TILE_SIZE));
+			CHECK(tiles.back().IsValid() && coverage.Add(tiles.back()));
+		}
+		CHECK(allocator.GetOccupancy() == 1.0f);
+		CHECK(!allocator.Allocate(MIN_TILE_SIZE).IsValid());
+
+		// Everything merges back into the whole atlas
+		for (AtlasAllocation& tile : tiles) allocator.Release(tile);
+		CHECK(allocator.GetUsedArea() == 0);
+		CHECK(allocator.Allocate(ATLAS_SIZE).IsValid());
+	}
+
+	void TestQuadTreeMergeNeedsAllSiblings()
+	{
+		QuadTreeStrategy allocator{ 256, 64 };
+
+		std::vector<AtlasAllocation> tiles;
+		for (uint32_t i = 0; i < 4; i++) tiles.push_back(allocator.Allocate(128));
+
+		// Three free quadrants don't make the whole atlas
+		for (uint32_t i = 0; i < 3; i++) allocator.Release(tiles[i]);
+		CHECK(!allocator.Allocate(256).IsValid());
+
+		// Free quadrant is split for the smaller tile, releasing it merges the quadrant back
+		AtlasAllocation small = allocator.Allocate(64);
+		CHECK(small.IsValid() && small.X == 0 && small.Y == 0);
+		allocator.Release(small);
+
+		allocator.Release(tiles[3]);
+		CHECK(allocator.Allocate(256).IsValid());
+	}
+
+	// Random allocations and releases never overlap, and the used area matches the live tiles
+	void TestQuadTreeRandomChurn()
+	{
+		constexpr uint32_t ATLAS_SIZE = 2048;
+		constexpr uint32_t MIN_TILE_SIZE = 32;
+
+		QuadTreeStrategy allocator{ ATLAS_SIZE, MIN_TILE_SIZE };
+		AtlasCoverage coverage{ ATLAS_SIZE, MIN_TILE_SIZE };
+
+		std::mt19937 random{ 1234 };
+		std::uniform_int_distribution<uint32_t> sizeShift{ 0, 5 };
+
+		std::vector<AtlasAllocation> tiles;
+		uint64_t usedArea = 0;
+		bool valid = true;
+		for (uint32_t i = 0; i < 20000; i++)
+		{
+			if (!tiles.empty() && random() % 3 == 0)
+			{
+				const size_t index = random() % tiles.size();
+				coverage.Remove(tiles[index]);
+				usedArea -= (uint64_t) tiles[index].Size * tiles[index].Size;
+				allocator.Release(tiles[index]);
+				tiles[index] = tiles.back();
+				tiles.pop_back();
+			}
+			else
+			{
+				const AtlasAllocation tile = allocator.Allocate(MIN_TILE_SIZE << sizeShift(random));
+				if (!tile.IsValid()) continue;
+
+				valid &= coverage.Add(tile);
+				usedArea += (uint64_t) tile.Size * tile.Size;
+				tiles.push_back(tile);
+			}
+			valid &= allocator.GetUsedArea() == usedArea;
+		}
+		CHECK(valid);
+
+		for (AtlasAllocation& tile : tiles) allocator.Release(tile);
+		CHECK(allocator.GetUsedArea() == 0);
+		CHECK(allocator.Allocate(ATLAS_SIZE).IsValid());
+	}
+
+	// ShadowAtlas::Repack depends on this, tiles allocated from the biggest to the smallest fit as long as their area does
+	void TestQuadTreeLargestFirstFits()
+	{
+		constexpr uint32_t ATLAS_SIZE = 4096;
+		constexpr uint32_t MIN_TILE_SIZE = 64;
+		constexpr uint64_t ATLAS_AREA = (uint64_t) ATLAS_SIZE * ATLAS_SIZE;
+
+		std::mt19937 random{ 42 };
+		std::uniform_int_distribution<uint32_t> sizeShift{ 0, 4 };
+
+		for (uint32_t pass = 0; pass < 100; pass++)
+		{
+			std::vector<uint32_t> tileSizes;
+			uint64_t area = 0;
+			while (true)
+			{
+				const uint32_t tileSize = MIN_TILE_SIZE << sizeShift(random);
+				if (area + (uint64_t) tileSize * tileSize > ATLAS_AREA) break;
+
+				area += (uint64_t) tileSize * tileSize;
+				tileSizes.push_back(tileSize);
+			}
+			std::sort(tileSizes.begin(), tileSizes.end(), std::greater<uint32_t>());
+
+			QuadTreeStrategy allocator{ ATLAS_SIZE, MIN_TILE_SIZE };
+			uint32_t numFailed = 0;
+			for (uint32_t tileSize : tileSizes) numFailed += allocator.Allocate(tileSize).IsValid() ? 0 : 1;
+
+			CHECK(numFailed == 0);
+			CHECK(allocator.GetUsedArea() == area);
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("GrowingRangeStrategy reserve", TestGrowingRangeReserve);
+	Test::Run("GrowingRangeStrategy random additions", TestGrowingRangeRandomAdditions);
+	Test::Run("GrowingRangeStrategy reserved scene", TestGrowingRangeReservedScene);
+	Test::Run("QuadTreeStrategy whole atlas", TestQuadTreeWholeAtlas);
+	Test::Run("QuadTreeStrategy invalid sizes", TestQuadTreeInvalidSizes);
+	Test::Run("QuadTreeStrategy top left first", TestQuadTreeTopLeftFirst);
+	Test::Run("QuadTreeStrategy fill with min tiles", TestQuadTreeFillWithMinTiles);
+	Test::Run("QuadTreeStrategy merge needs all siblings", TestQuadTreeMergeNeedsAllSiblings);
+	Test::Run("QuadTreeStrategy random churn", TestQuadTreeRandomChurn);
+	Test::Run("QuadTreeStrategy largest first fits", TestQuadTreeLargestFirstFits);
+	return Test::Finish();
+}
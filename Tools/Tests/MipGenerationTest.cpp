@@ -0,0 +1,181 @@
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Engine/Loading/MipGeneration.h>
+
+namespace
+{
+	using MipGeneration::Settings;
+	using MipGeneration::FilterKernel;
+
+	// Every combination of the kernel, sRGB and alpha weighting
+	std::vector<Settings> GetAllSettings()
+	{
+		std::vector<Settings> allSettings;
+		for (FilterKernel kernel : { FilterKernel::Box, FilterKernel::Kaiser })
+		{
+			for (bool srgb : { false, true })
+			{
+				for (bool alphaWeighted : { false, true }) allSettings.push_back(Settings{ kernel, srgb, alphaWeighted });
+			}
+		}
+		return allSettings;
+	}
+
+	// Full chain down to 1x1
+	uint32_t GetNumMips(uint32_t width, uint32_t height)
+	{
+		uint32_t numMips = 1;
+		while ((std::max(width, height) >> numMips) > 0) numMips++;
+		return numMips;
+	}
+
+	// Random colors, a quarter of the alpha is 0 so the alpha weighting has transparent pixels to skip
+	std::vector<uint8_t> CreateRandomImage(uint32_t width, uint32_t height, bool opaque, std::mt19937& random)
+	{
+		std::vector<uint8_t> pixels((size_t) width * height * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+		{
+			if (i % 4 != 3) pixels[i] = (uint8_t) random();
+			else pixels[i] = opaque ? 255 : random() % 4 == 0 ? 0 : (uint8_t) random();
+		}
+		return pixels;
+	}
+
+	// SSE2 path against the scalar reference, every byte of every mip is within one step
+	bool MatchesReference(const Settings& settings, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+	{
+		const uint32_t numMips = GetNumMips(width, height);
+		std::vector<uint8_t> generated = pixels;
+		std::vector<uint8_t> reference = pixels;
+		MipGeneration::Generate(settings, width, height, numMips, generated);
+		MipGeneration::GenerateReference(settings, width, height, numMips, reference);
+		if (generated.size() != MipGeneration::GetMipOffset(width, height, numMips) || reference.size() != generated.size()) return false;
+
+		for (size_t i = 0; i < generated.size(); i++)
+		{
+			if (std::abs(generated[i] - reference[i]) > 1) return false;
+		}
+		return true;
+	}
+
+	// Mips are tightly packed from the largest, sizes are rounded down and at least 1
+	void TestMipLayout()
+	{
+		CHECK(MipGeneration::GetMipSize(99, 1) == 49);
+		CHECK(MipGeneration::GetMipSize(99, 6) == 1);
+		CHECK(MipGeneration::GetMipSize(1, 3) == 1);
+		CHECK(MipGeneration::GetMipOffset(5, 3, 0) == 0);
+		CHECK(MipGeneration::GetMipOffset(5, 3, 1) == 5 * 3 * 4);
+		CHECK(MipGeneration::GetMipOffset(5, 3, 2) == (5 * 3 + 2 * 1) * 4);
+		CHECK(MipGeneration::GetMipOffset(5, 3, 3) == (5 * 3 + 2 * 1 + 1 * 1) * 4);
+		CHECK(MipGeneration::GetMipOffset(1, 7, 3) == (7 + 3 + 1) * 4);
+	}
+
+	// Odd, thin and non power of two sizes with every setting, opaque and with transparent pixels
+	void TestMatchesReference()
+	{
+		std::mt19937 random{ 7 };
+		const uint32_t sizes[][2] = { { 5, 3 }, { 99, 200 }, { 1, 7 }, { 7, 1 }, { 1, 1 }, { 2, 2 }, { 37, 23 }, { 64, 48 } };
+		for (const auto& [width, height] : sizes)
+		{
+			for (const Settings& settings : GetAllSettings())
+			{
+				for (bool opaque : { true, false })
+				{
+					CHECK(MatchesReference(settings, width, height, CreateRandomImage(width, height, opaque, random)));
+				}
+			}
+		}
+	}
+
+	// Image of one color stays that color in every mip, with every setting and in both paths
+	void TestConstantImage()
+	{
+		const uint32_t sizes[][2] = { { 5, 3 }, { 99, 200 }, { 1, 7 } };
+		for (const auto& [width, height] : sizes)
+		{
+			for (const Settings& settings : GetAllSettings())
+			{
+				std::vector<uint8_t> pixels((size_t) width * height * 4);
+				for (size_t i = 0; i < pixels.size(); i += 4)
+				{
+					pixels[i] = 200;
+					pixels[i + 1] = 17;
+					pixels[i + 2] = 90;
+					pixels[i + 3] = 128;
+				}
+				CHECK(MatchesReference(settings, width, height, pixels));
+
+				MipGeneration::Generate(settings, width, height, GetNumMips(width, height), pixels);
+				for (size_t i = 0; i < pixels.size(); i += 4)
+				{
+					CHECK(pixels[i] == 200 && pixels[i + 1] == 17 && pixels[i + 2] == 90 && pixels[i + 3] == 128);
+				}
+			}
+		}
+	}
+
+	// Black and white checker averages to linear 0.5, which is 188 in sRGB and 128 in linear
+	void TestSRGBAverage()
+	{
+		std::vector<uint8_t> pixels(8 * 8 * 4);
+		for (uint32_t i = 0; i < 8 * 8; i++)
+		{
+			const uint8_t value = (i % 8 + i / 8) % 2 ? 255 : 0;
+			pixels[i * 4] = pixels[i * 4 + 1] = pixels[i * 4 + 2] = value;
+			pixels[i * 4 + 3] = 255;
+		}
+
+		std::vector<uint8_t> linear = pixels;
+		MipGeneration::Generate(Settings{ FilterKernel::Box, true, true }, 8, 8, 2, pixels);
+		MipGeneration::Generate(Settings{ FilterKernel::Box, false, false }, 8, 8, 2, linear);
+		CHECK(pixels[8 * 8 * 4] == 188);
+		CHECK(linear[8 * 8 * 4] == 128);
+	}
+
+	// Transparent red next to opaque green doesn't tint the green, fully transparent pixels keep their own color
+	void TestAlphaWeighting()
+	{
+		std::vector<uint8_t> pixels(8 * 8 * 4);
+		for (uint32_t i = 0; i < 8 * 8; i++)
+		{
+			const bool left = i % 8 < 3;
+			pixels[i * 4] = left ? 255 : 0;
+			pixels[i * 4 + 1] = left ? 0 : 255;
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = left ? 0 : 255;
+		}
+
+		MipGeneration::Generate(Settings{ FilterKernel::Box, true, true }, 8, 8, 2, pixels);
+		const uint8_t* mip = pixels.data() + 8 * 8 * 4;
+		CHECK(mip[4] == 0 && mip[5] == 255 && mip[7] == 128);
+		CHECK(mip[0] == 255 && mip[1] == 0 && mip[3] == 0);
+	}
+
+	// Odd sizes use every source pixel, the bright last column of 5 pixels reaches the 2 pixel mip
+	void TestOddSizeCoverage()
+	{
+		std::vector<uint8_t> pixels(5 * 4, 0);
+		for (uint32_t c = 0; c < 4; c++) pixels[4 * 4 + c] = 255;
+
+		MipGeneration::Generate(Settings{ FilterKernel::Box, false, false }, 5, 1, 2, pixels);
+		CHECK(pixels[5 * 4] == 0);
+		CHECK(pixels[6 * 4] == 102);
+	}
+}
+
+int main()
+{
+	Test::Run("Mip layout", TestMipLayout);
+	Test::Run("Matches reference", TestMatchesReference);
+	Test::Run("Constant image", TestConstantImage);
+	Test::Run("sRGB average", TestSRGBAverage);
+	Test::Run("Alpha weighting", TestAlphaWeighting);
+	Test::Run("Odd size coverage", TestOddSizeCoverage);
+	return Test::Finish();
+}
@@ -0,0 +1,332 @@
+#include <set>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+
+#include "Test.h"
+
+#include <Engine/Render/PipelineLibraryCache.h>
+#include <Engine/Utility/FileUtility.h>
+
+namespace
+{
+	using AdapterID = PipelineLibraryCache::AdapterID;
+
+	const AdapterID ADAPTER{ 0x10DE, 0x2204, 0x1, 0xA1, 0x0020001E0011000Bull };
+
+	// Library that keeps the pipelines in the set, the blob is the sorted list of their hashes
+	// Same rules as the D3D12 library, only the pipelines created or loaded in this launch can be stored
+	class MockLibrary : public PipelineLibraryCache::Library
+	{
+	public:
+		bool Create(const std::vector<uint8_t>& blob) override
+		{
+			NumCreated++;
+			m_Pipelines.clear();
+			if (RejectBlobs && !blob.empty()) return false;
+			if (blob.size() % sizeof(uint64_t) != 0) return false;
+
+			for (size_t offset = 0; offset < blob.size(); offset += sizeof(uint64_t))
+			{
+				uint64_t stateHash = 0;
+				memcpy(&stateHash, blob.data() + offset, sizeof(uint64_t));
+				m_Pipelines.insert(stateHash);
+			}
+			return true;
+		}
+
+		bool Store(uint64_t stateHash) override
+		{
+			if (!m_SessionPipelines.contains(stateHash)) return false;
+			m_Pipelines.insert(stateHash);
+			return true;
+		}
+
+		bool Serialize(std::vector<uint8_t>& blob) override
+		{
+			blob.clear();
+			for (uint64_t stateHash : m_Pipelines)
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&stateHash);
+				blob.insert(blob.end(), bytes, bytes + sizeof(uint64_t));
+			}
+			return true;
+		}
+
+		// Same steps as PipelineLibrary::LoadOrCreate, returns true if the pipeline came from the library
+		bool LoadOrCreate(PipelineLibraryCache& cache, uint64_t stateHash)
+		{
+			m_SessionPipelines.insert(stateHash);
+			if (cache.Contains(stateHash) && m_Pipelines.contains(stateHash))
+			{
+				cache.MarkUsed(stateHash);
+				return true;
+			}
+
+			cache.Add(stateHash);
+			return false;
+		}
+
+		const std::set<uint64_t>& GetPipelines() const { return m_Pipelines; }
+
+		bool RejectBlobs = false;
+		uint32_t NumCreated = 0;
+
+	private:
+		std::set<uint64_t> m_Pipelines;
+		std::set<uint64_t> m_SessionPipelines;
+	};
+
+	struct Launch
+	{
+		bool Loaded = false;
+		uint32_t NumFromLibrary = 0;
+		PipelineLibraryCache::Statistics Statistics;
+		std::set<uint64_t> SavedPipelines;
+	};
+
+	// One run of the application that uses the pipelines and saves the library on exit
+	Launch RunLaunch(const std::string& path, const std::vector<uint64_t>& usedPipelines, const AdapterID& adapter = ADAPTER, uint32_t maxUnusedLaunches = 8)
+	{
+		MockLibrary library;
+		PipelineLibraryCache cache{ library, adapter, maxUnusedLaunches };
+
+		Launch launch;
+		launch.Loaded = cache.Load(path);
+		for (uint64_t stateHash : usedPipelines) launch.NumFromLibrary += library.LoadOrCreate(cache, stateHash) ? 1 : 0;
+
+		CHECK(cache.Save(path));
+		launch.Statistics = cache.GetStatistics();
+		launch.SavedPipelines = library.GetPipelines();
+		return launch;
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path)
+	{
+		std::vector<uint8_t> content;
+		FileUtility::ReadBinaryFile(path, content);
+		return content;
+	}
+
+	void WriteFile(const std::string& path, const std::vector<uint8_t>& content)
+	{
+		FileUtility::WriteBinaryFile(path, content.data(), content.size());
+	}
+
+	// Header, entries and the blob of the library, the next launch loads every pipeline
+	void TestFileFormat()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheFormat") + "/PipelineLibrary.bin";
+
+		const Launch first = RunLaunch(path, { 0x11, 0x22, 0x33 });
+		CHECK(!first.Loaded);
+		CHECK(first.NumFromLibrary == 0);
+		CHECK(first.Statistics.NumStored == 3);
+
+		const std::vector<uint8_t> content = ReadFile(path);
+		FileUtility::BinaryReader reader{ content };
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		AdapterID adapter{};
+		uint32_t launch = 0;
+		uint32_t numEntries = 0;
+		reader.Read(magic);
+		reader.Read(version);
+		reader.Read(adapter);
+		reader.Read(launch);
+		reader.Read(numEntries);
+		CHECK(memcmp(&magic, "PSOL", 4) == 0);
+		CHECK(version == 1);
+		CHECK(adapter == ADAPTER);
+		CHECK(launch == 1);
+		CHECK(numEntries == 3);
+
+		std::set<uint64_t> entries;
+		for (uint32_t i = 0; i < numEntries; i++)
+		{
+			uint64_t stateHash = 0;
+			uint32_t lastUsedLaunch = 0;
+			reader.Read(stateHash);
+			reader.Read(lastUsedLaunch);
+			entries.insert(stateHash);
+			CHECK(lastUsedLaunch == 1);
+		}
+		CHECK(entries == (std::set<uint64_t>{ 0x11, 0x22, 0x33 }));
+
+		uint64_t blobSize = 0;
+		std::vector<uint8_t> blob;
+		reader.Read(blobSize);
+		reader.ReadArray(blob, blobSize);
+		CHECK(reader.IsValid() && reader.IsAtEnd());
+		CHECK(blobSize == 3 * sizeof(uint64_t));
+
+		const Launch second = RunLaunch(path, { 0x11, 0x22, 0x33, 0x44 });
+		CHECK(second.Loaded);
+		CHECK(second.NumFromLibrary == 3);
+		CHECK(second.Statistics.NumLoaded == 3);
+		CHECK(second.Statistics.NumStored == 1);
+		CHECK(second.SavedPipelines == (std::set<uint64_t>{ 0x11, 0x22, 0x33, 0x44 }));
+	}
+
+	// Launch that doesn't change anything doesn't write the file
+	void TestSaveOnlyChanges()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheSave") + "/PipelineLibrary.bin";
+
+		RunLaunch(path, {});
+		CHECK(!std::filesystem::exists(path));
+
+		RunLaunch(path, { 0x11 });
+		CHECK(std::filesystem::exists(path));
+
+		// Pipeline that was already used in this launch doesn't make the library dirty again
+		MockLibrary library;
+		PipelineLibraryCache cache{ library, ADAPTER };
+		CHECK(cache.Load(path));
+		library.LoadOrCreate(cache, 0x11);
+		CHECK(cache.Save(path));
+
+		std::filesystem::remove(path);
+		library.LoadOrCreate(cache, 0x11);
+		CHECK(cache.Save(path));
+		CHECK(!std::filesystem::exists(path));
+	}
+
+	// Library of the other adapter or driver is discarded and overwritten even if nothing is added
+	void TestAdapterVersioning()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheAdapter") + "/PipelineLibrary.bin";
+
+		AdapterID otherDevice = ADAPTER;
+		otherDevice.DeviceID++;
+		AdapterID otherRevision = ADAPTER;
+		otherRevision.Revision++;
+		AdapterID newerDriver = ADAPTER;
+		newerDriver.DriverVersion++;
+
+		for (const AdapterID& adapter : { otherDevice, otherRevision, newerDriver })
+		{
+			RunLaunch(path, { 0x11, 0x22 });
+
+			MockLibrary library;
+			PipelineLibraryCache cache{ library, adapter };
+			CHECK(!cache.Load(path));
+			CHECK(cache.GetNumEntries() == 0);
+			CHECK(library.GetPipelines().empty());
+			CHECK(!library.LoadOrCreate(cache, 0x11));
+			CHECK(cache.Save(path));
+
+			// Overwritten file belongs to the new adapter
+			const Launch next = RunLaunch(path, { 0x11 }, adapter);
+			CHECK(next.Loaded);
+			CHECK(next.NumFromLibrary == 1);
+			CHECK(!RunLaunch(path, { 0x11 }).Loaded);
+			std::filesystem::remove(path);
+		}
+	}
+
+	// Damaged file or the blob that the driver rejects starts with the empty library
+	void TestCorruption()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheCorruption") + "/PipelineLibrary.bin";
+		RunLaunch(path, { 0x11, 0x22 });
+		const std::vector<uint8_t> content = ReadFile(path);
+
+		const auto loads = [&](const std::vector<uint8_t>& fileContent)
+		{
+			WriteFile(path, fileContent);
+			MockLibrary library;
+			PipelineLibraryCache cache{ library, ADAPTER };
+			const bool loaded = cache.Load(path);
+			CHECK(loaded == (cache.GetNumEntries() == 2));
+			return loaded;
+		};
+		CHECK(loads(content));
+
+		std::vector<uint8_t> wrongMagic = content;
+		wrongMagic[0] ^= 0xFF;
+		CHECK(!loads(wrongMagic));
+
+		std::vector<uint8_t> wrongVersion = content;
+		wrongVersion[4]++;
+		CHECK(!loads(wrongVersion));
+
+		std::vector<uint8_t> wrongNumEntries = content;
+		wrongNumEntries[36] = 0xFF;
+		CHECK(!loads(wrongNumEntries));
+
+		bool truncatedRejected = true;
+		for (size_t size = 0; size < content.size(); size++) truncatedRejected &= !loads(std::vector<uint8_t>(content.begin(), content.begin() + size));
+		CHECK(truncatedRejected);
+
+		std::vector<uint8_t> extended = content;
+		extended.push_back(0);
+		CHECK(!loads(extended));
+
+		// Blob that isn't a multiple of the hash size is rejected by the mock like the driver rejects the broken one
+		std::vector<uint8_t> brokenBlob = content;
+		brokenBlob[brokenBlob.size() - 2 * sizeof(uint64_t) - sizeof(uint64_t)]--;
+		brokenBlob.pop_back();
+		CHECK(!loads(brokenBlob));
+
+		WriteFile(path, content);
+		MockLibrary library;
+		library.RejectBlobs = true;
+		PipelineLibraryCache cache{ library, ADAPTER };
+		CHECK(!cache.Load(path));
+		CHECK(cache.GetNumEntries() == 0);
+		CHECK(library.NumCreated == 2);
+	}
+
+	// Pipeline unused for more than the limit is evicted, the ones not used in the evicting launch go with it
+	void TestEviction()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheEviction") + "/PipelineLibrary.bin";
+		constexpr uint32_t MAX_UNUSED_LAUNCHES = 2;
+
+		// Launch 1 adds all three, A is used every launch, C once more in launch 3
+		Launch launch = RunLaunch(path, { 0xA, 0xB, 0xC }, ADAPTER, MAX_UNUSED_LAUNCHES);
+		CHECK(launch.Statistics.NumStored == 3);
+
+		launch = RunLaunch(path, { 0xA }, ADAPTER, MAX_UNUSED_LAUNCHES);
+		CHECK(launch.Statistics.NumEvicted == 0);
+		launch = RunLaunch(path, { 0xA, 0xC }, ADAPTER, MAX_UNUSED_LAUNCHES);
+		CHECK(launch.Statistics.NumEvicted == 0);
+		CHECK(launch.SavedPipelines.size() == 3);
+
+		// B was last used 3 launches ago, C isn't used in this launch and is dropped with it
+		launch = RunLaunch(path, { 0xA }, ADAPTER, MAX_UNUSED_LAUNCHES);
+		CHECK(launch.Statistics.NumEvicted == 2);
+		CHECK(launch.SavedPipelines == (std::set<uint64_t>{ 0xA }));
+
+		launch = RunLaunch(path, { 0xA, 0xB }, ADAPTER, MAX_UNUSED_LAUNCHES);
+		CHECK(launch.Loaded);
+		CHECK(launch.NumFromLibrary == 1);
+		CHECK(launch.Statistics.NumStored == 1);
+		CHECK(launch.SavedPipelines == (std::set<uint64_t>{ 0xA, 0xB }));
+	}
+
+	// Limit is per pipeline, a library that is used every launch is never rebuilt
+	void TestNoEvictionWhenUsed()
+	{
+		const std::string path = Test::CreateTempDirectory("PipelineLibraryCacheUsed") + "/PipelineLibrary.bin";
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			const Launch launch = RunLaunch(path, { 0xA, 0xB }, ADAPTER, 1);
+			CHECK(launch.Statistics.NumEvicted == 0);
+			CHECK(launch.NumFromLibrary == (i == 0 ? 0u : 2u));
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("File format", TestFileFormat);
+	Test::Run("Save only changes", TestSaveOnlyChanges);
+	Test::Run("Adapter versioning", TestAdapterVersioning);
+	Test::Run("Corruption", TestCorruption);
+	Test::Run("Eviction", TestEviction);
+	Test::Run("No eviction when used", TestNoEvictionWhenUsed);
+	return Test::Finish();
+}
@@ -0,0 +1,107 @@
+// Time of the scene conversion for thread counts from the calling thread alone up to a thread per core
+// Without --scene a scene is generated with the given number of meshes, each with 3 textures of --texture-size
+//
+// Usage: SceneBuildBenchmark [--scene <path>] [--meshes <count>] [--texture-size <size>] [--max-threads <count>] [--repeats <count>]
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "TestScene.h"
+
+#include <Scene/SceneCache.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Best time of the repeats in milliseconds, fails if a build fails
+	bool MeasureBuild(const std::string& path, uint32_t numThreads, uint32_t numRepeats, double& bestMS, SceneCache::SceneData& scene)
+	{
+		bestMS = 0.0;
+		for (uint32_t i = 0; i < numRepeats; i++)
+		{
+			const Clock::time_point startTime = Clock::now();
+			if (!SceneCache::Build(path, scene, numThreads)) return false;
+			const double timeMS = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+			bestMS = i == 0 ? timeMS : std::min(bestMS, timeMS);
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string scenePath;
+	TestScene::Settings settings;
+	settings.NumMeshes = 64;
+	settings.GridSize = 128;
+	settings.TextureSize = 256;
+	uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t numRepeats = 3;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--scene" && i + 1 < argc) scenePath = argv[++i];
+		else if (argument == "--meshes" && i + 1 < argc) settings.NumMeshes = std::max(std::atoi(argv[++i]), 1);
+		else if (argument == "--texture-size" && i + 1 < argc) settings.TextureSize = std::max(std::atoi(argv[++i]) / 4 * 4, 4);
+		else if (argument == "--max-threads" && i + 1 < argc) maxThreads = std::max(std::atoi(argv[++i]), 1);
+		else if (argument == "--repeats" && i + 1 < argc) numRepeats = std::max(std::atoi(argv[++i]), 1);
+		else
+		{
+			std::cout << "Usage: SceneBuildBenchmark [--scene <path>] [--meshes <count>] [--texture-size <size>] [--max-threads <count>] [--repeats <count>]" << std::endl;
+			return 2;
+		}
+	}
+
+	if (scenePath.empty())
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "EngineBenchmarks" / "SceneBuild";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		scenePath = TestScene::Write(directory.generic_string(), settings);
+		if (scenePath.empty())
+		{
+			std::cout << "Failed to write the scene to " << directory.generic_string() << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<uint32_t> threadCounts = { 1 };
+	for (uint32_t numThreads = 2; numThreads < maxThreads; numThreads *= 2) threadCounts.push_back(numThreads);
+	if (maxThreads > 1) threadCounts.push_back(maxThreads);
+
+	std::cout << scenePath << ", " << std::thread::hardware_concurrency() << " cores, best of " << numRepeats << " runs" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	double serialMS = 0.0;
+	SceneCache::SceneData serial;
+	for (uint32_t numThreads : threadCounts)
+	{
+		double timeMS;
+		SceneCache::SceneData scene;
+		if (!MeasureBuild(scenePath, numThreads, numRepeats, timeMS, scene))
+		{
+			std::cout << "Failed to build " << scenePath << std::endl;
+			return 1;
+		}
+
+		if (numThreads == 1)
+		{
+			serialMS = timeMS;
+			serial = std::move(scene);
+			std::cout << "  " << serial.Meshes.size() << " meshes, " << serial.Vertices.size() << " vertices, " << serial.Textures.size() << " textures" << std::endl;
+		}
+
+		std::cout << "  " << std::setw(3) << numThreads << " threads" << std::setw(12) << timeMS << " ms" << std::setw(8) << serialMS / timeMS << "x";
+		if (numThreads != 1 && !SceneCache::IsEqual(serial.GetView(), scene.GetView())) std::cout << "  differs from 1 thread";
+		std::cout << std::endl;
+	}
+	return 0;
+}
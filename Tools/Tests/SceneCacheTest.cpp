@@ -0,0 +1,431 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+
+#include "Test.h"
+#include "TestScene.h"
+
+#include <cgltf.h>
+
+#include <Engine/Loading/BCEncoding.h>
+#include <Engine/Loading/MappedGLTF.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Scene/SceneCache.h>
+
+namespace
+{
+	// Small glTF with 2 meshes of 3 primitives, 3 materials with every render group and 2 PNGs, one of them with a space in the name
+	// Same scene is in scene.glb with the buffer and the images embedded in the binary chunk
+	const std::string SCENE_PATH = "Scene/scene.gltf";
+	const std::string GLB_SCENE_PATH = "Scene/scene.glb";
+
+	// Scene files are copied so the test can touch them, the cache is written next to them
+	void EnterTempDirectory()
+	{
+		const std::string directory = Test::CreateTempDirectory("SceneCache");
+		std::filesystem::copy(TEST_DATA_DIRECTORY "/Scene", directory + "/Scene");
+		std::filesystem::current_path(directory);
+	}
+
+	bool BuildAndSave(SceneCache::SceneData& scene, uint64_t& sourceHash, std::string& cachePath)
+	{
+		if (!SceneCache::Build(SCENE_PATH, scene) || !SceneCache::HashSourceFile(SCENE_PATH, sourceHash)) return false;
+
+		cachePath = SceneCache::GetCachePath(sourceHash);
+		SceneCache::SaveCache(cachePath, sourceHash, scene.GetView());
+		return std::filesystem::exists(cachePath);
+	}
+
+	// Damaged copy of the cache is written next to it
+	std::string WriteDamagedCache(const std::string& name, const std::vector<uint8_t>& content, size_t size)
+	{
+		const std::string path = "Cache/" + name + ".scene";
+		FileUtility::WriteBinaryFile(path, content.data(), size);
+		return path;
+	}
+
+	bool Loads(const std::string& cachePath, uint64_t sourceHash)
+	{
+		FileUtility::MappedFile file;
+		SceneCache::SceneView scene;
+		const bool loaded = SceneCache::LoadCache(cachePath, sourceHash, file, scene);
+		return loaded && file.IsOpen();
+	}
+
+	// Render groups follow each other and the meshes of each group tile it in the order of the meshes
+	bool IsPlacedByRenderGroup(const std::vector<SceneCache::MeshData>& meshes, const std::vector<SceneCache::RenderGroupData>& renderGroups)
+	{
+		if (renderGroups.size() != SceneCache::RENDER_GROUP_COUNT) return false;
+
+		uint64_t nextVertex = 0;
+		uint64_t nextIndex = 0;
+		for (uint32_t rg = 0; rg < SceneCache::RENDER_GROUP_COUNT; rg++)
+		{
+			const SceneCache::RenderGroupData& renderGroup = renderGroups[rg];
+			if (renderGroup.FirstVertex != nextVertex || renderGroup.FirstIndex != nextIndex) return false;
+
+			for (const SceneCache::MeshData& mesh : meshes)
+			{
+				if (mesh.RenderGroup != rg) continue;
+				if (mesh.VertexOffset != nextVertex || mesh.IndexOffset != nextIndex) return false;
+				nextVertex += mesh.VertexCount;
+				nextIndex += mesh.IndexCount;
+			}
+			if (nextVertex != (uint64_t) renderGroup.FirstVertex + renderGroup.NumVertices || nextIndex != (uint64_t) renderGroup.FirstIndex + renderGroup.NumIndices) return false;
+		}
+		return true;
+	}
+
+	// Random mesh sets, empty meshes and render groups without meshes included
+	void TestAssignMeshOffsets()
+	{
+		std::mt19937 random{ 7 };
+		bool placed = true;
+		for (uint32_t pass = 0; pass < 5000; pass++)
+		{
+			std::vector<SceneCache::MeshData> meshes(random() % 30);
+			for (SceneCache::MeshData& mesh : meshes)
+			{
+				mesh.RenderGroup = random() % SceneCache::RENDER_GROUP_COUNT;
+				mesh.VertexCount = random() % 4 == 0 ? 0 : random() % 1000;
+				mesh.IndexCount = random() % 3000;
+			}
+
+			std::vector<SceneCache::RenderGroupData> renderGroups;
+			placed &= SceneCache::AssignMeshOffsets(meshes, renderGroups) && IsPlacedByRenderGroup(meshes, renderGroups);
+		}
+		CHECK(placed);
+
+		// No meshes are 3 empty render groups
+		std::vector<SceneCache::MeshData> meshes;
+		std::vector<SceneCache::RenderGroupData> renderGroups;
+		CHECK(SceneCache::AssignMeshOffsets(meshes, renderGroups));
+		CHECK(renderGroups.size() == SceneCache::RENDER_GROUP_COUNT);
+		CHECK(renderGroups[2].FirstVertex == 0 && renderGroups[2].NumIndices == 0);
+
+		// Render group that doesn't exist
+		meshes.resize(2);
+		meshes[1].RenderGroup = SceneCache::RENDER_GROUP_COUNT;
+		CHECK(!SceneCache::AssignMeshOffsets(meshes, renderGroups));
+	}
+
+	// Offsets are 32 bit, the last vertex and index that fit and the first ones that don't
+	void TestAssignMeshOffsetsOverflow()
+	{
+		std::vector<SceneCache::MeshData> meshes(3);
+		for (uint32_t i = 0; i < 3; i++) meshes[i].RenderGroup = i;
+		meshes[0].VertexCount = 0x80000000;
+		meshes[1].VertexCount = 0x7FFFFFFF;
+		meshes[2].IndexCount = UINT32_MAX;
+
+		std::vector<SceneCache::RenderGroupData> renderGroups;
+		CHECK(SceneCache::AssignMeshOffsets(meshes, renderGroups));
+		CHECK(renderGroups[2].FirstVertex == UINT32_MAX && renderGroups[2].NumIndices == UINT32_MAX);
+
+		// Sum of the meshes of one render group overflows, the counts themselves fit
+		meshes[2].VertexCount = 1;
+		CHECK(!SceneCache::AssignMeshOffsets(meshes, renderGroups));
+		meshes[2].VertexCount = 0;
+		meshes[0].IndexCount = 1;
+		CHECK(!SceneCache::AssignMeshOffsets(meshes, renderGroups));
+
+		meshes.assign(3, SceneCache::MeshData{});
+		for (SceneCache::MeshData& mesh : meshes)
+		{
+			mesh.RenderGroup = 1;
+			mesh.IndexCount = 0x60000000;
+		}
+		CHECK(!SceneCache::AssignMeshOffsets(meshes, renderGroups));
+		meshes.pop_back();
+		CHECK(SceneCache::AssignMeshOffsets(meshes, renderGroups));
+		CHECK(meshes[1].IndexOffset == 0x60000000);
+	}
+
+	// Built scene has every object, mesh and material of the glTF with the meshes placed by the render group
+	void TestBuild()
+	{
+		SceneCache::SceneData scene;
+		CHECK(SceneCache::Build(SCENE_PATH, scene));
+		CHECK(scene.Objects.size() == 5);
+		CHECK(scene.Meshes.size() == 3);
+		CHECK(scene.Materials.size() == 3);
+		CHECK(scene.RenderGroups.size() == SceneCache::RENDER_GROUP_COUNT);
+		CHECK(scene.Vertices.size() == 12);
+		CHECK(scene.Indices.size() == 13);
+
+		for (const SceneCache::MeshData& mesh : scene.Meshes)
+		{
+			const SceneCache::RenderGroupData& renderGroup = scene.RenderGroups[mesh.RenderGroup];
+			CHECK(mesh.VertexOffset >= renderGroup.FirstVertex && mesh.VertexOffset + mesh.VertexCount <= renderGroup.FirstVertex + renderGroup.NumVertices);
+			CHECK(mesh.IndexOffset >= renderGroup.FirstIndex && mesh.IndexOffset + mesh.IndexCount <= renderGroup.FirstIndex + renderGroup.NumIndices);
+		}
+
+		for (const SceneCache::ObjectData& object : scene.Objects)
+		{
+			CHECK(object.Mesh < scene.Meshes.size() && object.Material < scene.Materials.size());
+			CHECK(scene.Meshes[object.Mesh].RenderGroup == scene.Materials[object.Material].RenderGroup);
+		}
+
+		for (const SceneCache::TextureData& texture : scene.Textures)
+		{
+			CHECK(texture.PixelSize == SceneCache::GetMipOffset(texture, texture.NumMips));
+			CHECK(texture.PixelOffset + texture.PixelSize <= scene.TexturePixels.size());
+		}
+
+		// Same scene is built again on another run
+		SceneCache::SceneData again;
+		CHECK(SceneCache::Build(SCENE_PATH, again));
+		CHECK(SceneCache::IsEqual(scene.GetView(), again.GetView()));
+	}
+
+	// Saved cache loads back to the same scene, every section is aligned for the mapping
+	void TestRoundTrip()
+	{
+		SceneCache::SceneData built;
+		uint64_t sourceHash = 0;
+		std::string cachePath;
+		CHECK(BuildAndSave(built, sourceHash, cachePath));
+
+		FileUtility::MappedFile file;
+		SceneCache::SceneView loaded;
+		CHECK(SceneCache::LoadCache(cachePath, sourceHash, file, loaded));
+		CHECK(SceneCache::IsEqual(built.GetView(), loaded));
+		CHECK(loaded.Objects.data() != built.Objects.data());
+		CHECK((uintptr_t) loaded.Vertices.data() % 4096 == 0);
+		CHECK((uintptr_t) loaded.TexturePixels.data() % 4096 == 0);
+
+		// Cache of another source isn't used
+		FileUtility::MappedFile otherFile;
+		CHECK(!SceneCache::LoadCache(cachePath, sourceHash + 1, otherFile, loaded));
+		CHECK(!otherFile.IsOpen());
+
+		// Any difference is found by the comparison
+		SceneCache::SceneData changed = built;
+		changed.Vertices[5].Position[1] += 1.0f;
+		CHECK(!SceneCache::IsEqual(built.GetView(), changed.GetView()));
+		changed = built;
+		changed.TexturePixels.back() ^= 1;
+		CHECK(!SceneCache::IsEqual(built.GetView(), changed.GetView()));
+	}
+
+	// Changed buffer makes a new source hash so the old cache isn't loaded
+	void TestSourceHash()
+	{
+		uint64_t sourceHash = 0;
+		CHECK(SceneCache::HashSourceFile(SCENE_PATH, sourceHash));
+
+		uint64_t sameHash = 0;
+		CHECK(SceneCache::HashSourceFile(SCENE_PATH, sameHash) && sameHash == sourceHash);
+
+		const std::filesystem::path bufferPath = "Scene/scene.bin";
+		std::filesystem::last_write_time(bufferPath, std::filesystem::last_write_time(bufferPath) + std::chrono::seconds(10));
+		uint64_t touchedHash = 0;
+		CHECK(SceneCache::HashSourceFile(SCENE_PATH, touchedHash) && touchedHash != sourceHash);
+		CHECK(SceneCache::GetCachePath(touchedHash) != SceneCache::GetCachePath(sourceHash));
+
+		uint64_t missingHash = 0;
+		CHECK(!SceneCache::HashSourceFile("Scene/missing.gltf", missingHash));
+	}
+
+	// Truncated caches, broken headers and sections that reference missing data aren't loaded
+	void TestCorruptedCache()
+	{
+		SceneCache::SceneData built;
+		uint64_t sourceHash = 0;
+		std::string cachePath;
+		CHECK(BuildAndSave(built, sourceHash, cachePath));
+
+		std::vector<uint8_t> content;
+		CHECK(FileUtility::ReadBinaryFile(cachePath, content));
+		CHECK(Loads(WriteDamagedCache("copy", content, content.size()), sourceHash));
+
+		// Header is magic, version, source hash and the offset and size of every section
+		constexpr size_t SECTIONS_OFFSET = 16;
+		constexpr size_t SECTION_RANGE_SIZE = 16;
+		constexpr size_t SECTION_COUNT = 8;
+		constexpr size_t OBJECTS_SECTION = 4;
+
+		// File cut in the header or in the last byte of any section fails
+		constexpr size_t HEADER_SIZE = 16 + SECTION_COUNT * SECTION_RANGE_SIZE;
+		std::vector<size_t> truncatedSizes = { 0, 4, 15, HEADER_SIZE - 1, HEADER_SIZE };
+		for (size_t section = 0; section < SECTION_COUNT; section++)
+		{
+			uint64_t range[2];
+			memcpy(range, content.data() + SECTIONS_OFFSET + section * SECTION_RANGE_SIZE, sizeof(range));
+			if (range[1] > 0) truncatedSizes.push_back((size_t) (range[0] + range[1] - 1));
+		}
+
+		bool truncatedRejected = true;
+		for (size_t size : truncatedSizes)
+		{
+			truncatedRejected &= size < content.size() && !Loads(WriteDamagedCache("truncated", content, size), sourceHash);
+		}
+		CHECK(truncatedRejected);
+
+		const auto damage = [&](const std::string& name, size_t offset, uint32_t value)
+		{
+			std::vector<uint8_t> damaged = content;
+			memcpy(damaged.data() + offset, &value, sizeof(value));
+			return WriteDamagedCache(name, damaged, damaged.size());
+		};
+		CHECK(!Loads(damage("magic", 0, 0x12345678), sourceHash));
+		CHECK(!Loads(damage("version", 4, 0), sourceHash));
+
+		// Section that isn't aligned or that runs past the file
+		CHECK(!Loads(damage("unaligned", SECTIONS_OFFSET, 8), sourceHash));
+		CHECK(!Loads(damage("size", SECTIONS_OFFSET + OBJECTS_SECTION * SECTION_RANGE_SIZE + 8, 0x7FFFFFFF), sourceHash));
+
+		// Object that references a missing mesh
+		uint64_t objectsOffset = 0;
+		memcpy(&objectsOffset, content.data() + SECTIONS_OFFSET + OBJECTS_SECTION * SECTION_RANGE_SIZE, sizeof(objectsOffset));
+		CHECK(objectsOffset % 4096 == 0 && objectsOffset < content.size());
+		CHECK(!Loads(damage("mesh", (size_t) objectsOffset, 99), sourceHash));
+
+		// Missing cache fails without the warning of a corrupted one
+		CHECK(!Loads("Cache/missing.scene", sourceHash));
+	}
+
+	// Any thread count builds the same scene as the calling thread alone, the textures are block compressed in parallel too
+	void TestThreadCounts()
+	{
+		std::filesystem::create_directories("Generated");
+		TestScene::Settings settings;
+		settings.NumMeshes = 24;
+		settings.GridSize = 40;
+		const std::string path = TestScene::Write("Generated", settings);
+		CHECK(!path.empty());
+
+		SceneCache::SceneData serial;
+		CHECK(SceneCache::Build(path, serial, 1));
+		CHECK(serial.Meshes.size() == settings.NumMeshes && serial.Textures.size() == settings.NumMeshes * 3);
+		CHECK(serial.RenderGroups[1].NumIndices > 0 && serial.RenderGroups[2].NumIndices > 0);
+
+		for (uint32_t numThreads : { 2, 3, 4, 8, 64, 0 })
+		{
+			SceneCache::SceneData parallel;
+			CHECK(SceneCache::Build(path, parallel, numThreads));
+			CHECK(SceneCache::IsEqual(serial.GetView(), parallel.GetView()));
+		}
+	}
+
+	// Albedo keeps its alpha in BC7, metallic roughness and normal only need red and green and are BC5
+	void TestTextureFormats()
+	{
+		std::filesystem::create_directories("Formats");
+		TestScene::Settings settings;
+		settings.NumMeshes = 4;
+		const std::string path = TestScene::Write("Formats", settings);
+		CHECK(!path.empty());
+
+		SceneCache::SceneData scene;
+		CHECK(SceneCache::Build(path, scene));
+		CHECK(scene.Materials.size() == settings.NumMeshes);
+		for (const SceneCache::MaterialData& material : scene.Materials)
+		{
+			CHECK(scene.Textures[material.Albedo].Format == (uint32_t) BCEncoding::Format::BC7);
+			CHECK(scene.Textures[material.MetallicRoughness].Format == (uint32_t) BCEncoding::Format::BC5);
+			CHECK(scene.Textures[material.Normal].Format == (uint32_t) BCEncoding::Format::BC5);
+		}
+	}
+
+	// GLB with the embedded buffer and images builds the same scene as the glTF with the external files
+	void TestGLBMatchesGLTF()
+	{
+		SceneCache::SceneData fromGLTF;
+		SceneCache::SceneData fromGLB;
+		CHECK(SceneCache::Build(SCENE_PATH, fromGLTF));
+		CHECK(SceneCache::Build(GLB_SCENE_PATH, fromGLB));
+		CHECK(fromGLB.Textures.size() == fromGLTF.Textures.size());
+
+		// Only the path hash differs, embedded images don't have a path
+		for (size_t i = 0; i < fromGLB.Textures.size() && i < fromGLTF.Textures.size(); i++)
+		{
+			CHECK(fromGLB.Textures[i].PathHash == 0);
+			fromGLB.Textures[i].PathHash = fromGLTF.Textures[i].PathHash;
+		}
+		CHECK(SceneCache::IsEqual(fromGLTF.GetView(), fromGLB.GetView()));
+
+		uint64_t gltfHash = 0;
+		uint64_t glbHash = 0;
+		CHECK(SceneCache::HashSourceFile(SCENE_PATH, gltfHash));
+		CHECK(SceneCache::HashSourceFile(GLB_SCENE_PATH, glbHash));
+		CHECK(glbHash != gltfHash);
+	}
+
+	// Binary chunk of the GLB and the buffer of the glTF are used in place of the mapped files
+	void TestMappedGLTF()
+	{
+		MappedGLTF glb;
+		CHECK(glb.Load(GLB_SCENE_PATH));
+		const cgltf_data* glbData = glb.GetData();
+		CHECK(glbData != nullptr);
+		if (!glbData) return;
+
+		const uint8_t* glbBegin = static_cast<const uint8_t*>(glbData->file_data);
+		const uint8_t* glbEnd = glbBegin + std::filesystem::file_size(GLB_SCENE_PATH);
+		CHECK(glbData->buffers_count == 1 && glbData->buffers[0].data == glbData->bin);
+		CHECK(static_cast<const uint8_t*>(glbData->bin) > glbBegin && static_cast<const uint8_t*>(glbData->bin) < glbEnd);
+
+		// Embedded image is the PNG file byte for byte
+		std::vector<uint8_t> albedoFile;
+		CHECK(FileUtility::ReadBinaryFile("Scene/albedo tex.png", albedoFile));
+		size_t imageSize = 0;
+		const uint8_t* image = MappedGLTF::GetImageData(glbData->images + 0, imageSize);
+		CHECK(image != nullptr && image > glbBegin && image + imageSize <= glbEnd);
+		CHECK(image && imageSize == albedoFile.size() && memcmp(image, albedoFile.data(), imageSize) == 0);
+
+		MappedGLTF gltf;
+		CHECK(gltf.Load(SCENE_PATH));
+		const cgltf_data* gltfData = gltf.GetData();
+		CHECK(gltfData != nullptr);
+		if (!gltfData) return;
+
+		// External buffer has the same bytes as the start of the binary chunk, images are referenced by URI
+		CHECK(gltfData->buffers_count == 1 && gltfData->buffers[0].data != nullptr);
+		CHECK(gltfData->accessors_count == glbData->accessors_count && gltfData->images_count == glbData->images_count);
+		const size_t bufferSize = gltfData->buffers[0].size;
+		CHECK(bufferSize <= glbData->buffers[0].size);
+		CHECK(gltfData->buffers[0].data && memcmp(gltfData->buffers[0].data, glbData->bin, bufferSize) == 0);
+		CHECK(MappedGLTF::GetImageData(gltfData->images + 0, imageSize) == nullptr);
+
+		// Parse doesn't load the buffers
+		MappedGLTF parsed;
+		CHECK(parsed.Parse(SCENE_PATH));
+		CHECK(parsed.GetData() && parsed.GetData()->buffers[0].data == nullptr);
+
+		MappedGLTF missing;
+		CHECK(!missing.Load("Scene/missing.glb"));
+		CHECK(missing.GetData() == nullptr);
+	}
+
+	// Scene that doesn't exist or doesn't parse isn't built
+	void TestFailedBuild()
+	{
+		SceneCache::SceneData scene;
+		CHECK(!SceneCache::Build("Scene/missing.gltf", scene));
+
+		const std::string text = "{ \"asset\": ";
+		FileUtility::WriteBinaryFile("Scene/broken.gltf", reinterpret_cast<const uint8_t*>(text.data()), text.size());
+		CHECK(!SceneCache::Build("Scene/broken.gltf", scene));
+	}
+}
+
+int main()
+{
+	EnterTempDirectory();
+	Test::Run("Assign mesh offsets", TestAssignMeshOffsets);
+	Test::Run("Assign mesh offsets overflow", TestAssignMeshOffsetsOverflow);
+	Test::Run("Build", TestBuild);
+	Test::Run("Round trip", TestRoundTrip);
+	Test::Run("Source hash", TestSourceHash);
+	Test::Run("Corrupted cache", TestCorruptedCache);
+	Test::Run("Thread counts", TestThreadCounts);
+	Test::Run("Texture formats", TestTextureFormats);
+	Test::Run("GLB matches glTF", TestGLBMatchesGLTF);
+	Test::Run("Mapped glTF", TestMappedGLTF);
+	Test::Run("Failed build", TestFailedBuild);
+	return Test::Finish();
+}
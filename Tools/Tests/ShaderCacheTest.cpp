@@ -0,0 +1,292 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "Test.h"
+
+#include <Engine/Render/ShaderCache.h>
+#include <Engine/Utility/FileUtility.h>
+
+namespace
+{
+	namespace ShaderCache = GFX::ShaderCache;
+	using ShaderCache::Key;
+	using ShaderCache::Entry;
+	using ShaderCache::InputParameter;
+
+	void WriteFile(const std::string& path, const std::string& content)
+	{
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file << content;
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path)
+	{
+		std::vector<uint8_t> content;
+		FileUtility::ReadBinaryFile(path, content);
+		return content;
+	}
+
+	void WriteFile(const std::string& path, const std::vector<uint8_t>& content)
+	{
+		FileUtility::WriteBinaryFile(path, content.data(), content.size());
+	}
+
+	// Nothing is compiled, the cache only stores the bytes and the reflection it's given
+	Entry CreateEntry(uint32_t seed, uint32_t bytecodeSize, bool withInputParameters)
+	{
+		Entry entry;
+		for (uint32_t i = 0; i < bytecodeSize; i++) entry.Bytecode.push_back((uint8_t) (i * 31 + seed));
+		if (withInputParameters)
+		{
+			entry.InputParameters.push_back(InputParameter{ "POSITION", 0, 0, 3, 0x7 });
+			entry.InputParameters.push_back(InputParameter{ "TEXCOORD", 1, 0, 3, 0x3 });
+			entry.InputParameters.push_back(InputParameter{ "SV_InstanceID", 0, 8, 1, 0x1 });
+		}
+		return entry;
+	}
+
+	bool IsSameEntry(const Entry& a, const Entry& b)
+	{
+		return a.Bytecode == b.Bytecode && a.InputParameters == b.InputParameters;
+	}
+
+	// Source with an include, the key of the stage depends on both
+	class ShaderDirectory
+	{
+	public:
+		ShaderDirectory(const std::string& name) : m_Directory(Test::CreateTempDirectory(name))
+		{
+			WriteFile(GetPath("common.h"), "float Common() { return 1; }\n");
+			WriteFile(GetPath("a.hlsl"), "#include \"common.h\"\nfloat4 PS() : SV_Target { return Common(); }\n");
+		}
+
+		std::string GetPath(const std::string& fileName) const { return m_Directory + "/" + fileName; }
+
+		Key CreateKey(const std::vector<std::string>& defines = {}, const std::string& entryPoint = "PS") const
+		{
+			Key key;
+			CHECK(ShaderCache::CreateKey(GetPath("a.hlsl"), defines, entryPoint, "ps_6_0", "test", key));
+			return key;
+		}
+
+	private:
+		std::string m_Directory;
+	};
+
+	// Stored entry loads back the same for its key, with and without the input layout reflection
+	void TestRoundTrip()
+	{
+		const ShaderDirectory directory{ "ShaderCacheRoundTrip" };
+		const Key key = directory.CreateKey({ "ALPHA_DISCARD" });
+		const Key keyVS = directory.CreateKey({}, "VS");
+		CHECK(key.Hash != keyVS.Hash);
+		CHECK(ShaderCache::GetCachePath(key) != ShaderCache::GetCachePath(keyVS));
+		CHECK(key.Files.size() == 2);
+
+		const Entry entry = CreateEntry(1, 1000, false);
+		const Entry entryVS = CreateEntry(2, 333, true);
+		const std::string cachePath = directory.GetPath("Cache/ps.bin");
+		const std::string cachePathVS = directory.GetPath("Cache/vs.bin");
+		ShaderCache::Store(cachePath, key, entry);
+		ShaderCache::Store(cachePathVS, keyVS, entryVS);
+
+		Entry loaded;
+		CHECK(ShaderCache::Load(cachePath, key, loaded) && IsSameEntry(loaded, entry));
+		CHECK(ShaderCache::Load(cachePathVS, keyVS, loaded) && IsSameEntry(loaded, entryVS));
+		CHECK(!ShaderCache::Load(directory.GetPath("Cache/missing.bin"), key, loaded));
+
+		// Stored again over the old entry
+		const Entry replaced = CreateEntry(3, 64, true);
+		ShaderCache::Store(cachePath, key, replaced);
+		CHECK(ShaderCache::Load(cachePath, key, loaded) && IsSameEntry(loaded, replaced));
+	}
+
+	// Entry of a different key is a miss even at the same path, so is an edit of an include
+	void TestKeyMismatch()
+	{
+		const ShaderDirectory directory{ "ShaderCacheKeyMismatch" };
+		const Key key = directory.CreateKey();
+		const std::string cachePath = directory.GetPath("entry.bin");
+		ShaderCache::Store(cachePath, key, CreateEntry(1, 100, true));
+
+		Entry loaded;
+		CHECK(!ShaderCache::Load(cachePath, directory.CreateKey({ "SHADOWMAP" }), loaded));
+		CHECK(!ShaderCache::Load(cachePath, directory.CreateKey({}, "VS"), loaded));
+
+		// Collision of the hash still compares the description
+		Key collision = key;
+		collision.Description += "define: OTHER\n";
+		CHECK(!ShaderCache::Load(cachePath, collision, loaded));
+
+		WriteFile(directory.GetPath("common.h"), "float Common() { return 2; }\n");
+		const Key editedKey = directory.CreateKey();
+		CHECK(editedKey.Hash != key.Hash);
+		CHECK(!ShaderCache::Load(cachePath, editedKey, loaded));
+
+		WriteFile(directory.GetPath("common.h"), "float Common() { return 1; }\n");
+		CHECK(ShaderCache::Load(cachePath, directory.CreateKey(), loaded));
+		CHECK(loaded.Bytecode.size() == 100 && loaded.InputParameters.size() == 3);
+	}
+
+	// Truncated, extended or damaged file is rejected and the entry that was passed in isn't touched
+	void TestCorruptedEntries()
+	{
+		const ShaderDirectory directory{ "ShaderCacheCorrupted" };
+		const Key key = directory.CreateKey();
+		const std::string cachePath = directory.GetPath("entry.bin");
+		ShaderCache::Store(cachePath, key, CreateEntry(1, 500, true));
+		const std::vector<uint8_t> content = ReadFile(cachePath);
+		CHECK(content.size() > 500);
+
+		const Entry untouched = CreateEntry(9, 7, false);
+		const auto isRejected = [&](const std::vector<uint8_t>& damaged)
+		{
+			WriteFile(cachePath, damaged);
+			Entry loaded = untouched;
+			return !ShaderCache::Load(cachePath, key, loaded) && IsSameEntry(loaded, untouched);
+		};
+
+		for (size_t size : { (size_t) 0, (size_t) 3, (size_t) 8, (size_t) 20, content.size() / 2, content.size() - 1 })
+		{
+			CHECK(isRejected(std::vector<uint8_t>(content.begin(), content.begin() + size)));
+		}
+
+		std::vector<uint8_t> extended = content;
+		extended.push_back(0);
+		CHECK(isRejected(extended));
+
+		// Magic and version
+		for (size_t offset : { (size_t) 0, (size_t) 4 })
+		{
+			std::vector<uint8_t> damaged = content;
+			damaged[offset] ^= 0x5A;
+			CHECK(isRejected(damaged));
+		}
+
+		// Bytecode size past the end of the file
+		std::vector<uint8_t> damaged = content;
+		const size_t bytecodeSizeOffset = 12 + key.Description.size();
+		damaged[bytecodeSizeOffset + 3] = 0x7F;
+		CHECK(isRejected(damaged));
+
+		// Entry without bytecode is never valid
+		ShaderCache::Store(cachePath, key, Entry{});
+		Entry loaded;
+		CHECK(!ShaderCache::Load(cachePath, key, loaded));
+
+		WriteFile(cachePath, content);
+		CHECK(ShaderCache::Load(cachePath, key, loaded) && loaded.Bytecode.size() == 500);
+	}
+
+	// Order and duplicates of the defines don't change the key
+	void TestCanonicalDefines()
+	{
+		CHECK(ShaderCache::GetCanonicalDefines({}).empty());
+		CHECK((ShaderCache::GetCanonicalDefines({ "B", "A=1", "C", "A=1", "B" }) == std::vector<std::string>{ "A=1", "B", "C" }));
+
+		// Different values of a define are different defines
+		CHECK((ShaderCache::GetCanonicalDefines({ "A=2", "A=1" }) == std::vector<std::string>{ "A=1", "A=2" }));
+
+		const ShaderDirectory directory{ "ShaderCacheCanonicalDefines" };
+		const Key key = directory.CreateKey({ "USE_PBR", "ALPHA_DISCARD", "USE_IBL" });
+		CHECK(directory.CreateKey({ "USE_IBL", "USE_PBR", "ALPHA_DISCARD", "USE_PBR" }).Hash == key.Hash);
+		CHECK(directory.CreateKey({ "USE_IBL", "USE_PBR" }).Hash != key.Hash);
+	}
+
+	// Saved archive loads back with every entry, the compiler version and the rejection of the changed sources
+	void TestArchive()
+	{
+		const ShaderDirectory directory{ "ShaderCacheArchive" };
+		const Key keyPS = directory.CreateKey();
+		const Key keyVS = directory.CreateKey({}, "VS");
+		const Key keyShadow = directory.CreateKey({ "SHADOWMAP" });
+		const Entry entryPS = CreateEntry(1, 300, false);
+		const Entry entryVS = CreateEntry(2, 700, true);
+		const Entry entryShadow = CreateEntry(3, 1, false);
+
+		ShaderCache::Archive archive;
+		archive.SetCompilerVersion("dxc 1.7");
+		archive.Add(keyPS, CreateEntry(4, 10, true));
+		archive.Add(keyPS, entryPS);
+		archive.Add(keyVS, entryVS);
+		archive.Add(keyShadow, entryShadow);
+		CHECK(archive.GetNumEntries() == 3);
+
+		const std::string archivePath = directory.GetPath("Cache/archive.bin");
+		CHECK(archive.Save(archivePath));
+
+		ShaderCache::Archive loaded;
+		CHECK(loaded.Load(archivePath));
+		CHECK(loaded.GetCompilerVersion() == "dxc 1.7");
+		CHECK(loaded.GetNumEntries() == 3);
+
+		Entry found;
+		CHECK(loaded.Find(keyPS, found) && IsSameEntry(found, entryPS));
+		CHECK(loaded.Find(keyVS, found) && IsSameEntry(found, entryVS));
+		CHECK(loaded.Find(keyShadow, found) && IsSameEntry(found, entryShadow));
+		CHECK(!loaded.Find(directory.CreateKey({ "OTHER" }), found));
+
+		// Same archive gives the same file
+		const std::string savedAgainPath = directory.GetPath("Cache/saved_again.bin");
+		CHECK(loaded.Save(savedAgainPath));
+		CHECK(ReadFile(savedAgainPath) == ReadFile(archivePath));
+
+		Key collision = keyPS;
+		collision.Description += "define: OTHER\n";
+		CHECK(!loaded.Find(collision, found));
+
+		WriteFile(directory.GetPath("common.h"), "float Common() { return 2; }\n");
+		CHECK(!loaded.Find(directory.CreateKey(), found));
+	}
+
+	// Damaged archive fails to load and keeps what was loaded before
+	void TestCorruptedArchive()
+	{
+		const ShaderDirectory directory{ "ShaderCacheCorruptedArchive" };
+		const Key key = directory.CreateKey();
+
+		ShaderCache::Archive archive;
+		archive.SetCompilerVersion("dxc 1.7");
+		archive.Add(key, CreateEntry(1, 200, true));
+		const std::string archivePath = directory.GetPath("archive.bin");
+		CHECK(archive.Save(archivePath));
+		const std::vector<uint8_t> content = ReadFile(archivePath);
+
+		ShaderCache::Archive loaded;
+		CHECK(!loaded.Load(directory.GetPath("missing.bin")));
+		CHECK(loaded.Load(archivePath));
+
+		for (size_t size : { (size_t) 0, (size_t) 6, content.size() / 2, content.size() - 1 })
+		{
+			WriteFile(archivePath, std::vector<uint8_t>(content.begin(), content.begin() + size));
+			CHECK(!loaded.Load(archivePath));
+		}
+
+		std::vector<uint8_t> damaged = content;
+		damaged[4] ^= 0x5A;
+		WriteFile(archivePath, damaged);
+		CHECK(!loaded.Load(archivePath));
+
+		damaged = content;
+		damaged.push_back(0);
+		WriteFile(archivePath, damaged);
+		CHECK(!loaded.Load(archivePath));
+
+		Entry found;
+		CHECK(loaded.GetCompilerVersion() == "dxc 1.7");
+		CHECK(loaded.Find(key, found) && found.Bytecode.size() == 200);
+	}
+}
+
+int main()
+{
+	Test::Run("Round trip", TestRoundTrip);
+	Test::Run("Key mismatch", TestKeyMismatch);
+	Test::Run("Corrupted entries", TestCorruptedEntries);
+	Test::Run("Canonical defines", TestCanonicalDefines);
+	Test::Run("Archive", TestArchive);
+	Test::Run("Corrupted archive", TestCorruptedArchive);
+	return Test::Finish();
+}
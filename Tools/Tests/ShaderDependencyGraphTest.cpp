@@ -0,0 +1,206 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include "Test.h"
+
+#include <Engine/Render/ShaderDependencyGraph.h>
+
+namespace
+{
+	using Implementation = ShaderDependencyGraph::Implementation;
+	namespace ShaderCache = GFX::ShaderCache;
+
+	// Graph only compares the shader pointers, they are never dereferenced
+	Shader* const SHADER_A = reinterpret_cast<Shader*>(0x1000);
+	Shader* const SHADER_B = reinterpret_cast<Shader*>(0x2000);
+	Shader* const SHADER_C = reinterpret_cast<Shader*>(0x3000);
+
+	void WriteFile(const std::string& path, const std::string& content)
+	{
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file << content;
+	}
+
+	bool Contains(const std::vector<Implementation>& implementations, const Implementation& implementation)
+	{
+		return std::find(implementations.begin(), implementations.end(), implementation) != implementations.end();
+	}
+
+	bool IsOnly(const std::vector<Implementation>& implementations, const Implementation& implementation)
+	{
+		return implementations.size() == 1 && implementations[0] == implementation;
+	}
+
+	// Directory of fake shaders, nothing is compiled, the graph only needs the hashes of the keys
+	// a.hlsl -> common.h -> nested.h
+	// b.hlsl -> common.h -> nested.h, b.hlsl -> other.h
+	// c.hlsl
+	class ShaderDirectory
+	{
+	public:
+		ShaderDirectory(const std::string& name) : m_Directory(Test::CreateTempDirectory(name))
+		{
+			WriteFile(GetPath("nested.h"), "#define NESTED 1\n");
+			WriteFile(GetPath("common.h"), "#include \"nested.h\"\nfloat Common() { return NESTED; }\n");
+			WriteFile(GetPath("other.h"), "float Other() { return 2; }\n");
+			WriteFile(GetPath("a.hlsl"), "#include \"common.h\"\nfloat4 PS() : SV_Target { return Common(); }\n");
+			WriteFile(GetPath("b.hlsl"), "#include \"common.h\"\n#include \"other.h\"\nfloat4 PS() : SV_Target { return Common() + Other(); }\n");
+			WriteFile(GetPath("c.hlsl"), "float4 CS() { return 0; }\n");
+		}
+
+		std::string GetPath(const std::string& fileName) const { return m_Directory + "/" + fileName; }
+
+		// Same files as the compilation of the implementation adds to the graph, the source that can't be read is added with the hash 0
+		std::vector<ShaderCache::FileHash> GetFiles(const std::string& fileName, const std::string& entryPoint, const std::vector<std::string>& defines = {}) const
+		{
+			ShaderCache::Key key;
+			if (!ShaderCache::CreateKey(GetPath(fileName), defines, entryPoint, "ps_6_0", "test", key)) return { ShaderCache::FileHash{ GetPath(fileName), 0 } };
+			return key.Files;
+		}
+
+	private:
+		std::string m_Directory;
+	};
+
+	void SetupGraph(const ShaderDirectory& directory, ShaderDependencyGraph& graph)
+	{
+		// Two implementations of A, stages of B share the files
+		graph.SetDependencies({ SHADER_A, 0 }, directory.GetFiles("a.hlsl", "PS"));
+		graph.SetDependencies({ SHADER_A, 1 }, directory.GetFiles("a.hlsl", "PS", { "VARIANT" }));
+
+		std::vector<ShaderCache::FileHash> filesB = directory.GetFiles("b.hlsl", "VS");
+		const std::vector<ShaderCache::FileHash> filesPS = directory.GetFiles("b.hlsl", "PS");
+		filesB.insert(filesB.end(), filesPS.begin(), filesPS.end());
+		graph.SetDependencies({ SHADER_B, 0 }, filesB);
+
+		graph.SetDependencies({ SHADER_C, 0 }, directory.GetFiles("c.hlsl", "CS"));
+	}
+
+	void TestIncludes()
+	{
+		const ShaderDirectory directory{ "ShaderDependencyGraphIncludes" };
+		ShaderDependencyGraph graph;
+		SetupGraph(directory, graph);
+
+		CHECK(graph.GetNumFiles() == 6);
+
+		// Nested include is found through common.h
+		const std::vector<Implementation> nestedDependents = graph.GetDependents(directory.GetPath("nested.h"));
+		CHECK(nestedDependents.size() == 3);
+		CHECK(Contains(nestedDependents, { SHADER_A, 0 }) && Contains(nestedDependents, { SHADER_A, 1 }) && Contains(nestedDependents, { SHADER_B, 0 }));
+
+		CHECK(IsOnly(graph.GetDependents(directory.GetPath("other.h")), { SHADER_B, 0 }));
+		CHECK(IsOnly(graph.GetDependents(directory.GetPath("c.hlsl")), { SHADER_C, 0 }));
+		CHECK(graph.GetDependents(directory.GetPath("missing.h")).empty());
+
+		// Nothing changed since the keys were made
+		CHECK(graph.ScanForChanges().empty());
+	}
+
+	// Edit of the shared header invalidates everything that includes it, only once
+	void TestHeaderEdit()
+	{
+		const ShaderDirectory directory{ "ShaderDependencyGraphHeaderEdit" };
+		ShaderDependencyGraph graph;
+		SetupGraph(directory, graph);
+
+		WriteFile(directory.GetPath("nested.h"), "#define NESTED 2\n");
+		const std::vector<Implementation> changed = graph.ScanForChanges();
+		CHECK(changed.size() == 3);
+		CHECK(!Contains(changed, { SHADER_C, 0 }));
+		CHECK(graph.ScanForChanges().empty());
+
+		WriteFile(directory.GetPath("other.h"), "float Other() { return 3; }\n");
+		CHECK(IsOnly(graph.ScanForChanges(), { SHADER_B, 0 }));
+
+		// Recompiled implementation gets the new hashes and isn't invalidated by them
+		graph.SetDependencies({ SHADER_B, 0 }, directory.GetFiles("b.hlsl", "PS"));
+		CHECK(graph.ScanForChanges().empty());
+	}
+
+	// Checkout with the other line endings is the same shader, the key and the hashes don't change
+	void TestLineEndingsOnlyEdit()
+	{
+		const ShaderDirectory directory{ "ShaderDependencyGraphLineEndings" };
+		ShaderDependencyGraph graph;
+		SetupGraph(directory, graph);
+
+		ShaderCache::Key keyBefore;
+		CHECK(ShaderCache::CreateKey(directory.GetPath("b.hlsl"), {}, "PS", "ps_6_0", "test", keyBefore));
+
+		WriteFile(directory.GetPath("common.h"), "#include \"nested.h\"\r\nfloat Common() { return NESTED; }\r\n");
+		WriteFile(directory.GetPath("b.hlsl"), "#include \"common.h\"\r\n#include \"other.h\"\r\nfloat4 PS() : SV_Target { return Common() + Other(); }\r\n");
+		CHECK(graph.ScanForChanges().empty());
+
+		ShaderCache::Key keyAfter;
+		CHECK(ShaderCache::CreateKey(directory.GetPath("b.hlsl"), {}, "PS", "ps_6_0", "test", keyAfter));
+		CHECK(keyAfter.Hash == keyBefore.Hash);
+
+		// Any other whitespace is a change
+		WriteFile(directory.GetPath("common.h"), "#include \"nested.h\"\r\nfloat Common() { return NESTED;  }\r\n");
+		CHECK(graph.ScanForChanges().size() == 3);
+	}
+
+	// Removed shader doesn't keep its files in the graph
+	void TestRemovedShader()
+	{
+		const ShaderDirectory directory{ "ShaderDependencyGraphRemovedShader" };
+		ShaderDependencyGraph graph;
+		SetupGraph(directory, graph);
+
+		graph.Remove(SHADER_B);
+		CHECK(graph.GetNumFiles() == 4);
+		CHECK(graph.GetDependents(directory.GetPath("other.h")).empty());
+		CHECK(graph.GetDependents(directory.GetPath("common.h")).size() == 2);
+
+		WriteFile(directory.GetPath("other.h"), "float Other() { return 3; }\n");
+		CHECK(graph.ScanForChanges().empty());
+
+		WriteFile(directory.GetPath("common.h"), "#include \"nested.h\"\nfloat Common() { return 2 * NESTED; }\n");
+		const std::vector<Implementation> changed = graph.ScanForChanges();
+		CHECK(changed.size() == 2);
+		CHECK(!Contains(changed, { SHADER_B, 0 }));
+
+		// Removing every implementation empties the graph, removing twice does nothing
+		graph.Remove(SHADER_A);
+		graph.Remove(SHADER_A);
+		graph.Remove(SHADER_C);
+		CHECK(graph.GetNumFiles() == 0);
+	}
+
+	// Deleted source invalidates its implementations, the source that appears again invalidates them once more
+	void TestDeletedSource()
+	{
+		const ShaderDirectory directory{ "ShaderDependencyGraphDeletedSource" };
+		ShaderDependencyGraph graph;
+		SetupGraph(directory, graph);
+
+		std::filesystem::remove(directory.GetPath("c.hlsl"));
+		CHECK(IsOnly(graph.ScanForChanges(), { SHADER_C, 0 }));
+		CHECK(graph.ScanForChanges().empty());
+
+		// Failed compilation of the missing source tracks it with the hash 0
+		graph.SetDependencies({ SHADER_C, 0 }, directory.GetFiles("c.hlsl", "CS"));
+		CHECK(graph.ScanForChanges().empty());
+
+		WriteFile(directory.GetPath("c.hlsl"), "float4 CS() { return 1; }\n");
+		CHECK(IsOnly(graph.ScanForChanges(), { SHADER_C, 0 }));
+
+		// Deleted include is a change of every shader that includes it
+		std::filesystem::remove(directory.GetPath("nested.h"));
+		CHECK(graph.ScanForChanges().size() == 3);
+	}
+}
+
+int main()
+{
+	Test::Run("Includes", TestIncludes);
+	Test::Run("Header edit", TestHeaderEdit);
+	Test::Run("Line endings only edit", TestLineEndingsOnlyEdit);
+	Test::Run("Removed shader", TestRemovedShader);
+	Test::Run("Deleted source", TestDeletedSource);
+	return Test::Finish();
+}
@@ -0,0 +1,152 @@
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Test.h"
+
+#include <Engine/Render/ShaderPermutation.h>
+
+#include "Renderers/Util/ShaderDeclarations.h"
+
+namespace
+{
+	const ShaderPermutationLayout& GetTestLayout()
+	{
+		static const ShaderPermutationLayout layout{
+			ShaderPermutationAxis::Option({ "PASS_A", "PASS_B", "PASS_C" }),
+			ShaderPermutationAxis::Flag("FLAG_X"),
+			ShaderPermutationAxis::Flag("FLAG_Y"),
+			ShaderPermutationAxis::Option({ "QUALITY_LOW", "QUALITY_HIGH" }),
+		};
+		return layout;
+	}
+
+	// Same set of defines is the same key, the order and the repeats don't matter
+	void TestCanonicalKeys()
+	{
+		const ShaderPermutationLayout& layout = GetTestLayout();
+
+		CHECK(layout.GetKey({}) == 0);
+		CHECK(layout.GetKey({ "FLAG_X", "FLAG_Y" }) == layout.GetKey({ "FLAG_Y", "FLAG_X" }));
+		CHECK(layout.GetKey({ "PASS_B", "FLAG_Y", "QUALITY_HIGH" }) == layout.GetKey({ "QUALITY_HIGH", "PASS_B", "FLAG_Y" }));
+		CHECK(layout.GetKey({ "FLAG_X", "FLAG_X" }) == layout.GetKey({ "FLAG_X" }));
+		CHECK(layout.GetKey({ "FLAG_X" }) != layout.GetKey({ "FLAG_Y" }));
+
+		// Default option is the same as not setting the axis at all
+		CHECK(layout.GetKey({ "PASS_A", "QUALITY_LOW" }) == layout.GetKey({}));
+
+		// nullptr is skipped, the conditional define can be written inline
+		CHECK(layout.GetKey({ "FLAG_X", nullptr, "PASS_C" }) == layout.GetKey({ "PASS_C", "FLAG_X" }));
+
+		// Later define of the same option axis wins
+		CHECK(layout.GetKey({ "PASS_B", "PASS_C" }) == layout.GetKey({ "PASS_C" }));
+		CHECK(layout.SetDefine(layout.GetKey({ "PASS_C", "FLAG_Y" }), "PASS_B") == layout.GetKey({ "PASS_B", "FLAG_Y" }));
+
+		// Setting a define that is already set doesn't change the key
+		const ShaderPermutationKey key = layout.GetKey({ "PASS_B", "FLAG_X" });
+		CHECK(layout.SetDefine(key, "FLAG_X") == key);
+		CHECK(layout.SetDefine(key, nullptr) == key);
+	}
+
+	// Defines come back in the order of the axes and make the same key again
+	void TestDefinesRoundTrip()
+	{
+		const ShaderPermutationLayout& layout = GetTestLayout();
+
+		const std::vector<std::string> defines = layout.GetDefines(layout.GetKey({ "QUALITY_HIGH", "FLAG_Y", "PASS_C" }));
+		CHECK((defines == std::vector<std::string>{ "PASS_C", "FLAG_Y", "QUALITY_HIGH" }));
+
+		// Options always have a define, flags only when they are set
+		CHECK((layout.GetDefines(0) == std::vector<std::string>{ "PASS_A", "QUALITY_LOW" }));
+	}
+
+	void TestIsValid()
+	{
+		const ShaderPermutationLayout& layout = GetTestLayout();
+
+		CHECK(layout.IsValid(0));
+		CHECK(layout.IsValid(layout.GetKey({ "PASS_C", "FLAG_X", "FLAG_Y", "QUALITY_HIGH" })));
+
+		// Option axis with 3 values takes 2 bits, the 4th value doesn't exist
+		CHECK(!layout.IsValid(3));
+
+		// Bits after the last axis
+		CHECK(!layout.IsValid(1ull << 5));
+		CHECK(!layout.IsValid(1ull << 40));
+
+		// Layout without axes has only the key 0
+		const ShaderPermutationLayout empty{};
+		CHECK(empty.IsValid(0));
+		CHECK(!empty.IsValid(1));
+		CHECK(empty.GetNumPermutations() == 1);
+		CHECK((empty.EnumeratePermutations() == std::vector<ShaderPermutationKey>{ 0 }));
+	}
+
+	// Every valid key exactly once, which is every combination of the defines
+	void TestEnumeration()
+	{
+		const ShaderPermutationLayout& layout = GetTestLayout();
+
+		CHECK(layout.GetNumPermutations() == 3 * 2 * 2 * 2);
+
+		const std::vector<ShaderPermutationKey> permutations = layout.EnumeratePermutations();
+		CHECK(permutations.size() == layout.GetNumPermutations());
+
+		const std::set<ShaderPermutationKey> unique{ permutations.begin(), permutations.end() };
+		CHECK(unique.size() == permutations.size());
+
+		bool valid = true;
+		bool roundTrip = true;
+		for (ShaderPermutationKey key : permutations)
+		{
+			valid &= layout.IsValid(key);
+
+			ShaderPermutationKey rebuilt = 0;
+			for (const std::string& define : layout.GetDefines(key)) rebuilt = layout.SetDefine(rebuilt, define.c_str());
+			roundTrip &= rebuilt == key;
+		}
+		CHECK(valid);
+		CHECK(roundTrip);
+
+		// Keys outside of the enumeration aren't valid
+		uint32_t numValid = 0;
+		for (ShaderPermutationKey key = 0; key < (1ull << 5); key++) numValid += layout.IsValid(key) ? 1 : 0;
+		CHECK(numValid == permutations.size());
+	}
+
+	// Declarations of the renderers only use the declared defines and every implementation is listed once
+	void TestShaderDeclarations()
+	{
+		std::set<std::string> paths;
+		for (const ShaderDeclaration& declaration : ShaderDeclarations::GetAll())
+		{
+			CHECK(paths.insert(declaration.Path).second);
+			CHECK(!declaration.DeclaredImplementations.empty());
+
+			std::set<std::pair<ShaderPermutationKey, uint32_t>> implementations;
+			for (const ShaderImplementationDesc& implementation : declaration.DeclaredImplementations)
+			{
+				CHECK(declaration.Permutations.IsValid(implementation.Permutation));
+				CHECK(implementation.Stages != 0 && implementation.Stages < (1u << SHADER_STAGE_COUNT));
+				CHECK(implementations.insert({ implementation.Permutation, implementation.Stages }).second);
+			}
+		}
+
+		// Required define is in every implementation, optional ones make all the combinations
+		const ShaderDeclaration& depth = ShaderDeclarations::Get("Forward+/Shaders/depth.hlsl");
+		CHECK(depth.DeclaredImplementations.size() == 4 + 2);
+
+		const ShaderDeclaration& geometry = ShaderDeclarations::Get("Forward+/Shaders/geometry.hlsl");
+		CHECK(geometry.DeclaredImplementations.size() == geometry.Permutations.GetNumPermutations());
+	}
+}
+
+int main()
+{
+	Test::Run("Canonical keys", TestCanonicalKeys);
+	Test::Run("Defines round trip", TestDefinesRoundTrip);
+	Test::Run("Is valid", TestIsValid);
+	Test::Run("Enumeration", TestEnumeration);
+	Test::Run("Shader declarations", TestShaderDeclarations);
+	return Test::Finish();
+}
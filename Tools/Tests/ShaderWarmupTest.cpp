@@ -0,0 +1,323 @@
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+
+#include "Test.h"
+
+#include <Engine/Render/ShaderWarmup.h>
+
+namespace
+{
+	using JobStatus = ShaderWarmup::JobStatus;
+
+	// Warm-up only compares the shader pointers, they are never dereferenced
+	Shader* const SHADER_A = reinterpret_cast<Shader*>(0x1000);
+	Shader* const SHADER_B = reinterpret_cast<Shader*>(0x2000);
+
+	// Compile function that counts the calls, can be held in the compilation until it is opened
+	class MockCompiler
+	{
+	public:
+		explicit MockCompiler(bool startOpen = true) : m_Open(startOpen) {}
+
+		ShaderWarmup::CompileFunc GetFunc()
+		{
+			return [this](Shader* shader, uint64_t implementationKey)
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_NumCalls[{ shader, implementationKey }]++;
+				m_LastThread = std::this_thread::get_id();
+				m_NumCompiling++;
+				m_StateChanged.notify_all();
+
+				m_StateChanged.wait(lock, [this] { return m_Open; });
+				m_NumCompiling--;
+				return !m_FailingKeys.contains(implementationKey);
+			};
+		}
+
+		void Open()
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Open = true;
+			m_StateChanged.notify_all();
+		}
+
+		void FailKey(uint64_t implementationKey)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_FailingKeys.insert(implementationKey);
+		}
+
+		// Waits until the number of the compilations held at the gate is reached
+		void WaitForCompiling(uint32_t numCompiling)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_StateChanged.wait(lock, [&] { return m_NumCompiling == numCompiling; });
+		}
+
+		uint32_t GetNumCalls(Shader* shader, uint64_t implementationKey)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			const auto it = m_NumCalls.find({ shader, implementationKey });
+			return it == m_NumCalls.end() ? 0 : it->second;
+		}
+
+		std::thread::id GetLastThread()
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			return m_LastThread;
+		}
+
+	private:
+		std::mutex m_Mutex;
+		std::condition_variable m_StateChanged;
+		bool m_Open;
+		uint32_t m_NumCompiling = 0;
+		std::map<std::pair<Shader*, uint64_t>, uint32_t> m_NumCalls;
+		std::set<uint64_t> m_FailingKeys;
+		std::thread::id m_LastThread;
+	};
+
+	void TestRequest()
+	{
+		MockCompiler compiler;
+		compiler.FailKey(2);
+		ShaderWarmup warmup{ compiler.GetFunc(), 2 };
+
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::NotRequested);
+		CHECK(warmup.Request(SHADER_A, 1));
+		CHECK(warmup.Request(SHADER_A, 2));
+		CHECK(warmup.Request(SHADER_B, 1));
+
+		// Same implementation is requested only once
+		CHECK(!warmup.Request(SHADER_A, 1));
+
+		warmup.WaitAll();
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Ready);
+		CHECK(warmup.GetStatus(SHADER_A, 2) == JobStatus::Failed);
+		CHECK(warmup.GetStatus(SHADER_B, 1) == JobStatus::Ready);
+		CHECK(!warmup.IsPending(SHADER_A, 1));
+		CHECK(compiler.GetNumCalls(SHADER_A, 1) == 1);
+		CHECK(compiler.GetNumCalls(SHADER_B, 1) == 1);
+
+		// Finished implementation isn't compiled again
+		CHECK(!warmup.Request(SHADER_A, 1));
+
+		const ShaderWarmup::Progress progress = warmup.GetProgress();
+		CHECK(progress.NumRequested == 3);
+		CHECK(progress.NumFinished == 3);
+		CHECK(progress.NumFailed == 1);
+		CHECK(progress.CompileTimeMS >= 0.0f);
+	}
+
+	// Without the workers the queued job is compiled on the thread that waits for it
+	void TestWaitCompilesQueuedJob()
+	{
+		MockCompiler compiler;
+		ShaderWarmup warmup{ compiler.GetFunc(), 0 };
+
+		CHECK(warmup.Wait(SHADER_A, 1) == JobStatus::NotRequested);
+
+		warmup.Request(SHADER_A, 1);
+		warmup.Request(SHADER_A, 2);
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Queued);
+		CHECK(warmup.IsPending(SHADER_A, 1));
+
+		CHECK(warmup.Wait(SHADER_A, 1) == JobStatus::Ready);
+		CHECK(compiler.GetLastThread() == std::this_thread::get_id());
+
+		// Other job is still queued
+		CHECK(warmup.GetStatus(SHADER_A, 2) == JobStatus::Queued);
+		CHECK(compiler.GetNumCalls(SHADER_A, 2) == 0);
+		CHECK(warmup.GetProgress().NumFinished == 1);
+	}
+
+	// Job in progress on the worker isn't compiled twice, the waiting thread blocks until the worker finishes it
+	void TestWaitForWorker()
+	{
+		MockCompiler compiler{ false };
+		ShaderWarmup warmup{ compiler.GetFunc(), 1 };
+
+		warmup.Request(SHADER_A, 1);
+		compiler.WaitForCompiling(1);
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Compiling);
+
+		std::atomic<bool> waitFinished = false;
+		std::thread waitingThread{ [&] { CHECK(warmup.Wait(SHADER_A, 1) == JobStatus::Ready); waitFinished = true; } };
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		CHECK(!waitFinished);
+
+		compiler.Open();
+		waitingThread.join();
+		CHECK(waitFinished);
+		CHECK(compiler.GetNumCalls(SHADER_A, 1) == 1);
+	}
+
+	void TestCancelQueued()
+	{
+		MockCompiler compiler;
+		ShaderWarmup warmup{ compiler.GetFunc(), 0 };
+
+		for (uint64_t key = 0; key < 3; key++) warmup.Request(SHADER_A, key);
+		warmup.Request(SHADER_B, 0);
+
+		warmup.Cancel(SHADER_A);
+		for (uint64_t key = 0; key < 3; key++) CHECK(warmup.GetStatus(SHADER_A, key) == JobStatus::NotRequested);
+		CHECK(warmup.GetStatus(SHADER_B, 0) == JobStatus::Queued);
+		CHECK(warmup.GetProgress().NumRequested == 1);
+
+		CHECK(warmup.Wait(SHADER_B, 0) == JobStatus::Ready);
+		warmup.WaitAll();
+		CHECK(compiler.GetNumCalls(SHADER_A, 0) == 0);
+
+		// New shader at the same address can request the same implementations again
+		CHECK(warmup.Request(SHADER_A, 0));
+		CHECK(warmup.Wait(SHADER_A, 0) == JobStatus::Ready);
+	}
+
+	// Cancel waits for the compilation in progress, the shader can be deleted after it returns
+	void TestCancelCompiling()
+	{
+		MockCompiler compiler{ false };
+		ShaderWarmup warmup{ compiler.GetFunc(), 1 };
+
+		warmup.Request(SHADER_A, 1);
+		warmup.Request(SHADER_A, 2);
+		compiler.WaitForCompiling(1);
+
+		std::atomic<bool> cancelFinished = false;
+		std::thread cancelThread{ [&] { warmup.Cancel(SHADER_A); cancelFinished = true; } };
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		CHECK(!cancelFinished);
+
+		compiler.Open();
+		cancelThread.join();
+
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::NotRequested);
+		CHECK(warmup.GetStatus(SHADER_A, 2) == JobStatus::NotRequested);
+		CHECK(compiler.GetNumCalls(SHADER_A, 2) == 0);
+
+		// Nothing is left for WaitAll
+		warmup.WaitAll();
+		const ShaderWarmup::Progress progress = warmup.GetProgress();
+		CHECK(progress.NumFinished == progress.NumRequested);
+	}
+
+	// Compilation in progress could have read the old files, the job is compiled once more after it
+	void TestRecompileWhileCompiling()
+	{
+		MockCompiler compiler{ false };
+		ShaderWarmup warmup{ compiler.GetFunc(), 1 };
+
+		warmup.Request(SHADER_A, 1);
+		compiler.WaitForCompiling(1);
+
+		warmup.Recompile(SHADER_A, 1);
+		warmup.Recompile(SHADER_A, 1);
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Compiling);
+
+		compiler.Open();
+		warmup.WaitAll();
+		CHECK(compiler.GetNumCalls(SHADER_A, 1) == 2);
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Ready);
+	}
+
+	void TestRecompile()
+	{
+		MockCompiler compiler;
+		ShaderWarmup warmup{ compiler.GetFunc(), 0 };
+
+		// Queued job is already going to read the new files
+		warmup.Request(SHADER_A, 1);
+		warmup.Recompile(SHADER_A, 1);
+		warmup.Wait(SHADER_A, 1);
+		CHECK(compiler.GetNumCalls(SHADER_A, 1) == 1);
+		CHECK(warmup.GetProgress().NumRequested == 1);
+
+		// Finished job is queued again, not requested one is queued for the first time
+		warmup.Recompile(SHADER_A, 1);
+		warmup.Recompile(SHADER_B, 1);
+		CHECK(warmup.GetStatus(SHADER_A, 1) == JobStatus::Queued);
+		CHECK(warmup.GetStatus(SHADER_B, 1) == JobStatus::Queued);
+
+		warmup.Wait(SHADER_A, 1);
+		warmup.Wait(SHADER_B, 1);
+		CHECK(compiler.GetNumCalls(SHADER_A, 1) == 2);
+		CHECK(compiler.GetNumCalls(SHADER_B, 1) == 1);
+	}
+
+	// Many jobs on many threads while the main thread waits for some of them, every job is compiled once
+	void TestWaitAll()
+	{
+		constexpr uint64_t NUM_JOBS = 500;
+
+		MockCompiler compiler;
+		ShaderWarmup warmup{ compiler.GetFunc(), 4 };
+
+		for (uint64_t key = 0; key < NUM_JOBS; key++)
+		{
+			warmup.Request(SHADER_A, key);
+			warmup.Request(SHADER_B, key);
+			if (key % 7 == 0) CHECK(warmup.Wait(SHADER_B, key / 2) == JobStatus::Ready);
+		}
+		warmup.WaitAll();
+
+		bool compiledOnce = true;
+		bool ready = true;
+		for (uint64_t key = 0; key < NUM_JOBS; key++)
+		{
+			compiledOnce &= compiler.GetNumCalls(SHADER_A, key) == 1 && compiler.GetNumCalls(SHADER_B, key) == 1;
+			ready &= warmup.GetStatus(SHADER_A, key) == JobStatus::Ready && warmup.GetStatus(SHADER_B, key) == JobStatus::Ready;
+		}
+		CHECK(compiledOnce);
+		CHECK(ready);
+
+		const ShaderWarmup::Progress progress = warmup.GetProgress();
+		CHECK(progress.NumRequested == 2 * NUM_JOBS);
+		CHECK(progress.NumFinished == 2 * NUM_JOBS);
+		CHECK(progress.NumFailed == 0);
+
+		// Compile time stops growing once the batch is finished
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		CHECK(warmup.GetProgress().CompileTimeMS == progress.CompileTimeMS);
+	}
+
+	// Queued jobs are dropped, the one in progress is finished before the workers are joined
+	void TestDestroyWithPendingJobs()
+	{
+		MockCompiler compiler{ false };
+		std::thread opener;
+		{
+			ShaderWarmup warmup{ compiler.GetFunc(), 1 };
+			for (uint64_t key = 0; key < 10; key++) warmup.Request(SHADER_A, key);
+			compiler.WaitForCompiling(1);
+
+			opener = std::thread{ [&] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); compiler.Open(); } };
+		}
+		opener.join();
+
+		CHECK(compiler.GetNumCalls(SHADER_A, 0) == 1);
+		CHECK(compiler.GetNumCalls(SHADER_A, 9) == 0);
+	}
+}
+
+int main()
+{
+	Test::Run("Request", TestRequest);
+	Test::Run("Wait compiles queued job", TestWaitCompilesQueuedJob);
+	Test::Run("Wait for worker", TestWaitForWorker);
+	Test::Run("Cancel queued", TestCancelQueued);
+	Test::Run("Cancel compiling", TestCancelCompiling);
+	Test::Run("Recompile while compiling", TestRecompileWhileCompiling);
+	Test::Run("Recompile", TestRecompile);
+	Test::Run("Wait all", TestWaitAll);
+	Test::Run("Destroy with pending jobs", TestDestroyWithPendingJobs);
+	return Test::Finish();
+}
@@ -0,0 +1,177 @@
+// Packing efficiency of the local light shadow atlas
+// Tiles are 6 faces of power of 2 sizes between ShadowAtlas::MIN_TILE_SIZE and MAX_TILE_SIZE
+//
+// Usage: ShadowAtlasPackingBenchmark [--frames <count>]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include <Engine/Utility/MemoryStrategies.h>
+#include <Renderers/Util/ShadowAtlas.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr uint32_t ATLAS_SIZE = ShadowAtlas::ATLAS_SIZE;
+	constexpr uint32_t MIN_TILE_SIZE = ShadowAtlas::MIN_TILE_SIZE;
+	constexpr uint32_t MAX_TILE_SIZE = ShadowAtlas::MAX_TILE_SIZE;
+	constexpr uint32_t NUM_FACES = ShadowAtlasEntry::MAX_FACES;
+	constexpr uint64_t ATLAS_AREA = (uint64_t) ATLAS_SIZE * ATLAS_SIZE;
+
+	// Most lights are far away, so the small tiles are the most common
+	uint32_t RandomTileSize(std::mt19937& random)
+	{
+		std::discrete_distribution<uint32_t> sizeShift{ 8, 6, 4, 2, 1 };
+		return std::min(MIN_TILE_SIZE << sizeShift(random), MAX_TILE_SIZE);
+	}
+
+	// Importance that selects the tile size
+	float RandomImportance(std::mt19937& random)
+	{
+		return (float) RandomTileSize(random) / MAX_TILE_SIZE;
+	}
+
+	bool AllocateLight(QuadTreeStrategy& allocator, uint32_t tileSize, std::vector<AtlasAllocation>& tiles)
+	{
+		tiles.clear();
+		for (uint32_t face = 0; face < NUM_FACES; face++)
+		{
+			tiles.push_back(allocator.Allocate(tileSize));
+			if (tiles.back().IsValid()) continue;
+
+			for (AtlasAllocation& tile : tiles) allocator.Release(tile);
+			tiles.clear();
+			return false;
+		}
+		return true;
+	}
+
+	// Occupancy when the first light doesn't fit, in the order the lights come and sorted from the biggest tile
+	void BenchmarkFill(uint32_t numPasses)
+	{
+		std::mt19937 random{ 7 };
+
+		double arrivalOccupancy = 0.0;
+		double sortedOccupancy = 0.0;
+		for (uint32_t pass = 0; pass < numPasses; pass++)
+		{
+			std::vector<uint32_t> tileSizes;
+			uint64_t area = 0;
+			while (area <= ATLAS_AREA)
+			{
+				tileSizes.push_back(RandomTileSize(random));
+				area += (uint64_t) NUM_FACES * tileSizes.back() * tileSizes.back();
+			}
+
+			const auto fill = [](const std::vector<uint32_t>& sizes)
+			{
+				QuadTreeStrategy allocator{ ATLAS_SIZE, MIN_TILE_SIZE };
+				std::vector<AtlasAllocation> tiles;
+				for (uint32_t tileSize : sizes)
+				{
+					if (!AllocateLight(allocator, tileSize, tiles)) break;
+				}
+				return allocator.GetOccupancy();
+			};
+
+			arrivalOccupancy += fill(tileSizes);
+			std::sort(tileSizes.begin(), tileSizes.end(), std::greater<uint32_t>());
+			sortedOccupancy += fill(tileSizes);
+		}
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Fill until the first light doesn't fit, " << numPasses << " atlases" << std::endl;
+		std::cout << "  Arrival order:   " << 100.0 * arrivalOccupancy / numPasses << "% occupancy" << std::endl;
+		std::cout << "  Largest first:   " << 100.0 * sortedOccupancy / numPasses << "% occupancy" << std::endl;
+	}
+
+	// Lights keep their tiles between frames, a few change the importance every frame and get tiles of another size
+	// ShadowAtlas::Update evicts them, allocates the new tiles and packs the atlas again when the allocation fails
+	void BenchmarkChurn(uint32_t numFrames)
+	{
+		constexpr uint32_t NUM_LIGHTS = 24;
+		constexpr uint32_t CHANGES_PER_FRAME = 4;
+
+		std::mt19937 random{ 11 };
+		ShadowAtlas atlas{ ATLAS_SIZE, MIN_TILE_SIZE, MAX_TILE_SIZE };
+
+		std::vector<float> importances(NUM_LIGHTS);
+		for (float& importance : importances) importance = RandomImportance(random);
+
+		std::vector<ShadowAtlasRequest> requests;
+		const auto update = [&]()
+		{
+			requests.clear();
+			for (uint32_t i = 0; i < NUM_LIGHTS; i++)
+			{
+				ShadowAtlasRequest request{};
+				request.LightIndex = i;
+				request.NumFaces = NUM_FACES;
+				request.Importance = importances[i];
+				requests.push_back(request);
+			}
+			atlas.Update(requests, NUM_LIGHTS);
+		};
+		update();
+
+		uint64_t numRepacks = 0;
+		uint64_t numEvictions = 0;
+		uint64_t numShrinkedOrDropped = 0;
+		uint64_t numRedrawn = 0;
+		double occupancy = 0.0;
+
+		const Clock::time_point startTime = Clock::now();
+		for (uint32_t frame = 0; frame < numFrames; frame++)
+		{
+			for (uint32_t change = 0; change < CHANGES_PER_FRAME; change++) importances[random() % NUM_LIGHTS] = RandomImportance(random);
+			update();
+
+			const ShadowAtlasStats& stats = atlas.GetStats();
+			numRepacks += stats.Repacks;
+			numEvictions += stats.Evictions;
+			occupancy += stats.Occupancy;
+			for (const ShadowAtlasEntry& entry : atlas.GetEntries())
+			{
+				numRedrawn += entry.IsNew ? 1 : 0;
+				numShrinkedOrDropped += atlas.SelectTileSize(entry.Importance) != entry.TileSize ? 1 : 0;
+			}
+			numShrinkedOrDropped += stats.RequestedLights - stats.ShadowedLights;
+		}
+		const float timeMS = std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "Churn of " << NUM_LIGHTS << " lights, " << CHANGES_PER_FRAME << " importance changes per frame, " << numFrames << " frames" << std::endl;
+		std::cout << "  Occupancy:       " << 100.0 * occupancy / numFrames << "%" << std::endl;
+		std::cout << "  Repacks:         " << 100.0 * numRepacks / numFrames << "% of the frames" << std::endl;
+		std::cout << "  Evictions:       " << (double) numEvictions / numFrames << " per frame" << std::endl;
+		std::cout << "  Shrinked lights: " << (double) numShrinkedOrDropped / numFrames << " per frame got smaller tiles or no shadow to fit" << std::endl;
+		std::cout << "  Redrawn lights:  " << (double) numRedrawn / numFrames << " per frame out of " << NUM_LIGHTS << std::endl;
+		std::cout << "  CPU time:        " << 1000.0f * timeMS / numFrames << " us per frame" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t numFrames = 100000;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--frames" && i + 1 < argc) numFrames = std::max(std::atoi(argv[++i]), 1);
+		else
+		{
+			std::cout << "Usage: ShadowAtlasPackingBenchmark [--frames <count>]" << std::endl;
+			return 2;
+		}
+	}
+
+	BenchmarkFill(1000);
+	BenchmarkChurn(numFrames);
+	return 0;
+}
@@ -0,0 +1,323 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Scene/SceneGraph.h>
+#include <Renderers/Util/ShadowAtlas.h>
+
+namespace
+{
+	// Camera at the origin looking down +Z with a 90 degree field of view, the planes point inside
+	Camera CreateCamera()
+	{
+		const float side = std::sqrt(0.5f);
+
+		Camera camera{};
+		camera.Type = Camera::CameraType::Perspective;
+		camera.FOV = 90.0f;
+		camera.AspectRatio = 1.0f;
+		camera.CurrentTranform.Position = Float3{ 0.0f, 0.0f, 0.0f };
+		camera.CurrentTranform.Forward = Float3{ 0.0f, 0.0f, 1.0f };
+		camera.CameraFrustum.Planes[0] = Float4{ 0.0f, -side, side, 0.0f };
+		camera.CameraFrustum.Planes[1] = Float4{ 0.0f, side, side, 0.0f };
+		camera.CameraFrustum.Planes[2] = Float4{ side, 0.0f, side, 0.0f };
+		camera.CameraFrustum.Planes[3] = Float4{ -side, 0.0f, side, 0.0f };
+		camera.CameraFrustum.Planes[4] = Float4{ 0.0f, 0.0f, 1.0f, -camera.ZNear };
+		camera.CameraFrustum.Planes[5] = Float4{ 0.0f, 0.0f, -1.0f, camera.ZFar };
+		return camera;
+	}
+
+	Light CreateLight(Float3 position, float radius)
+	{
+		Light light{};
+		light.Position = position;
+		light.Falloff = Float2{ 0.0f, radius };
+		return light;
+	}
+
+	ShadowAtlasRequest CreateRequest(uint32_t lightIndex, float importance, uint32_t numFaces = 6)
+	{
+		ShadowAtlasRequest request{};
+		request.LightIndex = lightIndex;
+		request.NumFaces = numFaces;
+		request.Importance = importance;
+		return request;
+	}
+
+	bool IsPowerOfTwo(uint32_t value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+
+	// Every tile is in the atlas, aligned to its size, as big as the entry says and doesn't overlap any other
+	bool HasValidTiles(const ShadowAtlas& atlas)
+	{
+		std::vector<AtlasAllocation> tiles;
+		for (const ShadowAtlasEntry& entry : atlas.GetEntries())
+		{
+			for (uint32_t face = 0; face < entry.NumFaces; face++)
+			{
+				const AtlasAllocation& tile = entry.Tiles[face];
+				if (tile.Size != entry.TileSize || tile.X % tile.Size != 0 || tile.Y % tile.Size != 0) return false;
+				if (tile.X + tile.Size > atlas.GetAtlasSize() || tile.Y + tile.Size > atlas.GetAtlasSize()) return false;
+				tiles.push_back(tile);
+			}
+		}
+
+		for (size_t i = 0; i < tiles.size(); i++)
+		{
+			for (size_t j = i + 1; j < tiles.size(); j++)
+			{
+				const AtlasAllocation& a = tiles[i];
+				const AtlasAllocation& b = tiles[j];
+				if (a.X < b.X + b.Size && b.X < a.X + a.Size && a.Y < b.Y + b.Size && b.Y < a.Y + a.Size) return false;
+			}
+		}
+		return true;
+	}
+
+	const ShadowAtlasEntry* FindEntry(const ShadowAtlas& atlas, uint32_t lightIndex)
+	{
+		for (const ShadowAtlasEntry& entry : atlas.GetEntries())
+		{
+			if (entry.LightIndex == lightIndex) return &entry;
+		}
+		return nullptr;
+	}
+
+	uint32_t CountNewEntries(const ShadowAtlas& atlas)
+	{
+		const std::vector<ShadowAtlasEntry>& entries = atlas.GetEntries();
+		return (uint32_t) std::count_if(entries.begin(), entries.end(), [](const ShadowAtlasEntry& entry) { return entry.IsNew; });
+	}
+
+	// Light further away covers less of the screen, the same light is never more important further away
+	void TestImportanceDistance()
+	{
+		const Camera camera = CreateCamera();
+		float lastImportance = 1.0f;
+		for (float distance = 3.0f; distance < 500.0f; distance *= 1.25f)
+		{
+			const float importance = ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.5f, -0.5f, distance }, 2.0f), camera);
+			CHECK(importance > 0.0f && importance <= lastImportance);
+			lastImportance = importance;
+		}
+		CHECK(lastImportance < 0.01f);
+
+		// Bigger light at the same distance is more important
+		const float small = ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 50.0f }, 2.0f), camera);
+		const float big = ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 50.0f }, 8.0f), camera);
+		CHECK(big > small);
+
+		// Radius over the distance, the field of view of 90 degrees doesn't scale it
+		CHECK_NEAR(small, 2.0f / 50.0f, 1e-3f);
+	}
+
+	// Light that can't be seen has no importance, the camera inside of the light volume needs the full size
+	void TestImportanceVisibility()
+	{
+		const Camera camera = CreateCamera();
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, -20.0f }, 2.0f), camera) == 0.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 50.0f, 0.0f, 10.0f }, 2.0f), camera) == 0.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 2000.0f }, 2.0f), camera) == 0.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 10.0f }, 0.0f), camera) == 0.0f);
+
+		// Volume that reaches into the frustum is visible
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, -20.0f }, 25.0f), camera) == 1.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 1.0f }, 5.0f), camera) == 1.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, -1.0f }, 5.0f), camera) == 1.0f);
+
+		// Close to the volume of the narrow field of view it's clamped
+		Camera narrow = CreateCamera();
+		narrow.FOV = 30.0f;
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 5.5f }, 5.0f), narrow) == 1.0f);
+		CHECK(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 5.5f }, 5.0f), camera) < 1.0f);
+
+		// Ortho camera doesn't get smaller with the distance
+		Camera ortho = CreateCamera();
+		ortho.Type = Camera::CameraType::Ortho;
+		ortho.RectHeight = 40.0f;
+		CHECK_NEAR(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 20.0f }, 2.0f), ortho), 0.1f, 1e-6f);
+		CHECK_NEAR(ShadowAtlas::CalculateImportance(CreateLight(Float3{ 0.0f, 0.0f, 200.0f }, 2.0f), ortho), 0.1f, 1e-6f);
+	}
+
+	// Smallest power of 2 that isn't under the importance times the max size, clamped to [min, max]
+	void TestTileSizes()
+	{
+		const ShadowAtlas atlas{ ShadowAtlas::ATLAS_SIZE, ShadowAtlas::MIN_TILE_SIZE, ShadowAtlas::MAX_TILE_SIZE };
+		CHECK(atlas.SelectTileSize(0.0f) == ShadowAtlas::MIN_TILE_SIZE);
+		CHECK(atlas.SelectTileSize(0.01f) == ShadowAtlas::MIN_TILE_SIZE);
+		CHECK(atlas.SelectTileSize(0.07f) == 128);
+		CHECK(atlas.SelectTileSize(0.25f) == 256);
+		CHECK(atlas.SelectTileSize(0.3f) == 512);
+		CHECK(atlas.SelectTileSize(1.0f) == ShadowAtlas::MAX_TILE_SIZE);
+		CHECK(atlas.SelectTileSize(4.0f) == ShadowAtlas::MAX_TILE_SIZE);
+
+		uint32_t lastSize = 0;
+		for (float importance = 0.0f; importance <= 1.0f; importance += 0.001f)
+		{
+			const uint32_t tileSize = atlas.SelectTileSize(importance);
+			CHECK(IsPowerOfTwo(tileSize) && tileSize >= ShadowAtlas::MIN_TILE_SIZE && tileSize <= ShadowAtlas::MAX_TILE_SIZE);
+			CHECK(tileSize >= lastSize);
+			CHECK(tileSize == ShadowAtlas::MIN_TILE_SIZE || (float) tileSize / 2 < importance * ShadowAtlas::MAX_TILE_SIZE);
+			lastSize = tileSize;
+		}
+	}
+
+	// Only the most important lights up to the budget get a shadow, lights that can't be seen never do
+	void TestBudget()
+	{
+		ShadowAtlas atlas{ ShadowAtlas::ATLAS_SIZE, ShadowAtlas::MIN_TILE_SIZE, ShadowAtlas::MAX_TILE_SIZE };
+		std::vector<ShadowAtlasRequest> requests;
+		for (uint32_t i = 0; i < 10; i++) requests.push_back(CreateRequest(i, 0.01f * (float) (i + 1)));
+		requests.push_back(CreateRequest(10, 0.0f));
+		requests.push_back(CreateRequest(11, 0.0f));
+
+		atlas.Update(requests, 4);
+		CHECK(atlas.GetStats().RequestedLights == 12);
+		CHECK(atlas.GetStats().ShadowedLights == 4);
+		CHECK(atlas.GetEntries().size() == 4);
+		for (uint32_t i = 0; i < 4; i++) CHECK(atlas.GetEntries()[i].LightIndex == 9 - i);
+		CHECK(HasValidTiles(atlas));
+
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 10);
+		CHECK(!FindEntry(atlas, 10) && !FindEntry(atlas, 11));
+		CHECK(HasValidTiles(atlas));
+	}
+
+	// Tiles of the least important lights shrink first until everything fits, then the least important lights are dropped
+	void TestShrinkAndDrop()
+	{
+		ShadowAtlas atlas{ 1024, 64, 512 };
+
+		// 6 faces of 512 are more than the whole atlas
+		std::vector<ShadowAtlasRequest> requests = { CreateRequest(0, 1.0f) };
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 1 && atlas.GetEntries()[0].TileSize == 256);
+		CHECK(HasValidTiles(atlas));
+
+		// Most important light keeps the bigger tiles
+		requests = { CreateRequest(0, 1.0f), CreateRequest(1, 0.9f), CreateRequest(2, 0.8f) };
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 3);
+		CHECK(FindEntry(atlas, 0)->TileSize >= FindEntry(atlas, 1)->TileSize && FindEntry(atlas, 1)->TileSize >= FindEntry(atlas, 2)->TileSize);
+		CHECK(FindEntry(atlas, 2)->TileSize < 512);
+		CHECK(HasValidTiles(atlas));
+
+		// 42 lights of 6 faces of 64 fit into 1024x1024, the rest is dropped
+		requests.clear();
+		for (uint32_t i = 0; i < 50; i++) requests.push_back(CreateRequest(i, 1.0f));
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 42);
+		for (const ShadowAtlasEntry& entry : atlas.GetEntries()) CHECK(entry.TileSize == 64 && entry.LightIndex < 42);
+		CHECK(HasValidTiles(atlas));
+	}
+
+	// Entries that kept the tile size keep their tiles and aren't drawn again
+	void TestNewEntries()
+	{
+		ShadowAtlas atlas{ ShadowAtlas::ATLAS_SIZE, ShadowAtlas::MIN_TILE_SIZE, ShadowAtlas::MAX_TILE_SIZE };
+		std::vector<ShadowAtlasRequest> requests;
+		for (uint32_t i = 0; i < 8; i++) requests.push_back(CreateRequest(i, 0.05f * (float) (i + 1)));
+
+		atlas.Update(requests, 100);
+		CHECK(CountNewEntries(atlas) == 8);
+		CHECK(atlas.GetStats().Allocations == 8);
+		const std::vector<ShadowAtlasEntry> firstEntries = atlas.GetEntries();
+
+		// Small change of the importance keeps the tile size, the requests were sorted by the update
+		for (ShadowAtlasRequest& request : requests)
+		{
+			if (request.LightIndex == 3) request.Importance += 0.001f;
+		}
+		atlas.Update(requests, 100);
+		CHECK(CountNewEntries(atlas) == 0);
+		CHECK(atlas.GetStats().Allocations == 0 && atlas.GetStats().Evictions == 0);
+		for (const ShadowAtlasEntry& first : firstEntries)
+		{
+			const ShadowAtlasEntry* entry = FindEntry(atlas, first.LightIndex);
+			CHECK(entry && entry->Tiles[0].X == first.Tiles[0].X && entry->Tiles[0].Y == first.Tiles[0].Y);
+		}
+
+		// Light that came closer needs bigger tiles, a new light and a light that moved out of the view
+		for (ShadowAtlasRequest& request : requests)
+		{
+			if (request.LightIndex == 0) request.Importance = 0.9f;
+			if (request.LightIndex == 5) request.Importance = 0.0f;
+		}
+		requests.push_back(CreateRequest(8, 0.1f));
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 8);
+		CHECK(CountNewEntries(atlas) == 2);
+		CHECK(FindEntry(atlas, 0)->IsNew && FindEntry(atlas, 8)->IsNew);
+		CHECK(!FindEntry(atlas, 5));
+		CHECK(atlas.GetStats().Evictions == 2);
+		CHECK(atlas.GetStats().Allocations == 2);
+		CHECK(atlas.GetStats().Repacks == 0);
+		CHECK(HasValidTiles(atlas));
+
+		atlas.Clear();
+		CHECK(atlas.GetEntries().empty());
+		atlas.Update(requests, 100);
+		CHECK(CountNewEntries(atlas) == 8);
+	}
+
+	// Freed tiles are scattered so the bigger tile doesn't fit, the atlas is packed again and everything is drawn again
+	void TestEvictAndRepack()
+	{
+		ShadowAtlas atlas{ 1024, 64, 512 };
+
+		// 16 tiles of 256 fill the atlas
+		std::vector<ShadowAtlasRequest> requests;
+		for (uint32_t i = 0; i < 16; i++) requests.push_back(CreateRequest(i, 0.5f, 1));
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetEntries().size() == 16);
+		CHECK(atlas.GetStats().Occupancy == 1.0f);
+
+		// One light stays in every quadrant, the area of 512 is free but not in one piece
+		std::vector<uint32_t> keptLights;
+		for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+		{
+			for (const ShadowAtlasEntry& entry : atlas.GetEntries())
+			{
+				if (entry.Tiles[0].X / 512 + 2 * (entry.Tiles[0].Y / 512) != quadrant) continue;
+				keptLights.push_back(entry.LightIndex);
+				break;
+			}
+		}
+		CHECK(keptLights.size() == 4);
+
+		requests.clear();
+		for (uint32_t lightIndex : keptLights) requests.push_back(CreateRequest(lightIndex, 0.5f, 1));
+		requests.push_back(CreateRequest(16, 1.0f, 1));
+		atlas.Update(requests, 100);
+
+		CHECK(atlas.GetStats().Evictions == 12);
+		CHECK(atlas.GetStats().Repacks == 1);
+		CHECK(atlas.GetEntries().size() == 5);
+		CHECK(CountNewEntries(atlas) == 5);
+		CHECK(FindEntry(atlas, 16) && FindEntry(atlas, 16)->TileSize == 512);
+		for (uint32_t lightIndex : keptLights) CHECK(FindEntry(atlas, lightIndex) && FindEntry(atlas, lightIndex)->TileSize == 256);
+		CHECK(HasValidTiles(atlas));
+
+		// Packed atlas stays as it is in the next frame
+		atlas.Update(requests, 100);
+		CHECK(atlas.GetStats().Repacks == 0);
+		CHECK(CountNewEntries(atlas) == 0);
+	}
+}
+
+int main()
+{
+	Test::Run("Importance and distance", TestImportanceDistance);
+	Test::Run("Importance and visibility", TestImportanceVisibility);
+	Test::Run("Tile sizes", TestTileSizes);
+	Test::Run("Budget", TestBudget);
+	Test::Run("Shrink and drop", TestShrinkAndDrop);
+	Test::Run("New entries", TestNewEntries);
+	Test::Run("Evict and repack", TestEvictAndRepack);
+	return Test::Finish();
+}
@@ -0,0 +1,244 @@
+#include <vector>
+
+#include "Test.h"
+
+#include <Engine/Render/SignatureCache.h>
+
+namespace
+{
+	struct MockRootSignature
+	{
+		uint32_t Index = 0;
+		bool Global = false;
+		uint64_t LayoutHash = 0;
+	};
+
+	struct MockCommandSignature
+	{
+		uint32_t Index = 0;
+		uint64_t LayoutHash = 0;
+		const MockRootSignature* RootSignature = nullptr;
+	};
+
+	using Cache = SignatureCache<MockRootSignature, MockCommandSignature>;
+
+	// Factory that numbers the created signatures in the order of the creation
+	class MockFactory : public Cache::Factory
+	{
+	public:
+		MockRootSignature CreateRootSignature(const BindingLayout& layout, bool global) override
+		{
+			return MockRootSignature{ NumRootSignatures++, global, layout.GetHash() };
+		}
+
+		MockCommandSignature CreateCommandSignature(const IndirectLayout& layout, const MockRootSignature* rootSignature) override
+		{
+			return MockCommandSignature{ NumCommandSignatures++, layout.GetHash(), rootSignature };
+		}
+
+		uint32_t NumRootSignatures = 0;
+		uint32_t NumCommandSignatures = 0;
+	};
+
+	BindingLayout CreateLayout(uint32_t numCBVs, uint32_t numSRVs, uint32_t numUAVs, uint32_t numSamplers = 0)
+	{
+		BindingLayout layout;
+		for (uint32_t i = 0; i < numCBVs; i++) layout.CBVs.set(i);
+		for (uint32_t i = 0; i < numSRVs; i++) layout.SRVs.set(i);
+		for (uint32_t i = 0; i < numUAVs; i++) layout.UAVs.set(i);
+		layout.NumSamplers = numSamplers;
+		return layout;
+	}
+
+	IndirectLayout CreateIndirectLayout(std::initializer_list<IndirectLayout::ArgumentType> types, uint32_t byteStride)
+	{
+		IndirectLayout layout;
+		layout.ByteStride = byteStride;
+		for (IndirectLayout::ArgumentType type : types) layout.Arguments.push_back(IndirectLayout::Argument{ type });
+		return layout;
+	}
+
+	// Every limit of the global root signature, the last register that fits and the first one that doesn't
+	void TestGlobalFits()
+	{
+		using namespace GlobalRootSignature;
+
+		CHECK(Fits(BindingLayout{}));
+		CHECK(Fits(CreateLayout(CBV_COUNT, SRV_COUNT, UAV_COUNT, SAMPLER_COUNT)));
+		CHECK(!Fits(CreateLayout(CBV_COUNT + 1, 0, 0)));
+		CHECK(!Fits(CreateLayout(0, 0, UAV_COUNT + 1)));
+		CHECK(!Fits(CreateLayout(0, 0, 0, SAMPLER_COUNT + 1)));
+
+		// Registers are checked, not the number of the bound ones
+		BindingLayout highCBV;
+		highCBV.CBVs.set(CBV_COUNT);
+		CHECK(!Fits(highCBV));
+		BindingLayout highSRV;
+		highSRV.SRVs.set(SRV_COUNT - 1);
+		CHECK(Fits(highSRV));
+
+		BindingLayout pushConstants;
+		pushConstants.PushConstantBinding = PUSH_CONSTANT_BINDING;
+		pushConstants.PushConstantCount = PUSH_CONSTANT_COUNT;
+		CHECK(Fits(pushConstants));
+		pushConstants.PushConstantCount++;
+		CHECK(!Fits(pushConstants));
+		pushConstants.PushConstantCount = 1;
+		pushConstants.PushConstantBinding = 0;
+		CHECK(!Fits(pushConstants));
+
+		// Binding of the unused push constants doesn't matter
+		pushConstants.PushConstantCount = 0;
+		CHECK(Fits(pushConstants));
+
+		BindingLayout bindless;
+		bindless.BindlessTables.push_back({ BINDLESS_REGISTER_SPACE, 0 });
+		CHECK(Fits(bindless));
+		bindless.BindlessTables.push_back({ BINDLESS_REGISTER_SPACE + 1, 0 });
+		CHECK(!Fits(bindless));
+		bindless.BindlessTables.erase(bindless.BindlessTables.begin());
+		CHECK(!Fits(bindless));
+	}
+
+	// Fallback root signature only has the parameters that the layout binds, in the fixed order
+	void TestRootParameters()
+	{
+		const RootParameters global = GlobalRootSignature::GetParameters();
+		CHECK(global.PushConstants == 0 && global.CBVs == 1 && global.SRVs == 2 && global.UAVs == 3 && global.Samplers == 4 && global.FirstBindlessTable == 5);
+
+		CHECK(GetRootParameters(BindingLayout{}) == RootParameters{});
+
+		BindingLayout layout = CreateLayout(0, 1, 1);
+		layout.BindlessTables.push_back({ 2, 16 });
+		RootParameters parameters = GetRootParameters(layout);
+		CHECK(parameters.PushConstants == RootParameters::INVALID && parameters.CBVs == RootParameters::INVALID);
+		CHECK(parameters.SRVs == 0 && parameters.UAVs == 1 && parameters.FirstBindlessTable == 2);
+		CHECK(parameters.Samplers == RootParameters::INVALID);
+
+		layout.PushConstantCount = 4;
+		layout.NumSamplers = 1;
+		parameters = GetRootParameters(layout);
+		CHECK(parameters.PushConstants == 0 && parameters.SRVs == 1 && parameters.UAVs == 2 && parameters.Samplers == 3 && parameters.FirstBindlessTable == 4);
+	}
+
+	// All layouts that fit share one global root signature, the others get one per layout
+	void TestLayoutSelection()
+	{
+		Cache cache;
+		MockFactory factory;
+
+		const Cache::Selection first = cache.GetRootSignature(factory, CreateLayout(1, 4, 0));
+		const Cache::Selection second = cache.GetRootSignature(factory, CreateLayout(8, 128, 8, 4));
+		CHECK(first.IsGlobal && second.IsGlobal);
+		CHECK(first.Signature == second.Signature);
+		CHECK(first.Hash == GlobalRootSignature::HASH && second.Hash == GlobalRootSignature::HASH);
+		CHECK(first.Parameters == GlobalRootSignature::GetParameters());
+		CHECK(first.Signature->Global);
+		CHECK(factory.NumRootSignatures == 1);
+
+		const BindingLayout largeLayout = CreateLayout(16, 4, 0);
+		const Cache::Selection fallback = cache.GetRootSignature(factory, largeLayout);
+		CHECK(!fallback.IsGlobal);
+		CHECK(!fallback.Signature->Global);
+		CHECK(fallback.Signature != first.Signature);
+		CHECK(fallback.Hash == largeLayout.GetHash());
+		CHECK(fallback.Parameters == GetRootParameters(largeLayout));
+		CHECK(factory.NumRootSignatures == 2);
+
+		// Same layout made again is the cached signature
+		const Cache::Selection sameFallback = cache.GetRootSignature(factory, CreateLayout(16, 4, 0));
+		CHECK(sameFallback.Signature == fallback.Signature);
+		CHECK(factory.NumRootSignatures == 2);
+
+		// Any difference of the layout is a different signature
+		BindingLayout otherRegister = largeLayout;
+		otherRegister.SRVs.reset(0);
+		otherRegister.SRVs.set(5);
+		BindingLayout otherBindless = largeLayout;
+		otherBindless.BindlessTables.push_back({ 1, 0 });
+		for (const BindingLayout& layout : { otherRegister, otherBindless })
+		{
+			const Cache::Selection selection = cache.GetRootSignature(factory, layout);
+			CHECK(selection.Signature != fallback.Signature);
+			CHECK(selection.Hash != fallback.Hash);
+		}
+		CHECK(factory.NumRootSignatures == 4);
+
+		const Cache::Statistics statistics = cache.GetStatistics();
+		CHECK(statistics.NumGlobal == 2);
+		CHECK(statistics.NumFallback == 4);
+		CHECK(statistics.NumRootSignatures == 4);
+
+		cache.Clear();
+		CHECK(cache.GetStatistics().NumRootSignatures == 0);
+		cache.GetRootSignature(factory, CreateLayout(1, 4, 0));
+		CHECK(factory.NumRootSignatures == 5);
+	}
+
+	// Command signature without the root arguments is shared, the one that sets them is made per root signature
+	void TestCommandSignatureKeying()
+	{
+		using ArgumentType = IndirectLayout::ArgumentType;
+
+		Cache cache;
+		MockFactory factory;
+
+		const Cache::Selection global = cache.GetRootSignature(factory, CreateLayout(1, 1, 1));
+		const Cache::Selection fallback = cache.GetRootSignature(factory, CreateLayout(16, 1, 1));
+
+		const IndirectLayout drawIndexed = CreateIndirectLayout({ ArgumentType::DrawIndexed }, 20);
+		CHECK(!drawIndexed.ChangesRootArguments());
+		const MockCommandSignature& sharedGlobal = cache.GetCommandSignature(factory, drawIndexed, global);
+		const MockCommandSignature& sharedFallback = cache.GetCommandSignature(factory, drawIndexed, fallback);
+		CHECK(&sharedGlobal == &sharedFallback);
+		CHECK(sharedGlobal.RootSignature == nullptr);
+		CHECK(factory.NumCommandSignatures == 1);
+
+		// Layout that differs only in the stride is a different signature
+		const MockCommandSignature& otherStride = cache.GetCommandSignature(factory, CreateIndirectLayout({ ArgumentType::DrawIndexed }, 32), global);
+		CHECK(&otherStride != &sharedGlobal);
+		CHECK(factory.NumCommandSignatures == 2);
+
+		// Every argument type from Constant on sets the root arguments
+		for (ArgumentType type : { ArgumentType::Constant, ArgumentType::ConstantBufferView, ArgumentType::ShaderResourceView, ArgumentType::UnorderedAccessView })
+		{
+			CHECK(CreateIndirectLayout({ type, ArgumentType::Dispatch }, 32).ChangesRootArguments());
+		}
+		CHECK(!CreateIndirectLayout({ ArgumentType::VertexBufferView, ArgumentType::IndexBufferView, ArgumentType::DrawIndexed }, 64).ChangesRootArguments());
+
+		IndirectLayout constantDraw = CreateIndirectLayout({ ArgumentType::Constant, ArgumentType::Draw }, 20);
+		constantDraw.Arguments[0].Data[0] = global.Parameters.PushConstants;
+		constantDraw.Arguments[0].Data[2] = 1;
+
+		const MockCommandSignature& forGlobal = cache.GetCommandSignature(factory, constantDraw, global);
+		const MockCommandSignature& forFallback = cache.GetCommandSignature(factory, constantDraw, fallback);
+		CHECK(&forGlobal != &forFallback);
+		CHECK(forGlobal.RootSignature == global.Signature);
+		CHECK(forFallback.RootSignature == fallback.Signature);
+		CHECK(factory.NumCommandSignatures == 4);
+
+		// Root signatures selected again find the same command signatures
+		CHECK(&cache.GetCommandSignature(factory, constantDraw, cache.GetRootSignature(factory, CreateLayout(1, 1, 1))) == &forGlobal);
+		CHECK(&cache.GetCommandSignature(factory, drawIndexed, cache.GetRootSignature(factory, CreateLayout(16, 1, 1))) == &sharedGlobal);
+		CHECK(factory.NumCommandSignatures == 4);
+
+		// Root parameter the constant is written to is part of the key
+		IndirectLayout otherParameter = constantDraw;
+		otherParameter.Arguments[0].Data[0]++;
+		CHECK(&cache.GetCommandSignature(factory, otherParameter, global) != &forGlobal);
+		CHECK(factory.NumCommandSignatures == 5);
+
+		const Cache::Statistics statistics = cache.GetStatistics();
+		CHECK(statistics.NumCommandSignatures == 5);
+		CHECK(statistics.NumCommandSignatureHits == 3);
+	}
+}
+
+int main()
+{
+	Test::Run("Global fits", TestGlobalFits);
+	Test::Run("Root parameters", TestRootParameters);
+	Test::Run("Layout selection", TestLayoutSelection);
+	Test::Run("Command signature keying", TestCommandSignatureKeying);
+	return Test::Finish();
+}
@@ -0,0 +1,152 @@
+#include <vector>
+#include <functional>
+
+#include "Test.h"
+
+#include "Renderers/Util/SphericalHarmonics.h"
+
+namespace
+{
+	constexpr uint32_t PANORAMA_WIDTH = 256;
+	constexpr uint32_t PANORAMA_HEIGHT = 128;
+	constexpr float PI = 3.14159265f;
+
+	using RadianceFunc = std::function<Float3(const Float3& direction)>;
+
+	std::vector<float> CreatePanorama(const RadianceFunc& radiance)
+	{
+		std::vector<float> pixels(4 * PANORAMA_WIDTH * PANORAMA_HEIGHT);
+		for (uint32_t y = 0; y < PANORAMA_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < PANORAMA_WIDTH; x++)
+			{
+				const Float3 value = radiance(SphericalHarmonics::PanoramaTexelToDirection(x, y, PANORAMA_WIDTH, PANORAMA_HEIGHT));
+				float* pixel = &pixels[4 * (y * PANORAMA_WIDTH + x)];
+				pixel[0] = value.x;
+				pixel[1] = value.y;
+				pixel[2] = value.z;
+				pixel[3] = 1.0f;
+			}
+		}
+		return pixels;
+	}
+
+	const Float3 TEST_NORMALS[] =
+	{
+		Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f),
+		Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f),
+		Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f),
+		Float3(0.6f, 0.0f, 0.8f), Float3(0.0f, -0.8f, 0.6f),
+	};
+
+	// Directions of the panorama cover the sphere once, the solid angle of every texel adds up to 4 PI
+	void TestPanoramaDirections()
+	{
+		float maxLengthError = 0.0f;
+		Float3 sum{ 0.0f, 0.0f, 0.0f };
+		for (uint32_t y = 0; y < PANORAMA_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < PANORAMA_WIDTH; x++)
+			{
+				const Float3 direction = SphericalHarmonics::PanoramaTexelToDirection(x, y, PANORAMA_WIDTH, PANORAMA_HEIGHT);
+				maxLengthError = MAX(maxLengthError, std::abs(direction.Length() - 1.0f));
+				sum += direction;
+			}
+		}
+		CHECK(maxLengthError < 1e-5f);
+		CHECK(sum.Length() < 1e-2f);
+
+		// First row is the -Y pole, center of the panorama looks along +X
+		CHECK(SphericalHarmonics::PanoramaTexelToDirection(0, 0, PANORAMA_WIDTH, PANORAMA_HEIGHT).y < -0.99f);
+		CHECK(SphericalHarmonics::PanoramaTexelToDirection(PANORAMA_WIDTH / 2, PANORAMA_HEIGHT / 2, PANORAMA_WIDTH, PANORAMA_HEIGHT).x > 0.99f);
+	}
+
+	// L(w) = c projects only to the first coefficient, c * Y00 * 4 PI, and the irradiance divided by PI is c everywhere
+	void TestConstantEnvironment()
+	{
+		const Float3 color{ 1.5f, 0.25f, 4.0f };
+		const std::vector<float> panorama = CreatePanorama([&](const Float3&) { return color; });
+
+		const SphericalHarmonics::SH9Color radiance = SphericalHarmonics::ProjectPanorama(panorama.data(), PANORAMA_WIDTH, PANORAMA_HEIGHT);
+
+		const float y00Integral = 0.282095f * 4.0f * PI;
+		CHECK_NEAR(radiance.Coefficients[0].x, color.x * y00Integral, 2e-3f * color.x * y00Integral);
+		CHECK_NEAR(radiance.Coefficients[0].y, color.y * y00Integral, 2e-3f * color.y * y00Integral);
+		CHECK_NEAR(radiance.Coefficients[0].z, color.z * y00Integral, 2e-3f * color.z * y00Integral);
+		for (uint32_t i = 1; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			CHECK(radiance.Coefficients[i].Length() < 1e-2f);
+		}
+
+		const SphericalHarmonics::SH9Color irradiance = SphericalHarmonics::ConvolveIrradiance(radiance);
+		for (const Float3& normal : TEST_NORMALS)
+		{
+			const Float3 value = SphericalHarmonics::Evaluate(irradiance, normal.Normalize());
+			CHECK((value - color).Length() < 1e-2f);
+
+			const Float3 reference = SphericalHarmonics::IntegrateIrradiance(panorama.data(), PANORAMA_WIDTH, PANORAMA_HEIGHT, normal.Normalize());
+			CHECK((reference - color).Length() < 1e-2f);
+		}
+		CHECK(SphericalHarmonics::ValidateIrradiance(irradiance, panorama.data(), PANORAMA_WIDTH, PANORAMA_HEIGHT) < 1e-2f);
+	}
+
+	// L(w) = max(dot(w, z), 0), the clamped cosine lobe has only the zonal coefficients
+	// Y00: sqrt(PI) / 2, Y10: sqrt(PI / 3), Y20: sqrt(5 PI) / 8
+	// Irradiance divided by PI is 2/3 facing the lobe and 0 facing away, 9 coefficients get within 0.01 of it
+	void TestCosineLobe()
+	{
+		const std::vector<float> panorama = CreatePanorama([](const Float3& direction)
+		{
+			const float value = MAX(direction.z, 0.0f);
+			return Float3{ value, 2.0f * value, 0.0f };
+		});
+
+		const SphericalHarmonics::SH9Color radiance = SphericalHarmonics::ProjectPanorama(panorama.data(), PANORAMA_WIDTH, PANORAMA_HEIGHT);
+
+		const float expected[SphericalHarmonics::NUM_COEFFICIENTS] = { sqrtf(PI) / 2.0f, 0.0f, sqrtf(PI / 3.0f), 0.0f, 0.0f, 0.0f, sqrtf(5.0f * PI) / 8.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			CHECK_NEAR(radiance.Coefficients[i].x, expected[i], 1e-3f);
+			CHECK_NEAR(radiance.Coefficients[i].y, 2.0f * expected[i], 2e-3f);
+			CHECK_NEAR(radiance.Coefficients[i].z, 0.0f, 1e-6f);
+		}
+
+		const SphericalHarmonics::SH9Color irradiance = SphericalHarmonics::ConvolveIrradiance(radiance);
+		CHECK_NEAR(SphericalHarmonics::Evaluate(irradiance, Float3(0.0f, 0.0f, 1.0f)).x, 2.0f / 3.0f, 1e-2f);
+		CHECK_NEAR(SphericalHarmonics::Evaluate(irradiance, Float3(0.0f, 0.0f, -1.0f)).x, 0.0f, 1e-2f);
+
+		// Every other normal matches the brute force integration over the panorama
+		for (const Float3& normal : TEST_NORMALS)
+		{
+			const Float3 value = SphericalHarmonics::Evaluate(irradiance, normal.Normalize());
+			const Float3 reference = SphericalHarmonics::IntegrateIrradiance(panorama.data(), PANORAMA_WIDTH, PANORAMA_HEIGHT, normal.Normalize());
+			CHECK_NEAR(value.x, reference.x, 1e-2f);
+			CHECK_NEAR(value.y, reference.y, 2e-2f);
+		}
+	}
+
+	// Irradiance of the render data layout matches Evaluate, the shader reads the same coefficients
+	void TestRenderData()
+	{
+		SphericalHarmonics::SH9Color sh{};
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++) sh.Coefficients[i] = Float3((float) i, 2.0f * i, -1.0f * i);
+
+		const SphericalHarmonics::SH9ColorRenderData renderData = SphericalHarmonics::ToRenderData(sh);
+		for (uint32_t i = 0; i < SphericalHarmonics::NUM_COEFFICIENTS; i++)
+		{
+			CHECK(renderData.Coefficients[i].x == sh.Coefficients[i].x);
+			CHECK(renderData.Coefficients[i].y == sh.Coefficients[i].y);
+			CHECK(renderData.Coefficients[i].z == sh.Coefficients[i].z);
+			CHECK(renderData.Coefficients[i].w == 0.0f);
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("Panorama directions", TestPanoramaDirections);
+	Test::Run("Constant environment", TestConstantEnvironment);
+	Test::Run("Cosine lobe", TestCosineLobe);
+	Test::Run("Render data", TestRenderData);
+	return Test::Finish();
+}
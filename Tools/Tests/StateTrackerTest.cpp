@@ -0,0 +1,239 @@
+#include <vector>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Engine/Render/StateTracker.h>
+
+namespace
+{
+	// Sink that counts the emitted commands
+	class MockSink : public StateTracker::CommandSink
+	{
+	public:
+		void SetDescriptorHeaps() override { NumDescriptorHeaps++; }
+		void SetRootSignature() override { NumRootSignatures++; }
+		void SetPipelineState() override { NumPipelineStates++; }
+		void SetDescriptorTable(uint32_t table) override { Tables.push_back(table); }
+		void SetRenderTargets() override { NumRenderTargets++; }
+		void SetViewport() override { NumViewports++; }
+		void SetStencilRef() override { NumStencilRefs++; }
+		void SetPrimitiveTopology() override { NumPrimitiveTopologies++; }
+		void SetVertexBuffers() override { NumVertexBuffers++; }
+		void SetIndexBuffer() override { NumIndexBuffers++; }
+
+		uint32_t GetNumGraphicsCommands() const { return NumRenderTargets + NumViewports + NumStencilRefs + NumPrimitiveTopologies + NumVertexBuffers + NumIndexBuffers; }
+		uint32_t GetNumCommands() const { return NumDescriptorHeaps + NumRootSignatures + NumPipelineStates + (uint32_t) Tables.size() + GetNumGraphicsCommands(); }
+
+		uint32_t NumDescriptorHeaps = 0;
+		uint32_t NumRootSignatures = 0;
+		uint32_t NumPipelineStates = 0;
+		std::vector<uint32_t> Tables;
+		uint32_t NumRenderTargets = 0;
+		uint32_t NumViewports = 0;
+		uint32_t NumStencilRefs = 0;
+		uint32_t NumPrimitiveTopologies = 0;
+		uint32_t NumVertexBuffers = 0;
+		uint32_t NumIndexBuffers = 0;
+	};
+
+	// Commands emitted by one Apply
+	MockSink Apply(StateTracker& tracker, const StateTracker::State& state)
+	{
+		MockSink sink;
+		tracker.Apply(state, sink);
+		return sink;
+	}
+
+	StateTracker::State CreateGraphicsState()
+	{
+		StateTracker::State state;
+		state.RootSignature = 0x100;
+		state.PipelineState = 0x200;
+		state.DescriptorTables[0] = 0x300;
+		state.DescriptorTables[1] = 0x301;
+		state.DescriptorTables[StateTracker::FIRST_BINDLESS_TABLE] = 0x302;
+		state.RenderTargets = 0x400;
+		state.Viewport = 0x500;
+		state.StencilRef = 0x600;
+		state.PrimitiveTopology = 0x700;
+		state.VertexBuffers = 0x800;
+		state.IndexBuffer = 0x900;
+		return state;
+	}
+
+	StateTracker::State CreateComputeState()
+	{
+		StateTracker::State state;
+		state.Compute = true;
+		state.RootSignature = 0x100;
+		state.PipelineState = 0x210;
+		state.DescriptorTables[1] = 0x301;
+		state.DescriptorTables[2] = 0x310;
+		return state;
+	}
+
+	// First state sets everything, the same state again sets nothing
+	void TestRedundantState()
+	{
+		StateTracker tracker;
+		const StateTracker::State state = CreateGraphicsState();
+
+		const MockSink first = Apply(tracker, state);
+		CHECK(first.NumDescriptorHeaps == 1);
+		CHECK(first.NumRootSignatures == 1);
+		CHECK(first.NumPipelineStates == 1);
+		CHECK(first.Tables == (std::vector<uint32_t>{ 0, 1, StateTracker::FIRST_BINDLESS_TABLE }));
+		CHECK(first.GetNumGraphicsCommands() == 6);
+		CHECK(tracker.IsPipelineStateBound(state.PipelineState));
+
+		const MockSink second = Apply(tracker, state);
+		CHECK(second.GetNumCommands() == 0);
+
+		// Root signature, pipeline state, 6 graphics components and 3 tables are skipped
+		const StateTracker::Statistics& statistics = tracker.GetStatistics();
+		CHECK(statistics.NumApplied == 2);
+		CHECK(statistics.NumEmitted == first.GetNumCommands());
+		CHECK(statistics.NumSkipped == 11);
+
+		// Only the changed component is set
+		StateTracker::State otherViewport = state;
+		otherViewport.Viewport++;
+		const MockSink third = Apply(tracker, otherViewport);
+		CHECK(third.NumViewports == 1);
+		CHECK(third.GetNumCommands() == 1);
+	}
+
+	// Root signature switch unbinds the tables, they are set again even if their keys didn't change
+	void TestRootSignatureSwitch()
+	{
+		StateTracker tracker;
+		const StateTracker::State state = CreateGraphicsState();
+		Apply(tracker, state);
+
+		StateTracker::State otherRootSignature = state;
+		otherRootSignature.RootSignature++;
+		const MockSink switched = Apply(tracker, otherRootSignature);
+		CHECK(switched.NumRootSignatures == 1);
+		CHECK(switched.Tables == (std::vector<uint32_t>{ 0, 1, StateTracker::FIRST_BINDLESS_TABLE }));
+		CHECK(switched.NumDescriptorHeaps == 0);
+		CHECK(switched.NumPipelineStates == 0);
+		CHECK(switched.GetNumGraphicsCommands() == 0);
+
+		// Table that the new state doesn't set isn't tracked as bound, the next state with it sets it
+		StateTracker::State withoutTable = state;
+		withoutTable.DescriptorTables[1] = 0;
+		const MockSink back = Apply(tracker, withoutTable);
+		CHECK(back.NumRootSignatures == 1);
+		CHECK(back.Tables == (std::vector<uint32_t>{ 0, StateTracker::FIRST_BINDLESS_TABLE }));
+
+		const MockSink withTable = Apply(tracker, state);
+		CHECK(withTable.NumRootSignatures == 0);
+		CHECK(withTable.Tables == std::vector<uint32_t>{ 1 });
+	}
+
+	// Graphics and compute have separate root signatures, the switch sets it even with the same key
+	// Compute doesn't touch the graphics components, they stay bound for the next draw
+	void TestComputeGraphicsAlternation()
+	{
+		StateTracker tracker;
+		const StateTracker::State graphics = CreateGraphicsState();
+		const StateTracker::State compute = CreateComputeState();
+		Apply(tracker, graphics);
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const MockSink dispatch = Apply(tracker, compute);
+			CHECK(dispatch.NumRootSignatures == 1);
+			CHECK(dispatch.NumPipelineStates == 1);
+			CHECK(dispatch.Tables == (std::vector<uint32_t>{ 1, 2 }));
+			CHECK(dispatch.GetNumGraphicsCommands() == 0);
+			CHECK(dispatch.NumDescriptorHeaps == 0);
+
+			const MockSink draw = Apply(tracker, graphics);
+			CHECK(draw.NumRootSignatures == 1);
+			CHECK(draw.NumPipelineStates == 1);
+			CHECK(draw.Tables == (std::vector<uint32_t>{ 0, 1, StateTracker::FIRST_BINDLESS_TABLE }));
+			CHECK(draw.GetNumGraphicsCommands() == 0);
+		}
+
+		// Back to back dispatches don't set anything
+		Apply(tracker, compute);
+		CHECK(Apply(tracker, compute).GetNumCommands() == 0);
+	}
+
+	// Invalidated tracker sets everything again, the descriptor heaps included
+	void TestInvalidate()
+	{
+		StateTracker tracker;
+		const StateTracker::State state = CreateGraphicsState();
+		const MockSink first = Apply(tracker, state);
+
+		tracker.Invalidate();
+		CHECK(!tracker.IsPipelineStateBound(state.PipelineState));
+
+		const MockSink afterInvalidate = Apply(tracker, state);
+		CHECK(afterInvalidate.NumDescriptorHeaps == 1);
+		CHECK(afterInvalidate.GetNumCommands() == first.GetNumCommands());
+		CHECK(tracker.IsPipelineStateBound(state.PipelineState));
+
+		// Invalidate before the first Apply and twice in a row is the same as once
+		StateTracker fresh;
+		fresh.Invalidate();
+		fresh.Invalidate();
+		CHECK(Apply(fresh, CreateComputeState()).NumDescriptorHeaps == 1);
+		CHECK(Apply(fresh, CreateComputeState()).GetNumCommands() == 0);
+	}
+
+	// State without the vertex buffers, index buffer or a table leaves the previous ones bound
+	void TestEmptyKeys()
+	{
+		StateTracker tracker;
+		const StateTracker::State state = CreateGraphicsState();
+		Apply(tracker, state);
+
+		StateTracker::State empty = state;
+		empty.VertexBuffers = 0;
+		empty.IndexBuffer = 0;
+		empty.DescriptorTables[0] = 0;
+		const MockSink withoutBuffers = Apply(tracker, empty);
+		CHECK(withoutBuffers.GetNumCommands() == 0);
+
+		// Previous buffers and table are still bound
+		CHECK(Apply(tracker, state).GetNumCommands() == 0);
+
+		// Other buffers are set, the empty state after them doesn't go back to the first ones
+		StateTracker::State otherBuffers = state;
+		otherBuffers.VertexBuffers++;
+		otherBuffers.IndexBuffer++;
+		const MockSink changed = Apply(tracker, otherBuffers);
+		CHECK(changed.NumVertexBuffers == 1 && changed.NumIndexBuffers == 1);
+		CHECK(changed.GetNumCommands() == 2);
+		CHECK(Apply(tracker, empty).GetNumCommands() == 0);
+		CHECK(Apply(tracker, otherBuffers).GetNumCommands() == 0);
+
+		// First state without the buffers doesn't set them at all
+		StateTracker fresh;
+		const MockSink first = Apply(fresh, empty);
+		CHECK(first.NumVertexBuffers == 0 && first.NumIndexBuffers == 0);
+		CHECK(first.Tables == (std::vector<uint32_t>{ 1, StateTracker::FIRST_BINDLESS_TABLE }));
+
+		// Every bindless table is tracked on its own
+		StateTracker::State bindless = state;
+		for (uint32_t i = StateTracker::FIRST_BINDLESS_TABLE; i < StateTracker::MAX_DESCRIPTOR_TABLES; i++) bindless.DescriptorTables[i] = 0x1000 + i;
+		const MockSink allTables = Apply(fresh, bindless);
+		CHECK(std::count_if(allTables.Tables.begin(), allTables.Tables.end(), [](uint32_t table) { return table >= StateTracker::FIRST_BINDLESS_TABLE; }) == StateTracker::MAX_DESCRIPTOR_TABLES - StateTracker::FIRST_BINDLESS_TABLE);
+		bindless.DescriptorTables[StateTracker::MAX_DESCRIPTOR_TABLES - 1]++;
+		CHECK(Apply(fresh, bindless).Tables == std::vector<uint32_t>{ StateTracker::MAX_DESCRIPTOR_TABLES - 1 });
+	}
+}
+
+int main()
+{
+	Test::Run("Redundant state", TestRedundantState);
+	Test::Run("Root signature switch", TestRootSignatureSwitch);
+	Test::Run("Compute and graphics alternation", TestComputeGraphicsAlternation);
+	Test::Run("Invalidate", TestInvalidate);
+	Test::Run("Empty keys", TestEmptyKeys);
+	return Test::Finish();
+}
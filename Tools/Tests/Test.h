@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <filesystem>
+
+// Checks of the CPU tests, a failed check prints where it failed and the test keeps going
+// main returns Test::Finish() so ctest sees the failures
+namespace Test
+{
+	inline uint32_t& GetNumFailures()
+	{
+		static uint32_t numFailures = 0;
+		return numFailures;
+	}
+
+	inline bool Check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			std::cout << file << "(" << line << "): Check failed: " << expression << std::endl;
+			GetNumFailures()++;
+		}
+		return condition;
+	}
+
+	template<typename TestFunc>
+	void Run(const char* name, TestFunc test)
+	{
+		const uint32_t numFailures = GetNumFailures();
+		test();
+		std::cout << (GetNumFailures() == numFailures ? "Passed: " : "Failed: ") << name << std::endl;
+	}
+
+	// Empty directory for the files of the test, removed and created again on every run
+	inline std::string CreateTempDirectory(const std::string& name)
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "EngineTests" / name;
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		return directory.generic_string();
+	}
+
+	inline int Finish()
+	{
+		if (GetNumFailures() > 0) std::cout << GetNumFailures() << " checks failed" << std::endl;
+		return GetNumFailures() > 0 ? 1 : 0;
+	}
+}
+
+#define CHECK(X) Test::Check(static_cast<bool>(X), #X, __FILE__, __LINE__)
+#define CHECK_NEAR(A, B, TOLERANCE) Test::Check(std::abs((double) (A) - (double) (B)) <= (double) (TOLERANCE), #A " == " #B " +- " #TOLERANCE, __FILE__, __LINE__)
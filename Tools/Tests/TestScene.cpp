@@ -0,0 +1,166 @@
+#include "TestScene.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+namespace TestScene
+{
+	namespace
+	{
+		// Views and accessors of the one buffer
+		struct BufferWriter
+		{
+			template<typename T>
+			uint32_t AddAccessor(const std::vector<T>& values, uint32_t componentType, const char* type, size_t count)
+			{
+				const size_t offset = Bytes.size();
+				Bytes.resize(offset + values.size() * sizeof(T));
+				memcpy(Bytes.data() + offset, values.data(), values.size() * sizeof(T));
+				Bytes.resize((Bytes.size() + 3) & ~(size_t) 3);
+
+				const uint32_t index = NumAccessors++;
+				Views << (index ? ",\n" : "") << "  { \"buffer\": 0, \"byteOffset\": " << offset << ", \"byteLength\": " << values.size() * sizeof(T) << " }";
+				Accessors << (index ? ",\n" : "") << "  { \"bufferView\": " << index << ", \"componentType\": " << componentType << ", \"type\": \"" << type << "\", \"count\": " << count;
+				if (strcmp(type, "VEC3") == 0 && componentType == 5126)
+				{
+					// Positions need the bounds
+					float min[3] = { 1e30f, 1e30f, 1e30f };
+					float max[3] = { -1e30f, -1e30f, -1e30f };
+					const float* floats = reinterpret_cast<const float*>(values.data());
+					for (size_t i = 0; i < count * 3; i++)
+					{
+						min[i % 3] = std::min(min[i % 3], floats[i]);
+						max[i % 3] = std::max(max[i % 3], floats[i]);
+					}
+					Accessors << ", \"min\": [" << min[0] << ", " << min[1] << ", " << min[2] << "], \"max\": [" << max[0] << ", " << max[1] << ", " << max[2] << "]";
+				}
+				Accessors << " }";
+				return index;
+			}
+
+			std::vector<uint8_t> Bytes;
+			std::ostringstream Views;
+			std::ostringstream Accessors;
+			uint32_t NumAccessors = 0;
+		};
+
+		// Noise with some structure so the block compression and the mips have something to do
+		bool WriteImage(const std::string& path, uint32_t size, std::mt19937& random, uint32_t channelMask)
+		{
+			std::vector<uint8_t> pixels(size * size * 4);
+			const float frequency = 0.05f + (random() % 100) * 0.003f;
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					uint8_t* pixel = pixels.data() + (y * size + x) * 4;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						const float wave = 0.5f + 0.5f * std::sin(x * frequency * (c + 1) + y * frequency * (3 - c));
+						pixel[c] = channelMask & (1 << c) ? (uint8_t) std::min(255.0f, wave * 224.0f + random() % 32) : 255;
+					}
+				}
+			}
+			return stbi_write_png(path.c_str(), (int) size, (int) size, 4, pixels.data(), (int) size * 4) != 0;
+		}
+	}
+
+	std::string Write(const std::string& directory, const Settings& settings)
+	{
+		std::mt19937 random{ settings.Seed };
+		BufferWriter buffer;
+		std::ostringstream meshes;
+		std::ostringstream materials;
+		std::ostringstream nodes;
+		std::ostringstream images;
+		std::ostringstream textures;
+
+		const uint32_t gridSize = std::max(settings.GridSize, 2u);
+		const uint32_t numVertices = gridSize * gridSize;
+		for (uint32_t m = 0; m < settings.NumMeshes; m++)
+		{
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<float> texcoords;
+			const float height = (random() % 100) * 0.01f;
+			for (uint32_t y = 0; y < gridSize; y++)
+			{
+				for (uint32_t x = 0; x < gridSize; x++)
+				{
+					const float u = (float) x / (gridSize - 1);
+					const float v = (float) y / (gridSize - 1);
+					positions.insert(positions.end(), { u * 10.0f, height * std::sin(u * 6.0f) * std::cos(v * 6.0f), v * 10.0f });
+					normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+					texcoords.insert(texcoords.end(), { u * 2.0f, v * 2.0f });
+				}
+			}
+
+			std::vector<uint32_t> indices;
+			for (uint32_t y = 0; y + 1 < gridSize; y++)
+			{
+				for (uint32_t x = 0; x + 1 < gridSize; x++)
+				{
+					const uint32_t i = y * gridSize + x;
+					indices.insert(indices.end(), { i, i + gridSize, i + 1, i + 1, i + gridSize, i + gridSize + 1 });
+				}
+			}
+
+			const uint32_t position = buffer.AddAccessor(positions, 5126, "VEC3", numVertices);
+			const uint32_t normal = buffer.AddAccessor(normals, 5126, "VEC3", numVertices);
+			const uint32_t texcoord = buffer.AddAccessor(texcoords, 5126, "VEC2", numVertices);
+			uint32_t index;
+			if (numVertices <= 65536) index = buffer.AddAccessor(std::vector<uint16_t>(indices.begin(), indices.end()), 5123, "SCALAR", indices.size());
+			else index = buffer.AddAccessor(indices, 5125, "SCALAR", indices.size());
+
+			meshes << (m ? ",\n" : "") << "  { \"primitives\": [ { \"attributes\": { \"POSITION\": " << position << ", \"NORMAL\": " << normal << ", \"TEXCOORD_0\": " << texcoord << " }, \"indices\": " << index << ", \"material\": " << m << " } ] }";
+			nodes << (m ? ",\n" : "") << "  { \"mesh\": " << m << ", \"translation\": [" << (m % 8) * 12.0f << ", 0, " << (m / 8) * 12.0f << "] }";
+
+			// Every render group is used
+			const char* alphaMode = m % 5 == 3 ? "MASK" : m % 7 == 6 ? "BLEND" : "OPAQUE";
+			const uint32_t firstTexture = m * 3;
+			materials << (m ? ",\n" : "") << "  { \"alphaMode\": \"" << alphaMode << "\", \"pbrMetallicRoughness\": { \"baseColorTexture\": { \"index\": " << firstTexture << " }, \"metallicRoughnessTexture\": { \"index\": " << firstTexture + 2 << " } }, \"normalTexture\": { \"index\": " << firstTexture + 1 << " } }";
+
+			const char* names[] = { "albedo", "normal", "metallic_roughness" };
+			const uint32_t channelMasks[] = { 0xF, 0x3, 0x6 };
+			for (uint32_t t = 0; t < 3; t++)
+			{
+				const std::string name = std::string(names[t]) + "_" + std::to_string(m) + ".png";
+				if (!WriteImage(directory + "/" + name, settings.TextureSize, random, channelMasks[t])) return "";
+
+				images << (firstTexture + t ? ",\n" : "") << "  { \"uri\": \"" << name << "\" }";
+				textures << (firstTexture + t ? ",\n" : "") << "  { \"source\": " << firstTexture + t << " }";
+			}
+		}
+
+		std::ofstream bin(directory + "/scene.bin", std::ios::binary);
+		bin.write(reinterpret_cast<const char*>(buffer.Bytes.data()), buffer.Bytes.size());
+		if (!bin) return "";
+
+		std::ostringstream sceneNodes;
+		for (uint32_t m = 0; m < settings.NumMeshes; m++) sceneNodes << (m ? ", " : "") << m;
+
+		const std::string path = directory + "/scene.gltf";
+		std::ofstream gltf(path);
+		gltf << "{\n\"asset\": { \"version\": \"2.0\" },\n";
+		gltf << "\"buffers\": [ { \"uri\": \"scene.bin\", \"byteLength\": " << buffer.Bytes.size() << " } ],\n";
+		gltf << "\"bufferViews\": [\n" << buffer.Views.str() << "\n],\n";
+		gltf << "\"accessors\": [\n" << buffer.Accessors.str() << "\n],\n";
+		gltf << "\"images\": [\n" << images.str() << "\n],\n";
+		gltf << "\"textures\": [\n" << textures.str() << "\n],\n";
+		gltf << "\"materials\": [\n" << materials.str() << "\n],\n";
+		gltf << "\"meshes\": [\n" << meshes.str() << "\n],\n";
+		gltf << "\"nodes\": [\n" << nodes.str() << "\n],\n";
+		gltf << "\"scenes\": [ { \"nodes\": [" << sceneNodes.str() << "] } ],\n";
+		gltf << "\"scene\": 0\n}\n";
+		gltf.close();
+		return gltf ? path : "";
+	}
+}
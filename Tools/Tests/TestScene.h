@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Generated glTF scene for the tests and benchmarks of the scene conversion
+// Every mesh is a displaced grid with its own material, every material has its own albedo, normal and metallic roughness PNG
+namespace TestScene
+{
+	struct Settings
+	{
+		uint32_t NumMeshes = 16;
+
+		// Grid of GridSize x GridSize vertices, more than 256 uses 32 bit indices
+		uint32_t GridSize = 32;
+
+		// Multiple of 4 so the textures are block compressed
+		uint32_t TextureSize = 64;
+
+		uint32_t Seed = 1;
+	};
+
+	// Writes scene.gltf, scene.bin and the images into the directory and returns the path of the glTF, empty on failure
+	std::string Write(const std::string& directory, const Settings& settings);
+}
@@ -0,0 +1,164 @@
+#include <vector>
+#include <algorithm>
+
+#include "Test.h"
+
+#include <Scene/TextureRegistry.h>
+
+namespace
+{
+	using Result = TextureRegistry::Result;
+	using Acquisition = TextureRegistry::Acquisition;
+
+	// Hashes stand in for the normalized paths and the pixels, nothing is loaded
+	constexpr uint64_t PATH_A = 0xA1;
+	constexpr uint64_t PATH_B = 0xB1;
+	constexpr uint64_t PATH_C = 0xC1;
+	constexpr uint64_t PIXELS_1 = 0x1001;
+	constexpr uint64_t PIXELS_2 = 0x2002;
+	constexpr uint64_t PIXELS_3 = 0x3003;
+
+	bool Is(const Acquisition& acquisition, Result status, uint32_t slot)
+	{
+		return acquisition.Status == status && acquisition.Slot == slot;
+	}
+
+	// Same path is found by the path, a copy of the image under another name by its pixels
+	void TestPathAndContentHits()
+	{
+		TextureRegistry registry{ 8 };
+		const Acquisition first = registry.Acquire(PATH_A, PIXELS_1);
+		CHECK(first.Status == Result::Miss && first.Slot != TextureRegistry::INVALID_SLOT);
+
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::PathHit, first.Slot));
+		CHECK(Is(registry.Acquire(PATH_B, PIXELS_1), Result::ContentHit, first.Slot));
+
+		// Copy is known by its own path from now on
+		CHECK(Is(registry.Acquire(PATH_B, PIXELS_1), Result::PathHit, first.Slot));
+
+		const Acquisition other = registry.Acquire(PATH_C, PIXELS_2);
+		CHECK(other.Status == Result::Miss && other.Slot != first.Slot);
+		CHECK(registry.GetNumTextures() == 2);
+		CHECK(registry.GetNumReferences(first.Slot) == 4);
+		CHECK(registry.GetNumReferences(other.Slot) == 1);
+	}
+
+	// File that changed since it was loaded gets a new texture, the old one stays for the scenes that still use it
+	void TestStalePath()
+	{
+		TextureRegistry registry{ 8 };
+		const Acquisition before = registry.Acquire(PATH_A, PIXELS_1);
+		const Acquisition after = registry.Acquire(PATH_A, PIXELS_2);
+		CHECK(after.Status == Result::Miss && after.Slot != before.Slot);
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_2), Result::PathHit, after.Slot));
+
+		// Old pixels are only found by their content now
+		CHECK(Is(registry.Acquire(PATH_B, PIXELS_1), Result::ContentHit, before.Slot));
+
+		// Moving back to pixels that are still loaded reuses their texture
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::ContentHit, before.Slot));
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::PathHit, before.Slot));
+		CHECK(registry.GetNumTextures() == 2);
+
+		// Last release of the old texture doesn't drop the path that moved away from it
+		CHECK(!registry.Release(after.Slot));
+		CHECK(registry.Release(after.Slot));
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::PathHit, before.Slot));
+	}
+
+	// Texture is deleted with its last reference, its path and pixels are forgotten and the slot is handed out again
+	void TestReleaseAndReuse()
+	{
+		TextureRegistry registry{ 8 };
+		const Acquisition first = registry.Acquire(PATH_A, PIXELS_1);
+		registry.Acquire(PATH_B, PIXELS_1);
+		const Acquisition other = registry.Acquire(PATH_C, PIXELS_2);
+
+		CHECK(!registry.Release(first.Slot));
+		CHECK(registry.GetNumReferences(first.Slot) == 1);
+		CHECK(registry.Release(first.Slot));
+		CHECK(registry.GetNumReferences(first.Slot) == 0);
+		CHECK(registry.GetNumTextures() == 1);
+
+		const Acquisition reloaded = registry.Acquire(PATH_A, PIXELS_1);
+		CHECK(Is(reloaded, Result::Miss, first.Slot));
+		const Acquisition changed = registry.Acquire(PATH_B, PIXELS_3);
+		CHECK(changed.Status == Result::Miss && changed.Slot != first.Slot && changed.Slot != other.Slot);
+		CHECK(registry.GetNumReferences(other.Slot) == 1);
+		CHECK(registry.GetNumTextures() == 3);
+	}
+
+	// Registry without a free slot still finds the loaded textures, a release makes room again
+	void TestFull()
+	{
+		TextureRegistry registry{ 2 };
+		const Acquisition first = registry.Acquire(PATH_A, PIXELS_1);
+		const Acquisition second = registry.Acquire(PATH_B, PIXELS_2);
+		CHECK(first.Status == Result::Miss && second.Status == Result::Miss);
+
+		const Acquisition full = registry.Acquire(PATH_C, PIXELS_3);
+		CHECK(Is(full, Result::Full, TextureRegistry::INVALID_SLOT));
+		CHECK(registry.GetNumTextures() == 2);
+		CHECK(Is(registry.Acquire(PATH_C, PIXELS_1), Result::ContentHit, first.Slot));
+
+		// Path of the failed acquisition wasn't taken
+		CHECK(Is(registry.Acquire(PATH_B, PIXELS_2), Result::PathHit, second.Slot));
+
+		CHECK(!registry.Release(second.Slot));
+		CHECK(registry.Release(second.Slot));
+		CHECK(Is(registry.Acquire(PATH_C, PIXELS_3), Result::Miss, second.Slot));
+		CHECK(registry.Acquire(0, 0x4004).Status == Result::Full);
+	}
+
+	// Default textures made from a color have no path, every material with the same color shares one
+	void TestSharedDefaults()
+	{
+		TextureRegistry registry{ 8 };
+		const Acquisition white = registry.Acquire(0, PIXELS_1);
+		CHECK(white.Status == Result::Miss);
+		CHECK(Is(registry.Acquire(0, PIXELS_1), Result::ContentHit, white.Slot));
+
+		const Acquisition black = registry.Acquire(0, PIXELS_2);
+		CHECK(black.Status == Result::Miss && black.Slot != white.Slot);
+
+		// File with the same pixels shares the default, the path 0 never points anywhere
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::ContentHit, white.Slot));
+		CHECK(Is(registry.Acquire(PATH_A, PIXELS_1), Result::PathHit, white.Slot));
+		CHECK(registry.GetNumReferences(white.Slot) == 4);
+
+		CHECK(!registry.Release(white.Slot));
+		CHECK(!registry.Release(white.Slot));
+		CHECK(!registry.Release(white.Slot));
+		CHECK(registry.Release(white.Slot));
+		CHECK(registry.Acquire(0, PIXELS_1).Status == Result::Miss);
+	}
+
+	// Every acquisition that got a slot is counted once, the full ones aren't counted
+	void TestStatistics()
+	{
+		TextureRegistry registry{ 2 };
+		registry.Acquire(PATH_A, PIXELS_1);
+		registry.Acquire(PATH_A, PIXELS_1);
+		registry.Acquire(PATH_A, PIXELS_1);
+		registry.Acquire(PATH_B, PIXELS_1);
+		registry.Acquire(0, PIXELS_1);
+		registry.Acquire(PATH_C, PIXELS_2);
+		registry.Acquire(PATH_C, PIXELS_3);
+
+		const TextureRegistry::Statistics& statistics = registry.GetStatistics();
+		CHECK(statistics.NumPathHits == 2);
+		CHECK(statistics.NumContentHits == 2);
+		CHECK(statistics.NumMisses == 2);
+	}
+}
+
+int main()
+{
+	Test::Run("Path and content hits", TestPathAndContentHits);
+	Test::Run("Stale path", TestStalePath);
+	Test::Run("Release and reuse", TestReleaseAndReuse);
+	Test::Run("Full", TestFull);
+	Test::Run("Shared defaults", TestSharedDefaults);
+	Test::Run("Statistics", TestStatistics);
+	return Test::Finish();
+}